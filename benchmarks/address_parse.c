@@ -0,0 +1,62 @@
+/*
+ * Copyright 2026 Markus Lindelöw
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files(the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+// tcs_address_parse() with its fast path against the generic parser it falls back to, per address form.
+
+#define TINYCSOCKET_IMPLEMENTATION
+#include <tinycsocket.h>
+
+#include "bench.h"
+
+#define BENCH_ITERATIONS 2000000
+
+static volatile uint32_t sink;
+
+static void bench_parse(const char* name, const char* str, TcsResult (*parse)(const char*, struct TcsAddress*))
+{
+    struct TcsAddress address = TCS_ADDRESS_NONE;
+    int64_t start = bench_now_ns();
+    for (int i = 0; i < BENCH_ITERATIONS; ++i)
+    {
+        parse(str, &address);
+        sink += address.data.ipv6.address.bytes[15];
+    }
+    bench_report(name, bench_now_ns() - start, BENCH_ITERATIONS);
+}
+
+int main(void)
+{
+    const char* forms[][2] = {{"ipv4", "192.168.100.200"},
+                              {"ipv4:port", "10.0.0.1:8080"},
+                              {"ipv6", "2001:db8:85a3::8a2e:370:7334"},
+                              {"[ipv6%scope]:port", "[fe80::1%2]:443"},
+                              {"mac", "00:1a:2b:3c:4d:5e"}};
+    for (size_t i = 0; i < sizeof(forms) / sizeof(forms[0]); ++i)
+    {
+        char name[64];
+        snprintf(name, sizeof(name), "parse %s", forms[i][0]);
+        bench_parse(name, forms[i][1], tcs_address_parse);
+        snprintf(name, sizeof(name), "parse %s, generic", forms[i][0]);
+        bench_parse(name, forms[i][1], address_parse_generic);
+    }
+    return 0;
+}
@@ -0,0 +1,115 @@
+/*
+ * Copyright 2026 Markus Lindelöw
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files(the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+// tcs_address_to_str() per address form and tcs_address_to_str_many() for a batch, against snprintf() formatting.
+
+#define TINYCSOCKET_IMPLEMENTATION
+#include <tinycsocket.h>
+
+#include "bench.h"
+
+#include <string.h>
+
+#define BENCH_ITERATIONS 2000000
+#define BENCH_BATCH 64
+
+static volatile char sink;
+
+// The same output built with snprintf(), what tcs_address_to_str() used before
+static void format_snprintf(const struct TcsAddress* address, char* str, size_t length)
+{
+    if (address->family.native == TCS_FAMILY_IPV4.native)
+    {
+        uint32_t d = address->data.ipv4.address;
+        snprintf(str,
+                 length,
+                 "%u.%u.%u.%u:%u",
+                 d >> 24,
+                 d >> 16 & 0xFF,
+                 d >> 8 & 0xFF,
+                 d & 0xFF,
+                 (unsigned int)address->data.ipv4.port);
+    }
+    else if (address->family.native == TCS_FAMILY_IPV6.native)
+    {
+        const uint8_t* b = address->data.ipv6.address.bytes;
+        snprintf(str,
+                 length,
+                 "[%x:%x::%x:%x%%%u]:%u",
+                 (unsigned int)(b[0] << 8 | b[1]),
+                 (unsigned int)(b[2] << 8 | b[3]),
+                 (unsigned int)(b[12] << 8 | b[13]),
+                 (unsigned int)(b[14] << 8 | b[15]),
+                 (unsigned int)address->data.ipv6.scope_id,
+                 (unsigned int)address->data.ipv6.port);
+    }
+    else
+    {
+        const uint8_t* m = address->data.packet.mac;
+        snprintf(str, length, "%02X:%02X:%02X:%02X:%02X:%02X", m[0], m[1], m[2], m[3], m[4], m[5]);
+    }
+}
+
+int main(void)
+{
+    const char* forms[][2] = {{"ipv4:port", "192.168.100.200:8080"},
+                              {"[ipv6%scope]:port", "[fe80:1::a:b%2]:443"},
+                              {"mac", "00:1A:2B:3C:4D:5E"}};
+    static struct TcsAddress batch[BENCH_BATCH];
+    for (size_t i = 0; i < sizeof(forms) / sizeof(forms[0]); ++i)
+    {
+        struct TcsAddress address = TCS_ADDRESS_NONE;
+        tcs_address_parse(forms[i][1], &address);
+        for (size_t j = i; j < BENCH_BATCH; j += 3)
+            batch[j] = address;
+
+        static char str[70];
+        char name[64];
+        int64_t start = bench_now_ns();
+        for (int n = 0; n < BENCH_ITERATIONS; ++n)
+        {
+            tcs_address_to_str(&address, str, sizeof str, NULL);
+            sink = str[n & 7];
+        }
+        snprintf(name, sizeof(name), "to_str %s", forms[i][0]);
+        bench_report(name, bench_now_ns() - start, BENCH_ITERATIONS);
+
+        start = bench_now_ns();
+        for (int n = 0; n < BENCH_ITERATIONS; ++n)
+        {
+            format_snprintf(&address, str, sizeof str);
+            sink = str[n & 7];
+        }
+        snprintf(name, sizeof(name), "snprintf %s", forms[i][0]);
+        bench_report(name, bench_now_ns() - start, BENCH_ITERATIONS);
+    }
+
+    static char batch_str[BENCH_BATCH * 72];
+    int64_t start = bench_now_ns();
+    for (int n = 0; n < BENCH_ITERATIONS / BENCH_BATCH; ++n)
+    {
+        tcs_address_to_str_many(batch, BENCH_BATCH, ", ", batch_str, sizeof batch_str, NULL);
+        sink = batch_str[n & 7];
+    }
+    bench_report("to_str_many, per address", bench_now_ns() - start, BENCH_ITERATIONS / BENCH_BATCH * BENCH_BATCH);
+    return 0;
+}
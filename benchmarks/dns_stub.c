@@ -0,0 +1,136 @@
+/*
+ * Copyright 2026 Markus Lindelöw
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files(the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+// Lookup rate of the DNS stub resolver against a minimal UDP server on loopback, answered from the same
+// poll loop. One lookup in flight at a time is compared with keeping a window of lookups in flight.
+
+#define TINYCSOCKET_IMPLEMENTATION
+#include <tinycsocket.h>
+
+#include "bench.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#define BENCH_LOOKUPS 20000
+#define BENCH_SERVER_PORT "1502"
+
+static TcsSocket server = TCS_SOCKET_INVALID;
+
+// Answers every query with 10.0.0.1
+static void serve(void)
+{
+    static uint8_t message[512];
+    size_t received = 0;
+    struct TcsAddress client = TCS_ADDRESS_NONE;
+    while (tcs_receive_from(server, message, sizeof(message) - 16, TCS_MSG_DONTWAIT, &client, &received) ==
+           TCS_SUCCESS)
+    {
+        static const uint8_t answer[] = {0xC0, 0x0C, 0, 1, 0, 1, 0, 0, 0, 60, 0, 4, 10, 0, 0, 1};
+        message[2] = 0x81;
+        message[3] = 0x80;
+        message[7] = 1;
+        memcpy(message + received, answer, sizeof(answer));
+        tcs_send_to(server, message, received + sizeof(answer), TCS_FLAG_NONE, &client, NULL);
+    }
+}
+
+static int bench_lookups(const char* name, size_t window)
+{
+    struct TcsPoll* poll = NULL;
+    struct TcsDns* dns = NULL;
+    struct TcsAddress nameserver = TCS_ADDRESS_NONE;
+    tcs_address_parse("127.0.0.1:" BENCH_SERVER_PORT, &nameserver);
+    if (tcs_poll_create(&poll) != TCS_SUCCESS || tcs_poll_add(poll, server, NULL, TCS_POLL_READ) != TCS_SUCCESS ||
+        tcs_dns_create(&dns, poll, &nameserver, 1, 1000, 3) != TCS_SUCCESS)
+        return -1;
+
+    size_t submitted = 0;
+    size_t taken = 0;
+    size_t failed = 0;
+    int timeout_ms = 0;
+    int64_t start = bench_now_ns();
+    while (taken < BENCH_LOOKUPS)
+    {
+        while (submitted < BENCH_LOOKUPS && submitted - taken < window)
+        {
+            char hostname[32];
+            size_t handle = 0;
+            snprintf(hostname, sizeof(hostname), "host%zu.bench", submitted);
+            if (tcs_dns_submit(dns, hostname, TCS_FAMILY_IPV4, &handle) != TCS_SUCCESS)
+                break;
+            submitted++;
+        }
+        tcs_dns_process(dns, NULL, &timeout_ms);
+
+        static struct TcsPollEvent events[64];
+        size_t count = 0;
+        tcs_poll_wait(poll, events, 64, &count, timeout_ms);
+        for (size_t i = 0; i < count; ++i)
+        {
+            if (events[i].user_data == dns)
+                tcs_dns_process(dns, &events[i], &timeout_ms);
+            else
+                serve();
+        }
+
+        size_t handle = 0;
+        TcsResult result = TCS_SUCCESS;
+        struct TcsAddress address = TCS_ADDRESS_NONE;
+        size_t address_count = 0;
+        while (tcs_dns_take(dns, &handle, &result, &address, 1, &address_count) == TCS_SUCCESS)
+        {
+            taken++;
+            failed += result == TCS_SUCCESS ? 0 : 1;
+        }
+    }
+    bench_report(name, bench_now_ns() - start, BENCH_LOOKUPS);
+    if (failed > 0)
+        fprintf(stderr, "%zu lookups failed\n", failed);
+
+    tcs_dns_destroy(&dns);
+    tcs_poll_destroy(&poll);
+    return 0;
+}
+
+int main(void)
+{
+    if (tcs_lib_init() != TCS_SUCCESS)
+        return 1;
+
+    if (tcs_socket_udp_str(&server, "127.0.0.1:" BENCH_SERVER_PORT, NULL) != TCS_SUCCESS)
+    {
+        fprintf(stderr, "Could not create UDP server socket\n");
+        return 1;
+    }
+    tcs_opt_receive_buffer_size_set(server, 1 << 20);
+
+    if (bench_lookups("dns lookup, 1 in flight", 1) != 0 || bench_lookups("dns lookup, 256 in flight", 256) != 0)
+    {
+        fprintf(stderr, "Could not create DNS stub resolver\n");
+        return 1;
+    }
+
+    tcs_close(&server);
+    tcs_lib_cleanup();
+    return 0;
+}
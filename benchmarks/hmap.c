@@ -0,0 +1,123 @@
+/*
+ * Copyright 2026 Markus Lindelöw
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files(the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+// TDS_HMAP_IMPL lookups, misses and set/remove churn against a linear scan of a TdsMap, per map size.
+
+#define TINYCSOCKET_IMPLEMENTATION
+#include <tinycsocket.h>
+
+#include "bench.h"
+
+#define BENCH_OPERATIONS 4000000
+
+static volatile uint64_t sink;
+
+static uint64_t bench_hash_u32(const uint32_t* key, uint64_t seed)
+{
+    uint64_t hash = (*key ^ seed) * 0x9E3779B97F4A7C15ULL;
+    return hash ^ (hash >> 32);
+}
+
+static bool bench_is_equal_u32(const uint32_t* l, const uint32_t* r)
+{
+    return *l == *r;
+}
+
+TDS_HMAP_IMPL(uint32_t, uint32_t, bench, bench_hash_u32, bench_is_equal_u32)
+TDS_MAP_IMPL(uint32_t, uint32_t, bench)
+
+static uint32_t bench_key(uint32_t i)
+{
+    return i * 2654435761u;
+}
+
+static void bench_size(uint32_t size)
+{
+    char name[64];
+    struct TdsHMap_bench hmap;
+    struct TdsMap_bench map;
+    tds_hmap_bench_create(&hmap, 1);
+    tds_map_bench_create(&map);
+    for (uint32_t i = 0; i < size; ++i)
+    {
+        uint32_t key = bench_key(i);
+        tds_hmap_bench_set(&hmap, &key, &i);
+        tds_map_bench_add(&map, key, i);
+    }
+
+    int64_t start = bench_now_ns();
+    for (uint32_t i = 0; i < BENCH_OPERATIONS; ++i)
+    {
+        uint32_t key = bench_key(i % size);
+        sink += *tds_hmap_bench_get(&hmap, &key);
+    }
+    snprintf(name, sizeof(name), "hmap get hit, %u", size);
+    bench_report(name, bench_now_ns() - start, BENCH_OPERATIONS);
+
+    start = bench_now_ns();
+    for (uint32_t i = 0; i < BENCH_OPERATIONS; ++i)
+    {
+        uint32_t key = bench_key(i % size + size);
+        sink += tds_hmap_bench_get(&hmap, &key) == NULL;
+    }
+    snprintf(name, sizeof(name), "hmap get miss, %u", size);
+    bench_report(name, bench_now_ns() - start, BENCH_OPERATIONS);
+
+    start = bench_now_ns();
+    for (uint32_t i = 0; i < BENCH_OPERATIONS / 2; ++i)
+    {
+        uint32_t key = bench_key(i % size);
+        tds_hmap_bench_remove(&hmap, &key);
+        tds_hmap_bench_set(&hmap, &key, &i);
+    }
+    snprintf(name, sizeof(name), "hmap remove + set, %u", size);
+    bench_report(name, bench_now_ns() - start, BENCH_OPERATIONS / 2);
+
+    // The linear scan gets quadratic quickly, keep its operation count per size roughly constant in time
+    uint32_t scan_operations = BENCH_OPERATIONS / (size / 8 + 1);
+    start = bench_now_ns();
+    for (uint32_t i = 0; i < scan_operations; ++i)
+    {
+        uint32_t key = bench_key((uint32_t)((uint64_t)i * 7919u % size));
+        for (size_t j = 0; j < map.count; ++j)
+        {
+            if (map.keys[j] == key)
+            {
+                sink += map.values[j];
+                break;
+            }
+        }
+    }
+    snprintf(name, sizeof(name), "linear map get hit, %u", size);
+    bench_report(name, bench_now_ns() - start, scan_operations);
+
+    tds_map_bench_destroy(&map);
+    tds_hmap_bench_destroy(&hmap);
+}
+
+int main(void)
+{
+    const uint32_t sizes[] = {8, 64, 1024, 65536};
+    for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); ++i)
+        bench_size(sizes[i]);
+    return 0;
+}
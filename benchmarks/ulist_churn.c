@@ -0,0 +1,107 @@
+/*
+ * Copyright 2026 Markus Lindelöw
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files(the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+// TdsUList add/remove churn, like a poll set with connections coming and going, per growth policy.
+
+#define TINYCSOCKET_IMPLEMENTATION
+#include <tinycsocket.h>
+
+#include "bench.h"
+
+#define BENCH_CYCLES 200000
+#define BENCH_LOW_COUNT 4
+#define BENCH_HIGH_COUNT 100
+#define BENCH_OPERATIONS ((uint64_t)BENCH_CYCLES * 2 * (BENCH_HIGH_COUNT - BENCH_LOW_COUNT))
+
+struct BenchEntry
+{
+    int fd;
+    short events;
+    short revents;
+};
+
+static const struct TdsGrowthPolicy BENCH_POLICY_NO_ZERO_FILL = {8, 200, 0, 2};
+static const struct TdsGrowthPolicy BENCH_POLICY_SLOW_GROWTH = {8, 150, 1, 2};
+
+TDS_ULIST_IMPL(struct BenchEntry, bench_default)
+TDS_ULIST_IMPL_WITH_POLICY(struct BenchEntry, bench_no_zero_fill, &BENCH_POLICY_NO_ZERO_FILL)
+TDS_ULIST_IMPL_WITH_POLICY(struct BenchEntry, bench_slow_growth, &BENCH_POLICY_SLOW_GROWTH)
+TDS_ULIST_IMPL_WITH_POLICY(struct BenchEntry, bench_never_shrink, &TDS_GROWTH_POLICY_NEVER_SHRINK)
+
+static uint64_t reallocs;
+
+static void* bench_alloc(size_t size, void* context)
+{
+    (void)context;
+    return malloc(size);
+}
+
+static void* bench_realloc(void* ptr, size_t size, void* context)
+{
+    (void)context;
+    reallocs++;
+    return realloc(ptr, size);
+}
+
+static void bench_free(void* ptr, void* context)
+{
+    (void)context;
+    free(ptr);
+}
+
+// Grows one entry at a time to BENCH_HIGH_COUNT and drops back to BENCH_LOW_COUNT one entry at a time, every cycle
+#define BENCH_CHURN(NAME)                                                                                              \
+    do                                                                                                                 \
+    {                                                                                                                  \
+        struct TdsUList_##NAME list;                                                                                   \
+        struct BenchEntry entry = {0, 1, 0};                                                                           \
+        tds_ulist_##NAME##_create(&list);                                                                              \
+        reallocs = 0;                                                                                                  \
+        int64_t start = bench_now_ns();                                                                                \
+        for (int cycle = 0; cycle < BENCH_CYCLES; ++cycle)                                                             \
+        {                                                                                                              \
+            while (list.count < BENCH_HIGH_COUNT)                                                                      \
+            {                                                                                                          \
+                entry.fd = (int)list.count;                                                                            \
+                tds_ulist_##NAME##_add(&list, &entry, 1);                                                              \
+            }                                                                                                          \
+            while (list.count > BENCH_LOW_COUNT)                                                                       \
+                tds_ulist_##NAME##_remove(&list, list.count / 2, 1);                                                   \
+        }                                                                                                              \
+        int64_t elapsed = bench_now_ns() - start;                                                                      \
+        bench_report("ulist churn, " #NAME, elapsed, BENCH_OPERATIONS);                                                \
+        printf("%-32s %12llu reallocs, capacity after %zu\n",                                                          \
+               "",                                                                                                     \
+               (unsigned long long)reallocs,                                                                           \
+               list.capacity);                                                                                         \
+        tds_ulist_##NAME##_destroy(&list);                                                                             \
+    } while (0)
+
+int main(void)
+{
+    tcs_lib_set_allocator(bench_alloc, bench_realloc, bench_free, NULL);
+    BENCH_CHURN(bench_default);
+    BENCH_CHURN(bench_no_zero_fill);
+    BENCH_CHURN(bench_slow_growth);
+    BENCH_CHURN(bench_never_shrink);
+    return 0;
+}
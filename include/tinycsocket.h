@@ -41,34 +41,47 @@ extern const char* const TCS_LICENSE_TXT;
 * Library Management:
 * - TcsResult tcs_lib_init(void);
 * - TcsResult tcs_lib_cleanup(void);
+* - int64_t tcs_time_monotonic_ms(void);
+* - TcsResult tcs_lib_set_allocator(TcsAllocFn alloc_fn, TcsReallocFn realloc_fn, TcsFreeFn free_fn, void* context);
+* - void* tcs_lib_malloc(size_t size);
+* - void* tcs_lib_realloc(void* ptr, size_t size);
+* - void tcs_lib_free(void* ptr);
 *
 * Socket Creation:
 * - TcsResult tcs_socket(TcsSocket* out_socket, TcsFamily family, TcsSocketType type, TcsProtocol protocol);
+* - TcsResult tcs_socket_with_flags(TcsSocket* out_socket, TcsFamily family, TcsSocketType type, TcsProtocol protocol, uint32_t flags);
 * - TcsResult tcs_socket_tcp(TcsSocket* out_socket, const struct TcsAddress* local_address, const struct TcsAddress* remote_address, int timeout_ms);
 * - TcsResult tcs_socket_tcp_str(TcsSocket* out_socket, const char* local_address, const char* remote_address, int timeout_ms);
+* - TcsResult tcs_socket_tcp_any(TcsSocket* out_socket, const struct TcsAddress* local_address, const struct TcsAddress remote_addresses[], size_t remote_addresses_length, int timeout_ms);
 * - TcsResult tcs_socket_udp(TcsSocket* out_socket, const struct TcsAddress* local_address, const struct TcsAddress* remote_address);
 * - TcsResult tcs_socket_udp_str(TcsSocket* out_socket, const char* local_address, const char* remote_address);
 * - TcsResult tcs_socket_packet(TcsSocket* out_socket, const struct TcsAddress* bind_address, TcsSocketType type);
 * - TcsResult tcs_socket_packet_str(TcsSocket* out_socket, const char* interface_name, uint16_t protocol, TcsSocketType type);
+* - TcsResult tcs_socket_per_cpu(TcsSocket out_sockets[], size_t sockets_length, TcsSocketType type, const struct TcsAddress* local_address, size_t* out_sockets_count);
 * - TcsResult tcs_close(TcsSocket* socket);
 *
 * Socket Operations:
 * - TcsResult tcs_bind(TcsSocket socket, const struct TcsAddress* local_address);
 * - TcsResult tcs_connect(TcsSocket socket, const struct TcsAddress* address);
 * - TcsResult tcs_connect_str(TcsSocket socket, const char* remote_address, uint16_t port);
+* - TcsResult tcs_connect_timeout(TcsSocket socket, const struct TcsAddress* address, int timeout_ms);
 * - TcsResult tcs_listen(TcsSocket socket, int backlog);
 * - TcsResult tcs_accept(TcsSocket listener, TcsSocket* out_socket, struct TcsAddress* out_address);
+* - TcsResult tcs_accept_many(TcsSocket listener, TcsSocket out_sockets[], struct TcsAddress out_addresses[], size_t sockets_length, size_t* out_accepted_count);
 * - TcsResult tcs_shutdown(TcsSocket socket, TcsShutdownDirection direction);
 *
 * Data Transfer:
 * - TcsResult tcs_send(TcsSocket socket, const uint8_t* buffer, size_t buffer_size, uint32_t flags, size_t* out_sent_size);
 * - TcsResult tcs_send_to(TcsSocket socket, const uint8_t* buffer, size_t buffer_size, uint32_t flags, const struct TcsAddress* destination_address, size_t* out_sent_size);
+* - TcsResult tcs_send_to_from(TcsSocket socket, const uint8_t* buffer, size_t buffer_size, uint32_t flags, const struct TcsAddress* destination_address, const struct TcsAddress* source_address, TcsInterfaceId interface_id, size_t* out_sent_size);
 * - TcsResult tcs_sendv(TcsSocket socket, const struct TcsIoVec* iov, size_t iov_length, uint32_t flags, size_t* out_sent_size);
 * - TcsResult tcs_send_netstring(TcsSocket socket, const uint8_t* buffer, size_t buffer_size);
 * - TcsResult tcs_receive(TcsSocket socket, uint8_t* buffer, size_t buffer_size, uint32_t flags, size_t* out_received_size);
 * - TcsResult tcs_receive_from(TcsSocket socket, uint8_t* buffer, size_t buffer_size, uint32_t flags, struct TcsAddress* out_source_address, size_t* out_received_size);
+* - TcsResult tcs_receive_from_to(TcsSocket socket, uint8_t* buffer, size_t buffer_size, uint32_t flags, struct TcsAddress* out_source_address, struct TcsAddress* out_destination_address, TcsInterfaceId* out_interface_id, size_t* out_received_size);
 * - TcsResult tcs_receive_line(TcsSocket socket, uint8_t* buffer, size_t buffer_size, uint8_t delimiter, size_t* out_received_size);
 * - TcsResult tcs_receive_netstring(TcsSocket socket, uint8_t* buffer, size_t buffer_size, size_t* out_received_size);
+* - TcsResult tcs_receive_tx_timestamps(TcsSocket socket, struct TcsTxTimestamp out_timestamps[], size_t timestamps_length, size_t* out_length);
 *
 * Socket Polling:
 * - TcsResult tcs_poll_create(struct TcsPoll** out_poll);
@@ -78,6 +91,51 @@ extern const char* const TCS_LICENSE_TXT;
 * - TcsResult tcs_poll_remove(struct TcsPoll* poll, TcsSocket socket);
 * - TcsResult tcs_poll_wait(struct TcsPoll* poll, struct TcsPollEvent* out_events, size_t events_length, size_t* out_events_length, int timeout_ms);
 *
+* Bulk Connect:
+* - TcsResult tcs_connector_create(struct TcsConnector** out_connector, const struct TcsAddress remote_addresses[], size_t remote_addresses_length);
+* - TcsResult tcs_connector_destroy(struct TcsConnector** connector);
+* - TcsResult tcs_connector_run(struct TcsConnector* connector, size_t max_in_flight, int connect_timeout_ms, int total_timeout_ms);
+* - TcsResult tcs_connector_take(struct TcsConnector* connector, size_t index, TcsSocket* out_socket);
+*
+* Connection Pool:
+* - TcsResult tcs_pool_create(struct TcsPool** out_pool, size_t max_idle_per_key, size_t max_total_per_key, int idle_timeout_ms, int connect_timeout_ms);
+* - TcsResult tcs_pool_destroy(struct TcsPool** pool);
+* - TcsResult tcs_pool_acquire(struct TcsPool* pool, const struct TcsAddress* remote_address, TcsSocket* out_socket);
+* - TcsResult tcs_pool_release(struct TcsPool* pool, const struct TcsAddress* remote_address, TcsSocket* socket, bool is_reusable);
+*
+* Asynchronous Resolve:
+* - TcsResult tcs_resolver_create(struct TcsResolver** out_resolver, size_t thread_count);
+* - TcsResult tcs_resolver_destroy(struct TcsResolver** resolver);
+* - TcsResult tcs_resolver_socket(struct TcsResolver* resolver, TcsSocket* out_socket);
+* - TcsResult tcs_resolver_submit(struct TcsResolver* resolver, const char* hostname, TcsFamily address_family, size_t* out_handle);
+* - TcsResult tcs_resolver_take(struct TcsResolver* resolver, size_t* out_handle, TcsResult* out_result, struct TcsAddress out_addresses[], size_t addresses_length, size_t* out_length);
+* - TcsResult tcs_resolver_cancel(struct TcsResolver* resolver, size_t handle);
+*
+* DNS Stub Resolver:
+* - TcsResult tcs_dns_create(struct TcsDns** out_dns, struct TcsPoll* poll, const struct TcsAddress nameservers[], size_t nameservers_length, int attempt_timeout_ms, int attempts);
+* - TcsResult tcs_dns_destroy(struct TcsDns** dns);
+* - TcsResult tcs_dns_submit(struct TcsDns* dns, const char* hostname, TcsFamily address_family, size_t* out_handle);
+* - TcsResult tcs_dns_process(struct TcsDns* dns, const struct TcsPollEvent* event, int* out_timeout_ms);
+* - TcsResult tcs_dns_take(struct TcsDns* dns, size_t* out_handle, TcsResult* out_result, struct TcsAddress out_addresses[], size_t addresses_length, size_t* out_length);
+* - TcsResult tcs_dns_cancel(struct TcsDns* dns, size_t handle);
+*
+* Packet Rings (Linux only):
+* - TcsResult tcs_packet_ring_rx_create(struct TcsPacketRing** out_ring, TcsSocket socket, size_t block_size, size_t block_count, size_t frame_size, int block_timeout_ms);
+* - TcsResult tcs_packet_ring_destroy(struct TcsPacketRing** ring);
+* - TcsResult tcs_packet_ring_rx_next(struct TcsPacketRing* ring, struct TcsPacketFrame* out_frame);
+* - TcsResult tcs_packet_ring_rx_release(struct TcsPacketRing* ring);
+* - TcsResult tcs_packet_ring_tx_create(struct TcsPacketRing** out_ring, TcsSocket socket, size_t block_size, size_t block_count, size_t frame_size);
+* - TcsResult tcs_packet_ring_tx_acquire(struct TcsPacketRing* ring, uint8_t** out_data, size_t* out_capacity);
+* - TcsResult tcs_packet_ring_tx_commit(struct TcsPacketRing* ring, size_t frame_size);
+* - TcsResult tcs_packet_ring_tx_flush(struct TcsPacketRing* ring, const struct TcsAddress* destination_address);
+*
+* Socket Filters:
+* - TcsResult tcs_filter_init(struct TcsFilter* filter);
+* - TcsResult tcs_filter_ether_type(struct TcsFilter* filter, uint16_t ether_type);
+* - TcsResult tcs_filter_vlan_id(struct TcsFilter* filter, uint16_t vlan_id);
+* - TcsResult tcs_filter_udp_destination_port(struct TcsFilter* filter, uint16_t port);
+* - TcsResult tcs_filter_multicast_group(struct TcsFilter* filter, const struct TcsAddress* multicast_address);
+*
 * Socket Options:
 * - TcsResult tcs_opt_set(TcsSocket socket, int32_t level, int32_t option_name, const void* option_value, size_t option_size);
 * - TcsResult tcs_opt_get(TcsSocket socket, int32_t level, int32_t option_name, void* out_option_value, size_t* option_size);
@@ -90,6 +148,7 @@ extern const char* const TCS_LICENSE_TXT;
 * - TcsResult tcs_opt_reuse_address_get(TcsSocket socket, bool* out_is_reuse_address_allowed);
 * - TcsResult tcs_opt_reuse_port_set(TcsSocket socket, bool do_allow_reuse_port);
 * - TcsResult tcs_opt_reuse_port_get(TcsSocket socket, bool* out_is_reuse_port_allowed);
+* - TcsResult tcs_opt_reuse_port_steer_by_cpu(TcsSocket socket, size_t group_size);
 * - TcsResult tcs_opt_send_buffer_size_set(TcsSocket socket, size_t send_buffer_size);
 * - TcsResult tcs_opt_send_buffer_size_get(TcsSocket socket, size_t* out_send_buffer_size);
 * - TcsResult tcs_opt_receive_buffer_size_set(TcsSocket socket, size_t receive_buffer_size);
@@ -100,12 +159,25 @@ extern const char* const TCS_LICENSE_TXT;
 * - TcsResult tcs_opt_linger_get(TcsSocket socket, bool* out_do_linger, int* out_timeout_seconds);
 * - TcsResult tcs_opt_ip_no_delay_set(TcsSocket socket, bool use_no_delay);
 * - TcsResult tcs_opt_ip_no_delay_get(TcsSocket socket, bool* out_is_no_delay_used);
+* - TcsResult tcs_opt_tcp_fast_open_set(TcsSocket socket, int queue_length);
+* - TcsResult tcs_opt_tcp_fast_open_get(TcsSocket socket, int* out_queue_length);
+* - TcsResult tcs_opt_tcp_fast_open_connect_set(TcsSocket socket, bool do_fast_open);
+* - TcsResult tcs_opt_tcp_fast_open_connect_get(TcsSocket socket, bool* out_is_fast_open);
 * - TcsResult tcs_opt_out_of_band_inline_set(TcsSocket socket, bool enable_oob);
 * - TcsResult tcs_opt_out_of_band_inline_get(TcsSocket socket, bool* out_is_oob_enabled);
 * - TcsResult tcs_opt_priority_set(TcsSocket socket, int priority);
 * - TcsResult tcs_opt_priority_get(TcsSocket socket, int* out_priority);
 * - TcsResult tcs_opt_nonblocking_set(TcsSocket socket, bool do_nonblocking);
 * - TcsResult tcs_opt_nonblocking_get(TcsSocket socket, bool* out_is_nonblocking);
+* - TcsResult tcs_opt_tx_timestamping_set(TcsSocket socket, bool do_timestamp);
+* - TcsResult tcs_opt_tx_timestamping_get(TcsSocket socket, bool* out_is_timestamping);
+* - TcsResult tcs_opt_packet_info_set(TcsSocket socket, bool do_receive_packet_info);
+* - TcsResult tcs_opt_packet_info_get(TcsSocket socket, bool* out_is_packet_info_received);
+* - TcsResult tcs_opt_packet_qdisc_bypass_set(TcsSocket socket, bool do_bypass);
+* - TcsResult tcs_opt_packet_qdisc_bypass_get(TcsSocket socket, bool* out_is_bypassed);
+* - TcsResult tcs_opt_packet_fanout_join(TcsSocket socket, uint16_t group_id, TcsPacketFanoutMode mode);
+* - TcsResult tcs_opt_filter_attach(TcsSocket socket, const struct TcsFilter* filter);
+* - TcsResult tcs_opt_filter_detach(TcsSocket socket);
 * - TcsResult tcs_opt_membership_add(TcsSocket socket, const struct TcsAddress* multicast_address);
 * - TcsResult tcs_opt_membership_add_str(TcsSocket socket, const char* multicast_address);
 * - TcsResult tcs_opt_membership_add_to(TcsSocket socket, const struct TcsAddress* local_address, const struct TcsAddress* multicast_address);
@@ -119,19 +191,31 @@ extern const char* const TCS_LICENSE_TXT;
 * Address and Interface Utilities:
 * - TcsResult tcs_interface_list(struct TcsInterface out_interfaces[], size_t interfaces_length, size_t* out_length);
 * - TcsResult tcs_address_resolve(const char* hostname, TcsFamily address_family, struct TcsAddress out_addresses[], size_t addresses_length, size_t* out_length);
+* - TcsResult tcs_address_cache_enable(size_t max_entries, int positive_ttl_ms, int negative_ttl_ms);
+* - TcsResult tcs_address_cache_disable(void);
+* - TcsResult tcs_address_cache_prefill(const char* hostname, TcsFamily address_family, const struct TcsAddress addresses[], size_t addresses_length, int ttl_ms);
+* - TcsResult tcs_address_cache_flush(const char* hostname);
 * - TcsResult tcs_address_list(TcsInterfaceId interface_id_filter, TcsFamily address_family_filter, struct TcsInterfaceAddress out_interface_addresses[], size_t interface_addresses_length, size_t* out_length);
 * - TcsResult tcs_address_socket_local(TcsSocket socket, struct TcsAddress* out_local_address);
 * - TcsResult tcs_address_socket_remote(TcsSocket socket, struct TcsAddress* out_remote_address);
 * - TcsResult tcs_address_socket_family(TcsSocket socket, TcsFamily* out_family);
 * - TcsResult tcs_address_parse(const char str[], struct TcsAddress* out_address);
 * - TcsResult tcs_address_to_str(const struct TcsAddress* address, char out_str[], size_t str_length, size_t* out_length);
+* - TcsResult tcs_address_to_str_many(const struct TcsAddress addresses[], size_t addresses_length, const char* separator, char out_str[], size_t str_length, size_t* out_length);
 * - bool tcs_address_is_equal(const struct TcsAddress* l, const struct TcsAddress* r);
+* - uint64_t tcs_address_hash(const struct TcsAddress* address, uint64_t seed);
 * - bool tcs_address_is_any(const struct TcsAddress* addr);
 * - bool tcs_address_is_link_local(const struct TcsAddress* addr);
 * - bool tcs_address_is_loopback(const struct TcsAddress* addr);
 * - bool tcs_address_is_multicast(const struct TcsAddress* addr);
 * - bool tcs_address_is_broadcast(const struct TcsAddress* addr);
 * - bool tcs_address_is_supported(const struct TcsAddress* addr);
+* - TcsResult tcs_address_map_create(struct TcsAddressMap** out_map, size_t capacity_hint);
+* - TcsResult tcs_address_map_destroy(struct TcsAddressMap** map);
+* - TcsResult tcs_address_map_set(struct TcsAddressMap* map, const struct TcsAddress* address, void* value);
+* - void* tcs_address_map_get(const struct TcsAddressMap* map, const struct TcsAddress* address);
+* - TcsResult tcs_address_map_remove(struct TcsAddressMap* map, const struct TcsAddress* address);
+* - size_t tcs_address_map_count(const struct TcsAddressMap* map);
 */
 
 // Recognize which system we are compiling against
@@ -195,6 +279,54 @@ typedef unsigned int TcsInterfaceId;
 #define TCS_CFG_INTERFACE_NAME_SIZE 64
 #endif
 
+#ifndef TCS_CFG_FILTER_MAX_INSTRUCTIONS
+#define TCS_CFG_FILTER_MAX_INSTRUCTIONS 64
+#endif
+
+#ifndef TCS_CFG_CONNECT_CANDIDATES_MAX
+#define TCS_CFG_CONNECT_CANDIDATES_MAX 8
+#endif
+
+#ifndef TCS_CFG_POOL_SHARDS
+#define TCS_CFG_POOL_SHARDS 16 // Number of independently locked parts of a TcsPool
+#endif
+
+#ifndef TCS_CFG_ADDRESS_CACHE_HOSTNAME_SIZE
+#define TCS_CFG_ADDRESS_CACHE_HOSTNAME_SIZE 256 // Longer hostnames are resolved but never cached
+#endif
+
+#ifndef TCS_CFG_ADDRESS_CACHE_ADDRESSES_MAX
+#define TCS_CFG_ADDRESS_CACHE_ADDRESSES_MAX 8 // Addresses kept per cached hostname
+#endif
+
+#ifndef TCS_CFG_RESOLVER_ADDRESSES_MAX
+#define TCS_CFG_RESOLVER_ADDRESSES_MAX 8 // Addresses kept per asynchronous lookup
+#endif
+
+#ifndef TCS_CFG_DNS_NAMESERVERS_MAX
+#define TCS_CFG_DNS_NAMESERVERS_MAX 3 // Same limit as resolv.conf
+#endif
+
+#ifndef TCS_CFG_DNS_ADDRESSES_MAX
+#define TCS_CFG_DNS_ADDRESSES_MAX 8 // Addresses kept per family of a DNS lookup
+#endif
+
+#ifndef TCS_CFG_DNS_RESOLV_CONF_PATH
+#define TCS_CFG_DNS_RESOLV_CONF_PATH "/etc/resolv.conf"
+#endif
+
+#ifndef TCS_CFG_DNS_HOSTS_PATH
+#define TCS_CFG_DNS_HOSTS_PATH "/etc/hosts"
+#endif
+
+#ifndef TCS_CFG_THREADS
+#define TCS_CFG_THREADS 0 // Set to 1 for tcs_resolver_create() on POSIX, then link with -pthread
+#endif
+
+#ifndef TCS_CFG_CONNECT_ATTEMPT_DELAY_MS
+#define TCS_CFG_CONNECT_ATTEMPT_DELAY_MS 250 // RFC 8305 recommended Connection Attempt Delay
+#endif
+
 // Declarations
 
 /** @internal */
@@ -244,6 +376,19 @@ typedef enum
     TCS_SHUTDOWN_BOTH,    /**< To shutdown both incoming and outgoing packets for socket */
 } TcsShutdownDirection;
 
+/**
+ * @brief How frames are distributed between the members of a packet fanout group.
+ *
+ * @see tcs_opt_packet_fanout_join()
+ */
+typedef enum
+{
+    TCS_PACKET_FANOUT_HASH,     /**< By flow hash, all frames of a flow go to the same member */
+    TCS_PACKET_FANOUT_LB,       /**< Round robin between the members */
+    TCS_PACKET_FANOUT_CPU,      /**< By the CPU that received the frame */
+    TCS_PACKET_FANOUT_ROLLOVER, /**< Fill one member, move to the next when its receive buffer is full */
+} TcsPacketFanoutMode;
+
 // Return codes
 typedef enum
 {
@@ -364,7 +509,62 @@ struct TcsIoVec
     size_t buffer_size;
 };
 
+/**
+ * @brief Transmit timestamp read from the socket error queue.
+ *
+ * @see tcs_receive_tx_timestamps()
+ */
+struct TcsTxTimestamp
+{
+    uint32_t id;          /**< Datagram counter for datagram sockets, byte counter for stream sockets. Starts at 0. */
+    int64_t timestamp_ns; /**< CLOCK_REALTIME when the packet left the network stack, in nanoseconds */
+};
+
+/**
+ * @brief A frame inside a memory mapped packet ring.
+ *
+ * @see tcs_packet_ring_rx_next()
+ */
+struct TcsPacketFrame
+{
+    uint8_t* data;        /**< Points into the ring. Valid until the block is released. */
+    size_t size;          /**< Number of bytes available at data */
+    size_t original_size; /**< Size of the frame on the wire, larger than size if the frame was truncated */
+    int64_t timestamp_ns; /**< CLOCK_REALTIME when the frame was received, in nanoseconds */
+};
+
+struct TcsPacketRing;
+
+/**
+ * @brief One classic BPF instruction. Same layout as struct sock_filter on Linux.
+ */
+struct TcsFilterInstruction
+{
+    uint16_t code; /**< Operation, BPF_* values from linux/filter.h */
+    uint8_t jt;    /**< Number of instructions to skip if the jump condition is true */
+    uint8_t jf;    /**< Number of instructions to skip if the jump condition is false */
+    uint32_t k;    /**< Operand */
+};
+
+/**
+ * @brief A classic BPF program that decides in the kernel which frames a socket receives.
+ *
+ * Build it with tcs_filter_init() and the tcs_filter_*() predicates, a frame is accepted if all predicates match.
+ * The instructions may also be written by hand.
+ *
+ * @see tcs_opt_filter_attach()
+ */
+struct TcsFilter
+{
+    struct TcsFilterInstruction instructions[TCS_CFG_FILTER_MAX_INSTRUCTIONS];
+    size_t length;
+};
 struct TcsPoll;
+struct TcsConnector;
+struct TcsPool;
+struct TcsResolver;
+struct TcsDns;
+struct TcsAddressMap;
 struct TcsPollEvent
 {
     TcsSocket socket;
@@ -372,6 +572,7 @@ struct TcsPollEvent
     bool can_read;
     bool can_write;
     TcsResult error;
+    bool can_read_error_queue; /**< Transmit timestamps are waiting, see tcs_receive_tx_timestamps() */
 };
 
 extern const TcsFamily TCS_FAMILY_ANY;    /**< Layer 4 agnostic (AF_UNSPEC) */
@@ -404,6 +605,10 @@ extern const TcsSocketType TCS_SOCKET_STREAM; /**< Use for streaming types like
 extern const TcsSocketType TCS_SOCKET_DGRAM;  /**< Use for datagrams types like UDP */
 extern const TcsSocketType TCS_SOCKET_RAW;    /**< Use for raw sockets, eg. layer 2 packet sockets */
 
+// Socket creation flags, see tcs_socket_with_flags()
+static const uint32_t TCS_SOCKET_FLAG_NONBLOCKING = 0x1; /**< Same as calling tcs_opt_nonblocking_set() afterwards */
+static const uint32_t TCS_SOCKET_FLAG_CLOEXEC = 0x2;     /**< Not inherited by child processes */
+
 static const TcsProtocol TCS_PROTOCOL_IP_TCP = 6;  /**< TCP, IANA-assigned (RFC 9293). Use with TCS_SOCKET_STREAM. */
 static const TcsProtocol TCS_PROTOCOL_IP_UDP = 17; /**< UDP, IANA-assigned (RFC 768). Use with TCS_SOCKET_DGRAM. */
 static const TcsProtocol TCS_PROTOCOL_ETH_ALL = 3; /**< Receive all protocols. Use with TCS_FAMILY_PACKET. */
@@ -416,6 +621,9 @@ extern const uint32_t TCS_MSG_WAITALL;
 // Send flags
 extern const uint32_t TCS_MSG_SENDALL;
 
+// Send and recv flags
+extern const uint32_t TCS_MSG_DONTWAIT; /**< Do not block in this call only, the socket keeps its blocking mode */
+
 // Backlog
 extern const int TCS_BACKLOG_MAX; /**< Max number of queued sockets when listening */
 
@@ -453,7 +661,7 @@ extern const int32_t TCS_PACKET_MEMBERSHIP_DROP;
 // Use for timeout to wait until infinity happens
 extern const int32_t TCS_WAIT_INF;
 
-static const struct TcsPollEvent TCS_POLL_EVENT_EMPTY = {0, 0, false, false, TCS_SUCCESS};
+static const struct TcsPollEvent TCS_POLL_EVENT_EMPTY = {0, 0, false, false, TCS_SUCCESS, false};
 
 // ######## Library Management ########
 
@@ -500,6 +708,68 @@ TcsResult tcs_lib_init(void);
  */
 TcsResult tcs_lib_cleanup(void);
 
+/**
+ * @brief Get a monotonic clock in milliseconds, suitable for timeouts and deadlines.
+ *
+ * The starting point is unspecified, only differences between two calls are meaningful.
+ *
+ * @return Milliseconds since an unspecified point in time.
+ */
+int64_t tcs_time_monotonic_ms(void);
+
+/** @brief Allocates size bytes, returns NULL on failure. See tcs_lib_set_allocator(). */
+typedef void* (*TcsAllocFn)(size_t size, void* context);
+/** @brief Works like realloc(), ptr may be NULL and size is never 0. See tcs_lib_set_allocator(). */
+typedef void* (*TcsReallocFn)(void* ptr, size_t size, void* context);
+/** @brief Frees memory from the other two functions, never called with NULL. See tcs_lib_set_allocator(). */
+typedef void (*TcsFreeFn)(void* ptr, void* context);
+
+/**
+ * @brief Route all memory the library allocates to your own allocator.
+ *
+ * Every allocation in the library goes through these functions, also the ones in its internal data structures.
+ * Use it to put the library memory in an arena or a NUMA local pool, or to count it in production.
+ * Pass NULL for all three functions to go back to malloc(), realloc() and free().
+ *
+ * The allocator is global and not protected against concurrent calls. Set it before using any other function in the
+ * library and do not change it while library objects exist, their memory is freed with the allocator that is set then.
+ *
+ * @code
+ * #include "tinycsocket.h"
+ *
+ * static size_t allocations = 0;
+ *
+ * static void* counting_alloc(size_t size, void* context) { (void)context; allocations++; return malloc(size); }
+ * static void* counting_realloc(void* ptr, size_t size, void* context) { (void)context; return realloc(ptr, size); }
+ * static void counting_free(void* ptr, void* context) { (void)context; free(ptr); }
+ *
+ * int main()
+ * {
+ *   tcs_lib_set_allocator(counting_alloc, counting_realloc, counting_free, NULL);
+ *   TcsResult tcs_init_res = tcs_lib_init();
+ *   // Do stuff with the library here
+ *   tcs_lib_cleanup();
+ * }
+ * @endcode
+ *
+ * @param alloc_fn is called instead of malloc().
+ * @param realloc_fn is called instead of realloc().
+ * @param free_fn is called instead of free().
+ * @param context is passed to all three functions.
+ * @return #TCS_SUCCESS if successful, otherwise the error code.
+ * @retval #TCS_ERROR_INVALID_ARGUMENT if some but not all of the functions are NULL.
+ */
+TcsResult tcs_lib_set_allocator(TcsAllocFn alloc_fn, TcsReallocFn realloc_fn, TcsFreeFn free_fn, void* context);
+
+/** @brief Allocate with the allocator from tcs_lib_set_allocator(), as the library does internally. */
+void* tcs_lib_malloc(size_t size);
+
+/** @brief Reallocate memory from tcs_lib_malloc() with the allocator from tcs_lib_set_allocator(). */
+void* tcs_lib_realloc(void* ptr, size_t size);
+
+/** @brief Free memory from tcs_lib_malloc() or tcs_lib_realloc(), NULL is ignored. */
+void tcs_lib_free(void* ptr);
+
 // ######## Socket Creation ########
 
 /**
@@ -558,6 +828,27 @@ TcsResult tcs_lib_cleanup(void);
  */
 TcsResult tcs_socket(TcsSocket* out_socket, TcsFamily family, TcsSocketType type, TcsProtocol protocol);
 
+/**
+ * @brief Create a new socket with creation flags applied atomically.
+ *
+ * Same as ::tcs_socket(), but the flags are applied by the socket call itself where the platform supports it
+ * (SOCK_NONBLOCK and SOCK_CLOEXEC on Linux and the BSDs), saving the extra calls to set them afterwards.
+ *
+ * @param[out] out_socket pointer to socket context to be created, which must have been initialized to #TCS_SOCKET_INVALID before use.
+ * @param[in] family See ::TcsFamily for supported values.
+ * @param[in] type specifies the type of the socket, supported values are: ::TCS_SOCKET_STREAM, ::TCS_SOCKET_DGRAM and ::TCS_SOCKET_RAW.
+ * @param[in] protocol specifies the protocol, for example #TCS_PROTOCOL_IP_TCP or #TCS_PROTOCOL_IP_UDP.
+ * @param[in] flags bitmask of #TCS_SOCKET_FLAG_NONBLOCKING and #TCS_SOCKET_FLAG_CLOEXEC, or #TCS_FLAG_NONE.
+ *
+ * @return #TCS_SUCCESS if successful, otherwise the error code.
+ * @see tcs_socket()
+ */
+TcsResult tcs_socket_with_flags(TcsSocket* out_socket,
+                                TcsFamily family,
+                                TcsSocketType type,
+                                TcsProtocol protocol,
+                                uint32_t flags);
+
 /**
 * @brief Create a TCP socket, optionally bind to a local address and/or connect to a remote address.
 *
@@ -566,6 +857,7 @@ TcsResult tcs_socket(TcsSocket* out_socket, TcsFamily family, TcsSocketType type
 * If @p remote_address is not NULL, the socket connects to it.
 * At least one of @p local_address or @p remote_address must be non-NULL.
 * If both are provided, they must have the same address family.
+* The socket is created with #TCS_SOCKET_FLAG_CLOEXEC and is returned in blocking mode.
 * On failure, *out_socket is always set back to #TCS_SOCKET_INVALID.
 *
 * @code
@@ -616,8 +908,9 @@ TcsResult tcs_socket_tcp(TcsSocket* out_socket,
 /**
 * @brief Create a TCP socket from string addresses, optionally bind and/or connect.
 *
-* Resolves the address strings with ::tcs_address_resolve() and delegates to ::tcs_socket_tcp().
-* Addresses must include a port, e.g. "127.0.0.1:8080" or "[::1]:8080".
+* Resolves the address strings with ::tcs_address_resolve(). All resolved remote addresses are raced with
+* ::tcs_socket_tcp_any() (Happy Eyeballs), so an unreachable address family does not stall the connect.
+* Addresses must include a port, e.g. "127.0.0.1:8080", "[::1]:8080" or "example.com:80".
 * At least one of @p local_address or @p remote_address must be non-NULL.
 * On failure, *out_socket is always set back to #TCS_SOCKET_INVALID.
 *
@@ -660,6 +953,40 @@ TcsResult tcs_socket_tcp_str(TcsSocket* out_socket,
                              const char* remote_address,
                              int timeout_ms);
 
+/**
+* @brief Create a TCP socket connected to the first reachable of several remote addresses (Happy Eyeballs, RFC 8305).
+*
+* The addresses are interleaved by family, keeping their order within each family, starting with the family of the
+* first address. A non-blocking connect is started to one address at a time. The next one is started when the
+* previous attempt fails or after #TCS_CFG_CONNECT_ATTEMPT_DELAY_MS without an answer, without cancelling the earlier
+* attempts. The first attempt to succeed is kept and the others are closed.
+*
+* @code
+* struct TcsAddress candidates[TCS_CFG_CONNECT_CANDIDATES_MAX];
+* size_t count = 0;
+* tcs_address_resolve("example.com", TCS_FAMILY_ANY, candidates, TCS_CFG_CONNECT_CANDIDATES_MAX, &count);
+* // Set the port of each candidate
+* TcsSocket socket = TCS_SOCKET_INVALID;
+* tcs_socket_tcp_any(&socket, NULL, candidates, count, 5000);
+* @endcode
+*
+* @param[out] out_socket pointer to socket context to be created, which must have been initialized to #TCS_SOCKET_INVALID before use.
+* @param[in] local_address address to bind to, or NULL to skip binding. Remote addresses of another family are skipped.
+* @param[in] remote_addresses addresses to try. At most #TCS_CFG_CONNECT_CANDIDATES_MAX are used.
+* @param[in] remote_addresses_length number of elements in @p remote_addresses.
+* @param[in] timeout_ms maximum time in milliseconds for all attempts together, or #TCS_WAIT_INF to wait until every attempt has failed.
+*
+* @return #TCS_SUCCESS if successful, otherwise the error of the last failed attempt.
+* @retval #TCS_ERROR_TIMED_OUT if no attempt succeeded within @p timeout_ms.
+*
+* @see tcs_socket_tcp_str()
+*/
+TcsResult tcs_socket_tcp_any(TcsSocket* out_socket,
+                             const struct TcsAddress* local_address,
+                             const struct TcsAddress remote_addresses[],
+                             size_t remote_addresses_length,
+                             int timeout_ms);
+
 /**
 * @brief Create a UDP socket, optionally bind to a local address and/or connect to a remote address.
 *
@@ -844,6 +1171,42 @@ TcsResult tcs_socket_packet_str(TcsSocket* out_socket,
                                 uint16_t protocol,
                                 TcsSocketType type);
 
+/**
+* @brief Create one socket per CPU sharing the same local address, with incoming traffic steered to the socket of the
+* CPU that received it.
+*
+* The sockets join a SO_REUSEPORT group in order and tcs_opt_reuse_port_steer_by_cpu() is attached, so socket i gets
+* the traffic handled by CPU i. Run the worker of socket i on CPU i to keep the receive path cache local.
+* Stream sockets are listening when returned. If @p local_address has port 0, all sockets share the port picked for
+* the first one.
+*
+* @code
+* TcsSocket sockets[64];
+* for (int i = 0; i < 64; ++i)
+*     sockets[i] = TCS_SOCKET_INVALID;
+* struct TcsAddress local = TCS_ADDRESS_NONE;
+* tcs_address_parse("0.0.0.0:5000", &local);
+* size_t count = 0;
+* tcs_socket_per_cpu(sockets, 64, TCS_SOCKET_DGRAM, &local, &count);
+* // Start count workers, worker i pinned to CPU i receives from sockets[i]
+* @endcode
+*
+* @note Only supported on Linux. Will return #TCS_ERROR_NOT_SUPPORTED on other platforms.
+*
+* @param[out] out_sockets array of sockets to create, all must be initialized to #TCS_SOCKET_INVALID.
+* @param[in] sockets_length number of elements in @p out_sockets. Fewer sockets than CPUs share CPUs round robin.
+* @param[in] type either #TCS_SOCKET_DGRAM for UDP or #TCS_SOCKET_STREAM for TCP listeners.
+* @param[in] local_address is the address all sockets are bound to.
+* @param[out] out_sockets_count number of created sockets, the smaller of the CPU count and @p sockets_length.
+* @return #TCS_SUCCESS if successful, otherwise the error code. No sockets are left open on failure.
+* @see tcs_opt_reuse_port_steer_by_cpu()
+*/
+TcsResult tcs_socket_per_cpu(TcsSocket out_sockets[],
+                             size_t sockets_length,
+                             TcsSocketType type,
+                             const struct TcsAddress* local_address,
+                             size_t* out_sockets_count);
+
 /**
 * @brief Closes the socket, stop communication and free all resources for the socket.
 *
@@ -1054,6 +1417,29 @@ TcsResult tcs_connect(TcsSocket socket, const struct TcsAddress* address);
  */
 TcsResult tcs_connect_str(TcsSocket socket, const char* remote_address, uint16_t port);
 
+/**
+ * @brief Connect a socket to a remote address, giving up after a timeout.
+ *
+ * Waits for the connection on the socket itself, without any heap allocation or poll context. A blocking socket is
+ * made non-blocking for the duration of the call and restored afterwards. A non-blocking socket, for example from
+ * tcs_socket_with_flags() with #TCS_SOCKET_FLAG_NONBLOCKING, is used as is and skips both mode switches.
+ *
+ * @note On Windows the non-blocking state cannot be queried, the socket is always left in blocking mode.
+ *
+ * @param[in] socket a TCP socket that is not yet connected.
+ * @param[in] address remote address to connect to.
+ * @param[in] timeout_ms maximum time to wait in milliseconds, or #TCS_WAIT_INF to behave as tcs_connect().
+ *
+ * @return #TCS_SUCCESS if the connection was established, otherwise the error code.
+ * @retval #TCS_ERROR_TIMED_OUT if the connection was not established within @p timeout_ms. The connection attempt is
+ * still in progress, close the socket before reusing it.
+ * @retval #TCS_ERROR_CONNECTION_REFUSED if the remote side refused the connection.
+ *
+ * @see tcs_connect()
+ * @see tcs_socket_tcp()
+ */
+TcsResult tcs_connect_timeout(TcsSocket socket, const struct TcsAddress* address, int timeout_ms);
+
 /**
  * @brief Let a socket start listening for incoming connections.
  *
@@ -1098,6 +1484,38 @@ TcsResult tcs_listen(TcsSocket socket, int backlog);
  */
 TcsResult tcs_accept(TcsSocket listener, TcsSocket* out_socket, struct TcsAddress* out_address);
 
+/**
+ * @brief Accept all pending connections of a listening socket, up to a maximum, in one call.
+ *
+ * The accepted sockets are non-blocking and close-on-exec from the start, on Linux with a single accept4() per
+ * connection. Use a non-blocking listener, for example together with a TcsPoll, otherwise the call blocks until
+ * @p sockets_length connections have been accepted.
+ *
+ * @code
+ * TcsSocket clients[64];
+ * size_t count = 0;
+ * tcs_accept_many(listen_socket, clients, NULL, 64, &count);
+ * for (size_t i = 0; i < count; ++i)
+ *     add_client(clients[i]);
+ * @endcode
+ *
+ * @param[in] listener is a listening socket, see ::tcs_listen().
+ * @param[out] out_sockets array that receives the accepted sockets. Its content is overwritten.
+ * @param[out] out_addresses optional array of at least @p sockets_length elements for the remote addresses, NULL to
+ * skip the address conversion.
+ * @param[in] sockets_length maximum number of connections to accept.
+ * @param[out] out_accepted_count number of sockets written to @p out_sockets, also when an error is returned.
+ *
+ * @return #TCS_SUCCESS if at least one connection was accepted, otherwise the error code.
+ * @retval #TCS_ERROR_WOULD_BLOCK if no connection was pending.
+ * @see tcs_accept()
+ */
+TcsResult tcs_accept_many(TcsSocket listener,
+                          TcsSocket out_sockets[],
+                          struct TcsAddress out_addresses[],
+                          size_t sockets_length,
+                          size_t* out_accepted_count);
+
 /**
 * @brief Turn off communication with a 3-way handshaking for the socket.
 * 
@@ -1143,6 +1561,36 @@ TcsResult tcs_send_to(TcsSocket socket,
                       const struct TcsAddress* destination_address,
                       size_t* out_sent_size);
 
+/**
+ * @brief Sends a datagram to an address from a chosen local address and/or interface.
+ *
+ * Useful for UDP servers bound to the wildcard address on hosts with several addresses. Reply from the
+ * destination address returned by tcs_receive_from_to() and the reply will leave from the address the request
+ * was sent to.
+ *
+ * @note Not supported on Windows. Will return #TCS_ERROR_NOT_SUPPORTED on that platform.
+ *
+ * @param[in] socket is your in-out socket context.
+ * @param[in] buffer is a pointer to your data you want to send.
+ * @param[in] buffer_size is number of bytes of the data you want to send.
+ * @param[in] flags is a bitmask of send flags. Use #TCS_FLAG_NONE for no flags.
+ * @param[in] destination_address is the address to send to.
+ * @param[in] source_address is the local address to send from, or NULL to let the routing table decide. The port is ignored.
+ * @param[in] interface_id is the interface to send on, or 0 to let the routing table decide.
+ * @param[out] out_sent_size is how many bytes that was successfully sent.
+ * @return #TCS_SUCCESS if successful, otherwise the error code.
+ * @retval #TCS_ERROR_INVALID_ARGUMENT if source_address and destination_address have different families.
+ * @see tcs_receive_from_to()
+ */
+TcsResult tcs_send_to_from(TcsSocket socket,
+                           const uint8_t* buffer,
+                           size_t buffer_size,
+                           uint32_t flags,
+                           const struct TcsAddress* destination_address,
+                           const struct TcsAddress* source_address,
+                           TcsInterfaceId interface_id,
+                           size_t* out_sent_size);
+
 /**
 * @brief Sends several data buffers on a socket as one message.
 *
@@ -1186,7 +1634,7 @@ TcsResult tcs_send_netstring(TcsSocket socket, const uint8_t* buffer, size_t buf
 * @param[in] socket is your in-out socket context.
 * @param[out] buffer is a pointer to your buffer where you want to store the incoming data to.
 * @param[in] buffer_size is the byte size of your buffer, for preventing overflows.
-* @param[in] flags is a bitmask of receive flags. Use #TCS_FLAG_NONE for no flags, or any combination of #TCS_MSG_PEEK, #TCS_MSG_OOB, and #TCS_MSG_WAITALL.
+* @param[in] flags is a bitmask of receive flags. Use #TCS_FLAG_NONE for no flags, or any combination of #TCS_MSG_PEEK, #TCS_MSG_OOB, #TCS_MSG_WAITALL and #TCS_MSG_DONTWAIT.
 * @param[out] out_received_size is how many bytes that was successfully written to your buffer.
 * @return #TCS_SUCCESS if successful, otherwise the error code.
 * @see tcs_send()
@@ -1199,7 +1647,7 @@ TcsResult tcs_receive(TcsSocket socket, uint8_t* buffer, size_t buffer_size, uin
 * @param[in] socket is your in-out socket context.
 * @param[out] buffer is a pointer to your buffer where you want to store the incoming data to.
 * @param[in] buffer_size is the byte size of your buffer, for preventing overflows.
-* @param[in] flags is a bitmask of receive flags. Use #TCS_FLAG_NONE for no flags, or any combination of #TCS_MSG_PEEK, #TCS_MSG_OOB, and #TCS_MSG_WAITALL.
+* @param[in] flags is a bitmask of receive flags. Use #TCS_FLAG_NONE for no flags, or any combination of #TCS_MSG_PEEK, #TCS_MSG_OOB, #TCS_MSG_WAITALL and #TCS_MSG_DONTWAIT.
 * @param[out] out_source_address is the address the data was received from.
 * @param[out] out_received_size is how many bytes that was successfully written to your buffer.
 * @return #TCS_SUCCESS if successful, otherwise the error code.
@@ -1212,6 +1660,43 @@ TcsResult tcs_receive_from(TcsSocket socket,
                            struct TcsAddress* out_source_address,
                            size_t* out_received_size);
 
+/**
+* @brief Receive a datagram together with its local destination address and ingress interface.
+*
+* Packet info must be enabled with tcs_opt_packet_info_set() first, otherwise @p out_destination_address is set to
+* #TCS_ADDRESS_NONE and @p out_interface_id to 0.
+*
+* @code
+* tcs_opt_packet_info_set(socket, true);
+* struct TcsAddress remote = TCS_ADDRESS_NONE;
+* struct TcsAddress local = TCS_ADDRESS_NONE;
+* TcsInterfaceId iface = 0;
+* tcs_receive_from_to(socket, buffer, sizeof(buffer), TCS_FLAG_NONE, &remote, &local, &iface, &received);
+* tcs_send_to_from(socket, buffer, received, TCS_FLAG_NONE, &remote, &local, iface, NULL); // Echo from same address
+* @endcode
+*
+* @note Not supported on Windows. Will return #TCS_ERROR_NOT_SUPPORTED on that platform.
+*
+* @param[in] socket is your in-out socket context.
+* @param[out] buffer is a pointer to your buffer where you want to store the incoming data to.
+* @param[in] buffer_size is the byte size of your buffer, for preventing overflows.
+* @param[in] flags is a bitmask of receive flags. Use #TCS_FLAG_NONE for no flags, or any combination of #TCS_MSG_PEEK, #TCS_MSG_OOB, #TCS_MSG_WAITALL and #TCS_MSG_DONTWAIT.
+* @param[out] out_source_address is the address the data was received from. May be NULL.
+* @param[out] out_destination_address is the local address the data was sent to. The port is not set. May be NULL.
+* @param[out] out_interface_id is the interface the data was received on. May be NULL.
+* @param[out] out_received_size is how many bytes that was successfully written to your buffer.
+* @return #TCS_SUCCESS if successful, otherwise the error code.
+* @see tcs_send_to_from()
+*/
+TcsResult tcs_receive_from_to(TcsSocket socket,
+                              uint8_t* buffer,
+                              size_t buffer_size,
+                              uint32_t flags,
+                              struct TcsAddress* out_source_address,
+                              struct TcsAddress* out_destination_address,
+                              TcsInterfaceId* out_interface_id,
+                              size_t* out_received_size);
+
 /**
 * @brief Read up to and including a delimiter.
 *
@@ -1253,6 +1738,37 @@ TcsResult tcs_receive_line(TcsSocket socket,
 */
 TcsResult tcs_receive_netstring(TcsSocket socket, uint8_t* buffer, size_t buffer_size, size_t* out_received_size);
 
+/**
+* @brief Drain transmit timestamps from the socket error queue.
+*
+* Timestamps must first be enabled with tcs_opt_tx_timestamping_set(). Every send after that queues one
+* timestamp when the packet leaves the network stack. A socket in a TcsPoll reports
+* TcsPollEvent::can_read_error_queue when timestamps are waiting. The call never blocks.
+*
+* @code
+* tcs_opt_tx_timestamping_set(socket, true);
+* tcs_send_to(socket, msg, sizeof(msg), TCS_FLAG_NONE, &destination, NULL); // Gets id 0
+* // ... poll until can_read_error_queue ...
+* struct TcsTxTimestamp timestamps[16];
+* size_t count = 0;
+* tcs_receive_tx_timestamps(socket, timestamps, 16, &count);
+* @endcode
+*
+* @note Only supported on Linux. Will return #TCS_ERROR_NOT_SUPPORTED on other platforms.
+*
+* @param[in] socket socket with transmit timestamping enabled.
+* @param[out] out_timestamps array to fill with timestamps, oldest first.
+* @param[in] timestamps_length number of elements in @p out_timestamps.
+* @param[out] out_length number of timestamps written to @p out_timestamps.
+* @return #TCS_SUCCESS if at least one timestamp was read, otherwise the error code.
+* @retval #TCS_ERROR_WOULD_BLOCK if no timestamps are queued.
+* @see tcs_opt_tx_timestamping_set()
+*/
+TcsResult tcs_receive_tx_timestamps(TcsSocket socket,
+                                    struct TcsTxTimestamp out_timestamps[],
+                                    size_t timestamps_length,
+                                    size_t* out_length);
+
 /**
 * @brief Create a context used for waiting on several sockets.
 *
@@ -1369,5525 +1885,11852 @@ TcsResult tcs_poll_wait(struct TcsPoll* poll,
                         int timeout_ms);
 
 /**
-* @brief Set parameters on a socket. It is recommended to use tcs_opt_*_set() instead.
+* @brief Create a connector that opens TCP connections to many remote addresses in parallel.
 *
-* @param[in] socket is your in-out socket context.
-* @param[in] level is the definition level.
-* @param[in] option_name is the option name.
-* @param[in] option_value is a pointer to the option value.
-* @param[in] option_size is the byte size of the data pointed by @p option_value.
-* @return #TCS_SUCCESS if successful, otherwise the error code.
-*/
-TcsResult tcs_opt_set(TcsSocket socket,
-                      int32_t level,
-                      int32_t option_name,
-                      const void* option_value,
-                      size_t option_size);
-
-/**
-* @brief Get parameters on a socket. It is recommended to use tcs_opt_*_get() instead.
+* All connects are driven by one poll context in tcs_connector_run(), pick up the connected sockets and the result of
+* each target with tcs_connector_take().
 *
 * @code
-* uint8_t c;
-* size_t a = sizeof(c);
-* tcs_opt_get(socket, TCS_SOL_IP, TCS_IP_MULTICAST_LOOP, &c, &a);
+* struct TcsConnector* connector = NULL;
+* tcs_connector_create(&connector, backends, backends_count);
+* tcs_connector_run(connector, 0, 1000, 5000);
+* for (size_t i = 0; i < backends_count; ++i)
+* {
+*     TcsSocket socket = TCS_SOCKET_INVALID;
+*     if (tcs_connector_take(connector, i, &socket) == TCS_SUCCESS)
+*         use_backend(i, socket);
+* }
+* tcs_connector_destroy(&connector);
 * @endcode
 *
-* @param[in] socket is your in-out socket context.
-* @param[in] level is the definition level.
-* @param[in] option_name is the option name.
-* @param[out] out_option_value is a pointer to receive the option value.
-* @param[in,out] option_size is a pointer the byte size of the data pointed by @p out_option_value.
+* @param[out] out_connector is your out connector pointer. Initiate a TcsConnector pointer to NULL and use the address of this pointer.
+* @param[in] remote_addresses addresses to connect to, the array is copied.
+* @param[in] remote_addresses_length number of elements in @p remote_addresses.
 * @return #TCS_SUCCESS if successful, otherwise the error code.
+* @see tcs_connector_destroy()
 */
-TcsResult tcs_opt_get(TcsSocket socket,
-                      int32_t level,
-                      int32_t option_name,
-                      void* out_option_value,
-                      size_t* option_size);
+TcsResult tcs_connector_create(struct TcsConnector** out_connector,
+                               const struct TcsAddress remote_addresses[],
+                               size_t remote_addresses_length);
 
 /**
-* @brief Query the socket type (e.g. ::TCS_SOCKET_STREAM or ::TCS_SOCKET_DGRAM).
+* @brief Free a connector and close every socket that has not been taken with tcs_connector_take().
 *
-* @param[in] socket socket to query.
-* @param[out] out_type pointer to receive the socket type.
+* @param[in,out] connector is a pointer to your connector pointer. It will be set to NULL.
 * @return #TCS_SUCCESS if successful, otherwise the error code.
 */
-TcsResult tcs_opt_type_get(TcsSocket socket, TcsSocketType* out_type);
+TcsResult tcs_connector_destroy(struct TcsConnector** connector);
 
 /**
-* @brief Enable the socket to be allowed to send to broadcast addresses.
+* @brief Connect to all targets of the connector in parallel and wait until each one has a result.
+*
+* Targets are started in order, at most @p max_in_flight at a time. A target that is not connected
+* @p connect_timeout_ms after its start fails with #TCS_ERROR_TIMED_OUT. When @p total_timeout_ms has passed, all
+* unfinished targets, including the ones never started, fail with #TCS_ERROR_TIMED_OUT. Connected sockets are in
+* blocking mode. Targets that already have a result are not retried by later calls.
+*
+* @param[in] connector created with tcs_connector_create().
+* @param[in] max_in_flight maximum number of simultaneous connects, 0 for no limit.
+* @param[in] connect_timeout_ms per target timeout in milliseconds, or #TCS_WAIT_INF.
+* @param[in] total_timeout_ms timeout for the whole call in milliseconds, or #TCS_WAIT_INF.
+* @return #TCS_SUCCESS when every target has a result, use tcs_connector_take() to see which ones connected.
+* @retval #TCS_ERROR_TIMED_OUT if @p total_timeout_ms cut some targets short.
+*/
+TcsResult tcs_connector_run(struct TcsConnector* connector,
+                            size_t max_in_flight,
+                            int connect_timeout_ms,
+                            int total_timeout_ms);
+
+/**
+* @brief Get the result of one target and take over its socket.
+*
+* @param[in] connector created with tcs_connector_create().
+* @param[in] index of the target, in the order given to tcs_connector_create().
+* @param[out] out_socket receives the connected socket on success and the caller becomes its owner. Must be
+* initialized to #TCS_SOCKET_INVALID. May be NULL to only query the result, the connector then keeps the socket.
+* @return #TCS_SUCCESS if the target is connected, otherwise the error of its connect.
+* @retval #TCS_IN_PROGRESS if tcs_connector_run() has not finished the target yet.
+* @retval #TCS_ERROR_INVALID_ARGUMENT if the index is out of range or the socket was already taken.
+*/
+TcsResult tcs_connector_take(struct TcsConnector* connector, size_t index, TcsSocket* out_socket);
+
+/**
+* @brief Create a thread safe pool of outbound TCP connections, keyed by remote address.
 *
-* By default, sockets are not permitted to send to broadcast addresses (e.g.
-* 255.255.255.255 or subnet broadcast addresses) as a safety measure to prevent
-* accidental broadcast storms. Enable this option on UDP sockets that need to
-* send broadcast traffic.
+* Released connections are kept open and handed out again by tcs_pool_acquire() for the same remote address, saving
+* the handshake and the TIME_WAIT state of a closed connection. The pool is split in #TCS_CFG_POOL_SHARDS
+* independently locked parts to keep contention low.
 *
-* Only valid for protocols that support broadcast, for example UDP. Default is false.
+* @code
+* struct TcsPool* pool = NULL;
+* tcs_pool_create(&pool, 4, 16, 30000, 1000);
+* TcsSocket socket = TCS_SOCKET_INVALID;
+* if (tcs_pool_acquire(pool, &backend, &socket) == TCS_SUCCESS)
+* {
+*     bool is_ok = do_request(socket);
+*     tcs_pool_release(pool, &backend, &socket, is_ok);
+* }
+* tcs_pool_destroy(&pool);
+* @endcode
 *
-* @param[in] socket socket to enable/disable permission to send broadcast on.
-* @param[in] do_allow_broadcast set to true to allow, false to forbid.
+* @param[out] out_pool is your out pool pointer. Initiate a TcsPool pointer to NULL and use the address of this pointer.
+* @param[in] max_idle_per_key maximum number of idle connections kept per remote address.
+* @param[in] max_total_per_key maximum number of connections per remote address, idle and acquired together.
+* @param[in] idle_timeout_ms idle connections older than this are closed, or #TCS_WAIT_INF to keep them.
+* @param[in] connect_timeout_ms timeout for new connections, see tcs_socket_tcp().
 * @return #TCS_SUCCESS if successful, otherwise the error code.
+* @see tcs_pool_destroy()
 */
-TcsResult tcs_opt_broadcast_set(TcsSocket socket, bool do_allow_broadcast);
+TcsResult tcs_pool_create(struct TcsPool** out_pool,
+                          size_t max_idle_per_key,
+                          size_t max_total_per_key,
+                          int idle_timeout_ms,
+                          int connect_timeout_ms);
 
 /**
-* @brief Query whether broadcast is enabled on a socket.
+* @brief Close all idle connections and free the pool.
 *
-* See tcs_opt_broadcast_set() for details on the broadcast option.
+* Connections that are acquired at this point are owned by the caller and must be closed with tcs_close().
 *
-* @param[in] socket socket to query.
-* @param[out] out_is_broadcast_allowed pointer to receive the current broadcast setting.
+* @param[in,out] pool is a pointer to your pool pointer. It will be set to NULL.
 * @return #TCS_SUCCESS if successful, otherwise the error code.
 */
-TcsResult tcs_opt_broadcast_get(TcsSocket socket, bool* out_is_broadcast_allowed);
+TcsResult tcs_pool_destroy(struct TcsPool** pool);
 
 /**
-* @brief Enable or disable TCP keep-alive on a socket.
-*
-* Keep-alive operates at the transport layer (TCP). When enabled, the OS periodically
-* sends probe packets on an idle connection to detect if the remote peer is still
-* reachable. Without keep-alive, a connection where neither side sends data can remain
-* open indefinitely even if the remote host has crashed or the network path is broken.
-*
-* Keep-alive probes also prevent NAT routers and stateful firewalls from dropping
-* idle connection mappings due to inactivity timeouts.
+* @brief Get a connection to a remote address, reusing an idle one when possible.
 *
-* This is particularly useful for long-lived connections that may be idle for extended
-* periods, such as database connections or control channels.
+* The most recently released idle connection is checked with a non-blocking peek. Connections that were closed or
+* reset by the peer, or that have unread data, are closed and the next one is tried. A new connection is made with
+* tcs_socket_tcp() when no idle one is usable.
 *
-* @param[in] socket socket to configure.
-* @param[in] do_keep_alive set to true to enable, false to disable.
+* @param[in] pool created with tcs_pool_create().
+* @param[in] remote_address the key of the connection.
+* @param[out] out_socket receives the connection. Must be initialized to #TCS_SOCKET_INVALID.
 * @return #TCS_SUCCESS if successful, otherwise the error code.
+* @retval #TCS_ERROR_WOULD_BLOCK if the maximum number of connections to @p remote_address are already acquired.
+* @see tcs_pool_release()
 */
-TcsResult tcs_opt_keep_alive_set(TcsSocket socket, bool do_keep_alive);
+TcsResult tcs_pool_acquire(struct TcsPool* pool, const struct TcsAddress* remote_address, TcsSocket* out_socket);
 
 /**
-* @brief Query whether keep-alive is enabled on a socket.
-*
-* See tcs_opt_keep_alive_set() for details on what keep-alive does.
+* @brief Give a connection from tcs_pool_acquire() back to the pool.
 *
-* @param[in] socket socket to query.
-* @param[out] out_is_keep_alive_enabled pointer to receive the current keep-alive setting.
+* @param[in] pool created with tcs_pool_create().
+* @param[in] remote_address the same address as used for tcs_pool_acquire().
+* @param[in,out] socket the connection. It is kept idle or closed, and set to #TCS_SOCKET_INVALID.
+* @param[in] is_reusable false to close the connection, e.g. after a protocol error.
 * @return #TCS_SUCCESS if successful, otherwise the error code.
 */
-TcsResult tcs_opt_keep_alive_get(TcsSocket socket, bool* out_is_keep_alive_enabled);
+TcsResult tcs_pool_release(struct TcsPool* pool,
+                           const struct TcsAddress* remote_address,
+                           TcsSocket* socket,
+                           bool is_reusable);
 
 /**
-* @brief Allow or disallow address reuse on a socket.
-*
-* **TCP:**
-* Allows binding to a port that is in the TIME_WAIT state. When a TCP connection
-* is closed, the port remains reserved for up to 2 minutes (2x Maximum Segment
-* Lifetime) to ensure delayed packets from the old connection are not misinterpreted
-* by a new one. This option bypasses that restriction, which is useful for server
-* sockets that need to restart quickly.
-* On POSIX, it also allows overlapping wildcard and specific address binds on the same
-* port (e.g. both 0.0.0.0:8080 and 192.168.1.1:8080). The most specific address wins.
-*
-* **UDP:**
-* Allows multiple sockets to bind to the same address and port. The behavior for
-* unicast datagrams is OS-specific, but on most implementations only the most
-* recently bound socket receives them.
-* This is primarily useful for multicast, where several sockets need to receive the
-* same group traffic.
+* @brief Create a resolver that runs tcs_address_resolve() on a pool of worker threads.
 *
-* For load-balancing multiple sockets on the same port, see ::tcs_opt_reuse_port_set().
+* Lookups are submitted without blocking and completions are signaled through a socket that can be added to a
+* TcsPoll, so an event loop thread can resolve hostnames. Any number of lookups can be queued, @p thread_count of them
+* run at the same time.
 *
-* @note On Windows, this library sets SO_EXCLUSIVEADDRUSE alongside SO_REUSEADDR
-* for TCP sockets to prevent port hijacking, matching the security guarantees of
-* POSIX. For UDP sockets, only SO_REUSEADDR is set, preserving multicast and
-* same-port binding behavior. I.e. it mimics POSIX behaviour.
+* @code
+* struct TcsResolver* resolver = NULL;
+* tcs_resolver_create(&resolver, 4);
+* TcsSocket resolver_socket = TCS_SOCKET_INVALID;
+* tcs_resolver_socket(resolver, &resolver_socket);
+* tcs_poll_add(poll, resolver_socket, resolver, TCS_POLL_READ);
+*
+* size_t handle = 0;
+* tcs_resolver_submit(resolver, "example.com", TCS_FAMILY_ANY, &handle);
+*
+* // When resolver_socket is readable
+* TcsResult lookup_result = TCS_SUCCESS;
+* struct TcsAddress addresses[4];
+* size_t count = 0;
+* while (tcs_resolver_take(resolver, &handle, &lookup_result, addresses, 4, &count) == TCS_SUCCESS)
+*     on_resolved(handle, lookup_result, addresses, count);
+* @endcode
 *
-* @param[in] socket socket to configure.
-* @param[in] do_allow_reuse_address set to true to allow, false to disallow.
+* @param[out] out_resolver is your out resolver pointer. Initiate a TcsResolver pointer to NULL and use the address of
+* this pointer.
+* @param[in] thread_count number of worker threads, the maximum number of concurrent lookups.
 * @return #TCS_SUCCESS if successful, otherwise the error code.
+* @retval #TCS_ERROR_NOT_SUPPORTED on POSIX unless the implementation is built with TCS_CFG_THREADS set to 1.
+* @see tcs_resolver_destroy()
 */
-TcsResult tcs_opt_reuse_address_set(TcsSocket socket, bool do_allow_reuse_address);
+TcsResult tcs_resolver_create(struct TcsResolver** out_resolver, size_t thread_count);
 
 /**
-* @brief Query whether address reuse is enabled on a socket.
+* @brief Stop the worker threads and free the resolver.
 *
-* See tcs_opt_reuse_address_set() for details on the address reuse option.
+* Waits for lookups that are already running, the system resolver can not interrupt them. Queued lookups are dropped.
 *
-* @param[in] socket socket to query.
-* @param[out] out_is_reuse_address_allowed pointer to receive the current setting.
+* @param[in,out] resolver is a pointer to your resolver pointer. It will be set to NULL.
 * @return #TCS_SUCCESS if successful, otherwise the error code.
 */
-TcsResult tcs_opt_reuse_address_get(TcsSocket socket, bool* out_is_reuse_address_allowed);
+TcsResult tcs_resolver_destroy(struct TcsResolver** resolver);
 
 /**
-* @brief Allow or disallow multiple sockets to bind to the same address and port.
-*
-* When enabled, the kernel distributes incoming traffic across all sockets bound to
-* the same address and port. All participating sockets must set this option, and on
-* POSIX systems they must belong to the same effective UID.
-*
-* This is useful for multi-threaded or multi-process servers that want to load-balance
-* incoming connections or datagrams across workers without application-level dispatching.
+* @brief Get the socket that is readable while there are finished lookups to take with tcs_resolver_take().
 *
-* @note Only supported on POSIX (Linux 3.9+). Returns #TCS_ERROR_NOT_SUPPORTED on Windows,
-* which has no equivalent with the same semantics.
+* Add it to a TcsPoll with #TCS_POLL_READ. It is owned by the resolver, do not read, write or close it. On POSIX it
+* is the read end of a pipe.
 *
-* @param[in] socket socket to configure.
-* @param[in] do_allow_reuse_port set to true to allow, false to disallow.
+* @param[in] resolver created with tcs_resolver_create().
+* @param[out] out_socket receives the socket.
 * @return #TCS_SUCCESS if successful, otherwise the error code.
 */
-TcsResult tcs_opt_reuse_port_set(TcsSocket socket, bool do_allow_reuse_port);
+TcsResult tcs_resolver_socket(struct TcsResolver* resolver, TcsSocket* out_socket);
 
 /**
-* @brief Query whether port reuse is enabled on a socket.
-*
-* See tcs_opt_reuse_port_set() for details.
+* @brief Queue a lookup without blocking.
 *
-* @note Returns #TCS_ERROR_NOT_SUPPORTED on Windows.
-*
-* @param[in] socket socket to query.
-* @param[out] out_is_reuse_port_allowed pointer to receive the current setting.
+* @param[in] resolver created with tcs_resolver_create().
+* @param[in] hostname hostname or IP string to resolve, it is copied.
+* @param[in] address_family address family filter, or ::TCS_FAMILY_ANY for all.
+* @param[out] out_handle identifies the lookup until it is taken or cancelled. Later lookups get other handles, so a
+* stale handle is rejected instead of acting on another lookup.
 * @return #TCS_SUCCESS if successful, otherwise the error code.
 */
-TcsResult tcs_opt_reuse_port_get(TcsSocket socket, bool* out_is_reuse_port_allowed);
+TcsResult tcs_resolver_submit(struct TcsResolver* resolver,
+                              const char* hostname,
+                              TcsFamily address_family,
+                              size_t* out_handle);
 
 /**
-* @brief Set the send buffer size of a socket.
+* @brief Take the result of the oldest finished lookup.
 *
-* @param[in] socket socket to configure.
-* @param[in] send_buffer_size desired send buffer size in bytes.
-* @return #TCS_SUCCESS if successful, otherwise the error code.
+* At most #TCS_CFG_RESOLVER_ADDRESSES_MAX addresses are kept per lookup.
+*
+* @param[in] resolver created with tcs_resolver_create().
+* @param[out] out_handle receives the handle given by tcs_resolver_submit().
+* @param[out] out_result receives the result of the lookup, as tcs_address_resolve() would have returned it.
+* @param[out] out_addresses array to receive resolved addresses, or NULL to only count.
+* @param[in] addresses_length number of elements in the @p out_addresses array.
+* @param[out] out_length pointer to receive the number of addresses found, or NULL.
+* @return #TCS_SUCCESS if a lookup was taken, otherwise the error code.
+* @retval #TCS_AGAIN if no lookup has finished.
 */
-TcsResult tcs_opt_send_buffer_size_set(TcsSocket socket, size_t send_buffer_size);
+TcsResult tcs_resolver_take(struct TcsResolver* resolver,
+                            size_t* out_handle,
+                            TcsResult* out_result,
+                            struct TcsAddress out_addresses[],
+                            size_t addresses_length,
+                            size_t* out_length);
 
 /**
-* @brief Query the send buffer size of a socket.
+* @brief Drop a lookup that is no longer needed. It will not be returned by tcs_resolver_take().
 *
-* @param[in] socket socket to query.
-* @param[out] out_send_buffer_size pointer to receive the send buffer size in bytes.
+* A lookup that is already running still occupies its worker thread until the system resolver returns.
+*
+* @param[in] resolver created with tcs_resolver_create().
+* @param[in] handle given by tcs_resolver_submit().
 * @return #TCS_SUCCESS if successful, otherwise the error code.
+* @retval #TCS_ERROR_INVALID_ARGUMENT if the lookup was already taken or cancelled.
 */
-TcsResult tcs_opt_send_buffer_size_get(TcsSocket socket, size_t* out_send_buffer_size);
+TcsResult tcs_resolver_cancel(struct TcsResolver* resolver, size_t handle);
 
 /**
-* @brief Set the receive buffer size of a socket.
+* @brief Create a DNS stub resolver that speaks DNS over its own non-blocking sockets, driven by your TcsPoll.
 *
-* @param[in] socket socket to configure.
-* @param[in] receive_buffer_size desired receive buffer size in bytes.
+* A and AAAA queries are sent in parallel over UDP to the nameservers. Queries without an answer are sent again to the
+* next nameserver after @p attempt_timeout_ms. Truncated answers are fetched again over TCP. Every attempt uses a new
+* socket with a random source port and a random query id. Thousands of lookups can be in flight from a single thread,
+* limited by the number of open sockets, no thread or blocking call is used.
+*
+* The resolver adds its sockets to @p poll with itself as user data. Pass every event with that user data to
+* tcs_dns_process() and call it when tcs_poll_wait() times out, using the timeout it returns.
+*
+* @code
+* struct TcsDns* dns = NULL;
+* tcs_dns_create(&dns, poll, NULL, 0, 5000, 2);
+* size_t handle = 0;
+* tcs_dns_submit(dns, "example.com", TCS_FAMILY_ANY, &handle);
+* int timeout_ms = 0;
+* tcs_dns_process(dns, NULL, &timeout_ms);
+* while (running)
+* {
+*     struct TcsPollEvent events[16];
+*     size_t count = 0;
+*     tcs_poll_wait(poll, events, 16, &count, timeout_ms);
+*     for (size_t i = 0; i < count; ++i)
+*     {
+*         if (events[i].user_data == dns)
+*             tcs_dns_process(dns, &events[i], &timeout_ms);
+*     }
+*     tcs_dns_process(dns, NULL, &timeout_ms);
+*     while (tcs_dns_take(dns, &handle, &lookup_result, addresses, 16, &address_count) == TCS_SUCCESS)
+*         on_resolved(handle, lookup_result, addresses, address_count);
+* }
+* @endcode
+*
+* @note Names are queried as given, search domains of resolv.conf are not applied. Use tcs_address_resolve() when the
+* full system resolver behavior is needed.
+*
+* @param[out] out_dns is your out resolver pointer. Initiate a TcsDns pointer to NULL and use the address of this
+* pointer.
+* @param[in] poll receives the sockets of the resolver. Must outlive the resolver.
+* @param[in] nameservers to ask, port 0 means 53. NULL to use the system configuration: the nameservers of
+* #TCS_CFG_DNS_RESOLV_CONF_PATH, or 127.0.0.1 if there are none, and the names in #TCS_CFG_DNS_HOSTS_PATH.
+* @param[in] nameservers_length number of nameservers, at most #TCS_CFG_DNS_NAMESERVERS_MAX. 0 if @p nameservers is
+* NULL.
+* @param[in] attempt_timeout_ms time to wait for an answer before asking again.
+* @param[in] attempts number of times every nameserver is asked before a lookup fails with #TCS_ERROR_TIMED_OUT.
 * @return #TCS_SUCCESS if successful, otherwise the error code.
+* @see tcs_dns_destroy()
 */
-TcsResult tcs_opt_receive_buffer_size_set(TcsSocket socket, size_t receive_buffer_size);
+TcsResult tcs_dns_create(struct TcsDns** out_dns,
+                         struct TcsPoll* poll,
+                         const struct TcsAddress nameservers[],
+                         size_t nameservers_length,
+                         int attempt_timeout_ms,
+                         int attempts);
 
 /**
-* @brief Query the receive buffer size of a socket.
+* @brief Remove the sockets of the resolver from its TcsPoll, close them and free the resolver.
 *
-* @param[in] socket socket to query.
-* @param[out] out_receive_buffer_size pointer to receive the receive buffer size in bytes.
+* @param[in,out] dns is a pointer to your resolver pointer. It will be set to NULL.
 * @return #TCS_SUCCESS if successful, otherwise the error code.
 */
-TcsResult tcs_opt_receive_buffer_size_get(TcsSocket socket, size_t* out_receive_buffer_size);
+TcsResult tcs_dns_destroy(struct TcsDns** dns);
 
 /**
-* @brief Set the receive timeout of a socket.
+* @brief Start a lookup. The queries are sent before this function returns.
 *
-* @param[in] socket socket to configure.
-* @param[in] timeout_ms timeout in milliseconds. Must be non-negative.
+* Numeric addresses and names in the hosts file are answered at once, call tcs_dns_take() to get them.
+*
+* @param[in] dns created with tcs_dns_create().
+* @param[in] hostname name or IP string to resolve.
+* @param[in] address_family ::TCS_FAMILY_IPV4 for A, ::TCS_FAMILY_IPV6 for AAAA or ::TCS_FAMILY_ANY for both.
+* @param[out] out_handle identifies the lookup until it is taken or cancelled. Later lookups get other handles, so a
+* stale handle is rejected instead of acting on another lookup.
 * @return #TCS_SUCCESS if successful, otherwise the error code.
 */
-TcsResult tcs_opt_receive_timeout_set(TcsSocket socket, int timeout_ms);
+TcsResult tcs_dns_submit(struct TcsDns* dns, const char* hostname, TcsFamily address_family, size_t* out_handle);
 
 /**
-* @brief Query the receive timeout of a socket.
+* @brief Read answers, progress TCP fallbacks and send again queries that timed out. Never blocks.
 *
-* @param[in] socket socket to query.
-* @param[out] out_timeout_ms pointer to receive the timeout in milliseconds.
+* @param[in] dns created with tcs_dns_create().
+* @param[in] event from tcs_poll_wait() with the resolver as user data, or NULL to only check timeouts.
+* @param[out] out_timeout_ms receives the time until the next timeout, 0 if finished lookups are waiting for
+* tcs_dns_take(), or #TCS_WAIT_INF if no query is in flight. May be NULL.
 * @return #TCS_SUCCESS if successful, otherwise the error code.
 */
-TcsResult tcs_opt_receive_timeout_get(TcsSocket socket, int* out_timeout_ms);
+TcsResult tcs_dns_process(struct TcsDns* dns, const struct TcsPollEvent* event, int* out_timeout_ms);
 
 /**
-* @brief Configure the linger behavior of a socket on close.
+* @brief Take the result of the oldest finished lookup.
 *
-* @param[in] socket socket to configure.
-* @param[in] do_linger set to true to enable lingering, false to disable.
-* @param[in] timeout_seconds linger timeout in seconds (only used when do_linger is true).
-* @return #TCS_SUCCESS if successful, otherwise the error code.
+* AAAA addresses are returned before A addresses, at most #TCS_CFG_DNS_ADDRESSES_MAX of each.
+*
+* @param[in] dns created with tcs_dns_create().
+* @param[out] out_handle receives the handle given by tcs_dns_submit().
+* @param[out] out_result receives the result of the lookup. #TCS_SUCCESS if any family has addresses.
+* @param[out] out_addresses array to receive resolved addresses, or NULL to only count.
+* @param[in] addresses_length number of elements in the @p out_addresses array.
+* @param[out] out_length pointer to receive the number of addresses found, or NULL.
+* @return #TCS_SUCCESS if a lookup was taken, otherwise the error code.
+* @retval #TCS_AGAIN if no lookup has finished.
 */
-TcsResult tcs_opt_linger_set(TcsSocket socket, bool do_linger, int timeout_seconds);
+TcsResult tcs_dns_take(struct TcsDns* dns,
+                       size_t* out_handle,
+                       TcsResult* out_result,
+                       struct TcsAddress out_addresses[],
+                       size_t addresses_length,
+                       size_t* out_length);
 
 /**
-* @brief Query the linger behavior of a socket.
+* @brief Stop a lookup that is no longer needed. Late answers are ignored.
 *
-* @param[in] socket socket to query.
-* @param[out] out_do_linger pointer to receive whether lingering is enabled.
-* @param[out] out_timeout_seconds pointer to receive the linger timeout in seconds.
+* @param[in] dns created with tcs_dns_create().
+* @param[in] handle given by tcs_dns_submit().
 * @return #TCS_SUCCESS if successful, otherwise the error code.
+* @retval #TCS_ERROR_INVALID_ARGUMENT if the lookup was already taken or cancelled.
 */
-TcsResult tcs_opt_linger_get(TcsSocket socket, bool* out_do_linger, int* out_timeout_seconds);
+TcsResult tcs_dns_cancel(struct TcsDns* dns, size_t handle);
 
 /**
-* @brief Enable or disable Nagle's algorithm (TCP_NODELAY).
+* @brief Create a memory mapped receive ring (TPACKET_V3) on a packet socket.
 *
-* @param[in] socket socket to configure.
-* @param[in] use_no_delay set to true to disable Nagle's algorithm (lower latency), false to enable it.
+* Frames are written by the kernel directly into memory shared with the application. No syscall or copy is needed
+* per frame. The ring is split into blocks, a block is handed to the application when it is full or when
+* @p block_timeout_ms has passed since the first frame was written to it. Iterate the frames of a block with
+* tcs_packet_ring_rx_next() and hand the block back with tcs_packet_ring_rx_release().
+*
+* Add the socket to a TcsPoll with #TCS_POLL_READ to wait for the next block.
+* Frames are no longer delivered to tcs_receive() while the ring exists.
+* A socket can only have one ring. The kernel fixes the ring version and the map offset per socket, so a transmit ring
+* from tcs_packet_ring_tx_create() needs a separate packet socket.
+*
+* @code
+* TcsSocket socket = TCS_SOCKET_INVALID;
+* tcs_socket_packet_str(&socket, "eth0", TCS_PROTOCOL_ETH_ALL, TCS_SOCKET_RAW);
+* struct TcsPacketRing* ring = NULL;
+* tcs_packet_ring_rx_create(&ring, socket, 1 << 20, 16, 2048, 10);
+* for (;;)
+* {
+*     struct TcsPacketFrame frame;
+*     TcsResult sts = tcs_packet_ring_rx_next(ring, &frame);
+*     if (sts == TCS_SUCCESS)
+*         handle_frame(frame.data, frame.size);
+*     else if (sts == TCS_AGAIN)
+*         tcs_packet_ring_rx_release(ring);
+*     else if (sts == TCS_ERROR_WOULD_BLOCK)
+*         wait_with_tcs_poll(socket);
+* }
+* tcs_packet_ring_destroy(&ring);
+* tcs_close(&socket);
+* @endcode
+*
+* @note Only supported on Linux. Will return #TCS_ERROR_NOT_SUPPORTED on other platforms.
+*
+* @param[out] out_ring is your out ring pointer. Initiate a TcsPacketRing pointer to NULL and use the address of this pointer.
+* @param[in] socket is a packet socket, see tcs_socket_packet(). The ring does not take ownership of the socket.
+* @param[in] block_size is the byte size of each block. Must be a multiple of the page size.
+* @param[in] block_count is the number of blocks in the ring.
+* @param[in] frame_size is the maximum byte size of a frame including the 48 byte ring header. Must be a multiple of 16.
+* @param[in] block_timeout_ms is the maximum time a partially filled block is held by the kernel. Use 0 for the kernel default.
 * @return #TCS_SUCCESS if successful, otherwise the error code.
+* @retval #TCS_ERROR_INVALID_ARGUMENT if the socket already has a receive or transmit ring.
+* @see tcs_packet_ring_destroy()
 */
-TcsResult tcs_opt_ip_no_delay_set(TcsSocket socket, bool use_no_delay);
+TcsResult tcs_packet_ring_rx_create(struct TcsPacketRing** out_ring,
+                                    TcsSocket socket,
+                                    size_t block_size,
+                                    size_t block_count,
+                                    size_t frame_size,
+                                    int block_timeout_ms);
 
 /**
-* @brief Query whether Nagle's algorithm is disabled on a socket.
+* @brief Unmap and free a packet ring. The socket is left open.
 *
-* @param[in] socket socket to query.
-* @param[out] out_is_no_delay_used pointer to receive the current setting.
+* @param[in,out] ring is a pointer to your ring pointer. Will be set to NULL.
 * @return #TCS_SUCCESS if successful, otherwise the error code.
 */
-TcsResult tcs_opt_ip_no_delay_get(TcsSocket socket, bool* out_is_no_delay_used);
+TcsResult tcs_packet_ring_destroy(struct TcsPacketRing** ring);
 
 /**
-* @brief Enable or disable inline reception of out-of-band data.
+* @brief Get the next received frame in place.
 *
-* @param[in] socket socket to configure.
-* @param[in] enable_oob set to true to receive OOB data inline, false to disable.
-* @return #TCS_SUCCESS if successful, otherwise the error code.
+* @param[in] ring is a receive ring created with tcs_packet_ring_rx_create().
+* @param[out] out_frame will point to the frame inside the ring.
+* @return #TCS_SUCCESS if a frame was returned, otherwise the error code.
+* @retval #TCS_AGAIN if all frames of the current block are consumed. Call tcs_packet_ring_rx_release() to continue.
+* @retval #TCS_ERROR_WOULD_BLOCK if no block is ready. Wait with TcsPoll.
 */
-TcsResult tcs_opt_out_of_band_inline_set(TcsSocket socket, bool enable_oob);
+TcsResult tcs_packet_ring_rx_next(struct TcsPacketRing* ring, struct TcsPacketFrame* out_frame);
 
 /**
-* @brief Query whether out-of-band data is received inline.
+* @brief Hand the current block back to the kernel and move to the next block.
 *
-* @param[in] socket socket to query.
-* @param[out] out_is_oob_enabled pointer to receive the current setting.
+* All frames returned from the current block become invalid.
+*
+* @param[in] ring is a receive ring created with tcs_packet_ring_rx_create().
 * @return #TCS_SUCCESS if successful, otherwise the error code.
 */
-TcsResult tcs_opt_out_of_band_inline_get(TcsSocket socket, bool* out_is_oob_enabled);
+TcsResult tcs_packet_ring_rx_release(struct TcsPacketRing* ring);
 
 /**
-* @brief Set the socket priority.
+* @brief Create a memory mapped transmit ring (TPACKET_V2) on a packet socket.
 *
-* @note Not supported on Windows. Will return #TCS_ERROR_NOT_SUPPORTED on that platform.
+* Frames are written by the application directly into memory shared with the kernel. Fill as many frames as needed
+* with tcs_packet_ring_tx_acquire() and tcs_packet_ring_tx_commit(), then transmit all of them with a single
+* tcs_packet_ring_tx_flush().
 *
-* @param[in] socket socket to configure.
-* @param[in] priority priority value.
+* Add the socket to a TcsPoll with #TCS_POLL_WRITE to wait for a free frame.
+* A socket can only have one ring. The kernel fixes the ring version and the map offset per socket, so a receive ring
+* from tcs_packet_ring_rx_create() needs a separate packet socket.
+*
+* @code
+* TcsSocket socket = TCS_SOCKET_INVALID;
+* tcs_socket_packet_str(&socket, "eth0", 0x22F0, TCS_SOCKET_RAW);
+* tcs_opt_packet_qdisc_bypass_set(socket, true); // Optional
+* struct TcsPacketRing* ring = NULL;
+* tcs_packet_ring_tx_create(&ring, socket, 1 << 16, 16, 2048);
+* uint8_t* data = NULL;
+* size_t capacity = 0;
+* while (has_frames() && tcs_packet_ring_tx_acquire(ring, &data, &capacity) == TCS_SUCCESS)
+*     tcs_packet_ring_tx_commit(ring, write_frame(data, capacity));
+* tcs_packet_ring_tx_flush(ring, NULL);
+* tcs_packet_ring_destroy(&ring);
+* tcs_close(&socket);
+* @endcode
+*
+* @note Only supported on Linux. Will return #TCS_ERROR_NOT_SUPPORTED on other platforms.
+*
+* @param[out] out_ring is your out ring pointer. Initiate a TcsPacketRing pointer to NULL and use the address of this pointer.
+* @param[in] socket is a packet socket, see tcs_socket_packet(). The ring does not take ownership of the socket.
+* @param[in] block_size is the byte size of each block. Must be a multiple of the page size.
+* @param[in] block_count is the number of blocks in the ring.
+* @param[in] frame_size is the byte size of each frame including the 32 byte ring header. Must be a multiple of 16.
 * @return #TCS_SUCCESS if successful, otherwise the error code.
+* @retval #TCS_ERROR_INVALID_ARGUMENT if the socket already has a receive or transmit ring.
+* @see tcs_packet_ring_destroy()
 */
-TcsResult tcs_opt_priority_set(TcsSocket socket, int priority);
+TcsResult tcs_packet_ring_tx_create(struct TcsPacketRing** out_ring,
+                                    TcsSocket socket,
+                                    size_t block_size,
+                                    size_t block_count,
+                                    size_t frame_size);
 
 /**
-* @brief Query the socket priority.
+* @brief Get the next free frame of a transmit ring.
 *
-* @note Not supported on Windows. Will return #TCS_ERROR_NOT_SUPPORTED on that platform.
+* The same frame is returned until it is committed with tcs_packet_ring_tx_commit().
+* For #TCS_SOCKET_RAW sockets the frame starts with the link layer header, for #TCS_SOCKET_DGRAM it is the payload.
 *
-* @param[in] socket socket to query.
-* @param[out] out_priority pointer to receive the priority value.
-* @return #TCS_SUCCESS if successful, otherwise the error code.
+* @param[in] ring is a transmit ring created with tcs_packet_ring_tx_create().
+* @param[out] out_data will point to the frame inside the ring.
+* @param[out] out_capacity is the maximum number of bytes that can be written to @p out_data.
+* @return #TCS_SUCCESS if a frame was returned, otherwise the error code.
+* @retval #TCS_ERROR_WOULD_BLOCK if all frames are queued for transmission. Flush or wait with TcsPoll.
 */
-TcsResult tcs_opt_priority_get(TcsSocket socket, int* out_priority);
+TcsResult tcs_packet_ring_tx_acquire(struct TcsPacketRing* ring, uint8_t** out_data, size_t* out_capacity);
 
 /**
-* @brief Join a multicast group on a specific local interface.
+* @brief Queue the frame returned by tcs_packet_ring_tx_acquire() for transmission.
 *
-* @param[in] socket socket to configure.
-* @param[in] local_address local interface address to use.
-* @param[in] multicast_address multicast group address to join.
+* Nothing is sent until tcs_packet_ring_tx_flush() is called.
+*
+* @param[in] ring is a transmit ring created with tcs_packet_ring_tx_create().
+* @param[in] frame_size is the number of bytes written to the frame.
 * @return #TCS_SUCCESS if successful, otherwise the error code.
-* @retval #TCS_ERROR_NOT_SUPPORTED if either address has an address family not supported on this platform.
+* @retval #TCS_ERROR_INVALID_ARGUMENT if no frame was acquired since the last commit.
 */
-TcsResult tcs_opt_membership_add_to(TcsSocket socket,
-                                    const struct TcsAddress* local_address,
-                                    const struct TcsAddress* multicast_address);
+TcsResult tcs_packet_ring_tx_commit(struct TcsPacketRing* ring, size_t frame_size);
 
 /**
-* @brief Leave a multicast group on a specific local interface.
+* @brief Transmit all committed frames with one syscall.
 *
-* @param[in] socket socket to configure.
-* @param[in] local_address local interface address used when joining.
-* @param[in] multicast_address multicast group address to leave.
+* Blocks until the frames are handed to the device unless the socket is non-blocking.
+*
+* @param[in] ring is a transmit ring created with tcs_packet_ring_tx_create().
+* @param[in] destination_address is the link layer destination, required for #TCS_SOCKET_DGRAM sockets. Use NULL for
+*            #TCS_SOCKET_RAW sockets to send on the interface the socket is bound to.
 * @return #TCS_SUCCESS if successful, otherwise the error code.
-* @retval #TCS_ERROR_NOT_SUPPORTED if either address has an address family not supported on this platform.
 */
-TcsResult tcs_opt_membership_drop_from(TcsSocket socket,
-                                       const struct TcsAddress* local_address,
-                                       const struct TcsAddress* multicast_address);
+TcsResult tcs_packet_ring_tx_flush(struct TcsPacketRing* ring, const struct TcsAddress* destination_address);
 
 /**
-* @brief Join a multicast group using the default local interface.
+* @brief Initialize a filter that accepts everything.
 *
-* @param[in] socket socket to configure.
-* @param[in] multicast_address multicast group address to join.
+* Add predicates with the tcs_filter_*() functions and attach it with tcs_opt_filter_attach().
+* The predicates only build instructions and work on every platform, attaching is only supported on Linux.
+*
+* @code
+* struct TcsFilter filter;
+* tcs_filter_init(&filter);
+* tcs_filter_ether_type(&filter, 0x0800);
+* tcs_filter_udp_destination_port(&filter, 5000);
+* tcs_opt_filter_attach(socket, &filter);
+* @endcode
+*
+* @param[out] filter is the filter to initialize.
 * @return #TCS_SUCCESS if successful, otherwise the error code.
-* @retval #TCS_ERROR_NOT_SUPPORTED if multicast_address has an address family not supported on this platform.
 */
-TcsResult tcs_opt_membership_add(TcsSocket socket, const struct TcsAddress* multicast_address);
+TcsResult tcs_filter_init(struct TcsFilter* filter);
 
 /**
-* @brief Join a multicast group by address string.
+* @brief Only accept frames with this EtherType.
 *
-* Resolves the multicast address string and joins the group using the default local interface.
+* Matches the protocol after any VLAN tag, e.g. 0x0800 for IPv4 or 0x22F0 for AVTP.
 *
-* @param[in] socket socket to configure.
-* @param[in] multicast_address multicast group address string (e.g. "239.1.2.3" or "ff02::1").
+* @param[in,out] filter is an initialized filter.
+* @param[in] ether_type is the EtherType in host byte order.
 * @return #TCS_SUCCESS if successful, otherwise the error code.
-* @retval #TCS_ERROR_INVALID_ARGUMENT if multicast_address is NULL.
-* @retval #TCS_ERROR_ADDRESS_LOOKUP_FAILED if the address string could not be resolved.
-* @see tcs_opt_membership_add()
-* @see tcs_opt_membership_drop_str()
+* @retval #TCS_ERROR_MEMORY if the filter has no room left, see TCS_CFG_FILTER_MAX_INSTRUCTIONS.
 */
-TcsResult tcs_opt_membership_add_str(TcsSocket socket, const char* multicast_address);
+TcsResult tcs_filter_ether_type(struct TcsFilter* filter, uint16_t ether_type);
 
 /**
-* @brief Leave a multicast group using the default local interface.
+* @brief Only accept frames with a VLAN tag with this VLAN id.
 *
-* @param[in] socket socket to configure.
-* @param[in] multicast_address multicast group address to leave.
+* @param[in,out] filter is an initialized filter.
+* @param[in] vlan_id is the 12 bit VLAN id.
 * @return #TCS_SUCCESS if successful, otherwise the error code.
-* @retval #TCS_ERROR_NOT_SUPPORTED if multicast_address has an address family not supported on this platform.
+* @retval #TCS_ERROR_MEMORY if the filter has no room left, see TCS_CFG_FILTER_MAX_INSTRUCTIONS.
 */
-TcsResult tcs_opt_membership_drop(TcsSocket socket, const struct TcsAddress* multicast_address);
+TcsResult tcs_filter_vlan_id(struct TcsFilter* filter, uint16_t vlan_id);
 
 /**
-* @brief Leave a multicast group by address string.
+* @brief Only accept UDP datagrams over IPv4 or IPv6 to this destination port.
 *
-* Parses the multicast address string and leaves the group using the default local interface.
+* IPv4 fragments after the first one are dropped. IPv6 datagrams with extension headers are not matched.
 *
-* @param[in] socket socket to configure.
-* @param[in] multicast_address multicast group address string (e.g. "239.1.2.3" or "ff02::1").
+* @param[in,out] filter is an initialized filter.
+* @param[in] port is the UDP destination port.
 * @return #TCS_SUCCESS if successful, otherwise the error code.
-* @retval #TCS_ERROR_INVALID_ARGUMENT if multicast_address is NULL.
-* @retval #TCS_ERROR_ADDRESS_LOOKUP_FAILED if the address string could not be resolved.
-* @see tcs_opt_membership_drop()
-* @see tcs_opt_membership_add_str()
+* @retval #TCS_ERROR_MEMORY if the filter has no room left, see TCS_CFG_FILTER_MAX_INSTRUCTIONS.
 */
-TcsResult tcs_opt_membership_drop_str(TcsSocket socket, const char* multicast_address);
+TcsResult tcs_filter_udp_destination_port(struct TcsFilter* filter, uint16_t port);
 
 /**
-* @brief Set the outgoing interface for multicast packets.
+* @brief Only accept frames sent to this multicast group.
 *
-* @param[in] socket socket to configure.
-* @param[in] local_address local interface address to use for outgoing multicast.
+* Compares the IPv4 or IPv6 destination address, or the destination MAC address for #TCS_FAMILY_PACKET.
+* Useful on sockets bound to a wildcard address that have joined several groups.
+*
+* @param[in,out] filter is an initialized filter.
+* @param[in] multicast_address is an IPv4, IPv6 or MAC multicast address. The port is ignored.
 * @return #TCS_SUCCESS if successful, otherwise the error code.
-* @retval #TCS_ERROR_NOT_SUPPORTED if local_address has an address family not supported on this platform.
+* @retval #TCS_ERROR_MEMORY if the filter has no room left, see TCS_CFG_FILTER_MAX_INSTRUCTIONS.
 */
-TcsResult tcs_opt_multicast_interface_set(TcsSocket socket, const struct TcsAddress* local_address);
+TcsResult tcs_filter_multicast_group(struct TcsFilter* filter, const struct TcsAddress* multicast_address);
 
 /**
-* @brief Enable or disable multicast loopback.
-*
-* When enabled, multicast packets sent on this socket are looped back and
-* delivered to local receivers on the same host.
+* @brief Set parameters on a socket. It is recommended to use tcs_opt_*_set() instead.
 *
-* @param[in] socket socket to configure.
-* @param[in] do_loopback set to true to enable loopback, false to disable.
+* @param[in] socket is your in-out socket context.
+* @param[in] level is the definition level.
+* @param[in] option_name is the option name.
+* @param[in] option_value is a pointer to the option value.
+* @param[in] option_size is the byte size of the data pointed by @p option_value.
 * @return #TCS_SUCCESS if successful, otherwise the error code.
 */
-TcsResult tcs_opt_multicast_loop_set(TcsSocket socket, bool do_loopback);
+TcsResult tcs_opt_set(TcsSocket socket,
+                      int32_t level,
+                      int32_t option_name,
+                      const void* option_value,
+                      size_t option_size);
 
 /**
-* @brief Get the current multicast loopback setting.
+* @brief Get parameters on a socket. It is recommended to use tcs_opt_*_get() instead.
 *
-* @param[in] socket socket to query.
-* @param[out] out_is_loopback pointer to receive the current setting.
+* @code
+* uint8_t c;
+* size_t a = sizeof(c);
+* tcs_opt_get(socket, TCS_SOL_IP, TCS_IP_MULTICAST_LOOP, &c, &a);
+* @endcode
+*
+* @param[in] socket is your in-out socket context.
+* @param[in] level is the definition level.
+* @param[in] option_name is the option name.
+* @param[out] out_option_value is a pointer to receive the option value.
+* @param[in,out] option_size is a pointer the byte size of the data pointed by @p out_option_value.
 * @return #TCS_SUCCESS if successful, otherwise the error code.
 */
-TcsResult tcs_opt_multicast_loop_get(TcsSocket socket, bool* out_is_loopback);
+TcsResult tcs_opt_get(TcsSocket socket,
+                      int32_t level,
+                      int32_t option_name,
+                      void* out_option_value,
+                      size_t* option_size);
 
 /**
-* @brief Set a socket to non-blocking or blocking mode.
+* @brief Query the socket type (e.g. ::TCS_SOCKET_STREAM or ::TCS_SOCKET_DGRAM).
 *
-* @param[in] socket socket to configure.
-* @param[in] do_nonblocking set to true for non-blocking, false for blocking.
+* @param[in] socket socket to query.
+* @param[out] out_type pointer to receive the socket type.
 * @return #TCS_SUCCESS if successful, otherwise the error code.
 */
-TcsResult tcs_opt_nonblocking_set(TcsSocket socket, bool do_nonblocking);
+TcsResult tcs_opt_type_get(TcsSocket socket, TcsSocketType* out_type);
 
 /**
-* @brief Query the non-blocking state of a socket.
+* @brief Enable the socket to be allowed to send to broadcast addresses.
 *
-* @note Not supported on Windows. Will return #TCS_ERROR_NOT_SUPPORTED on that platform.
+* By default, sockets are not permitted to send to broadcast addresses (e.g.
+* 255.255.255.255 or subnet broadcast addresses) as a safety measure to prevent
+* accidental broadcast storms. Enable this option on UDP sockets that need to
+* send broadcast traffic.
+*
+* Only valid for protocols that support broadcast, for example UDP. Default is false.
+*
+* @param[in] socket socket to enable/disable permission to send broadcast on.
+* @param[in] do_allow_broadcast set to true to allow, false to forbid.
+* @return #TCS_SUCCESS if successful, otherwise the error code.
 */
-TcsResult tcs_opt_nonblocking_get(TcsSocket socket, bool* out_is_nonblocking);
+TcsResult tcs_opt_broadcast_set(TcsSocket socket, bool do_allow_broadcast);
 
 /**
-* @brief List available network interfaces.
+* @brief Query whether broadcast is enabled on a socket.
 *
-* @param[out] out_interfaces array to receive interface information, or NULL to only count.
-* @param[in] interfaces_length number of elements in the @p out_interfaces array.
-* @param[out] out_length pointer to receive the total number of interfaces available, which may exceed @p interfaces_length.
+* See tcs_opt_broadcast_set() for details on the broadcast option.
+*
+* @param[in] socket socket to query.
+* @param[out] out_is_broadcast_allowed pointer to receive the current broadcast setting.
 * @return #TCS_SUCCESS if successful, otherwise the error code.
 */
-TcsResult tcs_interface_list(struct TcsInterface out_interfaces[], size_t interfaces_length, size_t* out_length);
+TcsResult tcs_opt_broadcast_get(TcsSocket socket, bool* out_is_broadcast_allowed);
 
 /**
-* @brief Resolve a hostname to one or more addresses.
+* @brief Enable or disable TCP keep-alive on a socket.
 *
-* @param[in] hostname hostname or IP string to resolve.
-* @param[in] address_family address family filter, or ::TCS_FAMILY_ANY for all.
-* @param[out] out_addresses array to receive resolved addresses, or NULL to only count.
-* @param[in] addresses_length number of elements in the @p out_addresses array.
-* @param[out] out_length pointer to receive the number of addresses found.
+* Keep-alive operates at the transport layer (TCP). When enabled, the OS periodically
+* sends probe packets on an idle connection to detect if the remote peer is still
+* reachable. Without keep-alive, a connection where neither side sends data can remain
+* open indefinitely even if the remote host has crashed or the network path is broken.
+*
+* Keep-alive probes also prevent NAT routers and stateful firewalls from dropping
+* idle connection mappings due to inactivity timeouts.
+*
+* This is particularly useful for long-lived connections that may be idle for extended
+* periods, such as database connections or control channels.
+*
+* @param[in] socket socket to configure.
+* @param[in] do_keep_alive set to true to enable, false to disable.
 * @return #TCS_SUCCESS if successful, otherwise the error code.
-* @retval #TCS_ERROR_NOT_SUPPORTED if @p address_family is not supported on this platform (e.g. ::TCS_FAMILY_PACKET on non-Linux).
 */
-TcsResult tcs_address_resolve(const char* hostname,
-                              TcsFamily address_family,
-                              struct TcsAddress out_addresses[],
-                              size_t addresses_length,
-                              size_t* out_length);
+TcsResult tcs_opt_keep_alive_set(TcsSocket socket, bool do_keep_alive);
 
 /**
-* @brief List addresses associated with network interfaces.
+* @brief Query whether keep-alive is enabled on a socket.
 *
-* @param[in] interface_id_filter interface ID to filter by, or 0 for all interfaces.
-* @param[in] address_family_filter address family filter, or ::TCS_FAMILY_ANY for all.
-* @param[out] out_interface_addresses array to receive results, or NULL to only count.
-* @param[in] interface_addresses_length number of elements in the @p out_interface_addresses array.
-* @param[out] out_length pointer to receive the total number of results available, which may exceed @p interface_addresses_length.
+* See tcs_opt_keep_alive_set() for details on what keep-alive does.
+*
+* @param[in] socket socket to query.
+* @param[out] out_is_keep_alive_enabled pointer to receive the current keep-alive setting.
 * @return #TCS_SUCCESS if successful, otherwise the error code.
-* @note If @p address_family_filter is not supported on this platform (e.g. ::TCS_FAMILY_PACKET on non-Linux), no entries match and *out_length is 0.
 */
-TcsResult tcs_address_list(TcsInterfaceId interface_id_filter,
-                           TcsFamily address_family_filter,
-                           struct TcsInterfaceAddress out_interface_addresses[],
-                           size_t interface_addresses_length,
-                           size_t* out_length);
+TcsResult tcs_opt_keep_alive_get(TcsSocket socket, bool* out_is_keep_alive_enabled);
 
 /**
-* @brief Get the local address of a bound or connected socket.
+* @brief Allow or disallow address reuse on a socket.
 *
-* @param[in] socket socket to query.
-* @param[out] out_local_address pointer to receive the local address.
+* **TCP:**
+* Allows binding to a port that is in the TIME_WAIT state. When a TCP connection
+* is closed, the port remains reserved for up to 2 minutes (2x Maximum Segment
+* Lifetime) to ensure delayed packets from the old connection are not misinterpreted
+* by a new one. This option bypasses that restriction, which is useful for server
+* sockets that need to restart quickly.
+* On POSIX, it also allows overlapping wildcard and specific address binds on the same
+* port (e.g. both 0.0.0.0:8080 and 192.168.1.1:8080). The most specific address wins.
+*
+* **UDP:**
+* Allows multiple sockets to bind to the same address and port. The behavior for
+* unicast datagrams is OS-specific, but on most implementations only the most
+* recently bound socket receives them.
+* This is primarily useful for multicast, where several sockets need to receive the
+* same group traffic.
+*
+* For load-balancing multiple sockets on the same port, see ::tcs_opt_reuse_port_set().
+*
+* @note On Windows, this library sets SO_EXCLUSIVEADDRUSE alongside SO_REUSEADDR
+* for TCP sockets to prevent port hijacking, matching the security guarantees of
+* POSIX. For UDP sockets, only SO_REUSEADDR is set, preserving multicast and
+* same-port binding behavior. I.e. it mimics POSIX behaviour.
+*
+* @param[in] socket socket to configure.
+* @param[in] do_allow_reuse_address set to true to allow, false to disallow.
 * @return #TCS_SUCCESS if successful, otherwise the error code.
 */
-TcsResult tcs_address_socket_local(TcsSocket socket, struct TcsAddress* out_local_address);
+TcsResult tcs_opt_reuse_address_set(TcsSocket socket, bool do_allow_reuse_address);
 
 /**
-* @brief Get the remote address of a connected socket.
+* @brief Query whether address reuse is enabled on a socket.
+*
+* See tcs_opt_reuse_address_set() for details on the address reuse option.
 *
 * @param[in] socket socket to query.
-* @param[out] out_remote_address pointer to receive the remote address.
+* @param[out] out_is_reuse_address_allowed pointer to receive the current setting.
 * @return #TCS_SUCCESS if successful, otherwise the error code.
 */
-TcsResult tcs_address_socket_remote(TcsSocket socket, struct TcsAddress* out_remote_address);
+TcsResult tcs_opt_reuse_address_get(TcsSocket socket, bool* out_is_reuse_address_allowed);
 
 /**
-* @brief Get the address family of a socket.
+* @brief Allow or disallow multiple sockets to bind to the same address and port.
+*
+* When enabled, the kernel distributes incoming traffic across all sockets bound to
+* the same address and port. All participating sockets must set this option, and on
+* POSIX systems they must belong to the same effective UID.
+*
+* This is useful for multi-threaded or multi-process servers that want to load-balance
+* incoming connections or datagrams across workers without application-level dispatching.
+*
+* @note Only supported on POSIX (Linux 3.9+). Returns #TCS_ERROR_NOT_SUPPORTED on Windows,
+* which has no equivalent with the same semantics.
+*
+* @param[in] socket socket to configure.
+* @param[in] do_allow_reuse_port set to true to allow, false to disallow.
+* @return #TCS_SUCCESS if successful, otherwise the error code.
+*/
+TcsResult tcs_opt_reuse_port_set(TcsSocket socket, bool do_allow_reuse_port);
+
+/**
+* @brief Query whether port reuse is enabled on a socket.
+*
+* See tcs_opt_reuse_port_set() for details.
+*
+* @note Returns #TCS_ERROR_NOT_SUPPORTED on Windows.
 *
 * @param[in] socket socket to query.
-* @param[out] out_family pointer to receive the address family.
+* @param[out] out_is_reuse_port_allowed pointer to receive the current setting.
 * @return #TCS_SUCCESS if successful, otherwise the error code.
 */
-TcsResult tcs_address_socket_family(TcsSocket socket, TcsFamily* out_family);
+TcsResult tcs_opt_reuse_port_get(TcsSocket socket, bool* out_is_reuse_port_allowed);
 
 /**
- * @brief Parse a network address from a string.
- *
- * Supports IPv4, IPv6 (RFC 4291 all three forms), MAC, and bracket/port notation (RFC 3986).
- * IPv6 zone IDs are limited to numeric values per the minimum requirement of RFC 4007.
- * String-based zone IDs (e.g. "%%eth0") are not supported.
- *
- * Examples:
- * @verbatim
- * 192.168.0.1:1212
- * ::1
- * [::1]:443
- * fe80::1%3
- * ::ffff:192.168.1.1
- * 91:E0:F0:00:FE:00
- * @endverbatim
- *
- * Note that this function will not perform DNS resolution. Use ::tcs_address_resolve() for that.
- *
- * @param[in] str The string to parse.
- * @param[out] out_address The parsed address.
- * @return #TCS_SUCCESS if successful, otherwise the error code.
- */
-TcsResult tcs_address_parse(const char str[], struct TcsAddress* out_address);
+* @brief Pick the socket of a SO_REUSEPORT group by the CPU that received the packet instead of by flow hash.
+*
+* Attaches a SO_ATTACH_REUSEPORT_CBPF program selecting socket number (CPU % @p group_size), where sockets are
+* numbered in the order they joined the group (bind for UDP, listen for TCP). The program applies to the whole group,
+* attach it to any member once all members have joined. See tcs_socket_per_cpu() for a helper creating the group.
+*
+* @note Only supported on Linux 4.5+. Will return #TCS_ERROR_NOT_SUPPORTED on other platforms.
+*
+* @param[in] socket is a bound member of the group.
+* @param[in] group_size is the number of sockets in the group.
+* @return #TCS_SUCCESS if successful, otherwise the error code.
+*/
+TcsResult tcs_opt_reuse_port_steer_by_cpu(TcsSocket socket, size_t group_size);
 
 /**
- * @brief Convert an address to a string.
- *
- * This will make a verbose string representation of the address.
- * Pass @c out_str=NULL and @c str_length=0 with @c out_length set to query the required size.
- *
- * @param[in] address the address to convert.
- * @param[out] out_str buffer to receive the null-terminated string representation.
- * @param[in] str_length capacity of @c out_str in bytes. A buffer of 70 bytes is always sufficient for any supported address family.
- * @param[out] out_length receives the length of the written string excluding the null terminator. May be NULL.
- * @return #TCS_SUCCESS if successful, #TCS_ERROR_MEMORY if @c out_str is too small, otherwise the error code.
- */
-TcsResult tcs_address_to_str(const struct TcsAddress* address, char out_str[], size_t str_length, size_t* out_length);
+* @brief Set the send buffer size of a socket.
+*
+* @param[in] socket socket to configure.
+* @param[in] send_buffer_size desired send buffer size in bytes.
+* @return #TCS_SUCCESS if successful, otherwise the error code.
+*/
+TcsResult tcs_opt_send_buffer_size_set(TcsSocket socket, size_t send_buffer_size);
 
-/** @brief Check if two addresses are equal. Returns false for NULL, mismatched, unknown, or unsupported address families. */
-bool tcs_address_is_equal(const struct TcsAddress* l, const struct TcsAddress* r);
+/**
+* @brief Query the send buffer size of a socket.
+*
+* @param[in] socket socket to query.
+* @param[out] out_send_buffer_size pointer to receive the send buffer size in bytes.
+* @return #TCS_SUCCESS if successful, otherwise the error code.
+*/
+TcsResult tcs_opt_send_buffer_size_get(TcsSocket socket, size_t* out_send_buffer_size);
 
-/** @brief Check if the address is a wildcard (any) address. Returns false for NULL, unknown, or unsupported address families. */
-bool tcs_address_is_any(const struct TcsAddress* addr);
+/**
+* @brief Set the receive buffer size of a socket.
+*
+* @param[in] socket socket to configure.
+* @param[in] receive_buffer_size desired receive buffer size in bytes.
+* @return #TCS_SUCCESS if successful, otherwise the error code.
+*/
+TcsResult tcs_opt_receive_buffer_size_set(TcsSocket socket, size_t receive_buffer_size);
 
-/** @brief Check if the address is a link-local address. Returns false for NULL, unknown, or unsupported address families. */
-bool tcs_address_is_link_local(const struct TcsAddress* addr);
+/**
+* @brief Query the receive buffer size of a socket.
+*
+* @param[in] socket socket to query.
+* @param[out] out_receive_buffer_size pointer to receive the receive buffer size in bytes.
+* @return #TCS_SUCCESS if successful, otherwise the error code.
+*/
+TcsResult tcs_opt_receive_buffer_size_get(TcsSocket socket, size_t* out_receive_buffer_size);
 
-/** @brief Check if the address is a loopback address. Returns false for NULL, unknown, or unsupported address families. */
-bool tcs_address_is_loopback(const struct TcsAddress* addr);
+/**
+* @brief Set the receive timeout of a socket.
+*
+* @param[in] socket socket to configure.
+* @param[in] timeout_ms timeout in milliseconds. Must be non-negative.
+* @return #TCS_SUCCESS if successful, otherwise the error code.
+*/
+TcsResult tcs_opt_receive_timeout_set(TcsSocket socket, int timeout_ms);
 
-/** @brief Check if the address is a multicast address. Returns false for NULL, unknown, or unsupported address families. */
-bool tcs_address_is_multicast(const struct TcsAddress* addr);
+/**
+* @brief Query the receive timeout of a socket.
+*
+* @param[in] socket socket to query.
+* @param[out] out_timeout_ms pointer to receive the timeout in milliseconds.
+* @return #TCS_SUCCESS if successful, otherwise the error code.
+*/
+TcsResult tcs_opt_receive_timeout_get(TcsSocket socket, int* out_timeout_ms);
 
-/** @brief Check if the address is a broadcast address. Returns false for NULL, unknown, or unsupported address families. */
-bool tcs_address_is_broadcast(const struct TcsAddress* addr);
+/**
+* @brief Configure the linger behavior of a socket on close.
+*
+* @param[in] socket socket to configure.
+* @param[in] do_linger set to true to enable lingering, false to disable.
+* @param[in] timeout_seconds linger timeout in seconds (only used when do_linger is true).
+* @return #TCS_SUCCESS if successful, otherwise the error code.
+*/
+TcsResult tcs_opt_linger_set(TcsSocket socket, bool do_linger, int timeout_seconds);
 
-/** @brief Check if the address family is known and supported by this platform. Returns false for NULL or unknown families. */
-bool tcs_address_is_supported(const struct TcsAddress* addr);
+/**
+* @brief Query the linger behavior of a socket.
+*
+* @param[in] socket socket to query.
+* @param[out] out_do_linger pointer to receive whether lingering is enabled.
+* @param[out] out_timeout_seconds pointer to receive the linger timeout in seconds.
+* @return #TCS_SUCCESS if successful, otherwise the error code.
+*/
+TcsResult tcs_opt_linger_get(TcsSocket socket, bool* out_do_linger, int* out_timeout_seconds);
 
-#ifdef __cplusplus
-}
-#endif
+/**
+* @brief Enable or disable Nagle's algorithm (TCP_NODELAY).
+*
+* @param[in] socket socket to configure.
+* @param[in] use_no_delay set to true to disable Nagle's algorithm (lower latency), false to enable it.
+* @return #TCS_SUCCESS if successful, otherwise the error code.
+*/
+TcsResult tcs_opt_ip_no_delay_set(TcsSocket socket, bool use_no_delay);
 
-#endif
+/**
+* @brief Query whether Nagle's algorithm is disabled on a socket.
+*
+* @param[in] socket socket to query.
+* @param[out] out_is_no_delay_used pointer to receive the current setting.
+* @return #TCS_SUCCESS if successful, otherwise the error code.
+*/
+TcsResult tcs_opt_ip_no_delay_get(TcsSocket socket, bool* out_is_no_delay_used);
 
-#ifdef TINYCSOCKET_IMPLEMENTATION
-/**********************************/
-/****** tinydatastructures.h ******/
-/**********************************/
-#ifndef TINYDATASTRUCTURES_H_
-#define TINYDATASTRUCTURES_H_
+/**
+* @brief Accept TCP Fast Open (TFO) connections on a listener, data in the SYN is delivered without waiting for the
+* handshake to complete.
+*
+* Call before tcs_listen(). Falls back silently to normal handshakes where TFO is unavailable, in that case
+* tcs_opt_tcp_fast_open_get() reports 0. On Linux the server side must also be enabled in net.ipv4.tcp_fastopen.
+*
+* @param[in] socket TCP socket that will listen.
+* @param[in] queue_length maximum number of pending TFO requests, 0 to disable.
+* @return #TCS_SUCCESS if successful or if TFO is unavailable, otherwise the error code.
+* @see tcs_opt_tcp_fast_open_connect_set()
+*/
+TcsResult tcs_opt_tcp_fast_open_set(TcsSocket socket, int queue_length);
 
-#include <stdlib.h>
-#include <string.h>
+/**
+* @brief Query the TCP Fast Open queue length of a listener.
+*
+* @param[in] socket socket to query.
+* @param[out] out_queue_length pointer to receive the queue length, 0 if TFO is disabled or unavailable.
+* @return #TCS_SUCCESS if successful, otherwise the error code.
+*/
+TcsResult tcs_opt_tcp_fast_open_get(TcsSocket socket, int* out_queue_length);
 
-#ifdef _MSC_VER
-#define TDS_UNUSED
-#else
-#define TDS_UNUSED __attribute__((unused))
-#endif
+/**
+* @brief Send the first data with the SYN using TCP Fast Open (TFO) on a client socket.
+*
+* Call before tcs_connect(). tcs_connect() then returns immediately and the handshake starts with the first
+* tcs_send(), carrying its data in the SYN when the server has handed out a TFO cookie earlier. The first connection
+* to a server uses a normal handshake to get the cookie. Falls back silently to normal handshakes where TFO is
+* unavailable, in that case tcs_opt_tcp_fast_open_connect_get() reports false.
+*
+* @code
+* TcsSocket socket = TCS_SOCKET_INVALID;
+* tcs_socket(&socket, TCS_FAMILY_IPV4, TCS_SOCKET_STREAM, TCS_PROTOCOL_IP_TCP);
+* tcs_opt_tcp_fast_open_connect_set(socket, true);
+* tcs_connect(socket, &server_address);
+* tcs_send(socket, request, request_size, TCS_FLAG_NONE, NULL); // Goes out with the SYN
+* @endcode
+*
+* @note Uses TCP_FASTOPEN_CONNECT, Linux 4.11+.
+*
+* @param[in] socket TCP socket that is not yet connected.
+* @param[in] do_fast_open set to true to enable, false to disable.
+* @return #TCS_SUCCESS if successful or if TFO is unavailable, otherwise the error code.
+* @see tcs_opt_tcp_fast_open_set()
+*/
+TcsResult tcs_opt_tcp_fast_open_connect_set(TcsSocket socket, bool do_fast_open);
 
-static inline int tds_ulist_create(void** data, size_t* count, size_t* capacity, size_t element_size);
-static inline int tds_ulist_destroy(void** data, size_t* count, size_t* capacity);
-static inline int tds_ulist_reserve(void** data, size_t* capacity, size_t element_size, size_t requested_capacity);
-static inline int tds_ulist_add(void** data,
-                                size_t* count,
-                                size_t* capacity,
-                                size_t element_size,
-                                void* add_data,
-                                size_t add_count);
-static inline int tds_ulist_remove(void** data,
-                                   size_t* count,
-                                   size_t* capacity,
-                                   size_t element_size,
-                                   size_t remove_from,
-                                   size_t remove_count);
+/**
+* @brief Query if a client socket uses TCP Fast Open.
+*
+* @param[in] socket socket to query.
+* @param[out] out_is_fast_open pointer to receive the current setting, false if TFO is unavailable.
+* @return #TCS_SUCCESS if successful, otherwise the error code.
+*/
+TcsResult tcs_opt_tcp_fast_open_connect_get(TcsSocket socket, bool* out_is_fast_open);
 
-static inline int tds_ulist_create(void** data, size_t* count, size_t* capacity, size_t element_size)
-{
-    *data = NULL;
-    *count = 0;
-    *capacity = 0;
-    if (element_size == 0)
-        return -1;
-    return tds_ulist_reserve(data, capacity, element_size, 1);
-}
+/**
+* @brief Enable or disable inline reception of out-of-band data.
+*
+* @param[in] socket socket to configure.
+* @param[in] enable_oob set to true to receive OOB data inline, false to disable.
+* @return #TCS_SUCCESS if successful, otherwise the error code.
+*/
+TcsResult tcs_opt_out_of_band_inline_set(TcsSocket socket, bool enable_oob);
 
-static inline int tds_ulist_destroy(void** data, size_t* count, size_t* capacity)
-{
-    if (*data != NULL)
-    {
-        free(*data);
-        *data = NULL;
-    }
-    *count = 0;
-    *capacity = 0;
-    return 0;
-}
+/**
+* @brief Query whether out-of-band data is received inline.
+*
+* @param[in] socket socket to query.
+* @param[out] out_is_oob_enabled pointer to receive the current setting.
+* @return #TCS_SUCCESS if successful, otherwise the error code.
+*/
+TcsResult tcs_opt_out_of_band_inline_get(TcsSocket socket, bool* out_is_oob_enabled);
 
-// TODO: move to reserve
-static inline size_t tds_ulist_best_capacity_fit(size_t old_capacity, size_t new_capacity)
-{
-    const size_t MINIMUM_CAPACITY = 8;
+/**
+* @brief Set the socket priority.
+*
+* @note Not supported on Windows. Will return #TCS_ERROR_NOT_SUPPORTED on that platform.
+*
+* @param[in] socket socket to configure.
+* @param[in] priority priority value.
+* @return #TCS_SUCCESS if successful, otherwise the error code.
+*/
+TcsResult tcs_opt_priority_set(TcsSocket socket, int priority);
 
-    size_t c = MINIMUM_CAPACITY;
-    while (c < new_capacity)
-        c *= 2;
+/**
+* @brief Query the socket priority.
+*
+* @note Not supported on Windows. Will return #TCS_ERROR_NOT_SUPPORTED on that platform.
+*
+* @param[in] socket socket to query.
+* @param[out] out_priority pointer to receive the priority value.
+* @return #TCS_SUCCESS if successful, otherwise the error code.
+*/
+TcsResult tcs_opt_priority_get(TcsSocket socket, int* out_priority);
 
-    // Hysteresis
-    if (c * 2 == old_capacity)
-        return old_capacity;
+/**
+* @brief Join a multicast group on a specific local interface.
+*
+* @param[in] socket socket to configure.
+* @param[in] local_address local interface address to use.
+* @param[in] multicast_address multicast group address to join.
+* @return #TCS_SUCCESS if successful, otherwise the error code.
+* @retval #TCS_ERROR_NOT_SUPPORTED if either address has an address family not supported on this platform.
+*/
+TcsResult tcs_opt_membership_add_to(TcsSocket socket,
+                                    const struct TcsAddress* local_address,
+                                    const struct TcsAddress* multicast_address);
 
-    return c;
-}
+/**
+* @brief Leave a multicast group on a specific local interface.
+*
+* @param[in] socket socket to configure.
+* @param[in] local_address local interface address used when joining.
+* @param[in] multicast_address multicast group address to leave.
+* @return #TCS_SUCCESS if successful, otherwise the error code.
+* @retval #TCS_ERROR_NOT_SUPPORTED if either address has an address family not supported on this platform.
+*/
+TcsResult tcs_opt_membership_drop_from(TcsSocket socket,
+                                       const struct TcsAddress* local_address,
+                                       const struct TcsAddress* multicast_address);
 
-static inline int tds_ulist_reserve(void** data, size_t* capacity, size_t element_size, size_t requested_capacity)
-{
-    size_t new_capacity = tds_ulist_best_capacity_fit(*capacity, requested_capacity);
-    if (new_capacity == *capacity)
-        return 0;
+/**
+* @brief Join a multicast group using the default local interface.
+*
+* @param[in] socket socket to configure.
+* @param[in] multicast_address multicast group address to join.
+* @return #TCS_SUCCESS if successful, otherwise the error code.
+* @retval #TCS_ERROR_NOT_SUPPORTED if multicast_address has an address family not supported on this platform.
+*/
+TcsResult tcs_opt_membership_add(TcsSocket socket, const struct TcsAddress* multicast_address);
 
-// UB protection for C23 and implemention defined protection before C23 (Should never happen)
-#ifndef NDEBUG
-    if (new_capacity == 0)
-        return -1;
-#endif
+/**
+* @brief Join a multicast group by address string.
+*
+* Resolves the multicast address string and joins the group using the default local interface.
+*
+* @param[in] socket socket to configure.
+* @param[in] multicast_address multicast group address string (e.g. "239.1.2.3" or "ff02::1").
+* @return #TCS_SUCCESS if successful, otherwise the error code.
+* @retval #TCS_ERROR_INVALID_ARGUMENT if multicast_address is NULL.
+* @retval #TCS_ERROR_ADDRESS_LOOKUP_FAILED if the address string could not be resolved.
+* @see tcs_opt_membership_add()
+* @see tcs_opt_membership_drop_str()
+*/
+TcsResult tcs_opt_membership_add_str(TcsSocket socket, const char* multicast_address);
 
-    void* new_data = realloc(*data, new_capacity * element_size);
-    if (new_data == NULL)
-        return -1;
+/**
+* @brief Leave a multicast group using the default local interface.
+*
+* @param[in] socket socket to configure.
+* @param[in] multicast_address multicast group address to leave.
+* @return #TCS_SUCCESS if successful, otherwise the error code.
+* @retval #TCS_ERROR_NOT_SUPPORTED if multicast_address has an address family not supported on this platform.
+*/
+TcsResult tcs_opt_membership_drop(TcsSocket socket, const struct TcsAddress* multicast_address);
 
-    if (new_capacity > *capacity)
-    {
-        memset((char*)new_data + *capacity * element_size, 0, (new_capacity - *capacity) * element_size);
-    }
-    *data = new_data;
-    *capacity = new_capacity;
-    return 0;
-}
+/**
+* @brief Leave a multicast group by address string.
+*
+* Parses the multicast address string and leaves the group using the default local interface.
+*
+* @param[in] socket socket to configure.
+* @param[in] multicast_address multicast group address string (e.g. "239.1.2.3" or "ff02::1").
+* @return #TCS_SUCCESS if successful, otherwise the error code.
+* @retval #TCS_ERROR_INVALID_ARGUMENT if multicast_address is NULL.
+* @retval #TCS_ERROR_ADDRESS_LOOKUP_FAILED if the address string could not be resolved.
+* @see tcs_opt_membership_drop()
+* @see tcs_opt_membership_add_str()
+*/
+TcsResult tcs_opt_membership_drop_str(TcsSocket socket, const char* multicast_address);
 
-static inline int tds_ulist_add(void** data,
-                                size_t* count,
-                                size_t* capacity,
-                                size_t element_size,
-                                void* add_data,
-                                size_t add_count)
-{
-    if (*count + add_count > *capacity)
-    {
-        int reserve_sts = tds_ulist_reserve(data, capacity, element_size, *count + add_count);
-        if (reserve_sts != 0)
-            return reserve_sts;
-    }
+/**
+* @brief Set the outgoing interface for multicast packets.
+*
+* @param[in] socket socket to configure.
+* @param[in] local_address local interface address to use for outgoing multicast.
+* @return #TCS_SUCCESS if successful, otherwise the error code.
+* @retval #TCS_ERROR_NOT_SUPPORTED if local_address has an address family not supported on this platform.
+*/
+TcsResult tcs_opt_multicast_interface_set(TcsSocket socket, const struct TcsAddress* local_address);
 
-    memcpy((char*)*data + (*count * element_size), add_data, add_count * element_size);
-    *count += add_count;
-    return 0;
-}
+/**
+* @brief Enable or disable multicast loopback.
+*
+* When enabled, multicast packets sent on this socket are looped back and
+* delivered to local receivers on the same host.
+*
+* @param[in] socket socket to configure.
+* @param[in] do_loopback set to true to enable loopback, false to disable.
+* @return #TCS_SUCCESS if successful, otherwise the error code.
+*/
+TcsResult tcs_opt_multicast_loop_set(TcsSocket socket, bool do_loopback);
 
-static inline int tds_ulist_remove(void** data,
-                                   size_t* count,
-                                   size_t* capacity,
-                                   size_t element_size,
-                                   size_t remove_from,
-                                   size_t remove_count)
-{
-    if (remove_from >= *count || remove_count == 0 || remove_from + remove_count > *count)
-        return -1;
+/**
+* @brief Get the current multicast loopback setting.
+*
+* @param[in] socket socket to query.
+* @param[out] out_is_loopback pointer to receive the current setting.
+* @return #TCS_SUCCESS if successful, otherwise the error code.
+*/
+TcsResult tcs_opt_multicast_loop_get(TcsSocket socket, bool* out_is_loopback);
 
-    void* dst = (char*)(*data) + (remove_from * element_size);
-    void* src = (char*)(*data) + (*count - remove_count) * element_size;
-    memmove(dst, src, element_size * remove_count);
-    *count -= remove_count;
+/**
+* @brief Set a socket to non-blocking or blocking mode.
+*
+* @param[in] socket socket to configure.
+* @param[in] do_nonblocking set to true for non-blocking, false for blocking.
+* @return #TCS_SUCCESS if successful, otherwise the error code.
+*/
+TcsResult tcs_opt_nonblocking_set(TcsSocket socket, bool do_nonblocking);
 
-    if (*count < *capacity / 2)
-    {
-        int reserve_sts = tds_ulist_reserve(data, capacity, element_size, *count);
-        if (reserve_sts != 0)
-            return reserve_sts;
-    }
+/**
+* @brief Query the non-blocking state of a socket.
+*
+* @note Not supported on Windows. Will return #TCS_ERROR_NOT_SUPPORTED on that platform.
+*/
+TcsResult tcs_opt_nonblocking_get(TcsSocket socket, bool* out_is_nonblocking);
 
-    return 0;
-}
+/**
+* @brief Enable or disable software transmit timestamps.
+*
+* Each packet sent after enabling gets a software timestamp queued on the socket error queue.
+* Read them with tcs_receive_tx_timestamps(). The id of each timestamp is a counter that restarts
+* at 0 every time timestamping is enabled.
+*
+* @note Only supported on Linux. Will return #TCS_ERROR_NOT_SUPPORTED on other platforms.
+*
+* @param[in] socket socket to configure.
+* @param[in] do_timestamp set to true to enable transmit timestamps, false to disable.
+* @return #TCS_SUCCESS if successful, otherwise the error code.
+* @see tcs_receive_tx_timestamps()
+*/
+TcsResult tcs_opt_tx_timestamping_set(TcsSocket socket, bool do_timestamp);
 
-#define TDS_ULIST_IMPL(TYPE, NAME)                                                                                     \
-    struct TdsUList_##NAME                                                                                             \
-    {                                                                                                                  \
-        TYPE* data;                                                                                                    \
-        size_t count;                                                                                                  \
-        size_t capacity;                                                                                               \
-    };                                                                                                                 \
-                                                                                                                       \
-    TDS_UNUSED static inline int tds_ulist_##NAME##_create(struct TdsUList_##NAME* ulist)                              \
-    {                                                                                                                  \
-        return tds_ulist_create((void**)&ulist->data, &ulist->count, &ulist->capacity, sizeof(TYPE));                  \
-    }                                                                                                                  \
-    TDS_UNUSED static inline int tds_ulist_##NAME##_destroy(struct TdsUList_##NAME* ulist)                             \
-    {                                                                                                                  \
-        int sts = tds_ulist_destroy((void**)&ulist->data, &ulist->count, &ulist->capacity);                            \
-        memset(ulist, 0, sizeof(*ulist));                                                                              \
-        return sts;                                                                                                    \
-    }                                                                                                                  \
-    TDS_UNUSED static inline int tds_ulist_##NAME##_add(struct TdsUList_##NAME* ulist, TYPE* data, size_t count)       \
-    {                                                                                                                  \
-        return tds_ulist_add((void**)&ulist->data, &ulist->count, &ulist->capacity, sizeof(TYPE), (void*)data, count); \
-    }                                                                                                                  \
-    TDS_UNUSED static inline int tds_ulist_##NAME##_remove(                                                            \
-        struct TdsUList_##NAME* ulist, size_t remove_from, size_t remove_count)                                        \
-    {                                                                                                                  \
-        return tds_ulist_remove(                                                                                       \
-            (void**)&ulist->data, &ulist->count, &ulist->capacity, sizeof(TYPE), remove_from, remove_count);           \
-    }                                                                                                                  \
-    TDS_UNUSED static inline int tds_ulist_##NAME##_reserve(struct TdsUList_##NAME* ulist, size_t new_capacity)        \
-    {                                                                                                                  \
-        return tds_ulist_reserve((void**)&ulist->data, &ulist->capacity, sizeof(TYPE), new_capacity);                  \
-    }
+/**
+* @brief Query if software transmit timestamps are enabled.
+*
+* @note Only supported on Linux. Will return #TCS_ERROR_NOT_SUPPORTED on other platforms.
+*
+* @param[in] socket socket to query.
+* @param[out] out_is_timestamping pointer to receive the current setting.
+* @return #TCS_SUCCESS if successful, otherwise the error code.
+*/
+TcsResult tcs_opt_tx_timestamping_get(TcsSocket socket, bool* out_is_timestamping);
 
-// Tiny Data Structures Map Implementation
+/**
+* @brief Enable or disable reception of destination address and interface for each datagram.
+*
+* Sets IP_PKTINFO on IPv4 sockets and IPV6_RECVPKTINFO on IPv6 sockets.
+*
+* @note Not supported on Windows. Will return #TCS_ERROR_NOT_SUPPORTED on that platform.
+*
+* @param[in] socket socket to configure.
+* @param[in] do_receive_packet_info set to true to enable, false to disable.
+* @return #TCS_SUCCESS if successful, otherwise the error code.
+* @see tcs_receive_from_to()
+*/
+TcsResult tcs_opt_packet_info_set(TcsSocket socket, bool do_receive_packet_info);
 
-static inline int tds_map_create(void** keys,
-                                 void** values,
-                                 size_t* count,
-                                 size_t* capacity,
-                                 size_t key_element_size,
-                                 size_t value_element_size)
-{
-    size_t key_capacity = 0;
-    size_t key_count = 0;
+/**
+* @brief Query if destination address and interface are received for each datagram.
+*
+* @note Not supported on Windows. Will return #TCS_ERROR_NOT_SUPPORTED on that platform.
+*
+* @param[in] socket socket to query.
+* @param[out] out_is_packet_info_received pointer to receive the current setting.
+* @return #TCS_SUCCESS if successful, otherwise the error code.
+*/
+TcsResult tcs_opt_packet_info_get(TcsSocket socket, bool* out_is_packet_info_received);
 
-    size_t value_capacity = 0;
-    size_t value_count = 0;
+/**
+* @brief Send frames from a packet socket directly to the device, skipping the traffic control (qdisc) layer.
+*
+* Gives the highest frame rate but frames are dropped instead of queued if the device queue is full, and they are
+* not seen by other packet sockets on the interface.
+*
+* @note Only supported on Linux. Will return #TCS_ERROR_NOT_SUPPORTED on other platforms.
+*
+* @param[in] socket packet socket to configure, see tcs_socket_packet().
+* @param[in] do_bypass set to true to bypass the qdisc layer, false to use it.
+* @return #TCS_SUCCESS if successful, otherwise the error code.
+* @see tcs_packet_ring_tx_create()
+*/
+TcsResult tcs_opt_packet_qdisc_bypass_set(TcsSocket socket, bool do_bypass);
 
-    int key_sts = tds_ulist_create(keys, &key_count, &key_capacity, key_element_size);
-    int value_sts = tds_ulist_create(values, &value_count, &value_capacity, value_element_size);
+/**
+* @brief Query if a packet socket bypasses the qdisc layer.
+*
+* @note Only supported on Linux. Will return #TCS_ERROR_NOT_SUPPORTED on other platforms.
+*
+* @param[in] socket packet socket to query.
+* @param[out] out_is_bypassed pointer to receive the current setting.
+* @return #TCS_SUCCESS if successful, otherwise the error code.
+*/
+TcsResult tcs_opt_packet_qdisc_bypass_get(TcsSocket socket, bool* out_is_bypassed);
 
-    if (key_sts != 0 || value_sts != 0)
-    {
-        tds_ulist_destroy(keys, &key_count, &key_capacity);
-        tds_ulist_destroy(values, &value_count, &value_capacity);
-        if (key_sts != 0)
-            return key_sts;
-        if (value_sts != 0)
-            return value_sts;
-    }
-    if (key_capacity != value_capacity)
-    {
-        tds_ulist_destroy(keys, &key_count, &key_capacity);
-        tds_ulist_destroy(values, &value_count, &value_capacity);
-        return -1;
-    }
-    *capacity = key_capacity;
-    *count = key_count;
+/**
+* @brief Join a packet socket to a fanout group to share the capture of an interface between sockets.
+*
+* Every frame is delivered to exactly one member of the group, picked by @p mode. Give each worker thread its own
+* packet socket bound to the same interface and protocol, and join them all to the same group. All members must use
+* the same mode. The group is per network namespace, use an id that is not used by other applications.
+* A socket stays in the group until it is closed.
+*
+* @code
+* TcsSocket workers[4];
+* for (int i = 0; i < 4; ++i)
+* {
+*     workers[i] = TCS_SOCKET_INVALID;
+*     tcs_socket_packet_str(&workers[i], "eth0", TCS_PROTOCOL_ETH_ALL, TCS_SOCKET_RAW);
+*     tcs_opt_packet_fanout_join(workers[i], 42, TCS_PACKET_FANOUT_HASH);
+* }
+* @endcode
+*
+* @note Only supported on Linux. Will return #TCS_ERROR_NOT_SUPPORTED on other platforms.
+*
+* @param[in] socket is a bound packet socket, see tcs_socket_packet().
+* @param[in] group_id identifies the group. The group is created by the first member.
+* @param[in] mode is how frames are distributed, see ::TcsPacketFanoutMode.
+* @return #TCS_SUCCESS if successful, otherwise the error code.
+*/
+TcsResult tcs_opt_packet_fanout_join(TcsSocket socket, uint16_t group_id, TcsPacketFanoutMode mode);
 
-    return 0;
-}
+/**
+* @brief Attach a classic BPF filter to a socket. Frames rejected by the filter are dropped in the kernel.
+*
+* Works on packet sockets as well as UDP and TCP sockets. Replaces any filter already attached.
+* Frames queued before the filter was attached are still received.
+*
+* @note Only supported on Linux. Will return #TCS_ERROR_NOT_SUPPORTED on other platforms.
+*
+* @param[in] socket socket to filter.
+* @param[in] filter is the program to attach, see tcs_filter_init(). It is copied by the kernel.
+* @return #TCS_SUCCESS if successful, otherwise the error code.
+* @see tcs_opt_filter_detach()
+*/
+TcsResult tcs_opt_filter_attach(TcsSocket socket, const struct TcsFilter* filter);
 
-static inline int tds_map_destroy(void** keys, void** values, size_t* count, size_t* capacity)
-{
-    size_t key_capacity = 0;
-    size_t key_count = 0;
+/**
+* @brief Remove the filter attached with tcs_opt_filter_attach().
+*
+* @note Only supported on Linux. Will return #TCS_ERROR_NOT_SUPPORTED on other platforms.
+*
+* @param[in] socket socket to remove the filter from.
+* @return #TCS_SUCCESS if successful, otherwise the error code.
+*/
+TcsResult tcs_opt_filter_detach(TcsSocket socket);
 
-    size_t value_capacity = 0;
-    size_t value_count = 0;
+/**
+* @brief List available network interfaces.
+*
+* @param[out] out_interfaces array to receive interface information, or NULL to only count.
+* @param[in] interfaces_length number of elements in the @p out_interfaces array.
+* @param[out] out_length pointer to receive the total number of interfaces available, which may exceed @p interfaces_length.
+* @return #TCS_SUCCESS if successful, otherwise the error code.
+*/
+TcsResult tcs_interface_list(struct TcsInterface out_interfaces[], size_t interfaces_length, size_t* out_length);
 
-    int key_sts = tds_ulist_destroy(keys, &key_count, &key_capacity);
-    int value_sts = tds_ulist_destroy(values, &value_count, &value_capacity);
-    *count = 0;
-    *capacity = 0;
-    if (key_sts != 0)
-        return key_sts;
-    if (value_sts != 0)
-        return value_sts;
-    return 0;
-}
+/**
+* @brief Resolve a hostname to one or more addresses.
+*
+* Numeric addresses are parsed without a lookup. Other hostnames are served from the address cache when it is enabled
+* with tcs_address_cache_enable(), at most #TCS_CFG_ADDRESS_CACHE_ADDRESSES_MAX addresses are returned then.
+*
+* @param[in] hostname hostname or IP string to resolve.
+* @param[in] address_family address family filter, or ::TCS_FAMILY_ANY for all.
+* @param[out] out_addresses array to receive resolved addresses, or NULL to only count.
+* @param[in] addresses_length number of elements in the @p out_addresses array.
+* @param[out] out_length pointer to receive the number of addresses found.
+* @return #TCS_SUCCESS if successful, otherwise the error code.
+* @retval #TCS_ERROR_NOT_SUPPORTED if @p address_family is not supported on this platform (e.g. ::TCS_FAMILY_PACKET on non-Linux).
+*/
+TcsResult tcs_address_resolve(const char* hostname,
+                              TcsFamily address_family,
+                              struct TcsAddress out_addresses[],
+                              size_t addresses_length,
+                              size_t* out_length);
 
-static inline int tds_map_add(void** keys,
-                              void** values,
-                              size_t* count,
-                              size_t* capacity,
-                              size_t key_element_size,
-                              size_t value_element_size,
-                              void* key_add,
-                              void* value_add)
-{
-    size_t value_count = *count;
-    size_t key_count = *count;
-    size_t key_capacity = *capacity;
-    size_t value_capacity = *capacity;
-    int key_sts = tds_ulist_add(keys, &key_count, &key_capacity, key_element_size, key_add, 1);
-    int value_sts = tds_ulist_add(values, &value_count, &value_capacity, value_element_size, value_add, 1);
-    if (key_sts != 0 || value_sts != 0)
-    {
-        // TODO: fix invariant memory state. Restore memory capacity should work most of the time.
-        // This is invariant is still non-fatal though, we may use more memory than needed.
-        return -1;
-    }
-    if (key_capacity != value_capacity)
-        return -1;
+/**
+* @brief Enable an in-process cache for tcs_address_resolve() and all functions using it.
+*
+* Lookups are keyed by hostname, compared case insensitively, and address family. Successful lookups are kept for
+* @p positive_ttl_ms and failed lookups (#TCS_ERROR_ADDRESS_LOOKUP_FAILED) for @p negative_ttl_ms, other errors are
+* never cached. The system resolver does not report DNS TTLs, so the same TTL is used for all hostnames. When the cache
+* is full the least recently used entry is evicted. The cache is thread safe, calling this again replaces the cache
+* with an empty one.
+*
+* @code
+* tcs_address_cache_enable(256, 60000, 5000);
+* tcs_socket_tcp_str(&socket, NULL, "example.com:80", 1000); // Resolved with getaddrinfo()
+* tcs_socket_tcp_str(&other, NULL, "example.com:80", 1000);  // Resolved from the cache
+* tcs_address_cache_disable();
+* @endcode
+*
+* @param[in] max_entries maximum number of cached hostname and family pairs.
+* @param[in] positive_ttl_ms lifetime of successful lookups, 0 to not cache them or #TCS_WAIT_INF to never expire.
+* @param[in] negative_ttl_ms lifetime of failed lookups, 0 to not cache them or #TCS_WAIT_INF to never expire.
+* @return #TCS_SUCCESS if successful, otherwise the error code.
+* @see tcs_address_cache_disable()
+*/
+TcsResult tcs_address_cache_enable(size_t max_entries, int positive_ttl_ms, int negative_ttl_ms);
 
-    *count += 1;
-    *capacity = key_capacity;
+/**
+* @brief Disable the address cache and free its memory. Lookups go to the system resolver again.
+*
+* @return #TCS_SUCCESS if successful, otherwise the error code.
+*/
+TcsResult tcs_address_cache_disable(void);
 
-    return 0;
-}
+/**
+* @brief Insert or replace a cache entry, e.g. to warm up the cache at startup or to pin a hostname to addresses.
+*
+* @param[in] hostname the name given to tcs_address_resolve().
+* @param[in] address_family the family given to tcs_address_resolve(), ::TCS_FAMILY_ANY is a separate entry.
+* @param[in] addresses the result of the lookup.
+* @param[in] addresses_length number of addresses, at most #TCS_CFG_ADDRESS_CACHE_ADDRESSES_MAX. 0 caches a failed
+* lookup.
+* @param[in] ttl_ms lifetime of the entry, or #TCS_WAIT_INF to keep it until it is evicted or flushed.
+* @return #TCS_SUCCESS if successful, otherwise the error code.
+* @retval #TCS_ERROR_LIBRARY_NOT_INITIALIZED if the cache is not enabled.
+*/
+TcsResult tcs_address_cache_prefill(const char* hostname,
+                                    TcsFamily address_family,
+                                    const struct TcsAddress addresses[],
+                                    size_t addresses_length,
+                                    int ttl_ms);
 
-static inline int tds_map_remove(void** keys,
-                                 void** values,
-                                 size_t* count,
-                                 size_t* capacity,
-                                 size_t key_element_size,
-                                 size_t value_element_size,
-                                 size_t index)
-{
-    size_t value_count = *count;
-    size_t key_count = *count;
-    size_t key_capacity = *capacity;
-    size_t value_capacity = *capacity;
-    if (index >= *count)
-        return -1;
+/**
+* @brief Remove cache entries, e.g. after a network change.
+*
+* @param[in] hostname remove the entries of all families for this hostname, or NULL to remove all entries.
+* @return #TCS_SUCCESS if successful, otherwise the error code.
+*/
+TcsResult tcs_address_cache_flush(const char* hostname);
 
-    int key_sts = tds_ulist_remove(keys, &key_count, &key_capacity, key_element_size, index, 1);
-    int value_sts = tds_ulist_remove(values, &value_count, &value_capacity, value_element_size, index, 1);
-    if (key_sts != 0 || value_sts != 0)
-    {
-        // -2 indicates we are in a very bad situation and the data structure may be corrupted.
-        // This should not be able to happen, with current implementation, but if it does, we need to be able to recover from it.
-        return -2;
-    }
-    if (key_count != value_count)
-        return -2;
-    *count = key_count;
-    *capacity = key_capacity;
-    return 0;
-}
+/**
+* @brief List addresses associated with network interfaces.
+*
+* @param[in] interface_id_filter interface ID to filter by, or 0 for all interfaces.
+* @param[in] address_family_filter address family filter, or ::TCS_FAMILY_ANY for all.
+* @param[out] out_interface_addresses array to receive results, or NULL to only count.
+* @param[in] interface_addresses_length number of elements in the @p out_interface_addresses array.
+* @param[out] out_length pointer to receive the total number of results available, which may exceed @p interface_addresses_length.
+* @return #TCS_SUCCESS if successful, otherwise the error code.
+* @note If @p address_family_filter is not supported on this platform (e.g. ::TCS_FAMILY_PACKET on non-Linux), no entries match and *out_length is 0.
+*/
+TcsResult tcs_address_list(TcsInterfaceId interface_id_filter,
+                           TcsFamily address_family_filter,
+                           struct TcsInterfaceAddress out_interface_addresses[],
+                           size_t interface_addresses_length,
+                           size_t* out_length);
 
-#define TDS_MAP_IMPL(KEY_TYPE, VALUE_TYPE, NAME)                                                                    \
-                                                                                                                    \
-    struct TdsMap_##NAME                                                                                            \
-    {                                                                                                               \
-        KEY_TYPE* keys;                                                                                             \
-        VALUE_TYPE* values;                                                                                         \
-        size_t count;                                                                                               \
-        size_t capacity;                                                                                            \
-    };                                                                                                              \
-                                                                                                                    \
-    TDS_UNUSED static inline int tds_map_##NAME##_create(struct TdsMap_##NAME* map)                                 \
-    {                                                                                                               \
-        memset(map, 0, sizeof(struct TdsMap_##NAME));                                                               \
-        return tds_map_create((void**)&map->keys,                                                                   \
-                              (void**)&map->values,                                                                 \
-                              &map->count,                                                                          \
-                              &map->capacity,                                                                       \
-                              sizeof(KEY_TYPE),                                                                     \
-                              sizeof(VALUE_TYPE));                                                                  \
-    }                                                                                                               \
-    TDS_UNUSED static inline int tds_map_##NAME##_destroy(struct TdsMap_##NAME* map)                                \
-    {                                                                                                               \
-        int sts = tds_map_destroy((void**)&map->keys, (void**)&map->values, &map->count, &map->capacity);           \
-        if (sts != 0)                                                                                               \
-            return sts;                                                                                             \
-        memset(map, 0, sizeof(struct TdsMap_##NAME));                                                               \
-        return 0;                                                                                                   \
-    }                                                                                                               \
-    TDS_UNUSED static inline int tds_map_##NAME##_add(struct TdsMap_##NAME* map, KEY_TYPE key, VALUE_TYPE value)    \
-    {                                                                                                               \
-        return tds_map_add((void**)&map->keys,                                                                      \
-                           (void**)&map->values,                                                                    \
-                           &map->count,                                                                             \
-                           &map->capacity,                                                                          \
-                           sizeof(KEY_TYPE),                                                                        \
-                           sizeof(VALUE_TYPE),                                                                      \
-                           &key,                                                                                    \
-                           &value);                                                                                 \
-    }                                                                                                               \
-    TDS_UNUSED static inline int tds_map_##NAME##_addp(struct TdsMap_##NAME* map, KEY_TYPE* key, VALUE_TYPE* value) \
-    {                                                                                                               \
-        return tds_map_add((void**)&map->keys,                                                                      \
-                           (void**)&map->values,                                                                    \
-                           &map->count,                                                                             \
-                           &map->capacity,                                                                          \
-                           sizeof(KEY_TYPE),                                                                        \
-                           sizeof(VALUE_TYPE),                                                                      \
-                           key,                                                                                     \
-                           value);                                                                                  \
-    }                                                                                                               \
-    TDS_UNUSED static inline int tds_map_##NAME##_remove(struct TdsMap_##NAME* map, size_t index)                   \
-    {                                                                                                               \
-        return tds_map_remove((void**)&map->keys,                                                                   \
-                              (void**)&map->values,                                                                 \
-                              &map->count,                                                                          \
-                              &map->capacity,                                                                       \
-                              sizeof(KEY_TYPE),                                                                     \
-                              sizeof(VALUE_TYPE),                                                                   \
-                              index);                                                                               \
-    }
+/**
+* @brief Get the local address of a bound or connected socket.
+*
+* @param[in] socket socket to query.
+* @param[out] out_local_address pointer to receive the local address.
+* @return #TCS_SUCCESS if successful, otherwise the error code.
+*/
+TcsResult tcs_address_socket_local(TcsSocket socket, struct TcsAddress* out_local_address);
 
-#endif
+/**
+* @brief Get the remote address of a connected socket.
+*
+* @param[in] socket socket to query.
+* @param[out] out_remote_address pointer to receive the remote address.
+* @return #TCS_SUCCESS if successful, otherwise the error code.
+*/
+TcsResult tcs_address_socket_remote(TcsSocket socket, struct TcsAddress* out_remote_address);
 
-/**********************************/
-/****** tinycsocket_posix.h *******/
-/**********************************/
-/*
- * Copyright 2018 Markus Lindelöw
+/**
+* @brief Get the address family of a socket.
+*
+* @param[in] socket socket to query.
+* @param[out] out_family pointer to receive the address family.
+* @return #TCS_SUCCESS if successful, otherwise the error code.
+*/
+TcsResult tcs_address_socket_family(TcsSocket socket, TcsFamily* out_family);
+
+/**
+ * @brief Parse a network address from a string.
  *
- * Permission is hereby granted, free of charge, to any person obtaining a copy
- * of this software and associated documentation files(the "Software"), to deal
- * in the Software without restriction, including without limitation the rights
- * to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
- * copies of the Software, and to permit persons to whom the Software is
- * furnished to do so, subject to the following conditions:
+ * Supports IPv4, IPv6 (RFC 4291 all three forms), MAC, and bracket/port notation (RFC 3986).
+ * IPv6 zone IDs are limited to numeric values per the minimum requirement of RFC 4007.
+ * String-based zone IDs (e.g. "%%eth0") are not supported.
  *
- * The above copyright notice and this permission notice shall be included in all
- * copies or substantial portions of the Software.
+ * Examples:
+ * @verbatim
+ * 192.168.0.1:1212
+ * ::1
+ * [::1]:443
+ * fe80::1%3
+ * ::ffff:192.168.1.1
+ * 91:E0:F0:00:FE:00
+ * @endverbatim
  *
- * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
- * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
- * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
- * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
- * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
- * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
- * SOFTWARE.
+ * Note that this function will not perform DNS resolution. Use ::tcs_address_resolve() for that.
+ *
+ * @param[in] str The string to parse.
+ * @param[out] out_address The parsed address.
+ * @return #TCS_SUCCESS if successful, otherwise the error code.
  */
+TcsResult tcs_address_parse(const char str[], struct TcsAddress* out_address);
 
-// Header only should not need other files
-#ifndef TINYCSOCKET_INTERNAL_H_
-#include "tinycsocket_internal.h"
-#endif
-#ifdef TINYCSOCKET_USE_POSIX_IMPL
+/**
+ * @brief Convert an address to a string.
+ *
+ * This will make a verbose string representation of the address.
+ * Pass @c out_str=NULL and @c str_length=0 with @c out_length set to query the required size.
+ *
+ * @param[in] address the address to convert.
+ * @param[out] out_str buffer to receive the null-terminated string representation.
+ * @param[in] str_length capacity of @c out_str in bytes. A buffer of 70 bytes is always sufficient for any supported address family.
+ * @param[out] out_length receives the length of the written string excluding the null terminator. May be NULL.
+ * @return #TCS_SUCCESS if successful, #TCS_ERROR_MEMORY if @c out_str is too small, otherwise the error code.
+ */
+TcsResult tcs_address_to_str(const struct TcsAddress* address, char out_str[], size_t str_length, size_t* out_length);
 
-#ifndef TINYDATASTRUCTURES_H_
-#include "tinydatastructures.h"
-#endif
+/**
+ * @brief Convert an array of addresses to one string, joined by a separator.
+ *
+ * Each address is formatted exactly as by tcs_address_to_str(). Useful for log lines listing several peers.
+ * Pass @c out_str=NULL and @c str_length=0 with @c out_length set to query the required size.
+ *
+ * @code
+ * char str[256];
+ * tcs_address_to_str_many(candidates, candidates_count, ", ", str, sizeof str, NULL);
+ * @endcode
+ *
+ * @param[in] addresses the addresses to convert.
+ * @param[in] addresses_length number of elements in @p addresses.
+ * @param[in] separator null-terminated string put between two addresses, NULL for none.
+ * @param[out] out_str buffer to receive the null-terminated string.
+ * @param[in] str_length capacity of @c out_str in bytes.
+ * @param[out] out_length receives the length of the whole string excluding the null terminator. May be NULL.
+ * @return #TCS_SUCCESS if successful, #TCS_ERROR_MEMORY if @c out_str is too small, otherwise the error code.
+ * @see tcs_address_to_str()
+ */
+TcsResult tcs_address_to_str_many(const struct TcsAddress addresses[],
+                                  size_t addresses_length,
+                                  const char* separator,
+                                  char out_str[],
+                                  size_t str_length,
+                                  size_t* out_length);
 
-#ifdef DO_WRAP
-#include "dbg_wrap.h"
-#endif
+/** @brief Check if two addresses are equal. Returns false for NULL, mismatched, unknown, or unsupported address families. */
+bool tcs_address_is_equal(const struct TcsAddress* l, const struct TcsAddress* r);
 
-#ifndef TCS_HAS_AF_PACKET
-#if defined(__linux__)
-#define TCS_HAS_AF_PACKET 1
-#else
-#define TCS_HAS_AF_PACKET 0
-#endif
-#endif
+/**
+ * @brief Hash an address for use in hash tables.
+ *
+ * Only the fields compared by tcs_address_is_equal() are hashed, so equal addresses always have equal hashes. Like
+ * tcs_address_is_equal(), the IPv6 scope id is not part of the hash.
+ *
+ * @param[in] address the address to hash. NULL hashes to a value derived from @p seed only.
+ * @param[in] seed varies the hash function. Use a random seed per table when peers choose the addresses.
+ * @return a 64 bit hash where all bits depend on the address, so masking off the low bits is fine.
+ */
+uint64_t tcs_address_hash(const struct TcsAddress* address, uint64_t seed);
 
-#ifndef TCS_HAS_GETIFADDRS
-#if defined(__ANDROID__)
-#if __ANDROID_API__ >= 24
-#define TCS_HAS_GETIFADDRS 1
-#else
-#define TCS_HAS_GETIFADDRS 0
-#endif
-#elif defined(__linux__) || defined(__APPLE__) || defined(__FreeBSD__) || defined(__OpenBSD__) || \
-    defined(__NetBSD__) || defined(__CYGWIN__)
-#define TCS_HAS_GETIFADDRS 1
-#else
-#define TCS_HAS_GETIFADDRS 0
-#endif
+/** @brief Check if the address is a wildcard (any) address. Returns false for NULL, unknown, or unsupported address families. */
+bool tcs_address_is_any(const struct TcsAddress* addr);
+
+/** @brief Check if the address is a link-local address. Returns false for NULL, unknown, or unsupported address families. */
+bool tcs_address_is_link_local(const struct TcsAddress* addr);
+
+/** @brief Check if the address is a loopback address. Returns false for NULL, unknown, or unsupported address families. */
+bool tcs_address_is_loopback(const struct TcsAddress* addr);
+
+/** @brief Check if the address is a multicast address. Returns false for NULL, unknown, or unsupported address families. */
+bool tcs_address_is_multicast(const struct TcsAddress* addr);
+
+/** @brief Check if the address is a broadcast address. Returns false for NULL, unknown, or unsupported address families. */
+bool tcs_address_is_broadcast(const struct TcsAddress* addr);
+
+/** @brief Check if the address family is known and supported by this platform. Returns false for NULL or unknown families. */
+bool tcs_address_is_supported(const struct TcsAddress* addr);
+
+/**
+ * @brief Create a hash map from addresses to user pointers, for example per peer state of a UDP server.
+ *
+ * Lookups take constant time on average. Keys are compared with tcs_address_is_equal() and hashed with
+ * tcs_address_hash() using a random seed per map. The map is not thread safe.
+ *
+ * @code
+ * struct Peer* peer = (struct Peer*)tcs_address_map_get(peers, &source);
+ * if (peer == NULL)
+ * {
+ *     peer = peer_create();
+ *     tcs_address_map_set(peers, &source, peer);
+ * }
+ * @endcode
+ *
+ * @param[out] out_map receives the new map, free it with tcs_address_map_destroy().
+ * @param[in] capacity_hint number of entries to make room for up front, 0 to grow on demand.
+ * @return #TCS_SUCCESS if successful, otherwise the error code.
+ */
+TcsResult tcs_address_map_create(struct TcsAddressMap** out_map, size_t capacity_hint);
+
+/**
+ * @brief Free a map created with tcs_address_map_create(). The values are not touched.
+ *
+ * @param[in,out] map pointer to the map, set to NULL afterwards.
+ * @return #TCS_SUCCESS if successful, otherwise the error code.
+ */
+TcsResult tcs_address_map_destroy(struct TcsAddressMap** map);
+
+/**
+ * @brief Insert an address or replace the value of an address already in the map.
+ *
+ * @param[in] map created with tcs_address_map_create().
+ * @param[in] address the key, copied into the map.
+ * @param[in] value the pointer to store.
+ * @return #TCS_SUCCESS if successful, otherwise the error code.
+ * @retval #TCS_ERROR_MEMORY if the map could not grow.
+ */
+TcsResult tcs_address_map_set(struct TcsAddressMap* map, const struct TcsAddress* address, void* value);
+
+/**
+ * @brief Look up the value of an address.
+ *
+ * @param[in] map created with tcs_address_map_create().
+ * @param[in] address the key to look up.
+ * @return the stored value, or NULL if the address is not in the map.
+ */
+void* tcs_address_map_get(const struct TcsAddressMap* map, const struct TcsAddress* address);
+
+/**
+ * @brief Remove an address from the map.
+ *
+ * @param[in] map created with tcs_address_map_create().
+ * @param[in] address the key to remove.
+ * @return #TCS_SUCCESS if successful, otherwise the error code.
+ * @retval #TCS_ERROR_INVALID_ARGUMENT if the address is not in the map.
+ */
+TcsResult tcs_address_map_remove(struct TcsAddressMap* map, const struct TcsAddress* address);
+
+/** @brief Number of addresses in the map, 0 for NULL. */
+size_t tcs_address_map_count(const struct TcsAddressMap* map);
+
+#ifdef __cplusplus
+}
 #endif
 
-#include <errno.h>
-#include <fcntl.h> // fcntl() for non-blocking
-#include <limits.h>
-#include <net/if.h>      // Flags for ifaddrs (?)
-#include <netdb.h>       // Protocols and custom return codes
-#include <netinet/in.h>  // IPPROTO_XXP
-#include <netinet/tcp.h> // TCP_NODELAY
-#include <poll.h>        // poll()
-#include <stdlib.h>      // malloc()/free()
-#include <string.h>      // strcpy, memset
-#include <sys/ioctl.h>   // Flags for ifaddrs
-#ifdef __sun
-#include <sys/sockio.h> // SIOCGIFCONF on Solaris/illumos
 #endif
-#include <sys/socket.h> // pretty much everything
-#include <sys/types.h>  // POSIX.1 compatibility
-#include <sys/uio.h>    // struct iovec
-#include <time.h>       // clock_gettime()
-#include <unistd.h>     // close()
 
-#if TCS_HAS_GETIFADDRS
-#include <ifaddrs.h> // getifaddr()
+#ifdef TINYCSOCKET_IMPLEMENTATION
+/**********************************/
+/****** tinydatastructures.h ******/
+/**********************************/
+#ifndef TINYDATASTRUCTURES_H_
+#define TINYDATASTRUCTURES_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+// All memory comes from TDS_MALLOC, TDS_REALLOC and TDS_FREE, define them before including this file to use another
+// allocator. Inside tinycsocket they go through the tcs_lib_set_allocator() hooks.
+#ifndef TDS_MALLOC
+#ifdef TINYCSOCKET_INTERNAL_H_
+#define TDS_MALLOC(size) tcs_lib_malloc(size)
+#define TDS_REALLOC(ptr, size) tcs_lib_realloc(ptr, size)
+#define TDS_FREE(ptr) tcs_lib_free(ptr)
+#else
+#define TDS_MALLOC(size) malloc(size)
+#define TDS_REALLOC(ptr, size) realloc(ptr, size)
+#define TDS_FREE(ptr) free(ptr)
 #endif
-#if TCS_HAS_AF_PACKET
-#include <linux/if_arp.h>    // sll_hatype (ethernet and not can or firewire etc.)
-#include <linux/if_packet.h> // struct sockaddr_ll
 #endif
 
-#ifndef TDS_MAP_pollfd_pvoid
-#define TDS_MAP_pollfd_pvoid
-TDS_MAP_IMPL(struct pollfd, void*, poll)
+#ifdef _MSC_VER
+#define TDS_UNUSED
+#else
+#define TDS_UNUSED __attribute__((unused))
 #endif
 
-struct TcsPoll
+// Growth and shrink behavior of a TdsUList or TdsMap, chosen per instantiation with the *_IMPL_WITH_POLICY macros.
+// Capacities step from minimum_capacity by growth_percent, 200 doubles. A list shrinks to fit when the count drops
+// below capacity / shrink_divisor, but never by a single step, and TDS_SHRINK_NEVER keeps the capacity until destroy.
+struct TdsGrowthPolicy
 {
-    union __backend
-    {
-        struct __poll
-        {
-            struct TdsMap_poll map;
-        } poll;
-    } backend;
+    size_t minimum_capacity; // Capacity after create
+    size_t growth_percent;   // Next capacity in percent of the current one, grows by at least one element
+    int is_zero_filled;      // Newly reserved elements are zeroed
+    size_t shrink_divisor;   // Or TDS_SHRINK_NEVER
 };
 
-const TcsSocket TCS_SOCKET_INVALID = -1;
-const int32_t TCS_WAIT_INF = -1;
+#define TDS_SHRINK_NEVER 0
 
-static long tcs_iov_max = 1024; // Default, updated by tcs_lib_init() via sysconf(_SC_IOV_MAX)
+static const struct TdsGrowthPolicy TDS_GROWTH_POLICY_DEFAULT = {8, 200, 1, 2};
 
-// Addresses
-const TcsAddressIpv4 TCS_ADDRESS_IPV4_ANY = INADDR_ANY;
-const TcsAddressIpv4 TCS_ADDRESS_IPV4_LOOPBACK = INADDR_LOOPBACK;
-const TcsAddressIpv4 TCS_ADDRESS_IPV4_BROADCAST = INADDR_BROADCAST;
-const TcsAddressIpv4 TCS_ADDRESS_IPV4_NONE = INADDR_NONE;
+// For sets that go up and down in size, like poll sets, no realloc() or memset() once they have reached their peak
+static const struct TdsGrowthPolicy TDS_GROWTH_POLICY_NEVER_SHRINK = {8, 200, 0, TDS_SHRINK_NEVER};
 
-const struct TcsAddressIpv6 TCS_ADDRESS_IPV6_ANY = {{0}};
-const struct TcsAddressIpv6 TCS_ADDRESS_IPV6_LOOPBACK = {{0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1}};
+static inline int tds_ulist_create(
+    void** data, size_t* count, size_t* capacity, size_t element_size, const struct TdsGrowthPolicy* policy);
+static inline int tds_ulist_destroy(void** data, size_t* count, size_t* capacity);
+static inline int tds_ulist_reserve(void** data,
+                                    size_t* capacity,
+                                    size_t element_size,
+                                    size_t requested_capacity,
+                                    const struct TdsGrowthPolicy* policy);
+static inline int tds_ulist_add(void** data,
+                                size_t* count,
+                                size_t* capacity,
+                                size_t element_size,
+                                void* add_data,
+                                size_t add_count,
+                                const struct TdsGrowthPolicy* policy);
+static inline int tds_ulist_remove(void** data,
+                                   size_t* count,
+                                   size_t* capacity,
+                                   size_t element_size,
+                                   size_t remove_from,
+                                   size_t remove_count,
+                                   const struct TdsGrowthPolicy* policy);
 
-// Family
-const TcsFamily TCS_FAMILY_ANY = {AF_UNSPEC};
-const TcsFamily TCS_FAMILY_IPV4 = {AF_INET};
-const TcsFamily TCS_FAMILY_IPV6 = {AF_INET6};
-#if TCS_HAS_AF_PACKET
-const TcsFamily TCS_FAMILY_PACKET = {AF_PACKET};
-#else
-const TcsFamily TCS_FAMILY_PACKET = {-1}; /* sentinel: socket() will reject */
-#endif
+static inline int tds_ulist_create(
+    void** data, size_t* count, size_t* capacity, size_t element_size, const struct TdsGrowthPolicy* policy)
+{
+    *data = NULL;
+    *count = 0;
+    *capacity = 0;
+    if (element_size == 0)
+        return -1;
+    return tds_ulist_reserve(data, capacity, element_size, 1, policy);
+}
 
-// Type
-const TcsSocketType TCS_SOCKET_STREAM = {SOCK_STREAM};
-const TcsSocketType TCS_SOCKET_DGRAM = {SOCK_DGRAM};
-const TcsSocketType TCS_SOCKET_RAW = {SOCK_RAW};
+static inline int tds_ulist_destroy(void** data, size_t* count, size_t* capacity)
+{
+    if (*data != NULL)
+    {
+        TDS_FREE(*data);
+        *data = NULL;
+    }
+    *count = 0;
+    *capacity = 0;
+    return 0;
+}
 
-// Recv flags
-const uint32_t TCS_MSG_PEEK = MSG_PEEK;
-const uint32_t TCS_MSG_OOB = MSG_OOB;
-const uint32_t TCS_MSG_WAITALL = MSG_WAITALL;
+static inline size_t tds_ulist_next_capacity(const struct TdsGrowthPolicy* policy, size_t capacity)
+{
+    size_t next = capacity * policy->growth_percent / 100;
+    return next > capacity ? next : capacity + 1;
+}
 
-// Send flags
-const uint32_t TCS_MSG_SENDALL = 0x80000000;
+// TODO: move to reserve
+static inline size_t tds_ulist_policy_capacity_fit(const struct TdsGrowthPolicy* policy,
+                                                   size_t old_capacity,
+                                                   size_t new_capacity)
+{
+    size_t c = policy->minimum_capacity > 0 ? policy->minimum_capacity : 1;
+    while (c < new_capacity)
+        c = tds_ulist_next_capacity(policy, c);
 
-// Backlog
-const int TCS_BACKLOG_MAX = SOMAXCONN;
+    // Hysteresis
+    if (tds_ulist_next_capacity(policy, c) == old_capacity)
+        return old_capacity;
 
-// Option levels
-const int32_t TCS_SOL_SOCKET = SOL_SOCKET;
-const int32_t TCS_SOL_IP = IPPROTO_IP; // Same as SOL_IP but crossplatform (BSD)
-const int32_t TCS_SOL_TCP = IPPROTO_TCP;
-#if TCS_HAS_AF_PACKET
-const int32_t TCS_SOL_PACKET = SOL_PACKET;
-#else
-const int32_t TCS_SOL_PACKET = -1;
-#endif
+    return c;
+}
 
-// Socket options
-const int32_t TCS_SO_TYPE = SO_TYPE;
-const int32_t TCS_SO_BROADCAST = SO_BROADCAST;
-const int32_t TCS_SO_KEEPALIVE = SO_KEEPALIVE;
-const int32_t TCS_SO_LINGER = SO_LINGER;
-const int32_t TCS_SO_REUSEADDR = SO_REUSEADDR;
-#ifdef SO_REUSEPORT
-const int32_t TCS_SO_REUSEPORT = SO_REUSEPORT;
-#else
-const int32_t TCS_SO_REUSEPORT = -1;
-#endif
-const int32_t TCS_SO_RCVBUF = SO_RCVBUF;
-const int32_t TCS_SO_RCVTIMEO = SO_RCVTIMEO;
-const int32_t TCS_SO_SNDBUF = SO_SNDBUF;
-const int32_t TCS_SO_OOBINLINE = SO_OOBINLINE;
-#ifdef SO_PRIORITY
-const int32_t TCS_SO_PRIORITY = SO_PRIORITY;
-#else
-const int32_t TCS_SO_PRIORITY = -1;
-#endif
+static inline size_t tds_ulist_best_capacity_fit(size_t old_capacity, size_t new_capacity)
+{
+    return tds_ulist_policy_capacity_fit(&TDS_GROWTH_POLICY_DEFAULT, old_capacity, new_capacity);
+}
 
-// IP options
-const int32_t TCS_TCP_NODELAY = TCP_NODELAY;
-const int32_t TCS_IP_MEMBERSHIP_ADD = IP_ADD_MEMBERSHIP;
-const int32_t TCS_IP_MEMBERSHIP_DROP = IP_DROP_MEMBERSHIP;
-const int32_t TCS_IP_MULTICAST_LOOP = IP_MULTICAST_LOOP;
+static inline int tds_ulist_reserve(void** data,
+                                    size_t* capacity,
+                                    size_t element_size,
+                                    size_t requested_capacity,
+                                    const struct TdsGrowthPolicy* policy)
+{
+    size_t new_capacity = tds_ulist_policy_capacity_fit(policy, *capacity, requested_capacity);
+    if (new_capacity == *capacity)
+        return 0;
+    if (new_capacity < *capacity && policy->shrink_divisor == TDS_SHRINK_NEVER)
+        return 0;
 
-#if TCS_HAS_AF_PACKET
-const int32_t TCS_PACKET_MEMBERSHIP_ADD = PACKET_ADD_MEMBERSHIP;
-const int32_t TCS_PACKET_MEMBERSHIP_DROP = PACKET_DROP_MEMBERSHIP;
-#else
-const int32_t TCS_PACKET_MEMBERSHIP_ADD = -1;
-const int32_t TCS_PACKET_MEMBERSHIP_DROP = -1;
+// UB protection for C23 and implemention defined protection before C23 (Should never happen)
+#ifndef NDEBUG
+    if (new_capacity == 0)
+        return -1;
 #endif
 
-// Default flags
-const int TCS_DEFAULT_SEND_FLAGS = MSG_NOSIGNAL;
-const int TCS_DEFAULT_RECV_FLAGS = 0;
-
-// ######## Internal Helpers ########
+    void* new_data = TDS_REALLOC(*data, new_capacity * element_size);
+    if (new_data == NULL)
+        return -1;
 
-static TcsResult errno2retcode(int error_code)
-{
-    switch (error_code)
+    if (policy->is_zero_filled && new_capacity > *capacity)
     {
-        case EAGAIN:
-#if defined(EWOULDBLOCK) && (EWOULDBLOCK != EAGAIN)
-        case EWOULDBLOCK:
-#endif
-            return TCS_ERROR_WOULD_BLOCK;
-        case EINPROGRESS:
-            return TCS_IN_PROGRESS;
-        case EPERM:
-        case EACCES:
-            return TCS_ERROR_PERMISSION_DENIED;
-        case ECONNREFUSED:
-            return TCS_ERROR_CONNECTION_REFUSED;
-        case ECONNRESET:
-            return TCS_ERROR_CONNECTION_RESET;
-        case ENOTCONN:
-            return TCS_ERROR_NOT_CONNECTED;
-        case ETIMEDOUT:
-            return TCS_ERROR_TIMED_OUT;
-        case ENETUNREACH:
-        case EHOSTUNREACH:
-        case ENETDOWN:
-            return TCS_ERROR_NETWORK_UNREACHABLE;
-        case EINVAL:
-            return TCS_ERROR_INVALID_ARGUMENT;
-        case EADDRINUSE:
-            return TCS_ERROR_ADDRESS_IN_USE;
-        case ENOPROTOOPT:
-            return TCS_ERROR_NOT_SUPPORTED;
-        case EAFNOSUPPORT:
-        case EPROTONOSUPPORT:
-        case ESOCKTNOSUPPORT:
-            return TCS_ERROR_NOT_SUPPORTED;
-        case ENODEV:
-            return TCS_ERROR_INVALID_ARGUMENT;
-        case ENOMEM:
-            return TCS_ERROR_MEMORY;
-        case EAI_SOCKTYPE:
-            return TCS_ERROR_NOT_IMPLEMENTED;
-        default:
-            return TCS_ERROR_UNKNOWN;
+        memset((char*)new_data + *capacity * element_size, 0, (new_capacity - *capacity) * element_size);
     }
+    *data = new_data;
+    *capacity = new_capacity;
+    return 0;
 }
 
-static TcsResult sockaddr2native(const struct TcsAddress* tcs_address,
-                                 struct sockaddr_storage* out_address,
-                                 socklen_t* out_address_size)
+static inline int tds_ulist_add(void** data,
+                                size_t* count,
+                                size_t* capacity,
+                                size_t element_size,
+                                void* add_data,
+                                size_t add_count,
+                                const struct TdsGrowthPolicy* policy)
 {
-    if (tcs_address == NULL || out_address == NULL)
-        return TCS_ERROR_INVALID_ARGUMENT;
-
-    if (tcs_address->family.native == -1) // sentinel for unsupported families (e.g. TCS_FAMILY_PACKET on non-Linux)
-        return TCS_ERROR_NOT_SUPPORTED;
-
-    memset(out_address, 0, sizeof(struct sockaddr_storage));
-    if (out_address_size != NULL)
-        *out_address_size = 0;
-
-    if (tcs_address->family.native == TCS_FAMILY_ANY.native)
-    {
-        return TCS_ERROR_NOT_SUPPORTED;
-    }
-    else if (tcs_address->family.native == TCS_FAMILY_IPV4.native)
-    {
-        struct sockaddr_in* addr = (struct sockaddr_in*)out_address;
-        addr->sin_family = (sa_family_t)AF_INET;
-        addr->sin_port = (in_port_t)htons(tcs_address->data.ipv4.port);
-        addr->sin_addr.s_addr = (in_addr_t)htonl(tcs_address->data.ipv4.address);
-        if (out_address_size != NULL)
-            *out_address_size = sizeof(struct sockaddr_in);
-        return TCS_SUCCESS;
-    }
-    else if (tcs_address->family.native == TCS_FAMILY_IPV6.native)
-    {
-        struct sockaddr_in6* addr = (struct sockaddr_in6*)out_address;
-        addr->sin6_family = (sa_family_t)AF_INET6;
-        addr->sin6_port = (in_port_t)htons(tcs_address->data.ipv6.port);
-        memcpy(&addr->sin6_addr, tcs_address->data.ipv6.address.bytes, 16);
-        addr->sin6_scope_id = (uint32_t)tcs_address->data.ipv6.scope_id;
-        if (out_address_size != NULL)
-            *out_address_size = sizeof(struct sockaddr_in6);
-        return TCS_SUCCESS;
-    }
-    else if (tcs_address->family.native == TCS_FAMILY_PACKET.native)
+    if (*count + add_count > *capacity)
     {
-#if TCS_HAS_AF_PACKET
-        struct sockaddr_ll* addr = (struct sockaddr_ll*)out_address;
-        addr->sll_family = (sa_family_t)AF_PACKET;
-        addr->sll_ifindex = (int)tcs_address->data.packet.interface_id;
-        addr->sll_protocol = (uint16_t)htons(tcs_address->data.packet.protocol);
-        addr->sll_halen = 6; // MAC address length
-        memcpy(addr->sll_addr, tcs_address->data.packet.mac, 6);
-        if (out_address_size != NULL)
-            *out_address_size = sizeof(struct sockaddr_ll);
-        return TCS_SUCCESS;
-#else
-        return TCS_ERROR_NOT_SUPPORTED;
-#endif
+        int reserve_sts = tds_ulist_reserve(data, capacity, element_size, *count + add_count, policy);
+        if (reserve_sts != 0)
+            return reserve_sts;
     }
 
-    return TCS_ERROR_NOT_SUPPORTED;
+    memcpy((char*)*data + (*count * element_size), add_data, add_count * element_size);
+    *count += add_count;
+    return 0;
 }
 
-static TcsResult native2sockaddr(const struct sockaddr* in_addr, struct TcsAddress* out_addr)
+static inline int tds_ulist_remove(void** data,
+                                   size_t* count,
+                                   size_t* capacity,
+                                   size_t element_size,
+                                   size_t remove_from,
+                                   size_t remove_count,
+                                   const struct TdsGrowthPolicy* policy)
 {
-    if (in_addr == NULL || out_addr == NULL)
-        return TCS_ERROR_INVALID_ARGUMENT;
+    if (remove_from >= *count || remove_count == 0 || remove_from + remove_count > *count)
+        return -1;
 
-    if (in_addr->sa_family == AF_INET)
+    void* dst = (char*)(*data) + (remove_from * element_size);
+    void* src = (char*)(*data) + (*count - remove_count) * element_size;
+    memmove(dst, src, element_size * remove_count);
+    *count -= remove_count;
+
+    if (policy->shrink_divisor != TDS_SHRINK_NEVER && *count < *capacity / policy->shrink_divisor)
     {
-        // (const void*) Supresses false positive alignment warning, the creator of the sockaddr is responsible for the alignment.
-        struct sockaddr_in const* addr = (struct sockaddr_in const*)(const void*)in_addr;
-        out_addr->family = TCS_FAMILY_IPV4;
-        out_addr->data.ipv4.port = ntohs((uint16_t)addr->sin_port);
-        out_addr->data.ipv4.address = ntohl((uint32_t)addr->sin_addr.s_addr);
+        int reserve_sts = tds_ulist_reserve(data, capacity, element_size, *count, policy);
+        if (reserve_sts != 0)
+            return reserve_sts;
     }
-    else if (in_addr->sa_family == AF_INET6)
-    {
-        struct sockaddr_in6 const* addr = (struct sockaddr_in6 const*)(const void*)in_addr;
-        out_addr->family = TCS_FAMILY_IPV6;
-        out_addr->data.ipv6.port = ntohs((uint16_t)addr->sin6_port);
-        memcpy(out_addr->data.ipv6.address.bytes, &addr->sin6_addr, 16);
-        out_addr->data.ipv6.scope_id = (TcsInterfaceId)addr->sin6_scope_id;
-    }
-#if TCS_HAS_AF_PACKET
-    else if (in_addr->sa_family == AF_PACKET)
-    {
-        struct sockaddr_ll const* addr = (struct sockaddr_ll const*)(const void*)in_addr;
-        if (addr->sll_family != AF_PACKET)
-            return TCS_ERROR_NOT_IMPLEMENTED;
-        if (addr->sll_hatype != ARPHRD_ETHER && addr->sll_hatype != ARPHRD_LOOPBACK)
-            return TCS_ERROR_NOT_IMPLEMENTED; // Not ethernet or loopback
-        if (addr->sll_halen > 6)
-            return TCS_ERROR_INVALID_ARGUMENT;
-        if (addr->sll_ifindex < 0)
-            return TCS_ERROR_INVALID_ARGUMENT;
 
-        out_addr->family = TCS_FAMILY_PACKET;
-        out_addr->data.packet.interface_id = (unsigned int)addr->sll_ifindex;
+    return 0;
+}
 
-        memcpy(out_addr->data.packet.mac, addr->sll_addr, 6);
-        out_addr->data.packet.protocol = ntohs((uint16_t)addr->sll_protocol);
+#define TDS_ULIST_IMPL_WITH_POLICY(TYPE, NAME, POLICY)                                                                 \
+    struct TdsUList_##NAME                                                                                             \
+    {                                                                                                                  \
+        TYPE* data;                                                                                                    \
+        size_t count;                                                                                                  \
+        size_t capacity;                                                                                               \
+    };                                                                                                                 \
+                                                                                                                       \
+    TDS_UNUSED static inline int tds_ulist_##NAME##_create(struct TdsUList_##NAME* ulist)                              \
+    {                                                                                                                  \
+        return tds_ulist_create((void**)&ulist->data, &ulist->count, &ulist->capacity, sizeof(TYPE), (POLICY));        \
+    }                                                                                                                  \
+    TDS_UNUSED static inline int tds_ulist_##NAME##_destroy(struct TdsUList_##NAME* ulist)                             \
+    {                                                                                                                  \
+        int sts = tds_ulist_destroy((void**)&ulist->data, &ulist->count, &ulist->capacity);                            \
+        memset(ulist, 0, sizeof(*ulist));                                                                              \
+        return sts;                                                                                                    \
+    }                                                                                                                  \
+    TDS_UNUSED static inline int tds_ulist_##NAME##_add(struct TdsUList_##NAME* ulist, TYPE* data, size_t count)       \
+    {                                                                                                                  \
+        return tds_ulist_add(                                                                                          \
+            (void**)&ulist->data, &ulist->count, &ulist->capacity, sizeof(TYPE), (void*)data, count, (POLICY));        \
+    }                                                                                                                  \
+    TDS_UNUSED static inline int tds_ulist_##NAME##_remove(                                                            \
+        struct TdsUList_##NAME* ulist, size_t remove_from, size_t remove_count)                                        \
+    {                                                                                                                  \
+        return tds_ulist_remove(                                                                                       \
+            (void**)&ulist->data, &ulist->count, &ulist->capacity, sizeof(TYPE), remove_from, remove_count, (POLICY)); \
+    }                                                                                                                  \
+    TDS_UNUSED static inline int tds_ulist_##NAME##_reserve(struct TdsUList_##NAME* ulist, size_t new_capacity)        \
+    {                                                                                                                  \
+        return tds_ulist_reserve((void**)&ulist->data, &ulist->capacity, sizeof(TYPE), new_capacity, (POLICY));        \
     }
-#endif
-    else if (in_addr->sa_family == AF_UNSPEC)
+
+#define TDS_ULIST_IMPL(TYPE, NAME) TDS_ULIST_IMPL_WITH_POLICY(TYPE, NAME, &TDS_GROWTH_POLICY_DEFAULT)
+
+// Tiny Data Structures Map Implementation
+
+static inline int tds_map_create(void** keys,
+                                 void** values,
+                                 size_t* count,
+                                 size_t* capacity,
+                                 size_t key_element_size,
+                                 size_t value_element_size,
+                                 const struct TdsGrowthPolicy* policy)
+{
+    size_t key_capacity = 0;
+    size_t key_count = 0;
+
+    size_t value_capacity = 0;
+    size_t value_count = 0;
+
+    int key_sts = tds_ulist_create(keys, &key_count, &key_capacity, key_element_size, policy);
+    int value_sts = tds_ulist_create(values, &value_count, &value_capacity, value_element_size, policy);
+
+    if (key_sts != 0 || value_sts != 0)
     {
-        return TCS_ERROR_INVALID_ARGUMENT;
+        tds_ulist_destroy(keys, &key_count, &key_capacity);
+        tds_ulist_destroy(values, &value_count, &value_capacity);
+        if (key_sts != 0)
+            return key_sts;
+        if (value_sts != 0)
+            return value_sts;
     }
-    else
+    if (key_capacity != value_capacity)
     {
-        return TCS_ERROR_NOT_IMPLEMENTED;
+        tds_ulist_destroy(keys, &key_count, &key_capacity);
+        tds_ulist_destroy(values, &value_count, &value_capacity);
+        return -1;
     }
+    *capacity = key_capacity;
+    *count = key_count;
 
-    return TCS_SUCCESS;
+    return 0;
 }
 
-// ######## Library Management ########
+static inline int tds_map_destroy(void** keys, void** values, size_t* count, size_t* capacity)
+{
+    size_t key_capacity = 0;
+    size_t key_count = 0;
 
-TcsResult tcs_lib_init(void)
+    size_t value_capacity = 0;
+    size_t value_count = 0;
+
+    int key_sts = tds_ulist_destroy(keys, &key_count, &key_capacity);
+    int value_sts = tds_ulist_destroy(values, &value_count, &value_capacity);
+    *count = 0;
+    *capacity = 0;
+    if (key_sts != 0)
+        return key_sts;
+    if (value_sts != 0)
+        return value_sts;
+    return 0;
+}
+
+static inline int tds_map_add(void** keys,
+                              void** values,
+                              size_t* count,
+                              size_t* capacity,
+                              size_t key_element_size,
+                              size_t value_element_size,
+                              void* key_add,
+                              void* value_add,
+                              const struct TdsGrowthPolicy* policy)
 {
-    long iov_max = sysconf(_SC_IOV_MAX);
-    if (iov_max > 0)
-        tcs_iov_max = iov_max;
-    return TCS_SUCCESS;
+    size_t value_count = *count;
+    size_t key_count = *count;
+    size_t key_capacity = *capacity;
+    size_t value_capacity = *capacity;
+    int key_sts = tds_ulist_add(keys, &key_count, &key_capacity, key_element_size, key_add, 1, policy);
+    int value_sts = tds_ulist_add(values, &value_count, &value_capacity, value_element_size, value_add, 1, policy);
+    if (key_sts != 0 || value_sts != 0)
+    {
+        // TODO: fix invariant memory state. Restore memory capacity should work most of the time.
+        // This is invariant is still non-fatal though, we may use more memory than needed.
+        return -1;
+    }
+    if (key_capacity != value_capacity)
+        return -1;
+
+    *count += 1;
+    *capacity = key_capacity;
+
+    return 0;
 }
 
-TcsResult tcs_lib_cleanup(void)
+static inline int tds_map_remove(void** keys,
+                                 void** values,
+                                 size_t* count,
+                                 size_t* capacity,
+                                 size_t key_element_size,
+                                 size_t value_element_size,
+                                 size_t index,
+                                 const struct TdsGrowthPolicy* policy)
 {
-    // Not needed for posix
-    return TCS_SUCCESS;
+    size_t value_count = *count;
+    size_t key_count = *count;
+    size_t key_capacity = *capacity;
+    size_t value_capacity = *capacity;
+    if (index >= *count)
+        return -1;
+
+    int key_sts = tds_ulist_remove(keys, &key_count, &key_capacity, key_element_size, index, 1, policy);
+    int value_sts = tds_ulist_remove(values, &value_count, &value_capacity, value_element_size, index, 1, policy);
+    if (key_sts != 0 || value_sts != 0)
+    {
+        // -2 indicates we are in a very bad situation and the data structure may be corrupted.
+        // This should not be able to happen, with current implementation, but if it does, we need to be able to recover from it.
+        return -2;
+    }
+    if (key_count != value_count)
+        return -2;
+    *count = key_count;
+    *capacity = key_capacity;
+    return 0;
 }
 
-// ######## Socket Creation ########
+#define TDS_MAP_IMPL_WITH_POLICY(KEY_TYPE, VALUE_TYPE, NAME, POLICY)                                               \
+                                                                                                                   \
+    struct TdsMap_##NAME                                                                                           \
+    {                                                                                                              \
+        KEY_TYPE* keys;                                                                                            \
+        VALUE_TYPE* values;                                                                                        \
+        size_t count;                                                                                              \
+        size_t capacity;                                                                                           \
+    };                                                                                                             \
+                                                                                                                   \
+    TDS_UNUSED static inline int tds_map_##NAME##_create(struct TdsMap_##NAME* map)                                \
+    {                                                                                                              \
+        memset(map, 0, sizeof(struct TdsMap_##NAME));                                                              \
+        return tds_map_create((void**)&map->keys,                                                                  \
+                              (void**)&map->values,                                                                \
+                              &map->count,                                                                         \
+                              &map->capacity,                                                                      \
+                              sizeof(KEY_TYPE),                                                                    \
+                              sizeof(VALUE_TYPE),                                                                  \
+                              (POLICY));                                                                           \
+    }                                                                                                              \
+    TDS_UNUSED static inline int tds_map_##NAME##_destroy(struct TdsMap_##NAME* map)                               \
+    {                                                                                                              \
+        int sts = tds_map_destroy((void**)&map->keys, (void**)&map->values, &map->count, &map->capacity);          \
+        if (sts != 0)                                                                                              \
+            return sts;                                                                                            \
+        memset(map, 0, sizeof(struct TdsMap_##NAME));                                                              \
+        return 0;                                                                                                  \
+    }                                                                                                              \
+    TDS_UNUSED static inline int tds_map_##NAME##_add(struct TdsMap_##NAME* map, KEY_TYPE key, VALUE_TYPE value)   \
+    {                                                                                                              \
+        return tds_map_add((void**)&map->keys,                                                                     \
+                           (void**)&map->values,                                                                   \
+                           &map->count,                                                                            \
+                           &map->capacity,                                                                         \
+                           sizeof(KEY_TYPE),                                                                       \
+                           sizeof(VALUE_TYPE),                                                                     \
+                           &key,                                                                                   \
+                           &value,                                                                                 \
+                           (POLICY));                                                                              \
+    }                                                                                                              \
+    TDS_UNUSED static inline int tds_map_##NAME##_addp(struct TdsMap_##NAME* map, KEY_TYPE* key, VALUE_TYPE* value)\
+    {                                                                                                              \
+        return tds_map_add((void**)&map->keys,                                                                     \
+                           (void**)&map->values,                                                                   \
+                           &map->count,                                                                            \
+                           &map->capacity,                                                                         \
+                           sizeof(KEY_TYPE),                                                                       \
+                           sizeof(VALUE_TYPE),                                                                     \
+                           key,                                                                                    \
+                           value,                                                                                  \
+                           (POLICY));                                                                              \
+    }                                                                                                              \
+    TDS_UNUSED static inline int tds_map_##NAME##_remove(struct TdsMap_##NAME* map, size_t index)                  \
+    {                                                                                                              \
+        return tds_map_remove((void**)&map->keys,                                                                  \
+                              (void**)&map->values,                                                                \
+                              &map->count,                                                                         \
+                              &map->capacity,                                                                      \
+                              sizeof(KEY_TYPE),                                                                    \
+                              sizeof(VALUE_TYPE),                                                                  \
+                              index,                                                                               \
+                              (POLICY));                                                                           \
+    }
 
-TcsResult tcs_socket(TcsSocket* out_socket, TcsFamily family, TcsSocketType type, TcsProtocol protocol)
+#define TDS_MAP_IMPL(KEY_TYPE, VALUE_TYPE, NAME)                                                                    \
+    TDS_MAP_IMPL_WITH_POLICY(KEY_TYPE, VALUE_TYPE, NAME, &TDS_GROWTH_POLICY_DEFAULT)
+
+// Tiny Data Structures Hash Map Implementation
+// Robin Hood open addressing over power of two capacities. HASH(const KEY_TYPE*, uint64_t seed) returns the hash as
+// uint64_t and EQ(const KEY_TYPE*, const KEY_TYPE*) is true for equal keys. Probing reads one metadata byte per slot,
+// the distance from the home slot, and only calls EQ for slots with the same home. Removal shifts entries back so no
+// tombstones are left and lookups of missing keys stay short.
+
+static inline size_t tds_hmap_capacity_fit(size_t count)
 {
-    if (out_socket == NULL || *out_socket != TCS_SOCKET_INVALID)
-        return TCS_ERROR_INVALID_ARGUMENT;
-    if (family.native == -1) // sentinel for unsupported families (e.g. TCS_FAMILY_PACKET on non-Linux)
-        return TCS_ERROR_NOT_SUPPORTED;
-#if TCS_HAS_AF_PACKET
-    int native_protocol = (family.native == AF_PACKET) ? (int)htons(protocol) : (int)protocol;
-#else
-    int native_protocol = (int)protocol;
-#endif
-    *out_socket = socket(family.native, type.native, native_protocol);
+    const size_t MINIMUM_CAPACITY = 8;
 
-    if (*out_socket != -1) // Same as TCS_NULLSOCKET
-        return TCS_SUCCESS;
-    else
-        return errno2retcode(errno);
+    // At most three quarters full
+    size_t c = MINIMUM_CAPACITY;
+    while (c - c / 4 < count)
+        c *= 2;
+    return c;
 }
 
-// tcs_socket_tcp() is defined in tinycsocket_common.c
-// tcs_socket_tcp_str() is defined in tinycsocket_common.c
-// tcs_socket_udp() is defined in tinycsocket_common.c
-// tcs_socket_udp_str() is defined in tinycsocket_common.c
-// tcs_socket_packet() is defined in tinycsocket_common.c
-// tcs_socket_packet_str() is defined in tinycsocket_common.c
+#define TDS_HMAP_IMPL(KEY_TYPE, VALUE_TYPE, NAME, HASH, EQ)                                                            \
+    typedef KEY_TYPE TdsHMapKey_##NAME;                                                                                \
+    typedef VALUE_TYPE TdsHMapValue_##NAME;                                                                            \
+    struct TdsHMap_##NAME                                                                                              \
+    {                                                                                                                  \
+        TdsHMapKey_##NAME* keys;                                                                                       \
+        TdsHMapValue_##NAME* values;                                                                                   \
+        uint8_t* distances; /* Probe distance + 1 per slot, 0 for empty */                                             \
+        size_t count;                                                                                                  \
+        size_t capacity;                                                                                               \
+        uint64_t seed;                                                                                                 \
+    };                                                                                                                 \
+                                                                                                                       \
+    TDS_UNUSED static inline int tds_hmap_##NAME##_create(struct TdsHMap_##NAME* map, uint64_t seed)                   \
+    {                                                                                                                  \
+        memset(map, 0, sizeof(struct TdsHMap_##NAME));                                                                 \
+        map->seed = seed;                                                                                              \
+        return 0;                                                                                                      \
+    }                                                                                                                  \
+    TDS_UNUSED static inline int tds_hmap_##NAME##_destroy(struct TdsHMap_##NAME* map)                                 \
+    {                                                                                                                  \
+        TDS_FREE(map->keys);                                                                                           \
+        TDS_FREE(map->values);                                                                                         \
+        TDS_FREE(map->distances);                                                                                      \
+        memset(map, 0, sizeof(struct TdsHMap_##NAME));                                                                 \
+        return 0;                                                                                                      \
+    }                                                                                                                  \
+    TDS_UNUSED static inline size_t tds_hmap_##NAME##_find(                                                            \
+        const struct TdsHMap_##NAME* map, const TdsHMapKey_##NAME* key)                                                \
+    {                                                                                                                  \
+        if (map->count == 0)                                                                                           \
+            return map->capacity;                                                                                      \
+        size_t mask = map->capacity - 1;                                                                               \
+        size_t i = (size_t)HASH(key, map->seed) & mask;                                                                \
+        /* A slot closer to its home than we are to ours ends the search, our key would have taken it */               \
+        for (uint8_t distance = 1; map->distances[i] >= distance; ++distance, i = (i + 1) & mask)                      \
+        {                                                                                                              \
+            if (map->distances[i] == distance && EQ(&map->keys[i], key))                                               \
+                return i;                                                                                              \
+        }                                                                                                              \
+        return map->capacity;                                                                                          \
+    }                                                                                                                  \
+    /* Places a key known to be missing starting at its hash, or with is_dry_run only checks that it can be placed. */ \
+    /* Returns 1 without touching the map if a probe distance would not fit the metadata byte. */                      \
+    TDS_UNUSED static inline int tds_hmap_##NAME##_place(struct TdsHMap_##NAME* map,                                   \
+                                                         uint64_t hash,                                                \
+                                                         TdsHMapKey_##NAME key,                                        \
+                                                         TdsHMapValue_##NAME value,                                    \
+                                                         int is_dry_run)                                               \
+    {                                                                                                                  \
+        if (!is_dry_run && tds_hmap_##NAME##_place(map, hash, key, value, 1) != 0)                                     \
+            return 1;                                                                                                  \
+        size_t mask = map->capacity - 1;                                                                               \
+        size_t i = (size_t)hash & mask;                                                                                \
+        for (uint8_t distance = 1; distance < UINT8_MAX; ++distance, i = (i + 1) & mask)                               \
+        {                                                                                                              \
+            if (map->distances[i] == 0)                                                                                \
+            {                                                                                                          \
+                if (!is_dry_run)                                                                                       \
+                {                                                                                                      \
+                    map->keys[i] = key;                                                                                \
+                    map->values[i] = value;                                                                            \
+                    map->distances[i] = distance;                                                                      \
+                }                                                                                                      \
+                return 0;                                                                                              \
+            }                                                                                                          \
+            if (map->distances[i] < distance)                                                                          \
+            {                                                                                                          \
+                /* Robin Hood: take the slot from the entry closer to its home and continue placing that one */        \
+                uint8_t displaced_distance = map->distances[i];                                                        \
+                if (!is_dry_run)                                                                                       \
+                {                                                                                                      \
+                    TdsHMapKey_##NAME displaced_key = map->keys[i];                                                    \
+                    TdsHMapValue_##NAME displaced_value = map->values[i];                                              \
+                    map->keys[i] = key;                                                                                \
+                    map->values[i] = value;                                                                            \
+                    map->distances[i] = distance;                                                                      \
+                    key = displaced_key;                                                                               \
+                    value = displaced_value;                                                                           \
+                }                                                                                                      \
+                distance = displaced_distance;                                                                         \
+            }                                                                                                          \
+        }                                                                                                              \
+        return 1;                                                                                                      \
+    }                                                                                                                  \
+    TDS_UNUSED static inline int tds_hmap_##NAME##_rehash(struct TdsHMap_##NAME* map, size_t new_capacity)             \
+    {                                                                                                                  \
+        struct TdsHMap_##NAME grown = *map;                                                                            \
+        grown.keys = (TdsHMapKey_##NAME*)TDS_MALLOC(new_capacity * sizeof(TdsHMapKey_##NAME));                         \
+        grown.values = (TdsHMapValue_##NAME*)TDS_MALLOC(new_capacity * sizeof(TdsHMapValue_##NAME));                   \
+        grown.distances = (uint8_t*)TDS_MALLOC(new_capacity);                                                          \
+        grown.capacity = new_capacity;                                                                                 \
+        int sts = grown.keys == NULL || grown.values == NULL || grown.distances == NULL ? -1 : 0;                      \
+        if (sts == 0)                                                                                                  \
+            memset(grown.distances, 0, new_capacity);                                                                  \
+        for (size_t i = 0; sts == 0 && i < map->capacity; ++i)                                                         \
+        {                                                                                                              \
+            if (map->distances[i] != 0)                                                                                \
+                sts = tds_hmap_##NAME##_place(                                                                         \
+                    &grown, HASH(&map->keys[i], map->seed), map->keys[i], map->values[i], 0);                          \
+        }                                                                                                              \
+        if (sts != 0)                                                                                                  \
+        {                                                                                                              \
+            TDS_FREE(grown.keys);                                                                                      \
+            TDS_FREE(grown.values);                                                                                    \
+            TDS_FREE(grown.distances);                                                                                 \
+            /* Probe sequences too long for the metadata byte, a sparser table spreads them out unless HASH is bad */  \
+            if (sts == 1 && new_capacity / 64 <= map->count)                                                           \
+                return tds_hmap_##NAME##_rehash(map, new_capacity * 2);                                                \
+            return -1;                                                                                                 \
+        }                                                                                                              \
+        TDS_FREE(map->keys);                                                                                           \
+        TDS_FREE(map->values);                                                                                         \
+        TDS_FREE(map->distances);                                                                                      \
+        *map = grown;                                                                                                  \
+        return 0;                                                                                                      \
+    }                                                                                                                  \
+    TDS_UNUSED static inline int tds_hmap_##NAME##_reserve(struct TdsHMap_##NAME* map, size_t count)                   \
+    {                                                                                                                  \
+        size_t new_capacity = tds_hmap_capacity_fit(count);                                                            \
+        if (new_capacity <= map->capacity)                                                                             \
+            return 0;                                                                                                  \
+        return tds_hmap_##NAME##_rehash(map, new_capacity);                                                            \
+    }                                                                                                                  \
+    TDS_UNUSED static inline TdsHMapValue_##NAME* tds_hmap_##NAME##_get(                                               \
+        const struct TdsHMap_##NAME* map, const TdsHMapKey_##NAME* key)                                                \
+    {                                                                                                                  \
+        size_t i = tds_hmap_##NAME##_find(map, key);                                                                   \
+        return i < map->capacity ? &map->values[i] : NULL;                                                             \
+    }                                                                                                                  \
+    TDS_UNUSED static inline int tds_hmap_##NAME##_set(                                                                \
+        struct TdsHMap_##NAME* map, const TdsHMapKey_##NAME* key, const TdsHMapValue_##NAME* value)                    \
+    {                                                                                                                  \
+        size_t i = tds_hmap_##NAME##_find(map, key);                                                                   \
+        if (i < map->capacity)                                                                                         \
+        {                                                                                                              \
+            map->values[i] = *value;                                                                                   \
+            return 0;                                                                                                  \
+        }                                                                                                              \
+        if (tds_hmap_##NAME##_reserve(map, map->count + 1) != 0)                                                       \
+            return -1;                                                                                                 \
+        uint64_t hash = HASH(key, map->seed);                                                                          \
+        while (tds_hmap_##NAME##_place(map, hash, *key, *value, 0) != 0)                                               \
+        {                                                                                                              \
+            if (map->capacity / 64 > map->count || tds_hmap_##NAME##_rehash(map, map->capacity * 2) != 0)              \
+                return -1;                                                                                             \
+        }                                                                                                              \
+        map->count++;                                                                                                  \
+        return 0;                                                                                                      \
+    }                                                                                                                  \
+    TDS_UNUSED static inline int tds_hmap_##NAME##_remove(struct TdsHMap_##NAME* map, const TdsHMapKey_##NAME* key)    \
+    {                                                                                                                  \
+        size_t i = tds_hmap_##NAME##_find(map, key);                                                                   \
+        if (i == map->capacity)                                                                                        \
+            return -1;                                                                                                 \
+        size_t mask = map->capacity - 1;                                                                               \
+        /* Backward shift instead of a tombstone, every following entry away from home moves one step closer */        \
+        for (size_t next = (i + 1) & mask; map->distances[next] > 1; i = next, next = (next + 1) & mask)               \
+        {                                                                                                              \
+            map->keys[i] = map->keys[next];                                                                            \
+            map->values[i] = map->values[next];                                                                        \
+            map->distances[i] = (uint8_t)(map->distances[next] - 1);                                                   \
+        }                                                                                                              \
+        map->distances[i] = 0;                                                                                         \
+        map->count--;                                                                                                  \
+        return 0;                                                                                                      \
+    }
 
-TcsResult tcs_close(TcsSocket* socket)
+
+// Tiny Data Structures Atomics
+// Just enough atomics on a size_t for the rings below. C11 <stdatomic.h> when compiled as C11, the __atomic builtins
+// on GCC and Clang (C++ and C99 included) and volatile plus barriers on MSVC. TDS_HAS_ATOMICS is left undefined on
+// other compilers and the rings are not available there.
+
+#if !defined(__cplusplus) && defined(__STDC_VERSION__) && __STDC_VERSION__ >= 201112L && !defined(__STDC_NO_ATOMICS__)
+#include <stdatomic.h>
+#define TDS_HAS_ATOMICS
+typedef _Atomic size_t TdsAtomicSize;
+
+static inline size_t tds_atomic_load_relaxed(TdsAtomicSize* atomic)
 {
-    if (socket == NULL || *socket == TCS_SOCKET_INVALID)
-        return TCS_ERROR_INVALID_ARGUMENT;
+    return atomic_load_explicit(atomic, memory_order_relaxed);
+}
 
-    if (close(*socket) == 0)
-    {
-        *socket = TCS_SOCKET_INVALID;
-        return TCS_SUCCESS;
-    }
-    else
-    {
-        return errno2retcode(errno);
-    }
+static inline size_t tds_atomic_load_acquire(TdsAtomicSize* atomic)
+{
+    return atomic_load_explicit(atomic, memory_order_acquire);
 }
 
-// ######## Socket Operations ########
+static inline void tds_atomic_store_relaxed(TdsAtomicSize* atomic, size_t value)
+{
+    atomic_store_explicit(atomic, value, memory_order_relaxed);
+}
 
-TcsResult tcs_bind(TcsSocket socket, const struct TcsAddress* address)
+static inline void tds_atomic_store_release(TdsAtomicSize* atomic, size_t value)
 {
-    if (socket == TCS_SOCKET_INVALID)
-        return TCS_ERROR_INVALID_ARGUMENT;
-    if (address == NULL)
-        return TCS_ERROR_INVALID_ARGUMENT;
+    atomic_store_explicit(atomic, value, memory_order_release);
+}
 
-    struct sockaddr_storage native_sockaddr;
-    memset(&native_sockaddr, 0, sizeof native_sockaddr);
-    socklen_t sockaddr_size = 0;
-    TcsResult convert_address_status = sockaddr2native(address, &native_sockaddr, &sockaddr_size);
-    if (convert_address_status != TCS_SUCCESS)
-        return convert_address_status;
+// On failure expected is updated with the current value
+static inline int tds_atomic_compare_exchange(TdsAtomicSize* atomic, size_t* expected, size_t desired)
+{
+    return atomic_compare_exchange_weak_explicit(atomic, expected, desired, memory_order_acq_rel, memory_order_relaxed);
+}
+#elif defined(__GNUC__)
+#define TDS_HAS_ATOMICS
+typedef size_t TdsAtomicSize;
 
-    if (bind(socket, (struct sockaddr*)&native_sockaddr, sockaddr_size) != -1)
-        return TCS_SUCCESS;
-    else
-        return errno2retcode(errno);
+static inline size_t tds_atomic_load_relaxed(TdsAtomicSize* atomic)
+{
+    return __atomic_load_n(atomic, __ATOMIC_RELAXED);
 }
 
-TcsResult tcs_connect(TcsSocket socket, const struct TcsAddress* address)
+static inline size_t tds_atomic_load_acquire(TdsAtomicSize* atomic)
 {
-    if (socket == TCS_SOCKET_INVALID)
-        return TCS_ERROR_INVALID_ARGUMENT;
-    if (address == NULL)
-        return TCS_ERROR_INVALID_ARGUMENT;
-
-    struct sockaddr_storage native_sockaddr;
-    memset(&native_sockaddr, 0, sizeof native_sockaddr);
-    socklen_t sockaddr_size = 0;
-    TcsResult convert_address_status = sockaddr2native(address, &native_sockaddr, &sockaddr_size);
-    if (convert_address_status != TCS_SUCCESS)
-        return convert_address_status;
-
-    if (connect(socket, (const struct sockaddr*)&native_sockaddr, sockaddr_size) == 0)
-        return TCS_SUCCESS;
-    else
-        return errno2retcode(errno);
+    return __atomic_load_n(atomic, __ATOMIC_ACQUIRE);
 }
 
-// tcs_connect_str() is defined in tinycsocket_common.c
-
-TcsResult tcs_listen(TcsSocket socket, int backlog)
+static inline void tds_atomic_store_relaxed(TdsAtomicSize* atomic, size_t value)
 {
-    if (socket == TCS_SOCKET_INVALID)
-        return TCS_ERROR_INVALID_ARGUMENT;
-
-    if (backlog < 1 || backlog > TCS_BACKLOG_MAX)
-        backlog = TCS_BACKLOG_MAX;
+    __atomic_store_n(atomic, value, __ATOMIC_RELAXED);
+}
 
-    if (listen(socket, backlog) == 0)
-        return TCS_SUCCESS;
-    else
-        return errno2retcode(errno);
+static inline void tds_atomic_store_release(TdsAtomicSize* atomic, size_t value)
+{
+    __atomic_store_n(atomic, value, __ATOMIC_RELEASE);
 }
 
-TcsResult tcs_accept(TcsSocket listener, TcsSocket* out_socket, struct TcsAddress* out_address)
+// On failure expected is updated with the current value
+static inline int tds_atomic_compare_exchange(TdsAtomicSize* atomic, size_t* expected, size_t desired)
 {
-    if (listener == TCS_SOCKET_INVALID || out_socket == NULL || *out_socket != TCS_SOCKET_INVALID)
-        return TCS_ERROR_INVALID_ARGUMENT;
+    return __atomic_compare_exchange_n(atomic, expected, desired, 1, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED);
+}
+#elif defined(_MSC_VER)
+#include <intrin.h>
+#define TDS_HAS_ATOMICS
+typedef volatile size_t TdsAtomicSize;
 
-    if (out_address != NULL)
-        *out_address = TCS_ADDRESS_NONE;
+// x86 and x64 only reorder stores after loads, ARM needs a real barrier for acquire and release
+static inline void tds_atomic_barrier(void)
+{
+#if defined(_M_ARM64)
+    __dmb(_ARM64_BARRIER_ISH);
+#elif defined(_M_ARM)
+    __dmb(_ARM_BARRIER_ISH);
+#else
+    _ReadWriteBarrier();
+#endif
+}
 
-    struct sockaddr_storage native_sockaddr;
-    memset(&native_sockaddr, 0, sizeof native_sockaddr);
-    socklen_t sockaddr_size = sizeof native_sockaddr;
+static inline size_t tds_atomic_load_relaxed(TdsAtomicSize* atomic)
+{
+    return *atomic;
+}
 
-    *out_socket = accept(listener, (struct sockaddr*)&native_sockaddr, &sockaddr_size);
-    if (*out_socket != -1)
-    {
-        if (out_address != NULL)
-        {
-            TcsResult convert_address_status = native2sockaddr((struct sockaddr*)&native_sockaddr, out_address);
-            if (convert_address_status != TCS_SUCCESS)
-                return convert_address_status;
-        }
-        return TCS_SUCCESS;
-    }
-    else
-    {
-        *out_socket = TCS_SOCKET_INVALID;
-        return errno2retcode(errno);
-    }
+static inline size_t tds_atomic_load_acquire(TdsAtomicSize* atomic)
+{
+    size_t value = *atomic;
+    tds_atomic_barrier();
+    return value;
 }
 
-TcsResult tcs_shutdown(TcsSocket socket, TcsShutdownDirection direction)
+static inline void tds_atomic_store_relaxed(TdsAtomicSize* atomic, size_t value)
 {
-    const int LUT[] = {SHUT_RD, SHUT_WR, SHUT_RDWR};
+    *atomic = value;
+}
 
-    if (socket == TCS_SOCKET_INVALID)
-        return TCS_ERROR_INVALID_ARGUMENT;
-    if (direction < 0 || direction > 2)
-        return TCS_ERROR_INVALID_ARGUMENT;
+static inline void tds_atomic_store_release(TdsAtomicSize* atomic, size_t value)
+{
+    tds_atomic_barrier();
+    *atomic = value;
+}
 
-    const int how = LUT[direction];
-    if (shutdown(socket, how) == 0)
-        return TCS_SUCCESS;
-    else
-        return errno2retcode(errno);
+// On failure expected is updated with the current value
+static inline int tds_atomic_compare_exchange(TdsAtomicSize* atomic, size_t* expected, size_t desired)
+{
+#if defined(_WIN64)
+    size_t previous =
+        (size_t)_InterlockedCompareExchange64((volatile __int64*)atomic, (__int64)desired, (__int64)*expected);
+#else
+    size_t previous = (size_t)_InterlockedCompareExchange((volatile long*)atomic, (long)desired, (long)*expected);
+#endif
+    if (previous == *expected)
+        return 1;
+    *expected = previous;
+    return 0;
 }
+#endif
 
-// ######## Data Transfer ########
+#ifndef TDS_CACHE_LINE_SIZE
+#define TDS_CACHE_LINE_SIZE 64
+#endif
 
-TcsResult tcs_send(TcsSocket socket, const uint8_t* buffer, size_t buffer_size, uint32_t flags, size_t* sent_size)
+static inline size_t tds_ring_capacity_fit(size_t capacity)
 {
-    if (socket == TCS_SOCKET_INVALID)
-        return TCS_ERROR_INVALID_ARGUMENT;
-
-    if (sent_size != NULL)
-        *sent_size = 0;
+    size_t c = 1;
+    while (c < capacity)
+        c *= 2;
+    return c;
+}
 
-    if (buffer == NULL || buffer_size == 0)
-        return TCS_ERROR_INVALID_ARGUMENT;
+#ifdef TDS_HAS_ATOMICS
 
-    // Send all
-    if (flags & TCS_MSG_SENDALL)
-    {
-        uint32_t new_flags = flags & ~TCS_MSG_SENDALL; // For recursive call
-        size_t left = buffer_size;
-        const uint8_t* iterator = buffer;
+// Tiny Data Structures Single Producer Single Consumer Ring Implementation
+// Bounded lock-free queue for exactly one pushing and one popping thread. The capacity is rounded up to a power of two
+// and the free running head and tail are kept on their own cache lines. Each side caches the last seen index of the
+// other side and only reloads it when the ring looks full or empty. push_many and pop_many move as many items as
+// there is room for and return how many that was.
 
-        while (left > 0)
-        {
-            size_t sent = 0;
-            TcsResult sts = tcs_send(socket, iterator, left, new_flags, &sent);
-            if (sent_size != NULL)
-                *sent_size += sent;
-            if (sts != TCS_SUCCESS)
-                return sts;
-            left -= sent;
-            iterator += sent;
-        }
-        return TCS_SUCCESS;
+#define TDS_SPSC_RING_IMPL(TYPE, NAME)                                                                                 \
+    struct TdsSpscRing_##NAME                                                                                          \
+    {                                                                                                                  \
+        TYPE* data;                                                                                                    \
+        size_t capacity;                                                                                               \
+        char shared_padding[TDS_CACHE_LINE_SIZE];                                                                      \
+        TdsAtomicSize head; /* Written by the consumer */                                                              \
+        size_t cached_tail;                                                                                            \
+        char head_padding[TDS_CACHE_LINE_SIZE];                                                                        \
+        TdsAtomicSize tail; /* Written by the producer */                                                              \
+        size_t cached_head;                                                                                            \
+        char tail_padding[TDS_CACHE_LINE_SIZE];                                                                        \
+    };                                                                                                                 \
+                                                                                                                       \
+    TDS_UNUSED static inline int tds_spsc_ring_##NAME##_create(struct TdsSpscRing_##NAME* ring, size_t capacity)       \
+    {                                                                                                                  \
+        memset(ring, 0, sizeof(struct TdsSpscRing_##NAME));                                                            \
+        if (capacity == 0)                                                                                             \
+            return -1;                                                                                                 \
+        ring->capacity = tds_ring_capacity_fit(capacity);                                                              \
+        ring->data = (TYPE*)TDS_MALLOC(ring->capacity * sizeof(TYPE));                                                 \
+        if (ring->data == NULL)                                                                                        \
+            return -1;                                                                                                 \
+        tds_atomic_store_relaxed(&ring->head, 0);                                                                      \
+        tds_atomic_store_relaxed(&ring->tail, 0);                                                                      \
+        return 0;                                                                                                      \
+    }                                                                                                                  \
+    TDS_UNUSED static inline int tds_spsc_ring_##NAME##_destroy(struct TdsSpscRing_##NAME* ring)                       \
+    {                                                                                                                  \
+        TDS_FREE(ring->data);                                                                                          \
+        memset(ring, 0, sizeof(struct TdsSpscRing_##NAME));                                                            \
+        return 0;                                                                                                      \
+    }                                                                                                                  \
+    TDS_UNUSED static inline size_t tds_spsc_ring_##NAME##_push_many(                                                  \
+        struct TdsSpscRing_##NAME* ring, const TYPE* items, size_t count)                                              \
+    {                                                                                                                  \
+        size_t tail = tds_atomic_load_relaxed(&ring->tail);                                                            \
+        if (ring->capacity - (tail - ring->cached_head) < count)                                                       \
+            ring->cached_head = tds_atomic_load_acquire(&ring->head);                                                  \
+        size_t free_count = ring->capacity - (tail - ring->cached_head);                                               \
+        if (count > free_count)                                                                                        \
+            count = free_count;                                                                                        \
+        size_t mask = ring->capacity - 1;                                                                              \
+        for (size_t i = 0; i < count; ++i)                                                                             \
+            ring->data[(tail + i) & mask] = items[i];                                                                  \
+        tds_atomic_store_release(&ring->tail, tail + count);                                                           \
+        return count;                                                                                                  \
+    }                                                                                                                  \
+    TDS_UNUSED static inline size_t tds_spsc_ring_##NAME##_pop_many(                                                   \
+        struct TdsSpscRing_##NAME* ring, TYPE* items, size_t max_count)                                                \
+    {                                                                                                                  \
+        size_t head = tds_atomic_load_relaxed(&ring->head);                                                            \
+        if (ring->cached_tail - head < max_count)                                                                      \
+            ring->cached_tail = tds_atomic_load_acquire(&ring->tail);                                                  \
+        size_t count = ring->cached_tail - head;                                                                       \
+        if (count > max_count)                                                                                         \
+            count = max_count;                                                                                         \
+        size_t mask = ring->capacity - 1;                                                                              \
+        for (size_t i = 0; i < count; ++i)                                                                             \
+            items[i] = ring->data[(head + i) & mask];                                                                  \
+        tds_atomic_store_release(&ring->head, head + count);                                                           \
+        return count;                                                                                                  \
+    }                                                                                                                  \
+    TDS_UNUSED static inline int tds_spsc_ring_##NAME##_push(struct TdsSpscRing_##NAME* ring, const TYPE* item)        \
+    {                                                                                                                  \
+        return tds_spsc_ring_##NAME##_push_many(ring, item, 1) == 1 ? 0 : -1;                                          \
+    }                                                                                                                  \
+    TDS_UNUSED static inline int tds_spsc_ring_##NAME##_pop(struct TdsSpscRing_##NAME* ring, TYPE* item)               \
+    {                                                                                                                  \
+        return tds_spsc_ring_##NAME##_pop_many(ring, item, 1) == 1 ? 0 : -1;                                           \
+    }                                                                                                                  \
+    /* Exact from either side when the other is idle, otherwise a snapshot */                                          \
+    TDS_UNUSED static inline size_t tds_spsc_ring_##NAME##_count(struct TdsSpscRing_##NAME* ring)                      \
+    {                                                                                                                  \
+        size_t head = tds_atomic_load_acquire(&ring->head);                                                            \
+        return tds_atomic_load_acquire(&ring->tail) - head;                                                            \
     }
-    else // Send
-    {
-        ssize_t send_status = send(socket, (const char*)buffer, buffer_size, TCS_DEFAULT_SEND_FLAGS | (int)flags);
-        if (send_status >= 0)
-        {
-            if (sent_size != NULL)
-                *sent_size = (size_t)send_status;
-            return TCS_SUCCESS;
-        }
-        else
-        {
-            if (sent_size != NULL)
-                *sent_size = 0;
-            return errno2retcode(errno);
-        }
+
+// Tiny Data Structures Multiple Producer Single Consumer Ring Implementation
+// Bounded lock-free queue for any number of pushing threads and one popping thread. Every slot carries a sequence
+// number telling which lap it is ready for, producers claim a run of free slots with one compare exchange on the tail
+// and publish each slot by bumping its sequence, so a slow producer only holds back the consumer at its own slots.
+// The capacity is rounded up to a power of two and the tail and head are kept on their own cache lines.
+
+#define TDS_MPSC_RING_IMPL(TYPE, NAME)                                                                                 \
+    struct TdsMpscRingSlot_##NAME                                                                                      \
+    {                                                                                                                  \
+        TdsAtomicSize sequence;                                                                                        \
+        TYPE item;                                                                                                     \
+    };                                                                                                                 \
+                                                                                                                       \
+    struct TdsMpscRing_##NAME                                                                                          \
+    {                                                                                                                  \
+        struct TdsMpscRingSlot_##NAME* slots;                                                                          \
+        size_t capacity;                                                                                               \
+        char shared_padding[TDS_CACHE_LINE_SIZE];                                                                      \
+        TdsAtomicSize head; /* Written by the consumer */                                                              \
+        char head_padding[TDS_CACHE_LINE_SIZE];                                                                        \
+        TdsAtomicSize tail; /* Claimed by the producers */                                                             \
+        char tail_padding[TDS_CACHE_LINE_SIZE];                                                                        \
+    };                                                                                                                 \
+                                                                                                                       \
+    TDS_UNUSED static inline int tds_mpsc_ring_##NAME##_create(struct TdsMpscRing_##NAME* ring, size_t capacity)       \
+    {                                                                                                                  \
+        memset(ring, 0, sizeof(struct TdsMpscRing_##NAME));                                                            \
+        if (capacity == 0)                                                                                             \
+            return -1;                                                                                                 \
+        ring->capacity = tds_ring_capacity_fit(capacity);                                                              \
+        ring->slots =                                                                                                  \
+            (struct TdsMpscRingSlot_##NAME*)TDS_MALLOC(ring->capacity * sizeof(struct TdsMpscRingSlot_##NAME));        \
+        if (ring->slots == NULL)                                                                                       \
+            return -1;                                                                                                 \
+        for (size_t i = 0; i < ring->capacity; ++i)                                                                    \
+            tds_atomic_store_relaxed(&ring->slots[i].sequence, i);                                                     \
+        tds_atomic_store_relaxed(&ring->head, 0);                                                                      \
+        tds_atomic_store_relaxed(&ring->tail, 0);                                                                      \
+        return 0;                                                                                                      \
+    }                                                                                                                  \
+    TDS_UNUSED static inline int tds_mpsc_ring_##NAME##_destroy(struct TdsMpscRing_##NAME* ring)                       \
+    {                                                                                                                  \
+        TDS_FREE(ring->slots);                                                                                         \
+        memset(ring, 0, sizeof(struct TdsMpscRing_##NAME));                                                            \
+        return 0;                                                                                                      \
+    }                                                                                                                  \
+    TDS_UNUSED static inline size_t tds_mpsc_ring_##NAME##_push_many(                                                  \
+        struct TdsMpscRing_##NAME* ring, const TYPE* items, size_t count)                                              \
+    {                                                                                                                  \
+        size_t mask = ring->capacity - 1;                                                                              \
+        size_t tail = tds_atomic_load_relaxed(&ring->tail);                                                            \
+        size_t claimed = 0;                                                                                            \
+        for (;;)                                                                                                       \
+        {                                                                                                              \
+            /* The consumer frees slots in order, so the free slots after the tail are a prefix */                     \
+            claimed = 0;                                                                                               \
+            while (claimed < count && claimed < ring->capacity)                                                        \
+            {                                                                                                          \
+                size_t sequence = tds_atomic_load_acquire(&ring->slots[(tail + claimed) & mask].sequence);             \
+                if (sequence != tail + claimed)                                                                        \
+                    break;                                                                                             \
+                claimed++;                                                                                             \
+            }                                                                                                          \
+            if (claimed == 0)                                                                                          \
+            {                                                                                                          \
+                /* Either full, or another producer moved the tail since we loaded it */                               \
+                size_t sequence = tds_atomic_load_acquire(&ring->slots[tail & mask].sequence);                         \
+                size_t current_tail = tds_atomic_load_relaxed(&ring->tail);                                            \
+                if ((ptrdiff_t)(sequence - tail) < 0 && current_tail == tail)                                          \
+                    return 0;                                                                                          \
+                tail = current_tail;                                                                                   \
+                continue;                                                                                              \
+            }                                                                                                          \
+            if (tds_atomic_compare_exchange(&ring->tail, &tail, tail + claimed))                                       \
+                break;                                                                                                 \
+        }                                                                                                              \
+        for (size_t i = 0; i < claimed; ++i)                                                                           \
+        {                                                                                                              \
+            struct TdsMpscRingSlot_##NAME* slot = &ring->slots[(tail + i) & mask];                                     \
+            slot->item = items[i];                                                                                     \
+            tds_atomic_store_release(&slot->sequence, tail + i + 1);                                                   \
+        }                                                                                                              \
+        return claimed;                                                                                                \
+    }                                                                                                                  \
+    TDS_UNUSED static inline size_t tds_mpsc_ring_##NAME##_pop_many(                                                   \
+        struct TdsMpscRing_##NAME* ring, TYPE* items, size_t max_count)                                                \
+    {                                                                                                                  \
+        size_t mask = ring->capacity - 1;                                                                              \
+        size_t head = tds_atomic_load_relaxed(&ring->head);                                                            \
+        size_t count = 0;                                                                                              \
+        while (count < max_count)                                                                                      \
+        {                                                                                                              \
+            struct TdsMpscRingSlot_##NAME* slot = &ring->slots[(head + count) & mask];                                 \
+            if (tds_atomic_load_acquire(&slot->sequence) != head + count + 1)                                          \
+                break;                                                                                                 \
+            items[count] = slot->item;                                                                                 \
+            /* Ready for the producers one lap later */                                                                \
+            tds_atomic_store_release(&slot->sequence, head + count + ring->capacity);                                  \
+            count++;                                                                                                   \
+        }                                                                                                              \
+        tds_atomic_store_release(&ring->head, head + count);                                                           \
+        return count;                                                                                                  \
+    }                                                                                                                  \
+    TDS_UNUSED static inline int tds_mpsc_ring_##NAME##_push(struct TdsMpscRing_##NAME* ring, const TYPE* item)        \
+    {                                                                                                                  \
+        return tds_mpsc_ring_##NAME##_push_many(ring, item, 1) == 1 ? 0 : -1;                                          \
+    }                                                                                                                  \
+    TDS_UNUSED static inline int tds_mpsc_ring_##NAME##_pop(struct TdsMpscRing_##NAME* ring, TYPE* item)               \
+    {                                                                                                                  \
+        return tds_mpsc_ring_##NAME##_pop_many(ring, item, 1) == 1 ? 0 : -1;                                           \
+    }                                                                                                                  \
+    /* Counts claimed slots, including ones a producer is still writing */                                             \
+    TDS_UNUSED static inline size_t tds_mpsc_ring_##NAME##_count(struct TdsMpscRing_##NAME* ring)                      \
+    {                                                                                                                  \
+        size_t head = tds_atomic_load_acquire(&ring->head);                                                            \
+        return tds_atomic_load_acquire(&ring->tail) - head;                                                            \
     }
-}
 
-TcsResult tcs_send_to(TcsSocket socket,
-                      const uint8_t* buffer,
-                      size_t buffer_size,
-                      uint32_t flags,
-                      const struct TcsAddress* destination_address,
-                      size_t* sent_size)
-{
-    if (socket == TCS_SOCKET_INVALID)
-        return TCS_ERROR_INVALID_ARGUMENT;
-    if (buffer == NULL && buffer_size > 0)
-        return TCS_ERROR_INVALID_ARGUMENT;
-    if (destination_address == NULL)
-        return TCS_ERROR_INVALID_ARGUMENT;
+#endif
 
-    if (flags & TCS_MSG_SENDALL)
-        return TCS_ERROR_NOT_IMPLEMENTED;
+// Tiny Data Structures Pool Implementation
+// Fixed size object allocator for objects allocated and freed at high rates. Objects are carved from chunks of
+// chunk_capacity objects and freed ones go on an intrusive free list, so alloc and free are O(1) and only a new chunk
+// calls malloc, the first one on the first alloc. With max_capacity 0 the pool grows without bound, otherwise alloc
+// returns NULL at max_capacity objects. Objects are not zeroed and stay at the same address until freed, the chunks are
+// released by destroy. For a pool shared between threads every thread puts a TdsPoolCache_NAME, declared
+// TDS_THREAD_LOCAL, in front of it. The cache moves TDS_POOL_CACHE_BATCH objects at a time to and from the pool under a
+// spin lock. The plain alloc and free take no lock, do not mix them with the cached ones on a shared pool.
+
+#ifndef TDS_POOL_CACHE_BATCH
+#define TDS_POOL_CACHE_BATCH 32
+#endif
 
-    struct sockaddr_storage native_sockaddr;
-    memset(&native_sockaddr, 0, sizeof native_sockaddr);
-    socklen_t sockaddr_size = 0;
-    TcsResult convert_addr_status = sockaddr2native(destination_address, &native_sockaddr, &sockaddr_size);
-    if (convert_addr_status != TCS_SUCCESS)
-        return convert_addr_status;
+#ifndef TDS_THREAD_LOCAL
+#if defined(__cplusplus)
+#define TDS_THREAD_LOCAL thread_local
+#elif defined(__STDC_VERSION__) && __STDC_VERSION__ >= 201112L
+#define TDS_THREAD_LOCAL _Thread_local
+#elif defined(_MSC_VER)
+#define TDS_THREAD_LOCAL __declspec(thread)
+#else
+#define TDS_THREAD_LOCAL __thread
+#endif
+#endif
 
-    ssize_t sendto_status = sendto(socket,
-                                   (const char*)buffer,
-                                   buffer_size,
-                                   TCS_DEFAULT_SEND_FLAGS | (int)flags,
-                                   (const struct sockaddr*)&native_sockaddr,
-                                   sockaddr_size);
+#ifdef TDS_HAS_ATOMICS
+typedef TdsAtomicSize TdsPoolLock;
 
-    if (sendto_status >= 0)
-    {
-        if (sent_size != NULL)
-            *sent_size = (size_t)sendto_status;
-        return TCS_SUCCESS;
-    }
-    else
-    {
-        if (sent_size != NULL)
-            *sent_size = 0;
+#ifndef TDS_THREAD_YIELD
+#if defined(_WIN32)
+// windows.h is not included here for SwitchToThread(), so only tell the core that we are spinning
+#if defined(_M_ARM) || defined(_M_ARM64)
+#define TDS_THREAD_YIELD() __yield()
+#elif defined(_MSC_VER)
+#define TDS_THREAD_YIELD() _mm_pause()
+#else
+#define TDS_THREAD_YIELD() __builtin_ia32_pause()
+#endif
+#else
+#include <sched.h>
+#define TDS_THREAD_YIELD() sched_yield()
+#endif
+#endif
 
-        return errno2retcode(errno);
+static inline void tds_pool_lock(TdsPoolLock* lock)
+{
+    size_t unlocked = 0;
+    while (!tds_atomic_compare_exchange(lock, &unlocked, 1))
+    {
+        unlocked = 0;
+        TDS_THREAD_YIELD();
     }
 }
 
-TcsResult tcs_sendv(TcsSocket socket, const struct TcsIoVec* iov, size_t iov_length, uint32_t flags, size_t* sent_size)
+static inline void tds_pool_unlock(TdsPoolLock* lock)
 {
-    if (socket == TCS_SOCKET_INVALID || iov == NULL || iov_length == 0)
-        return TCS_ERROR_INVALID_ARGUMENT;
-
-    if (flags & TCS_MSG_SENDALL)
-        return TCS_ERROR_NOT_IMPLEMENTED;
-
-    if (iov_length > (size_t)tcs_iov_max)
-        return TCS_ERROR_INVALID_ARGUMENT;
-
-    struct iovec stack_iovec[TCS_CFG_SENDV_STACK_MAX];
-    struct iovec* my_iovec = stack_iovec;
-    struct iovec* heap_iovec = NULL;
+    tds_atomic_store_release(lock, 0);
+}
 
-    if (iov_length > TCS_CFG_SENDV_STACK_MAX)
-    {
-        heap_iovec = (struct iovec*)malloc(sizeof(struct iovec) * iov_length);
-        if (heap_iovec == NULL)
-            return TCS_ERROR_MEMORY;
-        my_iovec = heap_iovec;
+#define TDS_POOL_CACHE_IMPL(TYPE, NAME)                                                                                \
+    struct TdsPoolCache_##NAME                                                                                         \
+    {                                                                                                                  \
+        union TdsPoolSlot_##NAME* free_list;                                                                           \
+        size_t count;                                                                                                  \
+    };                                                                                                                 \
+                                                                                                                       \
+    /* Gives the cached objects back to the pool, call before the thread exits and before the pool is destroyed */     \
+    TDS_UNUSED static inline void tds_pool_##NAME##_cache_flush(                                                       \
+        struct TdsPool_##NAME* pool, struct TdsPoolCache_##NAME* cache)                                                \
+    {                                                                                                                  \
+        if (cache->count == 0)                                                                                         \
+            return;                                                                                                    \
+        union TdsPoolSlot_##NAME* last = cache->free_list;                                                             \
+        while (last->next != NULL)                                                                                     \
+            last = last->next;                                                                                         \
+        tds_pool_lock(&pool->lock);                                                                                    \
+        last->next = pool->free_list;                                                                                  \
+        pool->free_list = cache->free_list;                                                                            \
+        pool->count -= cache->count;                                                                                   \
+        tds_pool_unlock(&pool->lock);                                                                                  \
+        cache->free_list = NULL;                                                                                       \
+        cache->count = 0;                                                                                              \
+    }                                                                                                                  \
+    TDS_UNUSED static inline TYPE* tds_pool_##NAME##_cache_alloc(                                                      \
+        struct TdsPool_##NAME* pool, struct TdsPoolCache_##NAME* cache)                                                \
+    {                                                                                                                  \
+        if (cache->free_list == NULL)                                                                                  \
+        {                                                                                                              \
+            tds_pool_lock(&pool->lock);                                                                                \
+            for (size_t i = 0; i < TDS_POOL_CACHE_BATCH; ++i)                                                          \
+            {                                                                                                          \
+                union TdsPoolSlot_##NAME* slot = (union TdsPoolSlot_##NAME*)tds_pool_##NAME##_alloc(pool);             \
+                if (slot == NULL)                                                                                      \
+                    break;                                                                                             \
+                slot->next = cache->free_list;                                                                         \
+                cache->free_list = slot;                                                                               \
+                cache->count++;                                                                                        \
+            }                                                                                                          \
+            tds_pool_unlock(&pool->lock);                                                                              \
+            if (cache->free_list == NULL)                                                                              \
+                return NULL;                                                                                           \
+        }                                                                                                              \
+        union TdsPoolSlot_##NAME* slot = cache->free_list;                                                             \
+        cache->free_list = slot->next;                                                                                 \
+        cache->count--;                                                                                                \
+        return &slot->object;                                                                                          \
+    }                                                                                                                  \
+    TDS_UNUSED static inline void tds_pool_##NAME##_cache_free(                                                        \
+        struct TdsPool_##NAME* pool, struct TdsPoolCache_##NAME* cache, TYPE* object)                                  \
+    {                                                                                                                  \
+        union TdsPoolSlot_##NAME* slot = (union TdsPoolSlot_##NAME*)object;                                            \
+        slot->next = cache->free_list;                                                                                 \
+        cache->free_list = slot;                                                                                       \
+        cache->count++;                                                                                                \
+        /* Keep one batch for the next allocations and give the other back */                                          \
+        if (cache->count < 2 * TDS_POOL_CACHE_BATCH)                                                                   \
+            return;                                                                                                    \
+        union TdsPoolSlot_##NAME* first = cache->free_list;                                                            \
+        union TdsPoolSlot_##NAME* last = first;                                                                        \
+        for (size_t i = 1; i < TDS_POOL_CACHE_BATCH; ++i)                                                              \
+            last = last->next;                                                                                         \
+        cache->free_list = last->next;                                                                                 \
+        cache->count -= TDS_POOL_CACHE_BATCH;                                                                          \
+        tds_pool_lock(&pool->lock);                                                                                    \
+        last->next = pool->free_list;                                                                                  \
+        pool->free_list = first;                                                                                       \
+        pool->count -= TDS_POOL_CACHE_BATCH;                                                                           \
+        tds_pool_unlock(&pool->lock);                                                                                  \
     }
+#else
+typedef size_t TdsPoolLock;
+#define TDS_POOL_CACHE_IMPL(TYPE, NAME)
+#endif
 
-    for (size_t i = 0; i < iov_length; i++)
-    {
-        if (iov[i].buffer == NULL && iov[i].buffer_size > 0)
-        {
-            free(heap_iovec);
-            return TCS_ERROR_INVALID_ARGUMENT;
-        }
-        // We know that sendmsg() does not modify the data, so we can safely cast away the const here.
-#pragma GCC diagnostic push
-#pragma GCC diagnostic ignored "-Wcast-qual"
-        my_iovec[i].iov_base = (void*)iov[i].buffer;
-#pragma GCC diagnostic pop
+#define TDS_POOL_IMPL(TYPE, NAME)                                                                                      \
+    union TdsPoolSlot_##NAME                                                                                           \
+    {                                                                                                                  \
+        union TdsPoolSlot_##NAME* next;                                                                                \
+        TYPE object;                                                                                                   \
+    };                                                                                                                 \
+                                                                                                                       \
+    /* A pointer sized header, the compiler pads it to the alignment of the slots instead of a whole slot */           \
+    struct TdsPoolChunk_##NAME                                                                                         \
+    {                                                                                                                  \
+        struct TdsPoolChunk_##NAME* previous;                                                                          \
+        union TdsPoolSlot_##NAME slots[1];                                                                             \
+    };                                                                                                                 \
+                                                                                                                       \
+    struct TdsPool_##NAME                                                                                              \
+    {                                                                                                                  \
+        union TdsPoolSlot_##NAME* free_list;                                                                           \
+        struct TdsPoolChunk_##NAME* chunks; /* Newest first */                                                         \
+        union TdsPoolSlot_##NAME* fresh;  /* Never used slots in the newest chunk, handed out before growing */        \
+        union TdsPoolSlot_##NAME* fresh_end;                                                                           \
+        size_t chunk_capacity;                                                                                         \
+        size_t max_capacity;                                                                                           \
+        size_t capacity;                                                                                               \
+        size_t count; /* Objects handed out, including the ones in caches */                                           \
+        TdsPoolLock lock;                                                                                              \
+    };                                                                                                                 \
+                                                                                                                       \
+    TDS_UNUSED static inline int tds_pool_##NAME##_grow(struct TdsPool_##NAME* pool)                                   \
+    {                                                                                                                  \
+        size_t chunk_capacity = pool->chunk_capacity;                                                                  \
+        if (pool->max_capacity != 0 && pool->max_capacity - pool->capacity < chunk_capacity)                           \
+            chunk_capacity = pool->max_capacity - pool->capacity;                                                      \
+        if (chunk_capacity == 0)                                                                                       \
+            return -1;                                                                                                 \
+        struct TdsPoolChunk_##NAME* chunk = (struct TdsPoolChunk_##NAME*)TDS_MALLOC(                                   \
+            offsetof(struct TdsPoolChunk_##NAME, slots) + chunk_capacity * sizeof(union TdsPoolSlot_##NAME));          \
+        if (chunk == NULL)                                                                                             \
+            return -1;                                                                                                 \
+        chunk->previous = pool->chunks;                                                                                \
+        pool->chunks = chunk;                                                                                          \
+        pool->fresh = chunk->slots;                                                                                    \
+        pool->fresh_end = chunk->slots + chunk_capacity;                                                               \
+        pool->capacity += chunk_capacity;                                                                              \
+        return 0;                                                                                                      \
+    }                                                                                                                  \
+    TDS_UNUSED static inline int tds_pool_##NAME##_create(                                                             \
+        struct TdsPool_##NAME* pool, size_t chunk_capacity, size_t max_capacity)                                       \
+    {                                                                                                                  \
+        memset(pool, 0, sizeof(struct TdsPool_##NAME));                                                                \
+        if (chunk_capacity == 0)                                                                                       \
+            return -1;                                                                                                 \
+        pool->chunk_capacity = chunk_capacity;                                                                         \
+        pool->max_capacity = max_capacity;                                                                             \
+        return 0;                                                                                                      \
+    }                                                                                                                  \
+    TDS_UNUSED static inline int tds_pool_##NAME##_destroy(struct TdsPool_##NAME* pool)                                \
+    {                                                                                                                  \
+        while (pool->chunks != NULL)                                                                                   \
+        {                                                                                                              \
+            struct TdsPoolChunk_##NAME* previous = pool->chunks->previous;                                             \
+            TDS_FREE(pool->chunks);                                                                                    \
+            pool->chunks = previous;                                                                                   \
+        }                                                                                                              \
+        memset(pool, 0, sizeof(struct TdsPool_##NAME));                                                                \
+        return 0;                                                                                                      \
+    }                                                                                                                  \
+    TDS_UNUSED static inline TYPE* tds_pool_##NAME##_alloc(struct TdsPool_##NAME* pool)                                \
+    {                                                                                                                  \
+        union TdsPoolSlot_##NAME* slot = pool->free_list;                                                              \
+        if (slot != NULL)                                                                                              \
+            pool->free_list = slot->next;                                                                              \
+        else if (pool->fresh != pool->fresh_end || tds_pool_##NAME##_grow(pool) == 0)                                  \
+            slot = pool->fresh++;                                                                                      \
+        else                                                                                                           \
+            return NULL;                                                                                               \
+        pool->count++;                                                                                                 \
+        return &slot->object;                                                                                          \
+    }                                                                                                                  \
+    TDS_UNUSED static inline int tds_pool_##NAME##_free(struct TdsPool_##NAME* pool, TYPE* object)                     \
+    {                                                                                                                  \
+        if (object == NULL)                                                                                            \
+            return -1;                                                                                                 \
+        union TdsPoolSlot_##NAME* slot = (union TdsPoolSlot_##NAME*)object;                                            \
+        slot->next = pool->free_list;                                                                                  \
+        pool->free_list = slot;                                                                                        \
+        pool->count--;                                                                                                 \
+        return 0;                                                                                                      \
+    }                                                                                                                  \
+    TDS_POOL_CACHE_IMPL(TYPE, NAME)
+
+#endif
+
+/**********************************/
+/****** tinycsocket_posix.h *******/
+/**********************************/
+/*
+ * Copyright 2018 Markus Lindelöw
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files(the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+// Header only should not need other files
+#ifndef TINYCSOCKET_INTERNAL_H_
+#include "tinycsocket_internal.h"
+#endif
+#ifdef TINYCSOCKET_USE_POSIX_IMPL
+
+#ifndef TINYDATASTRUCTURES_H_
+#include "tinydatastructures.h"
+#endif
+
+#ifdef DO_WRAP
+#include "dbg_wrap.h"
+#endif
+
+// Without TCS_CFG_THREADS locks are spinlocks on atomics so plain use does not need -pthread
+#ifndef TCS_HAS_PTHREAD
+#if TCS_CFG_THREADS || !defined(TDS_HAS_ATOMICS)
+#define TCS_HAS_PTHREAD 1
+#else
+#define TCS_HAS_PTHREAD 0
+#endif
+#endif
+
+#ifndef TCS_HAS_AF_PACKET
+#if defined(__linux__)
+#define TCS_HAS_AF_PACKET 1
+#else
+#define TCS_HAS_AF_PACKET 0
+#endif
+#endif
+
+#ifndef TCS_HAS_TX_TIMESTAMPING
+#if defined(__linux__)
+#define TCS_HAS_TX_TIMESTAMPING 1
+#else
+#define TCS_HAS_TX_TIMESTAMPING 0
+#endif
+#endif
+
+#ifndef TCS_HAS_SOCKET_FILTER
+#if defined(__linux__)
+#define TCS_HAS_SOCKET_FILTER 1
+#else
+#define TCS_HAS_SOCKET_FILTER 0
+#endif
+#endif
+
+#ifndef TCS_HAS_GETIFADDRS
+#if defined(__ANDROID__)
+#if __ANDROID_API__ >= 24
+#define TCS_HAS_GETIFADDRS 1
+#else
+#define TCS_HAS_GETIFADDRS 0
+#endif
+#elif defined(__linux__) || defined(__APPLE__) || defined(__FreeBSD__) || defined(__OpenBSD__) || \
+    defined(__NetBSD__) || defined(__CYGWIN__)
+#define TCS_HAS_GETIFADDRS 1
+#else
+#define TCS_HAS_GETIFADDRS 0
+#endif
+#endif
+
+#include <errno.h>
+#include <fcntl.h> // fcntl() for non-blocking
+#include <limits.h>
+#include <net/if.h>      // Flags for ifaddrs (?)
+#include <netdb.h>       // Protocols and custom return codes
+#include <netinet/in.h>  // IPPROTO_XXP
+#include <netinet/tcp.h> // TCP_NODELAY
+#include <poll.h>        // poll()
+#include <sched.h>       // sched_yield()
+#include <string.h>      // strcpy, memset
+#include <sys/ioctl.h>   // Flags for ifaddrs, FIONBIO
+#ifdef __sun
+#include <sys/sockio.h> // SIOCGIFCONF on Solaris/illumos
+#endif
+#include <sys/socket.h> // pretty much everything
+#include <sys/types.h>  // POSIX.1 compatibility
+#include <sys/uio.h>    // struct iovec
+#include <time.h>       // clock_gettime()
+#include <unistd.h>     // close()
+
+#if TCS_HAS_GETIFADDRS
+#include <ifaddrs.h> // getifaddr()
+#endif
+#if TCS_HAS_PTHREAD
+#include <pthread.h> // pthread_mutex_t, pthread_create
+#endif
+#if TCS_HAS_AF_PACKET
+#include <linux/if_arp.h>    // sll_hatype (ethernet and not can or firewire etc.)
+#include <linux/if_packet.h> // struct sockaddr_ll
+#include <sys/mman.h>         // mmap() for packet rings
+#endif
+#if TCS_HAS_SOCKET_FILTER
+#include <linux/filter.h> // struct sock_fprog
+#endif
+
+#ifndef TCS_HAS_REUSEPORT_CBPF
+#if TCS_HAS_SOCKET_FILTER && defined(SO_ATTACH_REUSEPORT_CBPF)
+#define TCS_HAS_REUSEPORT_CBPF 1
+#else
+#define TCS_HAS_REUSEPORT_CBPF 0
+#endif
+#endif
+
+#ifndef TCS_HAS_ACCEPT4
+#if defined(__linux__) && defined(SOCK_NONBLOCK) && defined(SOCK_CLOEXEC)
+#define TCS_HAS_ACCEPT4 1
+#else
+#define TCS_HAS_ACCEPT4 0
+#endif
+#endif
+#if TCS_HAS_ACCEPT4 && defined(__GLIBC__) && !defined(__USE_GNU)
+// glibc only declares accept4() with _GNU_SOURCE
+extern int accept4(int sockfd, struct sockaddr* addr, socklen_t* addrlen, int flags);
+#endif
+#if TCS_HAS_TX_TIMESTAMPING
+#include <linux/errqueue.h>   // struct sock_extended_err, struct scm_timestamping
+#include <linux/net_tstamp.h> // SOF_TIMESTAMPING_*
+#endif
+
+#ifndef TCS_HAS_PKTINFO
+#if defined(IP_PKTINFO) && defined(IPV6_RECVPKTINFO) && defined(IPV6_PKTINFO)
+#define TCS_HAS_PKTINFO 1
+#else
+#define TCS_HAS_PKTINFO 0
+#endif
+#endif
+
+#ifndef TDS_MAP_pollfd_pvoid
+#define TDS_MAP_pollfd_pvoid
+TDS_MAP_IMPL_WITH_POLICY(struct pollfd, void*, poll, &TDS_GROWTH_POLICY_NEVER_SHRINK)
+#endif
+
+struct TcsPoll
+{
+    union __backend
+    {
+        struct __poll
+        {
+            struct TdsMap_poll map;
+        } poll;
+    } backend;
+};
+
+#if TCS_HAS_AF_PACKET
+struct TcsPacketRing
+{
+    TcsSocket socket;
+    int ring_option; // PACKET_RX_RING or PACKET_TX_RING
+    uint8_t* map;
+    size_t map_size;
+    size_t block_size;
+    size_t block_count;
+    size_t current_block;
+    uint8_t* next_frame; // NULL until the current block is handed to us
+    uint32_t frames_left;
+    // Transmit rings are addressed per frame
+    size_t frame_size;
+    size_t frames_per_block;
+    size_t frame_count;
+    size_t current_frame;
+    bool is_frame_acquired;
+};
+#endif
+
+const TcsSocket TCS_SOCKET_INVALID = -1;
+const int32_t TCS_WAIT_INF = -1;
+
+static long tcs_iov_max = 1024; // Default, updated by tcs_lib_init() via sysconf(_SC_IOV_MAX)
+
+// Addresses
+const TcsAddressIpv4 TCS_ADDRESS_IPV4_ANY = INADDR_ANY;
+const TcsAddressIpv4 TCS_ADDRESS_IPV4_LOOPBACK = INADDR_LOOPBACK;
+const TcsAddressIpv4 TCS_ADDRESS_IPV4_BROADCAST = INADDR_BROADCAST;
+const TcsAddressIpv4 TCS_ADDRESS_IPV4_NONE = INADDR_NONE;
+
+const struct TcsAddressIpv6 TCS_ADDRESS_IPV6_ANY = {{0}};
+const struct TcsAddressIpv6 TCS_ADDRESS_IPV6_LOOPBACK = {{0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1}};
+
+// Family
+const TcsFamily TCS_FAMILY_ANY = {AF_UNSPEC};
+const TcsFamily TCS_FAMILY_IPV4 = {AF_INET};
+const TcsFamily TCS_FAMILY_IPV6 = {AF_INET6};
+#if TCS_HAS_AF_PACKET
+const TcsFamily TCS_FAMILY_PACKET = {AF_PACKET};
+#else
+const TcsFamily TCS_FAMILY_PACKET = {-1}; /* sentinel: socket() will reject */
+#endif
+
+// Type
+const TcsSocketType TCS_SOCKET_STREAM = {SOCK_STREAM};
+const TcsSocketType TCS_SOCKET_DGRAM = {SOCK_DGRAM};
+const TcsSocketType TCS_SOCKET_RAW = {SOCK_RAW};
+
+// Recv flags
+const uint32_t TCS_MSG_PEEK = MSG_PEEK;
+const uint32_t TCS_MSG_OOB = MSG_OOB;
+const uint32_t TCS_MSG_WAITALL = MSG_WAITALL;
+
+// Send flags
+const uint32_t TCS_MSG_SENDALL = 0x80000000;
+
+// Send and recv flags
+const uint32_t TCS_MSG_DONTWAIT = MSG_DONTWAIT;
+
+// Backlog
+const int TCS_BACKLOG_MAX = SOMAXCONN;
+
+// Option levels
+const int32_t TCS_SOL_SOCKET = SOL_SOCKET;
+const int32_t TCS_SOL_IP = IPPROTO_IP; // Same as SOL_IP but crossplatform (BSD)
+const int32_t TCS_SOL_TCP = IPPROTO_TCP;
+#if TCS_HAS_AF_PACKET
+const int32_t TCS_SOL_PACKET = SOL_PACKET;
+#else
+const int32_t TCS_SOL_PACKET = -1;
+#endif
+
+// Socket options
+const int32_t TCS_SO_TYPE = SO_TYPE;
+const int32_t TCS_SO_BROADCAST = SO_BROADCAST;
+const int32_t TCS_SO_KEEPALIVE = SO_KEEPALIVE;
+const int32_t TCS_SO_LINGER = SO_LINGER;
+const int32_t TCS_SO_REUSEADDR = SO_REUSEADDR;
+#ifdef SO_REUSEPORT
+const int32_t TCS_SO_REUSEPORT = SO_REUSEPORT;
+#else
+const int32_t TCS_SO_REUSEPORT = -1;
+#endif
+const int32_t TCS_SO_RCVBUF = SO_RCVBUF;
+const int32_t TCS_SO_RCVTIMEO = SO_RCVTIMEO;
+const int32_t TCS_SO_SNDBUF = SO_SNDBUF;
+const int32_t TCS_SO_OOBINLINE = SO_OOBINLINE;
+#ifdef SO_PRIORITY
+const int32_t TCS_SO_PRIORITY = SO_PRIORITY;
+#else
+const int32_t TCS_SO_PRIORITY = -1;
+#endif
+
+// IP options
+const int32_t TCS_TCP_NODELAY = TCP_NODELAY;
+const int32_t TCS_IP_MEMBERSHIP_ADD = IP_ADD_MEMBERSHIP;
+const int32_t TCS_IP_MEMBERSHIP_DROP = IP_DROP_MEMBERSHIP;
+const int32_t TCS_IP_MULTICAST_LOOP = IP_MULTICAST_LOOP;
+
+#if TCS_HAS_AF_PACKET
+const int32_t TCS_PACKET_MEMBERSHIP_ADD = PACKET_ADD_MEMBERSHIP;
+const int32_t TCS_PACKET_MEMBERSHIP_DROP = PACKET_DROP_MEMBERSHIP;
+#else
+const int32_t TCS_PACKET_MEMBERSHIP_ADD = -1;
+const int32_t TCS_PACKET_MEMBERSHIP_DROP = -1;
+#endif
+
+// Default flags
+const int TCS_DEFAULT_SEND_FLAGS = MSG_NOSIGNAL;
+const int TCS_DEFAULT_RECV_FLAGS = 0;
+
+// ######## Internal Helpers ########
+
+static TcsResult errno2retcode(int error_code)
+{
+    switch (error_code)
+    {
+        case EAGAIN:
+#if defined(EWOULDBLOCK) && (EWOULDBLOCK != EAGAIN)
+        case EWOULDBLOCK:
+#endif
+            return TCS_ERROR_WOULD_BLOCK;
+        case EINPROGRESS:
+            return TCS_IN_PROGRESS;
+        case EPERM:
+        case EACCES:
+            return TCS_ERROR_PERMISSION_DENIED;
+        case ECONNREFUSED:
+            return TCS_ERROR_CONNECTION_REFUSED;
+        case ECONNRESET:
+            return TCS_ERROR_CONNECTION_RESET;
+        case ENOTCONN:
+            return TCS_ERROR_NOT_CONNECTED;
+        case ETIMEDOUT:
+            return TCS_ERROR_TIMED_OUT;
+        case ENETUNREACH:
+        case EHOSTUNREACH:
+        case ENETDOWN:
+            return TCS_ERROR_NETWORK_UNREACHABLE;
+        case EINVAL:
+            return TCS_ERROR_INVALID_ARGUMENT;
+        case EADDRINUSE:
+            return TCS_ERROR_ADDRESS_IN_USE;
+        case ENOPROTOOPT:
+            return TCS_ERROR_NOT_SUPPORTED;
+        case EAFNOSUPPORT:
+        case EPROTONOSUPPORT:
+        case ESOCKTNOSUPPORT:
+            return TCS_ERROR_NOT_SUPPORTED;
+        case ENODEV:
+            return TCS_ERROR_INVALID_ARGUMENT;
+        case ENOMEM:
+            return TCS_ERROR_MEMORY;
+        case EAI_SOCKTYPE:
+            return TCS_ERROR_NOT_IMPLEMENTED;
+        default:
+            return TCS_ERROR_UNKNOWN;
+    }
+}
+
+static TcsResult sockaddr2native(const struct TcsAddress* tcs_address,
+                                 struct sockaddr_storage* out_address,
+                                 socklen_t* out_address_size)
+{
+    if (tcs_address == NULL || out_address == NULL)
+        return TCS_ERROR_INVALID_ARGUMENT;
+
+    if (tcs_address->family.native == -1) // sentinel for unsupported families (e.g. TCS_FAMILY_PACKET on non-Linux)
+        return TCS_ERROR_NOT_SUPPORTED;
+
+    memset(out_address, 0, sizeof(struct sockaddr_storage));
+    if (out_address_size != NULL)
+        *out_address_size = 0;
+
+    if (tcs_address->family.native == TCS_FAMILY_ANY.native)
+    {
+        return TCS_ERROR_NOT_SUPPORTED;
+    }
+    else if (tcs_address->family.native == TCS_FAMILY_IPV4.native)
+    {
+        struct sockaddr_in* addr = (struct sockaddr_in*)out_address;
+        addr->sin_family = (sa_family_t)AF_INET;
+        addr->sin_port = (in_port_t)htons(tcs_address->data.ipv4.port);
+        addr->sin_addr.s_addr = (in_addr_t)htonl(tcs_address->data.ipv4.address);
+        if (out_address_size != NULL)
+            *out_address_size = sizeof(struct sockaddr_in);
+        return TCS_SUCCESS;
+    }
+    else if (tcs_address->family.native == TCS_FAMILY_IPV6.native)
+    {
+        struct sockaddr_in6* addr = (struct sockaddr_in6*)out_address;
+        addr->sin6_family = (sa_family_t)AF_INET6;
+        addr->sin6_port = (in_port_t)htons(tcs_address->data.ipv6.port);
+        memcpy(&addr->sin6_addr, tcs_address->data.ipv6.address.bytes, 16);
+        addr->sin6_scope_id = (uint32_t)tcs_address->data.ipv6.scope_id;
+        if (out_address_size != NULL)
+            *out_address_size = sizeof(struct sockaddr_in6);
+        return TCS_SUCCESS;
+    }
+    else if (tcs_address->family.native == TCS_FAMILY_PACKET.native)
+    {
+#if TCS_HAS_AF_PACKET
+        struct sockaddr_ll* addr = (struct sockaddr_ll*)out_address;
+        addr->sll_family = (sa_family_t)AF_PACKET;
+        addr->sll_ifindex = (int)tcs_address->data.packet.interface_id;
+        addr->sll_protocol = (uint16_t)htons(tcs_address->data.packet.protocol);
+        addr->sll_halen = 6; // MAC address length
+        memcpy(addr->sll_addr, tcs_address->data.packet.mac, 6);
+        if (out_address_size != NULL)
+            *out_address_size = sizeof(struct sockaddr_ll);
+        return TCS_SUCCESS;
+#else
+        return TCS_ERROR_NOT_SUPPORTED;
+#endif
+    }
+
+    return TCS_ERROR_NOT_SUPPORTED;
+}
+
+static TcsResult native2sockaddr(const struct sockaddr* in_addr, struct TcsAddress* out_addr)
+{
+    if (in_addr == NULL || out_addr == NULL)
+        return TCS_ERROR_INVALID_ARGUMENT;
+
+    if (in_addr->sa_family == AF_INET)
+    {
+        // (const void*) Supresses false positive alignment warning, the creator of the sockaddr is responsible for the alignment.
+        struct sockaddr_in const* addr = (struct sockaddr_in const*)(const void*)in_addr;
+        out_addr->family = TCS_FAMILY_IPV4;
+        out_addr->data.ipv4.port = ntohs((uint16_t)addr->sin_port);
+        out_addr->data.ipv4.address = ntohl((uint32_t)addr->sin_addr.s_addr);
+    }
+    else if (in_addr->sa_family == AF_INET6)
+    {
+        struct sockaddr_in6 const* addr = (struct sockaddr_in6 const*)(const void*)in_addr;
+        out_addr->family = TCS_FAMILY_IPV6;
+        out_addr->data.ipv6.port = ntohs((uint16_t)addr->sin6_port);
+        memcpy(out_addr->data.ipv6.address.bytes, &addr->sin6_addr, 16);
+        out_addr->data.ipv6.scope_id = (TcsInterfaceId)addr->sin6_scope_id;
+    }
+#if TCS_HAS_AF_PACKET
+    else if (in_addr->sa_family == AF_PACKET)
+    {
+        struct sockaddr_ll const* addr = (struct sockaddr_ll const*)(const void*)in_addr;
+        if (addr->sll_family != AF_PACKET)
+            return TCS_ERROR_NOT_IMPLEMENTED;
+        if (addr->sll_hatype != ARPHRD_ETHER && addr->sll_hatype != ARPHRD_LOOPBACK)
+            return TCS_ERROR_NOT_IMPLEMENTED; // Not ethernet or loopback
+        if (addr->sll_halen > 6)
+            return TCS_ERROR_INVALID_ARGUMENT;
+        if (addr->sll_ifindex < 0)
+            return TCS_ERROR_INVALID_ARGUMENT;
+
+        out_addr->family = TCS_FAMILY_PACKET;
+        out_addr->data.packet.interface_id = (unsigned int)addr->sll_ifindex;
+
+        memcpy(out_addr->data.packet.mac, addr->sll_addr, 6);
+        out_addr->data.packet.protocol = ntohs((uint16_t)addr->sll_protocol);
+    }
+#endif
+    else if (in_addr->sa_family == AF_UNSPEC)
+    {
+        return TCS_ERROR_INVALID_ARGUMENT;
+    }
+    else
+    {
+        return TCS_ERROR_NOT_IMPLEMENTED;
+    }
+
+    return TCS_SUCCESS;
+}
+
+#if TCS_HAS_PKTINFO
+// Same layout as RFC 3542 struct in6_pktinfo, which glibc hides behind _GNU_SOURCE
+struct tcs_in6_pktinfo
+{
+    struct in6_addr ipi6_addr;
+    unsigned int ipi6_ifindex;
+};
+
+// Large enough and aligned for one IP_PKTINFO or IPV6_PKTINFO control message
+union tcs_pktinfo_control
+{
+    char buffer[CMSG_SPACE(sizeof(struct tcs_in6_pktinfo)) > CMSG_SPACE(sizeof(struct in_pktinfo))
+                    ? CMSG_SPACE(sizeof(struct tcs_in6_pktinfo))
+                    : CMSG_SPACE(sizeof(struct in_pktinfo))];
+    struct cmsghdr align;
+};
+#endif
+
+// ######## OS Primitives ########
+
+// Used by tinycsocket_common.c, see the declarations there
+
+size_t tcs_os_steering_cpu_count(void)
+{
+#if TCS_HAS_REUSEPORT_CBPF
+    // Configured, not online, CPUs since SO_INCOMING_CPU ids may be sparse
+    long cpu_count = sysconf(_SC_NPROCESSORS_CONF);
+    return cpu_count > 0 ? (size_t)cpu_count : 0;
+#else
+    return 0;
+#endif
+}
+
+#ifdef TDS_HAS_ATOMICS
+// Only for short critical sections, a waiter gives up its time slice instead of sleeping
+static void os_spin_lock(TdsAtomicSize* lock)
+{
+    size_t expected = 0;
+    while (!tds_atomic_compare_exchange(lock, &expected, 1))
+    {
+        sched_yield();
+        expected = 0;
+    }
+}
+
+static void os_spin_unlock(TdsAtomicSize* lock)
+{
+    tds_atomic_store_release(lock, 0);
+}
+#endif
+
+#if TCS_HAS_PTHREAD
+struct TcsOsMutex
+{
+    pthread_mutex_t mutex;
+};
+
+TcsResult tcs_os_mutex_create(struct TcsOsMutex** out_mutex)
+{
+    struct TcsOsMutex* mutex = (struct TcsOsMutex*)tcs_lib_malloc(sizeof(struct TcsOsMutex));
+    if (mutex == NULL)
+        return TCS_ERROR_MEMORY;
+    int sts = pthread_mutex_init(&mutex->mutex, NULL);
+    if (sts != 0)
+    {
+        tcs_lib_free(mutex);
+        return errno2retcode(sts);
+    }
+    *out_mutex = mutex;
+    return TCS_SUCCESS;
+}
+
+void tcs_os_mutex_destroy(struct TcsOsMutex** mutex)
+{
+    pthread_mutex_destroy(&(*mutex)->mutex);
+    tcs_lib_free(*mutex);
+    *mutex = NULL;
+}
+
+void tcs_os_mutex_lock(struct TcsOsMutex* mutex)
+{
+    pthread_mutex_lock(&mutex->mutex);
+}
+
+void tcs_os_mutex_unlock(struct TcsOsMutex* mutex)
+{
+    pthread_mutex_unlock(&mutex->mutex);
+}
+#else
+struct TcsOsMutex
+{
+    TdsAtomicSize is_locked;
+};
+
+TcsResult tcs_os_mutex_create(struct TcsOsMutex** out_mutex)
+{
+    struct TcsOsMutex* mutex = (struct TcsOsMutex*)tcs_lib_malloc(sizeof(struct TcsOsMutex));
+    if (mutex == NULL)
+        return TCS_ERROR_MEMORY;
+    tds_atomic_store_relaxed(&mutex->is_locked, 0);
+    *out_mutex = mutex;
+    return TCS_SUCCESS;
+}
+
+void tcs_os_mutex_destroy(struct TcsOsMutex** mutex)
+{
+    tcs_lib_free(*mutex);
+    *mutex = NULL;
+}
+
+void tcs_os_mutex_lock(struct TcsOsMutex* mutex)
+{
+    os_spin_lock(&mutex->is_locked);
+}
+
+void tcs_os_mutex_unlock(struct TcsOsMutex* mutex)
+{
+    os_spin_unlock(&mutex->is_locked);
+}
+#endif
+
+#ifdef TDS_HAS_ATOMICS
+static TdsAtomicSize os_global_lock = 0; // Held for a few lookups in the address cache, a spinlock is enough
+
+void tcs_os_global_lock(void)
+{
+    os_spin_lock(&os_global_lock);
+}
+
+void tcs_os_global_unlock(void)
+{
+    os_spin_unlock(&os_global_lock);
+}
+#else
+static pthread_mutex_t os_global_lock = PTHREAD_MUTEX_INITIALIZER;
+
+void tcs_os_global_lock(void)
+{
+    pthread_mutex_lock(&os_global_lock);
+}
+
+void tcs_os_global_unlock(void)
+{
+    pthread_mutex_unlock(&os_global_lock);
+}
+#endif
+
+#if TCS_CFG_THREADS
+struct TcsOsThread
+{
+    pthread_t thread;
+    void (*function)(void*);
+    void* arg;
+};
+
+static void* os_thread_main(void* arg)
+{
+    struct TcsOsThread* thread = (struct TcsOsThread*)arg;
+    thread->function(thread->arg);
+    return NULL;
+}
+
+TcsResult tcs_os_thread_create(struct TcsOsThread** out_thread, void (*function)(void*), void* arg)
+{
+    struct TcsOsThread* thread = (struct TcsOsThread*)tcs_lib_malloc(sizeof(struct TcsOsThread));
+    if (thread == NULL)
+        return TCS_ERROR_MEMORY;
+    thread->function = function;
+    thread->arg = arg;
+    int sts = pthread_create(&thread->thread, NULL, os_thread_main, thread);
+    if (sts != 0)
+    {
+        tcs_lib_free(thread);
+        return errno2retcode(sts);
+    }
+    *out_thread = thread;
+    return TCS_SUCCESS;
+}
+
+void tcs_os_thread_join(struct TcsOsThread** thread)
+{
+    pthread_join((*thread)->thread, NULL);
+    tcs_lib_free(*thread);
+    *thread = NULL;
+}
+
+// Not sem_t, unnamed POSIX semaphores are missing on MacOS
+struct TcsOsSemaphore
+{
+    pthread_mutex_t lock;
+    pthread_cond_t is_posted;
+    size_t count;
+};
+
+TcsResult tcs_os_semaphore_create(struct TcsOsSemaphore** out_semaphore)
+{
+    struct TcsOsSemaphore* semaphore = (struct TcsOsSemaphore*)tcs_lib_malloc(sizeof(struct TcsOsSemaphore));
+    if (semaphore == NULL)
+        return TCS_ERROR_MEMORY;
+    semaphore->count = 0;
+    int sts = pthread_mutex_init(&semaphore->lock, NULL);
+    if (sts != 0)
+    {
+        tcs_lib_free(semaphore);
+        return errno2retcode(sts);
+    }
+    sts = pthread_cond_init(&semaphore->is_posted, NULL);
+    if (sts != 0)
+    {
+        pthread_mutex_destroy(&semaphore->lock);
+        tcs_lib_free(semaphore);
+        return errno2retcode(sts);
+    }
+    *out_semaphore = semaphore;
+    return TCS_SUCCESS;
+}
+
+void tcs_os_semaphore_destroy(struct TcsOsSemaphore** semaphore)
+{
+    pthread_cond_destroy(&(*semaphore)->is_posted);
+    pthread_mutex_destroy(&(*semaphore)->lock);
+    tcs_lib_free(*semaphore);
+    *semaphore = NULL;
+}
+
+void tcs_os_semaphore_post(struct TcsOsSemaphore* semaphore)
+{
+    pthread_mutex_lock(&semaphore->lock);
+    semaphore->count++;
+    pthread_cond_signal(&semaphore->is_posted);
+    pthread_mutex_unlock(&semaphore->lock);
+}
+
+void tcs_os_semaphore_wait(struct TcsOsSemaphore* semaphore)
+{
+    pthread_mutex_lock(&semaphore->lock);
+    while (semaphore->count == 0)
+        pthread_cond_wait(&semaphore->is_posted, &semaphore->lock);
+    semaphore->count--;
+    pthread_mutex_unlock(&semaphore->lock);
+}
+#else
+struct TcsOsThread;
+struct TcsOsSemaphore;
+
+TcsResult tcs_os_thread_create(struct TcsOsThread** out_thread, void (*function)(void*), void* arg)
+{
+    (void)out_thread;
+    (void)function;
+    (void)arg;
+    return TCS_ERROR_NOT_SUPPORTED; // Build with TCS_CFG_THREADS and link with -pthread
+}
+
+void tcs_os_thread_join(struct TcsOsThread** thread)
+{
+    (void)thread;
+}
+
+TcsResult tcs_os_semaphore_create(struct TcsOsSemaphore** out_semaphore)
+{
+    (void)out_semaphore;
+    return TCS_ERROR_NOT_SUPPORTED;
+}
+
+void tcs_os_semaphore_destroy(struct TcsOsSemaphore** semaphore)
+{
+    (void)semaphore;
+}
+
+void tcs_os_semaphore_post(struct TcsOsSemaphore* semaphore)
+{
+    (void)semaphore;
+}
+
+void tcs_os_semaphore_wait(struct TcsOsSemaphore* semaphore)
+{
+    (void)semaphore;
+}
+#endif
+
+struct TcsOsWakeup
+{
+    int pipe[2]; // One byte is in the pipe while set
+};
+
+TcsResult tcs_os_wakeup_create(struct TcsOsWakeup** out_wakeup)
+{
+    struct TcsOsWakeup* wakeup = (struct TcsOsWakeup*)tcs_lib_malloc(sizeof(struct TcsOsWakeup));
+    if (wakeup == NULL)
+        return TCS_ERROR_MEMORY;
+    if (pipe(wakeup->pipe) != 0)
+    {
+        int error_code = errno;
+        tcs_lib_free(wakeup);
+        return errno2retcode(error_code);
+    }
+    for (int i = 0; i < 2; ++i)
+    {
+        fcntl(wakeup->pipe[i], F_SETFL, fcntl(wakeup->pipe[i], F_GETFL, 0) | O_NONBLOCK);
+        fcntl(wakeup->pipe[i], F_SETFD, FD_CLOEXEC);
+    }
+    *out_wakeup = wakeup;
+    return TCS_SUCCESS;
+}
+
+void tcs_os_wakeup_destroy(struct TcsOsWakeup** wakeup)
+{
+    close((*wakeup)->pipe[0]);
+    close((*wakeup)->pipe[1]);
+    tcs_lib_free(*wakeup);
+    *wakeup = NULL;
+}
+
+TcsSocket tcs_os_wakeup_socket(const struct TcsOsWakeup* wakeup)
+{
+    return wakeup->pipe[0];
+}
+
+void tcs_os_wakeup_set(struct TcsOsWakeup* wakeup, bool is_set)
+{
+    uint8_t byte = 1;
+    ssize_t sts = is_set ? write(wakeup->pipe[1], &byte, 1) : read(wakeup->pipe[0], &byte, 1);
+    (void)sts;
+}
+
+TcsResult tcs_os_connect_wait(const TcsSocket sockets[], size_t sockets_length, TcsResult out_results[], int timeout_ms)
+{
+    if (sockets_length > TCS_CFG_CONNECT_CANDIDATES_MAX)
+        return TCS_ERROR_INVALID_ARGUMENT;
+
+    struct pollfd poll_fds[TCS_CFG_CONNECT_CANDIDATES_MAX];
+    for (size_t i = 0; i < sockets_length; ++i)
+    {
+        poll_fds[i].fd = sockets[i]; // poll() ignores TCS_SOCKET_INVALID since it is negative
+        poll_fds[i].events = POLLOUT;
+        poll_fds[i].revents = 0;
+        out_results[i] = TCS_IN_PROGRESS;
+    }
+    int ready = poll(poll_fds, (nfds_t)sockets_length, timeout_ms);
+    if (ready == 0 || (ready < 0 && errno == EINTR))
+        return TCS_ERROR_TIMED_OUT;
+    if (ready < 0)
+        return errno2retcode(errno);
+
+    for (size_t i = 0; i < sockets_length; ++i)
+    {
+        if (poll_fds[i].revents == 0)
+            continue;
+        int error = 0;
+        socklen_t error_size = sizeof(error);
+        if (getsockopt(sockets[i], SOL_SOCKET, SO_ERROR, &error, &error_size) != 0)
+            error = errno;
+        out_results[i] = error == 0 ? TCS_SUCCESS : errno2retcode(error);
+    }
+    return TCS_SUCCESS;
+}
+
+// /dev/urandom and not getrandom(), which needs glibc 2.25 and is missing on older BSDs and MacOS
+TcsResult tcs_os_random(uint8_t* out_bytes, size_t length)
+{
+    int flags = O_RDONLY;
+#ifdef O_CLOEXEC
+    flags |= O_CLOEXEC;
+#endif
+    int fd = open("/dev/urandom", flags);
+    if (fd == -1)
+        return TCS_ERROR_NOT_SUPPORTED;
+    size_t done = 0;
+    while (done < length)
+    {
+        ssize_t sts = read(fd, out_bytes + done, length - done);
+        if (sts <= 0 && !(sts == -1 && errno == EINTR))
+            break;
+        if (sts > 0)
+            done += (size_t)sts;
+    }
+    close(fd);
+    return done == length ? TCS_SUCCESS : TCS_ERROR_NOT_SUPPORTED;
+}
+
+// ######## Library Management ########
+
+TcsResult tcs_lib_init(void)
+{
+    long iov_max = sysconf(_SC_IOV_MAX);
+    if (iov_max > 0)
+        tcs_iov_max = iov_max;
+    return TCS_SUCCESS;
+}
+
+TcsResult tcs_lib_cleanup(void)
+{
+    // Not needed for posix
+    return TCS_SUCCESS;
+}
+
+int64_t tcs_time_monotonic_ms(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+// ######## Socket Creation ########
+
+TcsResult tcs_socket(TcsSocket* out_socket, TcsFamily family, TcsSocketType type, TcsProtocol protocol)
+{
+    return tcs_socket_with_flags(out_socket, family, type, protocol, TCS_FLAG_NONE);
+}
+
+TcsResult tcs_socket_with_flags(TcsSocket* out_socket,
+                                TcsFamily family,
+                                TcsSocketType type,
+                                TcsProtocol protocol,
+                                uint32_t flags)
+{
+    if (out_socket == NULL || *out_socket != TCS_SOCKET_INVALID)
+        return TCS_ERROR_INVALID_ARGUMENT;
+    if ((flags & ~(TCS_SOCKET_FLAG_NONBLOCKING | TCS_SOCKET_FLAG_CLOEXEC)) != 0)
+        return TCS_ERROR_INVALID_ARGUMENT;
+    if (family.native == -1) // sentinel for unsupported families (e.g. TCS_FAMILY_PACKET on non-Linux)
+        return TCS_ERROR_NOT_SUPPORTED;
+#if TCS_HAS_AF_PACKET
+    int native_protocol = (family.native == AF_PACKET) ? (int)htons(protocol) : (int)protocol;
+#else
+    int native_protocol = (int)protocol;
+#endif
+    int native_type = type.native;
+#if defined(SOCK_NONBLOCK) && defined(SOCK_CLOEXEC)
+    if (flags & TCS_SOCKET_FLAG_NONBLOCKING)
+        native_type |= SOCK_NONBLOCK;
+    if (flags & TCS_SOCKET_FLAG_CLOEXEC)
+        native_type |= SOCK_CLOEXEC;
+#endif
+    *out_socket = socket(family.native, native_type, native_protocol);
+
+    if (*out_socket == -1) // Same as TCS_NULLSOCKET
+        return errno2retcode(errno);
+
+#if !defined(SOCK_NONBLOCK) || !defined(SOCK_CLOEXEC)
+    // No creation flags (e.g. macOS), set them afterwards
+    TcsResult res = TCS_SUCCESS;
+    if (flags & TCS_SOCKET_FLAG_NONBLOCKING)
+        res = tcs_opt_nonblocking_set(*out_socket, true);
+    if (res == TCS_SUCCESS && (flags & TCS_SOCKET_FLAG_CLOEXEC) && fcntl(*out_socket, F_SETFD, FD_CLOEXEC) == -1)
+        res = errno2retcode(errno);
+    if (res != TCS_SUCCESS)
+    {
+        tcs_close(out_socket);
+        return res;
+    }
+#endif
+    return TCS_SUCCESS;
+}
+
+// tcs_socket_tcp() is defined in tinycsocket_common.c
+// tcs_socket_tcp_str() is defined in tinycsocket_common.c
+// tcs_socket_udp() is defined in tinycsocket_common.c
+// tcs_socket_udp_str() is defined in tinycsocket_common.c
+// tcs_socket_packet() is defined in tinycsocket_common.c
+// tcs_socket_packet_str() is defined in tinycsocket_common.c
+
+// tcs_socket_per_cpu() is defined in tinycsocket_common.c
+
+TcsResult tcs_close(TcsSocket* socket)
+{
+    if (socket == NULL || *socket == TCS_SOCKET_INVALID)
+        return TCS_ERROR_INVALID_ARGUMENT;
+
+    if (close(*socket) == 0)
+    {
+        *socket = TCS_SOCKET_INVALID;
+        return TCS_SUCCESS;
+    }
+    else
+    {
+        return errno2retcode(errno);
+    }
+}
+
+// ######## Socket Operations ########
+
+TcsResult tcs_bind(TcsSocket socket, const struct TcsAddress* address)
+{
+    if (socket == TCS_SOCKET_INVALID)
+        return TCS_ERROR_INVALID_ARGUMENT;
+    if (address == NULL)
+        return TCS_ERROR_INVALID_ARGUMENT;
+
+    struct sockaddr_storage native_sockaddr;
+    memset(&native_sockaddr, 0, sizeof native_sockaddr);
+    socklen_t sockaddr_size = 0;
+    TcsResult convert_address_status = sockaddr2native(address, &native_sockaddr, &sockaddr_size);
+    if (convert_address_status != TCS_SUCCESS)
+        return convert_address_status;
+
+    if (bind(socket, (struct sockaddr*)&native_sockaddr, sockaddr_size) != -1)
+        return TCS_SUCCESS;
+    else
+        return errno2retcode(errno);
+}
+
+TcsResult tcs_connect(TcsSocket socket, const struct TcsAddress* address)
+{
+    if (socket == TCS_SOCKET_INVALID)
+        return TCS_ERROR_INVALID_ARGUMENT;
+    if (address == NULL)
+        return TCS_ERROR_INVALID_ARGUMENT;
+
+    struct sockaddr_storage native_sockaddr;
+    memset(&native_sockaddr, 0, sizeof native_sockaddr);
+    socklen_t sockaddr_size = 0;
+    TcsResult convert_address_status = sockaddr2native(address, &native_sockaddr, &sockaddr_size);
+    if (convert_address_status != TCS_SUCCESS)
+        return convert_address_status;
+
+    if (connect(socket, (const struct sockaddr*)&native_sockaddr, sockaddr_size) == 0)
+        return TCS_SUCCESS;
+    else
+        return errno2retcode(errno);
+}
+
+// tcs_connect_str() is defined in tinycsocket_common.c
+
+static TcsResult connect_wait(TcsSocket socket, int timeout_ms)
+{
+    struct pollfd poll_fd;
+    poll_fd.fd = socket;
+    poll_fd.events = POLLOUT;
+    poll_fd.revents = 0;
+
+    const int64_t deadline = tcs_time_monotonic_ms() + timeout_ms;
+    int remaining_ms = timeout_ms;
+    for (;;)
+    {
+        int ready = poll(&poll_fd, 1, remaining_ms);
+        if (ready > 0)
+            break;
+        if (ready == 0)
+            return TCS_ERROR_TIMED_OUT;
+        if (errno != EINTR)
+            return errno2retcode(errno);
+        int64_t left_ms = deadline - tcs_time_monotonic_ms();
+        remaining_ms = left_ms > 0 ? (int)left_ms : 0;
+    }
+
+    int error = 0;
+    socklen_t error_size = sizeof(error);
+    if (getsockopt(socket, SOL_SOCKET, SO_ERROR, &error, &error_size) != 0)
+        return errno2retcode(errno);
+    return error == 0 ? TCS_SUCCESS : errno2retcode(error);
+}
+
+TcsResult tcs_connect_timeout(TcsSocket socket, const struct TcsAddress* address, int timeout_ms)
+{
+    if (socket == TCS_SOCKET_INVALID || address == NULL)
+        return TCS_ERROR_INVALID_ARGUMENT;
+    if (timeout_ms < 0 && timeout_ms != TCS_WAIT_INF)
+        return TCS_ERROR_INVALID_ARGUMENT;
+    if (timeout_ms == TCS_WAIT_INF)
+        return tcs_connect(socket, address);
+
+    struct sockaddr_storage native_sockaddr;
+    memset(&native_sockaddr, 0, sizeof native_sockaddr);
+    socklen_t sockaddr_size = 0;
+    TcsResult res = sockaddr2native(address, &native_sockaddr, &sockaddr_size);
+    if (res != TCS_SUCCESS)
+        return res;
+
+    int flags = fcntl(socket, F_GETFL, 0);
+    if (flags == -1)
+        return errno2retcode(errno);
+    const bool was_blocking = (flags & O_NONBLOCK) == 0;
+    if (was_blocking && fcntl(socket, F_SETFL, flags | O_NONBLOCK) == -1)
+        return errno2retcode(errno);
+
+    if (connect(socket, (const struct sockaddr*)&native_sockaddr, sockaddr_size) == 0)
+        res = TCS_SUCCESS;
+    else if (errno == EINPROGRESS)
+        res = connect_wait(socket, timeout_ms);
+    else
+        res = errno2retcode(errno);
+
+    if (was_blocking && fcntl(socket, F_SETFL, flags) == -1 && res == TCS_SUCCESS)
+        res = errno2retcode(errno);
+    return res;
+}
+
+TcsResult tcs_listen(TcsSocket socket, int backlog)
+{
+    if (socket == TCS_SOCKET_INVALID)
+        return TCS_ERROR_INVALID_ARGUMENT;
+
+    if (backlog < 1 || backlog > TCS_BACKLOG_MAX)
+        backlog = TCS_BACKLOG_MAX;
+
+    if (listen(socket, backlog) == 0)
+        return TCS_SUCCESS;
+    else
+        return errno2retcode(errno);
+}
+
+TcsResult tcs_accept(TcsSocket listener, TcsSocket* out_socket, struct TcsAddress* out_address)
+{
+    if (listener == TCS_SOCKET_INVALID || out_socket == NULL || *out_socket != TCS_SOCKET_INVALID)
+        return TCS_ERROR_INVALID_ARGUMENT;
+
+    if (out_address != NULL)
+        *out_address = TCS_ADDRESS_NONE;
+
+    struct sockaddr_storage native_sockaddr;
+    memset(&native_sockaddr, 0, sizeof native_sockaddr);
+    socklen_t sockaddr_size = sizeof native_sockaddr;
+
+    *out_socket = accept(listener, (struct sockaddr*)&native_sockaddr, &sockaddr_size);
+    if (*out_socket != -1)
+    {
+        if (out_address != NULL)
+        {
+            TcsResult convert_address_status = native2sockaddr((struct sockaddr*)&native_sockaddr, out_address);
+            if (convert_address_status != TCS_SUCCESS)
+                return convert_address_status;
+        }
+        return TCS_SUCCESS;
+    }
+    else
+    {
+        *out_socket = TCS_SOCKET_INVALID;
+        return errno2retcode(errno);
+    }
+}
+
+TcsResult tcs_accept_many(TcsSocket listener,
+                          TcsSocket out_sockets[],
+                          struct TcsAddress out_addresses[],
+                          size_t sockets_length,
+                          size_t* out_accepted_count)
+{
+    if (out_accepted_count != NULL)
+        *out_accepted_count = 0;
+    if (listener == TCS_SOCKET_INVALID || out_sockets == NULL || sockets_length == 0 || out_accepted_count == NULL)
+        return TCS_ERROR_INVALID_ARGUMENT;
+
+    TcsResult res = TCS_SUCCESS;
+    size_t count = 0;
+    while (count < sockets_length)
+    {
+        struct sockaddr_storage native_sockaddr;
+        socklen_t sockaddr_size = sizeof native_sockaddr;
+        struct sockaddr* native_address = out_addresses != NULL ? (struct sockaddr*)&native_sockaddr : NULL;
+        socklen_t* native_address_size = out_addresses != NULL ? &sockaddr_size : NULL;
+#if TCS_HAS_ACCEPT4
+        int socket = accept4(listener, native_address, native_address_size, SOCK_NONBLOCK | SOCK_CLOEXEC);
+#else
+        int socket = accept(listener, native_address, native_address_size);
+        if (socket != -1 && (fcntl(socket, F_SETFL, fcntl(socket, F_GETFL, 0) | O_NONBLOCK) == -1 ||
+                             fcntl(socket, F_SETFD, FD_CLOEXEC) == -1))
+        {
+            int error = errno;
+            close(socket);
+            socket = -1;
+            errno = error;
+        }
+#endif
+        if (socket == -1)
+        {
+            if (errno == EINTR)
+                continue;
+            res = errno2retcode(errno);
+            break;
+        }
+        out_sockets[count] = socket;
+        if (out_addresses != NULL)
+        {
+            out_addresses[count] = TCS_ADDRESS_NONE;
+            native2sockaddr((struct sockaddr*)&native_sockaddr, &out_addresses[count]);
+        }
+        count++;
+    }
+
+    *out_accepted_count = count;
+    return count > 0 ? TCS_SUCCESS : res;
+}
+
+TcsResult tcs_shutdown(TcsSocket socket, TcsShutdownDirection direction)
+{
+    const int LUT[] = {SHUT_RD, SHUT_WR, SHUT_RDWR};
+
+    if (socket == TCS_SOCKET_INVALID)
+        return TCS_ERROR_INVALID_ARGUMENT;
+    if (direction < 0 || direction > 2)
+        return TCS_ERROR_INVALID_ARGUMENT;
+
+    const int how = LUT[direction];
+    if (shutdown(socket, how) == 0)
+        return TCS_SUCCESS;
+    else
+        return errno2retcode(errno);
+}
+
+// ######## Data Transfer ########
+
+TcsResult tcs_send(TcsSocket socket, const uint8_t* buffer, size_t buffer_size, uint32_t flags, size_t* sent_size)
+{
+    if (socket == TCS_SOCKET_INVALID)
+        return TCS_ERROR_INVALID_ARGUMENT;
+
+    if (sent_size != NULL)
+        *sent_size = 0;
+
+    if (buffer == NULL || buffer_size == 0)
+        return TCS_ERROR_INVALID_ARGUMENT;
+
+    // Send all
+    if (flags & TCS_MSG_SENDALL)
+    {
+        uint32_t new_flags = flags & ~TCS_MSG_SENDALL; // For recursive call
+        size_t left = buffer_size;
+        const uint8_t* iterator = buffer;
+
+        while (left > 0)
+        {
+            size_t sent = 0;
+            TcsResult sts = tcs_send(socket, iterator, left, new_flags, &sent);
+            if (sent_size != NULL)
+                *sent_size += sent;
+            if (sts != TCS_SUCCESS)
+                return sts;
+            left -= sent;
+            iterator += sent;
+        }
+        return TCS_SUCCESS;
+    }
+    else // Send
+    {
+        ssize_t send_status = send(socket, (const char*)buffer, buffer_size, TCS_DEFAULT_SEND_FLAGS | (int)flags);
+        if (send_status >= 0)
+        {
+            if (sent_size != NULL)
+                *sent_size = (size_t)send_status;
+            return TCS_SUCCESS;
+        }
+        else
+        {
+            if (sent_size != NULL)
+                *sent_size = 0;
+            return errno2retcode(errno);
+        }
+    }
+}
+
+TcsResult tcs_send_to(TcsSocket socket,
+                      const uint8_t* buffer,
+                      size_t buffer_size,
+                      uint32_t flags,
+                      const struct TcsAddress* destination_address,
+                      size_t* sent_size)
+{
+    if (socket == TCS_SOCKET_INVALID)
+        return TCS_ERROR_INVALID_ARGUMENT;
+    if (buffer == NULL && buffer_size > 0)
+        return TCS_ERROR_INVALID_ARGUMENT;
+    if (destination_address == NULL)
+        return TCS_ERROR_INVALID_ARGUMENT;
+
+    if (flags & TCS_MSG_SENDALL)
+        return TCS_ERROR_NOT_IMPLEMENTED;
+
+    struct sockaddr_storage native_sockaddr;
+    memset(&native_sockaddr, 0, sizeof native_sockaddr);
+    socklen_t sockaddr_size = 0;
+    TcsResult convert_addr_status = sockaddr2native(destination_address, &native_sockaddr, &sockaddr_size);
+    if (convert_addr_status != TCS_SUCCESS)
+        return convert_addr_status;
+
+    ssize_t sendto_status = sendto(socket,
+                                   (const char*)buffer,
+                                   buffer_size,
+                                   TCS_DEFAULT_SEND_FLAGS | (int)flags,
+                                   (const struct sockaddr*)&native_sockaddr,
+                                   sockaddr_size);
+
+    if (sendto_status >= 0)
+    {
+        if (sent_size != NULL)
+            *sent_size = (size_t)sendto_status;
+        return TCS_SUCCESS;
+    }
+    else
+    {
+        if (sent_size != NULL)
+            *sent_size = 0;
+
+        return errno2retcode(errno);
+    }
+}
+
+TcsResult tcs_send_to_from(TcsSocket socket,
+                           const uint8_t* buffer,
+                           size_t buffer_size,
+                           uint32_t flags,
+                           const struct TcsAddress* destination_address,
+                           const struct TcsAddress* source_address,
+                           TcsInterfaceId interface_id,
+                           size_t* sent_size)
+{
+    if (sent_size != NULL)
+        *sent_size = 0;
+    if (socket == TCS_SOCKET_INVALID)
+        return TCS_ERROR_INVALID_ARGUMENT;
+    if (buffer == NULL && buffer_size > 0)
+        return TCS_ERROR_INVALID_ARGUMENT;
+    if (destination_address == NULL)
+        return TCS_ERROR_INVALID_ARGUMENT;
+    if (source_address != NULL && source_address->family.native != destination_address->family.native)
+        return TCS_ERROR_INVALID_ARGUMENT;
+
+    if (flags & TCS_MSG_SENDALL)
+        return TCS_ERROR_NOT_IMPLEMENTED;
+
+    if (source_address == NULL && interface_id == 0)
+        return tcs_send_to(socket, buffer, buffer_size, flags, destination_address, sent_size);
+
+#if TCS_HAS_PKTINFO
+    struct sockaddr_storage native_sockaddr;
+    socklen_t sockaddr_size = 0;
+    TcsResult convert_addr_status = sockaddr2native(destination_address, &native_sockaddr, &sockaddr_size);
+    if (convert_addr_status != TCS_SUCCESS)
+        return convert_addr_status;
+
+    union tcs_pktinfo_control control;
+    memset(&control, 0, sizeof(control));
+
+    // We know that sendmsg() does not modify the data, so we can safely cast away the const here.
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wcast-qual"
+    struct iovec iov;
+    iov.iov_base = (void*)buffer;
+    iov.iov_len = buffer_size;
+#pragma GCC diagnostic pop
+
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_name = &native_sockaddr;
+    msg.msg_namelen = sockaddr_size;
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control.buffer;
+
+    if (destination_address->family.native == TCS_FAMILY_IPV4.native)
+    {
+        struct in_pktinfo info;
+        memset(&info, 0, sizeof(info));
+        info.ipi_ifindex = (int)interface_id;
+        if (source_address != NULL)
+            info.ipi_spec_dst.s_addr = htonl(source_address->data.ipv4.address);
+        msg.msg_controllen = CMSG_SPACE(sizeof(info));
+        struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+        cmsg->cmsg_level = IPPROTO_IP;
+        cmsg->cmsg_type = IP_PKTINFO;
+        cmsg->cmsg_len = CMSG_LEN(sizeof(info));
+        memcpy(CMSG_DATA(cmsg), &info, sizeof(info));
+    }
+    else if (destination_address->family.native == TCS_FAMILY_IPV6.native)
+    {
+        struct tcs_in6_pktinfo info;
+        memset(&info, 0, sizeof(info));
+        info.ipi6_ifindex = interface_id;
+        if (source_address != NULL)
+            memcpy(&info.ipi6_addr, source_address->data.ipv6.address.bytes, 16);
+        msg.msg_controllen = CMSG_SPACE(sizeof(info));
+        struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+        cmsg->cmsg_level = IPPROTO_IPV6;
+        cmsg->cmsg_type = IPV6_PKTINFO;
+        cmsg->cmsg_len = CMSG_LEN(sizeof(info));
+        memcpy(CMSG_DATA(cmsg), &info, sizeof(info));
+    }
+    else
+    {
+        return TCS_ERROR_NOT_SUPPORTED;
+    }
+
+    ssize_t ret = sendmsg(socket, &msg, TCS_DEFAULT_SEND_FLAGS | (int)flags);
+    if (ret < 0)
+        return errno2retcode(errno);
+    if (sent_size != NULL)
+        *sent_size = (size_t)ret;
+    return TCS_SUCCESS;
+#else
+    return TCS_ERROR_NOT_SUPPORTED;
+#endif
+}
+
+TcsResult tcs_sendv(TcsSocket socket, const struct TcsIoVec* iov, size_t iov_length, uint32_t flags, size_t* sent_size)
+{
+    if (socket == TCS_SOCKET_INVALID || iov == NULL || iov_length == 0)
+        return TCS_ERROR_INVALID_ARGUMENT;
+
+    if (flags & TCS_MSG_SENDALL)
+        return TCS_ERROR_NOT_IMPLEMENTED;
+
+    if (iov_length > (size_t)tcs_iov_max)
+        return TCS_ERROR_INVALID_ARGUMENT;
+
+    struct iovec stack_iovec[TCS_CFG_SENDV_STACK_MAX];
+    struct iovec* my_iovec = stack_iovec;
+    struct iovec* heap_iovec = NULL;
+
+    if (iov_length > TCS_CFG_SENDV_STACK_MAX)
+    {
+        heap_iovec = (struct iovec*)tcs_lib_malloc(sizeof(struct iovec) * iov_length);
+        if (heap_iovec == NULL)
+            return TCS_ERROR_MEMORY;
+        my_iovec = heap_iovec;
+    }
+
+    for (size_t i = 0; i < iov_length; i++)
+    {
+        if (iov[i].buffer == NULL && iov[i].buffer_size > 0)
+        {
+            tcs_lib_free(heap_iovec);
+            return TCS_ERROR_INVALID_ARGUMENT;
+        }
+        // We know that sendmsg() does not modify the data, so we can safely cast away the const here.
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wcast-qual"
+        my_iovec[i].iov_base = (void*)iov[i].buffer;
+#pragma GCC diagnostic pop
         my_iovec[i].iov_len = iov[i].buffer_size;
     }
 
-    struct msghdr msg;
-    msg.msg_name = NULL;
-    msg.msg_namelen = 0;
-    msg.msg_iov = my_iovec;
-    // msg_iovlen type varies across platforms (int on POSIX, size_t on glibc).
-    // iov_length is already validated against tcs_iov_max above.
-#pragma GCC diagnostic push
-#pragma GCC diagnostic ignored "-Wconversion"
-#pragma GCC diagnostic ignored "-Wsign-conversion"
-    msg.msg_iovlen = iov_length;
-#pragma GCC diagnostic pop
-    msg.msg_control = NULL;
-    msg.msg_controllen = 0;
-    msg.msg_flags = 0;
+    struct msghdr msg;
+    msg.msg_name = NULL;
+    msg.msg_namelen = 0;
+    msg.msg_iov = my_iovec;
+    // msg_iovlen type varies across platforms (int on POSIX, size_t on glibc).
+    // iov_length is already validated against tcs_iov_max above.
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wconversion"
+#pragma GCC diagnostic ignored "-Wsign-conversion"
+    msg.msg_iovlen = iov_length;
+#pragma GCC diagnostic pop
+    msg.msg_control = NULL;
+    msg.msg_controllen = 0;
+    msg.msg_flags = 0;
+
+    ssize_t ret = 0;
+    ret = sendmsg(socket, &msg, TCS_DEFAULT_SEND_FLAGS | (int)flags);
+
+    tcs_lib_free(heap_iovec);
+
+    if (ret >= 0)
+    {
+        if (sent_size != NULL)
+            *sent_size = (size_t)ret;
+        return TCS_SUCCESS;
+    }
+    else
+    {
+        if (sent_size != NULL)
+            *sent_size = 0;
+        return errno2retcode(errno);
+    }
+}
+
+// tcs_send_netstring() is defined in tinycsocket_common.c
+
+TcsResult tcs_receive(TcsSocket socket, uint8_t* buffer, size_t buffer_size, uint32_t flags, size_t* received_size)
+{
+    if (socket == TCS_SOCKET_INVALID)
+        return TCS_ERROR_INVALID_ARGUMENT;
+    if (buffer == NULL && buffer_size > 0)
+        return TCS_ERROR_INVALID_ARGUMENT;
+
+    if (buffer_size == 0)
+    {
+        if (received_size != NULL)
+            *received_size = 0;
+        return TCS_SUCCESS;
+    }
+
+#if defined(__CYGWIN__)
+    // Workaround for cygwin bug (introduced 2020 in cygwin, still present when this code is written)
+    // Cygwin's recv(MSG_WAITALL) loops forever after peer FIN.
+    // The loop in winsup/cygwin/fhandler/socket_inet.cc::recv_internal has no exit for a successful zero-byte WSARecv,
+    // and FD_CLOSE stays latched, so the loop re-enters wait_for_events and WSARecv repeatedly.
+    TcsSocketType cygwin_sock_type = {0};
+    bool is_stream = (flags & MSG_WAITALL) && ((flags & MSG_PEEK) || !(flags & MSG_OOB)) &&
+                     tcs_opt_type_get(socket, &cygwin_sock_type) == TCS_SUCCESS &&
+                     cygwin_sock_type.native == TCS_SOCKET_STREAM.native;
+    if (is_stream)
+    {
+        uint32_t base_flags = flags & ~(uint32_t)MSG_WAITALL;
+        size_t total = 0;
+        int loop_errno = 0;
+        bool peer_closed = false;
+        bool deadline_hit = false;
+
+        // Nonblocking sockets must never wait in poll(); the native recv()
+        // already returns EAGAIN immediately, which the epilog converts to
+        // TCS_ERROR_WOULD_BLOCK.
+        int fcntl_flags = fcntl(socket, F_GETFL, 0);
+        bool is_nonblock = (fcntl_flags != -1 && (fcntl_flags & O_NONBLOCK)) || (flags & TCS_MSG_DONTWAIT);
+
+        // SO_RCVTIMEO == 0 means block forever; otherwise compute monotonic deadline.
+        int timeout = 0;
+        tcs_opt_receive_timeout_get(socket, &timeout);
+        bool has_deadline = (timeout > 0 && !is_nonblock);
+        int64_t deadline_ns = 0;
+        if (has_deadline)
+        {
+            struct timespec ts;
+            clock_gettime(CLOCK_MONOTONIC, &ts);
+            deadline_ns = (int64_t)ts.tv_sec * 1000000000LL + ts.tv_nsec + (int64_t)timeout * 1000000LL;
+        }
+
+        if (!(flags & MSG_PEEK))
+        {
+            while (total < buffer_size)
+            {
+                // Cap each retry to the remaining deadline so a peer that
+                // trickles bytes can't keep resetting the per-recv SO_RCVTIMEO
+                // and extend the call past the configured timeout.
+                if (has_deadline)
+                {
+                    struct timespec now;
+                    clock_gettime(CLOCK_MONOTONIC, &now);
+                    int64_t now_ns = (int64_t)now.tv_sec * 1000000000LL + now.tv_nsec;
+                    if (now_ns >= deadline_ns)
+                    {
+                        deadline_hit = true;
+                        break;
+                    }
+                    int remaining_ms = (int)((deadline_ns - now_ns + 999999LL) / 1000000LL);
+                    struct pollfd pfd = {socket, POLLIN, 0};
+                    int perr = poll(&pfd, 1, remaining_ms);
+                    if (perr < 0)
+                    {
+                        if (errno == EINTR)
+                            continue;
+                        loop_errno = errno;
+                        break;
+                    }
+                    if (perr == 0)
+                    {
+                        deadline_hit = true;
+                        break;
+                    }
+                }
+                ssize_t r = recv(socket, (char*)buffer + total, buffer_size - total, (int)base_flags);
+                if (r > 0)
+                {
+                    total += (size_t)r;
+                }
+                else if (r == 0)
+                {
+                    peer_closed = true;
+                    break;
+                }
+                else
+                {
+                    if (errno == EINTR)
+                        continue;
+                    loop_errno = errno;
+                    break;
+                }
+            }
+        }
+        else
+        {
+            struct pollfd pfd = {socket, 0, 0};
+
+            for (;;)
+            {
+                // Peek what is currently buffered. If nothing has grown since the
+                // last iteration, this is a no-op on `total`; otherwise it captures more.
+                ssize_t r = recv(socket, (char*)buffer, buffer_size, (int)base_flags);
+                if (r > 0)
+                    total = (size_t)r;
+                else if (r == 0)
+                    peer_closed = true;
+                else if (errno == EINTR)
+                    continue;
+                else
+                    loop_errno = errno;
+
+                if (total >= buffer_size || peer_closed || loop_errno != 0)
+                    break;
+
+                if (has_deadline)
+                {
+                    struct timespec now;
+                    clock_gettime(CLOCK_MONOTONIC, &now);
+                    if ((int64_t)now.tv_sec * 1000000000LL + now.tv_nsec >= deadline_ns)
+                    {
+                        deadline_hit = true;
+                        break;
+                    }
+                }
+
+                // Wait briefly for state change. POLLHUP/POLLERR/POLLNVAL fire even
+                // with events=0; on close we just flag peer_closed and let the next
+                // iteration's peek capture any straggler bytes.
+                int perr = poll(&pfd, 1, 1);
+                if (perr < 0)
+                {
+                    if (errno == EINTR)
+                        continue;
+                    loop_errno = errno;
+                    break;
+                }
+                if (pfd.revents & (POLLHUP | POLLERR | POLLNVAL))
+                    peer_closed = true;
+            }
+        }
+
+        if (received_size != NULL)
+            *received_size = total;
+        if (total > 0)
+            return TCS_SUCCESS;
+        if (loop_errno != 0)
+        {
+#if (EAGAIN == EWOULDBLOCK)
+            if (loop_errno == EAGAIN)
+            {
+                if (is_nonblock)
+                    return TCS_ERROR_WOULD_BLOCK;
+                return TCS_ERROR_TIMED_OUT;
+            }
+#endif
+            return errno2retcode(loop_errno);
+        }
+        if (peer_closed)
+            return TCS_SHUTDOWN;
+        if (deadline_hit)
+            return TCS_ERROR_TIMED_OUT;
+        return TCS_SUCCESS;
+    }
+#endif
+
+    ssize_t recv_status = recv(socket, (char*)buffer, buffer_size, TCS_DEFAULT_RECV_FLAGS | (int)flags);
+
+    if (recv_status > 0)
+    {
+        if (received_size != NULL)
+            *received_size = (size_t)recv_status;
+        return TCS_SUCCESS;
+    }
+    else if (recv_status == 0)
+    {
+        if (received_size != NULL)
+            *received_size = 0;
+        TcsSocketType sock_type = {0};
+        if (tcs_opt_type_get(socket, &sock_type) == TCS_SUCCESS && sock_type.native == TCS_SOCKET_STREAM.native)
+            return TCS_SHUTDOWN;
+        return TCS_SUCCESS;
+    }
+    else
+    {
+        if (received_size != NULL)
+            *received_size = 0;
+#if (EAGAIN == EWOULDBLOCK)
+        if (errno == EAGAIN)
+        {
+            if (flags & TCS_MSG_DONTWAIT)
+                return TCS_ERROR_WOULD_BLOCK;
+            int fcntl_flags = fcntl(socket, F_GETFL, 0);
+            if (fcntl_flags == -1)
+                return errno2retcode(errno);
+            if (fcntl_flags & O_NONBLOCK)
+                return TCS_ERROR_WOULD_BLOCK;
+            return TCS_ERROR_TIMED_OUT;
+        }
+#endif
+        return errno2retcode(errno);
+    }
+}
+
+TcsResult tcs_receive_from(TcsSocket socket,
+                           uint8_t* buffer,
+                           size_t buffer_size,
+                           uint32_t flags,
+                           struct TcsAddress* source_address,
+                           size_t* received_size)
+{
+    if (socket == TCS_SOCKET_INVALID)
+        return TCS_ERROR_INVALID_ARGUMENT;
+    if (buffer == NULL && buffer_size > 0)
+        return TCS_ERROR_INVALID_ARGUMENT;
+
+    struct sockaddr_storage native_sockaddr;
+    memset(&native_sockaddr, 0, sizeof native_sockaddr);
+    socklen_t addrlen = sizeof native_sockaddr;
+
+    ssize_t recvfrom_status = recvfrom(socket,
+                                       (char*)buffer,
+                                       buffer_size,
+                                       TCS_DEFAULT_RECV_FLAGS | (int)flags,
+                                       (struct sockaddr*)&native_sockaddr,
+                                       &addrlen);
+
+    if (recvfrom_status > 0)
+    {
+        if (received_size != NULL)
+            *received_size = (size_t)recvfrom_status;
+        if (source_address != NULL)
+            return native2sockaddr((struct sockaddr*)&native_sockaddr, source_address);
+        return TCS_SUCCESS;
+    }
+    else if (recvfrom_status == 0)
+    {
+        if (received_size != NULL)
+            *received_size = 0;
+        TcsSocketType sock_type = {0};
+        if (tcs_opt_type_get(socket, &sock_type) == TCS_SUCCESS && sock_type.native == TCS_SOCKET_STREAM.native)
+            return TCS_SHUTDOWN;
+        return TCS_SUCCESS;
+    }
+    else
+    {
+        if (received_size != NULL)
+            *received_size = 0;
+        return errno2retcode(errno);
+    }
+}
+
+TcsResult tcs_receive_from_to(TcsSocket socket,
+                              uint8_t* buffer,
+                              size_t buffer_size,
+                              uint32_t flags,
+                              struct TcsAddress* source_address,
+                              struct TcsAddress* destination_address,
+                              TcsInterfaceId* interface_id,
+                              size_t* received_size)
+{
+    if (received_size != NULL)
+        *received_size = 0;
+    if (destination_address != NULL)
+        *destination_address = TCS_ADDRESS_NONE;
+    if (interface_id != NULL)
+        *interface_id = 0;
+    if (socket == TCS_SOCKET_INVALID)
+        return TCS_ERROR_INVALID_ARGUMENT;
+    if (buffer == NULL && buffer_size > 0)
+        return TCS_ERROR_INVALID_ARGUMENT;
+
+#if TCS_HAS_PKTINFO
+    struct sockaddr_storage native_sockaddr;
+    memset(&native_sockaddr, 0, sizeof native_sockaddr);
+
+    union tcs_pktinfo_control control;
+    struct iovec iov;
+    iov.iov_base = buffer;
+    iov.iov_len = buffer_size;
+
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_name = &native_sockaddr;
+    msg.msg_namelen = sizeof(native_sockaddr);
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control.buffer;
+    msg.msg_controllen = sizeof(control.buffer);
+
+    ssize_t recvmsg_status = recvmsg(socket, &msg, TCS_DEFAULT_RECV_FLAGS | (int)flags);
+    if (recvmsg_status < 0)
+        return errno2retcode(errno);
+
+    if (received_size != NULL)
+        *received_size = (size_t)recvmsg_status;
+
+    for (struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg); cmsg != NULL; cmsg = CMSG_NXTHDR(&msg, cmsg))
+    {
+        if (cmsg->cmsg_level == IPPROTO_IP && cmsg->cmsg_type == IP_PKTINFO)
+        {
+            struct in_pktinfo info;
+            memcpy(&info, CMSG_DATA(cmsg), sizeof(info));
+            if (destination_address != NULL)
+            {
+                destination_address->family = TCS_FAMILY_IPV4;
+                destination_address->data.ipv4.address = ntohl(info.ipi_addr.s_addr);
+            }
+            if (interface_id != NULL)
+                *interface_id = (TcsInterfaceId)info.ipi_ifindex;
+        }
+        else if (cmsg->cmsg_level == IPPROTO_IPV6 && cmsg->cmsg_type == IPV6_PKTINFO)
+        {
+            struct tcs_in6_pktinfo info;
+            memcpy(&info, CMSG_DATA(cmsg), sizeof(info));
+            if (destination_address != NULL)
+            {
+                destination_address->family = TCS_FAMILY_IPV6;
+                memcpy(destination_address->data.ipv6.address.bytes, &info.ipi6_addr, 16);
+                destination_address->data.ipv6.scope_id = info.ipi6_ifindex;
+            }
+            if (interface_id != NULL)
+                *interface_id = info.ipi6_ifindex;
+        }
+    }
+
+    if (recvmsg_status == 0)
+    {
+        TcsSocketType sock_type = {0};
+        if (tcs_opt_type_get(socket, &sock_type) == TCS_SUCCESS && sock_type.native == TCS_SOCKET_STREAM.native)
+            return TCS_SHUTDOWN;
+        return TCS_SUCCESS;
+    }
+    if (source_address != NULL)
+        return native2sockaddr((struct sockaddr*)&native_sockaddr, source_address);
+    return TCS_SUCCESS;
+#else
+    (void)flags;
+    (void)source_address;
+    return TCS_ERROR_NOT_SUPPORTED;
+#endif
+}
+
+// tcs_receive_line() is defined in tinycsocket_common.c
+// tcs_receive_netstring() is defined in tinycsocket_common.c
+
+TcsResult tcs_receive_tx_timestamps(TcsSocket socket,
+                                    struct TcsTxTimestamp out_timestamps[],
+                                    size_t timestamps_length,
+                                    size_t* out_length)
+{
+    if (out_length != NULL)
+        *out_length = 0;
+    if (socket == TCS_SOCKET_INVALID || out_timestamps == NULL || timestamps_length == 0 || out_length == NULL)
+        return TCS_ERROR_INVALID_ARGUMENT;
+
+#if TCS_HAS_TX_TIMESTAMPING
+    size_t filled = 0;
+    while (filled < timestamps_length)
+    {
+        union
+        {
+            char buffer[CMSG_SPACE(sizeof(struct scm_timestamping)) +
+                        CMSG_SPACE(sizeof(struct sock_extended_err) + sizeof(struct sockaddr_in6))];
+            struct cmsghdr align;
+        } control;
+        uint8_t payload[1]; // Only the control messages are of interest, the looped payload is truncated
+        struct iovec iov;
+        iov.iov_base = payload;
+        iov.iov_len = sizeof(payload);
+
+        struct msghdr msg;
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_iov = &iov;
+        msg.msg_iovlen = 1;
+        msg.msg_control = control.buffer;
+        msg.msg_controllen = sizeof(control.buffer);
+
+        ssize_t recv_status = recvmsg(socket, &msg, MSG_ERRQUEUE | MSG_DONTWAIT);
+        if (recv_status < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            if (filled > 0)
+                break;
+            return errno2retcode(errno);
+        }
+
+        bool has_timestamp = false;
+        bool has_id = false;
+        struct TcsTxTimestamp entry = {0, 0};
+        for (struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg); cmsg != NULL; cmsg = CMSG_NXTHDR(&msg, cmsg))
+        {
+            bool is_extended_error = (cmsg->cmsg_level == IPPROTO_IP && cmsg->cmsg_type == IP_RECVERR) ||
+                                     (cmsg->cmsg_level == IPPROTO_IPV6 && cmsg->cmsg_type == IPV6_RECVERR);
+#if TCS_HAS_AF_PACKET
+            is_extended_error |= cmsg->cmsg_level == SOL_PACKET && cmsg->cmsg_type == PACKET_TX_TIMESTAMP;
+#endif
+            if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_TIMESTAMPING)
+            {
+                struct scm_timestamping timestamps;
+                memcpy(&timestamps, CMSG_DATA(cmsg), sizeof(timestamps));
+                // Index 0 holds the software timestamp, 1 is deprecated and 2 is the hardware timestamp
+                entry.timestamp_ns = (int64_t)timestamps.ts[0].tv_sec * 1000000000LL + timestamps.ts[0].tv_nsec;
+                has_timestamp = true;
+            }
+            else if (is_extended_error)
+            {
+                struct sock_extended_err error;
+                memcpy(&error, CMSG_DATA(cmsg), sizeof(error));
+                if (error.ee_errno == ENOMSG && error.ee_origin == SO_EE_ORIGIN_TIMESTAMPING)
+                {
+                    entry.id = error.ee_data;
+                    has_id = true;
+                }
+            }
+        }
+
+        // Other error queue entries, e.g. ICMP errors when IP_RECVERR is enabled, are consumed and skipped
+        if (has_timestamp && has_id)
+            out_timestamps[filled++] = entry;
+    }
+    *out_length = filled;
+    return TCS_SUCCESS;
+#else
+    return TCS_ERROR_NOT_SUPPORTED;
+#endif
+}
+
+// ######## Socket Polling ########
+
+TcsResult tcs_poll_create(struct TcsPoll** out_poll)
+{
+    if (out_poll == NULL || *out_poll != NULL)
+        return TCS_ERROR_INVALID_ARGUMENT;
+
+    *out_poll = (struct TcsPoll*)tcs_lib_malloc(sizeof(struct TcsPoll));
+    if (*out_poll == NULL)
+        return TCS_ERROR_MEMORY;
+    memset(*out_poll, 0, sizeof(struct TcsPoll));
+
+    if (tds_map_poll_create(&(*out_poll)->backend.poll.map) != 0)
+    {
+        tcs_lib_free(*out_poll);
+        *out_poll = NULL;
+        return TCS_ERROR_MEMORY;
+    }
+
+    return TCS_SUCCESS;
+}
+
+TcsResult tcs_poll_destroy(struct TcsPoll** ctx)
+{
+    if (ctx == NULL || *ctx == NULL)
+        return TCS_ERROR_INVALID_ARGUMENT;
+
+    if (tds_map_poll_destroy(&(*ctx)->backend.poll.map) != 0)
+    {
+        return TCS_ERROR_MEMORY;
+    }
+
+    tcs_lib_free(*ctx);
+    *ctx = NULL;
+
+    return TCS_SUCCESS;
+}
+
+TcsResult tcs_poll_add(struct TcsPoll* ctx, TcsSocket socket, void* user_data, uint32_t flags)
+{
+    if (ctx == NULL)
+        return TCS_ERROR_INVALID_ARGUMENT;
+    if (socket == TCS_SOCKET_INVALID)
+        return TCS_ERROR_INVALID_ARGUMENT;
+
+    short ev = POLLERR;
+    if (flags & TCS_POLL_READ)
+        ev |= POLLIN;
+    if (flags & TCS_POLL_WRITE)
+        ev |= POLLOUT;
+
+    struct pollfd pfd;
+    pfd.fd = socket;
+    pfd.events = ev;
+    pfd.revents = 0;
+
+    if (tds_map_poll_addp(&ctx->backend.poll.map, &pfd, &user_data) != 0)
+        return TCS_ERROR_MEMORY;
+
+    return TCS_SUCCESS;
+}
+
+TcsResult tcs_poll_modify(struct TcsPoll* ctx, TcsSocket socket, uint32_t flags)
+{
+    if (ctx == NULL)
+        return TCS_ERROR_INVALID_ARGUMENT;
+    if (socket == TCS_SOCKET_INVALID)
+        return TCS_ERROR_INVALID_ARGUMENT;
+
+    struct TdsMap_poll* map = &ctx->backend.poll.map;
+
+    for (size_t i = 0; i < map->count; ++i)
+    {
+        if (socket == map->keys[i].fd)
+        {
+            short ev = POLLERR;
+            if (flags & TCS_POLL_READ)
+                ev |= POLLIN;
+            if (flags & TCS_POLL_WRITE)
+                ev |= POLLOUT;
+            map->keys[i].events = ev;
+            return TCS_SUCCESS;
+        }
+    }
+
+    return TCS_ERROR_INVALID_ARGUMENT;
+}
+
+TcsResult tcs_poll_remove(struct TcsPoll* ctx, TcsSocket socket)
+{
+    if (ctx == NULL)
+        return TCS_ERROR_INVALID_ARGUMENT;
+    if (socket == TCS_SOCKET_INVALID)
+        return TCS_ERROR_INVALID_ARGUMENT;
+    struct TdsMap_poll const* map = &ctx->backend.poll.map;
+
+    bool found = false;
+    for (size_t i = 0; i < map->count; ++i)
+    {
+        if (socket == map->keys[i].fd)
+        {
+            if (tds_map_poll_remove(&ctx->backend.poll.map, i) != 0)
+                return TCS_ERROR_MEMORY;
+            found = true;
+            break;
+        }
+    }
+    if (!found)
+        return TCS_ERROR_INVALID_ARGUMENT;
+
+    return TCS_SUCCESS;
+}
+
+TcsResult tcs_poll_wait(struct TcsPoll* poll_ctx,
+                        struct TcsPollEvent* out_events,
+                        size_t events_length,
+                        size_t* out_events_length,
+                        int timeout_ms)
+{
+    if (poll_ctx == NULL || out_events == NULL || out_events_length == NULL)
+        return TCS_ERROR_INVALID_ARGUMENT;
+    if (timeout_ms < 0 && timeout_ms != TCS_WAIT_INF)
+        return TCS_ERROR_INVALID_ARGUMENT;
+
+    struct TdsMap_poll* map = &poll_ctx->backend.poll.map;
+
+    int poll_ret = poll(map->keys, map->count, timeout_ms);
+    *out_events_length = 0;
+    if (poll_ret < 0)
+    {
+        return errno2retcode(errno);
+    }
+    if ((size_t)poll_ret > map->count)
+    {
+        return TCS_ERROR_UNKNOWN; // Corruption
+    }
+
+    int fill_max = poll_ret > (int)events_length ? (int)events_length : poll_ret; // min(ret, events_length)
+    int filled = 0;
+    for (size_t i = 0; filled < fill_max; ++i)
+    {
+        if (i >= map->count)
+            return TCS_ERROR_UNKNOWN;
+
+        if (map->keys[i].revents != 0)
+        {
+            out_events[filled].socket = map->keys[i].fd;
+            out_events[filled].user_data = map->values[i];
+            out_events[filled].can_read = map->keys[i].revents & POLLIN;
+            out_events[filled].can_write = map->keys[i].revents & POLLOUT;
+            out_events[filled].can_read_error_queue = false;
+            if (map->keys[i].revents & (POLLERR | POLLHUP))
+            {
+                int so_error = 0;
+                socklen_t so_error_size = sizeof(so_error);
+                TcsResult fallback = (map->keys[i].revents & POLLERR) ? TCS_ERROR_UNKNOWN : TCS_ERROR_SOCKET_CLOSED;
+#if TCS_HAS_TX_TIMESTAMPING
+                // POLLERR without a pending socket error means that the error queue has entries, e.g. timestamps
+                if (map->keys[i].revents & POLLERR)
+                    fallback = (map->keys[i].revents & POLLHUP) ? TCS_ERROR_SOCKET_CLOSED : TCS_SUCCESS;
+#endif
+                if (getsockopt(map->keys[i].fd, SOL_SOCKET, SO_ERROR, &so_error, &so_error_size) != 0)
+                    out_events[filled].error = errno2retcode(errno);
+                else
+                    out_events[filled].error = so_error != 0 ? errno2retcode(so_error) : fallback;
+#if TCS_HAS_TX_TIMESTAMPING
+                out_events[filled].can_read_error_queue = so_error == 0 && (map->keys[i].revents & POLLERR);
+#endif
+            }
+            else
+            {
+                out_events[filled].error = TCS_SUCCESS;
+            }
+            map->keys[i].revents = 0;
+            ++filled;
+        }
+    }
+    *out_events_length = (size_t)filled;
+
+    if (poll_ret == 0)
+        return TCS_ERROR_TIMED_OUT;
+    return TCS_SUCCESS;
+}
+
+// ######## Connection Pool ########
+
+// tcs_pool_create() is defined in tinycsocket_common.c
+// tcs_pool_destroy() is defined in tinycsocket_common.c
+// tcs_pool_acquire() is defined in tinycsocket_common.c
+// tcs_pool_release() is defined in tinycsocket_common.c
+
+// ######## Asynchronous Resolve ########
+
+// tcs_resolver_create() is defined in tinycsocket_common.c
+// tcs_resolver_destroy() is defined in tinycsocket_common.c
+// tcs_resolver_socket() is defined in tinycsocket_common.c
+// tcs_resolver_submit() is defined in tinycsocket_common.c
+// tcs_resolver_take() is defined in tinycsocket_common.c
+// tcs_resolver_cancel() is defined in tinycsocket_common.c
+
+// ######## Packet Rings ########
+
+#if TCS_HAS_AF_PACKET
+static void packet_ring_unset(TcsSocket socket, int ring_option)
+{
+    struct tpacket_req3 req;
+    memset(&req, 0, sizeof(req));
+    setsockopt(socket, SOL_PACKET, ring_option, &req, sizeof(req));
+}
+#endif
+
+TcsResult tcs_packet_ring_rx_create(struct TcsPacketRing** out_ring,
+                                    TcsSocket socket,
+                                    size_t block_size,
+                                    size_t block_count,
+                                    size_t frame_size,
+                                    int block_timeout_ms)
+{
+    if (out_ring == NULL || *out_ring != NULL || socket == TCS_SOCKET_INVALID)
+        return TCS_ERROR_INVALID_ARGUMENT;
+    if (block_timeout_ms < 0)
+        return TCS_ERROR_INVALID_ARGUMENT;
+
+#if TCS_HAS_AF_PACKET
+    long page_size = sysconf(_SC_PAGESIZE);
+    if (page_size <= 0)
+        return TCS_ERROR_SYSTEM;
+    if (block_size == 0 || block_size % (size_t)page_size != 0 || block_size > UINT_MAX)
+        return TCS_ERROR_INVALID_ARGUMENT;
+    // TPACKET_ALIGN() in the kernel header mixes int and size_t
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wsign-conversion"
+    const size_t min_frame_size = TPACKET3_HDRLEN;
+#pragma GCC diagnostic pop
+    if (frame_size < min_frame_size || frame_size % TPACKET_ALIGNMENT != 0 || frame_size > block_size)
+        return TCS_ERROR_INVALID_ARGUMENT;
+    if (block_count == 0 || block_count > UINT_MAX / (block_size / frame_size) || block_count > SIZE_MAX / block_size)
+        return TCS_ERROR_INVALID_ARGUMENT;
+
+    int version = TPACKET_V3;
+    if (setsockopt(socket, SOL_PACKET, PACKET_VERSION, &version, sizeof(version)) != 0)
+        return errno == EBUSY ? TCS_ERROR_INVALID_ARGUMENT : errno2retcode(errno); // EBUSY: the socket has a ring
+
+    struct tpacket_req3 req;
+    memset(&req, 0, sizeof(req));
+    req.tp_block_size = (unsigned int)block_size;
+    req.tp_block_nr = (unsigned int)block_count;
+    req.tp_frame_size = (unsigned int)frame_size;
+    req.tp_frame_nr = (unsigned int)(block_size / frame_size * block_count);
+    req.tp_retire_blk_tov = (unsigned int)block_timeout_ms;
+    if (setsockopt(socket, SOL_PACKET, PACKET_RX_RING, &req, sizeof(req)) != 0)
+        return errno2retcode(errno);
+
+    size_t map_size = block_size * block_count;
+    void* map = mmap(NULL, map_size, PROT_READ | PROT_WRITE, MAP_SHARED, socket, 0);
+    if (map == MAP_FAILED)
+    {
+        TcsResult sts = errno2retcode(errno);
+        packet_ring_unset(socket, PACKET_RX_RING);
+        return sts;
+    }
+
+    struct TcsPacketRing* ring = (struct TcsPacketRing*)tcs_lib_malloc(sizeof(struct TcsPacketRing));
+    if (ring == NULL)
+    {
+        munmap(map, map_size);
+        packet_ring_unset(socket, PACKET_RX_RING);
+        return TCS_ERROR_MEMORY;
+    }
+    memset(ring, 0, sizeof(struct TcsPacketRing));
+    ring->socket = socket;
+    ring->ring_option = PACKET_RX_RING;
+    ring->map = (uint8_t*)map;
+    ring->map_size = map_size;
+    ring->block_size = block_size;
+    ring->block_count = block_count;
+
+    *out_ring = ring;
+    return TCS_SUCCESS;
+#else
+    (void)block_size;
+    (void)block_count;
+    (void)frame_size;
+    return TCS_ERROR_NOT_SUPPORTED;
+#endif
+}
+
+TcsResult tcs_packet_ring_destroy(struct TcsPacketRing** ring)
+{
+    if (ring == NULL || *ring == NULL)
+        return TCS_ERROR_INVALID_ARGUMENT;
+
+#if TCS_HAS_AF_PACKET
+    munmap((*ring)->map, (*ring)->map_size);
+    packet_ring_unset((*ring)->socket, (*ring)->ring_option);
+    tcs_lib_free(*ring);
+    *ring = NULL;
+    return TCS_SUCCESS;
+#else
+    return TCS_ERROR_NOT_SUPPORTED;
+#endif
+}
+
+TcsResult tcs_packet_ring_rx_next(struct TcsPacketRing* ring, struct TcsPacketFrame* out_frame)
+{
+    if (ring == NULL || out_frame == NULL)
+        return TCS_ERROR_INVALID_ARGUMENT;
+
+#if TCS_HAS_AF_PACKET
+    if (ring->ring_option != PACKET_RX_RING)
+        return TCS_ERROR_INVALID_ARGUMENT;
+
+    if (ring->next_frame == NULL)
+    {
+        struct tpacket_block_desc* block =
+            (struct tpacket_block_desc*)(void*)(ring->map + ring->current_block * ring->block_size);
+        // Acquire pairs with the kernel publishing the block, the frames must not be read before the status
+        if ((__atomic_load_n(&block->hdr.bh1.block_status, __ATOMIC_ACQUIRE) & TP_STATUS_USER) == 0)
+            return TCS_ERROR_WOULD_BLOCK;
+        ring->frames_left = block->hdr.bh1.num_pkts;
+        ring->next_frame = (uint8_t*)block + block->hdr.bh1.offset_to_first_pkt;
+    }
+
+    if (ring->frames_left == 0)
+        return TCS_AGAIN;
+
+    struct tpacket3_hdr const* header = (struct tpacket3_hdr const*)(void*)ring->next_frame;
+    out_frame->data = ring->next_frame + header->tp_mac;
+    out_frame->size = header->tp_snaplen;
+    out_frame->original_size = header->tp_len;
+    out_frame->timestamp_ns = (int64_t)header->tp_sec * 1000000000LL + header->tp_nsec;
+
+    ring->next_frame += header->tp_next_offset;
+    ring->frames_left--;
+    return TCS_SUCCESS;
+#else
+    return TCS_ERROR_NOT_SUPPORTED;
+#endif
+}
+
+TcsResult tcs_packet_ring_rx_release(struct TcsPacketRing* ring)
+{
+    if (ring == NULL)
+        return TCS_ERROR_INVALID_ARGUMENT;
+
+#if TCS_HAS_AF_PACKET
+    if (ring->ring_option != PACKET_RX_RING)
+        return TCS_ERROR_INVALID_ARGUMENT;
+    if (ring->next_frame == NULL)
+        return TCS_SUCCESS; // No block is held
+
+    struct tpacket_block_desc* block =
+        (struct tpacket_block_desc*)(void*)(ring->map + ring->current_block * ring->block_size);
+    __atomic_store_n(&block->hdr.bh1.block_status, TP_STATUS_KERNEL, __ATOMIC_RELEASE);
+
+    ring->current_block = (ring->current_block + 1) % ring->block_count;
+    ring->next_frame = NULL;
+    ring->frames_left = 0;
+    return TCS_SUCCESS;
+#else
+    return TCS_ERROR_NOT_SUPPORTED;
+#endif
+}
+
+#if TCS_HAS_AF_PACKET
+static struct tpacket2_hdr* packet_ring_tx_frame(struct TcsPacketRing* ring, size_t frame)
+{
+    size_t block = frame / ring->frames_per_block;
+    size_t offset = (frame % ring->frames_per_block) * ring->frame_size;
+    return (struct tpacket2_hdr*)(void*)(ring->map + block * ring->block_size + offset);
+}
+
+// Without PACKET_TX_HAS_OFF the kernel reads the frame right after the aligned header
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wsign-conversion"
+static const size_t PACKET_RING_TX_DATA_OFFSET = TPACKET_ALIGN(sizeof(struct tpacket2_hdr));
+#pragma GCC diagnostic pop
+#endif
+
+TcsResult tcs_packet_ring_tx_create(struct TcsPacketRing** out_ring,
+                                    TcsSocket socket,
+                                    size_t block_size,
+                                    size_t block_count,
+                                    size_t frame_size)
+{
+    if (out_ring == NULL || *out_ring != NULL || socket == TCS_SOCKET_INVALID)
+        return TCS_ERROR_INVALID_ARGUMENT;
+
+#if TCS_HAS_AF_PACKET
+    long page_size = sysconf(_SC_PAGESIZE);
+    if (page_size <= 0)
+        return TCS_ERROR_SYSTEM;
+    if (block_size == 0 || block_size % (size_t)page_size != 0 || block_size > UINT_MAX)
+        return TCS_ERROR_INVALID_ARGUMENT;
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wsign-conversion"
+    const size_t min_frame_size = TPACKET2_HDRLEN;
+#pragma GCC diagnostic pop
+    if (frame_size < min_frame_size || frame_size % TPACKET_ALIGNMENT != 0 || frame_size > block_size)
+        return TCS_ERROR_INVALID_ARGUMENT;
+    if (block_count == 0 || block_count > UINT_MAX / (block_size / frame_size) || block_count > SIZE_MAX / block_size)
+        return TCS_ERROR_INVALID_ARGUMENT;
+
+    int version = TPACKET_V2;
+    if (setsockopt(socket, SOL_PACKET, PACKET_VERSION, &version, sizeof(version)) != 0)
+        return errno == EBUSY ? TCS_ERROR_INVALID_ARGUMENT : errno2retcode(errno); // EBUSY: the socket has a ring
+
+    struct tpacket_req req;
+    memset(&req, 0, sizeof(req));
+    req.tp_block_size = (unsigned int)block_size;
+    req.tp_block_nr = (unsigned int)block_count;
+    req.tp_frame_size = (unsigned int)frame_size;
+    req.tp_frame_nr = (unsigned int)(block_size / frame_size * block_count);
+    if (setsockopt(socket, SOL_PACKET, PACKET_TX_RING, &req, sizeof(req)) != 0)
+        return errno2retcode(errno);
+
+    size_t map_size = block_size * block_count;
+    void* map = mmap(NULL, map_size, PROT_READ | PROT_WRITE, MAP_SHARED, socket, 0);
+    if (map == MAP_FAILED)
+    {
+        TcsResult sts = errno2retcode(errno);
+        packet_ring_unset(socket, PACKET_TX_RING);
+        return sts;
+    }
+
+    struct TcsPacketRing* ring = (struct TcsPacketRing*)tcs_lib_malloc(sizeof(struct TcsPacketRing));
+    if (ring == NULL)
+    {
+        munmap(map, map_size);
+        packet_ring_unset(socket, PACKET_TX_RING);
+        return TCS_ERROR_MEMORY;
+    }
+    memset(ring, 0, sizeof(struct TcsPacketRing));
+    ring->socket = socket;
+    ring->ring_option = PACKET_TX_RING;
+    ring->map = (uint8_t*)map;
+    ring->map_size = map_size;
+    ring->block_size = block_size;
+    ring->block_count = block_count;
+    ring->frame_size = frame_size;
+    ring->frames_per_block = block_size / frame_size;
+    ring->frame_count = ring->frames_per_block * block_count;
+
+    *out_ring = ring;
+    return TCS_SUCCESS;
+#else
+    (void)block_size;
+    (void)block_count;
+    (void)frame_size;
+    return TCS_ERROR_NOT_SUPPORTED;
+#endif
+}
+
+TcsResult tcs_packet_ring_tx_acquire(struct TcsPacketRing* ring, uint8_t** out_data, size_t* out_capacity)
+{
+    if (ring == NULL || out_data == NULL || out_capacity == NULL)
+        return TCS_ERROR_INVALID_ARGUMENT;
+
+#if TCS_HAS_AF_PACKET
+    if (ring->ring_option != PACKET_TX_RING)
+        return TCS_ERROR_INVALID_ARGUMENT;
+
+    struct tpacket2_hdr* header = packet_ring_tx_frame(ring, ring->current_frame);
+    // Acquire pairs with the kernel releasing the frame after transmission
+    uint32_t status = __atomic_load_n(&header->tp_status, __ATOMIC_ACQUIRE);
+    // A frame the kernel rejected is handed back as free, tcs_packet_ring_tx_flush() has reported the error
+    if (status != TP_STATUS_AVAILABLE && status != TP_STATUS_WRONG_FORMAT)
+        return TCS_ERROR_WOULD_BLOCK;
+
+    *out_data = (uint8_t*)header + PACKET_RING_TX_DATA_OFFSET;
+    *out_capacity = ring->frame_size - PACKET_RING_TX_DATA_OFFSET;
+    ring->is_frame_acquired = true;
+    return TCS_SUCCESS;
+#else
+    return TCS_ERROR_NOT_SUPPORTED;
+#endif
+}
+
+TcsResult tcs_packet_ring_tx_commit(struct TcsPacketRing* ring, size_t frame_size)
+{
+    if (ring == NULL)
+        return TCS_ERROR_INVALID_ARGUMENT;
+
+#if TCS_HAS_AF_PACKET
+    if (ring->ring_option != PACKET_TX_RING)
+        return TCS_ERROR_INVALID_ARGUMENT;
+    if (frame_size == 0 || frame_size > ring->frame_size - PACKET_RING_TX_DATA_OFFSET)
+        return TCS_ERROR_INVALID_ARGUMENT;
+    if (!ring->is_frame_acquired)
+        return TCS_ERROR_INVALID_ARGUMENT;
+
+    struct tpacket2_hdr* header = packet_ring_tx_frame(ring, ring->current_frame);
+
+    header->tp_len = (uint32_t)frame_size;
+    header->tp_snaplen = (uint32_t)frame_size;
+    // Release makes the frame content visible before the kernel sees the request
+    __atomic_store_n(&header->tp_status, TP_STATUS_SEND_REQUEST, __ATOMIC_RELEASE);
+
+    ring->is_frame_acquired = false;
+    ring->current_frame = (ring->current_frame + 1) % ring->frame_count;
+    return TCS_SUCCESS;
+#else
+    (void)frame_size;
+    return TCS_ERROR_NOT_SUPPORTED;
+#endif
+}
+
+TcsResult tcs_packet_ring_tx_flush(struct TcsPacketRing* ring, const struct TcsAddress* destination_address)
+{
+    if (ring == NULL)
+        return TCS_ERROR_INVALID_ARGUMENT;
+
+#if TCS_HAS_AF_PACKET
+    if (ring->ring_option != PACKET_TX_RING)
+        return TCS_ERROR_INVALID_ARGUMENT;
+
+    struct sockaddr_storage native_address;
+    memset(&native_address, 0, sizeof native_address);
+    socklen_t native_address_size = 0;
+    if (destination_address != NULL)
+    {
+        TcsResult sts = sockaddr2native(destination_address, &native_address, &native_address_size);
+        if (sts != TCS_SUCCESS)
+            return sts;
+    }
+
+    // All frames with TP_STATUS_SEND_REQUEST are sent by this single call
+    ssize_t sent = sendto(ring->socket,
+                          NULL,
+                          0,
+                          0,
+                          destination_address != NULL ? (const struct sockaddr*)&native_address : NULL,
+                          native_address_size);
+    if (sent < 0)
+        return errno2retcode(errno);
+    return TCS_SUCCESS;
+#else
+    (void)destination_address;
+    return TCS_ERROR_NOT_SUPPORTED;
+#endif
+}
+
+// ######## Socket Options ########
+
+TcsResult tcs_opt_set(TcsSocket socket,
+                      int32_t level,
+                      int32_t option_name,
+                      const void* option_value,
+                      size_t option_size)
+{
+    if (socket == TCS_SOCKET_INVALID)
+        return TCS_ERROR_INVALID_ARGUMENT;
+
+    if (setsockopt(socket, (int)level, (int)option_name, (const char*)option_value, (socklen_t)option_size) == 0)
+        return TCS_SUCCESS;
+    else
+        return errno2retcode(errno);
+}
+
+TcsResult tcs_opt_get(TcsSocket socket, int32_t level, int32_t option_name, void* out_option_value, size_t* option_size)
+{
+    if (socket == TCS_SOCKET_INVALID || out_option_value == NULL || option_size == NULL)
+        return TCS_ERROR_INVALID_ARGUMENT;
+
+    socklen_t optlen = (socklen_t)*option_size;
+    if (getsockopt(socket, (int)level, (int)option_name, (void*)out_option_value, &optlen) == 0)
+    {
+        *option_size = (size_t)optlen;
+        // Linux sets the buffer size to the doubled because of internal use and returns the full doubled size including internal part
+#ifdef __linux__
+        if (level == TCS_SOL_SOCKET && (option_name == TCS_SO_RCVBUF || option_name == TCS_SO_SNDBUF))
+        {
+            *(unsigned int*)out_option_value /= 2;
+        }
+#endif
+        return TCS_SUCCESS;
+    }
+    else
+    {
+        return errno2retcode(errno);
+    }
+}
+
+// tcs_opt_broadcast_set() is defined in tinycsocket_common.c
+// tcs_opt_broadcast_get() is defined in tinycsocket_common.c
+// tcs_opt_keep_alive_set() is defined in tinycsocket_common.c
+// tcs_opt_keep_alive_get() is defined in tinycsocket_common.c
+// tcs_opt_reuse_address_set() is defined in tinycsocket_common.c
+TcsResult tcs_opt_reuse_address_set(TcsSocket socket, bool do_allow_reuse_address)
+{
+    if (socket == TCS_SOCKET_INVALID)
+        return TCS_ERROR_INVALID_ARGUMENT;
+
+    int b = do_allow_reuse_address ? 1 : 0;
+    return tcs_opt_set(socket, TCS_SOL_SOCKET, TCS_SO_REUSEADDR, &b, sizeof(b));
+}
+
+TcsResult tcs_opt_reuse_address_get(TcsSocket socket, bool* is_reuse_address_allowed)
+{
+    if (socket == TCS_SOCKET_INVALID || is_reuse_address_allowed == NULL)
+        return TCS_ERROR_INVALID_ARGUMENT;
+    int b = 0;
+    size_t s = sizeof(b);
+    TcsResult sts = tcs_opt_get(socket, TCS_SOL_SOCKET, TCS_SO_REUSEADDR, &b, &s);
+    *is_reuse_address_allowed = b;
+    return sts;
+}
+
+TcsResult tcs_opt_reuse_port_set(TcsSocket socket, bool do_allow_reuse_port)
+{
+    if (socket == TCS_SOCKET_INVALID)
+        return TCS_ERROR_INVALID_ARGUMENT;
+
+    int b = do_allow_reuse_port ? 1 : 0;
+    return tcs_opt_set(socket, TCS_SOL_SOCKET, TCS_SO_REUSEPORT, &b, sizeof(b));
+}
+
+TcsResult tcs_opt_reuse_port_get(TcsSocket socket, bool* is_reuse_port_allowed)
+{
+    if (socket == TCS_SOCKET_INVALID || is_reuse_port_allowed == NULL)
+        return TCS_ERROR_INVALID_ARGUMENT;
+    int b = 0;
+    size_t s = sizeof(b);
+    TcsResult sts = tcs_opt_get(socket, TCS_SOL_SOCKET, TCS_SO_REUSEPORT, &b, &s);
+    *is_reuse_port_allowed = b;
+    return sts;
+}
+
+// tcs_opt_send_buffer_size_set() is defined in tinycsocket_common.c
+// tcs_opt_send_buffer_size_get() is defined in tinycsocket_common.c
+// tcs_opt_receive_buffer_size_set() is defined in tinycsocket_common.c
+// tcs_opt_receive_buffer_size_get() is defined in tinycsocket_common.c
+
+TcsResult tcs_opt_receive_timeout_set(TcsSocket socket, int timeout_ms)
+{
+    if (socket == TCS_SOCKET_INVALID || timeout_ms < 0)
+        return TCS_ERROR_INVALID_ARGUMENT;
+
+    struct timeval tv;
+    tv.tv_sec = timeout_ms / 1000;
+    tv.tv_usec = (timeout_ms % 1000) * 1000;
+
+    return tcs_opt_set(socket, TCS_SOL_SOCKET, TCS_SO_RCVTIMEO, &tv, sizeof(tv));
+}
+
+TcsResult tcs_opt_receive_timeout_get(TcsSocket socket, int* timeout_ms)
+{
+    if (socket == TCS_SOCKET_INVALID || timeout_ms == NULL)
+        return TCS_ERROR_INVALID_ARGUMENT;
+
+    struct timeval tv = {0, 0};
+    size_t tv_size = sizeof(tv);
+    TcsResult sts = tcs_opt_get(socket, TCS_SOL_SOCKET, TCS_SO_RCVTIMEO, &tv, &tv_size);
+
+    if (sts == TCS_SUCCESS)
+    {
+        int c = 0;
+        c += (int)tv.tv_sec * 1000;
+        c += (int)tv.tv_usec / 1000;
+        *timeout_ms = c;
+    }
+    return sts;
+}
+
+TcsResult tcs_opt_linger_set(TcsSocket socket, bool do_linger, int timeout_seconds)
+{
+    if (socket == TCS_SOCKET_INVALID)
+        return TCS_ERROR_INVALID_ARGUMENT;
+
+    struct linger l = {(u_short)do_linger, (u_short)timeout_seconds};
+    return tcs_opt_set(socket, TCS_SOL_SOCKET, TCS_SO_LINGER, &l, sizeof(l));
+}
+
+TcsResult tcs_opt_linger_get(TcsSocket socket, bool* do_linger, int* timeout_seconds)
+{
+    if (socket == TCS_SOCKET_INVALID || (do_linger == NULL && timeout_seconds == NULL))
+        return TCS_ERROR_INVALID_ARGUMENT;
+
+    struct linger l = {0, 0};
+    size_t l_size = sizeof(l);
+    TcsResult sts = tcs_opt_get(socket, TCS_SOL_SOCKET, TCS_SO_LINGER, &l, &l_size);
+    if (sts == TCS_SUCCESS)
+    {
+        if (do_linger)
+            *do_linger = l.l_onoff;
+        if (timeout_seconds)
+            *timeout_seconds = l.l_linger;
+    }
+
+    return sts;
+}
+
+// tcs_opt_ip_no_delay_set() is defined in tinycsocket_common.c
+// tcs_opt_ip_no_delay_get() is defined in tinycsocket_common.c
+
+TcsResult tcs_opt_tcp_fast_open_set(TcsSocket socket, int queue_length)
+{
+    if (socket == TCS_SOCKET_INVALID || queue_length < 0)
+        return TCS_ERROR_INVALID_ARGUMENT;
+
+#if defined(TCP_FASTOPEN)
+    TcsResult sts = tcs_opt_set(socket, IPPROTO_TCP, TCP_FASTOPEN, &queue_length, sizeof(queue_length));
+    // Kernel without TFO, the listener keeps working with normal handshakes
+    if (sts == TCS_ERROR_NOT_SUPPORTED)
+        return TCS_SUCCESS;
+    return sts;
+#else
+    return TCS_SUCCESS;
+#endif
+}
+
+TcsResult tcs_opt_tcp_fast_open_get(TcsSocket socket, int* queue_length)
+{
+    if (socket == TCS_SOCKET_INVALID || queue_length == NULL)
+        return TCS_ERROR_INVALID_ARGUMENT;
+
+    *queue_length = 0;
+#if defined(TCP_FASTOPEN)
+    int length = 0;
+    size_t length_size = sizeof(length);
+    TcsResult sts = tcs_opt_get(socket, IPPROTO_TCP, TCP_FASTOPEN, &length, &length_size);
+    if (sts == TCS_ERROR_NOT_SUPPORTED)
+        return TCS_SUCCESS;
+    if (sts != TCS_SUCCESS)
+        return sts;
+    *queue_length = length;
+#endif
+    return TCS_SUCCESS;
+}
+
+TcsResult tcs_opt_tcp_fast_open_connect_set(TcsSocket socket, bool do_fast_open)
+{
+    if (socket == TCS_SOCKET_INVALID)
+        return TCS_ERROR_INVALID_ARGUMENT;
+
+#if defined(TCP_FASTOPEN_CONNECT)
+    int enable = do_fast_open ? 1 : 0;
+    TcsResult sts = tcs_opt_set(socket, IPPROTO_TCP, TCP_FASTOPEN_CONNECT, &enable, sizeof(enable));
+    // Kernel older than 4.11, tcs_connect() does a normal handshake
+    if (sts == TCS_ERROR_NOT_SUPPORTED)
+        return TCS_SUCCESS;
+    return sts;
+#else
+    (void)do_fast_open;
+    return TCS_SUCCESS;
+#endif
+}
+
+TcsResult tcs_opt_tcp_fast_open_connect_get(TcsSocket socket, bool* is_fast_open)
+{
+    if (socket == TCS_SOCKET_INVALID || is_fast_open == NULL)
+        return TCS_ERROR_INVALID_ARGUMENT;
+
+    *is_fast_open = false;
+#if defined(TCP_FASTOPEN_CONNECT)
+    int enabled = 0;
+    size_t enabled_size = sizeof(enabled);
+    TcsResult sts = tcs_opt_get(socket, IPPROTO_TCP, TCP_FASTOPEN_CONNECT, &enabled, &enabled_size);
+    if (sts == TCS_ERROR_NOT_SUPPORTED)
+        return TCS_SUCCESS;
+    if (sts != TCS_SUCCESS)
+        return sts;
+    *is_fast_open = enabled != 0;
+#endif
+    return TCS_SUCCESS;
+}
+// tcs_opt_out_of_band_inline_set() is defined in tinycsocket_common.c
+// tcs_opt_out_of_band_inline_get() is defined in tinycsocket_common.c
+// tcs_opt_priority_set() is defined in tinycsocket_common.c
+// tcs_opt_priority_get() is defined in tinycsocket_common.c
+
+TcsResult tcs_opt_nonblocking_set(TcsSocket socket, bool do_non_blocking)
+{
+    if (socket == TCS_SOCKET_INVALID)
+        return TCS_ERROR_INVALID_ARGUMENT;
+
+#ifdef FIONBIO
+    // One syscall instead of a F_GETFL and F_SETFL pair
+    int mode = do_non_blocking ? 1 : 0;
+    if (ioctl(socket, FIONBIO, &mode) == -1)
+        return errno2retcode(errno);
+#else
+    int flags = fcntl(socket, F_GETFL, 0);
+    if (flags == -1)
+        return errno2retcode(errno);
+
+    if (do_non_blocking)
+        flags |= O_NONBLOCK; /* sätt biten */
+    else
+        flags &= ~O_NONBLOCK; /* rensa biten */
+
+    if (fcntl(socket, F_SETFL, flags) == -1)
+        return errno2retcode(errno);
+#endif
+
+    return TCS_SUCCESS;
+}
+
+TcsResult tcs_opt_nonblocking_get(TcsSocket socket, bool* is_non_blocking)
+{
+    if (socket == TCS_SOCKET_INVALID || is_non_blocking == NULL)
+        return TCS_ERROR_INVALID_ARGUMENT;
+
+    int flags = fcntl(socket, F_GETFL, 0);
+    if (flags == -1)
+        return errno2retcode(errno);
+
+    *is_non_blocking = (flags & O_NONBLOCK) != 0;
+    return TCS_SUCCESS;
+}
+
+TcsResult tcs_opt_tx_timestamping_set(TcsSocket socket, bool do_timestamp)
+{
+    if (socket == TCS_SOCKET_INVALID)
+        return TCS_ERROR_INVALID_ARGUMENT;
+
+#if TCS_HAS_TX_TIMESTAMPING
+    // OPT_TSONLY skips looping the payload back to the error queue, only the timestamp is of interest
+    int flags = 0;
+    if (do_timestamp)
+        flags = SOF_TIMESTAMPING_TX_SOFTWARE | SOF_TIMESTAMPING_SOFTWARE | SOF_TIMESTAMPING_OPT_ID |
+                SOF_TIMESTAMPING_OPT_TSONLY;
+    if (setsockopt(socket, SOL_SOCKET, SO_TIMESTAMPING, &flags, sizeof(flags)) != 0)
+        return errno2retcode(errno);
+    return TCS_SUCCESS;
+#else
+    (void)do_timestamp;
+    return TCS_ERROR_NOT_SUPPORTED;
+#endif
+}
+
+TcsResult tcs_opt_tx_timestamping_get(TcsSocket socket, bool* is_timestamping)
+{
+    if (socket == TCS_SOCKET_INVALID || is_timestamping == NULL)
+        return TCS_ERROR_INVALID_ARGUMENT;
+
+#if TCS_HAS_TX_TIMESTAMPING
+    int flags = 0;
+    socklen_t flags_size = sizeof(flags);
+    if (getsockopt(socket, SOL_SOCKET, SO_TIMESTAMPING, &flags, &flags_size) != 0)
+        return errno2retcode(errno);
+    *is_timestamping = (flags & SOF_TIMESTAMPING_TX_SOFTWARE) != 0;
+    return TCS_SUCCESS;
+#else
+    return TCS_ERROR_NOT_SUPPORTED;
+#endif
+}
+
+TcsResult tcs_opt_packet_info_set(TcsSocket socket, bool do_receive_packet_info)
+{
+    if (socket == TCS_SOCKET_INVALID)
+        return TCS_ERROR_INVALID_ARGUMENT;
+
+#if TCS_HAS_PKTINFO
+    TcsFamily family = TCS_FAMILY_ANY;
+    TcsResult sts = tcs_address_socket_family(socket, &family);
+    if (sts != TCS_SUCCESS)
+        return sts;
+
+    int enable = do_receive_packet_info ? 1 : 0;
+    if (family.native == TCS_FAMILY_IPV4.native)
+        return tcs_opt_set(socket, IPPROTO_IP, IP_PKTINFO, &enable, sizeof(enable));
+    if (family.native == TCS_FAMILY_IPV6.native)
+        return tcs_opt_set(socket, IPPROTO_IPV6, IPV6_RECVPKTINFO, &enable, sizeof(enable));
+    return TCS_ERROR_NOT_SUPPORTED;
+#else
+    (void)do_receive_packet_info;
+    return TCS_ERROR_NOT_SUPPORTED;
+#endif
+}
+
+TcsResult tcs_opt_packet_info_get(TcsSocket socket, bool* is_packet_info_received)
+{
+    if (socket == TCS_SOCKET_INVALID || is_packet_info_received == NULL)
+        return TCS_ERROR_INVALID_ARGUMENT;
+
+#if TCS_HAS_PKTINFO
+    TcsFamily family = TCS_FAMILY_ANY;
+    TcsResult sts = tcs_address_socket_family(socket, &family);
+    if (sts != TCS_SUCCESS)
+        return sts;
+
+    int enabled = 0;
+    size_t enabled_size = sizeof(enabled);
+    if (family.native == TCS_FAMILY_IPV4.native)
+        sts = tcs_opt_get(socket, IPPROTO_IP, IP_PKTINFO, &enabled, &enabled_size);
+    else if (family.native == TCS_FAMILY_IPV6.native)
+        sts = tcs_opt_get(socket, IPPROTO_IPV6, IPV6_RECVPKTINFO, &enabled, &enabled_size);
+    else
+        return TCS_ERROR_NOT_SUPPORTED;
+    if (sts != TCS_SUCCESS)
+        return sts;
+    *is_packet_info_received = enabled != 0;
+    return TCS_SUCCESS;
+#else
+    return TCS_ERROR_NOT_SUPPORTED;
+#endif
+}
+
+TcsResult tcs_opt_packet_qdisc_bypass_set(TcsSocket socket, bool do_bypass)
+{
+    if (socket == TCS_SOCKET_INVALID)
+        return TCS_ERROR_INVALID_ARGUMENT;
+
+#if TCS_HAS_AF_PACKET && defined(PACKET_QDISC_BYPASS)
+    int bypass = do_bypass ? 1 : 0;
+    return tcs_opt_set(socket, SOL_PACKET, PACKET_QDISC_BYPASS, &bypass, sizeof(bypass));
+#else
+    (void)do_bypass;
+    return TCS_ERROR_NOT_SUPPORTED;
+#endif
+}
+
+TcsResult tcs_opt_packet_qdisc_bypass_get(TcsSocket socket, bool* is_bypassed)
+{
+    if (socket == TCS_SOCKET_INVALID || is_bypassed == NULL)
+        return TCS_ERROR_INVALID_ARGUMENT;
+
+#if TCS_HAS_AF_PACKET && defined(PACKET_QDISC_BYPASS)
+    int bypass = 0;
+    size_t bypass_size = sizeof(bypass);
+    TcsResult sts = tcs_opt_get(socket, SOL_PACKET, PACKET_QDISC_BYPASS, &bypass, &bypass_size);
+    if (sts != TCS_SUCCESS)
+        return sts;
+    *is_bypassed = bypass != 0;
+    return TCS_SUCCESS;
+#else
+    return TCS_ERROR_NOT_SUPPORTED;
+#endif
+}
+
+TcsResult tcs_opt_packet_fanout_join(TcsSocket socket, uint16_t group_id, TcsPacketFanoutMode mode)
+{
+    if (socket == TCS_SOCKET_INVALID)
+        return TCS_ERROR_INVALID_ARGUMENT;
+
+#if TCS_HAS_AF_PACKET && defined(PACKET_FANOUT)
+    uint32_t type = 0;
+    switch (mode)
+    {
+        case TCS_PACKET_FANOUT_HASH:
+            // Reassemble IP fragments first so they hash like the rest of the flow
+            type = PACKET_FANOUT_HASH | PACKET_FANOUT_FLAG_DEFRAG;
+            break;
+        case TCS_PACKET_FANOUT_LB:
+            type = PACKET_FANOUT_LB;
+            break;
+        case TCS_PACKET_FANOUT_CPU:
+            type = PACKET_FANOUT_CPU;
+            break;
+        case TCS_PACKET_FANOUT_ROLLOVER:
+            type = PACKET_FANOUT_ROLLOVER;
+            break;
+        default:
+            return TCS_ERROR_INVALID_ARGUMENT;
+    }
+    uint32_t fanout = (uint32_t)group_id | (type << 16);
+    return tcs_opt_set(socket, SOL_PACKET, PACKET_FANOUT, &fanout, sizeof(fanout));
+#else
+    (void)group_id;
+    (void)mode;
+    return TCS_ERROR_NOT_SUPPORTED;
+#endif
+}
+
+TcsResult tcs_opt_reuse_port_steer_by_cpu(TcsSocket socket, size_t group_size)
+{
+    if (socket == TCS_SOCKET_INVALID || group_size == 0 || group_size > UINT32_MAX)
+        return TCS_ERROR_INVALID_ARGUMENT;
+
+#if TCS_HAS_REUSEPORT_CBPF
+    // The returned value is the index of the socket in the group
+    struct sock_filter instructions[] = {
+        BPF_STMT(BPF_LD | BPF_W | BPF_ABS, (uint32_t)(SKF_AD_OFF + SKF_AD_CPU)),
+        BPF_STMT(BPF_ALU | BPF_MOD | BPF_K, (uint32_t)group_size),
+        BPF_STMT(BPF_RET | BPF_A, 0),
+    };
+    struct sock_fprog program;
+    memset(&program, 0, sizeof(program));
+    program.len = (unsigned short)(sizeof(instructions) / sizeof(instructions[0]));
+    program.filter = instructions;
+    return tcs_opt_set(socket, SOL_SOCKET, SO_ATTACH_REUSEPORT_CBPF, &program, sizeof(program));
+#else
+    return TCS_ERROR_NOT_SUPPORTED;
+#endif
+}
+
+#if TCS_HAS_SOCKET_FILTER
+tcs_static_assert(filter_instruction_layout, sizeof(struct TcsFilterInstruction) == sizeof(struct sock_filter));
+#endif
+
+TcsResult tcs_opt_filter_attach(TcsSocket socket, const struct TcsFilter* filter)
+{
+    if (socket == TCS_SOCKET_INVALID || filter == NULL)
+        return TCS_ERROR_INVALID_ARGUMENT;
+    if (filter->length == 0 || filter->length > TCS_CFG_FILTER_MAX_INSTRUCTIONS)
+        return TCS_ERROR_INVALID_ARGUMENT;
+
+#if TCS_HAS_SOCKET_FILTER
+    struct sock_filter instructions[TCS_CFG_FILTER_MAX_INSTRUCTIONS];
+    memcpy(instructions, filter->instructions, filter->length * sizeof(struct sock_filter));
+
+    struct sock_fprog program;
+    memset(&program, 0, sizeof(program));
+    program.len = (unsigned short)filter->length;
+    program.filter = instructions;
+    return tcs_opt_set(socket, SOL_SOCKET, SO_ATTACH_FILTER, &program, sizeof(program));
+#else
+    return TCS_ERROR_NOT_SUPPORTED;
+#endif
+}
+
+TcsResult tcs_opt_filter_detach(TcsSocket socket)
+{
+    if (socket == TCS_SOCKET_INVALID)
+        return TCS_ERROR_INVALID_ARGUMENT;
+
+#if TCS_HAS_SOCKET_FILTER
+    int unused = 0;
+    return tcs_opt_set(socket, SOL_SOCKET, SO_DETACH_FILTER, &unused, sizeof(unused));
+#else
+    return TCS_ERROR_NOT_SUPPORTED;
+#endif
+}
+
+TcsResult tcs_opt_membership_add(TcsSocket socket, const struct TcsAddress* multicast_address)
+{
+    if (socket == TCS_SOCKET_INVALID)
+        return TCS_ERROR_INVALID_ARGUMENT;
+
+    if (multicast_address == NULL)
+        return TCS_ERROR_INVALID_ARGUMENT;
+
+    struct TcsAddress local_address = TCS_ADDRESS_NONE;
+    TcsResult sts = tcs_address_socket_local(socket, &local_address);
+    if (sts != TCS_SUCCESS)
+        return sts;
+
+    if (local_address.family.native != multicast_address->family.native)
+        return TCS_ERROR_INVALID_ARGUMENT;
+
+    return tcs_opt_membership_add_to(socket, &local_address, multicast_address);
+}
+
+// tcs_opt_membership_add_str() is defined in tinycsocket_common.c
+
+TcsResult tcs_opt_membership_add_to(TcsSocket socket,
+                                    const struct TcsAddress* local_address,
+                                    const struct TcsAddress* multicast_address)
+{
+    if (socket == TCS_SOCKET_INVALID)
+        return TCS_ERROR_INVALID_ARGUMENT;
+
+    if (multicast_address == NULL)
+        return TCS_ERROR_INVALID_ARGUMENT;
+
+    if (local_address == NULL)
+        return TCS_ERROR_INVALID_ARGUMENT;
+
+    if (local_address->family.native != multicast_address->family.native)
+        return TCS_ERROR_INVALID_ARGUMENT;
+
+    struct sockaddr_storage local_address_native;
+    memset(&local_address_native, 0, sizeof(struct sockaddr_storage));
+    socklen_t local_address_native_size = 0;
+    TcsResult sts_la2n = sockaddr2native(local_address, &local_address_native, &local_address_native_size);
+    if (sts_la2n != TCS_SUCCESS)
+        return sts_la2n;
+
+    struct sockaddr_storage multicast_address_native;
+    memset(&multicast_address_native, 0, sizeof(struct sockaddr_storage));
+    socklen_t multicast_address_native_size = 0;
+    TcsResult sts_ma2n = sockaddr2native(multicast_address, &multicast_address_native, &multicast_address_native_size);
+    if (sts_ma2n != TCS_SUCCESS)
+        return sts_ma2n;
+
+    if (multicast_address->family.native == TCS_FAMILY_IPV4.native)
+    {
+        const struct sockaddr_in* address_native_local_p = (struct sockaddr_in*)&local_address_native;
+        const struct sockaddr_in* address_native_multicast_p = (struct sockaddr_in*)&multicast_address_native;
+
+        struct ip_mreq mreq;
+        memset(&mreq, 0, sizeof mreq);
+
+        mreq.imr_interface.s_addr = address_native_local_p->sin_addr.s_addr;
+        mreq.imr_multiaddr.s_addr = address_native_multicast_p->sin_addr.s_addr;
+
+        TcsResult sts_opt = tcs_opt_set(socket, TCS_SOL_IP, IP_ADD_MEMBERSHIP, &mreq, sizeof(mreq));
+        if (sts_opt != TCS_SUCCESS)
+            return sts_opt;
+        return TCS_SUCCESS;
+    }
+    else if (multicast_address->family.native == TCS_FAMILY_IPV6.native)
+    {
+        struct ipv6_mreq mreq6;
+        memset(&mreq6, 0, sizeof mreq6);
+        memcpy(&mreq6.ipv6mr_multiaddr, multicast_address->data.ipv6.address.bytes, 16);
+        mreq6.ipv6mr_interface = (unsigned int)local_address->data.ipv6.scope_id;
+
+        TcsResult sts_opt = tcs_opt_set(socket, IPPROTO_IPV6, IPV6_JOIN_GROUP, &mreq6, sizeof(mreq6));
+        if (sts_opt != TCS_SUCCESS)
+            return sts_opt;
+        return TCS_SUCCESS;
+    }
+    else if (multicast_address->family.native == TCS_FAMILY_PACKET.native)
+    {
+#if TCS_HAS_AF_PACKET
+        const struct sockaddr_ll* address_native_local_p = (struct sockaddr_ll*)&local_address_native;
+        const struct sockaddr_ll* address_native_multicast_p = (struct sockaddr_ll*)&multicast_address_native;
+
+        struct packet_mreq mreq;
+        memset(&mreq, 0, sizeof mreq);
+        mreq.mr_ifindex = address_native_local_p->sll_ifindex;
+        mreq.mr_type = PACKET_MR_MULTICAST;
+        memcpy(mreq.mr_address, address_native_multicast_p->sll_addr, ETH_ALEN);
+        mreq.mr_alen = ETH_ALEN;
+
+        TcsResult sts_opt = tcs_opt_set(socket, SOL_PACKET, PACKET_ADD_MEMBERSHIP, &mreq, sizeof(mreq));
+        if (sts_opt != TCS_SUCCESS)
+            return sts_opt;
+        return TCS_SUCCESS;
+#else
+        return TCS_ERROR_NOT_SUPPORTED;
+#endif
+    }
+    return TCS_ERROR_NOT_SUPPORTED;
+}
+
+// tcs_opt_membership_drop_str() is defined in tinycsocket_common.c
+
+TcsResult tcs_opt_membership_drop(TcsSocket socket, const struct TcsAddress* multicast_address)
+{
+    if (socket == TCS_SOCKET_INVALID)
+        return TCS_ERROR_INVALID_ARGUMENT;
+
+    if (multicast_address == NULL)
+        return TCS_ERROR_INVALID_ARGUMENT;
+
+    struct TcsAddress local_address = TCS_ADDRESS_NONE;
+    TcsResult sts = tcs_address_socket_local(socket, &local_address);
+    if (sts != TCS_SUCCESS)
+        return sts;
+
+    if (local_address.family.native != multicast_address->family.native)
+        return TCS_ERROR_INVALID_ARGUMENT;
+
+    return tcs_opt_membership_drop_from(socket, &local_address, multicast_address);
+}
+
+TcsResult tcs_opt_membership_drop_from(TcsSocket socket,
+                                       const struct TcsAddress* local_address,
+                                       const struct TcsAddress* multicast_address)
+{
+    if (socket == TCS_SOCKET_INVALID)
+        return TCS_ERROR_INVALID_ARGUMENT;
+
+    if (multicast_address == NULL)
+        return TCS_ERROR_INVALID_ARGUMENT;
+
+    if (local_address == NULL)
+        return TCS_ERROR_INVALID_ARGUMENT;
+
+    if (local_address->family.native != multicast_address->family.native)
+        return TCS_ERROR_INVALID_ARGUMENT;
+
+    struct sockaddr_storage local_address_native;
+    memset(&local_address_native, 0, sizeof(struct sockaddr_storage));
+    socklen_t local_address_native_size = 0;
+    TcsResult sts_la2n = sockaddr2native(local_address, &local_address_native, &local_address_native_size);
+    if (sts_la2n != TCS_SUCCESS)
+        return sts_la2n;
+
+    struct sockaddr_storage multicast_address_native;
+    memset(&multicast_address_native, 0, sizeof(struct sockaddr_storage));
+    socklen_t multicast_address_native_size = 0;
+    TcsResult sts_ma2n = sockaddr2native(multicast_address, &multicast_address_native, &multicast_address_native_size);
+    if (sts_ma2n != TCS_SUCCESS)
+        return sts_ma2n;
+
+    if (multicast_address->family.native == TCS_FAMILY_IPV4.native)
+    {
+        const struct sockaddr_in* address_native_local_p = (struct sockaddr_in*)&local_address_native;
+        const struct sockaddr_in* address_native_multicast_p = (struct sockaddr_in*)&multicast_address_native;
+
+        struct ip_mreq mreq;
+        memset(&mreq, 0, sizeof mreq);
+
+        mreq.imr_interface.s_addr = address_native_local_p->sin_addr.s_addr;
+        mreq.imr_multiaddr.s_addr = address_native_multicast_p->sin_addr.s_addr;
+
+        TcsResult sts_opt = tcs_opt_set(socket, TCS_SOL_IP, IP_DROP_MEMBERSHIP, &mreq, sizeof(mreq));
+        if (sts_opt != TCS_SUCCESS)
+            return sts_opt;
+        return TCS_SUCCESS;
+    }
+    else if (multicast_address->family.native == TCS_FAMILY_IPV6.native)
+    {
+        struct ipv6_mreq mreq6;
+        memset(&mreq6, 0, sizeof mreq6);
+        memcpy(&mreq6.ipv6mr_multiaddr, multicast_address->data.ipv6.address.bytes, 16);
+        mreq6.ipv6mr_interface = (unsigned int)local_address->data.ipv6.scope_id;
+
+        TcsResult sts_opt = tcs_opt_set(socket, IPPROTO_IPV6, IPV6_LEAVE_GROUP, &mreq6, sizeof(mreq6));
+        if (sts_opt != TCS_SUCCESS)
+            return sts_opt;
+        return TCS_SUCCESS;
+    }
+    else if (multicast_address->family.native == TCS_FAMILY_PACKET.native)
+    {
+#if TCS_HAS_AF_PACKET
+        const struct sockaddr_ll* address_native_local_p = (struct sockaddr_ll*)&local_address_native;
+        const struct sockaddr_ll* address_native_multicast_p = (struct sockaddr_ll*)&multicast_address_native;
+
+        struct packet_mreq mreq;
+        memset(&mreq, 0, sizeof mreq);
+        mreq.mr_ifindex = address_native_local_p->sll_ifindex;
+        mreq.mr_type = PACKET_MR_MULTICAST;
+        memcpy(mreq.mr_address, address_native_multicast_p->sll_addr, ETH_ALEN);
+        mreq.mr_alen = ETH_ALEN;
+
+        TcsResult sts_opt = tcs_opt_set(socket, SOL_PACKET, PACKET_DROP_MEMBERSHIP, &mreq, sizeof(mreq));
+        if (sts_opt != TCS_SUCCESS)
+            return sts_opt;
+        return TCS_SUCCESS;
+#else
+        return TCS_ERROR_NOT_SUPPORTED;
+#endif
+    }
+    return TCS_ERROR_NOT_SUPPORTED;
+}
+
+TcsResult tcs_opt_multicast_interface_set(TcsSocket socket, const struct TcsAddress* local_address)
+{
+    if (socket == TCS_SOCKET_INVALID || local_address == NULL)
+        return TCS_ERROR_INVALID_ARGUMENT;
+
+    if (local_address->family.native == TCS_FAMILY_IPV4.native)
+    {
+        struct in_addr iface;
+        iface.s_addr = htonl(local_address->data.ipv4.address);
+        return tcs_opt_set(socket, TCS_SOL_IP, IP_MULTICAST_IF, &iface, sizeof(iface));
+    }
+    else if (local_address->family.native == TCS_FAMILY_IPV6.native)
+    {
+        unsigned int idx = (unsigned int)local_address->data.ipv6.scope_id;
+        return tcs_opt_set(socket, IPPROTO_IPV6, IPV6_MULTICAST_IF, &idx, sizeof(idx));
+    }
+    return TCS_ERROR_INVALID_ARGUMENT;
+}
+
+TcsResult tcs_opt_multicast_loop_set(TcsSocket socket, bool do_loopback)
+{
+    if (socket == TCS_SOCKET_INVALID)
+        return TCS_ERROR_INVALID_ARGUMENT;
+
+    unsigned char val = do_loopback ? 1 : 0;
+    return tcs_opt_set(socket, TCS_SOL_IP, IP_MULTICAST_LOOP, &val, sizeof(val));
+}
+
+TcsResult tcs_opt_multicast_loop_get(TcsSocket socket, bool* is_loopback)
+{
+    if (socket == TCS_SOCKET_INVALID || is_loopback == NULL)
+        return TCS_ERROR_INVALID_ARGUMENT;
+
+    unsigned char val = 0;
+    size_t s = sizeof(val);
+    TcsResult sts = tcs_opt_get(socket, TCS_SOL_IP, IP_MULTICAST_LOOP, &val, &s);
+    *is_loopback = val;
+    return sts;
+}
+
+// ######## Address and Interface Utilities ########
+
+#if TCS_HAS_GETIFADDRS
+TcsResult tcs_interface_list(struct TcsInterface* out_interfaces,
+                             size_t interfaces_length,
+                             size_t* interfaces_populated)
+{
+    if (out_interfaces == NULL && interfaces_populated == NULL)
+        return TCS_ERROR_INVALID_ARGUMENT;
+
+    if (out_interfaces == NULL && interfaces_length != 0)
+        return TCS_ERROR_INVALID_ARGUMENT;
+
+    if (interfaces_populated != NULL)
+        *interfaces_populated = 0;
+
+    struct if_nameindex* interfaces = if_nameindex();
+    if (interfaces == NULL)
+        return errno2retcode(errno);
+
+    for (size_t i = 0; interfaces[i].if_index != 0; ++i)
+    {
+        if (out_interfaces != NULL && i < interfaces_length)
+        {
+            strncpy(out_interfaces[i].name, interfaces[i].if_name, TCS_CFG_INTERFACE_NAME_SIZE - 1);
+            out_interfaces[i].name[TCS_CFG_INTERFACE_NAME_SIZE - 1] = '\0';
+            out_interfaces[i].id = interfaces[i].if_index;
+        }
+        if (interfaces_populated != NULL)
+            *interfaces_populated += 1;
+    }
+
+    if_freenameindex(interfaces);
+    return TCS_SUCCESS;
+}
+#else
+// Fallback using ioctl(SIOCGIFCONF) for systems without if_nameindex (e.g. Android < API 24)
+TcsResult tcs_interface_list(struct TcsInterface* out_interfaces,
+                             size_t interfaces_length,
+                             size_t* interfaces_populated)
+{
+    if (out_interfaces == NULL && interfaces_populated == NULL)
+        return TCS_ERROR_INVALID_ARGUMENT;
+
+    if (out_interfaces == NULL && interfaces_length != 0)
+        return TCS_ERROR_INVALID_ARGUMENT;
+
+    if (interfaces_populated != NULL)
+        *interfaces_populated = 0;
+
+    int fd = socket(AF_INET, SOCK_DGRAM, 0);
+    if (fd < 0)
+        return errno2retcode(errno);
+
+    // Start with stack buffer, grow on heap if truncated
+    char stack_buf[512];
+    char* buf = stack_buf;
+    int buf_len = (int)sizeof(stack_buf);
+    struct ifconf ifc;
+
+    for (;;)
+    {
+        ifc.ifc_len = buf_len;
+        ifc.ifc_buf = buf;
+        if (ioctl(fd, SIOCGIFCONF, &ifc) != 0)
+        {
+            if (buf != stack_buf)
+                tcs_lib_free(buf);
+            close(fd);
+            return errno2retcode(errno);
+        }
+        if (ifc.ifc_len < buf_len)
+            break;
+        // If caller only wants N results (not counting), don't grow beyond what's needed
+        if (out_interfaces != NULL && interfaces_populated == NULL &&
+            (size_t)ifc.ifc_len / sizeof(struct ifreq) >= interfaces_length)
+            break;
+        buf_len *= 2;
+        if (buf != stack_buf)
+            tcs_lib_free(buf);
+        buf = (char*)tcs_lib_malloc((size_t)buf_len);
+        if (buf == NULL)
+        {
+            close(fd);
+            return TCS_ERROR_MEMORY;
+        }
+    }
+
+    size_t count = 0;
+    int offset = 0;
+    while (offset < ifc.ifc_len)
+    {
+        struct ifreq* ifr = (struct ifreq*)(buf + offset);
+        int entry_len = (int)sizeof(struct ifreq);
+
+        if (out_interfaces != NULL && count < interfaces_length)
+        {
+            strncpy(out_interfaces[count].name, ifr->ifr_name, TCS_CFG_INTERFACE_NAME_SIZE - 1);
+            out_interfaces[count].name[TCS_CFG_INTERFACE_NAME_SIZE - 1] = '\0';
+            out_interfaces[count].id = (unsigned int)(count + 1);
+        }
+        count++;
+
+        offset += entry_len;
+    }
+
+    if (interfaces_populated != NULL)
+        *interfaces_populated = count;
+
+    if (buf != stack_buf)
+        tcs_lib_free(buf);
+    close(fd);
+    return TCS_SUCCESS;
+}
+#endif
+
+// Used by tinycsocket_common.c, see the declarations there
+TcsResult tcs_os_address_resolve_native(const char* hostname,
+                                       TcsFamily address_family,
+                                       struct TcsAddress out_addresses[],
+                                       size_t addresses_length,
+                                       size_t* out_length)
+{
+    struct addrinfo native_hints;
+    memset(&native_hints, 0, sizeof native_hints);
+    native_hints.ai_family = address_family.native;
+    native_hints.ai_flags = AI_NUMERICSERV;
+    native_hints.ai_socktype = SOCK_DGRAM;
+    native_hints.ai_protocol = IPPROTO_UDP;
+
+    struct addrinfo* native_addrinfo_list = NULL;
+    int sts = getaddrinfo(hostname, NULL, &native_hints, &native_addrinfo_list);
+
+    // TODO: Move error codes to errno2retcode()
+    if (sts == EAI_SYSTEM)
+        return errno2retcode(errno);
+    else if (sts == EAI_AGAIN)
+        return TCS_ERROR_TEMPORARY_FAILURE;
+    else if (sts == EAI_BADFLAGS)
+        return TCS_ERROR_INVALID_ARGUMENT;
+    else if (sts == EAI_FAIL)
+        return TCS_ERROR_ADDRESS_LOOKUP_FAILED;
+    else if (sts == EAI_FAMILY)
+        return TCS_ERROR_INVALID_ARGUMENT;
+    else if (sts == EAI_MEMORY)
+        return TCS_ERROR_MEMORY;
+    else if (sts == EAI_NONAME)
+        return TCS_ERROR_ADDRESS_LOOKUP_FAILED;
+    else if (sts == EAI_SERVICE)
+        return TCS_ERROR_INVALID_ARGUMENT;
+    else if (native_addrinfo_list == NULL)
+        return TCS_ERROR_UNKNOWN;
+    else if (sts != 0)
+        return errno2retcode(sts);
+
+    size_t i = 0;
+    if (out_addresses == NULL)
+    {
+        for (struct addrinfo* iter = native_addrinfo_list; iter != NULL; iter = iter->ai_next)
+            i++;
+    }
+    else
+    {
+        for (struct addrinfo* iter = native_addrinfo_list; iter != NULL && i < addresses_length; iter = iter->ai_next)
+        {
+            if (iter->ai_addr == NULL)
+                continue;
+            TcsResult convert_address_status = native2sockaddr(iter->ai_addr, &out_addresses[i]);
+            if (convert_address_status != TCS_SUCCESS)
+                continue;
+            i++;
+        }
+    }
+    if (out_length != NULL)
+        *out_length = i;
+
+    freeaddrinfo(native_addrinfo_list);
+
+    if (i == 0)
+        return TCS_ERROR_ADDRESS_LOOKUP_FAILED;
+
+    return TCS_SUCCESS;
+}
+
+// tcs_address_resolve() is defined in tinycsocket_common.c
+// tcs_address_cache_enable() is defined in tinycsocket_common.c
+// tcs_address_cache_disable() is defined in tinycsocket_common.c
+// tcs_address_cache_prefill() is defined in tinycsocket_common.c
+// tcs_address_cache_flush() is defined in tinycsocket_common.c
+
+#if TCS_HAS_GETIFADDRS
+TcsResult tcs_address_list(unsigned int interface_id_filter,
+                           TcsFamily address_family_filter,
+                           struct TcsInterfaceAddress out_interface_addresses[],
+                           size_t interface_addresses_length,
+                           size_t* out_length)
+{
+    if (out_interface_addresses == NULL && out_length == NULL)
+        return TCS_ERROR_INVALID_ARGUMENT;
+    if (out_interface_addresses == NULL && interface_addresses_length != 0)
+        return TCS_ERROR_INVALID_ARGUMENT;
+    if (out_length != NULL)
+        *out_length = 0;
+
+    struct ifaddrs* ifap = NULL;
+    if (getifaddrs(&ifap) == -1)
+    {
+        if (ifap != NULL)
+            freeifaddrs(ifap);
+        return errno2retcode(errno);
+    }
+
+    if (ifap == NULL)
+        return TCS_ERROR_UNKNOWN;
+
+    size_t populated = 0;
+    for (struct ifaddrs* iter = ifap; iter != NULL; iter = iter->ifa_next)
+    {
+        if (iter->ifa_addr == NULL)
+            continue;
+
+        if (interface_id_filter != 0)
+        {
+            unsigned int id = if_nametoindex(iter->ifa_name);
+            if (id == 0)
+            {
+                freeifaddrs(ifap);
+                return errno2retcode(errno);
+            }
+            if (id != interface_id_filter)
+                continue;
+        }
+        if (address_family_filter.native != TCS_FAMILY_ANY.native)
+        {
+            if (address_family_filter.native == -1) /* unsupported sentinel (e.g. PACKET on non-Linux) */
+                continue;
+            if (iter->ifa_addr->sa_family != address_family_filter.native)
+                continue;
+        }
+
+        struct TcsAddress address = TCS_ADDRESS_NONE;
+        TcsResult convert_address_status = native2sockaddr(iter->ifa_addr, &address);
+        if (convert_address_status != TCS_SUCCESS)
+            continue; // skip entries we cannot represent (unknown family, malformed sockaddr, etc.)
+
+        if (out_interface_addresses != NULL && populated < interface_addresses_length)
+        {
+            unsigned int interface_id = if_nametoindex(iter->ifa_name);
+            if (interface_id == 0)
+            {
+                freeifaddrs(ifap);
+                return errno2retcode(errno);
+            }
+
+            strncpy(out_interface_addresses[populated].iface.name, iter->ifa_name, TCS_CFG_INTERFACE_NAME_SIZE - 1);
+            out_interface_addresses[populated].iface.name[TCS_CFG_INTERFACE_NAME_SIZE - 1] = '\0';
+            out_interface_addresses[populated].iface.id = interface_id;
+            out_interface_addresses[populated].address = address;
+            populated++;
+        }
+        if (out_length != NULL)
+            (*out_length)++;
+    }
+
+    freeifaddrs(ifap);
+    return TCS_SUCCESS;
+}
+#else
+// Fallback using ioctl(SIOCGIFCONF) for systems without getifaddrs (e.g. Android < API 24, old SunOS)
+// Limitation: SIOCGIFCONF only returns IPv4 addresses. IPv6 enumeration would require
+// platform-specific mechanisms (Linux: /proc/net/if_inet6 or netlink, Solaris: SIOCGLIFCONF).
+TcsResult tcs_address_list(unsigned int interface_id_filter,
+                           TcsFamily address_family_filter,
+                           struct TcsInterfaceAddress out_interface_addresses[],
+                           size_t interface_addresses_length,
+                           size_t* out_length)
+{
+    if (out_interface_addresses == NULL && out_length == NULL)
+        return TCS_ERROR_INVALID_ARGUMENT;
+    if (out_interface_addresses == NULL && interface_addresses_length != 0)
+        return TCS_ERROR_INVALID_ARGUMENT;
+    if (out_length != NULL)
+        *out_length = 0;
+
+    // Check if we support the requested address family in the ioctl fallback.
+    // IPv4 is always available. AF_PACKET is available on Linux via SIOCGIFHWADDR.
+    bool supported = (address_family_filter.native == TCS_FAMILY_ANY.native ||
+                      address_family_filter.native == TCS_FAMILY_IPV4.native);
+#if TCS_HAS_AF_PACKET
+    supported = supported || (address_family_filter.native == TCS_FAMILY_PACKET.native);
+#endif
+    if (!supported)
+        return TCS_SUCCESS;
+
+    int fd = socket(AF_INET, SOCK_DGRAM, 0);
+    if (fd < 0)
+        return errno2retcode(errno);
+
+    // Start with stack buffer, grow on heap if truncated
+    char stack_buf[512];
+    char* buf = stack_buf;
+    int buf_len = (int)sizeof(stack_buf);
+    struct ifconf ifc;
+
+    for (;;)
+    {
+        ifc.ifc_len = buf_len;
+        ifc.ifc_buf = buf;
+        if (ioctl(fd, SIOCGIFCONF, &ifc) != 0)
+        {
+            if (buf != stack_buf)
+                tcs_lib_free(buf);
+            close(fd);
+            return errno2retcode(errno);
+        }
+        if (ifc.ifc_len < buf_len)
+            break;
+        if (out_interface_addresses != NULL && out_length == NULL &&
+            (size_t)ifc.ifc_len / sizeof(struct ifreq) >= interface_addresses_length)
+            break;
+        buf_len *= 2;
+        if (buf != stack_buf)
+            tcs_lib_free(buf);
+        buf = (char*)tcs_lib_malloc((size_t)buf_len);
+        if (buf == NULL)
+        {
+            close(fd);
+            return TCS_ERROR_MEMORY;
+        }
+    }
+
+    size_t populated = 0;
+    int offset = 0;
+    while (offset < ifc.ifc_len)
+    {
+        struct ifreq* ifr = (struct ifreq*)(buf + offset);
+        int entry_len = (int)sizeof(struct ifreq);
 
-    ssize_t ret = 0;
-    ret = sendmsg(socket, &msg, TCS_DEFAULT_SEND_FLAGS | (int)flags);
+        unsigned int iface_id = if_nametoindex(ifr->ifr_name);
+        if (iface_id == 0)
+        {
+            offset += entry_len;
+            continue;
+        }
+
+        if (interface_id_filter != 0 && iface_id != interface_id_filter)
+        {
+            offset += entry_len;
+            continue;
+        }
+
+        // IPv4 addresses
+        if (address_family_filter.native == TCS_FAMILY_ANY.native ||
+            address_family_filter.native == TCS_FAMILY_IPV4.native)
+        {
+            struct TcsAddress address = TCS_ADDRESS_NONE;
+            TcsResult convert_status = native2sockaddr((struct sockaddr*)&ifr->ifr_addr, &address);
+            if (convert_status == TCS_SUCCESS)
+            {
+                if (out_interface_addresses != NULL && populated < interface_addresses_length)
+                {
+                    strncpy(
+                        out_interface_addresses[populated].iface.name, ifr->ifr_name, TCS_CFG_INTERFACE_NAME_SIZE - 1);
+                    out_interface_addresses[populated].iface.name[TCS_CFG_INTERFACE_NAME_SIZE - 1] = '\0';
+                    out_interface_addresses[populated].iface.id = iface_id;
+                    out_interface_addresses[populated].address = address;
+                    populated++;
+                }
+                if (out_length != NULL)
+                    (*out_length)++;
+            }
+        }
+
+#if TCS_HAS_AF_PACKET
+        // AF_PACKET addresses via SIOCGIFHWADDR (Ethernet only)
+        if (address_family_filter.native == TCS_FAMILY_ANY.native ||
+            address_family_filter.native == TCS_FAMILY_PACKET.native)
+        {
+            struct ifreq hw_req;
+            memset(&hw_req, 0, sizeof(hw_req));
+            strncpy(hw_req.ifr_name, ifr->ifr_name, IFNAMSIZ - 1);
+
+            if (ioctl(fd, SIOCGIFHWADDR, &hw_req) == 0 && hw_req.ifr_hwaddr.sa_family == ARPHRD_ETHER)
+            {
+                if (out_interface_addresses != NULL && populated < interface_addresses_length)
+                {
+                    strncpy(
+                        out_interface_addresses[populated].iface.name, ifr->ifr_name, TCS_CFG_INTERFACE_NAME_SIZE - 1);
+                    out_interface_addresses[populated].iface.name[TCS_CFG_INTERFACE_NAME_SIZE - 1] = '\0';
+                    out_interface_addresses[populated].iface.id = iface_id;
+                    out_interface_addresses[populated].address.family = TCS_FAMILY_PACKET;
+                    out_interface_addresses[populated].address.data.packet.interface_id = iface_id;
+                    memcpy(out_interface_addresses[populated].address.data.packet.mac, hw_req.ifr_hwaddr.sa_data, 6);
+                    populated++;
+                }
+                if (out_length != NULL)
+                    (*out_length)++;
+            }
+        }
+#endif
+
+        offset += entry_len;
+    }
+
+    if (buf != stack_buf)
+        tcs_lib_free(buf);
+    close(fd);
+    return TCS_SUCCESS;
+}
+#endif
+
+TcsResult tcs_address_socket_local(TcsSocket socket, struct TcsAddress* local_address)
+{
+    if (socket == TCS_SOCKET_INVALID || local_address == NULL)
+        return TCS_ERROR_INVALID_ARGUMENT;
+
+    struct sockaddr_storage native_sockaddr;
+    memset(&native_sockaddr, 0, sizeof native_sockaddr);
+    socklen_t addrlen = sizeof native_sockaddr;
+    if (getsockname(socket, (struct sockaddr*)&native_sockaddr, &addrlen) != 0)
+        return errno2retcode(errno);
+
+    return native2sockaddr((struct sockaddr*)&native_sockaddr, local_address);
+}
+
+TcsResult tcs_address_socket_remote(TcsSocket socket, struct TcsAddress* remote_address)
+{
+    if (socket == TCS_SOCKET_INVALID || remote_address == NULL)
+        return TCS_ERROR_INVALID_ARGUMENT;
+
+    struct sockaddr_storage native_sockaddr;
+    memset(&native_sockaddr, 0, sizeof native_sockaddr);
+    socklen_t addrlen = sizeof native_sockaddr;
+    if (getpeername(socket, (struct sockaddr*)&native_sockaddr, &addrlen) != 0)
+        return errno2retcode(errno);
 
-    free(heap_iovec);
+    return native2sockaddr((struct sockaddr*)&native_sockaddr, remote_address);
+}
+
+TcsResult tcs_address_socket_family(TcsSocket socket, TcsFamily* out_family)
+{
+    if (socket == TCS_SOCKET_INVALID || out_family == NULL)
+        return TCS_ERROR_INVALID_ARGUMENT;
+
+    struct sockaddr_storage native_sockaddr;
+    memset(&native_sockaddr, 0, sizeof native_sockaddr);
+    socklen_t addrlen = sizeof native_sockaddr;
+    if (getsockname(socket, (struct sockaddr*)&native_sockaddr, &addrlen) != 0)
+        return errno2retcode(errno);
+
+    out_family->native = (int)native_sockaddr.ss_family;
+    return TCS_SUCCESS;
+}
+
+// tcs_address_parse() is defined in tinycsocket_common.c
+// tcs_address_to_str() is defined in tinycsocket_common.c
+// tcs_address_is_equal() is defined in tinycsocket_common.c
+// tcs_address_is_any() is defined in tinycsocket_common.c
+// tcs_address_is_link_local() is defined in tinycsocket_common.c
+// tcs_address_is_loopback() is defined in tinycsocket_common.c
+// tcs_address_is_multicast() is defined in tinycsocket_common.c
+// tcs_address_is_broadcast() is defined in tinycsocket_common.c
+
+#endif
+
+/**********************************/
+/****** tinycsocket_win32.h *******/
+/**********************************/
+/*
+ * Copyright 2018 Markus Lindelöw
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files(the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef TINYCSOCKET_INTERNAL_H_
+#include "tinycsocket_internal.h"
+#endif
+#ifdef TINYCSOCKET_USE_WIN32_IMPL
+
+#ifdef DO_WRAP
+#include "dbg_wrap.h"
+#endif
+
+// Header only should not need other files
+#ifndef TINYDATASTRUCTURES_H_
+#include "tinydatastructures.h"
+#endif
+// before windows.h
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <winsock2.h> // sockets
+
+#include <windows.h>
+
+// after windows.h
+#include <iphlpapi.h> // GetAdaptersAddresses
+#include <ws2tcpip.h> // getaddrinfo
+
+#include <stdio.h>  // fprintf (debug diagnostics)
+#include <string.h> // memset
+
+// SOCKADDR_STORAGE was introduced in Windows XP (0x0501).
+// For Win2K targets with MSVC, define it ourselves.
+// mingw-w64 always defines it, so check _MSC_VER to avoid redefinition.
+#if defined(_MSC_VER) && defined(_WIN32_WINNT) && _WIN32_WINNT < 0x0501
+typedef struct
+{
+    short ss_family;
+    char __ss_pad1[6];
+    __int64 __ss_align;
+    char __ss_pad2[112];
+} SOCKADDR_STORAGE, *PSOCKADDR_STORAGE;
+#endif
+
+#if defined(_MSC_VER) || defined(__clang__)
+#pragma comment(lib, "wsock32.lib")
+#pragma comment(lib, "ws2_32.lib")
+#pragma comment(lib, "Iphlpapi.lib")
+#endif
+
+#ifndef ULIST_SOC
+#define ULIST_SOC
+TDS_ULIST_IMPL_WITH_POLICY(SOCKET, soc, &TDS_GROWTH_POLICY_NEVER_SHRINK)
+#endif
+
+#ifndef ULIST_PVOID
+#define ULIST_PVOID
+TDS_ULIST_IMPL(void*, pvoid)
+#endif
+
+#ifndef TDS_MAP_socket_pvoid
+#define TDS_MAP_socket_pvoid
+TDS_MAP_IMPL_WITH_POLICY(SOCKET, void*, socket_user, &TDS_GROWTH_POLICY_NEVER_SHRINK)
+#endif
+
+// Needs to be compatible with fd_set, hopefully this works. Only used when FD_SETSIZE is to small.
+struct tcs_fd_set
+{
+    u_int fd_count;
+    SOCKET fd_array[1]; // dynamic memory hack that is compatible with Win32 API fd_set
+};
+
+struct TcsPoll
+{
+    struct TdsUList_soc read_sockets;
+    struct TdsUList_soc write_sockets;
+    struct TdsUList_soc error_sockets;
+    struct TdsMap_socket_user user_data;
+};
+
+const TcsSocket TCS_SOCKET_INVALID = INVALID_SOCKET;
+const int32_t TCS_WAIT_INF = -1;
 
-    if (ret >= 0)
-    {
-        if (sent_size != NULL)
-            *sent_size = (size_t)ret;
-        return TCS_SUCCESS;
-    }
-    else
-    {
-        if (sent_size != NULL)
-            *sent_size = 0;
-        return errno2retcode(errno);
-    }
-}
+// Addresses
+const TcsAddressIpv4 TCS_ADDRESS_IPV4_ANY = INADDR_ANY;
+const TcsAddressIpv4 TCS_ADDRESS_IPV4_LOOPBACK = INADDR_LOOPBACK;
+const TcsAddressIpv4 TCS_ADDRESS_IPV4_BROADCAST = INADDR_BROADCAST;
+const TcsAddressIpv4 TCS_ADDRESS_IPV4_NONE = INADDR_NONE;
 
-// tcs_send_netstring() is defined in tinycsocket_common.c
+const struct TcsAddressIpv6 TCS_ADDRESS_IPV6_ANY = {{0}};
+const struct TcsAddressIpv6 TCS_ADDRESS_IPV6_LOOPBACK = {{0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1}};
 
-TcsResult tcs_receive(TcsSocket socket, uint8_t* buffer, size_t buffer_size, uint32_t flags, size_t* received_size)
-{
-    if (socket == TCS_SOCKET_INVALID)
-        return TCS_ERROR_INVALID_ARGUMENT;
-    if (buffer == NULL && buffer_size > 0)
-        return TCS_ERROR_INVALID_ARGUMENT;
+// Family
+const TcsFamily TCS_FAMILY_ANY = {AF_UNSPEC};
+const TcsFamily TCS_FAMILY_IPV4 = {AF_INET};
+const TcsFamily TCS_FAMILY_IPV6 = {AF_INET6};
+const TcsFamily TCS_FAMILY_PACKET = {-1}; /* AF_PACKET unsupported on Windows */
 
-    if (buffer_size == 0)
-    {
-        if (received_size != NULL)
-            *received_size = 0;
-        return TCS_SUCCESS;
-    }
+// Type
+const TcsSocketType TCS_SOCKET_STREAM = {SOCK_STREAM};
+const TcsSocketType TCS_SOCKET_DGRAM = {SOCK_DGRAM};
+const TcsSocketType TCS_SOCKET_RAW = {SOCK_RAW};
 
-#if defined(__CYGWIN__)
-    // Workaround for cygwin bug (introduced 2020 in cygwin, still present when this code is written)
-    // Cygwin's recv(MSG_WAITALL) loops forever after peer FIN.
-    // The loop in winsup/cygwin/fhandler/socket_inet.cc::recv_internal has no exit for a successful zero-byte WSARecv,
-    // and FD_CLOSE stays latched, so the loop re-enters wait_for_events and WSARecv repeatedly.
-    TcsSocketType cygwin_sock_type = {0};
-    bool is_stream = (flags & MSG_WAITALL) && ((flags & MSG_PEEK) || !(flags & MSG_OOB)) &&
-                     tcs_opt_type_get(socket, &cygwin_sock_type) == TCS_SUCCESS &&
-                     cygwin_sock_type.native == TCS_SOCKET_STREAM.native;
-    if (is_stream)
-    {
-        uint32_t base_flags = flags & ~(uint32_t)MSG_WAITALL;
-        size_t total = 0;
-        int loop_errno = 0;
-        bool peer_closed = false;
-        bool deadline_hit = false;
+// Recv flags
+const uint32_t TCS_MSG_PEEK = MSG_PEEK;
+const uint32_t TCS_MSG_OOB = MSG_OOB;
+const uint32_t TCS_MSG_WAITALL = 0x8; // Binary compatible when it does not exist
 
-        // Nonblocking sockets must never wait in poll(); the native recv()
-        // already returns EAGAIN immediately, which the epilog converts to
-        // TCS_ERROR_WOULD_BLOCK.
-        int fcntl_flags = fcntl(socket, F_GETFL, 0);
-        bool is_nonblock = (fcntl_flags != -1 && (fcntl_flags & O_NONBLOCK));
+// Send flags
+const uint32_t TCS_MSG_SENDALL = 0x80000000;
 
-        // SO_RCVTIMEO == 0 means block forever; otherwise compute monotonic deadline.
-        int timeout = 0;
-        tcs_opt_receive_timeout_get(socket, &timeout);
-        bool has_deadline = (timeout > 0 && !is_nonblock);
-        int64_t deadline_ns = 0;
-        if (has_deadline)
-        {
-            struct timespec ts;
-            clock_gettime(CLOCK_MONOTONIC, &ts);
-            deadline_ns = (int64_t)ts.tv_sec * 1000000000LL + ts.tv_nsec + (int64_t)timeout * 1000000LL;
-        }
+// Send and recv flags
+const uint32_t TCS_MSG_DONTWAIT = 0x40000000; // Emulated, Winsock has no MSG_DONTWAIT
 
-        if (!(flags & MSG_PEEK))
-        {
-            while (total < buffer_size)
-            {
-                // Cap each retry to the remaining deadline so a peer that
-                // trickles bytes can't keep resetting the per-recv SO_RCVTIMEO
-                // and extend the call past the configured timeout.
-                if (has_deadline)
-                {
-                    struct timespec now;
-                    clock_gettime(CLOCK_MONOTONIC, &now);
-                    int64_t now_ns = (int64_t)now.tv_sec * 1000000000LL + now.tv_nsec;
-                    if (now_ns >= deadline_ns)
-                    {
-                        deadline_hit = true;
-                        break;
-                    }
-                    int remaining_ms = (int)((deadline_ns - now_ns + 999999LL) / 1000000LL);
-                    struct pollfd pfd = {socket, POLLIN, 0};
-                    int perr = poll(&pfd, 1, remaining_ms);
-                    if (perr < 0)
-                    {
-                        if (errno == EINTR)
-                            continue;
-                        loop_errno = errno;
-                        break;
-                    }
-                    if (perr == 0)
-                    {
-                        deadline_hit = true;
-                        break;
-                    }
-                }
-                ssize_t r = recv(socket, (char*)buffer + total, buffer_size - total, (int)base_flags);
-                if (r > 0)
-                {
-                    total += (size_t)r;
-                }
-                else if (r == 0)
-                {
-                    peer_closed = true;
-                    break;
-                }
-                else
-                {
-                    if (errno == EINTR)
-                        continue;
-                    loop_errno = errno;
-                    break;
-                }
-            }
-        }
-        else
-        {
-            struct pollfd pfd = {socket, 0, 0};
+// Backlog
+const int TCS_BACKLOG_MAX = SOMAXCONN;
 
-            for (;;)
-            {
-                // Peek what is currently buffered. If nothing has grown since the
-                // last iteration, this is a no-op on `total`; otherwise it captures more.
-                ssize_t r = recv(socket, (char*)buffer, buffer_size, (int)base_flags);
-                if (r > 0)
-                    total = (size_t)r;
-                else if (r == 0)
-                    peer_closed = true;
-                else if (errno == EINTR)
-                    continue;
-                else
-                    loop_errno = errno;
+// Option levels
+const int32_t TCS_SOL_SOCKET = SOL_SOCKET;
+const int32_t TCS_SOL_IP = IPPROTO_IP;
+const int32_t TCS_SOL_TCP = IPPROTO_TCP;
+const int32_t TCS_SOL_PACKET = -1; // No equivalent on Windows
 
-                if (total >= buffer_size || peer_closed || loop_errno != 0)
-                    break;
+// Socket options
+const int32_t TCS_SO_TYPE = SO_TYPE;
+const int32_t TCS_SO_BROADCAST = SO_BROADCAST;
+const int32_t TCS_SO_KEEPALIVE = SO_KEEPALIVE;
+const int32_t TCS_SO_LINGER = SO_LINGER;
+const int32_t TCS_SO_REUSEADDR = SO_REUSEADDR;
+const int32_t TCS_SO_REUSEPORT = -1;
+const int32_t TCS_SO_RCVBUF = SO_RCVBUF;
+const int32_t TCS_SO_RCVTIMEO = SO_RCVTIMEO;
+const int32_t TCS_SO_SNDBUF = SO_SNDBUF;
+const int32_t TCS_SO_OOBINLINE = SO_OOBINLINE;
+const int32_t TCS_SO_PRIORITY = -1;
 
-                if (has_deadline)
-                {
-                    struct timespec now;
-                    clock_gettime(CLOCK_MONOTONIC, &now);
-                    if ((int64_t)now.tv_sec * 1000000000LL + now.tv_nsec >= deadline_ns)
-                    {
-                        deadline_hit = true;
-                        break;
-                    }
-                }
+// IP options
+const int32_t TCS_TCP_NODELAY = TCP_NODELAY;
+const int32_t TCS_IP_MEMBERSHIP_ADD = IP_ADD_MEMBERSHIP;
+const int32_t TCS_IP_MEMBERSHIP_DROP = IP_DROP_MEMBERSHIP;
+const int32_t TCS_IP_MULTICAST_LOOP = IP_MULTICAST_LOOP;
 
-                // Wait briefly for state change. POLLHUP/POLLERR/POLLNVAL fire even
-                // with events=0; on close we just flag peer_closed and let the next
-                // iteration's peek capture any straggler bytes.
-                int perr = poll(&pfd, 1, 1);
-                if (perr < 0)
-                {
-                    if (errno == EINTR)
-                        continue;
-                    loop_errno = errno;
-                    break;
-                }
-                if (pfd.revents & (POLLHUP | POLLERR | POLLNVAL))
-                    peer_closed = true;
-            }
-        }
+// ######## Internal Helpers ########
 
-        if (received_size != NULL)
-            *received_size = total;
-        if (total > 0)
-            return TCS_SUCCESS;
-        if (loop_errno != 0)
-        {
-#if (EAGAIN == EWOULDBLOCK)
-            if (loop_errno == EAGAIN)
-            {
-                if (is_nonblock)
-                    return TCS_ERROR_WOULD_BLOCK;
-                return TCS_ERROR_TIMED_OUT;
-            }
+#ifndef WSA_FLAG_NO_HANDLE_INHERIT
+#define WSA_FLAG_NO_HANDLE_INHERIT 0x80 // Windows 7 SP1 and later, missing in older SDKs
 #endif
-            return errno2retcode(loop_errno);
-        }
-        if (peer_closed)
-            return TCS_SHUTDOWN;
-        if (deadline_hit)
+
+static TcsResult wsaerror2retcode(int wsa_error)
+{
+    switch (wsa_error)
+    {
+        case WSANOTINITIALISED:
+            return TCS_ERROR_LIBRARY_NOT_INITIALIZED;
+        case WSAEWOULDBLOCK:
+            return TCS_ERROR_WOULD_BLOCK;
+        case WSAETIMEDOUT:
             return TCS_ERROR_TIMED_OUT;
-        return TCS_SUCCESS;
+        case WSAECONNREFUSED:
+            return TCS_ERROR_CONNECTION_REFUSED;
+        case WSAECONNRESET:
+            return TCS_ERROR_CONNECTION_RESET;
+        case WSAENOTCONN:
+            return TCS_ERROR_NOT_CONNECTED;
+        case WSAESHUTDOWN:
+            return TCS_ERROR_SOCKET_CLOSED;
+        case WSAENETUNREACH:
+        case WSAEHOSTUNREACH:
+        case WSAENETDOWN:
+            return TCS_ERROR_NETWORK_UNREACHABLE;
+        case WSAEACCES:
+            return TCS_ERROR_PERMISSION_DENIED;
+        case WSAEINVAL:
+            return TCS_ERROR_INVALID_ARGUMENT;
+        case WSAEADDRINUSE:
+            return TCS_ERROR_ADDRESS_IN_USE;
+        case WSAENOPROTOOPT:
+            return TCS_ERROR_NOT_SUPPORTED;
+        case WSAEAFNOSUPPORT:
+        case WSAEPROTONOSUPPORT:
+        case WSAESOCKTNOSUPPORT:
+            return TCS_ERROR_NOT_SUPPORTED;
+        case WSAENOBUFS:
+        case WSA_NOT_ENOUGH_MEMORY:
+            return TCS_ERROR_MEMORY;
+        default:
+            return TCS_ERROR_UNKNOWN;
     }
-#endif
-
-    ssize_t recv_status = recv(socket, (char*)buffer, buffer_size, TCS_DEFAULT_RECV_FLAGS | (int)flags);
+}
 
-    if (recv_status > 0)
+static TcsResult socketstatus2retcode(int status)
+{
+    if (status == 0)
     {
-        if (received_size != NULL)
-            *received_size = (size_t)recv_status;
         return TCS_SUCCESS;
     }
-    else if (recv_status == 0)
+    else if (status == SOCKET_ERROR)
     {
-        if (received_size != NULL)
-            *received_size = 0;
-        TcsSocketType sock_type = {0};
-        if (tcs_opt_type_get(socket, &sock_type) == TCS_SUCCESS && sock_type.native == TCS_SOCKET_STREAM.native)
-            return TCS_SHUTDOWN;
-        return TCS_SUCCESS;
+        int error_code = WSAGetLastError();
+        return wsaerror2retcode(error_code);
     }
     else
     {
-        if (received_size != NULL)
-            *received_size = 0;
-#if (EAGAIN == EWOULDBLOCK)
-        if (errno == EAGAIN)
-        {
-            int fcntl_flags = fcntl(socket, F_GETFL, 0);
-            if (fcntl_flags == -1)
-                return errno2retcode(errno);
-            if (fcntl_flags & O_NONBLOCK)
-                return TCS_ERROR_WOULD_BLOCK;
-            return TCS_ERROR_TIMED_OUT;
-        }
-#endif
-        return errno2retcode(errno);
+        return TCS_ERROR_UNKNOWN;
     }
 }
 
-TcsResult tcs_receive_from(TcsSocket socket,
-                           uint8_t* buffer,
-                           size_t buffer_size,
-                           uint32_t flags,
-                           struct TcsAddress* source_address,
-                           size_t* received_size)
+static TcsResult sockaddr2native(const struct TcsAddress* in_addr, PSOCKADDR out_addr, int* out_addrlen)
 {
-    if (socket == TCS_SOCKET_INVALID)
-        return TCS_ERROR_INVALID_ARGUMENT;
-    if (buffer == NULL && buffer_size > 0)
+    if (in_addr == NULL || out_addr == NULL)
         return TCS_ERROR_INVALID_ARGUMENT;
 
-    struct sockaddr_storage native_sockaddr;
-    memset(&native_sockaddr, 0, sizeof native_sockaddr);
-    socklen_t addrlen = sizeof native_sockaddr;
-
-    ssize_t recvfrom_status = recvfrom(socket,
-                                       (char*)buffer,
-                                       buffer_size,
-                                       TCS_DEFAULT_RECV_FLAGS | (int)flags,
-                                       (struct sockaddr*)&native_sockaddr,
-                                       &addrlen);
+    if (in_addr->family.native == -1) // sentinel for unsupported families (e.g. TCS_FAMILY_PACKET on Windows)
+        return TCS_ERROR_NOT_SUPPORTED;
 
-    if (recvfrom_status > 0)
+    if (in_addr->family.native == TCS_FAMILY_ANY.native)
     {
-        if (received_size != NULL)
-            *received_size = (size_t)recvfrom_status;
-        if (source_address != NULL)
-            return native2sockaddr((struct sockaddr*)&native_sockaddr, source_address);
+        return TCS_ERROR_NOT_SUPPORTED;
+    }
+    if (in_addr->family.native == TCS_FAMILY_IPV4.native)
+    {
+        PSOCKADDR_IN addr = (PSOCKADDR_IN)out_addr;
+        addr->sin_family = (ADDRESS_FAMILY)AF_INET;
+        addr->sin_port = htons((USHORT)in_addr->data.ipv4.port);
+        addr->sin_addr.S_un.S_addr = htonl((ULONG)in_addr->data.ipv4.address);
+
+        if (out_addrlen != NULL)
+            *out_addrlen = sizeof(SOCKADDR_IN);
+
         return TCS_SUCCESS;
     }
-    else if (recvfrom_status == 0)
+    else if (in_addr->family.native == TCS_FAMILY_IPV6.native)
     {
-        if (received_size != NULL)
-            *received_size = 0;
-        TcsSocketType sock_type = {0};
-        if (tcs_opt_type_get(socket, &sock_type) == TCS_SUCCESS && sock_type.native == TCS_SOCKET_STREAM.native)
-            return TCS_SHUTDOWN;
+        PSOCKADDR_IN6 addr = (PSOCKADDR_IN6)out_addr;
+        addr->sin6_family = (ADDRESS_FAMILY)AF_INET6;
+        addr->sin6_port = htons((USHORT)in_addr->data.ipv6.port);
+        memcpy(&addr->sin6_addr, in_addr->data.ipv6.address.bytes, 16);
+        addr->sin6_scope_id = (ULONG)in_addr->data.ipv6.scope_id;
+        if (out_addrlen != NULL)
+            *out_addrlen = sizeof(SOCKADDR_IN6);
         return TCS_SUCCESS;
     }
+    else if (in_addr->family.native == TCS_FAMILY_PACKET.native)
+    {
+        return TCS_ERROR_NOT_SUPPORTED;
+    }
+    return TCS_ERROR_NOT_SUPPORTED;
+}
+
+static TcsResult native2sockaddr(const PSOCKADDR in_addr, struct TcsAddress* out_addr)
+{
+    if (in_addr == NULL || out_addr == NULL)
+        return TCS_ERROR_INVALID_ARGUMENT;
+
+    if (in_addr->sa_family == AF_INET)
+    {
+        PSOCKADDR_IN addr = (PSOCKADDR_IN)in_addr;
+        out_addr->family = TCS_FAMILY_IPV4;
+        out_addr->data.ipv4.port = ntohs((uint16_t)addr->sin_port);
+        out_addr->data.ipv4.address = ntohl((uint32_t)addr->sin_addr.S_un.S_addr);
+    }
+    else if (in_addr->sa_family == AF_INET6)
+    {
+        PSOCKADDR_IN6 addr = (PSOCKADDR_IN6)in_addr;
+        out_addr->family = TCS_FAMILY_IPV6;
+        out_addr->data.ipv6.port = ntohs((uint16_t)addr->sin6_port);
+        memcpy(out_addr->data.ipv6.address.bytes, &addr->sin6_addr, 16);
+        out_addr->data.ipv6.scope_id = (TcsInterfaceId)addr->sin6_scope_id;
+    }
+    else if (in_addr->sa_family == AF_UNSPEC)
+    {
+        return TCS_ERROR_INVALID_ARGUMENT;
+    }
     else
     {
-        if (received_size != NULL)
-            *received_size = 0;
-        return errno2retcode(errno);
+        return TCS_ERROR_NOT_IMPLEMENTED;
     }
+
+    return TCS_SUCCESS;
 }
 
-// tcs_receive_line() is defined in tinycsocket_common.c
-// tcs_receive_netstring() is defined in tinycsocket_common.c
+// ######## OS Primitives ########
 
-// ######## Socket Polling ########
+// Used by tinycsocket_common.c, see the declarations there
 
-TcsResult tcs_poll_create(struct TcsPoll** out_poll)
+size_t tcs_os_steering_cpu_count(void)
 {
-    if (out_poll == NULL || *out_poll != NULL)
-        return TCS_ERROR_INVALID_ARGUMENT;
+    return 0; // No SO_REUSEPORT groups
+}
 
-    *out_poll = (struct TcsPoll*)malloc(sizeof(struct TcsPoll));
-    if (*out_poll == NULL)
+// CRITICAL_SECTION and not SRWLOCK, which needs Windows Vista
+struct TcsOsMutex
+{
+    CRITICAL_SECTION section;
+};
+
+TcsResult tcs_os_mutex_create(struct TcsOsMutex** out_mutex)
+{
+    struct TcsOsMutex* mutex = (struct TcsOsMutex*)tcs_lib_malloc(sizeof(struct TcsOsMutex));
+    if (mutex == NULL)
         return TCS_ERROR_MEMORY;
-    memset(*out_poll, 0, sizeof(struct TcsPoll));
+    InitializeCriticalSection(&mutex->section);
+    *out_mutex = mutex;
+    return TCS_SUCCESS;
+}
 
-    if (tds_map_poll_create(&(*out_poll)->backend.poll.map) != 0)
+void tcs_os_mutex_destroy(struct TcsOsMutex** mutex)
+{
+    DeleteCriticalSection(&(*mutex)->section);
+    tcs_lib_free(*mutex);
+    *mutex = NULL;
+}
+
+void tcs_os_mutex_lock(struct TcsOsMutex* mutex)
+{
+    EnterCriticalSection(&mutex->section);
+}
+
+void tcs_os_mutex_unlock(struct TcsOsMutex* mutex)
+{
+    LeaveCriticalSection(&mutex->section);
+}
+
+// A CRITICAL_SECTION has no static initializer, the first caller initializes it. It is never deleted.
+static CRITICAL_SECTION os_global_section;
+static volatile LONG os_global_state = 0; // 0 not initialized, 1 initializing, 2 ready
+
+void tcs_os_global_lock(void)
+{
+    if (InterlockedCompareExchange(&os_global_state, 1, 0) == 0)
     {
-        free(*out_poll);
-        *out_poll = NULL;
-        return TCS_ERROR_MEMORY;
+        InitializeCriticalSection(&os_global_section);
+        InterlockedExchange(&os_global_state, 2);
     }
+    while (InterlockedCompareExchange(&os_global_state, 2, 2) != 2)
+        Sleep(0);
+    EnterCriticalSection(&os_global_section);
+}
 
-    return TCS_SUCCESS;
+void tcs_os_global_unlock(void)
+{
+    LeaveCriticalSection(&os_global_section);
 }
 
-TcsResult tcs_poll_destroy(struct TcsPoll** ctx)
+struct TcsOsThread
 {
-    if (ctx == NULL || *ctx == NULL)
-        return TCS_ERROR_INVALID_ARGUMENT;
+    HANDLE handle;
+    void (*function)(void*);
+    void* arg;
+};
 
-    if (tds_map_poll_destroy(&(*ctx)->backend.poll.map) != 0)
-    {
+static DWORD WINAPI os_thread_main(LPVOID arg)
+{
+    struct TcsOsThread* thread = (struct TcsOsThread*)arg;
+    thread->function(thread->arg);
+    return 0;
+}
+
+TcsResult tcs_os_thread_create(struct TcsOsThread** out_thread, void (*function)(void*), void* arg)
+{
+    struct TcsOsThread* thread = (struct TcsOsThread*)tcs_lib_malloc(sizeof(struct TcsOsThread));
+    if (thread == NULL)
         return TCS_ERROR_MEMORY;
+    thread->function = function;
+    thread->arg = arg;
+    thread->handle = CreateThread(NULL, 0, os_thread_main, thread, 0, NULL);
+    if (thread->handle == NULL)
+    {
+        tcs_lib_free(thread);
+        return TCS_ERROR_SYSTEM;
     }
+    *out_thread = thread;
+    return TCS_SUCCESS;
+}
 
-    free(*ctx);
-    *ctx = NULL;
+void tcs_os_thread_join(struct TcsOsThread** thread)
+{
+    WaitForSingleObject((*thread)->handle, INFINITE);
+    CloseHandle((*thread)->handle);
+    tcs_lib_free(*thread);
+    *thread = NULL;
+}
+
+// A semaphore object and not CONDITION_VARIABLE, which needs Windows Vista
+struct TcsOsSemaphore
+{
+    HANDLE handle;
+};
 
+TcsResult tcs_os_semaphore_create(struct TcsOsSemaphore** out_semaphore)
+{
+    struct TcsOsSemaphore* semaphore = (struct TcsOsSemaphore*)tcs_lib_malloc(sizeof(struct TcsOsSemaphore));
+    if (semaphore == NULL)
+        return TCS_ERROR_MEMORY;
+    semaphore->handle = CreateSemaphoreW(NULL, 0, MAXLONG, NULL);
+    if (semaphore->handle == NULL)
+    {
+        tcs_lib_free(semaphore);
+        return TCS_ERROR_SYSTEM;
+    }
+    *out_semaphore = semaphore;
     return TCS_SUCCESS;
 }
 
-TcsResult tcs_poll_add(struct TcsPoll* ctx, TcsSocket socket, void* user_data, uint32_t flags)
+void tcs_os_semaphore_destroy(struct TcsOsSemaphore** semaphore)
 {
-    if (ctx == NULL)
-        return TCS_ERROR_INVALID_ARGUMENT;
-    if (socket == TCS_SOCKET_INVALID)
-        return TCS_ERROR_INVALID_ARGUMENT;
+    CloseHandle((*semaphore)->handle);
+    tcs_lib_free(*semaphore);
+    *semaphore = NULL;
+}
 
-    short ev = POLLERR;
-    if (flags & TCS_POLL_READ)
-        ev |= POLLIN;
-    if (flags & TCS_POLL_WRITE)
-        ev |= POLLOUT;
+void tcs_os_semaphore_post(struct TcsOsSemaphore* semaphore)
+{
+    ReleaseSemaphore(semaphore->handle, 1, NULL);
+}
 
-    struct pollfd pfd;
-    pfd.fd = socket;
-    pfd.events = ev;
-    pfd.revents = 0;
+void tcs_os_semaphore_wait(struct TcsOsSemaphore* semaphore)
+{
+    WaitForSingleObject(semaphore->handle, INFINITE);
+}
 
-    if (tds_map_poll_addp(&ctx->backend.poll.map, &pfd, &user_data) != 0)
-        return TCS_ERROR_MEMORY;
+// Windows can only select() on sockets, a pipe would not work with TcsPoll. This is a UDP socket connected to
+// itself instead, one datagram is queued while set.
+struct TcsOsWakeup
+{
+    TcsSocket socket;
+};
 
+TcsResult tcs_os_wakeup_create(struct TcsOsWakeup** out_wakeup)
+{
+    struct TcsAddress loopback = TCS_ADDRESS_NONE;
+    TcsResult res = tcs_address_parse("127.0.0.1:0", &loopback);
+    if (res != TCS_SUCCESS)
+        return res;
+    struct TcsOsWakeup* wakeup = (struct TcsOsWakeup*)tcs_lib_malloc(sizeof(struct TcsOsWakeup));
+    if (wakeup == NULL)
+        return TCS_ERROR_MEMORY;
+    wakeup->socket = TCS_SOCKET_INVALID;
+    res = tcs_socket_with_flags(&wakeup->socket,
+                                TCS_FAMILY_IPV4,
+                                TCS_SOCKET_DGRAM,
+                                TCS_PROTOCOL_IP_UDP,
+                                TCS_SOCKET_FLAG_NONBLOCKING | TCS_SOCKET_FLAG_CLOEXEC);
+    if (res == TCS_SUCCESS)
+        res = tcs_bind(wakeup->socket, &loopback);
+    if (res == TCS_SUCCESS)
+        res = tcs_address_socket_local(wakeup->socket, &loopback);
+    if (res == TCS_SUCCESS)
+        res = tcs_connect(wakeup->socket, &loopback);
+    if (res != TCS_SUCCESS)
+    {
+        if (wakeup->socket != TCS_SOCKET_INVALID)
+            tcs_close(&wakeup->socket);
+        tcs_lib_free(wakeup);
+        return res;
+    }
+    *out_wakeup = wakeup;
     return TCS_SUCCESS;
 }
 
-TcsResult tcs_poll_modify(struct TcsPoll* ctx, TcsSocket socket, uint32_t flags)
+void tcs_os_wakeup_destroy(struct TcsOsWakeup** wakeup)
 {
-    if (ctx == NULL)
-        return TCS_ERROR_INVALID_ARGUMENT;
-    if (socket == TCS_SOCKET_INVALID)
-        return TCS_ERROR_INVALID_ARGUMENT;
+    tcs_close(&(*wakeup)->socket);
+    tcs_lib_free(*wakeup);
+    *wakeup = NULL;
+}
 
-    struct TdsMap_poll* map = &ctx->backend.poll.map;
+TcsSocket tcs_os_wakeup_socket(const struct TcsOsWakeup* wakeup)
+{
+    return wakeup->socket;
+}
 
-    for (size_t i = 0; i < map->count; ++i)
+void tcs_os_wakeup_set(struct TcsOsWakeup* wakeup, bool is_set)
+{
+    char byte = 1;
+    if (is_set)
+        send(wakeup->socket, &byte, 1, 0);
+    else
+        recv(wakeup->socket, &byte, 1, 0);
+}
+
+TcsResult tcs_os_connect_wait(const TcsSocket sockets[], size_t sockets_length, TcsResult out_results[], int timeout_ms)
+{
+    if (sockets_length > TCS_CFG_CONNECT_CANDIDATES_MAX || sockets_length > FD_SETSIZE)
+        return TCS_ERROR_INVALID_ARGUMENT;
+
+    // A failed connect is reported in the except set on Windows
+    fd_set write_set;
+    fd_set except_set;
+    FD_ZERO(&write_set);
+    FD_ZERO(&except_set);
+    for (size_t i = 0; i < sockets_length; ++i)
     {
-        if (socket == map->keys[i].fd)
-        {
-            short ev = POLLERR;
-            if (flags & TCS_POLL_READ)
-                ev |= POLLIN;
-            if (flags & TCS_POLL_WRITE)
-                ev |= POLLOUT;
-            map->keys[i].events = ev;
-            return TCS_SUCCESS;
-        }
+        out_results[i] = TCS_IN_PROGRESS;
+        if (sockets[i] == TCS_SOCKET_INVALID)
+            continue;
+        FD_SET(sockets[i], &write_set);
+        FD_SET(sockets[i], &except_set);
+    }
+    if (write_set.fd_count == 0)
+    {
+        Sleep(timeout_ms == TCS_WAIT_INF ? INFINITE : (DWORD)timeout_ms); // select() fails on empty sets
+        return TCS_ERROR_TIMED_OUT;
     }
+    struct timeval timeout;
+    timeout.tv_sec = timeout_ms / 1000;
+    timeout.tv_usec = (timeout_ms % 1000) * 1000;
+    int ready = select(0, NULL, &write_set, &except_set, timeout_ms == TCS_WAIT_INF ? NULL : &timeout);
+    if (ready == SOCKET_ERROR)
+        return wsaerror2retcode(WSAGetLastError());
+    if (ready == 0)
+        return TCS_ERROR_TIMED_OUT;
 
-    return TCS_ERROR_INVALID_ARGUMENT;
+    for (size_t i = 0; i < sockets_length; ++i)
+    {
+        if (sockets[i] == TCS_SOCKET_INVALID ||
+            (!FD_ISSET(sockets[i], &write_set) && !FD_ISSET(sockets[i], &except_set)))
+            continue;
+        int error = 0;
+        int error_size = sizeof(error);
+        if (getsockopt(sockets[i], SOL_SOCKET, SO_ERROR, (char*)&error, &error_size) == SOCKET_ERROR)
+            error = WSAGetLastError();
+        out_results[i] = error == 0 ? TCS_SUCCESS : wsaerror2retcode(error);
+    }
+    return TCS_SUCCESS;
 }
 
-TcsResult tcs_poll_remove(struct TcsPoll* ctx, TcsSocket socket)
+// RtlGenRandom() is exported as SystemFunction036 since Windows XP, looked up so advapi32 is not needed at link time
+typedef BOOLEAN(WINAPI* TcsRtlGenRandom)(PVOID buffer, ULONG length);
+
+TcsResult tcs_os_random(uint8_t* out_bytes, size_t length)
 {
-    if (ctx == NULL)
+    if (length > MAXULONG)
         return TCS_ERROR_INVALID_ARGUMENT;
-    if (socket == TCS_SOCKET_INVALID)
-        return TCS_ERROR_INVALID_ARGUMENT;
-    struct TdsMap_poll const* map = &ctx->backend.poll.map;
+    HMODULE advapi = LoadLibraryA("advapi32.dll");
+    if (advapi == NULL)
+        return TCS_ERROR_NOT_SUPPORTED;
+    TcsRtlGenRandom gen_random = (TcsRtlGenRandom)(void*)GetProcAddress(advapi, "SystemFunction036");
+    bool is_filled = gen_random != NULL && gen_random(out_bytes, (ULONG)length);
+    FreeLibrary(advapi);
+    return is_filled ? TCS_SUCCESS : TCS_ERROR_NOT_SUPPORTED;
+}
 
-    bool found = false;
-    for (size_t i = 0; i < map->count; ++i)
-    {
-        if (socket == map->keys[i].fd)
-        {
-            if (tds_map_poll_remove(&ctx->backend.poll.map, i) != 0)
-                return TCS_ERROR_MEMORY;
-            found = true;
-            break;
-        }
-    }
-    if (!found)
-        return TCS_ERROR_INVALID_ARGUMENT;
+TcsResult tcs_lib_init(void)
+{
+    WSADATA wsa_data;
+    if (WSAStartup(MAKEWORD(2, 2), &wsa_data) != 0)
+        return TCS_ERROR_SYSTEM;
+    return TCS_SUCCESS;
+}
 
+TcsResult tcs_lib_cleanup(void)
+{
+    WSACleanup();
     return TCS_SUCCESS;
 }
 
-TcsResult tcs_poll_wait(struct TcsPoll* poll_ctx,
-                        struct TcsPollEvent* out_events,
-                        size_t events_length,
-                        size_t* out_events_length,
-                        int timeout_ms)
+int64_t tcs_time_monotonic_ms(void)
 {
-    if (poll_ctx == NULL || out_events == NULL || out_events_length == NULL)
+    LARGE_INTEGER frequency;
+    LARGE_INTEGER counter;
+    QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&counter);
+    // Split to not overflow when multiplying large counters
+    int64_t whole_seconds = counter.QuadPart / frequency.QuadPart;
+    int64_t remainder = counter.QuadPart % frequency.QuadPart;
+    return whole_seconds * 1000 + remainder * 1000 / frequency.QuadPart;
+}
+
+TcsResult tcs_socket(TcsSocket* out_socket, TcsFamily family, TcsSocketType type, TcsProtocol protocol)
+{
+    return tcs_socket_with_flags(out_socket, family, type, protocol, TCS_FLAG_NONE);
+}
+
+TcsResult tcs_socket_with_flags(TcsSocket* out_socket,
+                                TcsFamily family,
+                                TcsSocketType type,
+                                TcsProtocol protocol,
+                                uint32_t flags)
+{
+    if (out_socket == NULL || *out_socket != TCS_SOCKET_INVALID)
         return TCS_ERROR_INVALID_ARGUMENT;
-    if (timeout_ms < 0 && timeout_ms != TCS_WAIT_INF)
+    if ((flags & ~(TCS_SOCKET_FLAG_NONBLOCKING | TCS_SOCKET_FLAG_CLOEXEC)) != 0)
         return TCS_ERROR_INVALID_ARGUMENT;
+    if (family.native == -1) // sentinel for unsupported families (e.g. TCS_FAMILY_PACKET on Windows)
+        return TCS_ERROR_NOT_SUPPORTED;
 
-    struct TdsMap_poll* map = &poll_ctx->backend.poll.map;
-
-    int poll_ret = poll(map->keys, map->count, timeout_ms);
-    *out_events_length = 0;
-    if (poll_ret < 0)
+    // Same as socket(), which creates overlapped sockets
+    DWORD wsa_flags = WSA_FLAG_OVERLAPPED;
+    if (flags & TCS_SOCKET_FLAG_CLOEXEC)
+        wsa_flags |= WSA_FLAG_NO_HANDLE_INHERIT;
+    TcsSocket new_socket = WSASocketW(family.native, type.native, (int)protocol, NULL, 0, wsa_flags);
+    if (new_socket == INVALID_SOCKET && (wsa_flags & WSA_FLAG_NO_HANDLE_INHERIT) && WSAGetLastError() == WSAEINVAL)
     {
-        return errno2retcode(errno);
+        // The flag is unknown before Windows 7 SP1, clear the inherit flag after creation instead
+        new_socket = WSASocketW(family.native, type.native, (int)protocol, NULL, 0, WSA_FLAG_OVERLAPPED);
+        if (new_socket != INVALID_SOCKET && !SetHandleInformation((HANDLE)new_socket, HANDLE_FLAG_INHERIT, 0))
+        {
+            closesocket(new_socket);
+            return TCS_ERROR_SYSTEM;
+        }
     }
-    if ((size_t)poll_ret > map->count)
+
+    if (new_socket == INVALID_SOCKET)
     {
-        return TCS_ERROR_UNKNOWN; // Corruption
+        int error_code = WSAGetLastError();
+        return wsaerror2retcode(error_code);
     }
-
-    int fill_max = poll_ret > (int)events_length ? (int)events_length : poll_ret; // min(ret, events_length)
-    int filled = 0;
-    for (size_t i = 0; filled < fill_max; ++i)
+    if (flags & TCS_SOCKET_FLAG_NONBLOCKING)
     {
-        if (i >= map->count)
-            return TCS_ERROR_UNKNOWN;
-
-        if (map->keys[i].revents != 0)
+        u_long non_blocking = 1;
+        if (ioctlsocket(new_socket, FIONBIO, &non_blocking) == SOCKET_ERROR)
         {
-            out_events[filled].socket = map->keys[i].fd;
-            out_events[filled].user_data = map->values[i];
-            out_events[filled].can_read = map->keys[i].revents & POLLIN;
-            out_events[filled].can_write = map->keys[i].revents & POLLOUT;
-            if (map->keys[i].revents & (POLLERR | POLLHUP))
-            {
-                int so_error = 0;
-                socklen_t so_error_size = sizeof(so_error);
-                TcsResult fallback = (map->keys[i].revents & POLLERR) ? TCS_ERROR_UNKNOWN : TCS_ERROR_SOCKET_CLOSED;
-                if (getsockopt(map->keys[i].fd, SOL_SOCKET, SO_ERROR, &so_error, &so_error_size) != 0)
-                    out_events[filled].error = errno2retcode(errno);
-                else
-                    out_events[filled].error = so_error != 0 ? errno2retcode(so_error) : fallback;
-            }
-            else
-            {
-                out_events[filled].error = TCS_SUCCESS;
-            }
-            map->keys[i].revents = 0;
-            ++filled;
+            int error_code = WSAGetLastError();
+            closesocket(new_socket);
+            return wsaerror2retcode(error_code);
         }
     }
-    *out_events_length = (size_t)filled;
-
-    if (poll_ret == 0)
-        return TCS_ERROR_TIMED_OUT;
+    *out_socket = new_socket;
     return TCS_SUCCESS;
 }
 
-// ######## Socket Options ########
-
-TcsResult tcs_opt_set(TcsSocket socket,
-                      int32_t level,
-                      int32_t option_name,
-                      const void* option_value,
-                      size_t option_size)
-{
-    if (socket == TCS_SOCKET_INVALID)
-        return TCS_ERROR_INVALID_ARGUMENT;
+// tcs_socket_tcp() is defined in tinycsocket_common.c
+// tcs_socket_tcp_str() is defined in tinycsocket_common.c
+// tcs_socket_udp() is defined in tinycsocket_common.c
+// tcs_socket_udp_str() is defined in tinycsocket_common.c
+// tcs_socket_packet() is defined in tinycsocket_common.c
+// tcs_socket_packet_str() is defined in tinycsocket_common.c
 
-    if (setsockopt(socket, (int)level, (int)option_name, (const char*)option_value, (socklen_t)option_size) == 0)
-        return TCS_SUCCESS;
-    else
-        return errno2retcode(errno);
-}
+// tcs_socket_per_cpu() is defined in tinycsocket_common.c
 
-TcsResult tcs_opt_get(TcsSocket socket, int32_t level, int32_t option_name, void* out_option_value, size_t* option_size)
+TcsResult tcs_close(TcsSocket* socket)
 {
-    if (socket == TCS_SOCKET_INVALID || out_option_value == NULL || option_size == NULL)
+    if (socket == NULL || *socket == TCS_SOCKET_INVALID)
         return TCS_ERROR_INVALID_ARGUMENT;
 
-    socklen_t optlen = (socklen_t)*option_size;
-    if (getsockopt(socket, (int)level, (int)option_name, (void*)out_option_value, &optlen) == 0)
+    int close_status = closesocket(*socket);
+    if (close_status != SOCKET_ERROR)
     {
-        *option_size = (size_t)optlen;
-        // Linux sets the buffer size to the doubled because of internal use and returns the full doubled size including internal part
-#ifdef __linux__
-        if (option_name == TCS_SO_RCVBUF || option_name == TCS_SO_SNDBUF)
-        {
-            *(unsigned int*)out_option_value /= 2;
-        }
-#endif
+        *socket = TCS_SOCKET_INVALID;
         return TCS_SUCCESS;
     }
     else
     {
-        return errno2retcode(errno);
+        return socketstatus2retcode(close_status);
     }
 }
 
-// tcs_opt_broadcast_set() is defined in tinycsocket_common.c
-// tcs_opt_broadcast_get() is defined in tinycsocket_common.c
-// tcs_opt_keep_alive_set() is defined in tinycsocket_common.c
-// tcs_opt_keep_alive_get() is defined in tinycsocket_common.c
-// tcs_opt_reuse_address_set() is defined in tinycsocket_common.c
-TcsResult tcs_opt_reuse_address_set(TcsSocket socket, bool do_allow_reuse_address)
+// ######## Socket Operations ########
+
+TcsResult tcs_bind(TcsSocket socket, const struct TcsAddress* address)
 {
     if (socket == TCS_SOCKET_INVALID)
         return TCS_ERROR_INVALID_ARGUMENT;
+    if (address == NULL)
+        return TCS_ERROR_INVALID_ARGUMENT;
 
-    int b = do_allow_reuse_address ? 1 : 0;
-    return tcs_opt_set(socket, TCS_SOL_SOCKET, TCS_SO_REUSEADDR, &b, sizeof(b));
+    SOCKADDR_STORAGE native_sockaddr;
+    memset(&native_sockaddr, 0, sizeof native_sockaddr);
+    int addrlen = 0;
+    TcsResult convert_addr_status = sockaddr2native(address, (PSOCKADDR)&native_sockaddr, &addrlen);
+    if (convert_addr_status != TCS_SUCCESS)
+        return convert_addr_status;
+    int bind_status = bind(socket, (PSOCKADDR)&native_sockaddr, addrlen);
+    return socketstatus2retcode(bind_status);
 }
 
-TcsResult tcs_opt_reuse_address_get(TcsSocket socket, bool* is_reuse_address_allowed)
+TcsResult tcs_connect(TcsSocket socket, const struct TcsAddress* address)
 {
-    if (socket == TCS_SOCKET_INVALID || is_reuse_address_allowed == NULL)
+    if (socket == TCS_SOCKET_INVALID)
         return TCS_ERROR_INVALID_ARGUMENT;
-    int b = 0;
-    size_t s = sizeof(b);
-    TcsResult sts = tcs_opt_get(socket, TCS_SOL_SOCKET, TCS_SO_REUSEADDR, &b, &s);
-    *is_reuse_address_allowed = b;
-    return sts;
-}
 
-TcsResult tcs_opt_reuse_port_set(TcsSocket socket, bool do_allow_reuse_port)
-{
-    if (socket == TCS_SOCKET_INVALID)
+    if (address == NULL)
         return TCS_ERROR_INVALID_ARGUMENT;
 
-    int b = do_allow_reuse_port ? 1 : 0;
-    return tcs_opt_set(socket, TCS_SOL_SOCKET, TCS_SO_REUSEPORT, &b, sizeof(b));
+    SOCKADDR_STORAGE native_sockaddr;
+    memset(&native_sockaddr, 0, sizeof native_sockaddr);
+    int addrlen = 0;
+    TcsResult convert_addr_status = sockaddr2native(address, (PSOCKADDR)&native_sockaddr, &addrlen);
+    if (convert_addr_status != TCS_SUCCESS)
+        return convert_addr_status;
+    int connect_status = connect(socket, (PSOCKADDR)&native_sockaddr, addrlen);
+    if (connect_status == SOCKET_ERROR)
+    {
+        int error_code = WSAGetLastError();
+        // Windows uses WSAEWOULDBLOCK for non-blocking connect in progress,
+        // while POSIX uses EINPROGRESS. Normalize to TCS_IN_PROGRESS.
+        if (error_code == WSAEWOULDBLOCK)
+            return TCS_IN_PROGRESS;
+        return wsaerror2retcode(error_code);
+    }
+    return TCS_SUCCESS;
 }
 
-TcsResult tcs_opt_reuse_port_get(TcsSocket socket, bool* is_reuse_port_allowed)
+// tcs_connect_str() is defined in tinycsocket_common.c
+
+TcsResult tcs_connect_timeout(TcsSocket socket, const struct TcsAddress* address, int timeout_ms)
 {
-    if (socket == TCS_SOCKET_INVALID || is_reuse_port_allowed == NULL)
+    if (socket == TCS_SOCKET_INVALID || address == NULL)
         return TCS_ERROR_INVALID_ARGUMENT;
-    int b = 0;
-    size_t s = sizeof(b);
-    TcsResult sts = tcs_opt_get(socket, TCS_SOL_SOCKET, TCS_SO_REUSEPORT, &b, &s);
-    *is_reuse_port_allowed = b;
-    return sts;
-}
+    if (timeout_ms < 0 && timeout_ms != TCS_WAIT_INF)
+        return TCS_ERROR_INVALID_ARGUMENT;
+    if (timeout_ms == TCS_WAIT_INF)
+        return tcs_connect(socket, address);
 
-// tcs_opt_send_buffer_size_set() is defined in tinycsocket_common.c
-// tcs_opt_send_buffer_size_get() is defined in tinycsocket_common.c
-// tcs_opt_receive_buffer_size_set() is defined in tinycsocket_common.c
-// tcs_opt_receive_buffer_size_get() is defined in tinycsocket_common.c
+    u_long non_blocking = 1;
+    if (ioctlsocket(socket, FIONBIO, &non_blocking) == SOCKET_ERROR)
+        return wsaerror2retcode(WSAGetLastError());
 
-TcsResult tcs_opt_receive_timeout_set(TcsSocket socket, int timeout_ms)
+    TcsResult res = tcs_connect(socket, address);
+    if (res == TCS_IN_PROGRESS)
+    {
+        // A failed connect is reported in the except set on Windows
+        fd_set write_set;
+        fd_set except_set;
+        FD_ZERO(&write_set);
+        FD_ZERO(&except_set);
+        FD_SET(socket, &write_set);
+        FD_SET(socket, &except_set);
+        struct timeval timeout;
+        timeout.tv_sec = timeout_ms / 1000;
+        timeout.tv_usec = (timeout_ms % 1000) * 1000;
+        int ready = select(0, NULL, &write_set, &except_set, &timeout);
+        if (ready == SOCKET_ERROR)
+        {
+            res = wsaerror2retcode(WSAGetLastError());
+        }
+        else if (ready == 0)
+        {
+            res = TCS_ERROR_TIMED_OUT;
+        }
+        else
+        {
+            int error = 0;
+            int error_size = sizeof(error);
+            if (getsockopt(socket, SOL_SOCKET, SO_ERROR, (char*)&error, &error_size) == SOCKET_ERROR)
+                res = wsaerror2retcode(WSAGetLastError());
+            else
+                res = error == 0 ? TCS_SUCCESS : wsaerror2retcode(error);
+        }
+    }
+
+    non_blocking = 0;
+    if (ioctlsocket(socket, FIONBIO, &non_blocking) == SOCKET_ERROR && res == TCS_SUCCESS)
+        res = wsaerror2retcode(WSAGetLastError());
+    return res;
+}
+
+TcsResult tcs_listen(TcsSocket socket, int backlog)
 {
-    if (socket == TCS_SOCKET_INVALID || timeout_ms < 0)
+    if (socket == TCS_SOCKET_INVALID)
         return TCS_ERROR_INVALID_ARGUMENT;
 
-    struct timeval tv;
-    tv.tv_sec = timeout_ms / 1000;
-    tv.tv_usec = (timeout_ms % 1000) * 1000;
-
-    return tcs_opt_set(socket, TCS_SOL_SOCKET, TCS_SO_RCVTIMEO, &tv, sizeof(tv));
+    int status = listen(socket, (int)backlog);
+    return socketstatus2retcode(status);
 }
 
-TcsResult tcs_opt_receive_timeout_get(TcsSocket socket, int* timeout_ms)
+TcsResult tcs_accept(TcsSocket listener, TcsSocket* out_socket, struct TcsAddress* out_address)
 {
-    if (socket == TCS_SOCKET_INVALID || timeout_ms == NULL)
+    if (listener == TCS_SOCKET_INVALID || out_socket == NULL || *out_socket != TCS_SOCKET_INVALID)
         return TCS_ERROR_INVALID_ARGUMENT;
 
-    struct timeval tv = {0, 0};
-    size_t tv_size = sizeof(tv);
-    TcsResult sts = tcs_opt_get(socket, TCS_SOL_SOCKET, TCS_SO_RCVTIMEO, &tv, &tv_size);
-
-    if (sts == TCS_SUCCESS)
+    SOCKADDR_STORAGE native_sockaddr;
+    memset(&native_sockaddr, 0, sizeof native_sockaddr);
+    int addr_len = sizeof(native_sockaddr);
+    *out_socket = accept(listener, (PSOCKADDR)&native_sockaddr, &addr_len);
+    if (*out_socket != INVALID_SOCKET)
     {
-        int c = 0;
-        c += (int)tv.tv_sec * 1000;
-        c += (int)tv.tv_usec / 1000;
-        *timeout_ms = c;
+        if (out_address != NULL)
+        {
+            TcsResult convert_addr_status = native2sockaddr((PSOCKADDR)&native_sockaddr, out_address);
+            if (convert_addr_status != TCS_SUCCESS)
+                return convert_addr_status;
+        }
+        return TCS_SUCCESS;
+    }
+    else
+    {
+        *out_socket = TCS_SOCKET_INVALID;
+        int error_code = WSAGetLastError();
+        return wsaerror2retcode(error_code);
     }
-    return sts;
-}
-
-TcsResult tcs_opt_linger_set(TcsSocket socket, bool do_linger, int timeout_seconds)
-{
-    if (socket == TCS_SOCKET_INVALID)
-        return TCS_ERROR_INVALID_ARGUMENT;
-
-    struct linger l = {(u_short)do_linger, (u_short)timeout_seconds};
-    return tcs_opt_set(socket, TCS_SOL_SOCKET, TCS_SO_LINGER, &l, sizeof(l));
 }
 
-TcsResult tcs_opt_linger_get(TcsSocket socket, bool* do_linger, int* timeout_seconds)
+TcsResult tcs_accept_many(TcsSocket listener,
+                          TcsSocket out_sockets[],
+                          struct TcsAddress out_addresses[],
+                          size_t sockets_length,
+                          size_t* out_accepted_count)
 {
-    if (socket == TCS_SOCKET_INVALID || (do_linger == NULL && timeout_seconds == NULL))
+    if (out_accepted_count != NULL)
+        *out_accepted_count = 0;
+    if (listener == TCS_SOCKET_INVALID || out_sockets == NULL || sockets_length == 0 || out_accepted_count == NULL)
         return TCS_ERROR_INVALID_ARGUMENT;
 
-    struct linger l = {0, 0};
-    size_t l_size = sizeof(l);
-    TcsResult sts = tcs_opt_get(socket, TCS_SOL_SOCKET, TCS_SO_LINGER, &l, &l_size);
-    if (sts == TCS_SUCCESS)
-    {
-        if (do_linger)
-            *do_linger = l.l_onoff;
-        if (timeout_seconds)
-            *timeout_seconds = l.l_linger;
+    TcsResult res = TCS_SUCCESS;
+    size_t count = 0;
+    while (count < sockets_length)
+    {
+        SOCKADDR_STORAGE native_sockaddr;
+        int addr_len = sizeof(native_sockaddr);
+        PSOCKADDR native_address = out_addresses != NULL ? (PSOCKADDR)&native_sockaddr : NULL;
+        int* native_address_size = out_addresses != NULL ? &addr_len : NULL;
+        SOCKET socket = accept(listener, native_address, native_address_size);
+        if (socket == INVALID_SOCKET)
+        {
+            res = wsaerror2retcode(WSAGetLastError());
+            break;
+        }
+        // Windows has no accept4(), set the flags afterwards
+        u_long non_blocking = 1;
+        if (ioctlsocket(socket, FIONBIO, &non_blocking) == SOCKET_ERROR ||
+            !SetHandleInformation((HANDLE)socket, HANDLE_FLAG_INHERIT, 0))
+        {
+            res = wsaerror2retcode(WSAGetLastError());
+            closesocket(socket);
+            break;
+        }
+        out_sockets[count] = socket;
+        if (out_addresses != NULL)
+        {
+            out_addresses[count] = TCS_ADDRESS_NONE;
+            native2sockaddr((PSOCKADDR)&native_sockaddr, &out_addresses[count]);
+        }
+        count++;
     }
 
-    return sts;
+    *out_accepted_count = count;
+    return count > 0 ? TCS_SUCCESS : res;
 }
 
-// tcs_opt_ip_no_delay_set() is defined in tinycsocket_common.c
-// tcs_opt_ip_no_delay_get() is defined in tinycsocket_common.c
-// tcs_opt_out_of_band_inline_set() is defined in tinycsocket_common.c
-// tcs_opt_out_of_band_inline_get() is defined in tinycsocket_common.c
-// tcs_opt_priority_set() is defined in tinycsocket_common.c
-// tcs_opt_priority_get() is defined in tinycsocket_common.c
-
-TcsResult tcs_opt_nonblocking_set(TcsSocket socket, bool do_non_blocking)
+TcsResult tcs_shutdown(TcsSocket socket, TcsShutdownDirection direction)
 {
+    const int LUT[] = {SD_RECEIVE, SD_SEND, SD_BOTH};
+
     if (socket == TCS_SOCKET_INVALID)
         return TCS_ERROR_INVALID_ARGUMENT;
+    if (direction < 0 || direction > 2)
+        return TCS_ERROR_INVALID_ARGUMENT;
 
-    int flags = fcntl(socket, F_GETFL, 0);
-    if (flags == -1)
-        return errno2retcode(errno);
-
-    if (do_non_blocking)
-        flags |= O_NONBLOCK; /* sätt biten */
-    else
-        flags &= ~O_NONBLOCK; /* rensa biten */
-
-    if (fcntl(socket, F_SETFL, flags) == -1)
-        return errno2retcode(errno);
-
-    return TCS_SUCCESS;
+    const int how = LUT[direction];
+    int shutdown_status = shutdown(socket, how);
+    return socketstatus2retcode(shutdown_status);
 }
 
-TcsResult tcs_opt_nonblocking_get(TcsSocket socket, bool* is_non_blocking)
-{
-    if (socket == TCS_SOCKET_INVALID || is_non_blocking == NULL)
-        return TCS_ERROR_INVALID_ARGUMENT;
-
-    int flags = fcntl(socket, F_GETFL, 0);
-    if (flags == -1)
-        return errno2retcode(errno);
+// ######## Data Transfer ########
 
-    *is_non_blocking = (flags & O_NONBLOCK) != 0;
-    return TCS_SUCCESS;
+// Winsock has no MSG_DONTWAIT, check readiness without waiting instead and strip the flag
+static TcsResult dontwait_check(TcsSocket socket, uint32_t* flags, bool is_send)
+{
+    if ((*flags & TCS_MSG_DONTWAIT) == 0)
+        return TCS_SUCCESS;
+    *flags &= ~TCS_MSG_DONTWAIT;
+
+    fd_set set;
+    FD_ZERO(&set);
+    FD_SET(socket, &set);
+    struct timeval no_wait = {0, 0};
+    int ready = select(0, is_send ? NULL : &set, is_send ? &set : NULL, NULL, &no_wait);
+    if (ready == SOCKET_ERROR)
+        return wsaerror2retcode(WSAGetLastError());
+    return ready == 0 ? TCS_ERROR_WOULD_BLOCK : TCS_SUCCESS;
 }
 
-TcsResult tcs_opt_membership_add(TcsSocket socket, const struct TcsAddress* multicast_address)
+TcsResult tcs_send(TcsSocket socket, const uint8_t* buffer, size_t buffer_size, uint32_t flags, size_t* sent_size)
 {
     if (socket == TCS_SOCKET_INVALID)
         return TCS_ERROR_INVALID_ARGUMENT;
 
-    if (multicast_address == NULL)
+    if (sent_size != NULL)
+        *sent_size = 0;
+
+    if (buffer == NULL || buffer_size == 0)
         return TCS_ERROR_INVALID_ARGUMENT;
 
-    struct TcsAddress local_address = TCS_ADDRESS_NONE;
-    TcsResult sts = tcs_address_socket_local(socket, &local_address);
-    if (sts != TCS_SUCCESS)
-        return sts;
+    TcsResult dontwait_sts = dontwait_check(socket, &flags, true);
+    if (dontwait_sts != TCS_SUCCESS)
+        return dontwait_sts;
 
-    if (local_address.family.native != multicast_address->family.native)
-        return TCS_ERROR_INVALID_ARGUMENT;
+    // Send all
+    if (flags & TCS_MSG_SENDALL)
+    {
+        uint32_t new_flags = flags & ~TCS_MSG_SENDALL; // For recursive call
+        size_t left = buffer_size;
+        const uint8_t* iterator = buffer;
 
-    return tcs_opt_membership_add_to(socket, &local_address, multicast_address);
-}
+        while (left > 0)
+        {
+            size_t sent = 0;
+            TcsResult sts = tcs_send(socket, iterator, left, new_flags, &sent);
+            if (sent_size != NULL)
+                *sent_size += sent;
+            if (sts != TCS_SUCCESS)
+                return sts;
+            left -= sent;
+            iterator += sent;
+        }
+        return TCS_SUCCESS;
+    }
+    else // Send
+    {
+        int send_status = send(socket, (const char*)buffer, (int)buffer_size, (int)flags);
+        if (send_status != SOCKET_ERROR)
+        {
+            if (sent_size != NULL)
+                *sent_size = (size_t)send_status;
+            return TCS_SUCCESS;
+        }
+        else
+        {
+            if (sent_size != NULL)
+                *sent_size = 0;
 
-// tcs_opt_membership_add_str() is defined in tinycsocket_common.c
+            return socketstatus2retcode(send_status);
+        }
+    }
+}
 
-TcsResult tcs_opt_membership_add_to(TcsSocket socket,
-                                    const struct TcsAddress* local_address,
-                                    const struct TcsAddress* multicast_address)
+TcsResult tcs_send_to(TcsSocket socket,
+                      const uint8_t* buffer,
+                      size_t buffer_size,
+                      uint32_t flags,
+                      const struct TcsAddress* destination_address,
+                      size_t* sent_size)
 {
     if (socket == TCS_SOCKET_INVALID)
         return TCS_ERROR_INVALID_ARGUMENT;
-
-    if (multicast_address == NULL)
-        return TCS_ERROR_INVALID_ARGUMENT;
-
-    if (local_address == NULL)
+    if (buffer == NULL && buffer_size > 0)
         return TCS_ERROR_INVALID_ARGUMENT;
-
-    if (local_address->family.native != multicast_address->family.native)
+    if (destination_address == NULL)
         return TCS_ERROR_INVALID_ARGUMENT;
 
-    struct sockaddr_storage local_address_native;
-    memset(&local_address_native, 0, sizeof(struct sockaddr_storage));
-    socklen_t local_address_native_size = 0;
-    TcsResult sts_la2n = sockaddr2native(local_address, &local_address_native, &local_address_native_size);
-    if (sts_la2n != TCS_SUCCESS)
-        return sts_la2n;
-
-    struct sockaddr_storage multicast_address_native;
-    memset(&multicast_address_native, 0, sizeof(struct sockaddr_storage));
-    socklen_t multicast_address_native_size = 0;
-    TcsResult sts_ma2n = sockaddr2native(multicast_address, &multicast_address_native, &multicast_address_native_size);
-    if (sts_ma2n != TCS_SUCCESS)
-        return sts_ma2n;
+    if (flags & TCS_MSG_SENDALL)
+        return TCS_ERROR_NOT_IMPLEMENTED;
 
-    if (multicast_address->family.native == TCS_FAMILY_IPV4.native)
-    {
-        const struct sockaddr_in* address_native_local_p = (struct sockaddr_in*)&local_address_native;
-        const struct sockaddr_in* address_native_multicast_p = (struct sockaddr_in*)&multicast_address_native;
+    TcsResult dontwait_sts = dontwait_check(socket, &flags, true);
+    if (dontwait_sts != TCS_SUCCESS)
+        return dontwait_sts;
 
-        struct ip_mreq mreq;
-        memset(&mreq, 0, sizeof mreq);
+    SOCKADDR_STORAGE native_sockaddr;
+    memset(&native_sockaddr, 0, sizeof native_sockaddr);
+    int addrlen = 0;
+    TcsResult convert_addr_status = sockaddr2native(destination_address, (PSOCKADDR)&native_sockaddr, &addrlen);
+    if (convert_addr_status != TCS_SUCCESS)
+        return convert_addr_status;
 
-        mreq.imr_interface.s_addr = address_native_local_p->sin_addr.s_addr;
-        mreq.imr_multiaddr.s_addr = address_native_multicast_p->sin_addr.s_addr;
+    int sendto_status =
+        sendto(socket, (const char*)buffer, (int)buffer_size, (int)flags, (PSOCKADDR)&native_sockaddr, addrlen);
 
-        TcsResult sts_opt = tcs_opt_set(socket, TCS_SOL_IP, IP_ADD_MEMBERSHIP, &mreq, sizeof(mreq));
-        if (sts_opt != TCS_SUCCESS)
-            return sts_opt;
+    if (sendto_status != SOCKET_ERROR)
+    {
+        if (sent_size != NULL)
+            *sent_size = (size_t)sendto_status;
         return TCS_SUCCESS;
     }
-    else if (multicast_address->family.native == TCS_FAMILY_IPV6.native)
+    else
     {
-        struct ipv6_mreq mreq6;
-        memset(&mreq6, 0, sizeof mreq6);
-        memcpy(&mreq6.ipv6mr_multiaddr, multicast_address->data.ipv6.address.bytes, 16);
-        mreq6.ipv6mr_interface = (unsigned int)local_address->data.ipv6.scope_id;
+        if (sent_size != NULL)
+            *sent_size = 0;
 
-        TcsResult sts_opt = tcs_opt_set(socket, IPPROTO_IPV6, IPV6_JOIN_GROUP, &mreq6, sizeof(mreq6));
-        if (sts_opt != TCS_SUCCESS)
-            return sts_opt;
-        return TCS_SUCCESS;
+        return socketstatus2retcode(sendto_status);
     }
-    else if (multicast_address->family.native == TCS_FAMILY_PACKET.native)
-    {
-#if TCS_HAS_AF_PACKET
-        const struct sockaddr_ll* address_native_local_p = (struct sockaddr_ll*)&local_address_native;
-        const struct sockaddr_ll* address_native_multicast_p = (struct sockaddr_ll*)&multicast_address_native;
+}
 
-        struct packet_mreq mreq;
-        memset(&mreq, 0, sizeof mreq);
-        mreq.mr_ifindex = address_native_local_p->sll_ifindex;
-        mreq.mr_type = PACKET_MR_MULTICAST;
-        memcpy(mreq.mr_address, address_native_multicast_p->sll_addr, ETH_ALEN);
-        mreq.mr_alen = ETH_ALEN;
+TcsResult tcs_send_to_from(TcsSocket socket,
+                           const uint8_t* buffer,
+                           size_t buffer_size,
+                           uint32_t flags,
+                           const struct TcsAddress* destination_address,
+                           const struct TcsAddress* source_address,
+                           TcsInterfaceId interface_id,
+                           size_t* sent_size)
+{
+    if (source_address == NULL && interface_id == 0)
+        return tcs_send_to(socket, buffer, buffer_size, flags, destination_address, sent_size);
 
-        TcsResult sts_opt = tcs_opt_set(socket, SOL_PACKET, PACKET_ADD_MEMBERSHIP, &mreq, sizeof(mreq));
-        if (sts_opt != TCS_SUCCESS)
-            return sts_opt;
-        return TCS_SUCCESS;
-#else
-        return TCS_ERROR_NOT_SUPPORTED;
+    if (sent_size != NULL)
+        *sent_size = 0;
+    return TCS_ERROR_NOT_SUPPORTED;
+}
+
+TcsResult tcs_sendv(TcsSocket socket, const struct TcsIoVec* iov, size_t iov_length, uint32_t flags, size_t* sent_size)
+{
+    if (socket == TCS_SOCKET_INVALID || iov == NULL || iov_length == 0)
+        return TCS_ERROR_INVALID_ARGUMENT;
+
+    if (flags & TCS_MSG_SENDALL)
+        return TCS_ERROR_NOT_IMPLEMENTED;
+
+    TcsResult dontwait_sts = dontwait_check(socket, &flags, true);
+    if (dontwait_sts != TCS_SUCCESS)
+        return dontwait_sts;
+
+    WSABUF stack_buffers[TCS_CFG_SENDV_STACK_MAX];
+    WSABUF* native_buffers = stack_buffers;
+    WSABUF* heap_buffers = NULL;
+
+    if (iov_length > TCS_CFG_SENDV_STACK_MAX)
+    {
+        heap_buffers = (WSABUF*)tcs_lib_malloc(sizeof(WSABUF) * iov_length);
+        if (heap_buffers == NULL)
+            return TCS_ERROR_MEMORY;
+        native_buffers = heap_buffers;
+    }
+
+    for (size_t i = 0; i < iov_length; ++i)
+    {
+        if (iov[i].buffer == NULL && iov[i].buffer_size > 0)
+        {
+            tcs_lib_free(heap_buffers);
+            return TCS_ERROR_INVALID_ARGUMENT;
+        }
+        // WSABUF.buf is non-const by Windows API design, but WSASend does not modify the data.
+#ifdef __GNUC__
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wcast-qual"
+#endif
+        native_buffers[i].buf = (CHAR*)iov[i].buffer;
+#ifdef __GNUC__
+#pragma GCC diagnostic pop
 #endif
+        native_buffers[i].len = (ULONG)iov[i].buffer_size;
     }
-    return TCS_ERROR_NOT_SUPPORTED;
-}
-
-// tcs_opt_membership_drop_str() is defined in tinycsocket_common.c
-
-TcsResult tcs_opt_membership_drop(TcsSocket socket, const struct TcsAddress* multicast_address)
-{
-    if (socket == TCS_SOCKET_INVALID)
-        return TCS_ERROR_INVALID_ARGUMENT;
-
-    if (multicast_address == NULL)
-        return TCS_ERROR_INVALID_ARGUMENT;
 
-    struct TcsAddress local_address = TCS_ADDRESS_NONE;
-    TcsResult sts = tcs_address_socket_local(socket, &local_address);
-    if (sts != TCS_SUCCESS)
-        return sts;
+    DWORD sent = 0;
+    int wsasend_status = WSASend(socket, native_buffers, (DWORD)iov_length, &sent, (DWORD)flags, NULL, NULL);
 
-    if (local_address.family.native != multicast_address->family.native)
-        return TCS_ERROR_INVALID_ARGUMENT;
+    tcs_lib_free(heap_buffers);
 
-    return tcs_opt_membership_drop_from(socket, &local_address, multicast_address);
+    if (wsasend_status != SOCKET_ERROR)
+    {
+        if (sent_size != NULL)
+            *sent_size = (size_t)sent;
+        return TCS_SUCCESS;
+    }
+    else
+    {
+        if (sent_size != NULL)
+            *sent_size = 0;
+        return socketstatus2retcode(wsasend_status);
+    }
 }
 
-TcsResult tcs_opt_membership_drop_from(TcsSocket socket,
-                                       const struct TcsAddress* local_address,
-                                       const struct TcsAddress* multicast_address)
+TcsResult tcs_receive(TcsSocket socket, uint8_t* buffer, size_t buffer_size, uint32_t flags, size_t* received_size)
 {
     if (socket == TCS_SOCKET_INVALID)
         return TCS_ERROR_INVALID_ARGUMENT;
-
-    if (multicast_address == NULL)
-        return TCS_ERROR_INVALID_ARGUMENT;
-
-    if (local_address == NULL)
-        return TCS_ERROR_INVALID_ARGUMENT;
-
-    if (local_address->family.native != multicast_address->family.native)
+    if (buffer == NULL && buffer_size > 0)
         return TCS_ERROR_INVALID_ARGUMENT;
 
-    struct sockaddr_storage local_address_native;
-    memset(&local_address_native, 0, sizeof(struct sockaddr_storage));
-    socklen_t local_address_native_size = 0;
-    TcsResult sts_la2n = sockaddr2native(local_address, &local_address_native, &local_address_native_size);
-    if (sts_la2n != TCS_SUCCESS)
-        return sts_la2n;
-
-    struct sockaddr_storage multicast_address_native;
-    memset(&multicast_address_native, 0, sizeof(struct sockaddr_storage));
-    socklen_t multicast_address_native_size = 0;
-    TcsResult sts_ma2n = sockaddr2native(multicast_address, &multicast_address_native, &multicast_address_native_size);
-    if (sts_ma2n != TCS_SUCCESS)
-        return sts_ma2n;
-
-    if (multicast_address->family.native == TCS_FAMILY_IPV4.native)
+    TcsResult dontwait_sts = dontwait_check(socket, &flags, false);
+    if (dontwait_sts != TCS_SUCCESS)
     {
-        const struct sockaddr_in* address_native_local_p = (struct sockaddr_in*)&local_address_native;
-        const struct sockaddr_in* address_native_multicast_p = (struct sockaddr_in*)&multicast_address_native;
+        if (received_size != NULL)
+            *received_size = 0;
+        return dontwait_sts;
+    }
 
-        struct ip_mreq mreq;
-        memset(&mreq, 0, sizeof mreq);
+#if WINVER <= 0x501
+    if (flags & TCS_MSG_WAITALL)
+    {
+        uint32_t new_flags = flags & ~TCS_MSG_WAITALL; // Unmask for recursive call
+        size_t received_so_far = 0;
+        while (received_so_far < buffer_size)
+        {
+            size_t received_now = 0;
+            uint8_t* cursor = buffer + received_so_far;
+            size_t left = buffer_size - received_so_far;
+            TcsResult sts = tcs_receive(socket, cursor, left, new_flags, &received_now);
+            if (sts != TCS_SUCCESS)
+            {
+                if (received_size != NULL)
+                    *received_size = received_so_far;
+                return sts;
+            }
+            received_so_far += received_now;
+        }
+        if (received_size != NULL)
+            *received_size = received_so_far;
+        return TCS_SUCCESS;
+    }
+#endif
 
-        mreq.imr_interface.s_addr = address_native_local_p->sin_addr.s_addr;
-        mreq.imr_multiaddr.s_addr = address_native_multicast_p->sin_addr.s_addr;
+    int recv_status = recv(socket, (char*)buffer, (int)buffer_size, (int)flags);
 
-        TcsResult sts_opt = tcs_opt_set(socket, TCS_SOL_IP, IP_DROP_MEMBERSHIP, &mreq, sizeof(mreq));
-        if (sts_opt != TCS_SUCCESS)
-            return sts_opt;
+    if (recv_status == 0)
+    {
+        if (received_size != NULL)
+            *received_size = 0;
+        TcsSocketType sock_type = {0};
+        if (tcs_opt_type_get(socket, &sock_type) == TCS_SUCCESS && sock_type.native == TCS_SOCKET_STREAM.native)
+            return TCS_SHUTDOWN;
         return TCS_SUCCESS;
     }
-    else if (multicast_address->family.native == TCS_FAMILY_IPV6.native)
+    else if (recv_status != SOCKET_ERROR)
     {
-        struct ipv6_mreq mreq6;
-        memset(&mreq6, 0, sizeof mreq6);
-        memcpy(&mreq6.ipv6mr_multiaddr, multicast_address->data.ipv6.address.bytes, 16);
-        mreq6.ipv6mr_interface = (unsigned int)local_address->data.ipv6.scope_id;
-
-        TcsResult sts_opt = tcs_opt_set(socket, IPPROTO_IPV6, IPV6_LEAVE_GROUP, &mreq6, sizeof(mreq6));
-        if (sts_opt != TCS_SUCCESS)
-            return sts_opt;
+        if (received_size != NULL)
+            *received_size = (size_t)recv_status;
         return TCS_SUCCESS;
     }
-    else if (multicast_address->family.native == TCS_FAMILY_PACKET.native)
+    else
     {
-#if TCS_HAS_AF_PACKET
-        const struct sockaddr_ll* address_native_local_p = (struct sockaddr_ll*)&local_address_native;
-        const struct sockaddr_ll* address_native_multicast_p = (struct sockaddr_ll*)&multicast_address_native;
-
-        struct packet_mreq mreq;
-        memset(&mreq, 0, sizeof mreq);
-        mreq.mr_ifindex = address_native_local_p->sll_ifindex;
-        mreq.mr_type = PACKET_MR_MULTICAST;
-        memcpy(mreq.mr_address, address_native_multicast_p->sll_addr, ETH_ALEN);
-        mreq.mr_alen = ETH_ALEN;
+        if (received_size != NULL)
+            *received_size = 0;
 
-        TcsResult sts_opt = tcs_opt_set(socket, SOL_PACKET, PACKET_DROP_MEMBERSHIP, &mreq, sizeof(mreq));
-        if (sts_opt != TCS_SUCCESS)
-            return sts_opt;
-        return TCS_SUCCESS;
-#else
-        return TCS_ERROR_NOT_SUPPORTED;
-#endif
+        return socketstatus2retcode(recv_status);
     }
-    return TCS_ERROR_NOT_SUPPORTED;
 }
 
-TcsResult tcs_opt_multicast_interface_set(TcsSocket socket, const struct TcsAddress* local_address)
+TcsResult tcs_receive_from(TcsSocket socket,
+                           uint8_t* buffer,
+                           size_t buffer_size,
+                           uint32_t flags,
+                           struct TcsAddress* source_address,
+                           size_t* received_size)
 {
-    if (socket == TCS_SOCKET_INVALID || local_address == NULL)
+    if (socket == TCS_SOCKET_INVALID)
+        return TCS_ERROR_INVALID_ARGUMENT;
+    if (buffer == NULL && buffer_size > 0)
         return TCS_ERROR_INVALID_ARGUMENT;
+    if (received_size != NULL)
+        *received_size = 0;
 
-    if (local_address->family.native == TCS_FAMILY_IPV4.native)
+    TcsResult dontwait_sts = dontwait_check(socket, &flags, false);
+    if (dontwait_sts != TCS_SUCCESS)
+        return dontwait_sts;
+
+    SOCKADDR_STORAGE native_sockaddr;
+    memset(&native_sockaddr, 0, sizeof native_sockaddr);
+    int addrlen = sizeof(native_sockaddr);
+
+    int recvfrom_status =
+        recvfrom(socket, (char*)buffer, (int)buffer_size, (int)flags, (PSOCKADDR)&native_sockaddr, &addrlen);
+
+    if (recvfrom_status == 0)
     {
-        struct in_addr iface;
-        iface.s_addr = htonl(local_address->data.ipv4.address);
-        return tcs_opt_set(socket, TCS_SOL_IP, IP_MULTICAST_IF, &iface, sizeof(iface));
+        if (received_size != NULL)
+            *received_size = 0;
+        TcsSocketType sock_type = {0};
+        if (tcs_opt_type_get(socket, &sock_type) == TCS_SUCCESS && sock_type.native == TCS_SOCKET_STREAM.native)
+            return TCS_SHUTDOWN;
+        return TCS_SUCCESS;
     }
-    else if (local_address->family.native == TCS_FAMILY_IPV6.native)
+    else if (recvfrom_status != SOCKET_ERROR)
     {
-        unsigned int idx = (unsigned int)local_address->data.ipv6.scope_id;
-        return tcs_opt_set(socket, IPPROTO_IPV6, IPV6_MULTICAST_IF, &idx, sizeof(idx));
+        if (received_size != NULL)
+            *received_size = (size_t)recvfrom_status;
+
+        if (source_address != NULL)
+        {
+            TcsResult convert_address_status = native2sockaddr((PSOCKADDR)&native_sockaddr, source_address);
+            return convert_address_status;
+        }
+
+        return TCS_SUCCESS;
+    }
+    else
+    {
+        if (received_size != NULL)
+            *received_size = 0;
+
+        return socketstatus2retcode(recvfrom_status);
     }
-    return TCS_ERROR_INVALID_ARGUMENT;
 }
 
-TcsResult tcs_opt_multicast_loop_set(TcsSocket socket, bool do_loopback)
+TcsResult tcs_receive_from_to(TcsSocket socket,
+                              uint8_t* buffer,
+                              size_t buffer_size,
+                              uint32_t flags,
+                              struct TcsAddress* source_address,
+                              struct TcsAddress* destination_address,
+                              TcsInterfaceId* interface_id,
+                              size_t* received_size)
 {
-    if (socket == TCS_SOCKET_INVALID)
-        return TCS_ERROR_INVALID_ARGUMENT;
-
-    unsigned char val = do_loopback ? 1 : 0;
-    return tcs_opt_set(socket, TCS_SOL_IP, IP_MULTICAST_LOOP, &val, sizeof(val));
+    (void)socket;
+    (void)buffer;
+    (void)buffer_size;
+    (void)flags;
+    (void)source_address;
+    (void)destination_address;
+    (void)interface_id;
+    if (received_size != NULL)
+        *received_size = 0;
+    // Requires WSARecvMsg() which has to be loaded at runtime through WSAIoctl()
+    return TCS_ERROR_NOT_SUPPORTED;
 }
 
-TcsResult tcs_opt_multicast_loop_get(TcsSocket socket, bool* is_loopback)
-{
-    if (socket == TCS_SOCKET_INVALID || is_loopback == NULL)
-        return TCS_ERROR_INVALID_ARGUMENT;
+// tcs_receive_line() is defined in tinycsocket_common.c
+// tcs_receive_netstring() is defined in tinycsocket_common.c
 
-    unsigned char val = 0;
-    size_t s = sizeof(val);
-    TcsResult sts = tcs_opt_get(socket, TCS_SOL_IP, IP_MULTICAST_LOOP, &val, &s);
-    *is_loopback = val;
-    return sts;
+TcsResult tcs_receive_tx_timestamps(TcsSocket socket,
+                                    struct TcsTxTimestamp out_timestamps[],
+                                    size_t timestamps_length,
+                                    size_t* out_length)
+{
+    (void)socket;
+    (void)out_timestamps;
+    (void)timestamps_length;
+    if (out_length != NULL)
+        *out_length = 0;
+    return TCS_ERROR_NOT_SUPPORTED;
 }
 
-// ######## Address and Interface Utilities ########
+// ######## Socket Polling ########
 
-#if TCS_HAS_GETIFADDRS
-TcsResult tcs_interface_list(struct TcsInterface* out_interfaces,
-                             size_t interfaces_length,
-                             size_t* interfaces_populated)
+TcsResult tcs_poll_create(struct TcsPoll** out_poll)
 {
-    if (out_interfaces == NULL && interfaces_populated == NULL)
-        return TCS_ERROR_INVALID_ARGUMENT;
-
-    if (out_interfaces == NULL && interfaces_length != 0)
+    if (out_poll == NULL || *out_poll != NULL)
         return TCS_ERROR_INVALID_ARGUMENT;
 
-    if (interfaces_populated != NULL)
-        *interfaces_populated = 0;
-
-    struct if_nameindex* interfaces = if_nameindex();
-    if (interfaces == NULL)
-        return errno2retcode(errno);
-
-    for (size_t i = 0; interfaces[i].if_index != 0; ++i)
-    {
-        if (out_interfaces != NULL && i < interfaces_length)
-        {
-            strncpy(out_interfaces[i].name, interfaces[i].if_name, TCS_CFG_INTERFACE_NAME_SIZE - 1);
-            out_interfaces[i].name[TCS_CFG_INTERFACE_NAME_SIZE - 1] = '\0';
-            out_interfaces[i].id = interfaces[i].if_index;
-        }
-        if (interfaces_populated != NULL)
-            *interfaces_populated += 1;
-    }
+    *out_poll = (struct TcsPoll*)tcs_lib_malloc(sizeof(struct TcsPoll));
+    if (*out_poll == NULL)
+        return TCS_ERROR_MEMORY;
+    memset(*out_poll, 0, sizeof(struct TcsPoll));
+    int sts_read_array = tds_ulist_soc_create(&(*out_poll)->read_sockets);
+    int sts_write_array = tds_ulist_soc_create(&(*out_poll)->write_sockets);
+    int sts_error_array = tds_ulist_soc_create(&(*out_poll)->error_sockets);
+    int sts_user_data = tds_map_socket_user_create(&(*out_poll)->user_data);
 
-    if_freenameindex(interfaces);
+    if (sts_read_array != 0 || sts_write_array != 0 || sts_error_array != 0 || sts_user_data != 0)
+    {
+        tcs_poll_destroy(out_poll);
+        return TCS_ERROR_MEMORY;
+    }
     return TCS_SUCCESS;
 }
-#else
-// Fallback using ioctl(SIOCGIFCONF) for systems without if_nameindex (e.g. Android < API 24)
-TcsResult tcs_interface_list(struct TcsInterface* out_interfaces,
-                             size_t interfaces_length,
-                             size_t* interfaces_populated)
+
+TcsResult tcs_poll_destroy(struct TcsPoll** poll)
 {
-    if (out_interfaces == NULL && interfaces_populated == NULL)
+    if (poll == NULL || *poll == NULL)
         return TCS_ERROR_INVALID_ARGUMENT;
 
-    if (out_interfaces == NULL && interfaces_length != 0)
-        return TCS_ERROR_INVALID_ARGUMENT;
+    tds_ulist_soc_destroy(&(*poll)->read_sockets);
+    tds_ulist_soc_destroy(&(*poll)->write_sockets);
+    tds_ulist_soc_destroy(&(*poll)->error_sockets);
+    tds_map_socket_user_destroy(&(*poll)->user_data);
 
-    if (interfaces_populated != NULL)
-        *interfaces_populated = 0;
+    tcs_lib_free(*poll);
+    *poll = NULL;
 
-    int fd = socket(AF_INET, SOCK_DGRAM, 0);
-    if (fd < 0)
-        return errno2retcode(errno);
+    return TCS_SUCCESS;
+}
 
-    // Start with stack buffer, grow on heap if truncated
-    char stack_buf[512];
-    char* buf = stack_buf;
-    int buf_len = (int)sizeof(stack_buf);
-    struct ifconf ifc;
+TcsResult tcs_poll_add(struct TcsPoll* poll, TcsSocket socket, void* user_data, uint32_t flags)
+{
+    if (poll == NULL || socket == TCS_SOCKET_INVALID)
+        return TCS_ERROR_INVALID_ARGUMENT;
 
-    for (;;)
+    int map_sts = tds_map_socket_user_add(&poll->user_data, socket, user_data);
+    if (map_sts != 0)
+        return TCS_ERROR_MEMORY;
+
+    // Always monitor for errors
     {
-        ifc.ifc_len = buf_len;
-        ifc.ifc_buf = buf;
-        if (ioctl(fd, SIOCGIFCONF, &ifc) != 0)
+        int sts = tds_ulist_soc_add(&poll->error_sockets, &socket, 1);
+        if (sts != 0)
         {
-            if (buf != stack_buf)
-                free(buf);
-            close(fd);
-            return errno2retcode(errno);
+            tds_map_socket_user_remove(&poll->user_data, poll->user_data.count - 1);
+            return TCS_ERROR_MEMORY;
         }
-        if (ifc.ifc_len < buf_len)
-            break;
-        // If caller only wants N results (not counting), don't grow beyond what's needed
-        if (out_interfaces != NULL && interfaces_populated == NULL &&
-            (size_t)ifc.ifc_len / sizeof(struct ifreq) >= interfaces_length)
-            break;
-        buf_len *= 2;
-        if (buf != stack_buf)
-            free(buf);
-        buf = (char*)malloc((size_t)buf_len);
-        if (buf == NULL)
+    }
+    if (flags & TCS_POLL_READ)
+    {
+        int sts = tds_ulist_soc_add(&poll->read_sockets, &socket, 1);
+        if (sts != 0)
         {
-            close(fd);
+            tds_ulist_soc_remove(&poll->error_sockets, poll->error_sockets.count - 1, 1);
+            tds_map_socket_user_remove(&poll->user_data, poll->user_data.count - 1);
             return TCS_ERROR_MEMORY;
         }
     }
-
-    size_t count = 0;
-    int offset = 0;
-    while (offset < ifc.ifc_len)
+    if (flags & TCS_POLL_WRITE)
     {
-        struct ifreq* ifr = (struct ifreq*)(buf + offset);
-        int entry_len = (int)sizeof(struct ifreq);
-
-        if (out_interfaces != NULL && count < interfaces_length)
+        int sts = tds_ulist_soc_add(&poll->write_sockets, &socket, 1);
+        if (sts != 0)
         {
-            strncpy(out_interfaces[count].name, ifr->ifr_name, TCS_CFG_INTERFACE_NAME_SIZE - 1);
-            out_interfaces[count].name[TCS_CFG_INTERFACE_NAME_SIZE - 1] = '\0';
-            out_interfaces[count].id = (unsigned int)(count + 1);
+            if (flags & TCS_POLL_READ)
+                tds_ulist_soc_remove(&poll->read_sockets, poll->read_sockets.count - 1, 1);
+            tds_ulist_soc_remove(&poll->error_sockets, poll->error_sockets.count - 1, 1);
+            tds_map_socket_user_remove(&poll->user_data, poll->user_data.count - 1);
+            return TCS_ERROR_MEMORY;
         }
-        count++;
-
-        offset += entry_len;
     }
-
-    if (interfaces_populated != NULL)
-        *interfaces_populated = count;
-
-    if (buf != stack_buf)
-        free(buf);
-    close(fd);
     return TCS_SUCCESS;
 }
-#endif
 
-TcsResult tcs_address_resolve(const char* hostname,
-                              TcsFamily address_family,
-                              struct TcsAddress out_addresses[],
-                              size_t addresses_length,
-                              size_t* out_length)
+TcsResult tcs_poll_modify(struct TcsPoll* poll, TcsSocket socket, uint32_t flags)
 {
-    if (hostname == NULL)
+    if (poll == NULL)
         return TCS_ERROR_INVALID_ARGUMENT;
-
-    if (out_addresses == NULL && out_length == NULL)
+    if (socket == TCS_SOCKET_INVALID)
         return TCS_ERROR_INVALID_ARGUMENT;
 
-    if (out_length != NULL)
-        *out_length = 0;
-
-    // Fast path: try numeric/MAC parse first to avoid DNS lookup
-    struct TcsAddress parsed = TCS_ADDRESS_NONE;
-    if (tcs_address_parse(hostname, &parsed) == TCS_SUCCESS && parsed.family.native != TCS_FAMILY_ANY.native)
+    bool found = false;
+    for (size_t i = 0; i < poll->user_data.count; ++i)
     {
-        if (address_family.native == TCS_FAMILY_ANY.native || parsed.family.native == address_family.native)
+        if (poll->user_data.keys[i] == socket)
         {
-            if (out_addresses != NULL && addresses_length > 0)
-                out_addresses[0] = parsed;
-            if (out_length != NULL)
-                *out_length = 1;
-            return TCS_SUCCESS;
+            found = true;
+            break;
         }
     }
-
-    if (address_family.native == -1) // sentinel for unsupported families (e.g. TCS_FAMILY_PACKET on non-Linux)
-        return TCS_ERROR_NOT_SUPPORTED;
-
-    struct addrinfo native_hints;
-    memset(&native_hints, 0, sizeof native_hints);
-    native_hints.ai_family = address_family.native;
-    native_hints.ai_flags = AI_NUMERICSERV;
-    native_hints.ai_socktype = SOCK_DGRAM;
-    native_hints.ai_protocol = IPPROTO_UDP;
-
-    struct addrinfo* native_addrinfo_list = NULL;
-    int sts = getaddrinfo(hostname, NULL, &native_hints, &native_addrinfo_list);
-
-    // TODO: Move error codes to errno2retcode()
-    if (sts == EAI_SYSTEM)
-        return errno2retcode(errno);
-    else if (sts == EAI_AGAIN)
-        return TCS_ERROR_TEMPORARY_FAILURE;
-    else if (sts == EAI_BADFLAGS)
-        return TCS_ERROR_INVALID_ARGUMENT;
-    else if (sts == EAI_FAIL)
-        return TCS_ERROR_ADDRESS_LOOKUP_FAILED;
-    else if (sts == EAI_FAMILY)
-        return TCS_ERROR_INVALID_ARGUMENT;
-    else if (sts == EAI_MEMORY)
-        return TCS_ERROR_MEMORY;
-    else if (sts == EAI_NONAME)
-        return TCS_ERROR_ADDRESS_LOOKUP_FAILED;
-    else if (sts == EAI_SERVICE)
+    if (!found)
         return TCS_ERROR_INVALID_ARGUMENT;
-    else if (native_addrinfo_list == NULL)
-        return TCS_ERROR_UNKNOWN;
-    else if (sts != 0)
-        return errno2retcode(sts);
 
-    size_t i = 0;
-    if (out_addresses == NULL)
-    {
-        for (struct addrinfo* iter = native_addrinfo_list; iter != NULL; iter = iter->ai_next)
-            i++;
-    }
-    else
+    struct TdsUList_soc* const lists[2] = {&poll->read_sockets, &poll->write_sockets};
+    const bool should_exist[2] = {(flags & TCS_POLL_READ) != 0, (flags & TCS_POLL_WRITE) != 0};
+    for (int k = 0; k < 2; ++k)
     {
-        for (struct addrinfo* iter = native_addrinfo_list; iter != NULL && i < addresses_length; iter = iter->ai_next)
+        struct TdsUList_soc* list = lists[k];
+        bool already_in_list = false;
+        for (size_t i = 0; i < list->count; ++i)
         {
-            if (iter->ai_addr == NULL)
-                continue;
-            TcsResult convert_address_status = native2sockaddr(iter->ai_addr, &out_addresses[i]);
-            if (convert_address_status != TCS_SUCCESS)
-                continue;
-            i++;
+            if (list->data[i] == socket)
+            {
+                if (!should_exist[k])
+                    tds_ulist_soc_remove(list, i, 1);
+                already_in_list = true;
+                break;
+            }
         }
+        if (!already_in_list && should_exist[k])
+            tds_ulist_soc_add(list, &socket, 1);
     }
-    if (out_length != NULL)
-        *out_length = i;
-
-    freeaddrinfo(native_addrinfo_list);
-
-    if (i == 0)
-        return TCS_ERROR_ADDRESS_LOOKUP_FAILED;
 
     return TCS_SUCCESS;
 }
 
-#if TCS_HAS_GETIFADDRS
-TcsResult tcs_address_list(unsigned int interface_id_filter,
-                           TcsFamily address_family_filter,
-                           struct TcsInterfaceAddress out_interface_addresses[],
-                           size_t interface_addresses_length,
-                           size_t* out_length)
+TcsResult tcs_poll_remove(struct TcsPoll* poll, TcsSocket socket)
 {
-    if (out_interface_addresses == NULL && out_length == NULL)
+    if (poll == NULL)
         return TCS_ERROR_INVALID_ARGUMENT;
-    if (out_interface_addresses == NULL && interface_addresses_length != 0)
+    if (socket == TCS_SOCKET_INVALID)
         return TCS_ERROR_INVALID_ARGUMENT;
-    if (out_length != NULL)
-        *out_length = 0;
 
-    struct ifaddrs* ifap = NULL;
-    if (getifaddrs(&ifap) == -1)
+    bool found = false;
+    for (size_t i = 0; i < poll->read_sockets.count; ++i)
     {
-        if (ifap != NULL)
-            freeifaddrs(ifap);
-        return errno2retcode(errno);
+        if (poll->read_sockets.data[i] == socket)
+        {
+            tds_ulist_soc_remove(&poll->read_sockets, i, 1);
+            found = true;
+            break;
+        }
     }
-
-    if (ifap == NULL)
-        return TCS_ERROR_UNKNOWN;
-
-    size_t populated = 0;
-    for (struct ifaddrs* iter = ifap; iter != NULL; iter = iter->ifa_next)
+    for (size_t i = 0; i < poll->write_sockets.count; ++i)
     {
-        if (iter->ifa_addr == NULL)
-            continue;
-
-        if (interface_id_filter != 0)
+        if (poll->write_sockets.data[i] == socket)
         {
-            unsigned int id = if_nametoindex(iter->ifa_name);
-            if (id == 0)
-            {
-                freeifaddrs(ifap);
-                return errno2retcode(errno);
-            }
-            if (id != interface_id_filter)
-                continue;
+            tds_ulist_soc_remove(&poll->write_sockets, i, 1);
+            found = true;
+            break;
         }
-        if (address_family_filter.native != TCS_FAMILY_ANY.native)
+    }
+    for (size_t i = 0; i < poll->error_sockets.count; ++i)
+    {
+        if (poll->error_sockets.data[i] == socket)
         {
-            if (address_family_filter.native == -1) /* unsupported sentinel (e.g. PACKET on non-Linux) */
-                continue;
-            if (iter->ifa_addr->sa_family != address_family_filter.native)
-                continue;
+            tds_ulist_soc_remove(&poll->error_sockets, i, 1);
+            found = true;
+            break;
         }
-
-        struct TcsAddress address = TCS_ADDRESS_NONE;
-        TcsResult convert_address_status = native2sockaddr(iter->ifa_addr, &address);
-        if (convert_address_status != TCS_SUCCESS)
-            continue; // skip entries we cannot represent (unknown family, malformed sockaddr, etc.)
-
-        if (out_interface_addresses != NULL && populated < interface_addresses_length)
+    }
+    for (size_t i = 0; i < poll->user_data.count; ++i)
+    {
+        if (poll->user_data.keys[i] == socket)
         {
-            unsigned int interface_id = if_nametoindex(iter->ifa_name);
-            if (interface_id == 0)
-            {
-                freeifaddrs(ifap);
-                return errno2retcode(errno);
-            }
-
-            strncpy(out_interface_addresses[populated].iface.name, iter->ifa_name, TCS_CFG_INTERFACE_NAME_SIZE - 1);
-            out_interface_addresses[populated].iface.name[TCS_CFG_INTERFACE_NAME_SIZE - 1] = '\0';
-            out_interface_addresses[populated].iface.id = interface_id;
-            out_interface_addresses[populated].address = address;
-            populated++;
+            tds_map_socket_user_remove(&poll->user_data, i);
+            found = true;
+            break;
         }
-        if (out_length != NULL)
-            (*out_length)++;
     }
 
-    freeifaddrs(ifap);
+    if (!found)
+        return TCS_ERROR_INVALID_ARGUMENT;
+
     return TCS_SUCCESS;
 }
-#else
-// Fallback using ioctl(SIOCGIFCONF) for systems without getifaddrs (e.g. Android < API 24, old SunOS)
-// Limitation: SIOCGIFCONF only returns IPv4 addresses. IPv6 enumeration would require
-// platform-specific mechanisms (Linux: /proc/net/if_inet6 or netlink, Solaris: SIOCGLIFCONF).
-TcsResult tcs_address_list(unsigned int interface_id_filter,
-                           TcsFamily address_family_filter,
-                           struct TcsInterfaceAddress out_interface_addresses[],
-                           size_t interface_addresses_length,
-                           size_t* out_length)
+
+TcsResult tcs_poll_wait(struct TcsPoll* poll,
+                        struct TcsPollEvent* out_events,
+                        size_t events_length,
+                        size_t* out_events_length,
+                        int timeout_ms)
 {
-    if (out_interface_addresses == NULL && out_length == NULL)
+    if (poll == NULL)
         return TCS_ERROR_INVALID_ARGUMENT;
-    if (out_interface_addresses == NULL && interface_addresses_length != 0)
+    if (out_events == NULL || out_events_length == NULL)
+        return TCS_ERROR_INVALID_ARGUMENT;
+    if (timeout_ms < 0 && timeout_ms != TCS_WAIT_INF)
         return TCS_ERROR_INVALID_ARGUMENT;
-    if (out_length != NULL)
-        *out_length = 0;
 
-    // Check if we support the requested address family in the ioctl fallback.
-    // IPv4 is always available. AF_PACKET is available on Linux via SIOCGIFHWADDR.
-    bool supported = (address_family_filter.native == TCS_FAMILY_ANY.native ||
-                      address_family_filter.native == TCS_FAMILY_IPV4.native);
-#if TCS_HAS_AF_PACKET
-    supported = supported || (address_family_filter.native == TCS_FAMILY_PACKET.native);
-#endif
-    if (!supported)
-        return TCS_SUCCESS;
+    // Todo: add more modern implementation. Maybe dispatch att init?
+    // SELECT IMPLEMENTATION
 
-    int fd = socket(AF_INET, SOCK_DGRAM, 0);
-    if (fd < 0)
-        return errno2retcode(errno);
+    // Copy fds, use auto storage if possible, otherwise use dynamic memory
 
-    // Start with stack buffer, grow on heap if truncated
-    char stack_buf[512];
-    char* buf = stack_buf;
-    int buf_len = (int)sizeof(stack_buf);
-    struct ifconf ifc;
+    // Allocate so that we can access fd_array out of nominal bounds
+    // We need this hack to be able to use dynamic memory for select
+    const size_t data_offset = offsetof(struct tcs_fd_set, fd_array);
 
-    for (;;)
+    struct fd_set rfds_stack;
+    struct fd_set wfds_stack;
+    struct fd_set efds_stack;
+
+    struct tcs_fd_set* rfds_heap = NULL;
+    struct tcs_fd_set* wfds_heap = NULL;
+    struct tcs_fd_set* efds_heap = NULL;
+
+    struct tcs_fd_set* rfds_cpy = NULL;
+    struct tcs_fd_set* wfds_cpy = NULL;
+    struct tcs_fd_set* efds_cpy = NULL;
+
+    if (poll->read_sockets.count <= FD_SETSIZE)
     {
-        ifc.ifc_len = buf_len;
-        ifc.ifc_buf = buf;
-        if (ioctl(fd, SIOCGIFCONF, &ifc) != 0)
+        FD_ZERO(&rfds_stack);
+        rfds_cpy = (struct tcs_fd_set*)&rfds_stack;
+    }
+    else
+    {
+        rfds_heap = (struct tcs_fd_set*)tcs_lib_malloc(data_offset + sizeof(SOCKET) * poll->read_sockets.count);
+        if (rfds_heap == NULL)
+            return TCS_ERROR_MEMORY;
+        rfds_cpy = rfds_heap;
+    }
+
+    if (poll->write_sockets.count <= FD_SETSIZE)
+    {
+        FD_ZERO(&wfds_stack);
+        wfds_cpy = (struct tcs_fd_set*)&wfds_stack;
+    }
+    else
+    {
+        wfds_heap = (struct tcs_fd_set*)tcs_lib_malloc(data_offset + sizeof(SOCKET) * poll->write_sockets.count);
+        if (wfds_heap == NULL)
         {
-            if (buf != stack_buf)
-                free(buf);
-            close(fd);
-            return errno2retcode(errno);
+            tcs_lib_free(rfds_heap);
+            return TCS_ERROR_MEMORY;
         }
-        if (ifc.ifc_len < buf_len)
-            break;
-        if (out_interface_addresses != NULL && out_length == NULL &&
-            (size_t)ifc.ifc_len / sizeof(struct ifreq) >= interface_addresses_length)
-            break;
-        buf_len *= 2;
-        if (buf != stack_buf)
-            free(buf);
-        buf = (char*)malloc((size_t)buf_len);
-        if (buf == NULL)
+        wfds_cpy = wfds_heap;
+    }
+
+    if (poll->error_sockets.count <= FD_SETSIZE)
+    {
+        FD_ZERO(&efds_stack);
+        efds_cpy = (struct tcs_fd_set*)&efds_stack;
+    }
+    else
+    {
+        efds_heap = (struct tcs_fd_set*)tcs_lib_malloc(data_offset + sizeof(SOCKET) * poll->error_sockets.count);
+        if (efds_heap == NULL)
         {
-            close(fd);
+            tcs_lib_free(rfds_heap);
+            tcs_lib_free(wfds_heap);
             return TCS_ERROR_MEMORY;
         }
+        efds_cpy = efds_heap;
     }
+    rfds_cpy->fd_count = (u_int)poll->read_sockets.count;
+    wfds_cpy->fd_count = (u_int)poll->write_sockets.count;
+    efds_cpy->fd_count = (u_int)poll->error_sockets.count;
 
-    size_t populated = 0;
-    int offset = 0;
-    while (offset < ifc.ifc_len)
+    memcpy(rfds_cpy->fd_array, poll->read_sockets.data, sizeof(SOCKET) * poll->read_sockets.count);
+    memcpy(wfds_cpy->fd_array, poll->write_sockets.data, sizeof(SOCKET) * poll->write_sockets.count);
+    memcpy(efds_cpy->fd_array, poll->error_sockets.data, sizeof(SOCKET) * poll->error_sockets.count);
+
+    memset(out_events, 0, sizeof(struct TcsPollEvent) * events_length);
+    *out_events_length = 0;
+
+    // Run select
+    struct timeval* t_ptr = NULL;
+    struct timeval t = {0, 0};
+    if (timeout_ms != TCS_WAIT_INF)
     {
-        struct ifreq* ifr = (struct ifreq*)(buf + offset);
-        int entry_len = (int)sizeof(struct ifreq);
+        t.tv_sec = (long)(timeout_ms / 1000);
+        t.tv_usec = (long)(timeout_ms % 1000) * 1000;
+        t_ptr = &t;
+    }
+    int no = select(IGNORE, (fd_set*)rfds_cpy, (fd_set*)wfds_cpy, (fd_set*)efds_cpy, t_ptr);
 
-        unsigned int iface_id = if_nametoindex(ifr->ifr_name);
-        if (iface_id == 0)
-        {
-            offset += entry_len;
-            continue;
-        }
+    size_t events_added = 0;
 
-        if (interface_id_filter != 0 && iface_id != interface_id_filter)
+    if (no > 0)
+    {
+        for (u_int n = 0; n < rfds_cpy->fd_count && events_added < events_length; ++n)
         {
-            offset += entry_len;
-            continue;
+            out_events[events_added].socket = rfds_cpy->fd_array[n];
+            out_events[events_added].can_read = true;
+            for (size_t i = 0; i < poll->user_data.count; ++i)
+            {
+                if (out_events[events_added].socket == poll->user_data.keys[i])
+                {
+                    out_events[events_added].user_data = poll->user_data.values[i];
+                    break;
+                }
+            }
+            events_added++;
         }
-
-        // IPv4 addresses
-        if (address_family_filter.native == TCS_FAMILY_ANY.native ||
-            address_family_filter.native == TCS_FAMILY_IPV4.native)
+        for (u_int n = 0; n < wfds_cpy->fd_count && events_added < events_length; ++n)
         {
-            struct TcsAddress address = TCS_ADDRESS_NONE;
-            TcsResult convert_status = native2sockaddr((struct sockaddr*)&ifr->ifr_addr, &address);
-            if (convert_status == TCS_SUCCESS)
+            // Check already added events
+            size_t new_n = events_added;
+            for (size_t m = 0; m < events_added; ++m)
             {
-                if (out_interface_addresses != NULL && populated < interface_addresses_length)
+                if (out_events[m].socket == wfds_cpy->fd_array[n])
                 {
-                    strncpy(
-                        out_interface_addresses[populated].iface.name, ifr->ifr_name, TCS_CFG_INTERFACE_NAME_SIZE - 1);
-                    out_interface_addresses[populated].iface.name[TCS_CFG_INTERFACE_NAME_SIZE - 1] = '\0';
-                    out_interface_addresses[populated].iface.id = iface_id;
-                    out_interface_addresses[populated].address = address;
-                    populated++;
+                    new_n = m;
+                    break;
                 }
-                if (out_length != NULL)
-                    (*out_length)++;
             }
-        }
+            out_events[new_n].can_write = true;
+            // Check for new events
+            if (events_added == new_n)
+            {
+                out_events[new_n].socket = wfds_cpy->fd_array[n];
 
-#if TCS_HAS_AF_PACKET
-        // AF_PACKET addresses via SIOCGIFHWADDR (Ethernet only)
-        if (address_family_filter.native == TCS_FAMILY_ANY.native ||
-            address_family_filter.native == TCS_FAMILY_PACKET.native)
+                for (size_t i = 0; i < poll->user_data.count; ++i)
+                {
+                    if (out_events[new_n].socket == poll->user_data.keys[i])
+                    {
+                        out_events[new_n].user_data = poll->user_data.values[i];
+                        break;
+                    }
+                }
+                events_added++;
+            }
+        }
+        for (u_int n = 0; n < efds_cpy->fd_count && events_added < events_length; ++n)
         {
-            struct ifreq hw_req;
-            memset(&hw_req, 0, sizeof(hw_req));
-            strncpy(hw_req.ifr_name, ifr->ifr_name, IFNAMSIZ - 1);
-
-            if (ioctl(fd, SIOCGIFHWADDR, &hw_req) == 0 && hw_req.ifr_hwaddr.sa_family == ARPHRD_ETHER)
+            // Check already added events
+            size_t new_n = events_added;
+            for (size_t m = 0; m < events_added; ++m)
+            {
+                if (out_events[m].socket == efds_cpy->fd_array[n])
+                {
+                    new_n = m;
+                    break;
+                }
+            }
+            // Get the actual socket error
+            int so_error = 0;
+            int so_error_size = sizeof(so_error);
+            if (getsockopt((SOCKET)efds_cpy->fd_array[n], SOL_SOCKET, SO_ERROR, (char*)&so_error, &so_error_size) != 0)
+                out_events[new_n].error = wsaerror2retcode(WSAGetLastError());
+            else
+                out_events[new_n].error = so_error != 0 ? wsaerror2retcode(so_error) : TCS_ERROR_UNKNOWN;
+            if (events_added == new_n)
             {
-                if (out_interface_addresses != NULL && populated < interface_addresses_length)
+                out_events[new_n].socket = efds_cpy->fd_array[n];
+
+                for (size_t i = 0; i < poll->user_data.count; ++i)
                 {
-                    strncpy(
-                        out_interface_addresses[populated].iface.name, ifr->ifr_name, TCS_CFG_INTERFACE_NAME_SIZE - 1);
-                    out_interface_addresses[populated].iface.name[TCS_CFG_INTERFACE_NAME_SIZE - 1] = '\0';
-                    out_interface_addresses[populated].iface.id = iface_id;
-                    out_interface_addresses[populated].address.family = TCS_FAMILY_PACKET;
-                    out_interface_addresses[populated].address.data.packet.interface_id = iface_id;
-                    memcpy(out_interface_addresses[populated].address.data.packet.mac, hw_req.ifr_hwaddr.sa_data, 6);
-                    populated++;
+                    if (out_events[new_n].socket == poll->user_data.keys[i])
+                    {
+                        out_events[new_n].user_data = poll->user_data.values[i];
+                        break;
+                    }
                 }
-                if (out_length != NULL)
-                    (*out_length)++;
+
+                events_added++;
             }
         }
-#endif
+    }
 
-        offset += entry_len;
+    *out_events_length = events_added;
+
+    // Clean up
+    if (rfds_heap != NULL)
+        tcs_lib_free(rfds_heap);
+    if (wfds_heap != NULL)
+        tcs_lib_free(wfds_heap);
+    if (efds_heap != NULL)
+        tcs_lib_free(efds_heap);
+
+    if (no == 0)
+    {
+        return TCS_ERROR_TIMED_OUT;
+    }
+    if (no == SOCKET_ERROR)
+    {
+        int error_code = WSAGetLastError();
+        return wsaerror2retcode(error_code);
     }
 
-    if (buf != stack_buf)
-        free(buf);
-    close(fd);
     return TCS_SUCCESS;
 }
-#endif
 
-TcsResult tcs_address_socket_local(TcsSocket socket, struct TcsAddress* local_address)
+// ######## Connection Pool ########
+
+// tcs_pool_create() is defined in tinycsocket_common.c
+// tcs_pool_destroy() is defined in tinycsocket_common.c
+// tcs_pool_acquire() is defined in tinycsocket_common.c
+// tcs_pool_release() is defined in tinycsocket_common.c
+
+// ######## Asynchronous Resolve ########
+
+// tcs_resolver_create() is defined in tinycsocket_common.c
+// tcs_resolver_destroy() is defined in tinycsocket_common.c
+// tcs_resolver_socket() is defined in tinycsocket_common.c
+// tcs_resolver_submit() is defined in tinycsocket_common.c
+// tcs_resolver_take() is defined in tinycsocket_common.c
+// tcs_resolver_cancel() is defined in tinycsocket_common.c
+
+// ######## Packet Rings ########
+
+TcsResult tcs_packet_ring_rx_create(struct TcsPacketRing** out_ring,
+                                    TcsSocket socket,
+                                    size_t block_size,
+                                    size_t block_count,
+                                    size_t frame_size,
+                                    int block_timeout_ms)
 {
-    if (socket == TCS_SOCKET_INVALID || local_address == NULL)
+    (void)out_ring;
+    (void)socket;
+    (void)block_size;
+    (void)block_count;
+    (void)frame_size;
+    (void)block_timeout_ms;
+    return TCS_ERROR_NOT_SUPPORTED;
+}
+
+TcsResult tcs_packet_ring_destroy(struct TcsPacketRing** ring)
+{
+    (void)ring;
+    return TCS_ERROR_NOT_SUPPORTED;
+}
+
+TcsResult tcs_packet_ring_rx_next(struct TcsPacketRing* ring, struct TcsPacketFrame* out_frame)
+{
+    (void)ring;
+    (void)out_frame;
+    return TCS_ERROR_NOT_SUPPORTED;
+}
+
+TcsResult tcs_packet_ring_rx_release(struct TcsPacketRing* ring)
+{
+    (void)ring;
+    return TCS_ERROR_NOT_SUPPORTED;
+}
+
+TcsResult tcs_packet_ring_tx_create(struct TcsPacketRing** out_ring,
+                                    TcsSocket socket,
+                                    size_t block_size,
+                                    size_t block_count,
+                                    size_t frame_size)
+{
+    (void)out_ring;
+    (void)socket;
+    (void)block_size;
+    (void)block_count;
+    (void)frame_size;
+    return TCS_ERROR_NOT_SUPPORTED;
+}
+
+TcsResult tcs_packet_ring_tx_acquire(struct TcsPacketRing* ring, uint8_t** out_data, size_t* out_capacity)
+{
+    (void)ring;
+    (void)out_data;
+    (void)out_capacity;
+    return TCS_ERROR_NOT_SUPPORTED;
+}
+
+TcsResult tcs_packet_ring_tx_commit(struct TcsPacketRing* ring, size_t frame_size)
+{
+    (void)ring;
+    (void)frame_size;
+    return TCS_ERROR_NOT_SUPPORTED;
+}
+
+TcsResult tcs_packet_ring_tx_flush(struct TcsPacketRing* ring, const struct TcsAddress* destination_address)
+{
+    (void)ring;
+    (void)destination_address;
+    return TCS_ERROR_NOT_SUPPORTED;
+}
+
+// ######## Socket Options ########
+
+TcsResult tcs_opt_set(TcsSocket socket,
+                      int32_t level,
+                      int32_t option_name,
+                      const void* option_value,
+                      size_t option_size)
+{
+    if (socket == TCS_SOCKET_INVALID)
         return TCS_ERROR_INVALID_ARGUMENT;
 
-    struct sockaddr_storage native_sockaddr;
-    memset(&native_sockaddr, 0, sizeof native_sockaddr);
-    socklen_t addrlen = sizeof native_sockaddr;
-    if (getsockname(socket, (struct sockaddr*)&native_sockaddr, &addrlen) != 0)
-        return errno2retcode(errno);
+    if (option_name == -1)
+        return TCS_ERROR_NOT_IMPLEMENTED;
 
-    return native2sockaddr((struct sockaddr*)&native_sockaddr, local_address);
+    int sockopt_status = setsockopt(socket, (int)level, (int)option_name, (const char*)option_value, (int)option_size);
+    return socketstatus2retcode(sockopt_status);
 }
 
-TcsResult tcs_address_socket_remote(TcsSocket socket, struct TcsAddress* remote_address)
+TcsResult tcs_opt_get(TcsSocket socket, int32_t level, int32_t option_name, void* out_option_value, size_t* option_size)
 {
-    if (socket == TCS_SOCKET_INVALID || remote_address == NULL)
+    if (socket == TCS_SOCKET_INVALID || out_option_value == NULL || option_size == NULL)
         return TCS_ERROR_INVALID_ARGUMENT;
 
-    struct sockaddr_storage native_sockaddr;
-    memset(&native_sockaddr, 0, sizeof native_sockaddr);
-    socklen_t addrlen = sizeof native_sockaddr;
-    if (getpeername(socket, (struct sockaddr*)&native_sockaddr, &addrlen) != 0)
-        return errno2retcode(errno);
+    if (option_name == -1)
+        return TCS_ERROR_NOT_IMPLEMENTED;
 
-    return native2sockaddr((struct sockaddr*)&native_sockaddr, remote_address);
+    int optlen = (int)*option_size;
+    int sockopt_status = getsockopt(socket, (int)level, (int)option_name, (char*)out_option_value, &optlen);
+    if (sockopt_status == 0)
+        *option_size = (size_t)optlen;
+    return socketstatus2retcode(sockopt_status);
 }
 
-TcsResult tcs_address_socket_family(TcsSocket socket, TcsFamily* out_family)
+// tcs_opt_broadcast_set() is defined in tinycsocket_common.c
+// tcs_opt_broadcast_get() is defined in tinycsocket_common.c
+// tcs_opt_keep_alive_set() is defined in tinycsocket_common.c
+// tcs_opt_keep_alive_get() is defined in tinycsocket_common.c
+TcsResult tcs_opt_reuse_address_set(TcsSocket socket, bool do_allow_reuse_address)
 {
-    if (socket == TCS_SOCKET_INVALID || out_family == NULL)
+    if (socket == TCS_SOCKET_INVALID)
         return TCS_ERROR_INVALID_ARGUMENT;
 
-    struct sockaddr_storage native_sockaddr;
-    memset(&native_sockaddr, 0, sizeof native_sockaddr);
-    socklen_t addrlen = sizeof native_sockaddr;
-    if (getsockname(socket, (struct sockaddr*)&native_sockaddr, &addrlen) != 0)
-        return errno2retcode(errno);
+    int b = do_allow_reuse_address ? 1 : 0;
+    TcsResult sts = tcs_opt_set(socket, TCS_SOL_SOCKET, TCS_SO_REUSEADDR, &b, sizeof(b));
+    if (sts != TCS_SUCCESS)
+        return sts;
+
+#if _WIN32_WINNT >= 0x0502
+    TcsSocketType sock_type = {0};
+    if (tcs_opt_type_get(socket, &sock_type) == TCS_SUCCESS && sock_type.native == TCS_SOCKET_STREAM.native)
+        tcs_opt_set(socket, TCS_SOL_SOCKET, SO_EXCLUSIVEADDRUSE, &b, sizeof(b));
+#endif
 
-    out_family->native = (int)native_sockaddr.ss_family;
     return TCS_SUCCESS;
 }
 
-// tcs_address_parse() is defined in tinycsocket_common.c
-// tcs_address_to_str() is defined in tinycsocket_common.c
-// tcs_address_is_equal() is defined in tinycsocket_common.c
-// tcs_address_is_any() is defined in tinycsocket_common.c
-// tcs_address_is_link_local() is defined in tinycsocket_common.c
-// tcs_address_is_loopback() is defined in tinycsocket_common.c
-// tcs_address_is_multicast() is defined in tinycsocket_common.c
-// tcs_address_is_broadcast() is defined in tinycsocket_common.c
+TcsResult tcs_opt_reuse_address_get(TcsSocket socket, bool* is_reuse_address_allowed)
+{
+    if (socket == TCS_SOCKET_INVALID || is_reuse_address_allowed == NULL)
+        return TCS_ERROR_INVALID_ARGUMENT;
+    int b = 0;
+    size_t s = sizeof(b);
+    TcsResult sts = tcs_opt_get(socket, TCS_SOL_SOCKET, TCS_SO_REUSEADDR, &b, &s);
+    *is_reuse_address_allowed = b;
+    return sts;
+}
 
-#endif
+TcsResult tcs_opt_reuse_port_set(TcsSocket socket, bool do_allow_reuse_port)
+{
+    (void)socket;
+    (void)do_allow_reuse_port;
+    return TCS_ERROR_NOT_SUPPORTED;
+}
 
-/**********************************/
-/****** tinycsocket_win32.h *******/
-/**********************************/
-/*
- * Copyright 2018 Markus Lindelöw
- *
- * Permission is hereby granted, free of charge, to any person obtaining a copy
- * of this software and associated documentation files(the "Software"), to deal
- * in the Software without restriction, including without limitation the rights
- * to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
- * copies of the Software, and to permit persons to whom the Software is
- * furnished to do so, subject to the following conditions:
- *
- * The above copyright notice and this permission notice shall be included in all
- * copies or substantial portions of the Software.
- *
- * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
- * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
- * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
- * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
- * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
- * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
- * SOFTWARE.
- */
-#ifndef TINYCSOCKET_INTERNAL_H_
-#include "tinycsocket_internal.h"
-#endif
-#ifdef TINYCSOCKET_USE_WIN32_IMPL
+TcsResult tcs_opt_reuse_port_get(TcsSocket socket, bool* is_reuse_port_allowed)
+{
+    (void)socket;
+    (void)is_reuse_port_allowed;
+    return TCS_ERROR_NOT_SUPPORTED;
+}
+
+// tcs_opt_send_buffer_size_set() is defined in tinycsocket_common.c
+// tcs_opt_send_buffer_size_get() is defined in tinycsocket_common.c
+// tcs_opt_receive_buffer_size_set() is defined in tinycsocket_common.c
+// tcs_opt_receive_buffer_size_get() is defined in tinycsocket_common.c
+
+TcsResult tcs_opt_receive_timeout_set(TcsSocket socket, int timeout_ms)
+{
+    if (socket == TCS_SOCKET_INVALID || timeout_ms < 0)
+        return TCS_ERROR_INVALID_ARGUMENT;
+
+    return tcs_opt_set(socket, TCS_SOL_SOCKET, TCS_SO_RCVTIMEO, &timeout_ms, sizeof(timeout_ms));
+}
+
+TcsResult tcs_opt_receive_timeout_get(TcsSocket socket, int* timeout_ms)
+{
+    if (socket == TCS_SOCKET_INVALID || timeout_ms == NULL)
+        return TCS_ERROR_INVALID_ARGUMENT;
+
+    DWORD t = 0;
+    size_t t_size = sizeof(t);
+    TcsResult sts = tcs_opt_get(socket, TCS_SOL_SOCKET, TCS_SO_RCVTIMEO, &t, &t_size);
+
+    if (sts == TCS_SUCCESS)
+    {
+        *timeout_ms = (int)t;
+    }
+    return sts;
+}
+
+TcsResult tcs_opt_linger_set(TcsSocket socket, bool do_linger, int timeout_seconds)
+{
+    if (socket == TCS_SOCKET_INVALID)
+        return TCS_ERROR_INVALID_ARGUMENT;
+
+    struct linger l = {(u_short)do_linger, (u_short)timeout_seconds};
+    return tcs_opt_set(socket, TCS_SOL_SOCKET, TCS_SO_LINGER, &l, sizeof(l));
+}
+
+TcsResult tcs_opt_linger_get(TcsSocket socket, bool* do_linger, int* timeout_seconds)
+{
+    if (socket == TCS_SOCKET_INVALID || (do_linger == NULL && timeout_seconds == NULL))
+        return TCS_ERROR_INVALID_ARGUMENT;
+
+    struct linger l = {0, 0};
+    size_t l_size = sizeof(l);
+    TcsResult sts = tcs_opt_get(socket, TCS_SOL_SOCKET, TCS_SO_LINGER, &l, &l_size);
+    if (sts == TCS_SUCCESS)
+    {
+        if (do_linger)
+            *do_linger = l.l_onoff;
+        if (timeout_seconds)
+            *timeout_seconds = l.l_linger;
+    }
 
-#ifdef DO_WRAP
-#include "dbg_wrap.h"
-#endif
+    return sts;
+}
 
-// Header only should not need other files
-#ifndef TINYDATASTRUCTURES_H_
-#include "tinydatastructures.h"
-#endif
-// before windows.h
-#define WIN32_LEAN_AND_MEAN
-#define NOMINMAX
-#include <winsock2.h> // sockets
+// tcs_opt_ip_no_delay_set() is defined in tinycsocket_common.c
+// tcs_opt_ip_no_delay_get() is defined in tinycsocket_common.c
 
-#include <windows.h>
+// TCP Fast Open on Windows needs ConnectEx(), fall back to normal handshakes
 
-// after windows.h
-#include <iphlpapi.h> // GetAdaptersAddresses
-#include <ws2tcpip.h> // getaddrinfo
+TcsResult tcs_opt_tcp_fast_open_set(TcsSocket socket, int queue_length)
+{
+    if (socket == TCS_SOCKET_INVALID || queue_length < 0)
+        return TCS_ERROR_INVALID_ARGUMENT;
+    return TCS_SUCCESS;
+}
 
-#include <stdio.h>  // fprintf (debug diagnostics)
-#include <stdlib.h> // Malloc for GetAdaptersAddresses
-#include <string.h> // memset
+TcsResult tcs_opt_tcp_fast_open_get(TcsSocket socket, int* queue_length)
+{
+    if (socket == TCS_SOCKET_INVALID || queue_length == NULL)
+        return TCS_ERROR_INVALID_ARGUMENT;
+    *queue_length = 0;
+    return TCS_SUCCESS;
+}
 
-// SOCKADDR_STORAGE was introduced in Windows XP (0x0501).
-// For Win2K targets with MSVC, define it ourselves.
-// mingw-w64 always defines it, so check _MSC_VER to avoid redefinition.
-#if defined(_MSC_VER) && defined(_WIN32_WINNT) && _WIN32_WINNT < 0x0501
-typedef struct
+TcsResult tcs_opt_tcp_fast_open_connect_set(TcsSocket socket, bool do_fast_open)
 {
-    short ss_family;
-    char __ss_pad1[6];
-    __int64 __ss_align;
-    char __ss_pad2[112];
-} SOCKADDR_STORAGE, *PSOCKADDR_STORAGE;
-#endif
+    (void)do_fast_open;
+    if (socket == TCS_SOCKET_INVALID)
+        return TCS_ERROR_INVALID_ARGUMENT;
+    return TCS_SUCCESS;
+}
 
-#if defined(_MSC_VER) || defined(__clang__)
-#pragma comment(lib, "wsock32.lib")
-#pragma comment(lib, "ws2_32.lib")
-#pragma comment(lib, "Iphlpapi.lib")
-#endif
+TcsResult tcs_opt_tcp_fast_open_connect_get(TcsSocket socket, bool* is_fast_open)
+{
+    if (socket == TCS_SOCKET_INVALID || is_fast_open == NULL)
+        return TCS_ERROR_INVALID_ARGUMENT;
+    *is_fast_open = false;
+    return TCS_SUCCESS;
+}
+// tcs_opt_out_of_band_inline_set() is defined in tinycsocket_common.c
+// tcs_opt_out_of_band_inline_get() is defined in tinycsocket_common.c
+// tcs_opt_priority_set() is defined in tinycsocket_common.c
+// tcs_opt_priority_get() is defined in tinycsocket_common.c
 
-#ifndef ULIST_SOC
-#define ULIST_SOC
-TDS_ULIST_IMPL(SOCKET, soc)
-#endif
+TcsResult tcs_opt_nonblocking_set(TcsSocket socket, bool do_non_blocking)
+{
+    if (socket == TCS_SOCKET_INVALID)
+        return TCS_ERROR_INVALID_ARGUMENT;
 
-#ifndef ULIST_PVOID
-#define ULIST_PVOID
-TDS_ULIST_IMPL(void*, pvoid)
-#endif
+    u_long mode = do_non_blocking ? 1 : 0;
+    int sts = ioctlsocket((SOCKET)socket, (long)FIONBIO, &mode);
+    return socketstatus2retcode(sts);
+}
 
-#ifndef TDS_MAP_socket_pvoid
-#define TDS_MAP_socket_pvoid
-TDS_MAP_IMPL(SOCKET, void*, socket_user)
-#endif
+TcsResult tcs_opt_nonblocking_get(TcsSocket socket, bool* is_non_blocking)
+{
+    (void)socket;
+    (void)is_non_blocking;
+    // Win32 does not provide an API to query the non-blocking state of a socket
+    return TCS_ERROR_NOT_SUPPORTED;
+}
 
-// Needs to be compatible with fd_set, hopefully this works. Only used when FD_SETSIZE is to small.
-struct tcs_fd_set
+TcsResult tcs_opt_tx_timestamping_set(TcsSocket socket, bool do_timestamp)
 {
-    u_int fd_count;
-    SOCKET fd_array[1]; // dynamic memory hack that is compatible with Win32 API fd_set
-};
+    (void)socket;
+    (void)do_timestamp;
+    return TCS_ERROR_NOT_SUPPORTED;
+}
 
-struct TcsPoll
+TcsResult tcs_opt_tx_timestamping_get(TcsSocket socket, bool* is_timestamping)
 {
-    struct TdsUList_soc read_sockets;
-    struct TdsUList_soc write_sockets;
-    struct TdsUList_soc error_sockets;
-    struct TdsMap_socket_user user_data;
-};
+    (void)socket;
+    (void)is_timestamping;
+    return TCS_ERROR_NOT_SUPPORTED;
+}
 
-const TcsSocket TCS_SOCKET_INVALID = INVALID_SOCKET;
-const int32_t TCS_WAIT_INF = -1;
+TcsResult tcs_opt_packet_info_set(TcsSocket socket, bool do_receive_packet_info)
+{
+    (void)socket;
+    (void)do_receive_packet_info;
+    return TCS_ERROR_NOT_SUPPORTED;
+}
 
-// Addresses
-const TcsAddressIpv4 TCS_ADDRESS_IPV4_ANY = INADDR_ANY;
-const TcsAddressIpv4 TCS_ADDRESS_IPV4_LOOPBACK = INADDR_LOOPBACK;
-const TcsAddressIpv4 TCS_ADDRESS_IPV4_BROADCAST = INADDR_BROADCAST;
-const TcsAddressIpv4 TCS_ADDRESS_IPV4_NONE = INADDR_NONE;
+TcsResult tcs_opt_packet_info_get(TcsSocket socket, bool* is_packet_info_received)
+{
+    (void)socket;
+    (void)is_packet_info_received;
+    return TCS_ERROR_NOT_SUPPORTED;
+}
 
-const struct TcsAddressIpv6 TCS_ADDRESS_IPV6_ANY = {{0}};
-const struct TcsAddressIpv6 TCS_ADDRESS_IPV6_LOOPBACK = {{0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1}};
+TcsResult tcs_opt_packet_qdisc_bypass_set(TcsSocket socket, bool do_bypass)
+{
+    (void)socket;
+    (void)do_bypass;
+    return TCS_ERROR_NOT_SUPPORTED;
+}
 
-// Family
-const TcsFamily TCS_FAMILY_ANY = {AF_UNSPEC};
-const TcsFamily TCS_FAMILY_IPV4 = {AF_INET};
-const TcsFamily TCS_FAMILY_IPV6 = {AF_INET6};
-const TcsFamily TCS_FAMILY_PACKET = {-1}; /* AF_PACKET unsupported on Windows */
+TcsResult tcs_opt_packet_qdisc_bypass_get(TcsSocket socket, bool* is_bypassed)
+{
+    (void)socket;
+    (void)is_bypassed;
+    return TCS_ERROR_NOT_SUPPORTED;
+}
 
-// Type
-const TcsSocketType TCS_SOCKET_STREAM = {SOCK_STREAM};
-const TcsSocketType TCS_SOCKET_DGRAM = {SOCK_DGRAM};
-const TcsSocketType TCS_SOCKET_RAW = {SOCK_RAW};
+TcsResult tcs_opt_packet_fanout_join(TcsSocket socket, uint16_t group_id, TcsPacketFanoutMode mode)
+{
+    (void)socket;
+    (void)group_id;
+    (void)mode;
+    return TCS_ERROR_NOT_SUPPORTED;
+}
 
-// Recv flags
-const uint32_t TCS_MSG_PEEK = MSG_PEEK;
-const uint32_t TCS_MSG_OOB = MSG_OOB;
-const uint32_t TCS_MSG_WAITALL = 0x8; // Binary compatible when it does not exist
+TcsResult tcs_opt_reuse_port_steer_by_cpu(TcsSocket socket, size_t group_size)
+{
+    (void)socket;
+    (void)group_size;
+    return TCS_ERROR_NOT_SUPPORTED;
+}
 
-// Send flags
-const uint32_t TCS_MSG_SENDALL = 0x80000000;
+TcsResult tcs_opt_filter_attach(TcsSocket socket, const struct TcsFilter* filter)
+{
+    (void)socket;
+    (void)filter;
+    return TCS_ERROR_NOT_SUPPORTED;
+}
 
-// Backlog
-const int TCS_BACKLOG_MAX = SOMAXCONN;
+TcsResult tcs_opt_filter_detach(TcsSocket socket)
+{
+    (void)socket;
+    return TCS_ERROR_NOT_SUPPORTED;
+}
 
-// Option levels
-const int32_t TCS_SOL_SOCKET = SOL_SOCKET;
-const int32_t TCS_SOL_IP = IPPROTO_IP;
-const int32_t TCS_SOL_TCP = IPPROTO_TCP;
-const int32_t TCS_SOL_PACKET = -1; // No equivalent on Windows
+// tcs_opt_membership_add_str() is defined in tinycsocket_common.c
 
-// Socket options
-const int32_t TCS_SO_TYPE = SO_TYPE;
-const int32_t TCS_SO_BROADCAST = SO_BROADCAST;
-const int32_t TCS_SO_KEEPALIVE = SO_KEEPALIVE;
-const int32_t TCS_SO_LINGER = SO_LINGER;
-const int32_t TCS_SO_REUSEADDR = SO_REUSEADDR;
-const int32_t TCS_SO_REUSEPORT = -1;
-const int32_t TCS_SO_RCVBUF = SO_RCVBUF;
-const int32_t TCS_SO_RCVTIMEO = SO_RCVTIMEO;
-const int32_t TCS_SO_SNDBUF = SO_SNDBUF;
-const int32_t TCS_SO_OOBINLINE = SO_OOBINLINE;
-const int32_t TCS_SO_PRIORITY = -1;
+TcsResult tcs_opt_membership_add(TcsSocket socket, const struct TcsAddress* multicast_address)
+{
+    if (socket == TCS_SOCKET_INVALID)
+        return TCS_ERROR_INVALID_ARGUMENT;
 
-// IP options
-const int32_t TCS_TCP_NODELAY = TCP_NODELAY;
-const int32_t TCS_IP_MEMBERSHIP_ADD = IP_ADD_MEMBERSHIP;
-const int32_t TCS_IP_MEMBERSHIP_DROP = IP_DROP_MEMBERSHIP;
-const int32_t TCS_IP_MULTICAST_LOOP = IP_MULTICAST_LOOP;
+    if (multicast_address == NULL)
+        return TCS_ERROR_INVALID_ARGUMENT;
 
-// ######## Internal Helpers ########
+    SOCKADDR_STORAGE address_native_local;
+    memset(&address_native_local, 0, sizeof address_native_local);
+    int address_native_local_size = sizeof address_native_local;
+    if (getsockname((SOCKET)socket, (PSOCKADDR)&address_native_local, &address_native_local_size) != 0)
+        return wsaerror2retcode(WSAGetLastError());
 
-static TcsResult wsaerror2retcode(int wsa_error)
-{
-    switch (wsa_error)
-    {
-        case WSANOTINITIALISED:
-            return TCS_ERROR_LIBRARY_NOT_INITIALIZED;
-        case WSAEWOULDBLOCK:
-            return TCS_ERROR_WOULD_BLOCK;
-        case WSAETIMEDOUT:
-            return TCS_ERROR_TIMED_OUT;
-        case WSAECONNREFUSED:
-            return TCS_ERROR_CONNECTION_REFUSED;
-        case WSAECONNRESET:
-            return TCS_ERROR_CONNECTION_RESET;
-        case WSAENOTCONN:
-            return TCS_ERROR_NOT_CONNECTED;
-        case WSAESHUTDOWN:
-            return TCS_ERROR_SOCKET_CLOSED;
-        case WSAENETUNREACH:
-        case WSAEHOSTUNREACH:
-        case WSAENETDOWN:
-            return TCS_ERROR_NETWORK_UNREACHABLE;
-        case WSAEACCES:
-            return TCS_ERROR_PERMISSION_DENIED;
-        case WSAEINVAL:
-            return TCS_ERROR_INVALID_ARGUMENT;
-        case WSAEADDRINUSE:
-            return TCS_ERROR_ADDRESS_IN_USE;
-        case WSAENOPROTOOPT:
-            return TCS_ERROR_NOT_SUPPORTED;
-        case WSAEAFNOSUPPORT:
-        case WSAEPROTONOSUPPORT:
-        case WSAESOCKTNOSUPPORT:
-            return TCS_ERROR_NOT_SUPPORTED;
-        case WSAENOBUFS:
-        case WSA_NOT_ENOUGH_MEMORY:
-            return TCS_ERROR_MEMORY;
-        default:
-            return TCS_ERROR_UNKNOWN;
-    }
+    struct TcsAddress local_address = TCS_ADDRESS_NONE;
+    TcsResult sts = native2sockaddr((PSOCKADDR)&address_native_local, &local_address);
+    if (sts != TCS_SUCCESS)
+        return sts;
+
+    if (local_address.family.native != multicast_address->family.native)
+        return TCS_ERROR_INVALID_ARGUMENT;
+
+    return tcs_opt_membership_add_to(socket, &local_address, multicast_address);
 }
 
-static TcsResult socketstatus2retcode(int status)
-{
-    if (status == 0)
-    {
-        return TCS_SUCCESS;
-    }
-    else if (status == SOCKET_ERROR)
+TcsResult tcs_opt_membership_add_to(TcsSocket socket,
+                                    const struct TcsAddress* local_address,
+                                    const struct TcsAddress* multicast_address)
+{
+    if (socket == TCS_SOCKET_INVALID)
+        return TCS_ERROR_INVALID_ARGUMENT;
+    if (multicast_address == NULL)
+        return TCS_ERROR_INVALID_ARGUMENT;
+
+    if (multicast_address->family.native == TCS_FAMILY_IPV4.native)
     {
-        int error_code = WSAGetLastError();
-        return wsaerror2retcode(error_code);
+        struct ip_mreq imr;
+        memset(&imr, 0, sizeof imr);
+        imr.imr_multiaddr.s_addr = htonl(multicast_address->data.ipv4.address);
+        if (local_address != NULL)
+            imr.imr_interface.s_addr = htonl(local_address->data.ipv4.address);
+        return tcs_opt_set(socket, TCS_SOL_IP, TCS_IP_MEMBERSHIP_ADD, &imr, sizeof(imr));
     }
-    else
+    else if (multicast_address->family.native == TCS_FAMILY_IPV6.native)
     {
-        return TCS_ERROR_UNKNOWN;
+        struct ipv6_mreq imr6;
+        memset(&imr6, 0, sizeof imr6);
+        memcpy(&imr6.ipv6mr_multiaddr, multicast_address->data.ipv6.address.bytes, 16);
+        if (local_address != NULL)
+            imr6.ipv6mr_interface = (unsigned long)local_address->data.ipv6.scope_id;
+        return tcs_opt_set(socket, IPPROTO_IPV6, IPV6_JOIN_GROUP, &imr6, sizeof(imr6));
     }
+    return TCS_ERROR_NOT_SUPPORTED;
 }
 
-static TcsResult sockaddr2native(const struct TcsAddress* in_addr, PSOCKADDR out_addr, int* out_addrlen)
+// tcs_opt_membership_drop_str() is defined in tinycsocket_common.c
+
+TcsResult tcs_opt_membership_drop(TcsSocket socket, const struct TcsAddress* multicast_address)
 {
-    if (in_addr == NULL || out_addr == NULL)
+    if (socket == TCS_SOCKET_INVALID)
         return TCS_ERROR_INVALID_ARGUMENT;
 
-    if (in_addr->family.native == -1) // sentinel for unsupported families (e.g. TCS_FAMILY_PACKET on Windows)
-        return TCS_ERROR_NOT_SUPPORTED;
+    if (multicast_address == NULL)
+        return TCS_ERROR_INVALID_ARGUMENT;
 
-    if (in_addr->family.native == TCS_FAMILY_ANY.native)
-    {
-        return TCS_ERROR_NOT_SUPPORTED;
-    }
-    if (in_addr->family.native == TCS_FAMILY_IPV4.native)
-    {
-        PSOCKADDR_IN addr = (PSOCKADDR_IN)out_addr;
-        addr->sin_family = (ADDRESS_FAMILY)AF_INET;
-        addr->sin_port = htons((USHORT)in_addr->data.ipv4.port);
-        addr->sin_addr.S_un.S_addr = htonl((ULONG)in_addr->data.ipv4.address);
+    SOCKADDR_STORAGE address_native_local;
+    memset(&address_native_local, 0, sizeof address_native_local);
+    int address_native_local_size = sizeof address_native_local;
+    if (getsockname((SOCKET)socket, (PSOCKADDR)&address_native_local, &address_native_local_size) != 0)
+        return wsaerror2retcode(WSAGetLastError());
 
-        if (out_addrlen != NULL)
-            *out_addrlen = sizeof(SOCKADDR_IN);
+    struct TcsAddress local_address = TCS_ADDRESS_NONE;
+    TcsResult sts = native2sockaddr((PSOCKADDR)&address_native_local, &local_address);
+    if (sts != TCS_SUCCESS)
+        return sts;
 
-        return TCS_SUCCESS;
-    }
-    else if (in_addr->family.native == TCS_FAMILY_IPV6.native)
+    if (local_address.family.native != multicast_address->family.native)
+        return TCS_ERROR_INVALID_ARGUMENT;
+
+    return tcs_opt_membership_drop_from(socket, &local_address, multicast_address);
+}
+
+TcsResult tcs_opt_membership_drop_from(TcsSocket socket,
+                                       const struct TcsAddress* local_address,
+                                       const struct TcsAddress* multicast_address)
+{
+    if (socket == TCS_SOCKET_INVALID)
+        return TCS_ERROR_INVALID_ARGUMENT;
+    if (multicast_address == NULL)
+        return TCS_ERROR_INVALID_ARGUMENT;
+
+    if (multicast_address->family.native == TCS_FAMILY_IPV4.native)
     {
-        PSOCKADDR_IN6 addr = (PSOCKADDR_IN6)out_addr;
-        addr->sin6_family = (ADDRESS_FAMILY)AF_INET6;
-        addr->sin6_port = htons((USHORT)in_addr->data.ipv6.port);
-        memcpy(&addr->sin6_addr, in_addr->data.ipv6.address.bytes, 16);
-        addr->sin6_scope_id = (ULONG)in_addr->data.ipv6.scope_id;
-        if (out_addrlen != NULL)
-            *out_addrlen = sizeof(SOCKADDR_IN6);
-        return TCS_SUCCESS;
+        struct ip_mreq imr;
+        memset(&imr, 0, sizeof imr);
+        imr.imr_multiaddr.s_addr = htonl(multicast_address->data.ipv4.address);
+        if (local_address != NULL)
+            imr.imr_interface.s_addr = htonl(local_address->data.ipv4.address);
+        return tcs_opt_set(socket, TCS_SOL_IP, TCS_IP_MEMBERSHIP_DROP, &imr, sizeof(imr));
     }
-    else if (in_addr->family.native == TCS_FAMILY_PACKET.native)
+    else if (multicast_address->family.native == TCS_FAMILY_IPV6.native)
     {
-        return TCS_ERROR_NOT_SUPPORTED;
+        struct ipv6_mreq imr6;
+        memset(&imr6, 0, sizeof imr6);
+        memcpy(&imr6.ipv6mr_multiaddr, multicast_address->data.ipv6.address.bytes, 16);
+        if (local_address != NULL)
+            imr6.ipv6mr_interface = (unsigned long)local_address->data.ipv6.scope_id;
+        return tcs_opt_set(socket, IPPROTO_IPV6, IPV6_LEAVE_GROUP, &imr6, sizeof(imr6));
     }
     return TCS_ERROR_NOT_SUPPORTED;
 }
 
-static TcsResult native2sockaddr(const PSOCKADDR in_addr, struct TcsAddress* out_addr)
+TcsResult tcs_opt_multicast_interface_set(TcsSocket socket, const struct TcsAddress* local_address)
 {
-    if (in_addr == NULL || out_addr == NULL)
+    if (socket == TCS_SOCKET_INVALID || local_address == NULL)
         return TCS_ERROR_INVALID_ARGUMENT;
 
-    if (in_addr->sa_family == AF_INET)
-    {
-        PSOCKADDR_IN addr = (PSOCKADDR_IN)in_addr;
-        out_addr->family = TCS_FAMILY_IPV4;
-        out_addr->data.ipv4.port = ntohs((uint16_t)addr->sin_port);
-        out_addr->data.ipv4.address = ntohl((uint32_t)addr->sin_addr.S_un.S_addr);
-    }
-    else if (in_addr->sa_family == AF_INET6)
-    {
-        PSOCKADDR_IN6 addr = (PSOCKADDR_IN6)in_addr;
-        out_addr->family = TCS_FAMILY_IPV6;
-        out_addr->data.ipv6.port = ntohs((uint16_t)addr->sin6_port);
-        memcpy(out_addr->data.ipv6.address.bytes, &addr->sin6_addr, 16);
-        out_addr->data.ipv6.scope_id = (TcsInterfaceId)addr->sin6_scope_id;
-    }
-    else if (in_addr->sa_family == AF_UNSPEC)
+    if (local_address->family.native == TCS_FAMILY_IPV4.native)
     {
-        return TCS_ERROR_INVALID_ARGUMENT;
+        struct in_addr iface;
+        iface.s_addr = htonl(local_address->data.ipv4.address);
+        return tcs_opt_set(socket, TCS_SOL_IP, IP_MULTICAST_IF, &iface, sizeof(iface));
     }
-    else
+    else if (local_address->family.native == TCS_FAMILY_IPV6.native)
     {
-        return TCS_ERROR_NOT_IMPLEMENTED;
+        unsigned long idx = (unsigned long)local_address->data.ipv6.scope_id;
+        return tcs_opt_set(socket, IPPROTO_IPV6, IPV6_MULTICAST_IF, &idx, sizeof(idx));
     }
-
-    return TCS_SUCCESS;
+    return TCS_ERROR_INVALID_ARGUMENT;
 }
 
-TcsResult tcs_lib_init(void)
+TcsResult tcs_opt_multicast_loop_set(TcsSocket socket, bool do_loopback)
 {
-    WSADATA wsa_data;
-    if (WSAStartup(MAKEWORD(2, 2), &wsa_data) != 0)
-        return TCS_ERROR_SYSTEM;
-    return TCS_SUCCESS;
-}
+    if (socket == TCS_SOCKET_INVALID)
+        return TCS_ERROR_INVALID_ARGUMENT;
 
-TcsResult tcs_lib_cleanup(void)
-{
-    WSACleanup();
-    return TCS_SUCCESS;
+    DWORD val = do_loopback ? 1 : 0;
+    return tcs_opt_set(socket, TCS_SOL_IP, IP_MULTICAST_LOOP, &val, sizeof(val));
 }
 
-TcsResult tcs_socket(TcsSocket* out_socket, TcsFamily family, TcsSocketType type, TcsProtocol protocol)
+TcsResult tcs_opt_multicast_loop_get(TcsSocket socket, bool* is_loopback)
 {
-    if (out_socket == NULL || *out_socket != TCS_SOCKET_INVALID)
+    if (socket == TCS_SOCKET_INVALID || is_loopback == NULL)
         return TCS_ERROR_INVALID_ARGUMENT;
-    if (family.native == -1) // sentinel for unsupported families (e.g. TCS_FAMILY_PACKET on Windows)
-        return TCS_ERROR_NOT_SUPPORTED;
 
-    TcsSocket new_socket = socket(family.native, type.native, (int)protocol);
-
-    if (new_socket != INVALID_SOCKET)
-    {
-        *out_socket = new_socket;
-        return TCS_SUCCESS;
-    }
-    else
-    {
-        int error_code = WSAGetLastError();
-        return wsaerror2retcode(error_code);
-    }
+    DWORD val = 0;
+    size_t s = sizeof(val);
+    TcsResult sts = tcs_opt_get(socket, TCS_SOL_IP, IP_MULTICAST_LOOP, &val, &s);
+    *is_loopback = val;
+    return sts;
 }
 
-// tcs_socket_tcp() is defined in tinycsocket_common.c
-// tcs_socket_tcp_str() is defined in tinycsocket_common.c
-// tcs_socket_udp() is defined in tinycsocket_common.c
-// tcs_socket_udp_str() is defined in tinycsocket_common.c
-// tcs_socket_packet() is defined in tinycsocket_common.c
-// tcs_socket_packet_str() is defined in tinycsocket_common.c
+// ######## Address and Interface Utilities ########
 
-TcsResult tcs_close(TcsSocket* socket)
+// Retrieves the user-visible adapter name.
+// On Vista+ this is the FriendlyName field in IP_ADAPTER_ADDRESSES.
+// On pre-Vista the FriendlyName field does not exist, so we read the registry:
+//   HKLM\SYSTEM\CurrentControlSet\Control\Network\{4D36E972-E325-11CE-BFC1-08002BE10318}\<GUID>\Connection
+//   Value: "Name" (REG_SZ)
+// Falls back to Description (hardware name) if FriendlyName / registry is unavailable.
+static TcsResult adapter_get_friendly_name(PIP_ADAPTER_ADDRESSES adapter, char* out_name, int out_name_size)
 {
-    if (socket == NULL || *socket == TCS_SOCKET_INVALID)
+    if (adapter == NULL || out_name == NULL || out_name_size <= 0)
         return TCS_ERROR_INVALID_ARGUMENT;
+#if _WIN32_WINNT >= 0x0600
+    WideCharToMultiByte(CP_UTF8, 0, adapter->FriendlyName, -1, out_name, out_name_size, NULL, NULL);
+#else
+    const char prefix[] =
+        "SYSTEM\\CurrentControlSet\\Control\\Network\\"
+        "{4D36E972-E325-11CE-BFC1-08002BE10318}\\";
+    const char suffix[] = "\\Connection";
 
-    int close_status = closesocket(*socket);
-    if (close_status != SOCKET_ERROR)
-    {
-        *socket = TCS_SOCKET_INVALID;
-        return TCS_SUCCESS;
-    }
-    else
+    bool found = false;
+    size_t guid_len = strlen(adapter->AdapterName);
+    size_t key_len = sizeof(prefix) - 1 + guid_len + sizeof(suffix) - 1 + 1;
+
+    char key_path[256];
+    if (key_len <= sizeof key_path)
     {
-        return socketstatus2retcode(close_status);
+        memcpy(key_path, prefix, sizeof(prefix) - 1);
+        memcpy(key_path + sizeof(prefix) - 1, adapter->AdapterName, guid_len);
+        memcpy(key_path + sizeof(prefix) - 1 + guid_len, suffix, sizeof(suffix)); // includes null
+
+        HKEY hkey = NULL;
+        if (RegOpenKeyExA(HKEY_LOCAL_MACHINE, key_path, 0, KEY_READ, &hkey) == ERROR_SUCCESS)
+        {
+            DWORD type = 0;
+            DWORD data_size = (DWORD)out_name_size;
+            if (RegQueryValueExA(hkey, "Name", NULL, &type, (LPBYTE)out_name, &data_size) == ERROR_SUCCESS &&
+                type == REG_SZ && data_size > 1)
+            {
+                found = true;
+            }
+            RegCloseKey(hkey);
+        }
     }
-}
 
-// ######## Socket Operations ########
+    if (!found)
+        WideCharToMultiByte(CP_UTF8, 0, adapter->Description, -1, out_name, out_name_size, NULL, NULL);
+#endif
+    return TCS_SUCCESS;
+}
 
-TcsResult tcs_bind(TcsSocket socket, const struct TcsAddress* address)
+static TcsResult adapter_is_up(PIP_ADAPTER_ADDRESSES adapter, bool* out_is_up)
 {
-    if (socket == TCS_SOCKET_INVALID)
-        return TCS_ERROR_INVALID_ARGUMENT;
-    if (address == NULL)
+    if (adapter == NULL || out_is_up == NULL)
         return TCS_ERROR_INVALID_ARGUMENT;
-
-    SOCKADDR_STORAGE native_sockaddr;
-    memset(&native_sockaddr, 0, sizeof native_sockaddr);
-    int addrlen = 0;
-    TcsResult convert_addr_status = sockaddr2native(address, (PSOCKADDR)&native_sockaddr, &addrlen);
-    if (convert_addr_status != TCS_SUCCESS)
-        return convert_addr_status;
-    int bind_status = bind(socket, (PSOCKADDR)&native_sockaddr, addrlen);
-    return socketstatus2retcode(bind_status);
+#if _WIN32_WINNT >= 0x0600
+    *out_is_up = adapter->OperStatus == IfOperStatusUp;
+#else
+#ifndef MIB_IF_OPER_STATUS_OPERATIONAL
+// Not always exposed in all mingw-w64 versions
+#define MIB_IF_OPER_STATUS_OPERATIONAL 5
+#endif
+    MIB_IFROW ifrow;
+    memset(&ifrow, 0, sizeof ifrow);
+    ifrow.dwIndex = adapter->IfIndex;
+    if (GetIfEntry(&ifrow) != NO_ERROR)
+    {
+        *out_is_up = false;
+        return TCS_SUCCESS;
+    }
+    *out_is_up = ifrow.dwOperStatus >= MIB_IF_OPER_STATUS_OPERATIONAL;
+#endif
+    return TCS_SUCCESS;
 }
 
-TcsResult tcs_connect(TcsSocket socket, const struct TcsAddress* address)
+TcsResult tcs_interface_list(struct TcsInterface out_interfaces[], size_t interfaces_length, size_t* out_length)
 {
-    if (socket == TCS_SOCKET_INVALID)
+    if (out_interfaces == NULL && out_length == NULL)
         return TCS_ERROR_INVALID_ARGUMENT;
 
-    if (address == NULL)
+    if (out_interfaces == NULL && interfaces_length != 0)
         return TCS_ERROR_INVALID_ARGUMENT;
 
-    SOCKADDR_STORAGE native_sockaddr;
-    memset(&native_sockaddr, 0, sizeof native_sockaddr);
-    int addrlen = 0;
-    TcsResult convert_addr_status = sockaddr2native(address, (PSOCKADDR)&native_sockaddr, &addrlen);
-    if (convert_addr_status != TCS_SUCCESS)
-        return convert_addr_status;
-    int connect_status = connect(socket, (PSOCKADDR)&native_sockaddr, addrlen);
-    if (connect_status == SOCKET_ERROR)
+    if (out_length != NULL)
+        *out_length = 0;
+
+    const int MAX_TRIES = 5;
+    ULONG buffer_size = 15000; // From msdn recommendation
+    PIP_ADAPTER_ADDRESSES adapters = NULL;
+    ULONG adapter_sts = ERROR_NO_DATA;
+    for (int i = 0; i < MAX_TRIES; ++i)
     {
-        int error_code = WSAGetLastError();
-        // Windows uses WSAEWOULDBLOCK for non-blocking connect in progress,
-        // while POSIX uses EINPROGRESS. Normalize to TCS_IN_PROGRESS.
-        if (error_code == WSAEWOULDBLOCK)
-            return TCS_IN_PROGRESS;
-        return wsaerror2retcode(error_code);
+        adapters = (PIP_ADAPTER_ADDRESSES)tcs_lib_malloc(buffer_size);
+        if (adapters == NULL)
+            return TCS_ERROR_MEMORY;
+        adapter_sts = GetAdaptersAddresses(AF_UNSPEC,
+                                           GAA_FLAG_SKIP_DNS_SERVER | GAA_FLAG_SKIP_ANYCAST | GAA_FLAG_SKIP_MULTICAST,
+                                           NULL,
+                                           adapters,
+                                           &buffer_size);
+        if (adapter_sts == ERROR_BUFFER_OVERFLOW)
+        {
+            tcs_lib_free(adapters);
+            adapters = NULL;
+        }
+        else
+        {
+            break;
+        }
+    }
+    if (adapter_sts == ERROR_NO_DATA)
+    {
+        if (adapters != NULL)
+            tcs_lib_free(adapters);
+        return TCS_SUCCESS;
+    }
+    if (adapter_sts != NO_ERROR)
+    {
+        // Debug: log the actual Windows error code for diagnostics
+        fprintf(stderr, "GetAdaptersAddresses failed with error: %lu (0x%lX)\n", adapter_sts, adapter_sts);
+        if (adapters != NULL)
+            tcs_lib_free(adapters);
+        return TCS_ERROR_UNKNOWN;
     }
-    return TCS_SUCCESS;
-}
 
-// tcs_connect_str() is defined in tinycsocket_common.c
+    {
+        size_t i = 0;
+        for (PIP_ADAPTER_ADDRESSES iter = adapters; iter != NULL; iter = iter->Next)
+        {
+            bool is_up = false;
+            TcsResult up_sts = adapter_is_up(iter, &is_up);
+            if (up_sts != TCS_SUCCESS)
+            {
+                tcs_lib_free(adapters);
+                return TCS_ERROR_SYSTEM;
+            }
+            if (!is_up)
+                continue;
 
-TcsResult tcs_listen(TcsSocket socket, int backlog)
-{
-    if (socket == TCS_SOCKET_INVALID)
-        return TCS_ERROR_INVALID_ARGUMENT;
+            if (out_interfaces != NULL && i < interfaces_length)
+            {
+                memset(out_interfaces[i].name, '\0', TCS_CFG_INTERFACE_NAME_SIZE);
+                TcsResult name_sts =
+                    adapter_get_friendly_name(iter, out_interfaces[i].name, TCS_CFG_INTERFACE_NAME_SIZE - 1);
+                if (name_sts != TCS_SUCCESS)
+                {
+                    tcs_lib_free(adapters);
+                    return TCS_ERROR_SYSTEM;
+                }
+                out_interfaces[i].id = iter->IfIndex;
+            }
+            if (out_length != NULL)
+                (*out_length)++;
+            ++i;
+        }
+    }
 
-    int status = listen(socket, (int)backlog);
-    return socketstatus2retcode(status);
+    tcs_lib_free(adapters);
+    return TCS_SUCCESS;
 }
 
-TcsResult tcs_accept(TcsSocket listener, TcsSocket* out_socket, struct TcsAddress* out_address)
+// Used by tinycsocket_common.c, see the declarations there
+TcsResult tcs_os_address_resolve_native(const char* hostname,
+                                       TcsFamily address_family,
+                                       struct TcsAddress out_addresses[],
+                                       size_t addresses_length,
+                                       size_t* out_length)
 {
-    if (listener == TCS_SOCKET_INVALID || out_socket == NULL || *out_socket != TCS_SOCKET_INVALID)
-        return TCS_ERROR_INVALID_ARGUMENT;
+    ADDRINFOA native_hints;
+    memset(&native_hints, 0, sizeof native_hints);
+    native_hints.ai_family = address_family.native;
 
-    SOCKADDR_STORAGE native_sockaddr;
-    memset(&native_sockaddr, 0, sizeof native_sockaddr);
-    int addr_len = sizeof(native_sockaddr);
-    *out_socket = accept(listener, (PSOCKADDR)&native_sockaddr, &addr_len);
-    if (*out_socket != INVALID_SOCKET)
+    PADDRINFOA native_addrinfo_list = NULL;
+    int getaddrinfo_status = getaddrinfo(hostname, NULL, &native_hints, &native_addrinfo_list);
+    if (getaddrinfo_status != 0)
+        return TCS_ERROR_ADDRESS_LOOKUP_FAILED;
+
+    if (native_addrinfo_list == NULL)
+        return TCS_ERROR_UNKNOWN;
+
+    size_t i = 0;
+    if (out_addresses == NULL)
     {
-        if (out_address != NULL)
-        {
-            TcsResult convert_addr_status = native2sockaddr((PSOCKADDR)&native_sockaddr, out_address);
-            if (convert_addr_status != TCS_SUCCESS)
-                return convert_addr_status;
-        }
-        return TCS_SUCCESS;
+        for (PADDRINFOA iter = native_addrinfo_list; iter != NULL; iter = iter->ai_next)
+            i++;
     }
     else
     {
-        *out_socket = TCS_SOCKET_INVALID;
-        int error_code = WSAGetLastError();
-        return wsaerror2retcode(error_code);
+        for (PADDRINFOA iter = native_addrinfo_list; iter != NULL && i < addresses_length; iter = iter->ai_next)
+        {
+            if (iter->ai_addr == NULL)
+                continue;
+            TcsResult address_convert_status = native2sockaddr(iter->ai_addr, &out_addresses[i]);
+            if (address_convert_status != TCS_SUCCESS)
+                continue;
+            i++;
+        }
     }
-}
+    if (out_length != NULL)
+        *out_length = i;
 
-TcsResult tcs_shutdown(TcsSocket socket, TcsShutdownDirection direction)
-{
-    const int LUT[] = {SD_RECEIVE, SD_SEND, SD_BOTH};
+    freeaddrinfo(native_addrinfo_list);
 
-    if (socket == TCS_SOCKET_INVALID)
-        return TCS_ERROR_INVALID_ARGUMENT;
-    if (direction < 0 || direction > 2)
-        return TCS_ERROR_INVALID_ARGUMENT;
+    if (i == 0)
+        return TCS_ERROR_ADDRESS_LOOKUP_FAILED;
 
-    const int how = LUT[direction];
-    int shutdown_status = shutdown(socket, how);
-    return socketstatus2retcode(shutdown_status);
+    return TCS_SUCCESS;
 }
 
-// ######## Data Transfer ########
+// tcs_address_resolve() is defined in tinycsocket_common.c
+// tcs_address_cache_enable() is defined in tinycsocket_common.c
+// tcs_address_cache_disable() is defined in tinycsocket_common.c
+// tcs_address_cache_prefill() is defined in tinycsocket_common.c
+// tcs_address_cache_flush() is defined in tinycsocket_common.c
 
-TcsResult tcs_send(TcsSocket socket, const uint8_t* buffer, size_t buffer_size, uint32_t flags, size_t* sent_size)
+TcsResult tcs_address_list(unsigned int interface_id_filter,
+                           TcsFamily address_family_filter,
+                           struct TcsInterfaceAddress out_interface_addresses[],
+                           size_t interface_addresses_length,
+                           size_t* out_length)
 {
-    if (socket == TCS_SOCKET_INVALID)
+    if (out_interface_addresses == NULL && out_length == NULL)
         return TCS_ERROR_INVALID_ARGUMENT;
 
-    if (sent_size != NULL)
-        *sent_size = 0;
-
-    if (buffer == NULL || buffer_size == 0)
+    if (out_interface_addresses == NULL && interface_addresses_length != 0)
         return TCS_ERROR_INVALID_ARGUMENT;
 
-    // Send all
-    if (flags & TCS_MSG_SENDALL)
-    {
-        uint32_t new_flags = flags & ~TCS_MSG_SENDALL; // For recursive call
-        size_t left = buffer_size;
-        const uint8_t* iterator = buffer;
+    if (out_length != NULL)
+        *out_length = 0;
 
-        while (left > 0)
+    const int MAX_TRIES = 5;
+    ULONG buffer_size = 15000;
+    PIP_ADAPTER_ADDRESSES adapters = NULL;
+    ULONG adapter_sts = ERROR_NO_DATA;
+    for (int i = 0; i < MAX_TRIES; ++i)
+    {
+        adapters = (PIP_ADAPTER_ADDRESSES)tcs_lib_malloc(buffer_size);
+        if (adapters == NULL)
+            return TCS_ERROR_MEMORY;
+        adapter_sts = GetAdaptersAddresses(AF_UNSPEC,
+                                           GAA_FLAG_SKIP_DNS_SERVER | GAA_FLAG_SKIP_ANYCAST | GAA_FLAG_SKIP_MULTICAST,
+                                           NULL,
+                                           adapters,
+                                           &buffer_size);
+        if (adapter_sts == ERROR_BUFFER_OVERFLOW)
         {
-            size_t sent = 0;
-            TcsResult sts = tcs_send(socket, iterator, left, new_flags, &sent);
-            if (sent_size != NULL)
-                *sent_size += sent;
-            if (sts != TCS_SUCCESS)
-                return sts;
-            left -= sent;
-            iterator += sent;
+            tcs_lib_free(adapters);
+            adapters = NULL;
+        }
+        else
+        {
+            break;
         }
+    }
+    if (adapter_sts == ERROR_NO_DATA)
+    {
+        if (adapters != NULL)
+            tcs_lib_free(adapters);
         return TCS_SUCCESS;
     }
-    else // Send
+    if (adapter_sts != NO_ERROR)
     {
-        int send_status = send(socket, (const char*)buffer, (int)buffer_size, (int)flags);
-        if (send_status != SOCKET_ERROR)
+        if (adapters != NULL)
+            tcs_lib_free(adapters);
+        return TCS_ERROR_UNKNOWN;
+    }
+
+    size_t populated = 0;
+    for (PIP_ADAPTER_ADDRESSES iter = adapters; iter != NULL; iter = iter->Next)
+    {
+        bool is_up = false;
+        TcsResult up_sts = adapter_is_up(iter, &is_up);
+        if (up_sts != TCS_SUCCESS)
         {
-            if (sent_size != NULL)
-                *sent_size = (size_t)send_status;
-            return TCS_SUCCESS;
+            tcs_lib_free(adapters);
+            return TCS_ERROR_SYSTEM;
         }
-        else
+        if (!is_up)
+            continue;
+
+        if (interface_id_filter != 0 && iter->IfIndex != interface_id_filter)
+            continue;
+
+        for (PIP_ADAPTER_UNICAST_ADDRESS address_iter = iter->FirstUnicastAddress; address_iter != NULL;
+             address_iter = address_iter->Next)
         {
-            if (sent_size != NULL)
-                *sent_size = 0;
+            if (address_iter->Address.lpSockaddr == NULL)
+                continue;
+
+            if (address_family_filter.native != TCS_FAMILY_ANY.native)
+            {
+                if (address_family_filter.native == -1) /* unsupported sentinel */
+                    continue;
+                if (address_iter->Address.lpSockaddr->sa_family != address_family_filter.native)
+                    continue;
+            }
+
+            struct TcsAddress address = TCS_ADDRESS_NONE;
+            TcsResult convert_sts = native2sockaddr(address_iter->Address.lpSockaddr, &address);
+            if (convert_sts != TCS_SUCCESS)
+                continue; // skip entries we cannot represent (unknown family, malformed sockaddr, etc.)
+
+            if (out_interface_addresses != NULL && populated < interface_addresses_length)
+            {
+                memset(out_interface_addresses[populated].iface.name, '\0', TCS_CFG_INTERFACE_NAME_SIZE);
+                TcsResult name_sts = adapter_get_friendly_name(
+                    iter, out_interface_addresses[populated].iface.name, TCS_CFG_INTERFACE_NAME_SIZE - 1);
+                if (name_sts != TCS_SUCCESS)
+                {
+                    tcs_lib_free(adapters);
+                    return TCS_ERROR_SYSTEM;
+                }
+                out_interface_addresses[populated].iface.id = iter->IfIndex;
+                out_interface_addresses[populated].address = address;
+                populated++;
 
-            return socketstatus2retcode(send_status);
+                if (out_length != NULL)
+                    (*out_length)++;
+            }
+            else if (out_interface_addresses == NULL && out_length != NULL)
+            {
+                (*out_length)++;
+            }
         }
     }
+
+    tcs_lib_free(adapters);
+    return TCS_SUCCESS;
 }
 
-TcsResult tcs_send_to(TcsSocket socket,
-                      const uint8_t* buffer,
-                      size_t buffer_size,
-                      uint32_t flags,
-                      const struct TcsAddress* destination_address,
-                      size_t* sent_size)
+TcsResult tcs_address_socket_local(TcsSocket socket, struct TcsAddress* local_address)
 {
-    if (socket == TCS_SOCKET_INVALID)
-        return TCS_ERROR_INVALID_ARGUMENT;
-    if (buffer == NULL && buffer_size > 0)
-        return TCS_ERROR_INVALID_ARGUMENT;
-    if (destination_address == NULL)
+    if (socket == TCS_SOCKET_INVALID || local_address == NULL)
         return TCS_ERROR_INVALID_ARGUMENT;
 
-    if (flags & TCS_MSG_SENDALL)
-        return TCS_ERROR_NOT_IMPLEMENTED;
-
     SOCKADDR_STORAGE native_sockaddr;
     memset(&native_sockaddr, 0, sizeof native_sockaddr);
-    int addrlen = 0;
-    TcsResult convert_addr_status = sockaddr2native(destination_address, (PSOCKADDR)&native_sockaddr, &addrlen);
-    if (convert_addr_status != TCS_SUCCESS)
-        return convert_addr_status;
+    int addrlen = sizeof native_sockaddr;
+    if (getsockname((SOCKET)socket, (PSOCKADDR)&native_sockaddr, &addrlen) != 0)
+        return wsaerror2retcode(WSAGetLastError());
 
-    int sendto_status =
-        sendto(socket, (const char*)buffer, (int)buffer_size, (int)flags, (PSOCKADDR)&native_sockaddr, addrlen);
+    return native2sockaddr((PSOCKADDR)&native_sockaddr, local_address);
+}
 
-    if (sendto_status != SOCKET_ERROR)
-    {
-        if (sent_size != NULL)
-            *sent_size = (size_t)sendto_status;
-        return TCS_SUCCESS;
-    }
-    else
-    {
-        if (sent_size != NULL)
-            *sent_size = 0;
+TcsResult tcs_address_socket_remote(TcsSocket socket, struct TcsAddress* remote_address)
+{
+    if (socket == TCS_SOCKET_INVALID || remote_address == NULL)
+        return TCS_ERROR_INVALID_ARGUMENT;
 
-        return socketstatus2retcode(sendto_status);
-    }
+    SOCKADDR_STORAGE native_sockaddr;
+    memset(&native_sockaddr, 0, sizeof native_sockaddr);
+    int addrlen = sizeof native_sockaddr;
+    if (getpeername((SOCKET)socket, (PSOCKADDR)&native_sockaddr, &addrlen) != 0)
+        return wsaerror2retcode(WSAGetLastError());
+
+    return native2sockaddr((PSOCKADDR)&native_sockaddr, remote_address);
 }
 
-TcsResult tcs_sendv(TcsSocket socket, const struct TcsIoVec* iov, size_t iov_length, uint32_t flags, size_t* sent_size)
+TcsResult tcs_address_socket_family(TcsSocket socket, TcsFamily* out_family)
 {
-    if (socket == TCS_SOCKET_INVALID || iov == NULL || iov_length == 0)
+    if (socket == TCS_SOCKET_INVALID || out_family == NULL)
         return TCS_ERROR_INVALID_ARGUMENT;
 
-    if (flags & TCS_MSG_SENDALL)
-        return TCS_ERROR_NOT_IMPLEMENTED;
+    WSAPROTOCOL_INFOW info;
+    memset(&info, 0, sizeof info);
+    int info_size = sizeof info;
+    if (getsockopt((SOCKET)socket, SOL_SOCKET, SO_PROTOCOL_INFOW, (char*)&info, &info_size) != 0)
+        return wsaerror2retcode(WSAGetLastError());
 
-    WSABUF stack_buffers[TCS_CFG_SENDV_STACK_MAX];
-    WSABUF* native_buffers = stack_buffers;
-    WSABUF* heap_buffers = NULL;
+    out_family->native = (int)info.iAddressFamily;
+    return TCS_SUCCESS;
+}
 
-    if (iov_length > TCS_CFG_SENDV_STACK_MAX)
-    {
-        heap_buffers = (WSABUF*)malloc(sizeof(WSABUF) * iov_length);
-        if (heap_buffers == NULL)
-            return TCS_ERROR_MEMORY;
-        native_buffers = heap_buffers;
-    }
+// tcs_address_parse() is defined in tinycsocket_common.c
+// tcs_address_to_str() is defined in tinycsocket_common.c
+// tcs_address_is_equal() is defined in tinycsocket_common.c
+// tcs_address_is_any() is defined in tinycsocket_common.c
+// tcs_address_is_link_local() is defined in tinycsocket_common.c
+// tcs_address_is_loopback() is defined in tinycsocket_common.c
+// tcs_address_is_multicast() is defined in tinycsocket_common.c
+// tcs_address_is_broadcast() is defined in tinycsocket_common.c
 
-    for (size_t i = 0; i < iov_length; ++i)
-    {
-        if (iov[i].buffer == NULL && iov[i].buffer_size > 0)
-        {
-            free(heap_buffers);
-            return TCS_ERROR_INVALID_ARGUMENT;
-        }
-        // WSABUF.buf is non-const by Windows API design, but WSASend does not modify the data.
-#ifdef __GNUC__
-#pragma GCC diagnostic push
-#pragma GCC diagnostic ignored "-Wcast-qual"
 #endif
-        native_buffers[i].buf = (CHAR*)iov[i].buffer;
-#ifdef __GNUC__
-#pragma GCC diagnostic pop
-#endif
-        native_buffers[i].len = (ULONG)iov[i].buffer_size;
-    }
-
-    DWORD sent = 0;
-    int wsasend_status = WSASend(socket, native_buffers, (DWORD)iov_length, &sent, (DWORD)flags, NULL, NULL);
-
-    free(heap_buffers);
 
-    if (wsasend_status != SOCKET_ERROR)
-    {
-        if (sent_size != NULL)
-            *sent_size = (size_t)sent;
-        return TCS_SUCCESS;
-    }
-    else
-    {
-        if (sent_size != NULL)
-            *sent_size = 0;
-        return socketstatus2retcode(wsasend_status);
-    }
-}
+/**********************************/
+/****** tinycsocket_common.h ******/
+/**********************************/
+/*
+ * Copyright 2018 Markus Lindelöw
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files(the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef TINYCSOCKET_INTERNAL_H_
+#include "tinycsocket_internal.h"
+#endif
 
-TcsResult tcs_receive(TcsSocket socket, uint8_t* buffer, size_t buffer_size, uint32_t flags, size_t* received_size)
-{
-    if (socket == TCS_SOCKET_INVALID)
-        return TCS_ERROR_INVALID_ARGUMENT;
-    if (buffer == NULL && buffer_size > 0)
-        return TCS_ERROR_INVALID_ARGUMENT;
+// This file should never call OS dependent code. Do not include OS files of OS specific ifdefs
 
-#if WINVER <= 0x501
-    if (flags & TCS_MSG_WAITALL)
-    {
-        uint32_t new_flags = flags & ~TCS_MSG_WAITALL; // Unmask for recursive call
-        size_t received_so_far = 0;
-        while (received_so_far < buffer_size)
-        {
-            size_t received_now = 0;
-            uint8_t* cursor = buffer + received_so_far;
-            size_t left = buffer_size - received_so_far;
-            TcsResult sts = tcs_receive(socket, cursor, left, new_flags, &received_now);
-            if (sts != TCS_SUCCESS)
-            {
-                if (received_size != NULL)
-                    *received_size = received_so_far;
-                return sts;
-            }
-            received_so_far += received_now;
-        }
-        if (received_size != NULL)
-            *received_size = received_so_far;
-        return TCS_SUCCESS;
-    }
+#ifndef TINYDATASTRUCTURES_H_
+#include "tinydatastructures.h"
 #endif
 
-    int recv_status = recv(socket, (char*)buffer, (int)buffer_size, (int)flags);
-
-    if (recv_status == 0)
-    {
-        if (received_size != NULL)
-            *received_size = 0;
-        TcsSocketType sock_type = {0};
-        if (tcs_opt_type_get(socket, &sock_type) == TCS_SUCCESS && sock_type.native == TCS_SOCKET_STREAM.native)
-            return TCS_SHUTDOWN;
-        return TCS_SUCCESS;
-    }
-    else if (recv_status != SOCKET_ERROR)
-    {
-        if (received_size != NULL)
-            *received_size = (size_t)recv_status;
-        return TCS_SUCCESS;
-    }
-    else
-    {
-        if (received_size != NULL)
-            *received_size = 0;
+#ifdef DO_WRAP
+#include "dbg_wrap.h"
+#endif
 
-        return socketstatus2retcode(recv_status);
-    }
-}
+#include <stdbool.h>
+#include <stdio.h>  //sprintf, fopen for resolv.conf and hosts
+#include <stdlib.h> // malloc, realloc, free for the default allocator
+#include <string.h> // memset
 
-TcsResult tcs_receive_from(TcsSocket socket,
-                           uint8_t* buffer,
-                           size_t buffer_size,
-                           uint32_t flags,
-                           struct TcsAddress* source_address,
-                           size_t* received_size)
-{
-    if (socket == TCS_SOCKET_INVALID)
-        return TCS_ERROR_INVALID_ARGUMENT;
-    if (buffer == NULL && buffer_size > 0)
-        return TCS_ERROR_INVALID_ARGUMENT;
-    if (received_size != NULL)
-        *received_size = 0;
+const char* const TCS_LICENSE_TXT =
+    "Copyright 2018 Markus Lindelöw\n"
+    "\n"
+    "Permission is hereby granted, free of charge, to any person obtaining a copy "
+    "of this software and associated documentation files(the \"Software\"), to deal "
+    "in the Software without restriction, including without limitation the rights "
+    "to use, copy, modify, merge, publish, distribute, sublicense, and / or sell "
+    "copies of the Software, and to permit persons to whom the Software is "
+    "furnished to do so, subject to the following conditions:\n"
+    "\n"
+    "The above copyright notice and this permission notice shall be included in all "
+    "copies or substantial portions of the Software.\n"
+    "\n"
+    "THE SOFTWARE IS PROVIDED \"AS IS\", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR "
+    "IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, "
+    "FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE "
+    "AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER "
+    "LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, "
+    "OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE "
+    "SOFTWARE.";
 
-    SOCKADDR_STORAGE native_sockaddr;
-    memset(&native_sockaddr, 0, sizeof native_sockaddr);
-    int addrlen = sizeof(native_sockaddr);
+// ######## OS Primitives ########
 
-    int recvfrom_status =
-        recvfrom(socket, (char*)buffer, (int)buffer_size, (int)flags, (PSOCKADDR)&native_sockaddr, &addrlen);
+// Thin wrappers around OS facilities for the code in this file, defined in OS specific files. Not public API.
 
-    if (recvfrom_status == 0)
-    {
-        if (received_size != NULL)
-            *received_size = 0;
-        TcsSocketType sock_type = {0};
-        if (tcs_opt_type_get(socket, &sock_type) == TCS_SUCCESS && sock_type.native == TCS_SOCKET_STREAM.native)
-            return TCS_SHUTDOWN;
-        return TCS_SUCCESS;
-    }
-    else if (recvfrom_status != SOCKET_ERROR)
-    {
-        if (received_size != NULL)
-            *received_size = (size_t)recvfrom_status;
+size_t tcs_os_steering_cpu_count(void); // CPUs a SO_REUSEPORT group can steer between, 0 if not supported
 
-        if (source_address != NULL)
-        {
-            TcsResult convert_address_status = native2sockaddr((PSOCKADDR)&native_sockaddr, source_address);
-            return convert_address_status;
-        }
+struct TcsOsMutex; // Non recursive lock between threads
+TcsResult tcs_os_mutex_create(struct TcsOsMutex** out_mutex);
+void tcs_os_mutex_destroy(struct TcsOsMutex** mutex);
+void tcs_os_mutex_lock(struct TcsOsMutex* mutex);
+void tcs_os_mutex_unlock(struct TcsOsMutex* mutex);
 
-        return TCS_SUCCESS;
-    }
-    else
-    {
-        if (received_size != NULL)
-            *received_size = 0;
+// One process wide lock for library state, usable without any setup
+void tcs_os_global_lock(void);
+void tcs_os_global_unlock(void);
 
-        return socketstatus2retcode(recvfrom_status);
-    }
-}
+// The system resolver, tcs_address_resolve() without parsing and caching
+TcsResult tcs_os_address_resolve_native(const char* hostname,
+                                        TcsFamily address_family,
+                                        struct TcsAddress out_addresses[],
+                                        size_t addresses_length,
+                                        size_t* out_length);
 
-// tcs_receive_line() is defined in tinycsocket_common.c
-// tcs_receive_netstring() is defined in tinycsocket_common.c
+struct TcsOsThread;
+TcsResult tcs_os_thread_create(struct TcsOsThread** out_thread, void (*function)(void*), void* arg);
+void tcs_os_thread_join(struct TcsOsThread** thread); // Waits for the thread to return and frees it
 
-// ######## Socket Polling ########
+struct TcsOsSemaphore; // Counting, starts at zero
+TcsResult tcs_os_semaphore_create(struct TcsOsSemaphore** out_semaphore);
+void tcs_os_semaphore_destroy(struct TcsOsSemaphore** semaphore);
+void tcs_os_semaphore_post(struct TcsOsSemaphore* semaphore);
+void tcs_os_semaphore_wait(struct TcsOsSemaphore* semaphore);
 
-TcsResult tcs_poll_create(struct TcsPoll** out_poll)
-{
-    if (out_poll == NULL || *out_poll != NULL)
-        return TCS_ERROR_INVALID_ARGUMENT;
+struct TcsOsWakeup; // Can be waited on with TcsPoll, readable while set. Only set when cleared and vice versa.
+TcsResult tcs_os_wakeup_create(struct TcsOsWakeup** out_wakeup);
+void tcs_os_wakeup_destroy(struct TcsOsWakeup** wakeup);
+TcsSocket tcs_os_wakeup_socket(const struct TcsOsWakeup* wakeup);
+void tcs_os_wakeup_set(struct TcsOsWakeup* wakeup, bool is_set);
 
-    *out_poll = (struct TcsPoll*)malloc(sizeof(struct TcsPoll));
-    if (*out_poll == NULL)
-        return TCS_ERROR_MEMORY;
-    memset(*out_poll, 0, sizeof(struct TcsPoll));
-    int sts_read_array = tds_ulist_soc_create(&(*out_poll)->read_sockets);
-    int sts_write_array = tds_ulist_soc_create(&(*out_poll)->write_sockets);
-    int sts_error_array = tds_ulist_soc_create(&(*out_poll)->error_sockets);
-    int sts_user_data = tds_map_socket_user_create(&(*out_poll)->user_data);
+// Waits for non-blocking connects without allocating. Sockets that are TCS_SOCKET_INVALID are skipped. Sets
+// TCS_SUCCESS, an error or TCS_IN_PROGRESS per socket, at most TCS_CFG_CONNECT_CANDIDATES_MAX sockets.
+TcsResult tcs_os_connect_wait(const TcsSocket sockets[], size_t sockets_length, TcsResult out_results[], int timeout_ms);
 
-    if (sts_read_array != 0 || sts_write_array != 0 || sts_error_array != 0 || sts_user_data != 0)
-    {
-        tcs_poll_destroy(out_poll);
-        return TCS_ERROR_MEMORY;
-    }
-    return TCS_SUCCESS;
+// Fills with bytes from the OS entropy source, TCS_ERROR_NOT_SUPPORTED if there is none
+TcsResult tcs_os_random(uint8_t* out_bytes, size_t length);
+
+// ######## Library Management ########
+
+// tcs_lib_init() is defined in OS specific files
+// tcs_lib_cleanup() is defined in OS specific files
+// tcs_time_monotonic_ms() is defined in OS specific files
+
+static void* tcs_default_alloc(size_t size, void* context)
+{
+    (void)context;
+    return malloc(size);
 }
 
-TcsResult tcs_poll_destroy(struct TcsPoll** poll)
+static void* tcs_default_realloc(void* ptr, size_t size, void* context)
 {
-    if (poll == NULL || *poll == NULL)
-        return TCS_ERROR_INVALID_ARGUMENT;
+    (void)context;
+    return realloc(ptr, size);
+}
 
-    tds_ulist_soc_destroy(&(*poll)->read_sockets);
-    tds_ulist_soc_destroy(&(*poll)->write_sockets);
-    tds_ulist_soc_destroy(&(*poll)->error_sockets);
-    tds_map_socket_user_destroy(&(*poll)->user_data);
+static void tcs_default_free(void* ptr, void* context)
+{
+    (void)context;
+    free(ptr);
+}
 
-    free(*poll);
-    *poll = NULL;
+static TcsAllocFn tcs_alloc_fn = tcs_default_alloc;
+static TcsReallocFn tcs_realloc_fn = tcs_default_realloc;
+static TcsFreeFn tcs_free_fn = tcs_default_free;
+static void* tcs_alloc_context = NULL;
+
+TcsResult tcs_lib_set_allocator(TcsAllocFn alloc_fn, TcsReallocFn realloc_fn, TcsFreeFn free_fn, void* context)
+{
+    if (alloc_fn == NULL && realloc_fn == NULL && free_fn == NULL)
+    {
+        tcs_alloc_fn = tcs_default_alloc;
+        tcs_realloc_fn = tcs_default_realloc;
+        tcs_free_fn = tcs_default_free;
+        tcs_alloc_context = NULL;
+        return TCS_SUCCESS;
+    }
+    if (alloc_fn == NULL || realloc_fn == NULL || free_fn == NULL)
+        return TCS_ERROR_INVALID_ARGUMENT;
 
+    tcs_alloc_fn = alloc_fn;
+    tcs_realloc_fn = realloc_fn;
+    tcs_free_fn = free_fn;
+    tcs_alloc_context = context;
     return TCS_SUCCESS;
 }
 
-TcsResult tcs_poll_add(struct TcsPoll* poll, TcsSocket socket, void* user_data, uint32_t flags)
+void* tcs_lib_malloc(size_t size)
 {
-    if (poll == NULL || socket == TCS_SOCKET_INVALID)
-        return TCS_ERROR_INVALID_ARGUMENT;
+    return tcs_alloc_fn(size, tcs_alloc_context);
+}
 
-    int map_sts = tds_map_socket_user_add(&poll->user_data, socket, user_data);
-    if (map_sts != 0)
-        return TCS_ERROR_MEMORY;
+void* tcs_lib_realloc(void* ptr, size_t size)
+{
+    return tcs_realloc_fn(ptr, size, tcs_alloc_context);
+}
 
-    // Always monitor for errors
-    {
-        int sts = tds_ulist_soc_add(&poll->error_sockets, &socket, 1);
-        if (sts != 0)
-        {
-            tds_map_socket_user_remove(&poll->user_data, poll->user_data.count - 1);
-            return TCS_ERROR_MEMORY;
-        }
-    }
-    if (flags & TCS_POLL_READ)
-    {
-        int sts = tds_ulist_soc_add(&poll->read_sockets, &socket, 1);
-        if (sts != 0)
-        {
-            tds_ulist_soc_remove(&poll->error_sockets, poll->error_sockets.count - 1, 1);
-            tds_map_socket_user_remove(&poll->user_data, poll->user_data.count - 1);
-            return TCS_ERROR_MEMORY;
-        }
-    }
-    if (flags & TCS_POLL_WRITE)
+void tcs_lib_free(void* ptr)
+{
+    if (ptr != NULL)
+        tcs_free_fn(ptr, tcs_alloc_context);
+}
+
+const char* tcs_strerror(TcsResult result)
+{
+    switch (result)
     {
-        int sts = tds_ulist_soc_add(&poll->write_sockets, &socket, 1);
-        if (sts != 0)
-        {
-            if (flags & TCS_POLL_READ)
-                tds_ulist_soc_remove(&poll->read_sockets, poll->read_sockets.count - 1, 1);
-            tds_ulist_soc_remove(&poll->error_sockets, poll->error_sockets.count - 1, 1);
-            tds_map_socket_user_remove(&poll->user_data, poll->user_data.count - 1);
-            return TCS_ERROR_MEMORY;
-        }
+        case TCS_SUCCESS:
+            return "Success";
+        case TCS_AGAIN:
+            return "Try again";
+        case TCS_IN_PROGRESS:
+            return "Operation in progress";
+        case TCS_SHUTDOWN:
+            return "Socket shutdown";
+        case TCS_ERROR_UNKNOWN:
+            return "Unknown error";
+        case TCS_ERROR_MEMORY:
+            return "Out of memory";
+        case TCS_ERROR_INVALID_ARGUMENT:
+            return "Invalid argument";
+        case TCS_ERROR_SYSTEM:
+            return "System error";
+        case TCS_ERROR_PERMISSION_DENIED:
+            return "Permission denied";
+        case TCS_ERROR_NOT_IMPLEMENTED:
+            return "Not implemented";
+        case TCS_ERROR_NOT_SUPPORTED:
+            return "Not supported";
+        case TCS_ERROR_ADDRESS_LOOKUP_FAILED:
+            return "Address lookup failed";
+        case TCS_ERROR_CONNECTION_REFUSED:
+            return "Connection refused";
+        case TCS_ERROR_NOT_CONNECTED:
+            return "Not connected";
+        case TCS_ERROR_SOCKET_CLOSED:
+            return "Socket closed";
+        case TCS_ERROR_WOULD_BLOCK:
+            return "Operation would block";
+        case TCS_ERROR_TIMED_OUT:
+            return "Timed out";
+        case TCS_ERROR_TEMPORARY_FAILURE:
+            return "Temporary failure";
+        case TCS_ERROR_NETWORK_UNREACHABLE:
+            return "Network unreachable";
+        case TCS_ERROR_CONNECTION_RESET:
+            return "Connection reset";
+        case TCS_ERROR_ADDRESS_IN_USE:
+            return "Address in use";
+        case TCS_ERROR_LIBRARY_NOT_INITIALIZED:
+            return "Library not initialized";
+        case TCS_ERROR_ILL_FORMED_MESSAGE:
+            return "Ill-formed message";
     }
-    return TCS_SUCCESS;
+    return "Unknown TcsResult";
 }
 
-TcsResult tcs_poll_modify(struct TcsPoll* poll, TcsSocket socket, uint32_t flags)
+// ######## Socket Creation ########
+
+// tcs_socket() is defined in OS specific files
+// tcs_socket_with_flags() is defined in OS specific files
+
+TcsResult tcs_socket_tcp(TcsSocket* out_socket,
+                         const struct TcsAddress* local_address,
+                         const struct TcsAddress* remote_address,
+                         int timeout_ms)
 {
-    if (poll == NULL)
+    if (out_socket == NULL || *out_socket != TCS_SOCKET_INVALID)
         return TCS_ERROR_INVALID_ARGUMENT;
-    if (socket == TCS_SOCKET_INVALID)
+    if (local_address == NULL && remote_address == NULL)
+        return TCS_ERROR_INVALID_ARGUMENT;
+    if (local_address != NULL && remote_address != NULL &&
+        local_address->family.native != remote_address->family.native)
+        return TCS_ERROR_INVALID_ARGUMENT;
+    if (timeout_ms < 0 && timeout_ms != TCS_WAIT_INF)
         return TCS_ERROR_INVALID_ARGUMENT;
 
-    bool found = false;
-    for (size_t i = 0; i < poll->user_data.count; ++i)
+    TcsFamily family = local_address != NULL ? local_address->family : remote_address->family;
+
+    // Created non-blocking so tcs_connect_timeout() does not switch modes, blocking mode is set once when connected
+    bool is_timed = remote_address != NULL && timeout_ms != TCS_WAIT_INF;
+    uint32_t flags = TCS_SOCKET_FLAG_CLOEXEC | (is_timed ? TCS_SOCKET_FLAG_NONBLOCKING : TCS_FLAG_NONE);
+    TcsResult res = tcs_socket_with_flags(out_socket, family, TCS_SOCKET_STREAM, TCS_PROTOCOL_IP_TCP, flags);
+    if (res != TCS_SUCCESS)
+        return res;
+
+    if (local_address != NULL)
     {
-        if (poll->user_data.keys[i] == socket)
+        res = tcs_opt_reuse_address_set(*out_socket, true);
+        if (res != TCS_SUCCESS)
         {
-            found = true;
-            break;
+            tcs_close(out_socket);
+            return res;
+        }
+        res = tcs_bind(*out_socket, local_address);
+        if (res != TCS_SUCCESS)
+        {
+            tcs_close(out_socket);
+            return res;
         }
     }
-    if (!found)
-        return TCS_ERROR_INVALID_ARGUMENT;
 
-    struct TdsUList_soc* const lists[2] = {&poll->read_sockets, &poll->write_sockets};
-    const bool should_exist[2] = {(flags & TCS_POLL_READ) != 0, (flags & TCS_POLL_WRITE) != 0};
-    for (int k = 0; k < 2; ++k)
+    if (remote_address != NULL)
     {
-        struct TdsUList_soc* list = lists[k];
-        bool already_in_list = false;
-        for (size_t i = 0; i < list->count; ++i)
+        res = tcs_connect_timeout(*out_socket, remote_address, timeout_ms);
+        if (res == TCS_SUCCESS && is_timed)
+            res = tcs_opt_nonblocking_set(*out_socket, false);
+        if (res != TCS_SUCCESS)
         {
-            if (list->data[i] == socket)
-            {
-                if (!should_exist[k])
-                    tds_ulist_soc_remove(list, i, 1);
-                already_in_list = true;
-                break;
-            }
+            tcs_close(out_socket);
+            return res;
         }
-        if (!already_in_list && should_exist[k])
-            tds_ulist_soc_add(list, &socket, 1);
     }
 
     return TCS_SUCCESS;
 }
 
-TcsResult tcs_poll_remove(struct TcsPoll* poll, TcsSocket socket)
+// Splits "host:port" and "[host]:port". More than one colon without brackets is an IPv6 address without port.
+static TcsResult host_port_split(const char* str, char* out_host, size_t host_size, uint16_t* out_port)
 {
-    if (poll == NULL)
-        return TCS_ERROR_INVALID_ARGUMENT;
-    if (socket == TCS_SOCKET_INVALID)
-        return TCS_ERROR_INVALID_ARGUMENT;
-
-    bool found = false;
-    for (size_t i = 0; i < poll->read_sockets.count; ++i)
-    {
-        if (poll->read_sockets.data[i] == socket)
-        {
-            tds_ulist_soc_remove(&poll->read_sockets, i, 1);
-            found = true;
-            break;
-        }
-    }
-    for (size_t i = 0; i < poll->write_sockets.count; ++i)
+    const char* host_begin = str;
+    const char* host_end = NULL;
+    const char* port_str = NULL;
+    if (str[0] == '[')
     {
-        if (poll->write_sockets.data[i] == socket)
-        {
-            tds_ulist_soc_remove(&poll->write_sockets, i, 1);
-            found = true;
-            break;
-        }
+        host_begin = str + 1;
+        host_end = strchr(host_begin, ']');
+        if (host_end == NULL)
+            return TCS_ERROR_INVALID_ARGUMENT;
+        if (host_end[1] == ':')
+            port_str = host_end + 2;
+        else if (host_end[1] != '\0')
+            return TCS_ERROR_INVALID_ARGUMENT;
     }
-    for (size_t i = 0; i < poll->error_sockets.count; ++i)
+    else
     {
-        if (poll->error_sockets.data[i] == socket)
+        const char* colon = strchr(str, ':');
+        if (colon != NULL && strchr(colon + 1, ':') == NULL)
         {
-            tds_ulist_soc_remove(&poll->error_sockets, i, 1);
-            found = true;
-            break;
+            host_end = colon;
+            port_str = colon + 1;
+        }
+        else
+        {
+            host_end = str + strlen(str);
         }
     }
-    for (size_t i = 0; i < poll->user_data.count; ++i)
+
+    *out_port = 0;
+    if (port_str != NULL)
     {
-        if (poll->user_data.keys[i] == socket)
+        uint32_t port = 0;
+        if (*port_str == '\0')
+            return TCS_ERROR_INVALID_ARGUMENT;
+        for (const char* c = port_str; *c != '\0'; ++c)
         {
-            tds_map_socket_user_remove(&poll->user_data, i);
-            found = true;
-            break;
+            if (*c < '0' || *c > '9')
+                return TCS_ERROR_INVALID_ARGUMENT;
+            port = port * 10 + (uint32_t)(*c - '0');
+            if (port > 0xFFFF)
+                return TCS_ERROR_INVALID_ARGUMENT;
         }
+        *out_port = (uint16_t)port;
     }
 
-    if (!found)
+    size_t host_length = (size_t)(host_end - host_begin);
+    if (host_length == 0 || host_length >= host_size)
         return TCS_ERROR_INVALID_ARGUMENT;
-
+    memcpy(out_host, host_begin, host_length);
+    out_host[host_length] = '\0';
     return TCS_SUCCESS;
 }
 
-TcsResult tcs_poll_wait(struct TcsPoll* poll,
-                        struct TcsPollEvent* out_events,
-                        size_t events_length,
-                        size_t* out_events_length,
-                        int timeout_ms)
+static void address_port_set(struct TcsAddress* address, uint16_t port)
 {
-    if (poll == NULL)
-        return TCS_ERROR_INVALID_ARGUMENT;
-    if (out_events == NULL || out_events_length == NULL)
+    if (address->family.native == TCS_FAMILY_IPV4.native)
+        address->data.ipv4.port = port;
+    else if (address->family.native == TCS_FAMILY_IPV6.native)
+        address->data.ipv6.port = port;
+}
+
+TcsResult tcs_socket_tcp_str(TcsSocket* out_socket,
+                             const char* local_address,
+                             const char* remote_address,
+                             int timeout_ms)
+{
+    if (out_socket == NULL || *out_socket != TCS_SOCKET_INVALID)
         return TCS_ERROR_INVALID_ARGUMENT;
-    if (timeout_ms < 0 && timeout_ms != TCS_WAIT_INF)
+    if (local_address == NULL && remote_address == NULL)
         return TCS_ERROR_INVALID_ARGUMENT;
 
-    // Todo: add more modern implementation. Maybe dispatch att init?
-    // SELECT IMPLEMENTATION
+    struct TcsAddress local_addr = TCS_ADDRESS_NONE;
+    TcsFamily family = TCS_FAMILY_ANY;
 
-    // Copy fds, use auto storage if possible, otherwise use dynamic memory
+    if (local_address != NULL)
+    {
+        size_t count = 0;
+        TcsResult res = tcs_address_resolve(local_address, TCS_FAMILY_ANY, &local_addr, 1, &count);
+        if (res != TCS_SUCCESS)
+            return res;
+        if (count == 0)
+            return TCS_ERROR_ADDRESS_LOOKUP_FAILED;
+        family = local_addr.family;
+    }
 
-    // Allocate so that we can access fd_array out of nominal bounds
-    // We need this hack to be able to use dynamic memory for select
-    const size_t data_offset = offsetof(struct tcs_fd_set, fd_array);
+    if (remote_address == NULL)
+        return tcs_socket_tcp(out_socket, &local_addr, NULL, timeout_ms);
 
-    struct fd_set rfds_stack;
-    struct fd_set wfds_stack;
-    struct fd_set efds_stack;
+    // Resolve the host without the port to get every candidate, also for host names
+    char host[256];
+    uint16_t port = 0;
+    TcsResult res = host_port_split(remote_address, host, sizeof(host), &port);
+    if (res != TCS_SUCCESS)
+        return res;
 
-    struct tcs_fd_set* rfds_heap = NULL;
-    struct tcs_fd_set* wfds_heap = NULL;
-    struct tcs_fd_set* efds_heap = NULL;
+    struct TcsAddress candidates[TCS_CFG_CONNECT_CANDIDATES_MAX];
+    size_t count = 0;
+    res = tcs_address_resolve(host, family, candidates, TCS_CFG_CONNECT_CANDIDATES_MAX, &count);
+    if (res != TCS_SUCCESS)
+        return res;
+    if (count == 0)
+        return TCS_ERROR_ADDRESS_LOOKUP_FAILED;
+    for (size_t i = 0; i < count; ++i)
+        address_port_set(&candidates[i], port);
 
-    struct tcs_fd_set* rfds_cpy = NULL;
-    struct tcs_fd_set* wfds_cpy = NULL;
-    struct tcs_fd_set* efds_cpy = NULL;
+    return tcs_socket_tcp_any(out_socket, local_address != NULL ? &local_addr : NULL, candidates, count, timeout_ms);
+}
 
-    if (poll->read_sockets.count <= FD_SETSIZE)
-    {
-        FD_ZERO(&rfds_stack);
-        rfds_cpy = (struct tcs_fd_set*)&rfds_stack;
-    }
-    else
+// RFC 8305 section 4: alternate between the families, starting with the family of the first address
+static void interleave_families(struct TcsAddress addresses[], size_t count)
+{
+    struct TcsAddress first_family[TCS_CFG_CONNECT_CANDIDATES_MAX];
+    struct TcsAddress other_family[TCS_CFG_CONNECT_CANDIDATES_MAX];
+    size_t first_count = 0;
+    size_t other_count = 0;
+    for (size_t i = 0; i < count; ++i)
     {
-        rfds_heap = (struct tcs_fd_set*)malloc(data_offset + sizeof(SOCKET) * poll->read_sockets.count);
-        if (rfds_heap == NULL)
-            return TCS_ERROR_MEMORY;
-        rfds_cpy = rfds_heap;
+        if (addresses[i].family.native == addresses[0].family.native)
+            first_family[first_count++] = addresses[i];
+        else
+            other_family[other_count++] = addresses[i];
     }
 
-    if (poll->write_sockets.count <= FD_SETSIZE)
-    {
-        FD_ZERO(&wfds_stack);
-        wfds_cpy = (struct tcs_fd_set*)&wfds_stack;
-    }
-    else
+    size_t n = 0;
+    for (size_t i = 0; n < count; ++i)
     {
-        wfds_heap = (struct tcs_fd_set*)malloc(data_offset + sizeof(SOCKET) * poll->write_sockets.count);
-        if (wfds_heap == NULL)
-        {
-            free(rfds_heap);
-            return TCS_ERROR_MEMORY;
-        }
-        wfds_cpy = wfds_heap;
+        if (i < first_count)
+            addresses[n++] = first_family[i];
+        if (i < other_count)
+            addresses[n++] = other_family[i];
     }
+}
 
-    if (poll->error_sockets.count <= FD_SETSIZE)
-    {
-        FD_ZERO(&efds_stack);
-        efds_cpy = (struct tcs_fd_set*)&efds_stack;
-    }
-    else
+static TcsResult connect_attempt_start(TcsSocket* out_socket,
+                                       const struct TcsAddress* local_address,
+                                       const struct TcsAddress* remote_address)
+{
+    TcsResult res = tcs_socket_with_flags(out_socket,
+                                          remote_address->family,
+                                          TCS_SOCKET_STREAM,
+                                          TCS_PROTOCOL_IP_TCP,
+                                          TCS_SOCKET_FLAG_NONBLOCKING | TCS_SOCKET_FLAG_CLOEXEC);
+    if (res != TCS_SUCCESS)
+        return res;
+    if (local_address != NULL)
     {
-        efds_heap = (struct tcs_fd_set*)malloc(data_offset + sizeof(SOCKET) * poll->error_sockets.count);
-        if (efds_heap == NULL)
-        {
-            free(rfds_heap);
-            free(wfds_heap);
-            return TCS_ERROR_MEMORY;
-        }
-        efds_cpy = efds_heap;
+        res = tcs_opt_reuse_address_set(*out_socket, true);
+        if (res == TCS_SUCCESS)
+            res = tcs_bind(*out_socket, local_address);
     }
-    rfds_cpy->fd_count = (u_int)poll->read_sockets.count;
-    wfds_cpy->fd_count = (u_int)poll->write_sockets.count;
-    efds_cpy->fd_count = (u_int)poll->error_sockets.count;
-
-    memcpy(rfds_cpy->fd_array, poll->read_sockets.data, sizeof(SOCKET) * poll->read_sockets.count);
-    memcpy(wfds_cpy->fd_array, poll->write_sockets.data, sizeof(SOCKET) * poll->write_sockets.count);
-    memcpy(efds_cpy->fd_array, poll->error_sockets.data, sizeof(SOCKET) * poll->error_sockets.count);
+    if (res == TCS_SUCCESS)
+        res = tcs_connect(*out_socket, remote_address);
+    if (res != TCS_SUCCESS && res != TCS_IN_PROGRESS)
+        tcs_close(out_socket);
+    return res;
+}
 
-    memset(out_events, 0, sizeof(struct TcsPollEvent) * events_length);
-    *out_events_length = 0;
+TcsResult tcs_socket_tcp_any(TcsSocket* out_socket,
+                             const struct TcsAddress* local_address,
+                             const struct TcsAddress remote_addresses[],
+                             size_t remote_addresses_length,
+                             int timeout_ms)
+{
+    if (out_socket == NULL || *out_socket != TCS_SOCKET_INVALID)
+        return TCS_ERROR_INVALID_ARGUMENT;
+    if (remote_addresses == NULL || remote_addresses_length == 0)
+        return TCS_ERROR_INVALID_ARGUMENT;
+    if (timeout_ms < 0 && timeout_ms != TCS_WAIT_INF)
+        return TCS_ERROR_INVALID_ARGUMENT;
 
-    // Run select
-    struct timeval* t_ptr = NULL;
-    struct timeval t = {0, 0};
-    if (timeout_ms != TCS_WAIT_INF)
+    struct TcsAddress candidates[TCS_CFG_CONNECT_CANDIDATES_MAX];
+    size_t count = 0;
+    for (size_t i = 0; i < remote_addresses_length && count < TCS_CFG_CONNECT_CANDIDATES_MAX; ++i)
     {
-        t.tv_sec = (long)(timeout_ms / 1000);
-        t.tv_usec = (long)(timeout_ms % 1000) * 1000;
-        t_ptr = &t;
+        if (local_address == NULL || local_address->family.native == remote_addresses[i].family.native)
+            candidates[count++] = remote_addresses[i];
     }
-    int no = select(IGNORE, (fd_set*)rfds_cpy, (fd_set*)wfds_cpy, (fd_set*)efds_cpy, t_ptr);
-
-    size_t events_added = 0;
+    if (count == 0)
+        return TCS_ERROR_INVALID_ARGUMENT;
+    if (count == 1)
+        return tcs_socket_tcp(out_socket, local_address, &candidates[0], timeout_ms); // Nothing to race
+    interleave_families(candidates, count);
 
-    if (no > 0)
-    {
-        for (u_int n = 0; n < rfds_cpy->fd_count && events_added < events_length; ++n)
+    TcsSocket attempts[TCS_CFG_CONNECT_CANDIDATES_MAX];
+    TcsResult results[TCS_CFG_CONNECT_CANDIDATES_MAX];
+    for (size_t i = 0; i < count; ++i)
+        attempts[i] = TCS_SOCKET_INVALID;
+
+    int64_t now = tcs_time_monotonic_ms();
+    const int64_t deadline = timeout_ms == TCS_WAIT_INF ? INT64_MAX : now + timeout_ms;
+    int64_t next_attempt_time = now;
+    size_t next = 0;
+    size_t pending = 0;
+    TcsSocket* winner = NULL;
+    TcsResult last_error = TCS_ERROR_CONNECTION_REFUSED;
+    TcsResult res = TCS_SUCCESS;
+    while (winner == NULL)
+    {
+        now = tcs_time_monotonic_ms();
+        if (next < count && (pending == 0 || now >= next_attempt_time))
         {
-            out_events[events_added].socket = rfds_cpy->fd_array[n];
-            out_events[events_added].can_read = true;
-            for (size_t i = 0; i < poll->user_data.count; ++i)
+            TcsSocket* attempt = &attempts[next];
+            res = connect_attempt_start(attempt, local_address, &candidates[next]);
+            next++;
+            if (res == TCS_SUCCESS)
             {
-                if (out_events[events_added].socket == poll->user_data.keys[i])
-                {
-                    out_events[events_added].user_data = poll->user_data.values[i];
-                    break;
-                }
+                winner = attempt;
             }
-            events_added++;
-        }
-        for (u_int n = 0; n < wfds_cpy->fd_count && events_added < events_length; ++n)
-        {
-            // Check already added events
-            size_t new_n = events_added;
-            for (size_t m = 0; m < events_added; ++m)
+            else if (res == TCS_IN_PROGRESS)
             {
-                if (out_events[m].socket == wfds_cpy->fd_array[n])
-                {
-                    new_n = m;
-                    break;
-                }
+                pending++;
+                next_attempt_time = now + TCS_CFG_CONNECT_ATTEMPT_DELAY_MS;
             }
-            out_events[new_n].can_write = true;
-            // Check for new events
-            if (events_added == new_n)
+            else
             {
-                out_events[new_n].socket = wfds_cpy->fd_array[n];
-
-                for (size_t i = 0; i < poll->user_data.count; ++i)
-                {
-                    if (out_events[new_n].socket == poll->user_data.keys[i])
-                    {
-                        out_events[new_n].user_data = poll->user_data.values[i];
-                        break;
-                    }
-                }
-                events_added++;
+                last_error = res;
             }
+            continue;
         }
-        for (u_int n = 0; n < efds_cpy->fd_count && events_added < events_length; ++n)
+        if (pending == 0)
+            break; // Every candidate failed
+        if (now >= deadline)
         {
-            // Check already added events
-            size_t new_n = events_added;
-            for (size_t m = 0; m < events_added; ++m)
+            last_error = TCS_ERROR_TIMED_OUT;
+            break;
+        }
+
+        int64_t wake_time = next < count && next_attempt_time < deadline ? next_attempt_time : deadline;
+        int wait_ms = wake_time == INT64_MAX ? TCS_WAIT_INF : (int)(wake_time - now);
+        res = tcs_os_connect_wait(attempts, next, results, wait_ms);
+        if (res != TCS_SUCCESS && res != TCS_ERROR_TIMED_OUT)
+        {
+            last_error = res;
+            break;
+        }
+        for (size_t i = 0; i < next && res == TCS_SUCCESS && winner == NULL; ++i)
+        {
+            if (attempts[i] == TCS_SOCKET_INVALID || results[i] == TCS_IN_PROGRESS)
+                continue;
+            if (results[i] == TCS_SUCCESS)
             {
-                if (out_events[m].socket == efds_cpy->fd_array[n])
-                {
-                    new_n = m;
-                    break;
-                }
+                winner = &attempts[i];
+                continue;
             }
-            // Get the actual socket error
-            int so_error = 0;
-            int so_error_size = sizeof(so_error);
-            if (getsockopt((SOCKET)efds_cpy->fd_array[n], SOL_SOCKET, SO_ERROR, (char*)&so_error, &so_error_size) != 0)
-                out_events[new_n].error = wsaerror2retcode(WSAGetLastError());
-            else
-                out_events[new_n].error = so_error != 0 ? wsaerror2retcode(so_error) : TCS_ERROR_UNKNOWN;
-            if (events_added == new_n)
-            {
-                out_events[new_n].socket = efds_cpy->fd_array[n];
+            // A failed attempt starts the next one at once instead of waiting for the delay
+            tcs_close(&attempts[i]);
+            pending--;
+            last_error = results[i];
+            next_attempt_time = now;
+        }
+    }
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        if (&attempts[i] != winner && attempts[i] != TCS_SOCKET_INVALID)
+            tcs_close(&attempts[i]);
+    }
+    if (winner == NULL)
+        return last_error;
+
+    res = tcs_opt_nonblocking_set(*winner, false);
+    if (res != TCS_SUCCESS)
+    {
+        tcs_close(winner);
+        return res;
+    }
+    *out_socket = *winner;
+    return TCS_SUCCESS;
+}
+
+TcsResult tcs_socket_udp(TcsSocket* out_socket,
+                         const struct TcsAddress* local_address,
+                         const struct TcsAddress* remote_address)
+{
+    if (out_socket == NULL || *out_socket != TCS_SOCKET_INVALID)
+        return TCS_ERROR_INVALID_ARGUMENT;
+    if (local_address == NULL && remote_address == NULL)
+        return TCS_ERROR_INVALID_ARGUMENT;
+    if (local_address != NULL && remote_address != NULL &&
+        local_address->family.native != remote_address->family.native)
+        return TCS_ERROR_INVALID_ARGUMENT;
+
+    TcsFamily family = local_address != NULL ? local_address->family : remote_address->family;
+
+    TcsResult res = tcs_socket(out_socket, family, TCS_SOCKET_DGRAM, TCS_PROTOCOL_IP_UDP);
+    if (res != TCS_SUCCESS)
+        return res;
+
+    if (local_address != NULL)
+    {
+        res = tcs_opt_reuse_address_set(*out_socket, true);
+        if (res != TCS_SUCCESS)
+        {
+            tcs_close(out_socket);
+            return res;
+        }
+        res = tcs_bind(*out_socket, local_address);
+        if (res != TCS_SUCCESS)
+        {
+            tcs_close(out_socket);
+            return res;
+        }
+    }
 
-                for (size_t i = 0; i < poll->user_data.count; ++i)
-                {
-                    if (out_events[new_n].socket == poll->user_data.keys[i])
-                    {
-                        out_events[new_n].user_data = poll->user_data.values[i];
-                        break;
-                    }
-                }
+    if (remote_address != NULL)
+    {
+        bool is_multicast = tcs_address_is_multicast(remote_address);
 
-                events_added++;
+        if (is_multicast)
+        {
+            res = tcs_opt_membership_add(*out_socket, remote_address);
+            if (res != TCS_SUCCESS)
+            {
+                tcs_close(out_socket);
+                return res;
+            }
+        }
+
+        if (!is_multicast || local_address == NULL)
+        {
+            res = tcs_connect(*out_socket, remote_address);
+            if (res != TCS_SUCCESS)
+            {
+                tcs_close(out_socket);
+                return res;
             }
         }
     }
 
-    *out_events_length = events_added;
+    return TCS_SUCCESS;
+}
 
-    // Clean up
-    if (rfds_heap != NULL)
-        free(rfds_heap);
-    if (wfds_heap != NULL)
-        free(wfds_heap);
-    if (efds_heap != NULL)
-        free(efds_heap);
+TcsResult tcs_socket_udp_str(TcsSocket* out_socket, const char* local_address, const char* remote_address)
+{
+    if (out_socket == NULL || *out_socket != TCS_SOCKET_INVALID)
+        return TCS_ERROR_INVALID_ARGUMENT;
+    if (local_address == NULL && remote_address == NULL)
+        return TCS_ERROR_INVALID_ARGUMENT;
 
-    if (no == 0)
+    struct TcsAddress local_addr = TCS_ADDRESS_NONE;
+    struct TcsAddress remote_addr = TCS_ADDRESS_NONE;
+    TcsFamily family = TCS_FAMILY_ANY;
+
+    if (local_address != NULL)
     {
-        return TCS_ERROR_TIMED_OUT;
+        size_t count = 0;
+        TcsResult res = tcs_address_resolve(local_address, TCS_FAMILY_ANY, &local_addr, 1, &count);
+        if (res != TCS_SUCCESS)
+            return res;
+        if (count == 0)
+            return TCS_ERROR_ADDRESS_LOOKUP_FAILED;
+        family = local_addr.family;
     }
-    if (no == SOCKET_ERROR)
+
+    if (remote_address != NULL)
     {
-        int error_code = WSAGetLastError();
-        return wsaerror2retcode(error_code);
+        size_t count = 0;
+        TcsResult res = tcs_address_resolve(remote_address, family, &remote_addr, 1, &count);
+        if (res != TCS_SUCCESS)
+            return res;
+        if (count == 0)
+            return TCS_ERROR_ADDRESS_LOOKUP_FAILED;
     }
 
-    return TCS_SUCCESS;
+    return tcs_socket_udp(
+        out_socket, local_address != NULL ? &local_addr : NULL, remote_address != NULL ? &remote_addr : NULL);
 }
 
-// ######## Socket Options ########
-
-TcsResult tcs_opt_set(TcsSocket socket,
-                      int32_t level,
-                      int32_t option_name,
-                      const void* option_value,
-                      size_t option_size)
+TcsResult tcs_socket_packet(TcsSocket* out_socket, const struct TcsAddress* bind_address, TcsSocketType type)
 {
-    if (socket == TCS_SOCKET_INVALID)
+    if (out_socket == NULL || *out_socket != TCS_SOCKET_INVALID)
+        return TCS_ERROR_INVALID_ARGUMENT;
+    if (bind_address == NULL)
+        return TCS_ERROR_INVALID_ARGUMENT;
+    if (bind_address->family.native != TCS_FAMILY_PACKET.native)
+        return TCS_ERROR_INVALID_ARGUMENT;
+    if (type.native != TCS_SOCKET_RAW.native && type.native != TCS_SOCKET_DGRAM.native)
         return TCS_ERROR_INVALID_ARGUMENT;
 
-    if (option_name == -1)
-        return TCS_ERROR_NOT_IMPLEMENTED;
+    TcsResult res = tcs_socket(out_socket, TCS_FAMILY_PACKET, type, bind_address->data.packet.protocol);
+    if (res != TCS_SUCCESS)
+        return res;
 
-    int sockopt_status = setsockopt(socket, (int)level, (int)option_name, (const char*)option_value, (int)option_size);
-    return socketstatus2retcode(sockopt_status);
+    res = tcs_bind(*out_socket, bind_address);
+    if (res != TCS_SUCCESS)
+    {
+        tcs_close(out_socket);
+        return res;
+    }
+
+    return TCS_SUCCESS;
 }
 
-TcsResult tcs_opt_get(TcsSocket socket, int32_t level, int32_t option_name, void* out_option_value, size_t* option_size)
+TcsResult tcs_socket_packet_str(TcsSocket* out_socket,
+                                const char* interface_name,
+                                uint16_t protocol,
+                                TcsSocketType type)
 {
-    if (socket == TCS_SOCKET_INVALID || out_option_value == NULL || option_size == NULL)
+    if (out_socket == NULL || *out_socket != TCS_SOCKET_INVALID)
+        return TCS_ERROR_INVALID_ARGUMENT;
+    if (interface_name == NULL)
         return TCS_ERROR_INVALID_ARGUMENT;
 
-    if (option_name == -1)
-        return TCS_ERROR_NOT_IMPLEMENTED;
+    struct TcsInterface stack_buf[16];
+    struct TcsInterface* interfaces = stack_buf;
+    size_t count = 0;
 
-    int optlen = (int)*option_size;
-    int sockopt_status = getsockopt(socket, (int)level, (int)option_name, (char*)out_option_value, &optlen);
-    if (sockopt_status == 0)
-        *option_size = (size_t)optlen;
-    return socketstatus2retcode(sockopt_status);
+    TcsResult res = tcs_interface_list(stack_buf, 16, &count);
+    if (res != TCS_SUCCESS)
+        return res;
+
+    size_t search_count = count < 16 ? count : 16;
+    for (size_t i = 0; i < search_count; ++i)
+    {
+        if (strcmp(stack_buf[i].name, interface_name) == 0)
+        {
+            struct TcsAddress bind_address = TCS_ADDRESS_NONE;
+            bind_address.family = TCS_FAMILY_PACKET;
+            bind_address.data.packet.interface_id = stack_buf[i].id;
+            bind_address.data.packet.protocol = protocol;
+            return tcs_socket_packet(out_socket, &bind_address, type);
+        }
+    }
+
+    if (count > 16)
+    {
+        interfaces = (struct TcsInterface*)tcs_lib_malloc(count * sizeof(struct TcsInterface));
+        if (interfaces == NULL)
+            return TCS_ERROR_MEMORY;
+        res = tcs_interface_list(interfaces, count, &count);
+        if (res != TCS_SUCCESS)
+        {
+            tcs_lib_free(interfaces);
+            return res;
+        }
+    }
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        if (strcmp(interfaces[i].name, interface_name) == 0)
+        {
+            struct TcsAddress bind_address = TCS_ADDRESS_NONE;
+            bind_address.family = TCS_FAMILY_PACKET;
+            bind_address.data.packet.interface_id = interfaces[i].id;
+            bind_address.data.packet.protocol = protocol;
+            if (interfaces != stack_buf)
+                tcs_lib_free(interfaces);
+            return tcs_socket_packet(out_socket, &bind_address, type);
+        }
+    }
+
+    if (interfaces != stack_buf)
+        tcs_lib_free(interfaces);
+    return TCS_ERROR_INVALID_ARGUMENT;
 }
 
-// tcs_opt_broadcast_set() is defined in tinycsocket_common.c
-// tcs_opt_broadcast_get() is defined in tinycsocket_common.c
-// tcs_opt_keep_alive_set() is defined in tinycsocket_common.c
-// tcs_opt_keep_alive_get() is defined in tinycsocket_common.c
-TcsResult tcs_opt_reuse_address_set(TcsSocket socket, bool do_allow_reuse_address)
+// tcs_close() is defined in OS specific files
+
+TcsResult tcs_socket_per_cpu(TcsSocket out_sockets[],
+                             size_t sockets_length,
+                             TcsSocketType type,
+                             const struct TcsAddress* local_address,
+                             size_t* out_sockets_count)
 {
-    if (socket == TCS_SOCKET_INVALID)
+    if (out_sockets == NULL || sockets_length == 0 || local_address == NULL || out_sockets_count == NULL)
+        return TCS_ERROR_INVALID_ARGUMENT;
+    if (type.native != TCS_SOCKET_STREAM.native && type.native != TCS_SOCKET_DGRAM.native)
         return TCS_ERROR_INVALID_ARGUMENT;
+    for (size_t i = 0; i < sockets_length; ++i)
+    {
+        if (out_sockets[i] != TCS_SOCKET_INVALID)
+            return TCS_ERROR_INVALID_ARGUMENT;
+    }
+    *out_sockets_count = 0;
 
-    int b = do_allow_reuse_address ? 1 : 0;
-    TcsResult sts = tcs_opt_set(socket, TCS_SOL_SOCKET, TCS_SO_REUSEADDR, &b, sizeof(b));
-    if (sts != TCS_SUCCESS)
-        return sts;
+    size_t cpu_count = tcs_os_steering_cpu_count();
+    if (cpu_count == 0)
+        return TCS_ERROR_NOT_SUPPORTED;
+    size_t count = cpu_count < sockets_length ? cpu_count : sockets_length;
 
-#if _WIN32_WINNT >= 0x0502
-    TcsSocketType sock_type = {0};
-    if (tcs_opt_type_get(socket, &sock_type) == TCS_SUCCESS && sock_type.native == TCS_SOCKET_STREAM.native)
-        tcs_opt_set(socket, TCS_SOL_SOCKET, SO_EXCLUSIVEADDRUSE, &b, sizeof(b));
-#endif
+    bool is_stream = type.native == TCS_SOCKET_STREAM.native;
+    TcsProtocol protocol = is_stream ? TCS_PROTOCOL_IP_TCP : TCS_PROTOCOL_IP_UDP;
+    struct TcsAddress bind_address = *local_address;
+    TcsResult sts = TCS_SUCCESS;
+    for (size_t i = 0; i < count && sts == TCS_SUCCESS; ++i)
+    {
+        // The group index is the join order, so each socket must be bound (and listening) before the next
+        sts = tcs_socket(&out_sockets[i], local_address->family, type, protocol);
+        if (sts == TCS_SUCCESS)
+            sts = tcs_opt_reuse_port_set(out_sockets[i], true);
+        if (sts == TCS_SUCCESS)
+            sts = tcs_bind(out_sockets[i], &bind_address);
+        if (sts == TCS_SUCCESS && i == 0)
+            sts = tcs_address_socket_local(out_sockets[i], &bind_address); // Resolve port 0 once
+        if (sts == TCS_SUCCESS && is_stream)
+            sts = tcs_listen(out_sockets[i], TCS_BACKLOG_MAX);
+    }
+    if (sts == TCS_SUCCESS)
+        sts = tcs_opt_reuse_port_steer_by_cpu(out_sockets[0], count);
 
+    if (sts != TCS_SUCCESS)
+    {
+        for (size_t i = 0; i < count; ++i)
+        {
+            if (out_sockets[i] != TCS_SOCKET_INVALID)
+                tcs_close(&out_sockets[i]);
+        }
+        return sts;
+    }
+    *out_sockets_count = count;
     return TCS_SUCCESS;
 }
 
-TcsResult tcs_opt_reuse_address_get(TcsSocket socket, bool* is_reuse_address_allowed)
+// ######## Socket Operations ########
+
+// tcs_bind() is defined in OS specific files
+// tcs_connect() is defined in OS specific files
+// tcs_connect_timeout() is defined in OS specific files
+
+TcsResult tcs_connect_str(TcsSocket socket, const char* remote_address, uint16_t port)
 {
-    if (socket == TCS_SOCKET_INVALID || is_reuse_address_allowed == NULL)
+    if (socket == TCS_SOCKET_INVALID)
         return TCS_ERROR_INVALID_ARGUMENT;
-    int b = 0;
-    size_t s = sizeof(b);
-    TcsResult sts = tcs_opt_get(socket, TCS_SOL_SOCKET, TCS_SO_REUSEADDR, &b, &s);
-    *is_reuse_address_allowed = b;
-    return sts;
-}
 
-TcsResult tcs_opt_reuse_port_set(TcsSocket socket, bool do_allow_reuse_port)
-{
-    (void)socket;
-    (void)do_allow_reuse_port;
-    return TCS_ERROR_NOT_SUPPORTED;
-}
+    if (remote_address == NULL)
+        return TCS_ERROR_INVALID_ARGUMENT;
 
-TcsResult tcs_opt_reuse_port_get(TcsSocket socket, bool* is_reuse_port_allowed)
-{
-    (void)socket;
-    (void)is_reuse_port_allowed;
-    return TCS_ERROR_NOT_SUPPORTED;
-}
+    TcsFamily socket_family = TCS_FAMILY_ANY;
+    TcsResult res = tcs_address_socket_family(socket, &socket_family);
+    if (res != TCS_SUCCESS)
+        return res;
 
-// tcs_opt_send_buffer_size_set() is defined in tinycsocket_common.c
-// tcs_opt_send_buffer_size_get() is defined in tinycsocket_common.c
-// tcs_opt_receive_buffer_size_set() is defined in tinycsocket_common.c
-// tcs_opt_receive_buffer_size_get() is defined in tinycsocket_common.c
+    if (socket_family.native != TCS_FAMILY_IPV4.native && socket_family.native != TCS_FAMILY_IPV6.native)
+        return TCS_ERROR_NOT_IMPLEMENTED;
 
-TcsResult tcs_opt_receive_timeout_set(TcsSocket socket, int timeout_ms)
-{
-    if (socket == TCS_SOCKET_INVALID || timeout_ms < 0)
+    struct TcsAddress found_addresses;
+    size_t no_of_found_addresses = 0;
+
+    res = tcs_address_resolve(remote_address, socket_family, &found_addresses, 1, &no_of_found_addresses);
+    if (res != TCS_SUCCESS)
+        return res;
+
+    if (no_of_found_addresses == 0)
+        return TCS_ERROR_ADDRESS_LOOKUP_FAILED;
+
+    if (socket_family.native == TCS_FAMILY_IPV4.native)
+    {
+        if (found_addresses.data.ipv4.port == 0)
+            found_addresses.data.ipv4.port = port;
+        else if (port != 0)
+            return TCS_ERROR_INVALID_ARGUMENT;
+    }
+    else if (socket_family.native == TCS_FAMILY_IPV6.native)
+    {
+        if (found_addresses.data.ipv6.port == 0)
+            found_addresses.data.ipv6.port = port;
+        else if (port != 0)
+            return TCS_ERROR_INVALID_ARGUMENT;
+    }
+    else if (socket_family.native == TCS_FAMILY_ANY.native)
+    {
+        /* nothing to do */
+    }
+    else
+    {
         return TCS_ERROR_INVALID_ARGUMENT;
-
-    return tcs_opt_set(socket, TCS_SOL_SOCKET, TCS_SO_RCVTIMEO, &timeout_ms, sizeof(timeout_ms));
+    }
+    return tcs_connect(socket, &found_addresses);
 }
 
-TcsResult tcs_opt_receive_timeout_get(TcsSocket socket, int* timeout_ms)
-{
-    if (socket == TCS_SOCKET_INVALID || timeout_ms == NULL)
-        return TCS_ERROR_INVALID_ARGUMENT;
+// tcs_listen() is defined in OS specific files
+// tcs_accept() is defined in OS specific files
+// tcs_accept_many() is defined in OS specific files
+// tcs_shutdown() is defined in OS specific files
 
-    DWORD t = 0;
-    size_t t_size = sizeof(t);
-    TcsResult sts = tcs_opt_get(socket, TCS_SOL_SOCKET, TCS_SO_RCVTIMEO, &t, &t_size);
+// ######## Data Transfer ########
 
-    if (sts == TCS_SUCCESS)
-    {
-        *timeout_ms = (int)t;
-    }
-    return sts;
-}
+// tcs_send() is defined in OS specific files
+// tcs_send_to() is defined in OS specific files
+// tcs_sendv() is defined in OS specific files
 
-TcsResult tcs_opt_linger_set(TcsSocket socket, bool do_linger, int timeout_seconds)
+TcsResult tcs_send_netstring(TcsSocket socket, const uint8_t* buffer, size_t buffer_size)
 {
     if (socket == TCS_SOCKET_INVALID)
         return TCS_ERROR_INVALID_ARGUMENT;
 
-    struct linger l = {(u_short)do_linger, (u_short)timeout_seconds};
-    return tcs_opt_set(socket, TCS_SOL_SOCKET, TCS_SO_LINGER, &l, sizeof(l));
-}
-
-TcsResult tcs_opt_linger_get(TcsSocket socket, bool* do_linger, int* timeout_seconds)
-{
-    if (socket == TCS_SOCKET_INVALID || (do_linger == NULL && timeout_seconds == NULL))
+    if (buffer == NULL || buffer_size == 0)
         return TCS_ERROR_INVALID_ARGUMENT;
 
-    struct linger l = {0, 0};
-    size_t l_size = sizeof(l);
-    TcsResult sts = tcs_opt_get(socket, TCS_SOL_SOCKET, TCS_SO_LINGER, &l, &l_size);
-    if (sts == TCS_SUCCESS)
-    {
-        if (do_linger)
-            *do_linger = l.l_onoff;
-        if (timeout_seconds)
-            *timeout_seconds = l.l_linger;
-    }
+#if SIZE_MAX > 0xffffffffffffffffULL
+    // buffer_size bigger than 64 bits? (size_t can be bigger on some systems)
+    if (buffer_size > 0xffffffffffffffffULL)
+        return TCS_ERROR_INVALID_ARGUMENT;
+#endif
 
-    return sts;
-}
+    int header_length = 0;
+    char netstring_header[21];
+    memset(netstring_header, 0, sizeof netstring_header);
 
-// tcs_opt_ip_no_delay_set() is defined in tinycsocket_common.c
-// tcs_opt_ip_no_delay_get() is defined in tinycsocket_common.c
-// tcs_opt_out_of_band_inline_set() is defined in tinycsocket_common.c
-// tcs_opt_out_of_band_inline_get() is defined in tinycsocket_common.c
-// tcs_opt_priority_set() is defined in tinycsocket_common.c
-// tcs_opt_priority_get() is defined in tinycsocket_common.c
+    // %zu is not supported by all compilers, therefor we cast it to llu
+    header_length = snprintf(netstring_header, 21, "%llu:", (unsigned long long)buffer_size);
 
-TcsResult tcs_opt_nonblocking_set(TcsSocket socket, bool do_non_blocking)
-{
-    if (socket == TCS_SOCKET_INVALID)
+    if (header_length < 0)
         return TCS_ERROR_INVALID_ARGUMENT;
 
-    u_long mode = do_non_blocking ? 1 : 0;
-    int sts = ioctlsocket((SOCKET)socket, (long)FIONBIO, &mode);
-    return socketstatus2retcode(sts);
-}
+    TcsResult sts = TCS_SUCCESS;
+    sts = tcs_send(socket, (uint8_t*)netstring_header, (size_t)header_length, TCS_MSG_SENDALL, NULL);
+    if (sts != TCS_SUCCESS)
+        return sts;
 
-TcsResult tcs_opt_nonblocking_get(TcsSocket socket, bool* is_non_blocking)
-{
-    (void)socket;
-    (void)is_non_blocking;
-    // Win32 does not provide an API to query the non-blocking state of a socket
-    return TCS_ERROR_NOT_SUPPORTED;
+    sts = tcs_send(socket, buffer, buffer_size, TCS_MSG_SENDALL, NULL);
+    if (sts != TCS_SUCCESS)
+        return sts;
+
+    sts = tcs_send(socket, (const uint8_t*)",", 1, TCS_MSG_SENDALL, NULL);
+    if (sts != TCS_SUCCESS)
+        return sts;
+
+    return TCS_SUCCESS;
 }
 
-// tcs_opt_membership_add_str() is defined in tinycsocket_common.c
+// tcs_receive() is defined in OS specific files
+// tcs_receive_from() is defined in OS specific files
 
-TcsResult tcs_opt_membership_add(TcsSocket socket, const struct TcsAddress* multicast_address)
+TcsResult tcs_receive_line(TcsSocket socket,
+                           uint8_t* buffer,
+                           size_t buffer_size,
+                           uint8_t delimiter,
+                           size_t* out_received_size)
 {
-    if (socket == TCS_SOCKET_INVALID)
+    if (socket == TCS_SOCKET_INVALID || buffer == NULL || buffer_size == 0)
         return TCS_ERROR_INVALID_ARGUMENT;
 
-    if (multicast_address == NULL)
-        return TCS_ERROR_INVALID_ARGUMENT;
+    /*
+    *                    data in kernel buffer
+    *   |12345yyyyyyyyyyyyyyyyyyyyyyyy..............|
+    *
+    *       buffer_size ----------------------------------.
+    *       searched ----------------------.                |
+    *                                      |                |
+    *       bytes_peeked ------------------.                |
+    *       bytes_read ---------------.    |                |
+    *                                 v    v                v
+    *       data in arg buffer
+    *   |xxxxxxxxxxxxxxxxxxxxxxxxxxxxxx12345................|
+    */
+    size_t bytes_read = 0;
+    size_t bytes_peeked = 0;
+    size_t bytes_searched = 0;
+    while (bytes_read < buffer_size)
+    {
+        TcsResult sts = TCS_SUCCESS;
+        size_t bytes_free_in_buffer = buffer_size - bytes_read;
+        size_t current_peeked = 0;
+        sts = tcs_receive(socket, buffer + bytes_read, bytes_free_in_buffer, TCS_MSG_PEEK, &current_peeked);
+        if (sts != TCS_SUCCESS)
+        {
+            if (out_received_size != NULL)
+                *out_received_size = bytes_read;
+            return sts;
+        }
+        bytes_peeked += current_peeked;
 
-    SOCKADDR_STORAGE address_native_local;
-    memset(&address_native_local, 0, sizeof address_native_local);
-    int address_native_local_size = sizeof address_native_local;
-    if (getsockname((SOCKET)socket, (PSOCKADDR)&address_native_local, &address_native_local_size) != 0)
-        return wsaerror2retcode(WSAGetLastError());
+        if (current_peeked == 0)
+        {
+            // Make sure we block so we do not fast loop previous PEEK.
+            // Can not assume that peek with waitall is not crossplatform, needs to read
+            size_t current_read = 0;
+            sts = tcs_receive(socket, buffer + bytes_read, 1, TCS_MSG_WAITALL, &current_read);
+            bytes_read += current_read;
+            bytes_peeked += current_read;
 
-    struct TcsAddress local_address = TCS_ADDRESS_NONE;
-    TcsResult sts = native2sockaddr((PSOCKADDR)&address_native_local, &local_address);
-    if (sts != TCS_SUCCESS)
-        return sts;
+            if (sts != TCS_SUCCESS)
+            {
+                if (out_received_size != NULL)
+                    *out_received_size = bytes_read;
+                return sts;
+            }
+        }
 
-    if (local_address.family.native != multicast_address->family.native)
-        return TCS_ERROR_INVALID_ARGUMENT;
+        bool found_delimiter = false;
 
-    return tcs_opt_membership_add_to(socket, &local_address, multicast_address);
+        while (bytes_searched < bytes_peeked)
+        {
+            if (buffer[bytes_searched++] == delimiter)
+            {
+                found_delimiter = true;
+                break;
+            }
+        }
+
+        // byte_searched == bytes_peeked if no delimiter was found
+        // after this block, bytes_read will also has the same value as they have
+        if (bytes_searched > bytes_read)
+        {
+            size_t bytes = 0;
+            size_t bytes_to_read_to_catch_up = bytes_searched - bytes_read;
+            sts = tcs_receive(socket, buffer + bytes_read, bytes_to_read_to_catch_up, TCS_MSG_WAITALL, &bytes);
+            bytes_read += bytes;
+            if (sts != TCS_SUCCESS)
+            {
+                if (out_received_size != NULL)
+                    *out_received_size = bytes_read;
+                return sts;
+            }
+        }
+        if (found_delimiter)
+        {
+            if (out_received_size != NULL)
+                *out_received_size = bytes_read;
+            return sts;
+        }
+    }
+    if (out_received_size != NULL)
+        *out_received_size = bytes_read;
+    return TCS_AGAIN;
 }
 
-TcsResult tcs_opt_membership_add_to(TcsSocket socket,
-                                    const struct TcsAddress* local_address,
-                                    const struct TcsAddress* multicast_address)
+TcsResult tcs_receive_netstring(TcsSocket socket, uint8_t* buffer, size_t buffer_size, size_t* out_received_size)
 {
-    if (socket == TCS_SOCKET_INVALID)
-        return TCS_ERROR_INVALID_ARGUMENT;
-    if (multicast_address == NULL)
+    if (socket == TCS_SOCKET_INVALID || buffer == NULL || buffer_size == 0)
         return TCS_ERROR_INVALID_ARGUMENT;
 
-    if (multicast_address->family.native == TCS_FAMILY_IPV4.native)
-    {
-        struct ip_mreq imr;
-        memset(&imr, 0, sizeof imr);
-        imr.imr_multiaddr.s_addr = htonl(multicast_address->data.ipv4.address);
-        if (local_address != NULL)
-            imr.imr_interface.s_addr = htonl(local_address->data.ipv4.address);
-        return tcs_opt_set(socket, TCS_SOL_IP, TCS_IP_MEMBERSHIP_ADD, &imr, sizeof(imr));
-    }
-    else if (multicast_address->family.native == TCS_FAMILY_IPV6.native)
+    size_t expected_length = 0;
+    int parsed = 0;
+    TcsResult sts = TCS_SUCCESS;
+    char t = '\0';
+    const int max_header = 21;
+    while (t != ':' && parsed < max_header)
     {
-        struct ipv6_mreq imr6;
-        memset(&imr6, 0, sizeof imr6);
-        memcpy(&imr6.ipv6mr_multiaddr, multicast_address->data.ipv6.address.bytes, 16);
-        if (local_address != NULL)
-            imr6.ipv6mr_interface = (unsigned long)local_address->data.ipv6.scope_id;
-        return tcs_opt_set(socket, IPPROTO_IPV6, IPV6_JOIN_GROUP, &imr6, sizeof(imr6));
-    }
-    return TCS_ERROR_NOT_SUPPORTED;
-}
+        sts = tcs_receive(socket, (uint8_t*)&t, 1, TCS_MSG_WAITALL, NULL);
+        if (sts != TCS_SUCCESS)
+            return sts;
 
-// tcs_opt_membership_drop_str() is defined in tinycsocket_common.c
+        parsed += 1;
+
+        bool is_num = t >= '0' && t <= '9';
+        bool is_end = t == ':';
+        if (!is_num && !is_end)
+            return TCS_ERROR_ILL_FORMED_MESSAGE;
+
+        if (is_end)
+            break;
+
+        size_t digit = (size_t)t - '0';
+        if (expected_length > (SIZE_MAX - digit) / 10)
+            return TCS_ERROR_ILL_FORMED_MESSAGE;
+        expected_length = expected_length * 10 + digit;
+    }
 
-TcsResult tcs_opt_membership_drop(TcsSocket socket, const struct TcsAddress* multicast_address)
-{
-    if (socket == TCS_SOCKET_INVALID)
-        return TCS_ERROR_INVALID_ARGUMENT;
+    if (parsed >= max_header)
+        return TCS_ERROR_ILL_FORMED_MESSAGE;
 
-    if (multicast_address == NULL)
-        return TCS_ERROR_INVALID_ARGUMENT;
+    if (buffer_size < expected_length)
+        return TCS_ERROR_MEMORY;
 
-    SOCKADDR_STORAGE address_native_local;
-    memset(&address_native_local, 0, sizeof address_native_local);
-    int address_native_local_size = sizeof address_native_local;
-    if (getsockname((SOCKET)socket, (PSOCKADDR)&address_native_local, &address_native_local_size) != 0)
-        return wsaerror2retcode(WSAGetLastError());
+    sts = tcs_receive(socket, buffer, expected_length, TCS_MSG_WAITALL, NULL);
+    if (sts != TCS_SUCCESS)
+        return sts;
 
-    struct TcsAddress local_address = TCS_ADDRESS_NONE;
-    TcsResult sts = native2sockaddr((PSOCKADDR)&address_native_local, &local_address);
+    sts = tcs_receive(socket, (uint8_t*)&t, 1, TCS_MSG_WAITALL, NULL);
     if (sts != TCS_SUCCESS)
         return sts;
 
-    if (local_address.family.native != multicast_address->family.native)
-        return TCS_ERROR_INVALID_ARGUMENT;
+    if (t != ',')
+        return TCS_ERROR_ILL_FORMED_MESSAGE;
 
-    return tcs_opt_membership_drop_from(socket, &local_address, multicast_address);
+    if (out_received_size != NULL)
+        *out_received_size = expected_length;
+
+    return TCS_SUCCESS;
 }
 
-TcsResult tcs_opt_membership_drop_from(TcsSocket socket,
-                                       const struct TcsAddress* local_address,
-                                       const struct TcsAddress* multicast_address)
+// ######## Socket Polling ########
+
+// tcs_poll_create() is defined in OS specific files
+// tcs_poll_destroy() is defined in OS specific files
+// tcs_poll_add() is defined in OS specific files
+// tcs_poll_modify() is defined in OS specific files
+// tcs_poll_remove() is defined in OS specific files
+// tcs_poll_wait() is defined in OS specific files
+
+// ######## Bulk Connect ########
+
+#define TCS_CONNECTOR_EVENTS_MAX 64
+
+struct TcsConnectorTarget
 {
-    if (socket == TCS_SOCKET_INVALID)
+    struct TcsAddress address;
+    TcsSocket socket;
+    TcsResult result; // TCS_IN_PROGRESS until the target has finished
+    int64_t deadline;
+    bool is_polled;
+    bool is_taken;
+};
+
+struct TcsConnector
+{
+    struct TcsPoll* poll;
+    struct TcsConnectorTarget* targets;
+    size_t targets_length;
+    struct TcsPollEvent events[TCS_CONNECTOR_EVENTS_MAX]; // Kept here to keep tcs_connector_run() stack frame small
+};
+
+TcsResult tcs_connector_create(struct TcsConnector** out_connector,
+                               const struct TcsAddress remote_addresses[],
+                               size_t remote_addresses_length)
+{
+    if (out_connector == NULL || *out_connector != NULL)
         return TCS_ERROR_INVALID_ARGUMENT;
-    if (multicast_address == NULL)
+    if (remote_addresses == NULL || remote_addresses_length == 0)
         return TCS_ERROR_INVALID_ARGUMENT;
 
-    if (multicast_address->family.native == TCS_FAMILY_IPV4.native)
+    struct TcsConnector* connector = (struct TcsConnector*)tcs_lib_malloc(sizeof(struct TcsConnector));
+    if (connector == NULL)
+        return TCS_ERROR_MEMORY;
+    connector->poll = NULL;
+    connector->targets_length = remote_addresses_length;
+    connector->targets =
+        (struct TcsConnectorTarget*)tcs_lib_malloc(remote_addresses_length * sizeof(struct TcsConnectorTarget));
+    if (connector->targets == NULL)
     {
-        struct ip_mreq imr;
-        memset(&imr, 0, sizeof imr);
-        imr.imr_multiaddr.s_addr = htonl(multicast_address->data.ipv4.address);
-        if (local_address != NULL)
-            imr.imr_interface.s_addr = htonl(local_address->data.ipv4.address);
-        return tcs_opt_set(socket, TCS_SOL_IP, TCS_IP_MEMBERSHIP_DROP, &imr, sizeof(imr));
+        tcs_lib_free(connector);
+        return TCS_ERROR_MEMORY;
     }
-    else if (multicast_address->family.native == TCS_FAMILY_IPV6.native)
+    TcsResult res = tcs_poll_create(&connector->poll);
+    if (res != TCS_SUCCESS)
     {
-        struct ipv6_mreq imr6;
-        memset(&imr6, 0, sizeof imr6);
-        memcpy(&imr6.ipv6mr_multiaddr, multicast_address->data.ipv6.address.bytes, 16);
-        if (local_address != NULL)
-            imr6.ipv6mr_interface = (unsigned long)local_address->data.ipv6.scope_id;
-        return tcs_opt_set(socket, IPPROTO_IPV6, IPV6_LEAVE_GROUP, &imr6, sizeof(imr6));
+        tcs_lib_free(connector->targets);
+        tcs_lib_free(connector);
+        return res;
     }
-    return TCS_ERROR_NOT_SUPPORTED;
-}
-
-TcsResult tcs_opt_multicast_interface_set(TcsSocket socket, const struct TcsAddress* local_address)
-{
-    if (socket == TCS_SOCKET_INVALID || local_address == NULL)
-        return TCS_ERROR_INVALID_ARGUMENT;
 
-    if (local_address->family.native == TCS_FAMILY_IPV4.native)
-    {
-        struct in_addr iface;
-        iface.s_addr = htonl(local_address->data.ipv4.address);
-        return tcs_opt_set(socket, TCS_SOL_IP, IP_MULTICAST_IF, &iface, sizeof(iface));
-    }
-    else if (local_address->family.native == TCS_FAMILY_IPV6.native)
+    for (size_t i = 0; i < remote_addresses_length; ++i)
     {
-        unsigned long idx = (unsigned long)local_address->data.ipv6.scope_id;
-        return tcs_opt_set(socket, IPPROTO_IPV6, IPV6_MULTICAST_IF, &idx, sizeof(idx));
+        connector->targets[i].address = remote_addresses[i];
+        connector->targets[i].socket = TCS_SOCKET_INVALID;
+        connector->targets[i].result = TCS_IN_PROGRESS;
+        connector->targets[i].deadline = INT64_MAX;
+        connector->targets[i].is_polled = false;
+        connector->targets[i].is_taken = false;
     }
-    return TCS_ERROR_INVALID_ARGUMENT;
+    *out_connector = connector;
+    return TCS_SUCCESS;
 }
 
-TcsResult tcs_opt_multicast_loop_set(TcsSocket socket, bool do_loopback)
+TcsResult tcs_connector_destroy(struct TcsConnector** connector)
 {
-    if (socket == TCS_SOCKET_INVALID)
+    if (connector == NULL || *connector == NULL)
         return TCS_ERROR_INVALID_ARGUMENT;
 
-    DWORD val = do_loopback ? 1 : 0;
-    return tcs_opt_set(socket, TCS_SOL_IP, IP_MULTICAST_LOOP, &val, sizeof(val));
+    for (size_t i = 0; i < (*connector)->targets_length; ++i)
+    {
+        if ((*connector)->targets[i].socket != TCS_SOCKET_INVALID)
+            tcs_close(&(*connector)->targets[i].socket);
+    }
+    tcs_poll_destroy(&(*connector)->poll);
+    tcs_lib_free((*connector)->targets);
+    tcs_lib_free(*connector);
+    *connector = NULL;
+    return TCS_SUCCESS;
 }
 
-TcsResult tcs_opt_multicast_loop_get(TcsSocket socket, bool* is_loopback)
+static void connector_target_finish(struct TcsConnector* connector, struct TcsConnectorTarget* target, TcsResult result)
 {
-    if (socket == TCS_SOCKET_INVALID || is_loopback == NULL)
-        return TCS_ERROR_INVALID_ARGUMENT;
-
-    DWORD val = 0;
-    size_t s = sizeof(val);
-    TcsResult sts = tcs_opt_get(socket, TCS_SOL_IP, IP_MULTICAST_LOOP, &val, &s);
-    *is_loopback = val;
-    return sts;
+    if (target->is_polled)
+        tcs_poll_remove(connector->poll, target->socket);
+    target->is_polled = false;
+    if (result == TCS_SUCCESS)
+        result = tcs_opt_nonblocking_set(target->socket, false);
+    if (result != TCS_SUCCESS && target->socket != TCS_SOCKET_INVALID)
+        tcs_close(&target->socket);
+    target->result = result;
 }
 
-// ######## Address and Interface Utilities ########
-
-// Retrieves the user-visible adapter name.
-// On Vista+ this is the FriendlyName field in IP_ADAPTER_ADDRESSES.
-// On pre-Vista the FriendlyName field does not exist, so we read the registry:
-//   HKLM\SYSTEM\CurrentControlSet\Control\Network\{4D36E972-E325-11CE-BFC1-08002BE10318}\<GUID>\Connection
-//   Value: "Name" (REG_SZ)
-// Falls back to Description (hardware name) if FriendlyName / registry is unavailable.
-static TcsResult adapter_get_friendly_name(PIP_ADAPTER_ADDRESSES adapter, char* out_name, int out_name_size)
+TcsResult tcs_connector_run(struct TcsConnector* connector,
+                            size_t max_in_flight,
+                            int connect_timeout_ms,
+                            int total_timeout_ms)
 {
-    if (adapter == NULL || out_name == NULL || out_name_size <= 0)
+    if (connector == NULL)
+        return TCS_ERROR_INVALID_ARGUMENT;
+    if ((connect_timeout_ms < 0 && connect_timeout_ms != TCS_WAIT_INF) ||
+        (total_timeout_ms < 0 && total_timeout_ms != TCS_WAIT_INF))
         return TCS_ERROR_INVALID_ARGUMENT;
-#if _WIN32_WINNT >= 0x0600
-    WideCharToMultiByte(CP_UTF8, 0, adapter->FriendlyName, -1, out_name, out_name_size, NULL, NULL);
-#else
-    const char prefix[] =
-        "SYSTEM\\CurrentControlSet\\Control\\Network\\"
-        "{4D36E972-E325-11CE-BFC1-08002BE10318}\\";
-    const char suffix[] = "\\Connection";
-
-    bool found = false;
-    size_t guid_len = strlen(adapter->AdapterName);
-    size_t key_len = sizeof(prefix) - 1 + guid_len + sizeof(suffix) - 1 + 1;
 
-    char key_path[256];
-    if (key_len <= sizeof key_path)
+    const int64_t start = tcs_time_monotonic_ms();
+    const int64_t total_deadline = total_timeout_ms == TCS_WAIT_INF ? INT64_MAX : start + total_timeout_ms;
+    size_t next = 0;
+    size_t in_flight = 0;
+    for (size_t i = 0; i < connector->targets_length; ++i)
+        in_flight += connector->targets[i].is_polled ? 1 : 0;
+    TcsResult res = TCS_SUCCESS;
+    for (;;)
     {
-        memcpy(key_path, prefix, sizeof(prefix) - 1);
-        memcpy(key_path + sizeof(prefix) - 1, adapter->AdapterName, guid_len);
-        memcpy(key_path + sizeof(prefix) - 1 + guid_len, suffix, sizeof(suffix)); // includes null
+        int64_t now = tcs_time_monotonic_ms();
 
-        HKEY hkey = NULL;
-        if (RegOpenKeyExA(HKEY_LOCAL_MACHINE, key_path, 0, KEY_READ, &hkey) == ERROR_SUCCESS)
+        // Start targets while there is room
+        for (; next < connector->targets_length && (max_in_flight == 0 || in_flight < max_in_flight) &&
+               now < total_deadline;
+             ++next)
         {
-            DWORD type = 0;
-            DWORD data_size = (DWORD)out_name_size;
-            if (RegQueryValueExA(hkey, "Name", NULL, &type, (LPBYTE)out_name, &data_size) == ERROR_SUCCESS &&
-                type == REG_SZ && data_size > 1)
+            struct TcsConnectorTarget* target = &connector->targets[next];
+            if (target->result != TCS_IN_PROGRESS || target->is_polled)
+                continue;
+            TcsResult start_res = tcs_socket_with_flags(&target->socket,
+                                                        target->address.family,
+                                                        TCS_SOCKET_STREAM,
+                                                        TCS_PROTOCOL_IP_TCP,
+                                                        TCS_SOCKET_FLAG_NONBLOCKING | TCS_SOCKET_FLAG_CLOEXEC);
+            if (start_res == TCS_SUCCESS)
+                start_res = tcs_connect(target->socket, &target->address);
+            if (start_res == TCS_IN_PROGRESS)
             {
-                found = true;
+                start_res = tcs_poll_add(connector->poll, target->socket, target, TCS_POLL_WRITE);
+                if (start_res == TCS_SUCCESS)
+                {
+                    target->is_polled = true;
+                    target->deadline = connect_timeout_ms == TCS_WAIT_INF ? INT64_MAX : now + connect_timeout_ms;
+                    in_flight++;
+                    continue;
+                }
             }
-            RegCloseKey(hkey);
+            // Failed, or connected at once which may happen on loopback
+            connector_target_finish(connector, target, start_res);
         }
-    }
 
-    if (!found)
-        WideCharToMultiByte(CP_UTF8, 0, adapter->Description, -1, out_name, out_name_size, NULL, NULL);
-#endif
-    return TCS_SUCCESS;
+        if (in_flight == 0 && next == connector->targets_length)
+            break;
+
+        // Expire targets and find the next wake up time
+        int64_t wake_time = total_deadline;
+        for (size_t i = 0; i < connector->targets_length; ++i)
+        {
+            struct TcsConnectorTarget* target = &connector->targets[i];
+            if (!target->is_polled)
+                continue;
+            if (now >= target->deadline || now >= total_deadline)
+            {
+                connector_target_finish(connector, target, TCS_ERROR_TIMED_OUT);
+                in_flight--;
+            }
+            else if (target->deadline < wake_time)
+            {
+                wake_time = target->deadline;
+            }
+        }
+        if (now >= total_deadline)
+        {
+            for (; next < connector->targets_length; ++next)
+            {
+                if (connector->targets[next].result == TCS_IN_PROGRESS)
+                    connector->targets[next].result = TCS_ERROR_TIMED_OUT;
+            }
+            res = TCS_ERROR_TIMED_OUT;
+            break;
+        }
+        if (in_flight == 0)
+            continue;
+
+        struct TcsPollEvent* events = connector->events;
+        size_t events_length = 0;
+        int wait_ms = wake_time == INT64_MAX ? TCS_WAIT_INF : (int)(wake_time - now);
+        TcsResult wait_res = tcs_poll_wait(connector->poll, events, TCS_CONNECTOR_EVENTS_MAX, &events_length, wait_ms);
+        if (wait_res != TCS_SUCCESS && wait_res != TCS_ERROR_TIMED_OUT)
+        {
+            res = wait_res;
+            break;
+        }
+        for (size_t i = 0; i < events_length; ++i)
+        {
+            struct TcsConnectorTarget* target = (struct TcsConnectorTarget*)events[i].user_data;
+            if (events[i].error != TCS_SUCCESS)
+                connector_target_finish(connector, target, events[i].error);
+            else if (events[i].can_write)
+                connector_target_finish(connector, target, TCS_SUCCESS);
+            else
+                continue;
+            in_flight--;
+        }
+    }
+    return res;
 }
 
-static TcsResult adapter_is_up(PIP_ADAPTER_ADDRESSES adapter, bool* out_is_up)
+TcsResult tcs_connector_take(struct TcsConnector* connector, size_t index, TcsSocket* out_socket)
 {
-    if (adapter == NULL || out_is_up == NULL)
+    if (connector == NULL || index >= connector->targets_length)
         return TCS_ERROR_INVALID_ARGUMENT;
-#if _WIN32_WINNT >= 0x0600
-    *out_is_up = adapter->OperStatus == IfOperStatusUp;
-#else
-#ifndef MIB_IF_OPER_STATUS_OPERATIONAL
-// Not always exposed in all mingw-w64 versions
-#define MIB_IF_OPER_STATUS_OPERATIONAL 5
-#endif
-    MIB_IFROW ifrow;
-    memset(&ifrow, 0, sizeof ifrow);
-    ifrow.dwIndex = adapter->IfIndex;
-    if (GetIfEntry(&ifrow) != NO_ERROR)
+    if (out_socket != NULL && *out_socket != TCS_SOCKET_INVALID)
+        return TCS_ERROR_INVALID_ARGUMENT;
+
+    struct TcsConnectorTarget* target = &connector->targets[index];
+    if (target->is_taken)
+        return TCS_ERROR_INVALID_ARGUMENT;
+    if (target->result == TCS_SUCCESS && out_socket != NULL)
     {
-        *out_is_up = false;
-        return TCS_SUCCESS;
+        *out_socket = target->socket;
+        target->socket = TCS_SOCKET_INVALID;
+        target->is_taken = true;
     }
-    *out_is_up = ifrow.dwOperStatus >= MIB_IF_OPER_STATUS_OPERATIONAL;
-#endif
-    return TCS_SUCCESS;
+    return target->result;
 }
 
-TcsResult tcs_interface_list(struct TcsInterface out_interfaces[], size_t interfaces_length, size_t* out_length)
+// ######## Connection Pool ########
+
+#define TCS_POOL_CLOSE_BATCH 16 // Sockets closed after the shard lock is dropped, the rest waits for the next call
+
+struct TcsPoolIdle
 {
-    if (out_interfaces == NULL && out_length == NULL)
-        return TCS_ERROR_INVALID_ARGUMENT;
+    TcsSocket socket;
+    int64_t idle_since_ms;
+};
 
-    if (out_interfaces == NULL && interfaces_length != 0)
-        return TCS_ERROR_INVALID_ARGUMENT;
+struct TcsPoolKey
+{
+    struct TcsAddress address;
+    size_t total;      // Idle and acquired connections, the key is removed when this reaches zero
+    size_t idle_count; // Oldest first
+    struct TcsPoolIdle* idle;
+};
 
-    if (out_length != NULL)
-        *out_length = 0;
+// Keys are allocated one by one so pointers to them stay valid while the map grows
+TDS_HMAP_IMPL(struct TcsAddress, struct TcsPoolKey*, pool_key, tcs_address_hash, tcs_address_is_equal)
 
-    const int MAX_TRIES = 5;
-    ULONG buffer_size = 15000; // From msdn recommendation
-    PIP_ADAPTER_ADDRESSES adapters = NULL;
-    ULONG adapter_sts = ERROR_NO_DATA;
-    for (int i = 0; i < MAX_TRIES; ++i)
-    {
-        adapters = (PIP_ADAPTER_ADDRESSES)malloc(buffer_size);
-        if (adapters == NULL)
-            return TCS_ERROR_MEMORY;
-        adapter_sts = GetAdaptersAddresses(AF_UNSPEC,
-                                           GAA_FLAG_SKIP_DNS_SERVER | GAA_FLAG_SKIP_ANYCAST | GAA_FLAG_SKIP_MULTICAST,
-                                           NULL,
-                                           adapters,
-                                           &buffer_size);
-        if (adapter_sts == ERROR_BUFFER_OVERFLOW)
-        {
-            free(adapters);
-            adapters = NULL;
-        }
-        else
-        {
-            break;
-        }
-    }
-    if (adapter_sts == ERROR_NO_DATA)
-    {
-        if (adapters != NULL)
-            free(adapters);
-        return TCS_SUCCESS;
-    }
-    if (adapter_sts != NO_ERROR)
-    {
-        // Debug: log the actual Windows error code for diagnostics
-        fprintf(stderr, "GetAdaptersAddresses failed with error: %lu (0x%lX)\n", adapter_sts, adapter_sts);
-        if (adapters != NULL)
-            free(adapters);
-        return TCS_ERROR_UNKNOWN;
-    }
+struct TcsPoolShard
+{
+    struct TcsOsMutex* lock;
+    struct TdsHMap_pool_key keys;
+    int64_t next_sweep_ms; // Keys nobody touches are only expired by a sweep of the whole shard
+};
+
+struct TcsPool
+{
+    size_t max_idle_per_key;
+    size_t max_total_per_key;
+    int idle_timeout_ms;
+    int connect_timeout_ms;
+    struct TcsPoolShard shards[TCS_CFG_POOL_SHARDS];
+};
+
+// Sockets removed from the pool under the shard lock, closed by pool_closing_flush() without it
+struct TcsPoolClosing
+{
+    TcsSocket sockets[TCS_POOL_CLOSE_BATCH];
+    size_t count;
+};
+
+static void pool_closing_flush(struct TcsPoolClosing* closing)
+{
+    for (size_t i = 0; i < closing->count; ++i)
+        tcs_close(&closing->sockets[i]);
+    closing->count = 0;
+}
+
+static size_t pool_shard_index(const struct TcsAddress* address)
+{
+    return (size_t)(tcs_address_hash(address, 0) % TCS_CFG_POOL_SHARDS);
+}
+
+// Moves idle connections that have passed the idle timeout to closing, they are stored oldest first
+static void pool_key_expire(const struct TcsPool* pool,
+                            struct TcsPoolKey* key,
+                            int64_t now_ms,
+                            struct TcsPoolClosing* closing)
+{
+    if (pool->idle_timeout_ms == TCS_WAIT_INF)
+        return;
+    size_t expired = 0;
+    while (expired < key->idle_count && closing->count < TCS_POOL_CLOSE_BATCH &&
+           now_ms - key->idle[expired].idle_since_ms >= pool->idle_timeout_ms)
+        closing->sockets[closing->count++] = key->idle[expired++].socket;
+    if (expired == 0)
+        return;
+    key->idle_count -= expired;
+    key->total -= expired;
+    memmove(key->idle, key->idle + expired, key->idle_count * sizeof(struct TcsPoolIdle));
+}
 
+// Frees a key without connections, the key pointer is invalid afterwards if it returns true
+static bool pool_key_remove_if_unused(struct TcsPoolShard* shard, struct TcsPoolKey* key)
+{
+    if (key->total > 0)
+        return false;
+    tds_hmap_pool_key_remove(&shard->keys, &key->address);
+    tcs_lib_free(key->idle);
+    tcs_lib_free(key);
+    return true;
+}
+
+// Expires every key of the shard at most once per idle timeout, so keys of addresses that are not used anymore are
+// also removed without making every acquire and release walk the whole shard
+static void pool_shard_sweep(const struct TcsPool* pool,
+                             struct TcsPoolShard* shard,
+                             int64_t now_ms,
+                             struct TcsPoolClosing* closing)
+{
+    if (pool->idle_timeout_ms == TCS_WAIT_INF || now_ms < shard->next_sweep_ms)
+        return;
+    size_t i = 0;
+    while (i < shard->keys.capacity && closing->count < TCS_POOL_CLOSE_BATCH)
     {
-        size_t i = 0;
-        for (PIP_ADAPTER_ADDRESSES iter = adapters; iter != NULL; iter = iter->Next)
+        if (shard->keys.distances[i] == 0)
         {
-            bool is_up = false;
-            TcsResult up_sts = adapter_is_up(iter, &is_up);
-            if (up_sts != TCS_SUCCESS)
-            {
-                free(adapters);
-                return TCS_ERROR_SYSTEM;
-            }
-            if (!is_up)
-                continue;
-
-            if (out_interfaces != NULL && i < interfaces_length)
-            {
-                memset(out_interfaces[i].name, '\0', TCS_CFG_INTERFACE_NAME_SIZE);
-                TcsResult name_sts =
-                    adapter_get_friendly_name(iter, out_interfaces[i].name, TCS_CFG_INTERFACE_NAME_SIZE - 1);
-                if (name_sts != TCS_SUCCESS)
-                {
-                    free(adapters);
-                    return TCS_ERROR_SYSTEM;
-                }
-                out_interfaces[i].id = iter->IfIndex;
-            }
-            if (out_length != NULL)
-                (*out_length)++;
             ++i;
+            continue;
         }
+        struct TcsPoolKey* key = shard->keys.values[i];
+        pool_key_expire(pool, key, now_ms, closing);
+        if (!pool_key_remove_if_unused(shard, key))
+            ++i; // Otherwise the removal shifted the next entry into i
     }
+    if (closing->count < TCS_POOL_CLOSE_BATCH)
+        shard->next_sweep_ms = now_ms + pool->idle_timeout_ms; // A full batch continues the sweep on the next call
+}
 
-    free(adapters);
-    return TCS_SUCCESS;
+// An idle connection should have nothing to read, EOF, a pending error or stray data all make it unusable
+static bool pool_socket_is_alive(TcsSocket socket)
+{
+    uint8_t byte = 0;
+    size_t received = 0;
+    return tcs_receive(socket, &byte, 1, TCS_MSG_PEEK | TCS_MSG_DONTWAIT, &received) == TCS_ERROR_WOULD_BLOCK;
 }
 
-TcsResult tcs_address_resolve(const char* hostname,
-                              TcsFamily address_family,
-                              struct TcsAddress out_addresses[],
-                              size_t addresses_length,
-                              size_t* out_length)
+TcsResult tcs_pool_create(struct TcsPool** out_pool,
+                          size_t max_idle_per_key,
+                          size_t max_total_per_key,
+                          int idle_timeout_ms,
+                          int connect_timeout_ms)
 {
-    if (hostname == NULL)
+    if (out_pool == NULL || *out_pool != NULL)
         return TCS_ERROR_INVALID_ARGUMENT;
-
-    if (out_addresses == NULL && out_length == NULL)
+    if (max_total_per_key == 0 || max_idle_per_key > max_total_per_key)
+        return TCS_ERROR_INVALID_ARGUMENT;
+    if ((idle_timeout_ms < 0 && idle_timeout_ms != TCS_WAIT_INF) ||
+        (connect_timeout_ms < 0 && connect_timeout_ms != TCS_WAIT_INF))
         return TCS_ERROR_INVALID_ARGUMENT;
 
-    if (out_length != NULL)
-        *out_length = 0;
+    struct TcsPool* pool = (struct TcsPool*)tcs_lib_malloc(sizeof(struct TcsPool));
+    if (pool == NULL)
+        return TCS_ERROR_MEMORY;
+    memset(pool, 0, sizeof(struct TcsPool));
+    pool->max_idle_per_key = max_idle_per_key;
+    pool->max_total_per_key = max_total_per_key;
+    pool->idle_timeout_ms = idle_timeout_ms;
+    pool->connect_timeout_ms = connect_timeout_ms;
 
-    // Fast path: try numeric/MAC parse first to avoid DNS lookup
-    struct TcsAddress parsed = TCS_ADDRESS_NONE;
-    if (tcs_address_parse(hostname, &parsed) == TCS_SUCCESS && parsed.family.native != TCS_FAMILY_ANY.native)
+    // Per pool seed so remote peers can not pick addresses that collide in every process
+    uint64_t seed = (uint64_t)tcs_time_monotonic_ms() ^ (uint64_t)(uintptr_t)pool;
+    for (size_t i = 0; i < TCS_CFG_POOL_SHARDS; ++i)
     {
-        if (address_family.native == TCS_FAMILY_ANY.native || parsed.family.native == address_family.native)
+        TcsResult res = tcs_os_mutex_create(&pool->shards[i].lock);
+        if (res != TCS_SUCCESS)
         {
-            if (out_addresses != NULL && addresses_length > 0)
-                out_addresses[0] = parsed;
-            if (out_length != NULL)
-                *out_length = 1;
-            return TCS_SUCCESS;
+            for (size_t j = 0; j < i; ++j)
+                tcs_os_mutex_destroy(&pool->shards[j].lock);
+            tcs_lib_free(pool);
+            return res;
         }
+        tds_hmap_pool_key_create(&pool->shards[i].keys, tcs_address_hash(NULL, seed + i) * 0x9E3779B97F4A7C15ULL);
     }
 
-    if (address_family.native == -1) // sentinel for unsupported families (e.g. TCS_FAMILY_PACKET on Windows)
-        return TCS_ERROR_NOT_SUPPORTED;
-
-    ADDRINFOA native_hints;
-    memset(&native_hints, 0, sizeof native_hints);
-    native_hints.ai_family = address_family.native;
-
-    PADDRINFOA native_addrinfo_list = NULL;
-    int getaddrinfo_status = getaddrinfo(hostname, NULL, &native_hints, &native_addrinfo_list);
-    if (getaddrinfo_status != 0)
-        return TCS_ERROR_ADDRESS_LOOKUP_FAILED;
+    *out_pool = pool;
+    return TCS_SUCCESS;
+}
 
-    if (native_addrinfo_list == NULL)
-        return TCS_ERROR_UNKNOWN;
+TcsResult tcs_pool_destroy(struct TcsPool** pool)
+{
+    if (pool == NULL || *pool == NULL)
+        return TCS_ERROR_INVALID_ARGUMENT;
 
-    size_t i = 0;
-    if (out_addresses == NULL)
-    {
-        for (PADDRINFOA iter = native_addrinfo_list; iter != NULL; iter = iter->ai_next)
-            i++;
-    }
-    else
+    for (size_t i = 0; i < TCS_CFG_POOL_SHARDS; ++i)
     {
-        for (PADDRINFOA iter = native_addrinfo_list; iter != NULL && i < addresses_length; iter = iter->ai_next)
+        struct TcsPoolShard* shard = &(*pool)->shards[i];
+        for (size_t k = 0; k < shard->keys.capacity; ++k)
         {
-            if (iter->ai_addr == NULL)
-                continue;
-            TcsResult address_convert_status = native2sockaddr(iter->ai_addr, &out_addresses[i]);
-            if (address_convert_status != TCS_SUCCESS)
+            if (shard->keys.distances[k] == 0)
                 continue;
-            i++;
+            struct TcsPoolKey* key = shard->keys.values[k];
+            for (size_t n = 0; n < key->idle_count; ++n)
+                tcs_close(&key->idle[n].socket);
+            tcs_lib_free(key->idle);
+            tcs_lib_free(key);
         }
+        tds_hmap_pool_key_destroy(&shard->keys);
+        tcs_os_mutex_destroy(&shard->lock);
     }
-    if (out_length != NULL)
-        *out_length = i;
-
-    freeaddrinfo(native_addrinfo_list);
-
-    if (i == 0)
-        return TCS_ERROR_ADDRESS_LOOKUP_FAILED;
-
+    tcs_lib_free(*pool);
+    *pool = NULL;
     return TCS_SUCCESS;
 }
 
-TcsResult tcs_address_list(unsigned int interface_id_filter,
-                           TcsFamily address_family_filter,
-                           struct TcsInterfaceAddress out_interface_addresses[],
-                           size_t interface_addresses_length,
-                           size_t* out_length)
+static struct TcsPoolKey* pool_key_get_or_add(const struct TcsPool* pool,
+                                              struct TcsPoolShard* shard,
+                                              const struct TcsAddress* address)
 {
-    if (out_interface_addresses == NULL && out_length == NULL)
-        return TCS_ERROR_INVALID_ARGUMENT;
+    struct TcsPoolKey** found = tds_hmap_pool_key_get(&shard->keys, address);
+    if (found != NULL)
+        return *found;
 
-    if (out_interface_addresses == NULL && interface_addresses_length != 0)
+    struct TcsPoolKey* key = (struct TcsPoolKey*)tcs_lib_malloc(sizeof(struct TcsPoolKey));
+    if (key == NULL)
+        return NULL;
+    key->address = *address;
+    key->total = 0;
+    key->idle_count = 0;
+    key->idle = NULL;
+    if (pool->max_idle_per_key > 0)
+    {
+        key->idle = (struct TcsPoolIdle*)tcs_lib_malloc(pool->max_idle_per_key * sizeof(struct TcsPoolIdle));
+        if (key->idle == NULL)
+        {
+            tcs_lib_free(key);
+            return NULL;
+        }
+    }
+    if (tds_hmap_pool_key_set(&shard->keys, address, &key) != 0)
+    {
+        tcs_lib_free(key->idle);
+        tcs_lib_free(key);
+        return NULL;
+    }
+    return key;
+}
+
+TcsResult tcs_pool_acquire(struct TcsPool* pool, const struct TcsAddress* remote_address, TcsSocket* out_socket)
+{
+    if (pool == NULL || remote_address == NULL || out_socket == NULL || *out_socket != TCS_SOCKET_INVALID)
         return TCS_ERROR_INVALID_ARGUMENT;
 
-    if (out_length != NULL)
-        *out_length = 0;
+    struct TcsPoolShard* shard = &pool->shards[pool_shard_index(remote_address)];
+    struct TcsPoolClosing closing;
+    closing.count = 0;
+    tcs_os_mutex_lock(shard->lock);
+    int64_t now_ms = tcs_time_monotonic_ms();
+    pool_shard_sweep(pool, shard, now_ms, &closing);
+    struct TcsPoolKey* key = pool_key_get_or_add(pool, shard, remote_address);
+    if (key == NULL)
+    {
+        tcs_os_mutex_unlock(shard->lock);
+        pool_closing_flush(&closing);
+        return TCS_ERROR_MEMORY;
+    }
+    pool_key_expire(pool, key, now_ms, &closing);
 
-    const int MAX_TRIES = 5;
-    ULONG buffer_size = 15000;
-    PIP_ADAPTER_ADDRESSES adapters = NULL;
-    ULONG adapter_sts = ERROR_NO_DATA;
-    for (int i = 0; i < MAX_TRIES; ++i)
+    // The newest idle connection is checked without the lock, it still counts in total so the key stays
+    while (key->idle_count > 0)
     {
-        adapters = (PIP_ADAPTER_ADDRESSES)malloc(buffer_size);
-        if (adapters == NULL)
-            return TCS_ERROR_MEMORY;
-        adapter_sts = GetAdaptersAddresses(AF_UNSPEC,
-                                           GAA_FLAG_SKIP_DNS_SERVER | GAA_FLAG_SKIP_ANYCAST | GAA_FLAG_SKIP_MULTICAST,
-                                           NULL,
-                                           adapters,
-                                           &buffer_size);
-        if (adapter_sts == ERROR_BUFFER_OVERFLOW)
-        {
-            free(adapters);
-            adapters = NULL;
-        }
-        else
+        TcsSocket socket = key->idle[--key->idle_count].socket;
+        tcs_os_mutex_unlock(shard->lock);
+        pool_closing_flush(&closing);
+        if (pool_socket_is_alive(socket))
         {
-            break;
+            *out_socket = socket;
+            return TCS_SUCCESS;
         }
+        tcs_close(&socket);
+        tcs_os_mutex_lock(shard->lock);
+        key->total--;
     }
-    if (adapter_sts == ERROR_NO_DATA)
+    if (key->total >= pool->max_total_per_key)
     {
-        if (adapters != NULL)
-            free(adapters);
-        return TCS_SUCCESS;
+        tcs_os_mutex_unlock(shard->lock);
+        pool_closing_flush(&closing);
+        return TCS_ERROR_WOULD_BLOCK;
     }
-    if (adapter_sts != NO_ERROR)
+    key->total++; // Reserve the slot while connecting without the lock, this also keeps the key
+    tcs_os_mutex_unlock(shard->lock);
+    pool_closing_flush(&closing);
+
+    TcsResult res = tcs_socket_tcp(out_socket, NULL, remote_address, pool->connect_timeout_ms);
+    if (res != TCS_SUCCESS)
     {
-        if (adapters != NULL)
-            free(adapters);
-        return TCS_ERROR_UNKNOWN;
+        tcs_os_mutex_lock(shard->lock);
+        key->total--;
+        pool_key_remove_if_unused(shard, key);
+        tcs_os_mutex_unlock(shard->lock);
     }
+    return res;
+}
 
-    size_t populated = 0;
-    for (PIP_ADAPTER_ADDRESSES iter = adapters; iter != NULL; iter = iter->Next)
+TcsResult tcs_pool_release(struct TcsPool* pool,
+                           const struct TcsAddress* remote_address,
+                           TcsSocket* socket,
+                           bool is_reusable)
+{
+    if (pool == NULL || remote_address == NULL || socket == NULL || *socket == TCS_SOCKET_INVALID)
+        return TCS_ERROR_INVALID_ARGUMENT;
+
+    struct TcsPoolShard* shard = &pool->shards[pool_shard_index(remote_address)];
+    struct TcsPoolClosing closing;
+    closing.count = 0;
+    tcs_os_mutex_lock(shard->lock);
+    struct TcsPoolKey** found = tds_hmap_pool_key_get(&shard->keys, remote_address);
+    if (found == NULL)
     {
-        bool is_up = false;
-        TcsResult up_sts = adapter_is_up(iter, &is_up);
-        if (up_sts != TCS_SUCCESS)
-        {
-            free(adapters);
-            return TCS_ERROR_SYSTEM;
-        }
-        if (!is_up)
-            continue;
+        tcs_os_mutex_unlock(shard->lock);
+        return TCS_ERROR_INVALID_ARGUMENT;
+    }
+    struct TcsPoolKey* key = *found;
+    int64_t now_ms = tcs_time_monotonic_ms();
+    pool_key_expire(pool, key, now_ms, &closing); // The released connection keeps total above zero
+    bool is_pooled = is_reusable && key->idle_count < pool->max_idle_per_key;
+    if (is_pooled)
+    {
+        key->idle[key->idle_count].socket = *socket;
+        key->idle[key->idle_count].idle_since_ms = now_ms;
+        key->idle_count++;
+        *socket = TCS_SOCKET_INVALID;
+    }
+    else
+    {
+        key->total--;
+        pool_key_remove_if_unused(shard, key);
+    }
+    pool_shard_sweep(pool, shard, now_ms, &closing); // Last, it may remove the key
+    tcs_os_mutex_unlock(shard->lock);
+    pool_closing_flush(&closing);
+    return is_pooled ? TCS_SUCCESS : tcs_close(socket);
+}
 
-        if (interface_id_filter != 0 && iter->IfIndex != interface_id_filter)
-            continue;
+// ######## Asynchronous Resolve ########
 
-        for (PIP_ADAPTER_UNICAST_ADDRESS address_iter = iter->FirstUnicastAddress; address_iter != NULL;
-             address_iter = address_iter->Next)
-        {
-            if (address_iter->Address.lpSockaddr == NULL)
-                continue;
+enum TcsResolveState
+{
+    TCS_RESOLVE_FREE,
+    TCS_RESOLVE_PENDING,
+    TCS_RESOLVE_RUNNING,
+    TCS_RESOLVE_DONE,
+    TCS_RESOLVE_CANCELLED, // Freed by the worker when the lookup returns
+};
 
-            if (address_family_filter.native != TCS_FAMILY_ANY.native)
-            {
-                if (address_family_filter.native == -1) /* unsupported sentinel */
-                    continue;
-                if (address_iter->Address.lpSockaddr->sa_family != address_family_filter.native)
-                    continue;
-            }
+struct TcsResolveRequest
+{
+    char* hostname;
+    TcsFamily family;
+    enum TcsResolveState state;
+    TcsResult result;
+    size_t address_count;
+    struct TcsAddress addresses[TCS_CFG_RESOLVER_ADDRESSES_MAX];
+    size_t next;       // Next request in the free, pending or done list
+    size_t generation; // Bumped when the slot is freed so handles of earlier lookups no longer match
+};
 
-            struct TcsAddress address = TCS_ADDRESS_NONE;
-            TcsResult convert_sts = native2sockaddr(address_iter->Address.lpSockaddr, &address);
-            if (convert_sts != TCS_SUCCESS)
-                continue; // skip entries we cannot represent (unknown family, malformed sockaddr, etc.)
+#ifndef TDS_ULIST_resolve_request
+#define TDS_ULIST_resolve_request
+TDS_ULIST_IMPL(struct TcsResolveRequest, resolve_request)
+#endif
 
-            if (out_interface_addresses != NULL && populated < interface_addresses_length)
-            {
-                memset(out_interface_addresses[populated].iface.name, '\0', TCS_CFG_INTERFACE_NAME_SIZE);
-                TcsResult name_sts = adapter_get_friendly_name(
-                    iter, out_interface_addresses[populated].iface.name, TCS_CFG_INTERFACE_NAME_SIZE - 1);
-                if (name_sts != TCS_SUCCESS)
-                {
-                    free(adapters);
-                    return TCS_ERROR_SYSTEM;
-                }
-                out_interface_addresses[populated].iface.id = iter->IfIndex;
-                out_interface_addresses[populated].address = address;
-                populated++;
+struct TcsResolver
+{
+    struct TcsOsMutex* lock;
+    struct TcsOsSemaphore* has_pending; // Posted for every submit, and once per thread when stopping
+    struct TcsOsWakeup* wakeup;         // Set while the done list is not empty
+    bool is_stopping;
+    size_t thread_count;
+    struct TcsOsThread** threads;
+    struct TdsUList_resolve_request requests; // Requests are reused but never moved between slots
+    size_t free_head;
+    size_t pending_head;
+    size_t pending_tail;
+    size_t done_head;
+    size_t done_tail;
+};
 
-                if (out_length != NULL)
-                    (*out_length)++;
-            }
-            else if (out_interface_addresses == NULL && out_length != NULL)
-            {
-                (*out_length)++;
-            }
+// End of the free, pending and done lists
+static const size_t RESOLVER_END = (size_t)-1;
+
+// A handle is the slot index in the low half and the slot generation in the high half
+#define RESOLVER_HANDLE_SHIFT (sizeof(size_t) * 4)
+static const size_t RESOLVER_HANDLE_MASK = ((size_t)1 << RESOLVER_HANDLE_SHIFT) - 1;
+
+static size_t resolver_handle(const struct TcsResolver* resolver, size_t index)
+{
+    return index | (resolver->requests.data[index].generation << RESOLVER_HANDLE_SHIFT);
+}
+
+// Returns the slot of a handle, or RESOLVER_END for handles of lookups that were already taken or cancelled
+static size_t resolver_handle_index(const struct TcsResolver* resolver, size_t handle)
+{
+    size_t index = handle & RESOLVER_HANDLE_MASK;
+    if (index >= resolver->requests.count)
+        return RESOLVER_END;
+    if (resolver->requests.data[index].generation != handle >> RESOLVER_HANDLE_SHIFT)
+        return RESOLVER_END;
+    return index;
+}
+
+static void resolver_request_free(struct TcsResolver* resolver, size_t index)
+{
+    struct TcsResolveRequest* request = &resolver->requests.data[index];
+    tcs_lib_free(request->hostname);
+    request->hostname = NULL;
+    request->state = TCS_RESOLVE_FREE;
+    request->generation = (request->generation + 1) & RESOLVER_HANDLE_MASK;
+    request->next = resolver->free_head;
+    resolver->free_head = index;
+}
+
+static void resolver_list_append(struct TcsResolver* resolver, size_t* head, size_t* tail, size_t index)
+{
+    resolver->requests.data[index].next = RESOLVER_END;
+    if (*tail != RESOLVER_END)
+        resolver->requests.data[*tail].next = index;
+    else
+        *head = index;
+    *tail = index;
+}
+
+static void resolver_list_unlink(struct TcsResolver* resolver, size_t* head, size_t* tail, size_t index)
+{
+    size_t prev = RESOLVER_END;
+    size_t iter = *head;
+    while (iter != index)
+    {
+        prev = iter;
+        iter = resolver->requests.data[iter].next;
+    }
+    size_t next = resolver->requests.data[index].next;
+    if (prev != RESOLVER_END)
+        resolver->requests.data[prev].next = next;
+    else
+        *head = next;
+    if (*tail == index)
+        *tail = prev;
+}
+
+// Keeps the wakeup readable exactly while there are lookups to take. The caller holds the lock.
+static void resolver_wakeup_update(struct TcsResolver* resolver, bool was_done_empty)
+{
+    bool is_done_empty = resolver->done_head == RESOLVER_END;
+    if (was_done_empty != is_done_empty)
+        tcs_os_wakeup_set(resolver->wakeup, !is_done_empty);
+}
+
+static void resolver_thread(void* arg)
+{
+    struct TcsResolver* resolver = (struct TcsResolver*)arg;
+    while (true)
+    {
+        tcs_os_semaphore_wait(resolver->has_pending);
+        tcs_os_mutex_lock(resolver->lock);
+        if (resolver->is_stopping)
+            break;
+        if (resolver->pending_head == RESOLVER_END) // Cancelled before any thread took it
+        {
+            tcs_os_mutex_unlock(resolver->lock);
+            continue;
         }
+
+        size_t index = resolver->pending_head;
+        struct TcsResolveRequest* request = &resolver->requests.data[index];
+        resolver_list_unlink(resolver, &resolver->pending_head, &resolver->pending_tail, index);
+        request->state = TCS_RESOLVE_RUNNING;
+        const char* hostname = request->hostname; // Only freed by this thread while running
+        TcsFamily family = request->family;
+        tcs_os_mutex_unlock(resolver->lock);
+
+        struct TcsAddress addresses[TCS_CFG_RESOLVER_ADDRESSES_MAX];
+        size_t address_count = 0;
+        TcsResult res = tcs_address_resolve(
+            hostname, family, addresses, TCS_CFG_RESOLVER_ADDRESSES_MAX, &address_count);
+
+        tcs_os_mutex_lock(resolver->lock);
+        request = &resolver->requests.data[index]; // The list may have grown
+        if (request->state == TCS_RESOLVE_CANCELLED)
+        {
+            resolver_request_free(resolver, index);
+            tcs_os_mutex_unlock(resolver->lock);
+            continue;
+        }
+        request->state = TCS_RESOLVE_DONE;
+        request->result = res;
+        request->address_count = res == TCS_SUCCESS ? address_count : 0;
+        memcpy(request->addresses, addresses, request->address_count * sizeof(struct TcsAddress));
+        bool was_done_empty = resolver->done_head == RESOLVER_END;
+        resolver_list_append(resolver, &resolver->done_head, &resolver->done_tail, index);
+        resolver_wakeup_update(resolver, was_done_empty);
+        tcs_os_mutex_unlock(resolver->lock);
+    }
+    tcs_os_mutex_unlock(resolver->lock);
+}
+
+// Stops and joins the started threads and frees everything that was created
+static void resolver_free(struct TcsResolver* resolver)
+{
+    if (resolver->thread_count > 0)
+    {
+        tcs_os_mutex_lock(resolver->lock);
+        resolver->is_stopping = true;
+        tcs_os_mutex_unlock(resolver->lock);
+        for (size_t i = 0; i < resolver->thread_count; ++i)
+            tcs_os_semaphore_post(resolver->has_pending);
+        for (size_t i = 0; i < resolver->thread_count; ++i)
+            tcs_os_thread_join(&resolver->threads[i]);
     }
 
-    free(adapters);
-    return TCS_SUCCESS;
+    for (size_t i = 0; i < resolver->requests.count; ++i)
+        tcs_lib_free(resolver->requests.data[i].hostname);
+    tds_ulist_resolve_request_destroy(&resolver->requests);
+    tcs_lib_free(resolver->threads);
+    if (resolver->wakeup != NULL)
+        tcs_os_wakeup_destroy(&resolver->wakeup);
+    if (resolver->has_pending != NULL)
+        tcs_os_semaphore_destroy(&resolver->has_pending);
+    if (resolver->lock != NULL)
+        tcs_os_mutex_destroy(&resolver->lock);
+    tcs_lib_free(resolver);
 }
 
-TcsResult tcs_address_socket_local(TcsSocket socket, struct TcsAddress* local_address)
+TcsResult tcs_resolver_create(struct TcsResolver** out_resolver, size_t thread_count)
 {
-    if (socket == TCS_SOCKET_INVALID || local_address == NULL)
+    if (out_resolver == NULL || *out_resolver != NULL || thread_count == 0)
         return TCS_ERROR_INVALID_ARGUMENT;
 
-    SOCKADDR_STORAGE native_sockaddr;
-    memset(&native_sockaddr, 0, sizeof native_sockaddr);
-    int addrlen = sizeof native_sockaddr;
-    if (getsockname((SOCKET)socket, (PSOCKADDR)&native_sockaddr, &addrlen) != 0)
-        return wsaerror2retcode(WSAGetLastError());
+    struct TcsResolver* resolver = (struct TcsResolver*)tcs_lib_malloc(sizeof(struct TcsResolver));
+    if (resolver == NULL)
+        return TCS_ERROR_MEMORY;
+    memset(resolver, 0, sizeof(struct TcsResolver));
+    resolver->free_head = RESOLVER_END;
+    resolver->pending_head = RESOLVER_END;
+    resolver->pending_tail = RESOLVER_END;
+    resolver->done_head = RESOLVER_END;
+    resolver->done_tail = RESOLVER_END;
+
+    TcsResult res = tcs_os_mutex_create(&resolver->lock);
+    if (res == TCS_SUCCESS)
+        res = tcs_os_semaphore_create(&resolver->has_pending);
+    if (res == TCS_SUCCESS)
+        res = tcs_os_wakeup_create(&resolver->wakeup);
+    if (res == TCS_SUCCESS)
+    {
+        resolver->threads = (struct TcsOsThread**)tcs_lib_malloc(thread_count * sizeof(struct TcsOsThread*));
+        if (resolver->threads == NULL || tds_ulist_resolve_request_create(&resolver->requests) != 0)
+            res = TCS_ERROR_MEMORY;
+    }
+    for (size_t i = 0; i < thread_count && res == TCS_SUCCESS; ++i)
+    {
+        res = tcs_os_thread_create(&resolver->threads[i], resolver_thread, resolver);
+        if (res == TCS_SUCCESS)
+            resolver->thread_count++;
+    }
+    if (res != TCS_SUCCESS)
+    {
+        resolver_free(resolver);
+        return res;
+    }
 
-    return native2sockaddr((PSOCKADDR)&native_sockaddr, local_address);
+    *out_resolver = resolver;
+    return TCS_SUCCESS;
 }
 
-TcsResult tcs_address_socket_remote(TcsSocket socket, struct TcsAddress* remote_address)
+TcsResult tcs_resolver_destroy(struct TcsResolver** resolver)
 {
-    if (socket == TCS_SOCKET_INVALID || remote_address == NULL)
+    if (resolver == NULL || *resolver == NULL)
         return TCS_ERROR_INVALID_ARGUMENT;
-
-    SOCKADDR_STORAGE native_sockaddr;
-    memset(&native_sockaddr, 0, sizeof native_sockaddr);
-    int addrlen = sizeof native_sockaddr;
-    if (getpeername((SOCKET)socket, (PSOCKADDR)&native_sockaddr, &addrlen) != 0)
-        return wsaerror2retcode(WSAGetLastError());
-
-    return native2sockaddr((PSOCKADDR)&native_sockaddr, remote_address);
+    resolver_free(*resolver);
+    *resolver = NULL;
+    return TCS_SUCCESS;
 }
 
-TcsResult tcs_address_socket_family(TcsSocket socket, TcsFamily* out_family)
+TcsResult tcs_resolver_socket(struct TcsResolver* resolver, TcsSocket* out_socket)
 {
-    if (socket == TCS_SOCKET_INVALID || out_family == NULL)
+    if (resolver == NULL || out_socket == NULL)
         return TCS_ERROR_INVALID_ARGUMENT;
-
-    WSAPROTOCOL_INFOW info;
-    memset(&info, 0, sizeof info);
-    int info_size = sizeof info;
-    if (getsockopt((SOCKET)socket, SOL_SOCKET, SO_PROTOCOL_INFOW, (char*)&info, &info_size) != 0)
-        return wsaerror2retcode(WSAGetLastError());
-
-    out_family->native = (int)info.iAddressFamily;
+    *out_socket = tcs_os_wakeup_socket(resolver->wakeup);
     return TCS_SUCCESS;
 }
 
-// tcs_address_parse() is defined in tinycsocket_common.c
-// tcs_address_to_str() is defined in tinycsocket_common.c
-// tcs_address_is_equal() is defined in tinycsocket_common.c
-// tcs_address_is_any() is defined in tinycsocket_common.c
-// tcs_address_is_link_local() is defined in tinycsocket_common.c
-// tcs_address_is_loopback() is defined in tinycsocket_common.c
-// tcs_address_is_multicast() is defined in tinycsocket_common.c
-// tcs_address_is_broadcast() is defined in tinycsocket_common.c
-
-#endif
-
-/**********************************/
-/****** tinycsocket_common.h ******/
-/**********************************/
-/*
- * Copyright 2018 Markus Lindelöw
- *
- * Permission is hereby granted, free of charge, to any person obtaining a copy
- * of this software and associated documentation files(the "Software"), to deal
- * in the Software without restriction, including without limitation the rights
- * to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
- * copies of the Software, and to permit persons to whom the Software is
- * furnished to do so, subject to the following conditions:
- *
- * The above copyright notice and this permission notice shall be included in all
- * copies or substantial portions of the Software.
- *
- * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
- * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
- * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
- * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
- * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
- * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
- * SOFTWARE.
- */
-#ifndef TINYCSOCKET_INTERNAL_H_
-#include "tinycsocket_internal.h"
-#endif
-
-// This file should never call OS dependent code. Do not include OS files of OS specific ifdefs
-
-#ifdef DO_WRAP
-#include "dbg_wrap.h"
-#endif
-
-#include <stdbool.h>
-#include <stdio.h>  //sprintf
-#include <stdlib.h> // malloc, free
-#include <string.h> // memset
-
-const char* const TCS_LICENSE_TXT =
-    "Copyright 2018 Markus Lindelöw\n"
-    "\n"
-    "Permission is hereby granted, free of charge, to any person obtaining a copy "
-    "of this software and associated documentation files(the \"Software\"), to deal "
-    "in the Software without restriction, including without limitation the rights "
-    "to use, copy, modify, merge, publish, distribute, sublicense, and / or sell "
-    "copies of the Software, and to permit persons to whom the Software is "
-    "furnished to do so, subject to the following conditions:\n"
-    "\n"
-    "The above copyright notice and this permission notice shall be included in all "
-    "copies or substantial portions of the Software.\n"
-    "\n"
-    "THE SOFTWARE IS PROVIDED \"AS IS\", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR "
-    "IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, "
-    "FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE "
-    "AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER "
-    "LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, "
-    "OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE "
-    "SOFTWARE.";
-
-// ######## Library Management ########
+TcsResult tcs_resolver_submit(struct TcsResolver* resolver,
+                              const char* hostname,
+                              TcsFamily address_family,
+                              size_t* out_handle)
+{
+    if (resolver == NULL || hostname == NULL || out_handle == NULL)
+        return TCS_ERROR_INVALID_ARGUMENT;
+    if (address_family.native == -1) // sentinel for unsupported families (e.g. TCS_FAMILY_PACKET on Windows)
+        return TCS_ERROR_NOT_SUPPORTED;
 
-// tcs_lib_init() is defined in OS specific files
-// tcs_lib_cleanup() is defined in OS specific files
+    size_t hostname_size = strlen(hostname) + 1;
+    char* hostname_copy = (char*)tcs_lib_malloc(hostname_size);
+    if (hostname_copy == NULL)
+        return TCS_ERROR_MEMORY;
+    memcpy(hostname_copy, hostname, hostname_size);
 
-const char* tcs_strerror(TcsResult result)
-{
-    switch (result)
+    tcs_os_mutex_lock(resolver->lock);
+    size_t index = resolver->free_head;
+    if (index == RESOLVER_END)
     {
-        case TCS_SUCCESS:
-            return "Success";
-        case TCS_AGAIN:
-            return "Try again";
-        case TCS_IN_PROGRESS:
-            return "Operation in progress";
-        case TCS_SHUTDOWN:
-            return "Socket shutdown";
-        case TCS_ERROR_UNKNOWN:
-            return "Unknown error";
-        case TCS_ERROR_MEMORY:
-            return "Out of memory";
-        case TCS_ERROR_INVALID_ARGUMENT:
-            return "Invalid argument";
-        case TCS_ERROR_SYSTEM:
-            return "System error";
-        case TCS_ERROR_PERMISSION_DENIED:
-            return "Permission denied";
-        case TCS_ERROR_NOT_IMPLEMENTED:
-            return "Not implemented";
-        case TCS_ERROR_NOT_SUPPORTED:
-            return "Not supported";
-        case TCS_ERROR_ADDRESS_LOOKUP_FAILED:
-            return "Address lookup failed";
-        case TCS_ERROR_CONNECTION_REFUSED:
-            return "Connection refused";
-        case TCS_ERROR_NOT_CONNECTED:
-            return "Not connected";
-        case TCS_ERROR_SOCKET_CLOSED:
-            return "Socket closed";
-        case TCS_ERROR_WOULD_BLOCK:
-            return "Operation would block";
-        case TCS_ERROR_TIMED_OUT:
-            return "Timed out";
-        case TCS_ERROR_TEMPORARY_FAILURE:
-            return "Temporary failure";
-        case TCS_ERROR_NETWORK_UNREACHABLE:
-            return "Network unreachable";
-        case TCS_ERROR_CONNECTION_RESET:
-            return "Connection reset";
-        case TCS_ERROR_ADDRESS_IN_USE:
-            return "Address in use";
-        case TCS_ERROR_LIBRARY_NOT_INITIALIZED:
-            return "Library not initialized";
-        case TCS_ERROR_ILL_FORMED_MESSAGE:
-            return "Ill-formed message";
+        struct TcsResolveRequest new_request;
+        memset(&new_request, 0, sizeof(new_request));
+        if (resolver->requests.count > RESOLVER_HANDLE_MASK ||
+            tds_ulist_resolve_request_add(&resolver->requests, &new_request, 1) != 0)
+        {
+            tcs_os_mutex_unlock(resolver->lock);
+            tcs_lib_free(hostname_copy);
+            return TCS_ERROR_MEMORY;
+        }
+        index = resolver->requests.count - 1;
     }
-    return "Unknown TcsResult";
+    else
+    {
+        resolver->free_head = resolver->requests.data[index].next;
+    }
+    struct TcsResolveRequest* request = &resolver->requests.data[index];
+    request->hostname = hostname_copy;
+    request->family = address_family;
+    request->state = TCS_RESOLVE_PENDING;
+    resolver_list_append(resolver, &resolver->pending_head, &resolver->pending_tail, index);
+    *out_handle = resolver_handle(resolver, index);
+    tcs_os_mutex_unlock(resolver->lock);
+    tcs_os_semaphore_post(resolver->has_pending);
+    return TCS_SUCCESS;
 }
 
-// ######## Socket Creation ########
-
-// tcs_socket() is defined in OS specific files
-
-TcsResult tcs_socket_tcp(TcsSocket* out_socket,
-                         const struct TcsAddress* local_address,
-                         const struct TcsAddress* remote_address,
-                         int timeout_ms)
+TcsResult tcs_resolver_take(struct TcsResolver* resolver,
+                            size_t* out_handle,
+                            TcsResult* out_result,
+                            struct TcsAddress out_addresses[],
+                            size_t addresses_length,
+                            size_t* out_length)
 {
-    if (out_socket == NULL || *out_socket != TCS_SOCKET_INVALID)
-        return TCS_ERROR_INVALID_ARGUMENT;
-    if (local_address == NULL && remote_address == NULL)
+    if (resolver == NULL || out_handle == NULL || out_result == NULL)
         return TCS_ERROR_INVALID_ARGUMENT;
-    if (local_address != NULL && remote_address != NULL &&
-        local_address->family.native != remote_address->family.native)
-        return TCS_ERROR_INVALID_ARGUMENT;
-    if (timeout_ms < 0 && timeout_ms != TCS_WAIT_INF)
-        return TCS_ERROR_INVALID_ARGUMENT;
-
-    TcsFamily family = local_address != NULL ? local_address->family : remote_address->family;
+    if (out_length != NULL)
+        *out_length = 0;
 
-    TcsResult res = tcs_socket(out_socket, family, TCS_SOCKET_STREAM, TCS_PROTOCOL_IP_TCP);
-    if (res != TCS_SUCCESS)
-        return res;
+    tcs_os_mutex_lock(resolver->lock);
+    size_t index = resolver->done_head;
+    if (index == RESOLVER_END)
+    {
+        tcs_os_mutex_unlock(resolver->lock);
+        return TCS_AGAIN;
+    }
+    resolver_list_unlink(resolver, &resolver->done_head, &resolver->done_tail, index);
+    resolver_wakeup_update(resolver, false);
 
-    if (local_address != NULL)
+    const struct TcsResolveRequest* request = &resolver->requests.data[index];
+    size_t address_count = request->address_count;
+    if (out_addresses != NULL)
     {
-        res = tcs_opt_reuse_address_set(*out_socket, true);
-        if (res != TCS_SUCCESS)
-        {
-            tcs_close(out_socket);
-            return res;
-        }
-        res = tcs_bind(*out_socket, local_address);
-        if (res != TCS_SUCCESS)
-        {
-            tcs_close(out_socket);
-            return res;
-        }
+        if (address_count > addresses_length)
+            address_count = addresses_length;
+        memcpy(out_addresses, request->addresses, address_count * sizeof(struct TcsAddress));
     }
+    if (out_length != NULL)
+        *out_length = address_count;
+    *out_handle = resolver_handle(resolver, index);
+    *out_result = request->result;
+    resolver_request_free(resolver, index);
+    tcs_os_mutex_unlock(resolver->lock);
+    return TCS_SUCCESS;
+}
 
-    if (remote_address != NULL)
+TcsResult tcs_resolver_cancel(struct TcsResolver* resolver, size_t handle)
+{
+    if (resolver == NULL)
+        return TCS_ERROR_INVALID_ARGUMENT;
+
+    tcs_os_mutex_lock(resolver->lock);
+    size_t index = resolver_handle_index(resolver, handle);
+    if (index == RESOLVER_END || resolver->requests.data[index].state == TCS_RESOLVE_FREE ||
+        resolver->requests.data[index].state == TCS_RESOLVE_CANCELLED)
     {
-        if (timeout_ms == TCS_WAIT_INF)
-        {
-            res = tcs_connect(*out_socket, remote_address);
-            if (res != TCS_SUCCESS)
-            {
-                tcs_close(out_socket);
-                return res;
-            }
-        }
-        else
-        {
-            res = tcs_opt_nonblocking_set(*out_socket, true);
-            if (res != TCS_SUCCESS)
-            {
-                tcs_close(out_socket);
-                return res;
-            }
-            res = tcs_connect(*out_socket, remote_address);
-            if (res != TCS_IN_PROGRESS && res != TCS_SUCCESS)
-            {
-                tcs_close(out_socket);
-                return res;
-            }
-            if (res == TCS_IN_PROGRESS)
-            {
-                struct TcsPoll* poll = NULL;
-                res = tcs_poll_create(&poll);
-                if (res != TCS_SUCCESS)
-                {
-                    tcs_close(out_socket);
-                    return res;
-                }
-                res = tcs_poll_add(poll, *out_socket, NULL, TCS_POLL_WRITE);
-                if (res != TCS_SUCCESS)
-                {
-                    tcs_poll_destroy(&poll);
-                    tcs_close(out_socket);
-                    return res;
-                }
-                struct TcsPollEvent event = TCS_POLL_EVENT_EMPTY;
-                size_t out_events_length = 0;
-                res = tcs_poll_wait(poll, &event, 1, &out_events_length, timeout_ms);
-                tcs_poll_destroy(&poll);
-                if (res == TCS_ERROR_TIMED_OUT)
-                {
-                    tcs_close(out_socket);
-                    return TCS_ERROR_TIMED_OUT;
-                }
-                if (res != TCS_SUCCESS || out_events_length == 0)
-                {
-                    tcs_close(out_socket);
-                    return res != TCS_SUCCESS ? res : TCS_ERROR_UNKNOWN;
-                }
-                if (event.error != TCS_SUCCESS)
-                {
-                    tcs_close(out_socket);
-                    return TCS_ERROR_CONNECTION_REFUSED;
-                }
-            }
-            res = tcs_opt_nonblocking_set(*out_socket, false);
-            if (res != TCS_SUCCESS)
-            {
-                tcs_close(out_socket);
-                return res;
-            }
-        }
+        tcs_os_mutex_unlock(resolver->lock);
+        return TCS_ERROR_INVALID_ARGUMENT;
     }
-
+    struct TcsResolveRequest* request = &resolver->requests.data[index];
+    if (request->state == TCS_RESOLVE_PENDING)
+    {
+        resolver_list_unlink(resolver, &resolver->pending_head, &resolver->pending_tail, index);
+        resolver_request_free(resolver, index);
+    }
+    else if (request->state == TCS_RESOLVE_DONE)
+    {
+        resolver_list_unlink(resolver, &resolver->done_head, &resolver->done_tail, index);
+        resolver_wakeup_update(resolver, false);
+        resolver_request_free(resolver, index);
+    }
+    else
+    {
+        request->state = TCS_RESOLVE_CANCELLED;
+    }
+    tcs_os_mutex_unlock(resolver->lock);
     return TCS_SUCCESS;
 }
 
-TcsResult tcs_socket_tcp_str(TcsSocket* out_socket,
-                             const char* local_address,
-                             const char* remote_address,
-                             int timeout_ms)
+// ######## DNS Stub Resolver ########
+
+// RFC 1035 wire format
+#define TCS_DNS_HEADER_SIZE 12
+#define TCS_DNS_NAME_MAX 255  // Encoded name including the root label
+#define TCS_DNS_LABEL_MAX 63  // Longest label
+#define TCS_DNS_UDP_MAX 512   // Largest answer over UDP without EDNS
+#define TCS_DNS_TCP_MAX 65535 // TCP messages have a 16 bit length prefix
+#define TCS_DNS_FLAG_QR 0x8000
+#define TCS_DNS_FLAG_TC 0x0200
+#define TCS_DNS_FLAG_RD 0x0100
+#define TCS_DNS_RCODE_MASK 0x000F
+#define TCS_DNS_RCODE_NXDOMAIN 3
+#define TCS_DNS_TYPE_A 1
+#define TCS_DNS_TYPE_AAAA 28
+#define TCS_DNS_CLASS_IN 1
+
+enum TcsDnsQueryState
+{
+    TCS_DNS_QUERY_UNUSED,
+    TCS_DNS_QUERY_UDP,         // Waiting for a datagram, sent again on timeout
+    TCS_DNS_QUERY_TCP_SEND,    // Connecting or sending after a truncated answer
+    TCS_DNS_QUERY_TCP_RECEIVE, // Waiting for the length prefixed answer
+    TCS_DNS_QUERY_DONE,
+};
+
+// The query and then the answer, both with the length prefix
+struct TcsDnsTcpBuffer
 {
-    if (out_socket == NULL || *out_socket != TCS_SOCKET_INVALID)
-        return TCS_ERROR_INVALID_ARGUMENT;
-    if (local_address == NULL && remote_address == NULL)
-        return TCS_ERROR_INVALID_ARGUMENT;
+    uint8_t bytes[2 + TCS_DNS_TCP_MAX];
+};
 
-    struct TcsAddress local_addr = TCS_ADDRESS_NONE;
-    struct TcsAddress remote_addr = TCS_ADDRESS_NONE;
-    TcsFamily family = TCS_FAMILY_ANY;
+#ifndef TDS_POOL_dns_tcp_buffer
+#define TDS_POOL_dns_tcp_buffer
+TDS_POOL_IMPL(struct TcsDnsTcpBuffer, dns_tcp_buffer)
+#endif
 
-    if (local_address != NULL)
-    {
-        size_t count = 0;
-        TcsResult res = tcs_address_resolve(local_address, TCS_FAMILY_ANY, &local_addr, 1, &count);
-        if (res != TCS_SUCCESS)
-            return res;
-        if (count == 0)
-            return TCS_ERROR_ADDRESS_LOOKUP_FAILED;
-        family = local_addr.family;
-    }
+struct TcsDnsQuery
+{
+    enum TcsDnsQueryState state;
+    uint16_t id;
+    uint16_t type;
+    size_t nameserver; // Index of the nameserver asked last
+    int sent_count;
+    int64_t deadline_ms;
+    TcsResult result;
+    size_t address_count;
+    struct TcsAddress addresses[TCS_CFG_DNS_ADDRESSES_MAX];
+    TcsSocket socket; // UDP or TCP, a new socket per attempt gets a new random source port
+    struct TcsDnsTcpBuffer* tcp_buffer;
+    size_t tcp_length;
+    size_t tcp_done;
+};
 
-    if (remote_address != NULL)
+enum TcsDnsLookupState
+{
+    TCS_DNS_LOOKUP_FREE,
+    TCS_DNS_LOOKUP_ACTIVE,
+    TCS_DNS_LOOKUP_DONE,
+};
+
+struct TcsDnsLookup
+{
+    enum TcsDnsLookupState state;
+    uint8_t name[TCS_DNS_NAME_MAX];
+    size_t name_length;
+    struct TcsDnsQuery queries[2]; // AAAA and A, addresses are returned in this order
+    size_t next;                   // Next lookup in the free or done list
+    size_t generation;             // Bumped when the slot is freed so handles of earlier lookups no longer match
+};
+
+struct TcsDnsHost
+{
+    char name[TCS_DNS_NAME_MAX + 1];
+    struct TcsAddress address;
+};
+
+#ifndef TDS_ULIST_dns_lookup
+#define TDS_ULIST_dns_lookup
+TDS_ULIST_IMPL(struct TcsDnsLookup, dns_lookup)
+#endif
+
+#ifndef TDS_ULIST_dns_host
+#define TDS_ULIST_dns_host
+TDS_ULIST_IMPL(struct TcsDnsHost, dns_host)
+#endif
+
+static uint64_t dns_socket_hash(const TcsSocket* socket, uint64_t seed)
+{
+    uint64_t x = (uint64_t)*socket ^ seed;
+    x *= 0x9E3779B97F4A7C15ULL;
+    return x ^ (x >> 29);
+}
+
+static bool dns_socket_is_equal(const TcsSocket* l, const TcsSocket* r)
+{
+    return *l == *r;
+}
+
+// Socket of a query to lookup index * 2 + query index
+TDS_HMAP_IMPL(TcsSocket, size_t, dns_socket, dns_socket_hash, dns_socket_is_equal)
+
+struct TcsDns
+{
+    struct TcsPoll* poll;
+    int attempt_timeout_ms;
+    int attempts;
+    size_t nameservers_length;
+    struct TcsAddress nameservers[TCS_CFG_DNS_NAMESERVERS_MAX];
+    struct TdsUList_dns_host hosts;
+    struct TdsUList_dns_lookup lookups; // Lookups are reused but never moved between slots
+    struct TdsHMap_dns_socket query_by_socket;
+    uint32_t random_state;
+    size_t in_flight;                          // Queries waiting for an answer
+    struct TdsPool_dns_tcp_buffer tcp_buffers; // Reused by later TCP queries instead of a 64 KiB malloc() each
+    int64_t next_deadline_ms;
+    size_t free_head;
+    size_t done_head;
+    size_t done_tail;
+};
+
+// End of the free and done lists
+static const size_t DNS_END = (size_t)-1;
+
+// A handle is the slot index in the low half and the slot generation in the high half, as for TcsResolver
+#define DNS_HANDLE_SHIFT (sizeof(size_t) * 4)
+static const size_t DNS_HANDLE_MASK = ((size_t)1 << DNS_HANDLE_SHIFT) - 1;
+
+static size_t dns_handle(const struct TcsDns* dns, size_t index)
+{
+    return index | (dns->lookups.data[index].generation << DNS_HANDLE_SHIFT);
+}
+
+// Returns the slot of a handle, or DNS_END for handles of lookups that were already taken or cancelled
+static size_t dns_handle_index(const struct TcsDns* dns, size_t handle)
+{
+    size_t index = handle & DNS_HANDLE_MASK;
+    if (index >= dns->lookups.count || dns->lookups.data[index].state == TCS_DNS_LOOKUP_FREE)
+        return DNS_END;
+    if (dns->lookups.data[index].generation != handle >> DNS_HANDLE_SHIFT)
+        return DNS_END;
+    return index;
+}
+
+// xorshift32 seeded from the OS entropy source. An off-path attacker has to guess the id and the source port.
+static uint16_t dns_id_random(struct TcsDns* dns)
+{
+    uint32_t x = dns->random_state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    dns->random_state = x;
+    return (uint16_t)(x >> 8);
+}
+
+static char dns_fold(char c)
+{
+    return (c >= 'A' && c <= 'Z') ? (char)(c - 'A' + 'a') : c;
+}
+
+static bool dns_hostname_is_equal(const char* l, const char* r)
+{
+    while (*l != '\0' && dns_fold(*l) == dns_fold(*r))
     {
-        size_t count = 0;
-        TcsResult res = tcs_address_resolve(remote_address, family, &remote_addr, 1, &count);
-        if (res != TCS_SUCCESS)
-            return res;
-        if (count == 0)
-            return TCS_ERROR_ADDRESS_LOOKUP_FAILED;
+        ++l;
+        ++r;
     }
-
-    return tcs_socket_tcp(out_socket,
-                          local_address != NULL ? &local_addr : NULL,
-                          remote_address != NULL ? &remote_addr : NULL,
-                          timeout_ms);
+    return dns_fold(*l) == dns_fold(*r);
 }
 
-TcsResult tcs_socket_udp(TcsSocket* out_socket,
-                         const struct TcsAddress* local_address,
-                         const struct TcsAddress* remote_address)
+static uint16_t dns_read_u16(const uint8_t* bytes)
 {
-    if (out_socket == NULL || *out_socket != TCS_SOCKET_INVALID)
-        return TCS_ERROR_INVALID_ARGUMENT;
-    if (local_address == NULL && remote_address == NULL)
-        return TCS_ERROR_INVALID_ARGUMENT;
-    if (local_address != NULL && remote_address != NULL &&
-        local_address->family.native != remote_address->family.native)
-        return TCS_ERROR_INVALID_ARGUMENT;
+    return (uint16_t)((bytes[0] << 8) | bytes[1]);
+}
 
-    TcsFamily family = local_address != NULL ? local_address->family : remote_address->family;
+static void dns_write_u16(uint8_t* bytes, uint16_t value)
+{
+    bytes[0] = (uint8_t)(value >> 8);
+    bytes[1] = (uint8_t)(value & 0xFF);
+}
 
-    TcsResult res = tcs_socket(out_socket, family, TCS_SOCKET_DGRAM, TCS_PROTOCOL_IP_UDP);
-    if (res != TCS_SUCCESS)
-        return res;
+// "example.com" to 7example3com0, a trailing dot is allowed
+static TcsResult dns_name_encode(const char* hostname, uint8_t out_name[TCS_DNS_NAME_MAX], size_t* out_length)
+{
+    size_t length = 0;
+    const char* label = hostname;
+    if (*label == '\0')
+        return TCS_ERROR_INVALID_ARGUMENT;
+    while (*label != '\0')
+    {
+        const char* end = label;
+        while (*end != '\0' && *end != '.')
+            ++end;
+        size_t label_length = (size_t)(end - label);
+        if (label_length == 0 || label_length > TCS_DNS_LABEL_MAX || length + label_length + 2 > TCS_DNS_NAME_MAX)
+            return TCS_ERROR_INVALID_ARGUMENT;
+        out_name[length++] = (uint8_t)label_length;
+        memcpy(out_name + length, label, label_length);
+        length += label_length;
+        label = *end == '.' ? end + 1 : end;
+    }
+    out_name[length++] = 0;
+    *out_length = length;
+    return TCS_SUCCESS;
+}
 
-    if (local_address != NULL)
+// Skips a possibly compressed name, the target of a compression pointer is never needed
+static bool dns_name_skip(const uint8_t* message, size_t length, size_t* offset)
+{
+    size_t position = *offset;
+    while (position < length)
     {
-        res = tcs_opt_reuse_address_set(*out_socket, true);
-        if (res != TCS_SUCCESS)
+        uint8_t label_length = message[position];
+        if (label_length == 0)
         {
-            tcs_close(out_socket);
-            return res;
+            *offset = position + 1;
+            return true;
         }
-        res = tcs_bind(*out_socket, local_address);
-        if (res != TCS_SUCCESS)
+        if ((label_length & 0xC0) == 0xC0)
         {
-            tcs_close(out_socket);
-            return res;
+            if (position + 2 > length)
+                return false;
+            *offset = position + 2;
+            return true;
         }
+        if ((label_length & 0xC0) != 0)
+            return false;
+        position += 1u + label_length;
     }
+    return false;
+}
 
-    if (remote_address != NULL)
+static size_t dns_query_build(const struct TcsDnsLookup* lookup, const struct TcsDnsQuery* query, uint8_t* out_message)
+{
+    memset(out_message, 0, TCS_DNS_HEADER_SIZE);
+    dns_write_u16(out_message, query->id);
+    dns_write_u16(out_message + 2, TCS_DNS_FLAG_RD);
+    dns_write_u16(out_message + 4, 1); // QDCOUNT
+    memcpy(out_message + TCS_DNS_HEADER_SIZE, lookup->name, lookup->name_length);
+    size_t length = TCS_DNS_HEADER_SIZE + lookup->name_length;
+    dns_write_u16(out_message + length, query->type);
+    dns_write_u16(out_message + length + 2, TCS_DNS_CLASS_IN);
+    return length + 4;
+}
+
+// Fills the query with the addresses of an answer. Returns TCS_ERROR_ILL_FORMED_MESSAGE for messages that do not
+// answer this query, they are ignored. TCS_ERROR_TEMPORARY_FAILURE means that another nameserver may do better, or
+// with out_is_truncated that the answer did not fit.
+static TcsResult dns_answer_parse(const uint8_t* message,
+                                  size_t length,
+                                  const struct TcsDnsLookup* lookup,
+                                  struct TcsDnsQuery* query,
+                                  bool* out_is_truncated)
+{
+    *out_is_truncated = false;
+    if (length < TCS_DNS_HEADER_SIZE + lookup->name_length + 4)
+        return TCS_ERROR_ILL_FORMED_MESSAGE;
+    uint16_t flags = dns_read_u16(message + 2);
+    if (dns_read_u16(message) != query->id || (flags & TCS_DNS_FLAG_QR) == 0 || dns_read_u16(message + 4) != 1)
+        return TCS_ERROR_ILL_FORMED_MESSAGE;
+
+    // The question must be ours, names compare case insensitively
+    const uint8_t* question = message + TCS_DNS_HEADER_SIZE;
+    for (size_t i = 0; i < lookup->name_length; ++i)
     {
-        bool is_multicast = tcs_address_is_multicast(remote_address);
+        if (dns_fold((char)question[i]) != dns_fold((char)lookup->name[i]))
+            return TCS_ERROR_ILL_FORMED_MESSAGE;
+    }
+    if (dns_read_u16(question + lookup->name_length) != query->type ||
+        dns_read_u16(question + lookup->name_length + 2) != TCS_DNS_CLASS_IN)
+        return TCS_ERROR_ILL_FORMED_MESSAGE;
 
-        if (is_multicast)
+    if (flags & TCS_DNS_FLAG_TC)
+    {
+        *out_is_truncated = true;
+        return TCS_ERROR_TEMPORARY_FAILURE;
+    }
+    uint16_t rcode = (uint16_t)(flags & TCS_DNS_RCODE_MASK);
+    if (rcode == TCS_DNS_RCODE_NXDOMAIN)
+        return TCS_ERROR_ADDRESS_LOOKUP_FAILED;
+    if (rcode != 0)
+        return TCS_ERROR_TEMPORARY_FAILURE;
+
+    // Records of other types, e.g. the CNAME chain leading to the addresses, are skipped
+    uint16_t answer_count = dns_read_u16(message + 6);
+    size_t offset = TCS_DNS_HEADER_SIZE + lookup->name_length + 4;
+    query->address_count = 0;
+    for (uint16_t i = 0; i < answer_count; ++i)
+    {
+        if (!dns_name_skip(message, length, &offset) || offset + 10 > length)
+            return TCS_ERROR_ILL_FORMED_MESSAGE;
+        uint16_t type = dns_read_u16(message + offset);
+        uint16_t class_ = dns_read_u16(message + offset + 2);
+        uint16_t data_length = dns_read_u16(message + offset + 8);
+        offset += 10;
+        if (offset + data_length > length)
+            return TCS_ERROR_ILL_FORMED_MESSAGE;
+        if (class_ == TCS_DNS_CLASS_IN && type == query->type && query->address_count < TCS_CFG_DNS_ADDRESSES_MAX)
         {
-            res = tcs_opt_membership_add(*out_socket, remote_address);
-            if (res != TCS_SUCCESS)
+            struct TcsAddress* address = &query->addresses[query->address_count];
+            *address = TCS_ADDRESS_NONE;
+            if (type == TCS_DNS_TYPE_A && data_length == 4)
             {
-                tcs_close(out_socket);
-                return res;
+                address->family = TCS_FAMILY_IPV4;
+                address->data.ipv4.address = ((uint32_t)message[offset] << 24) |
+                                             ((uint32_t)message[offset + 1] << 16) |
+                                             ((uint32_t)message[offset + 2] << 8) | (uint32_t)message[offset + 3];
+                query->address_count++;
             }
-        }
-
-        if (!is_multicast || local_address == NULL)
-        {
-            res = tcs_connect(*out_socket, remote_address);
-            if (res != TCS_SUCCESS)
+            else if (type == TCS_DNS_TYPE_AAAA && data_length == 16)
             {
-                tcs_close(out_socket);
-                return res;
+                address->family = TCS_FAMILY_IPV6;
+                memcpy(address->data.ipv6.address.bytes, message + offset, 16);
+                query->address_count++;
             }
         }
+        offset += data_length;
     }
-
-    return TCS_SUCCESS;
+    return query->address_count > 0 ? TCS_SUCCESS : TCS_ERROR_ADDRESS_LOOKUP_FAILED;
 }
 
-TcsResult tcs_socket_udp_str(TcsSocket* out_socket, const char* local_address, const char* remote_address)
+static void dns_deadline_set(struct TcsDns* dns, struct TcsDnsQuery* query, int64_t now_ms)
 {
-    if (out_socket == NULL || *out_socket != TCS_SOCKET_INVALID)
-        return TCS_ERROR_INVALID_ARGUMENT;
-    if (local_address == NULL && remote_address == NULL)
-        return TCS_ERROR_INVALID_ARGUMENT;
+    query->deadline_ms = now_ms + dns->attempt_timeout_ms;
+    if (query->deadline_ms < dns->next_deadline_ms)
+        dns->next_deadline_ms = query->deadline_ms;
+}
 
-    struct TcsAddress local_addr = TCS_ADDRESS_NONE;
-    struct TcsAddress remote_addr = TCS_ADDRESS_NONE;
-    TcsFamily family = TCS_FAMILY_ANY;
+static void dns_query_socket_close(struct TcsDns* dns, struct TcsDnsQuery* query)
+{
+    if (query->socket == TCS_SOCKET_INVALID)
+        return;
+    tcs_poll_remove(dns->poll, query->socket);
+    tds_hmap_dns_socket_remove(&dns->query_by_socket, &query->socket);
+    tcs_close(&query->socket);
+}
 
-    if (local_address != NULL)
+// Opens a new socket to the nameserver of the query, the OS picks a random source port for it
+static TcsResult dns_query_socket_open(struct TcsDns* dns, size_t index, struct TcsDnsQuery* query, bool is_tcp)
+{
+    const struct TcsAddress* nameserver = &dns->nameservers[query->nameserver];
+    size_t slot = index * 2 + (size_t)(query - dns->lookups.data[index].queries);
+    TcsResult res = TCS_SUCCESS;
+    if (is_tcp)
     {
-        size_t count = 0;
-        TcsResult res = tcs_address_resolve(local_address, TCS_FAMILY_ANY, &local_addr, 1, &count);
-        if (res != TCS_SUCCESS)
-            return res;
-        if (count == 0)
-            return TCS_ERROR_ADDRESS_LOOKUP_FAILED;
-        family = local_addr.family;
+        res = connect_attempt_start(&query->socket, NULL, nameserver);
     }
-
-    if (remote_address != NULL)
+    else
     {
-        size_t count = 0;
-        TcsResult res = tcs_address_resolve(remote_address, family, &remote_addr, 1, &count);
-        if (res != TCS_SUCCESS)
-            return res;
-        if (count == 0)
-            return TCS_ERROR_ADDRESS_LOOKUP_FAILED;
+        res = tcs_socket_with_flags(&query->socket,
+                                    nameserver->family,
+                                    TCS_SOCKET_DGRAM,
+                                    TCS_PROTOCOL_IP_UDP,
+                                    TCS_SOCKET_FLAG_NONBLOCKING | TCS_SOCKET_FLAG_CLOEXEC);
+        if (res == TCS_SUCCESS)
+            res = tcs_connect(query->socket, nameserver);
     }
-
-    return tcs_socket_udp(
-        out_socket, local_address != NULL ? &local_addr : NULL, remote_address != NULL ? &remote_addr : NULL);
+    if (res == TCS_IN_PROGRESS)
+        res = TCS_SUCCESS;
+    if (res == TCS_SUCCESS)
+        res = tcs_poll_add(dns->poll, query->socket, dns, is_tcp ? TCS_POLL_WRITE : TCS_POLL_READ);
+    if (res == TCS_SUCCESS && tds_hmap_dns_socket_set(&dns->query_by_socket, &query->socket, &slot) != 0)
+    {
+        tcs_poll_remove(dns->poll, query->socket);
+        res = TCS_ERROR_MEMORY;
+    }
+    if (res != TCS_SUCCESS && query->socket != TCS_SOCKET_INVALID)
+        tcs_close(&query->socket);
+    return res;
 }
 
-TcsResult tcs_socket_packet(TcsSocket* out_socket, const struct TcsAddress* bind_address, TcsSocketType type)
+// Every attempt asks all nameservers in turn, from a new socket. Socket and send errors are left to the timeout.
+static void dns_query_send(struct TcsDns* dns, size_t index, struct TcsDnsQuery* query, int64_t now_ms)
 {
-    if (out_socket == NULL || *out_socket != TCS_SOCKET_INVALID)
-        return TCS_ERROR_INVALID_ARGUMENT;
-    if (bind_address == NULL)
-        return TCS_ERROR_INVALID_ARGUMENT;
-    if (bind_address->family.native != TCS_FAMILY_PACKET.native)
-        return TCS_ERROR_INVALID_ARGUMENT;
-    if (type.native != TCS_SOCKET_RAW.native && type.native != TCS_SOCKET_DGRAM.native)
-        return TCS_ERROR_INVALID_ARGUMENT;
+    dns_query_socket_close(dns, query);
+    query->nameserver = (size_t)query->sent_count % dns->nameservers_length;
+    query->sent_count++;
+    query->id = dns_id_random(dns);
+    dns_deadline_set(dns, query, now_ms);
+    if (dns_query_socket_open(dns, index, query, false) != TCS_SUCCESS)
+        return;
+    uint8_t message[TCS_DNS_HEADER_SIZE + TCS_DNS_NAME_MAX + 4];
+    size_t length = dns_query_build(&dns->lookups.data[index], query, message);
+    tcs_send(query->socket, message, length, TCS_FLAG_NONE, NULL);
+}
 
-    TcsResult res = tcs_socket(out_socket, TCS_FAMILY_PACKET, type, bind_address->data.packet.protocol);
-    if (res != TCS_SUCCESS)
-        return res;
+static bool dns_query_is_in_flight(const struct TcsDnsQuery* query)
+{
+    return query->state == TCS_DNS_QUERY_UDP || query->state == TCS_DNS_QUERY_TCP_SEND ||
+           query->state == TCS_DNS_QUERY_TCP_RECEIVE;
+}
 
-    res = tcs_bind(*out_socket, bind_address);
-    if (res != TCS_SUCCESS)
-    {
-        tcs_close(out_socket);
-        return res;
-    }
+// Releases the socket and the TCP buffer of a query that was in flight
+static void dns_query_stop(struct TcsDns* dns, struct TcsDnsQuery* query)
+{
+    dns->in_flight--;
+    dns_query_socket_close(dns, query);
+    if (query->tcp_buffer != NULL)
+        tds_pool_dns_tcp_buffer_free(&dns->tcp_buffers, query->tcp_buffer);
+    query->tcp_buffer = NULL;
+}
 
-    return TCS_SUCCESS;
+static void dns_lookup_done(struct TcsDns* dns, size_t index)
+{
+    struct TcsDnsLookup* lookup = &dns->lookups.data[index];
+    lookup->state = TCS_DNS_LOOKUP_DONE;
+    lookup->next = DNS_END;
+    if (dns->done_tail != DNS_END)
+        dns->lookups.data[dns->done_tail].next = index;
+    else
+        dns->done_head = index;
+    dns->done_tail = index;
 }
 
-TcsResult tcs_socket_packet_str(TcsSocket* out_socket,
-                                const char* interface_name,
-                                uint16_t protocol,
-                                TcsSocketType type)
+static void dns_query_finish(struct TcsDns* dns, size_t index, struct TcsDnsQuery* query, TcsResult result)
 {
-    if (out_socket == NULL || *out_socket != TCS_SOCKET_INVALID)
-        return TCS_ERROR_INVALID_ARGUMENT;
-    if (interface_name == NULL)
-        return TCS_ERROR_INVALID_ARGUMENT;
+    dns_query_stop(dns, query);
+    query->state = TCS_DNS_QUERY_DONE;
+    query->result = result;
+    if (result != TCS_SUCCESS)
+        query->address_count = 0;
+    const struct TcsDnsLookup* lookup = &dns->lookups.data[index];
+    if (!dns_query_is_in_flight(&lookup->queries[0]) && !dns_query_is_in_flight(&lookup->queries[1]))
+        dns_lookup_done(dns, index);
+}
 
-    struct TcsInterface stack_buf[16];
-    struct TcsInterface* interfaces = stack_buf;
-    size_t count = 0;
+// Handles a parsed answer, possibly by retrying with the next nameserver or over TCP. A truncated answer over TCP
+// fails the query, there is nothing larger to fall back to.
+static void dns_answer_handle(
+    struct TcsDns* dns, size_t index, struct TcsDnsQuery* query, TcsResult result, bool is_truncated, int64_t now_ms)
+{
+    const struct TcsDnsLookup* lookup = &dns->lookups.data[index];
+    if (is_truncated && query->state == TCS_DNS_QUERY_UDP)
+    {
+        query->tcp_buffer = tds_pool_dns_tcp_buffer_alloc(&dns->tcp_buffers);
+        if (query->tcp_buffer == NULL)
+        {
+            dns_query_finish(dns, index, query, TCS_ERROR_MEMORY);
+            return;
+        }
+        query->tcp_length = 2 + dns_query_build(lookup, query, query->tcp_buffer->bytes + 2);
+        dns_write_u16(query->tcp_buffer->bytes, (uint16_t)(query->tcp_length - 2));
+        query->tcp_done = 0;
+        dns_query_socket_close(dns, query);
+        TcsResult res = dns_query_socket_open(dns, index, query, true);
+        if (res != TCS_SUCCESS)
+        {
+            dns_query_finish(dns, index, query, res);
+            return;
+        }
+        query->state = TCS_DNS_QUERY_TCP_SEND;
+        dns_deadline_set(dns, query, now_ms);
+        return;
+    }
+    if (result == TCS_ERROR_TEMPORARY_FAILURE && query->state == TCS_DNS_QUERY_UDP &&
+        query->sent_count < dns->attempts * (int)dns->nameservers_length)
+    {
+        dns_query_send(dns, index, query, now_ms);
+        return;
+    }
+    dns_query_finish(dns, index, query, result);
+}
 
-    TcsResult res = tcs_interface_list(stack_buf, 16, &count);
-    if (res != TCS_SUCCESS)
-        return res;
+// Stops when the query leaves UDP or sends again from a new socket
+static void dns_udp_receive(struct TcsDns* dns, size_t index, struct TcsDnsQuery* query, int64_t now_ms)
+{
+    uint8_t message[TCS_DNS_UDP_MAX];
+    size_t received = 0;
+    TcsSocket socket = query->socket;
+    while (query->state == TCS_DNS_QUERY_UDP && query->socket == socket &&
+           tcs_receive(socket, message, sizeof(message), TCS_FLAG_NONE, &received) == TCS_SUCCESS)
+    {
+        bool is_truncated = false;
+        TcsResult res = dns_answer_parse(message, received, &dns->lookups.data[index], query, &is_truncated);
+        if (res != TCS_ERROR_ILL_FORMED_MESSAGE)
+            dns_answer_handle(dns, index, query, res, is_truncated, now_ms);
+    }
+}
 
-    size_t search_count = count < 16 ? count : 16;
-    for (size_t i = 0; i < search_count; ++i)
+static void dns_tcp_progress(struct TcsDns* dns,
+                             size_t index,
+                             struct TcsDnsQuery* query,
+                             const struct TcsPollEvent* event,
+                             int64_t now_ms)
+{
+    if (event->error != TCS_SUCCESS)
     {
-        if (strcmp(stack_buf[i].name, interface_name) == 0)
-        {
-            struct TcsAddress bind_address = TCS_ADDRESS_NONE;
-            bind_address.family = TCS_FAMILY_PACKET;
-            bind_address.data.packet.interface_id = stack_buf[i].id;
-            bind_address.data.packet.protocol = protocol;
-            return tcs_socket_packet(out_socket, &bind_address, type);
+        dns_query_finish(dns, index, query, event->error);
+        return;
+    }
+    if (query->state == TCS_DNS_QUERY_TCP_SEND && event->can_write)
+    {
+        size_t sent = 0;
+        TcsResult res = tcs_send(query->socket,
+                                 query->tcp_buffer->bytes + query->tcp_done,
+                                 query->tcp_length - query->tcp_done,
+                                 0,
+                                 &sent);
+        if (res != TCS_SUCCESS && res != TCS_ERROR_WOULD_BLOCK)
+        {
+            dns_query_finish(dns, index, query, res);
+            return;
+        }
+        query->tcp_done += sent;
+        if (query->tcp_done == query->tcp_length)
+        {
+            query->state = TCS_DNS_QUERY_TCP_RECEIVE;
+            query->tcp_done = 0;
+            tcs_poll_modify(dns->poll, query->socket, TCS_POLL_READ);
         }
+        return;
     }
-
-    if (count > 16)
+    while (query->state == TCS_DNS_QUERY_TCP_RECEIVE && event->can_read)
     {
-        interfaces = (struct TcsInterface*)malloc(count * sizeof(struct TcsInterface));
-        if (interfaces == NULL)
-            return TCS_ERROR_MEMORY;
-        res = tcs_interface_list(interfaces, count, &count);
-        if (res != TCS_SUCCESS)
+        size_t wanted = query->tcp_done < 2 ? 2 : 2 + (size_t)dns_read_u16(query->tcp_buffer->bytes);
+        size_t received = 0;
+        TcsResult res = tcs_receive(
+            query->socket, query->tcp_buffer->bytes + query->tcp_done, wanted - query->tcp_done, 0, &received);
+        if (res == TCS_ERROR_WOULD_BLOCK)
+            return;
+        if (res != TCS_SUCCESS || received == 0)
         {
-            free(interfaces);
-            return res;
+            dns_query_finish(dns, index, query, res != TCS_SUCCESS ? res : TCS_ERROR_SOCKET_CLOSED);
+            return;
+        }
+        query->tcp_done += received;
+        if (query->tcp_done >= 2 && query->tcp_done == 2 + (size_t)dns_read_u16(query->tcp_buffer->bytes))
+        {
+            bool is_truncated = false;
+            res = dns_answer_parse(
+                query->tcp_buffer->bytes + 2, query->tcp_done - 2, &dns->lookups.data[index], query, &is_truncated);
+            dns_answer_handle(dns, index, query, res, is_truncated, now_ms);
         }
     }
+}
 
-    for (size_t i = 0; i < count; ++i)
+// Sends again or gives up on queries past their deadline and finds the next deadline
+static void dns_timeouts(struct TcsDns* dns, int64_t now_ms)
+{
+    dns->next_deadline_ms = INT64_MAX;
+    for (size_t index = 0; index < dns->lookups.count; ++index)
     {
-        if (strcmp(interfaces[i].name, interface_name) == 0)
+        for (size_t q = 0; q < 2; ++q)
         {
-            struct TcsAddress bind_address = TCS_ADDRESS_NONE;
-            bind_address.family = TCS_FAMILY_PACKET;
-            bind_address.data.packet.interface_id = interfaces[i].id;
-            bind_address.data.packet.protocol = protocol;
-            if (interfaces != stack_buf)
-                free(interfaces);
-            return tcs_socket_packet(out_socket, &bind_address, type);
+            struct TcsDnsQuery* query = &dns->lookups.data[index].queries[q];
+            if (!dns_query_is_in_flight(query))
+                continue;
+            if (now_ms >= query->deadline_ms)
+            {
+                if (query->state == TCS_DNS_QUERY_UDP &&
+                    query->sent_count < dns->attempts * (int)dns->nameservers_length)
+                {
+                    dns_query_send(dns, index, query, now_ms);
+                }
+                else
+                {
+                    dns_query_finish(dns, index, query, TCS_ERROR_TIMED_OUT);
+                    continue;
+                }
+            }
+            if (query->deadline_ms < dns->next_deadline_ms)
+                dns->next_deadline_ms = query->deadline_ms;
         }
     }
+}
 
-    if (interfaces != stack_buf)
-        free(interfaces);
-    return TCS_ERROR_INVALID_ARGUMENT;
+static void dns_lookup_free(struct TcsDns* dns, size_t index)
+{
+    struct TcsDnsLookup* lookup = &dns->lookups.data[index];
+    for (size_t q = 0; q < 2; ++q)
+    {
+        if (dns_query_is_in_flight(&lookup->queries[q]))
+            dns_query_stop(dns, &lookup->queries[q]);
+        lookup->queries[q].state = TCS_DNS_QUERY_UNUSED;
+    }
+    lookup->state = TCS_DNS_LOOKUP_FREE;
+    lookup->generation = (lookup->generation + 1) & DNS_HANDLE_MASK;
+    lookup->next = dns->free_head;
+    dns->free_head = index;
 }
 
-// tcs_close() is defined in OS specific files
+// Whitespace separated tokens, strtok() would not be thread safe
+static char* dns_token_next(char** cursor)
+{
+    char* token = *cursor;
+    while (*token == ' ' || *token == '\t' || *token == '\r' || *token == '\n')
+        ++token;
+    if (*token == '\0')
+        return NULL;
+    char* end = token;
+    while (*end != '\0' && *end != ' ' && *end != '\t' && *end != '\r' && *end != '\n')
+        ++end;
+    *cursor = *end != '\0' ? end + 1 : end;
+    *end = '\0';
+    return token;
+}
 
-// ######## Socket Operations ########
+static void dns_config_load(struct TcsDns* dns)
+{
+    char line[512];
+    FILE* file = fopen(TCS_CFG_DNS_RESOLV_CONF_PATH, "r");
+    while (file != NULL && fgets(line, sizeof(line), file) != NULL)
+    {
+        char address_str[128];
+        struct TcsAddress address = TCS_ADDRESS_NONE;
+        if (dns->nameservers_length < TCS_CFG_DNS_NAMESERVERS_MAX &&
+            sscanf(line, " nameserver %127s", address_str) == 1 &&
+            tcs_address_parse(address_str, &address) == TCS_SUCCESS)
+            dns->nameservers[dns->nameservers_length++] = address;
+    }
+    if (file != NULL)
+        fclose(file);
+    if (dns->nameservers_length == 0) // Same default as glibc
+        tcs_address_parse("127.0.0.1", &dns->nameservers[dns->nameservers_length++]);
+
+    file = fopen(TCS_CFG_DNS_HOSTS_PATH, "r");
+    while (file != NULL && fgets(line, sizeof(line), file) != NULL)
+    {
+        char* comment = strchr(line, '#');
+        if (comment != NULL)
+            *comment = '\0';
+        struct TcsDnsHost host;
+        host.address = TCS_ADDRESS_NONE;
+        char* cursor = line;
+        char* token = dns_token_next(&cursor);
+        if (token == NULL || tcs_address_parse(token, &host.address) != TCS_SUCCESS)
+            continue;
+        while ((token = dns_token_next(&cursor)) != NULL)
+        {
+            if (strlen(token) > TCS_DNS_NAME_MAX)
+                continue;
+            memcpy(host.name, token, strlen(token) + 1);
+            if (tds_ulist_dns_host_add(&dns->hosts, &host, 1) != 0)
+                break;
+        }
+    }
+    if (file != NULL)
+        fclose(file);
+}
 
-// tcs_bind() is defined in OS specific files
-// tcs_connect() is defined in OS specific files
+// Closes all sockets and frees everything, also for a partly created resolver
+static void dns_free(struct TcsDns* dns)
+{
+    for (size_t index = 0; index < dns->lookups.count; ++index)
+    {
+        if (dns->lookups.data[index].state == TCS_DNS_LOOKUP_ACTIVE)
+            dns_lookup_free(dns, index);
+    }
+    tds_ulist_dns_lookup_destroy(&dns->lookups);
+    tds_ulist_dns_host_destroy(&dns->hosts);
+    tds_pool_dns_tcp_buffer_destroy(&dns->tcp_buffers);
+    tds_hmap_dns_socket_destroy(&dns->query_by_socket);
+    tcs_lib_free(dns);
+}
 
-TcsResult tcs_connect_str(TcsSocket socket, const char* remote_address, uint16_t port)
+TcsResult tcs_dns_create(struct TcsDns** out_dns,
+                         struct TcsPoll* poll,
+                         const struct TcsAddress nameservers[],
+                         size_t nameservers_length,
+                         int attempt_timeout_ms,
+                         int attempts)
 {
-    if (socket == TCS_SOCKET_INVALID)
+    if (out_dns == NULL || *out_dns != NULL || poll == NULL)
         return TCS_ERROR_INVALID_ARGUMENT;
-
-    if (remote_address == NULL)
+    if ((nameservers == NULL) != (nameservers_length == 0) || nameservers_length > TCS_CFG_DNS_NAMESERVERS_MAX)
+        return TCS_ERROR_INVALID_ARGUMENT;
+    if (attempt_timeout_ms <= 0 || attempts <= 0)
         return TCS_ERROR_INVALID_ARGUMENT;
 
-    TcsFamily socket_family = TCS_FAMILY_ANY;
-    TcsResult res = tcs_address_socket_family(socket, &socket_family);
-    if (res != TCS_SUCCESS)
-        return res;
-
-    if (socket_family.native != TCS_FAMILY_IPV4.native && socket_family.native != TCS_FAMILY_IPV6.native)
-        return TCS_ERROR_NOT_IMPLEMENTED;
-
-    struct TcsAddress found_addresses;
-    size_t no_of_found_addresses = 0;
-
-    res = tcs_address_resolve(remote_address, socket_family, &found_addresses, 1, &no_of_found_addresses);
-    if (res != TCS_SUCCESS)
-        return res;
-
-    if (no_of_found_addresses == 0)
-        return TCS_ERROR_ADDRESS_LOOKUP_FAILED;
-
-    if (socket_family.native == TCS_FAMILY_IPV4.native)
-    {
-        if (found_addresses.data.ipv4.port == 0)
-            found_addresses.data.ipv4.port = port;
-        else if (port != 0)
-            return TCS_ERROR_INVALID_ARGUMENT;
-    }
-    else if (socket_family.native == TCS_FAMILY_IPV6.native)
-    {
-        if (found_addresses.data.ipv6.port == 0)
-            found_addresses.data.ipv6.port = port;
-        else if (port != 0)
-            return TCS_ERROR_INVALID_ARGUMENT;
+    struct TcsDns* dns = (struct TcsDns*)tcs_lib_malloc(sizeof(struct TcsDns));
+    if (dns == NULL)
+        return TCS_ERROR_MEMORY;
+    memset(dns, 0, sizeof(struct TcsDns));
+    dns->poll = poll;
+    dns->attempt_timeout_ms = attempt_timeout_ms;
+    dns->attempts = attempts;
+    dns->next_deadline_ms = INT64_MAX;
+    dns->free_head = DNS_END;
+    dns->done_head = DNS_END;
+    dns->done_tail = DNS_END;
+
+    // Query ids and the socket map seed, guessable ones only if the OS has no entropy source
+    uint8_t random[12];
+    if (tcs_os_random(random, sizeof(random)) != TCS_SUCCESS)
+    {
+        uint64_t fallback = (uint64_t)tcs_time_monotonic_ms() ^ (uint64_t)(uintptr_t)dns;
+        memcpy(random, &fallback, sizeof(fallback));
+        memcpy(random + 8, &fallback, 4);
+    }
+    uint64_t map_seed = 0;
+    memcpy(&dns->random_state, random, sizeof(dns->random_state));
+    memcpy(&map_seed, random + 4, sizeof(map_seed));
+    if (dns->random_state == 0)
+        dns->random_state = 0x9E3779B9u;
+    tds_hmap_dns_socket_create(&dns->query_by_socket, map_seed);
+
+    if (tds_ulist_dns_lookup_create(&dns->lookups) != 0 || tds_ulist_dns_host_create(&dns->hosts) != 0 ||
+        tds_pool_dns_tcp_buffer_create(&dns->tcp_buffers, 1, 0) != 0)
+    {
+        dns_free(dns);
+        return TCS_ERROR_MEMORY;
     }
-    else if (socket_family.native == TCS_FAMILY_ANY.native)
+
+    if (nameservers == NULL)
     {
-        /* nothing to do */
+        dns_config_load(dns);
     }
     else
     {
-        return TCS_ERROR_INVALID_ARGUMENT;
+        memcpy(dns->nameservers, nameservers, nameservers_length * sizeof(struct TcsAddress));
+        dns->nameservers_length = nameservers_length;
     }
-    return tcs_connect(socket, &found_addresses);
-}
-
-// tcs_listen() is defined in OS specific files
-// tcs_accept() is defined in OS specific files
-// tcs_shutdown() is defined in OS specific files
 
-// ######## Data Transfer ########
+    for (size_t i = 0; i < dns->nameservers_length; ++i)
+    {
+        struct TcsAddress* nameserver = &dns->nameservers[i];
+        if (nameserver->family.native == TCS_FAMILY_IPV4.native && nameserver->data.ipv4.port == 0)
+            nameserver->data.ipv4.port = 53;
+        else if (nameserver->family.native == TCS_FAMILY_IPV6.native && nameserver->data.ipv6.port == 0)
+            nameserver->data.ipv6.port = 53;
+    }
 
-// tcs_send() is defined in OS specific files
-// tcs_send_to() is defined in OS specific files
-// tcs_sendv() is defined in OS specific files
+    *out_dns = dns;
+    return TCS_SUCCESS;
+}
 
-TcsResult tcs_send_netstring(TcsSocket socket, const uint8_t* buffer, size_t buffer_size)
+TcsResult tcs_dns_destroy(struct TcsDns** dns)
 {
-    if (socket == TCS_SOCKET_INVALID)
-        return TCS_ERROR_INVALID_ARGUMENT;
-
-    if (buffer == NULL || buffer_size == 0)
-        return TCS_ERROR_INVALID_ARGUMENT;
-
-#if SIZE_MAX > 0xffffffffffffffffULL
-    // buffer_size bigger than 64 bits? (size_t can be bigger on some systems)
-    if (buffer_size > 0xffffffffffffffffULL)
+    if (dns == NULL || *dns == NULL)
         return TCS_ERROR_INVALID_ARGUMENT;
-#endif
-
-    int header_length = 0;
-    char netstring_header[21];
-    memset(netstring_header, 0, sizeof netstring_header);
-
-    // %zu is not supported by all compilers, therefor we cast it to llu
-    header_length = snprintf(netstring_header, 21, "%llu:", (unsigned long long)buffer_size);
+    dns_free(*dns);
+    *dns = NULL;
+    return TCS_SUCCESS;
+}
 
-    if (header_length < 0)
+TcsResult tcs_dns_submit(struct TcsDns* dns, const char* hostname, TcsFamily address_family, size_t* out_handle)
+{
+    if (dns == NULL || hostname == NULL || out_handle == NULL)
         return TCS_ERROR_INVALID_ARGUMENT;
+    bool is_any = address_family.native == TCS_FAMILY_ANY.native;
+    if (!is_any && address_family.native != TCS_FAMILY_IPV4.native &&
+        address_family.native != TCS_FAMILY_IPV6.native)
+        return TCS_ERROR_NOT_SUPPORTED;
 
-    TcsResult sts = TCS_SUCCESS;
-    sts = tcs_send(socket, (uint8_t*)netstring_header, (size_t)header_length, TCS_MSG_SENDALL, NULL);
-    if (sts != TCS_SUCCESS)
-        return sts;
-
-    sts = tcs_send(socket, buffer, buffer_size, TCS_MSG_SENDALL, NULL);
-    if (sts != TCS_SUCCESS)
-        return sts;
+    size_t index = dns->free_head;
+    if (index == DNS_END)
+    {
+        struct TcsDnsLookup new_lookup;
+        memset(&new_lookup, 0, sizeof(new_lookup));
+        if (dns->lookups.count >= UINT32_MAX / 2 || dns->lookups.count > DNS_HANDLE_MASK ||
+            tds_ulist_dns_lookup_add(&dns->lookups, &new_lookup, 1) != 0)
+            return TCS_ERROR_MEMORY;
+        index = dns->lookups.count - 1;
+    }
+    else
+    {
+        dns->free_head = dns->lookups.data[index].next;
+    }
+    struct TcsDnsLookup* lookup = &dns->lookups.data[index];
+    lookup->state = TCS_DNS_LOOKUP_ACTIVE;
+    for (size_t q = 0; q < 2; ++q)
+    {
+        lookup->queries[q].state = TCS_DNS_QUERY_UNUSED;
+        lookup->queries[q].address_count = 0;
+        lookup->queries[q].socket = TCS_SOCKET_INVALID;
+        lookup->queries[q].tcp_buffer = NULL;
+    }
+    *out_handle = dns_handle(dns, index);
 
-    sts = tcs_send(socket, (const uint8_t*)",", 1, TCS_MSG_SENDALL, NULL);
-    if (sts != TCS_SUCCESS)
-        return sts;
+    // Numeric addresses and the hosts file are answered at once
+    struct TcsDnsQuery* local = &lookup->queries[0];
+    struct TcsAddress parsed = TCS_ADDRESS_NONE;
+    if (tcs_address_parse(hostname, &parsed) == TCS_SUCCESS &&
+        (is_any || parsed.family.native == address_family.native))
+        local->addresses[local->address_count++] = parsed;
+    for (size_t i = 0; i < dns->hosts.count && local->address_count < TCS_CFG_DNS_ADDRESSES_MAX; ++i)
+    {
+        const struct TcsDnsHost* host = &dns->hosts.data[i];
+        if ((is_any || host->address.family.native == address_family.native) &&
+            dns_hostname_is_equal(host->name, hostname))
+            local->addresses[local->address_count++] = host->address;
+    }
+    if (local->address_count > 0)
+    {
+        local->state = TCS_DNS_QUERY_DONE;
+        local->result = TCS_SUCCESS;
+        dns_lookup_done(dns, index);
+        return TCS_SUCCESS;
+    }
 
+    TcsResult res = dns_name_encode(hostname, lookup->name, &lookup->name_length);
+    if (res != TCS_SUCCESS)
+    {
+        dns_lookup_free(dns, index);
+        return res;
+    }
+    int64_t now_ms = tcs_time_monotonic_ms();
+    for (size_t q = 0; q < 2; ++q)
+    {
+        uint16_t type = q == 0 ? TCS_DNS_TYPE_AAAA : TCS_DNS_TYPE_A;
+        if (!is_any && (type == TCS_DNS_TYPE_AAAA) != (address_family.native == TCS_FAMILY_IPV6.native))
+            continue;
+        struct TcsDnsQuery* query = &lookup->queries[q];
+        dns->in_flight++;
+        query->type = type;
+        query->state = TCS_DNS_QUERY_UDP;
+        query->sent_count = 0;
+        dns_query_send(dns, index, query, now_ms);
+    }
     return TCS_SUCCESS;
 }
 
-// tcs_receive() is defined in OS specific files
-// tcs_receive_from() is defined in OS specific files
-
-TcsResult tcs_receive_line(TcsSocket socket,
-                           uint8_t* buffer,
-                           size_t buffer_size,
-                           uint8_t delimiter,
-                           size_t* out_received_size)
+TcsResult tcs_dns_process(struct TcsDns* dns, const struct TcsPollEvent* event, int* out_timeout_ms)
 {
-    if (socket == TCS_SOCKET_INVALID || buffer == NULL || buffer_size == 0)
+    if (dns == NULL)
         return TCS_ERROR_INVALID_ARGUMENT;
 
-    /*
-    *                    data in kernel buffer
-    *   |12345yyyyyyyyyyyyyyyyyyyyyyyy..............|
-    *
-    *       buffer_size ----------------------------------.
-    *       searched ----------------------.                |
-    *                                      |                |
-    *       bytes_peeked ------------------.                |
-    *       bytes_read ---------------.    |                |
-    *                                 v    v                v
-    *       data in arg buffer
-    *   |xxxxxxxxxxxxxxxxxxxxxxxxxxxxxx12345................|
-    */
-    size_t bytes_read = 0;
-    size_t bytes_peeked = 0;
-    size_t bytes_searched = 0;
-    while (bytes_read < buffer_size)
+    int64_t now_ms = tcs_time_monotonic_ms();
+    const size_t* slot = event != NULL ? tds_hmap_dns_socket_get(&dns->query_by_socket, &event->socket) : NULL;
+    if (slot != NULL)
     {
-        TcsResult sts = TCS_SUCCESS;
-        size_t bytes_free_in_buffer = buffer_size - bytes_read;
-        size_t current_peeked = 0;
-        sts = tcs_receive(socket, buffer + bytes_read, bytes_free_in_buffer, TCS_MSG_PEEK, &current_peeked);
-        if (sts != TCS_SUCCESS)
-        {
-            if (out_received_size != NULL)
-                *out_received_size = bytes_read;
-            return sts;
-        }
-        bytes_peeked += current_peeked;
-
-        if (current_peeked == 0)
-        {
-            // Make sure we block so we do not fast loop previous PEEK.
-            // Can not assume that peek with waitall is not crossplatform, needs to read
-            size_t current_read = 0;
-            sts = tcs_receive(socket, buffer + bytes_read, 1, TCS_MSG_WAITALL, &current_read);
-            bytes_read += current_read;
-            bytes_peeked += current_read;
-
-            if (sts != TCS_SUCCESS)
-            {
-                if (out_received_size != NULL)
-                    *out_received_size = bytes_read;
-                return sts;
-            }
-        }
-
-        bool found_delimiter = false;
-
-        while (bytes_searched < bytes_peeked)
-        {
-            if (buffer[bytes_searched++] == delimiter)
-            {
-                found_delimiter = true;
-                break;
-            }
-        }
+        size_t index = *slot / 2;
+        struct TcsDnsQuery* query = &dns->lookups.data[index].queries[*slot % 2];
+        if (query->state == TCS_DNS_QUERY_UDP)
+            dns_udp_receive(dns, index, query, now_ms);
+        else
+            dns_tcp_progress(dns, index, query, event, now_ms);
+    }
+    if (now_ms >= dns->next_deadline_ms)
+        dns_timeouts(dns, now_ms);
 
-        // byte_searched == bytes_peeked if no delimiter was found
-        // after this block, bytes_read will also has the same value as they have
-        if (bytes_searched > bytes_read)
-        {
-            size_t bytes = 0;
-            size_t bytes_to_read_to_catch_up = bytes_searched - bytes_read;
-            sts = tcs_receive(socket, buffer + bytes_read, bytes_to_read_to_catch_up, TCS_MSG_WAITALL, &bytes);
-            bytes_read += bytes;
-            if (sts != TCS_SUCCESS)
-            {
-                if (out_received_size != NULL)
-                    *out_received_size = bytes_read;
-                return sts;
-            }
-        }
-        if (found_delimiter)
+    if (out_timeout_ms != NULL)
+    {
+        if (dns->done_head != DNS_END)
+            *out_timeout_ms = 0;
+        else if (dns->in_flight == 0)
+            *out_timeout_ms = TCS_WAIT_INF;
+        else if (dns->next_deadline_ms <= now_ms)
+            *out_timeout_ms = 0;
+        else
+            *out_timeout_ms = (int)(dns->next_deadline_ms - now_ms);
+    }
+    return TCS_SUCCESS;
+}
+
+TcsResult tcs_dns_take(struct TcsDns* dns,
+                       size_t* out_handle,
+                       TcsResult* out_result,
+                       struct TcsAddress out_addresses[],
+                       size_t addresses_length,
+                       size_t* out_length)
+{
+    if (dns == NULL || out_handle == NULL || out_result == NULL)
+        return TCS_ERROR_INVALID_ARGUMENT;
+    if (out_length != NULL)
+        *out_length = 0;
+
+    size_t index = dns->done_head;
+    if (index == DNS_END)
+        return TCS_AGAIN;
+    struct TcsDnsLookup* lookup = &dns->lookups.data[index];
+    dns->done_head = lookup->next;
+    if (dns->done_head == DNS_END)
+        dns->done_tail = DNS_END;
+
+    // Addresses of both families, otherwise the most telling error. No such name is the least telling.
+    TcsResult result = TCS_ERROR_ADDRESS_LOOKUP_FAILED;
+    size_t count = 0;
+    for (size_t q = 0; q < 2; ++q)
+    {
+        const struct TcsDnsQuery* query = &lookup->queries[q];
+        if (query->state != TCS_DNS_QUERY_DONE)
+            continue;
+        if (query->result == TCS_SUCCESS)
+            result = TCS_SUCCESS;
+        else if (result == TCS_ERROR_ADDRESS_LOOKUP_FAILED)
+            result = query->result;
+        for (size_t i = 0; i < query->address_count; ++i, ++count)
         {
-            if (out_received_size != NULL)
-                *out_received_size = bytes_read;
-            return sts;
+            if (out_addresses != NULL && count < addresses_length)
+                out_addresses[count] = query->addresses[i];
         }
     }
-    if (out_received_size != NULL)
-        *out_received_size = bytes_read;
-    return TCS_AGAIN;
+    if (out_addresses != NULL && count > addresses_length)
+        count = addresses_length;
+    if (out_length != NULL)
+        *out_length = count;
+    *out_handle = dns_handle(dns, index);
+    *out_result = result;
+    dns_lookup_free(dns, index);
+    return TCS_SUCCESS;
 }
 
-TcsResult tcs_receive_netstring(TcsSocket socket, uint8_t* buffer, size_t buffer_size, size_t* out_received_size)
+TcsResult tcs_dns_cancel(struct TcsDns* dns, size_t handle)
 {
-    if (socket == TCS_SOCKET_INVALID || buffer == NULL || buffer_size == 0)
+    if (dns == NULL)
+        return TCS_ERROR_INVALID_ARGUMENT;
+    size_t index = dns_handle_index(dns, handle);
+    if (index == DNS_END)
         return TCS_ERROR_INVALID_ARGUMENT;
 
-    size_t expected_length = 0;
-    int parsed = 0;
-    TcsResult sts = TCS_SUCCESS;
-    char t = '\0';
-    const int max_header = 21;
-    while (t != ':' && parsed < max_header)
+    if (dns->lookups.data[index].state == TCS_DNS_LOOKUP_DONE)
     {
-        sts = tcs_receive(socket, (uint8_t*)&t, 1, TCS_MSG_WAITALL, NULL);
-        if (sts != TCS_SUCCESS)
-            return sts;
+        size_t prev = DNS_END;
+        size_t iter = dns->done_head;
+        while (iter != index)
+        {
+            prev = iter;
+            iter = dns->lookups.data[iter].next;
+        }
+        if (prev != DNS_END)
+            dns->lookups.data[prev].next = dns->lookups.data[index].next;
+        else
+            dns->done_head = dns->lookups.data[index].next;
+        if (dns->done_tail == index)
+            dns->done_tail = prev;
+    }
+    dns_lookup_free(dns, index);
+    return TCS_SUCCESS;
+}
 
-        parsed += 1;
+// ######## Socket Filters ########
 
-        bool is_num = t >= '0' && t <= '9';
-        bool is_end = t == ':';
-        if (!is_num && !is_end)
-            return TCS_ERROR_ILL_FORMED_MESSAGE;
+// Classic BPF opcodes and Linux ancillary offsets, kernel ABI values from linux/filter.h
+#define TCS_BPF_LD_W_ABS 0x20  // BPF_LD | BPF_W | BPF_ABS
+#define TCS_BPF_LD_H_ABS 0x28  // BPF_LD | BPF_H | BPF_ABS
+#define TCS_BPF_LD_B_ABS 0x30  // BPF_LD | BPF_B | BPF_ABS
+#define TCS_BPF_LD_H_IND 0x48  // BPF_LD | BPF_H | BPF_IND
+#define TCS_BPF_LDX_B_MSH 0xb1 // BPF_LDX | BPF_B | BPF_MSH
+#define TCS_BPF_AND_K 0x54     // BPF_ALU | BPF_AND | BPF_K
+#define TCS_BPF_JA 0x05        // BPF_JMP | BPF_JA
+#define TCS_BPF_JEQ_K 0x15     // BPF_JMP | BPF_JEQ | BPF_K
+#define TCS_BPF_JSET_K 0x45    // BPF_JMP | BPF_JSET | BPF_K
+#define TCS_BPF_RET_K 0x06     // BPF_RET | BPF_K
 
-        if (is_end)
-            break;
+#define TCS_SKF_AD_PROTOCOL 0xFFFFF000U         // SKF_AD_OFF + SKF_AD_PROTOCOL
+#define TCS_SKF_AD_VLAN_TAG 0xFFFFF02CU         // SKF_AD_OFF + SKF_AD_VLAN_TAG
+#define TCS_SKF_AD_VLAN_TAG_PRESENT 0xFFFFF030U // SKF_AD_OFF + SKF_AD_VLAN_TAG_PRESENT
+#define TCS_SKF_NET_OFF 0xFFF00000U             // SKF_NET_OFF, network header independent of socket type
+#define TCS_SKF_LL_OFF 0xFFE00000U              // SKF_LL_OFF, link layer header independent of socket type
 
-        size_t digit = (size_t)t - '0';
-        if (expected_length > (SIZE_MAX - digit) / 10)
-            return TCS_ERROR_ILL_FORMED_MESSAGE;
-        expected_length = expected_length * 10 + digit;
+// Jump target of a predicate meaning its own trailing reject
+#define TCS_BPF_REJECT 0xFF
+
+// Every predicate ends with its own "ret #0", the check before it jumps over it on a match.
+// This keeps predicates self contained so they can be appended in front of the final accept.
+static TcsResult filter_append(struct TcsFilter* filter, struct TcsFilterInstruction* block, size_t block_length)
+{
+    if (filter == NULL || filter->length == 0 || filter->length > TCS_CFG_FILTER_MAX_INSTRUCTIONS)
+        return TCS_ERROR_INVALID_ARGUMENT;
+    if (filter->length + block_length > TCS_CFG_FILTER_MAX_INSTRUCTIONS)
+        return TCS_ERROR_MEMORY;
+
+    for (size_t i = 0; i < block_length; ++i)
+    {
+        uint8_t to_reject = (uint8_t)(block_length - 1 - i - 1);
+        if (block[i].jt == TCS_BPF_REJECT)
+            block[i].jt = to_reject;
+        if (block[i].jf == TCS_BPF_REJECT)
+            block[i].jf = to_reject;
     }
 
-    if (parsed >= max_header)
-        return TCS_ERROR_ILL_FORMED_MESSAGE;
+    struct TcsFilterInstruction accept = filter->instructions[filter->length - 1];
+    memcpy(&filter->instructions[filter->length - 1], block, block_length * sizeof(struct TcsFilterInstruction));
+    filter->length += block_length;
+    filter->instructions[filter->length - 1] = accept;
+    return TCS_SUCCESS;
+}
 
-    if (buffer_size < expected_length)
-        return TCS_ERROR_MEMORY;
+TcsResult tcs_filter_init(struct TcsFilter* filter)
+{
+    if (filter == NULL)
+        return TCS_ERROR_INVALID_ARGUMENT;
 
-    sts = tcs_receive(socket, buffer, expected_length, TCS_MSG_WAITALL, NULL);
-    if (sts != TCS_SUCCESS)
-        return sts;
+    memset(filter, 0, sizeof(struct TcsFilter));
+    filter->instructions[0].code = TCS_BPF_RET_K;
+    filter->instructions[0].k = 0xFFFFFFFFU; // Accept the whole frame
+    filter->length = 1;
+    return TCS_SUCCESS;
+}
 
-    sts = tcs_receive(socket, (uint8_t*)&t, 1, TCS_MSG_WAITALL, NULL);
-    if (sts != TCS_SUCCESS)
-        return sts;
+TcsResult tcs_filter_ether_type(struct TcsFilter* filter, uint16_t ether_type)
+{
+    struct TcsFilterInstruction block[] = {
+        {TCS_BPF_LD_H_ABS, 0, 0, TCS_SKF_AD_PROTOCOL},
+        {TCS_BPF_JEQ_K, 1, 0, ether_type},
+        {TCS_BPF_RET_K, 0, 0, 0},
+    };
+    return filter_append(filter, block, sizeof(block) / sizeof(block[0]));
+}
 
-    if (t != ',')
-        return TCS_ERROR_ILL_FORMED_MESSAGE;
+TcsResult tcs_filter_vlan_id(struct TcsFilter* filter, uint16_t vlan_id)
+{
+    if (vlan_id > 0x0FFF)
+        return TCS_ERROR_INVALID_ARGUMENT;
 
-    if (out_received_size != NULL)
-        *out_received_size = expected_length;
+    struct TcsFilterInstruction block[] = {
+        {TCS_BPF_LD_W_ABS, 0, 0, TCS_SKF_AD_VLAN_TAG_PRESENT},
+        {TCS_BPF_JEQ_K, TCS_BPF_REJECT, 0, 0},
+        {TCS_BPF_LD_W_ABS, 0, 0, TCS_SKF_AD_VLAN_TAG},
+        {TCS_BPF_AND_K, 0, 0, 0x0FFF},
+        {TCS_BPF_JEQ_K, 1, 0, vlan_id},
+        {TCS_BPF_RET_K, 0, 0, 0},
+    };
+    return filter_append(filter, block, sizeof(block) / sizeof(block[0]));
+}
 
-    return TCS_SUCCESS;
+TcsResult tcs_filter_udp_destination_port(struct TcsFilter* filter, uint16_t port)
+{
+    struct TcsFilterInstruction block[] = {
+        {TCS_BPF_LD_H_ABS, 0, 0, TCS_SKF_AD_PROTOCOL},
+        {TCS_BPF_JEQ_K, 8, 0, 0x86DD},                       // IPv6 continues at the next header check
+        {TCS_BPF_JEQ_K, 0, TCS_BPF_REJECT, 0x0800},          // IPv4
+        {TCS_BPF_LD_B_ABS, 0, 0, TCS_SKF_NET_OFF + 9},       // Protocol
+        {TCS_BPF_JEQ_K, 0, TCS_BPF_REJECT, 17},              // UDP
+        {TCS_BPF_LD_H_ABS, 0, 0, TCS_SKF_NET_OFF + 6},       // Flags and fragment offset
+        {TCS_BPF_JSET_K, TCS_BPF_REJECT, 0, 0x1FFF},         // Only the first fragment has the UDP header
+        {TCS_BPF_LDX_B_MSH, 0, 0, TCS_SKF_NET_OFF},          // X = IPv4 header length
+        {TCS_BPF_LD_H_IND, 0, 0, TCS_SKF_NET_OFF + 2},       // Destination port after the IPv4 header
+        {TCS_BPF_JA, 0, 0, 3},                               // Go to the port compare
+        {TCS_BPF_LD_B_ABS, 0, 0, TCS_SKF_NET_OFF + 6},       // IPv6 next header
+        {TCS_BPF_JEQ_K, 0, TCS_BPF_REJECT, 17},              // UDP
+        {TCS_BPF_LD_H_ABS, 0, 0, TCS_SKF_NET_OFF + 40 + 2},  // Destination port after the IPv6 header
+        {TCS_BPF_JEQ_K, 1, 0, port},
+        {TCS_BPF_RET_K, 0, 0, 0},
+    };
+    return filter_append(filter, block, sizeof(block) / sizeof(block[0]));
 }
 
-// ######## Socket Polling ########
+TcsResult tcs_filter_multicast_group(struct TcsFilter* filter, const struct TcsAddress* multicast_address)
+{
+    if (!tcs_address_is_multicast(multicast_address))
+        return TCS_ERROR_INVALID_ARGUMENT;
 
-// tcs_poll_create() is defined in OS specific files
-// tcs_poll_destroy() is defined in OS specific files
-// tcs_poll_add() is defined in OS specific files
-// tcs_poll_modify() is defined in OS specific files
-// tcs_poll_remove() is defined in OS specific files
-// tcs_poll_wait() is defined in OS specific files
+    if (multicast_address->family.native == TCS_FAMILY_IPV4.native)
+    {
+        struct TcsFilterInstruction block[] = {
+            {TCS_BPF_LD_H_ABS, 0, 0, TCS_SKF_AD_PROTOCOL},
+            {TCS_BPF_JEQ_K, 0, TCS_BPF_REJECT, 0x0800},
+            {TCS_BPF_LD_W_ABS, 0, 0, TCS_SKF_NET_OFF + 16}, // Destination address
+            {TCS_BPF_JEQ_K, 1, 0, multicast_address->data.ipv4.address},
+            {TCS_BPF_RET_K, 0, 0, 0},
+        };
+        return filter_append(filter, block, sizeof(block) / sizeof(block[0]));
+    }
+
+    if (multicast_address->family.native == TCS_FAMILY_IPV6.native)
+    {
+        uint32_t words[4];
+        const uint8_t* b = multicast_address->data.ipv6.address.bytes;
+        for (int i = 0; i < 4; ++i)
+            words[i] = (uint32_t)b[i * 4] << 24 | (uint32_t)b[i * 4 + 1] << 16 | (uint32_t)b[i * 4 + 2] << 8 |
+                       (uint32_t)b[i * 4 + 3];
+        struct TcsFilterInstruction block[] = {
+            {TCS_BPF_LD_H_ABS, 0, 0, TCS_SKF_AD_PROTOCOL},
+            {TCS_BPF_JEQ_K, 0, TCS_BPF_REJECT, 0x86DD},
+            {TCS_BPF_LD_W_ABS, 0, 0, TCS_SKF_NET_OFF + 24}, // Destination address
+            {TCS_BPF_JEQ_K, 0, TCS_BPF_REJECT, words[0]},
+            {TCS_BPF_LD_W_ABS, 0, 0, TCS_SKF_NET_OFF + 28},
+            {TCS_BPF_JEQ_K, 0, TCS_BPF_REJECT, words[1]},
+            {TCS_BPF_LD_W_ABS, 0, 0, TCS_SKF_NET_OFF + 32},
+            {TCS_BPF_JEQ_K, 0, TCS_BPF_REJECT, words[2]},
+            {TCS_BPF_LD_W_ABS, 0, 0, TCS_SKF_NET_OFF + 36},
+            {TCS_BPF_JEQ_K, 1, 0, words[3]},
+            {TCS_BPF_RET_K, 0, 0, 0},
+        };
+        return filter_append(filter, block, sizeof(block) / sizeof(block[0]));
+    }
+
+    const uint8_t* mac = multicast_address->data.packet.mac;
+    uint32_t mac_high = (uint32_t)mac[0] << 24 | (uint32_t)mac[1] << 16 | (uint32_t)mac[2] << 8 | mac[3];
+    uint32_t mac_low = (uint32_t)mac[4] << 8 | mac[5];
+    struct TcsFilterInstruction block[] = {
+        {TCS_BPF_LD_W_ABS, 0, 0, TCS_SKF_LL_OFF}, // Destination MAC
+        {TCS_BPF_JEQ_K, 0, TCS_BPF_REJECT, mac_high},
+        {TCS_BPF_LD_H_ABS, 0, 0, TCS_SKF_LL_OFF + 4},
+        {TCS_BPF_JEQ_K, 1, 0, mac_low},
+        {TCS_BPF_RET_K, 0, 0, 0},
+    };
+    return filter_append(filter, block, sizeof(block) / sizeof(block[0]));
+}
 
 // ######## Socket Options ########
 
@@ -7033,83 +13876,663 @@ TcsResult tcs_opt_out_of_band_inline_get(TcsSocket socket, bool* is_oob_enabled)
     return sts;
 }
 
-TcsResult tcs_opt_priority_set(TcsSocket socket, int priority)
+TcsResult tcs_opt_priority_set(TcsSocket socket, int priority)
+{
+    if (socket == TCS_SOCKET_INVALID)
+        return TCS_ERROR_INVALID_ARGUMENT;
+
+    return tcs_opt_set(socket, TCS_SOL_SOCKET, TCS_SO_PRIORITY, &priority, sizeof(priority));
+}
+
+TcsResult tcs_opt_priority_get(TcsSocket socket, int* priority)
+{
+    if (socket == TCS_SOCKET_INVALID || priority == NULL)
+        return TCS_ERROR_INVALID_ARGUMENT;
+
+    size_t s = sizeof(*priority);
+    return tcs_opt_get(socket, TCS_SOL_SOCKET, TCS_SO_PRIORITY, priority, &s);
+}
+
+// tcs_opt_nonblocking_set() is defined in OS specific files
+// tcs_opt_nonblocking_get() is defined in OS specific files
+
+// tcs_opt_membership_add() is defined in OS specific files
+
+TcsResult tcs_opt_membership_add_str(TcsSocket socket, const char* multicast_address)
+{
+    if (multicast_address == NULL)
+        return TCS_ERROR_INVALID_ARGUMENT;
+
+    struct TcsAddress addr = TCS_ADDRESS_NONE;
+    TcsResult res = tcs_address_parse(multicast_address, &addr);
+    if (res != TCS_SUCCESS)
+        return res;
+
+    return tcs_opt_membership_add(socket, &addr);
+}
+
+// tcs_opt_membership_add_to() is defined in OS specific files
+// tcs_opt_membership_drop() is defined in OS specific files
+
+TcsResult tcs_opt_membership_drop_str(TcsSocket socket, const char* multicast_address)
+{
+    if (multicast_address == NULL)
+        return TCS_ERROR_INVALID_ARGUMENT;
+
+    struct TcsAddress addr = TCS_ADDRESS_NONE;
+    TcsResult res = tcs_address_parse(multicast_address, &addr);
+    if (res != TCS_SUCCESS)
+        return res;
+
+    return tcs_opt_membership_drop(socket, &addr);
+}
+
+// tcs_opt_membership_drop_from() is defined in OS specific files
+
+// ######## Address and Interface Utilities ########
+
+// tcs_interface_list() is defined in OS specific files
+// tcs_address_list() is defined in OS specific files
+// tcs_address_socket_local() is defined in OS specific files
+// tcs_address_socket_remote() is defined in OS specific files
+// tcs_address_socket_family() is defined in OS specific files
+
+struct TcsAddressCacheEntry
+{
+    char hostname[TCS_CFG_ADDRESS_CACHE_HOSTNAME_SIZE];
+    int family; // Native family, TCS_FAMILY_ANY is cached apart from the specific families
+    uint32_t hash;
+    int64_t expires_ms;
+    TcsResult result; // TCS_SUCCESS or the cached lookup failure
+    size_t address_count;
+    struct TcsAddress addresses[TCS_CFG_ADDRESS_CACHE_ADDRESSES_MAX];
+    size_t chain_next; // Next entry in the same bucket, or the next free entry
+    size_t lru_prev;   // Towards the most recently used
+    size_t lru_next;   // Towards the least recently used
+};
+
+struct TcsAddressCache
+{
+    int positive_ttl_ms;
+    int negative_ttl_ms;
+    size_t capacity;
+    size_t bucket_mask;
+    size_t* buckets;
+    size_t free_head;
+    size_t lru_head; // Most recently used
+    size_t lru_tail; // Evicted first
+    struct TcsAddressCacheEntry* entries;
+};
+
+// End of a bucket chain, the free list and the LRU list
+static const size_t ADDRESS_CACHE_END = (size_t)-1;
+
+static struct TcsAddressCache* address_cache = NULL;
+
+static char address_cache_fold(char c)
+{
+    return (c >= 'A' && c <= 'Z') ? (char)(c - 'A' + 'a') : c;
+}
+
+// FNV-1a over the lower case hostname and the family, DNS names are case insensitive
+static uint32_t address_cache_hash(const char* hostname, int family)
+{
+    uint32_t hash = 2166136261u;
+    for (const char* c = hostname; *c != '\0'; ++c)
+        hash = (hash ^ (uint8_t)address_cache_fold(*c)) * 16777619u;
+    return (hash ^ (uint32_t)family) * 16777619u;
+}
+
+static bool address_cache_hostname_is_equal(const char* l, const char* r)
+{
+    while (*l != '\0' && address_cache_fold(*l) == address_cache_fold(*r))
+    {
+        ++l;
+        ++r;
+    }
+    return address_cache_fold(*l) == address_cache_fold(*r);
+}
+
+static void address_cache_clear(struct TcsAddressCache* cache)
+{
+    for (size_t i = 0; i <= cache->bucket_mask; ++i)
+        cache->buckets[i] = ADDRESS_CACHE_END;
+    for (size_t i = 0; i < cache->capacity; ++i)
+        cache->entries[i].chain_next = i + 1 < cache->capacity ? i + 1 : ADDRESS_CACHE_END;
+    cache->free_head = 0;
+    cache->lru_head = ADDRESS_CACHE_END;
+    cache->lru_tail = ADDRESS_CACHE_END;
+}
+
+static void address_cache_free(struct TcsAddressCache* cache)
+{
+    if (cache == NULL)
+        return;
+    tcs_lib_free(cache->buckets);
+    tcs_lib_free(cache->entries);
+    tcs_lib_free(cache);
+}
+
+static void address_cache_lru_unlink(struct TcsAddressCache* cache, size_t index)
+{
+    struct TcsAddressCacheEntry* entry = &cache->entries[index];
+    if (entry->lru_prev != ADDRESS_CACHE_END)
+        cache->entries[entry->lru_prev].lru_next = entry->lru_next;
+    else
+        cache->lru_head = entry->lru_next;
+    if (entry->lru_next != ADDRESS_CACHE_END)
+        cache->entries[entry->lru_next].lru_prev = entry->lru_prev;
+    else
+        cache->lru_tail = entry->lru_prev;
+}
+
+static void address_cache_lru_push(struct TcsAddressCache* cache, size_t index)
+{
+    struct TcsAddressCacheEntry* entry = &cache->entries[index];
+    entry->lru_prev = ADDRESS_CACHE_END;
+    entry->lru_next = cache->lru_head;
+    if (cache->lru_head != ADDRESS_CACHE_END)
+        cache->entries[cache->lru_head].lru_prev = index;
+    else
+        cache->lru_tail = index;
+    cache->lru_head = index;
+}
+
+static size_t address_cache_find(const struct TcsAddressCache* cache, const char* hostname, int family, uint32_t hash)
+{
+    size_t index = cache->buckets[hash & cache->bucket_mask];
+    while (index != ADDRESS_CACHE_END)
+    {
+        const struct TcsAddressCacheEntry* entry = &cache->entries[index];
+        if (entry->hash == hash && entry->family == family &&
+            address_cache_hostname_is_equal(entry->hostname, hostname))
+            return index;
+        index = entry->chain_next;
+    }
+    return ADDRESS_CACHE_END;
+}
+
+static void address_cache_remove(struct TcsAddressCache* cache, size_t index)
+{
+    struct TcsAddressCacheEntry* entry = &cache->entries[index];
+    size_t* link = &cache->buckets[entry->hash & cache->bucket_mask];
+    while (*link != index)
+        link = &cache->entries[*link].chain_next;
+    *link = entry->chain_next;
+    address_cache_lru_unlink(cache, index);
+    entry->chain_next = cache->free_head;
+    cache->free_head = index;
+}
+
+// Replaces an existing entry, evicts the least recently used entry when full. The caller holds the lock.
+static void address_cache_store(struct TcsAddressCache* cache,
+                                const char* hostname,
+                                int family,
+                                TcsResult result,
+                                const struct TcsAddress addresses[],
+                                size_t address_count,
+                                int ttl_ms)
+{
+    uint32_t hash = address_cache_hash(hostname, family);
+    size_t index = address_cache_find(cache, hostname, family, hash);
+    if (index != ADDRESS_CACHE_END)
+        address_cache_remove(cache, index);
+    if (cache->free_head == ADDRESS_CACHE_END)
+        address_cache_remove(cache, cache->lru_tail);
+
+    index = cache->free_head;
+    struct TcsAddressCacheEntry* entry = &cache->entries[index];
+    cache->free_head = entry->chain_next;
+
+    memcpy(entry->hostname, hostname, strlen(hostname) + 1);
+    entry->family = family;
+    entry->hash = hash;
+    entry->expires_ms = ttl_ms == TCS_WAIT_INF ? INT64_MAX : tcs_time_monotonic_ms() + ttl_ms;
+    entry->result = result;
+    entry->address_count = address_count;
+    if (address_count > 0)
+        memcpy(entry->addresses, addresses, address_count * sizeof(struct TcsAddress));
+    entry->chain_next = cache->buckets[hash & cache->bucket_mask];
+    cache->buckets[hash & cache->bucket_mask] = index;
+    address_cache_lru_push(cache, index);
+}
+
+// Fills the output the same way as tcs_address_resolve() fills it from getaddrinfo()
+static void address_cache_copy_out(const struct TcsAddress addresses[],
+                                   size_t address_count,
+                                   struct TcsAddress out_addresses[],
+                                   size_t addresses_length,
+                                   size_t* out_length)
+{
+    if (out_addresses != NULL)
+    {
+        if (address_count > addresses_length)
+            address_count = addresses_length;
+        if (address_count > 0)
+            memcpy(out_addresses, addresses, address_count * sizeof(struct TcsAddress));
+    }
+    if (out_length != NULL)
+        *out_length = address_count;
+}
+
+// Returns false on a miss, expired entries are removed. The caller holds the lock.
+static bool address_cache_lookup(struct TcsAddressCache* cache,
+                                 const char* hostname,
+                                 int family,
+                                 struct TcsAddress out_addresses[],
+                                 size_t addresses_length,
+                                 size_t* out_length,
+                                 TcsResult* out_result)
+{
+    size_t index = address_cache_find(cache, hostname, family, address_cache_hash(hostname, family));
+    if (index == ADDRESS_CACHE_END)
+        return false;
+    const struct TcsAddressCacheEntry* entry = &cache->entries[index];
+    if (entry->expires_ms != INT64_MAX && tcs_time_monotonic_ms() >= entry->expires_ms)
+    {
+        address_cache_remove(cache, index);
+        return false;
+    }
+    address_cache_lru_unlink(cache, index);
+    address_cache_lru_push(cache, index);
+    address_cache_copy_out(entry->addresses, entry->address_count, out_addresses, addresses_length, out_length);
+    *out_result = entry->result;
+    return true;
+}
+
+TcsResult tcs_address_resolve(const char* hostname,
+                              TcsFamily address_family,
+                              struct TcsAddress out_addresses[],
+                              size_t addresses_length,
+                              size_t* out_length)
+{
+    if (hostname == NULL)
+        return TCS_ERROR_INVALID_ARGUMENT;
+
+    if (out_addresses == NULL && out_length == NULL)
+        return TCS_ERROR_INVALID_ARGUMENT;
+
+    if (out_length != NULL)
+        *out_length = 0;
+
+    // Fast path: try numeric/MAC parse first to avoid DNS lookup
+    struct TcsAddress parsed = TCS_ADDRESS_NONE;
+    if (tcs_address_parse(hostname, &parsed) == TCS_SUCCESS && parsed.family.native != TCS_FAMILY_ANY.native)
+    {
+        if (address_family.native == TCS_FAMILY_ANY.native || parsed.family.native == address_family.native)
+        {
+            if (out_addresses != NULL && addresses_length > 0)
+                out_addresses[0] = parsed;
+            if (out_length != NULL)
+                *out_length = 1;
+            return TCS_SUCCESS;
+        }
+    }
+
+    if (address_family.native == -1) // sentinel for unsupported families (e.g. TCS_FAMILY_PACKET on Windows)
+        return TCS_ERROR_NOT_SUPPORTED;
+
+    if (strlen(hostname) >= TCS_CFG_ADDRESS_CACHE_HOSTNAME_SIZE)
+        return tcs_os_address_resolve_native(hostname, address_family, out_addresses, addresses_length, out_length);
+
+    tcs_os_global_lock();
+    bool is_cached = address_cache != NULL;
+    TcsResult res = TCS_SUCCESS;
+    if (is_cached && address_cache_lookup(address_cache,
+                                          hostname,
+                                          address_family.native,
+                                          out_addresses,
+                                          addresses_length,
+                                          out_length,
+                                          &res))
+    {
+        tcs_os_global_unlock();
+        return res;
+    }
+    tcs_os_global_unlock();
+    if (!is_cached)
+        return tcs_os_address_resolve_native(hostname, address_family, out_addresses, addresses_length, out_length);
+
+    // Resolve into a buffer of our own so the cache gets the full answer whatever the caller asked for
+    struct TcsAddress found[TCS_CFG_ADDRESS_CACHE_ADDRESSES_MAX];
+    size_t found_count = 0;
+    res = tcs_os_address_resolve_native(hostname,
+                                        address_family,
+                                        found,
+                                        TCS_CFG_ADDRESS_CACHE_ADDRESSES_MAX,
+                                        &found_count);
+
+    tcs_os_global_lock();
+    if (address_cache != NULL)
+    {
+        int ttl_ms = res == TCS_SUCCESS ? address_cache->positive_ttl_ms : address_cache->negative_ttl_ms;
+        bool is_cacheable = res == TCS_SUCCESS || res == TCS_ERROR_ADDRESS_LOOKUP_FAILED;
+        if (is_cacheable && ttl_ms != 0)
+            address_cache_store(address_cache, hostname, address_family.native, res, found, found_count, ttl_ms);
+    }
+    tcs_os_global_unlock();
+
+    if (res != TCS_SUCCESS)
+        return res;
+    address_cache_copy_out(found, found_count, out_addresses, addresses_length, out_length);
+    return TCS_SUCCESS;
+}
+
+TcsResult tcs_address_cache_enable(size_t max_entries, int positive_ttl_ms, int negative_ttl_ms)
+{
+    if (max_entries == 0)
+        return TCS_ERROR_INVALID_ARGUMENT;
+    if ((positive_ttl_ms < 0 && positive_ttl_ms != TCS_WAIT_INF) ||
+        (negative_ttl_ms < 0 && negative_ttl_ms != TCS_WAIT_INF))
+        return TCS_ERROR_INVALID_ARGUMENT;
+
+    size_t bucket_count = 1;
+    while (bucket_count < max_entries)
+        bucket_count *= 2;
+
+    struct TcsAddressCache* cache = (struct TcsAddressCache*)tcs_lib_malloc(sizeof(struct TcsAddressCache));
+    if (cache == NULL)
+        return TCS_ERROR_MEMORY;
+    cache->buckets = (size_t*)tcs_lib_malloc(bucket_count * sizeof(size_t));
+    cache->entries = (struct TcsAddressCacheEntry*)tcs_lib_malloc(max_entries * sizeof(struct TcsAddressCacheEntry));
+    if (cache->buckets == NULL || cache->entries == NULL)
+    {
+        address_cache_free(cache);
+        return TCS_ERROR_MEMORY;
+    }
+    cache->positive_ttl_ms = positive_ttl_ms;
+    cache->negative_ttl_ms = negative_ttl_ms;
+    cache->capacity = max_entries;
+    cache->bucket_mask = bucket_count - 1;
+    address_cache_clear(cache);
+
+    tcs_os_global_lock();
+    struct TcsAddressCache* old_cache = address_cache;
+    address_cache = cache;
+    tcs_os_global_unlock();
+
+    address_cache_free(old_cache);
+    return TCS_SUCCESS;
+}
+
+TcsResult tcs_address_cache_disable(void)
 {
-    if (socket == TCS_SOCKET_INVALID)
-        return TCS_ERROR_INVALID_ARGUMENT;
+    tcs_os_global_lock();
+    struct TcsAddressCache* cache = address_cache;
+    address_cache = NULL;
+    tcs_os_global_unlock();
 
-    return tcs_opt_set(socket, TCS_SOL_SOCKET, TCS_SO_PRIORITY, &priority, sizeof(priority));
+    address_cache_free(cache);
+    return TCS_SUCCESS;
 }
 
-TcsResult tcs_opt_priority_get(TcsSocket socket, int* priority)
+TcsResult tcs_address_cache_prefill(const char* hostname,
+                                    TcsFamily address_family,
+                                    const struct TcsAddress addresses[],
+                                    size_t addresses_length,
+                                    int ttl_ms)
 {
-    if (socket == TCS_SOCKET_INVALID || priority == NULL)
+    if (hostname == NULL || strlen(hostname) >= TCS_CFG_ADDRESS_CACHE_HOSTNAME_SIZE)
+        return TCS_ERROR_INVALID_ARGUMENT;
+    if ((addresses == NULL && addresses_length > 0) || addresses_length > TCS_CFG_ADDRESS_CACHE_ADDRESSES_MAX)
         return TCS_ERROR_INVALID_ARGUMENT;
+    if (ttl_ms < 0 && ttl_ms != TCS_WAIT_INF)
+        return TCS_ERROR_INVALID_ARGUMENT;
+    if (address_family.native == -1)
+        return TCS_ERROR_NOT_SUPPORTED;
 
-    size_t s = sizeof(*priority);
-    return tcs_opt_get(socket, TCS_SOL_SOCKET, TCS_SO_PRIORITY, priority, &s);
+    tcs_os_global_lock();
+    if (address_cache == NULL)
+    {
+        tcs_os_global_unlock();
+        return TCS_ERROR_LIBRARY_NOT_INITIALIZED;
+    }
+    TcsResult result = addresses_length > 0 ? TCS_SUCCESS : TCS_ERROR_ADDRESS_LOOKUP_FAILED;
+    address_cache_store(address_cache, hostname, address_family.native, result, addresses, addresses_length, ttl_ms);
+    tcs_os_global_unlock();
+    return TCS_SUCCESS;
 }
 
-// tcs_opt_nonblocking_set() is defined in OS specific files
-// tcs_opt_nonblocking_get() is defined in OS specific files
-
-// tcs_opt_membership_add() is defined in OS specific files
-
-TcsResult tcs_opt_membership_add_str(TcsSocket socket, const char* multicast_address)
+TcsResult tcs_address_cache_flush(const char* hostname)
 {
-    if (multicast_address == NULL)
-        return TCS_ERROR_INVALID_ARGUMENT;
+    tcs_os_global_lock();
+    if (address_cache != NULL && hostname == NULL)
+    {
+        address_cache_clear(address_cache);
+    }
+    else if (address_cache != NULL)
+    {
+        size_t index = address_cache->lru_head;
+        while (index != ADDRESS_CACHE_END)
+        {
+            size_t next = address_cache->entries[index].lru_next;
+            if (address_cache_hostname_is_equal(address_cache->entries[index].hostname, hostname))
+                address_cache_remove(address_cache, index);
+            index = next;
+        }
+    }
+    tcs_os_global_unlock();
+    return TCS_SUCCESS;
+}
 
-    struct TcsAddress addr = TCS_ADDRESS_NONE;
-    TcsResult res = tcs_address_parse(multicast_address, &addr);
-    if (res != TCS_SUCCESS)
-        return res;
+// Value of a hex digit, or 0xFF for any other character
+static const uint8_t address_hex_lut[256] = {
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, // 0x00
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, // 0x10
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, // 0x20
+    0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, // 0x30
+    0xFF, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E, 0x0F, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, // 0x40
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, // 0x50
+    0xFF, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E, 0x0F, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, // 0x60
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, // 0x70
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, // 0x80
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, // 0x90
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, // 0xA0
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, // 0xB0
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, // 0xC0
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, // 0xD0
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, // 0xE0
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, // 0xF0
+};
 
-    return tcs_opt_membership_add(socket, &addr);
+static inline uint32_t address_digit(char c)
+{
+    return (uint32_t)(unsigned char)c - '0';
 }
 
-// tcs_opt_membership_add_to() is defined in OS specific files
-// tcs_opt_membership_drop() is defined in OS specific files
-
-TcsResult tcs_opt_membership_drop_str(TcsSocket socket, const char* multicast_address)
+// Parses 1 to max_digits decimal digits without a leading zero, the forms where sscanf("%i") would not read octal.
+// Returns the number of characters consumed or 0 if there is no such number.
+static size_t address_decimal_parse(const char* c, size_t max_digits, uint32_t* out_value)
 {
-    if (multicast_address == NULL)
-        return TCS_ERROR_INVALID_ARGUMENT;
+    if (address_digit(c[0]) > 9)
+        return 0;
+    uint32_t value = address_digit(c[0]);
+    size_t digits = 1;
+    while (digits < max_digits && address_digit(c[digits]) <= 9)
+        value = value * 10 + address_digit(c[digits++]);
+    if (address_digit(c[digits]) <= 9 || (c[0] == '0' && digits > 1))
+        return 0;
+    *out_value = value;
+    return digits;
+}
 
-    struct TcsAddress addr = TCS_ADDRESS_NONE;
-    TcsResult res = tcs_address_parse(multicast_address, &addr);
-    if (res != TCS_SUCCESS)
-        return res;
+// "a.b.c.d" and "a.b.c.d:port" in plain decimal
+static bool address_parse_fast_ipv4(const char* c, struct TcsAddress* out_address)
+{
+    uint32_t address = 0;
+    for (int i = 0; i < 4; ++i)
+    {
+        uint32_t octet = 0;
+        size_t length = address_decimal_parse(c, 3, &octet);
+        if (length == 0 || octet > 255)
+            return false;
+        address = address << 8 | octet;
+        c += length;
+        if (i < 3 && *c++ != '.')
+            return false;
+    }
+    uint32_t port = 0;
+    if (*c == ':')
+    {
+        size_t length = address_decimal_parse(c + 1, 5, &port);
+        if (length == 0 || port > UINT16_MAX)
+            return false;
+        c += 1 + length;
+    }
+    if (*c != '\0')
+        return false;
 
-    return tcs_opt_membership_drop(socket, &addr);
+    out_address->family = TCS_FAMILY_IPV4;
+    out_address->data.ipv4.address = address;
+    out_address->data.ipv4.port = (uint16_t)port;
+    return true;
 }
 
-// tcs_opt_membership_drop_from() is defined in OS specific files
-
-// ######## Address and Interface Utilities ########
+// "x:x:x:x:x:x" with one or two hex digits per byte
+static bool address_parse_fast_mac(const char* c, struct TcsAddress* out_address)
+{
+    uint8_t mac[6];
+    for (int i = 0; i < 6; ++i)
+    {
+        uint32_t high = address_hex_lut[(unsigned char)c[0]];
+        if (high > 0xF)
+            return false;
+        uint32_t low = address_hex_lut[(unsigned char)c[1]];
+        mac[i] = (uint8_t)(low > 0xF ? high : high << 4 | low);
+        c += low > 0xF ? 1 : 2;
+        if (*c++ != (i < 5 ? ':' : '\0'))
+            return false;
+    }
 
-// tcs_interface_list() is defined in OS specific files
-// tcs_address_resolve() is defined in OS specific files
-// tcs_address_list() is defined in OS specific files
-// tcs_address_socket_local() is defined in OS specific files
-// tcs_address_socket_remote() is defined in OS specific files
-// tcs_address_socket_family() is defined in OS specific files
+    out_address->family = TCS_FAMILY_PACKET;
+    memcpy(out_address->data.packet.mac, mac, sizeof(mac));
+    return true;
+}
 
-TcsResult tcs_address_parse(const char str[], struct TcsAddress* out_address)
+// Hex groups with at most one "::", an optional decimal scope and, within brackets, an optional port.
+// Embedded IPv4 and anything unusual is left to the DFA.
+static bool address_parse_fast_ipv6(const char* c, struct TcsAddress* out_address)
 {
-    if (out_address == NULL)
-        return TCS_ERROR_INVALID_ARGUMENT;
-    if (str == NULL)
-        return TCS_ERROR_INVALID_ARGUMENT;
+    bool is_bracketed = *c == '[';
+    if (is_bracketed)
+        c++;
 
-    if (str[0] == '\0')
+    uint16_t groups[8];
+    int group_count = 0;
+    int gap_pos = -1;
+    if (c[0] == ':')
     {
-        *out_address = TCS_ADDRESS_NONE;
-        return TCS_SUCCESS;
+        if (c[1] != ':')
+            return false;
+        gap_pos = 0;
+        c += 2;
+    }
+    while (address_hex_lut[(unsigned char)*c] <= 0xF)
+    {
+        uint32_t value = 0;
+        int digits = 0;
+        uint32_t digit;
+        while ((digit = address_hex_lut[(unsigned char)*c]) <= 0xF)
+        {
+            if (++digits > 4)
+                return false;
+            value = value << 4 | digit;
+            c++;
+        }
+        if (group_count == 8)
+            return false;
+        groups[group_count++] = (uint16_t)value;
+        if (c[0] != ':')
+            break;
+        if (c[1] == ':')
+        {
+            if (gap_pos >= 0)
+                return false;
+            gap_pos = group_count;
+            c += 2;
+        }
+        else if (address_hex_lut[(unsigned char)c[1]] <= 0xF)
+        {
+            c++;
+        }
+        else
+        {
+            return false;
+        }
+    }
+    if (gap_pos >= 0 ? group_count > 7 : group_count != 8)
+        return false;
+
+    uint32_t scope_id = 0;
+    if (*c == '%')
+    {
+        // The DFA takes no scope right after "::"
+        if (gap_pos == group_count)
+            return false;
+        uint32_t digit = address_digit(*++c);
+        if (digit > 9)
+            return false;
+        uint64_t value = 0;
+        for (int digits = 0; digit <= 9; digit = address_digit(*++c))
+        {
+            if (++digits > 10)
+                return false;
+            value = value * 10 + digit;
+        }
+        if (value > UINT32_MAX)
+            return false;
+        scope_id = (uint32_t)value;
+    }
+    uint32_t port = 0;
+    if (is_bracketed)
+    {
+        if (*c++ != ']')
+            return false;
+        if (*c == ':')
+        {
+            size_t length = address_decimal_parse(c + 1, 5, &port);
+            if (length == 0 || port > UINT16_MAX)
+                return false;
+            c += 1 + length;
+        }
+    }
+    if (*c != '\0')
+        return false;
+
+    out_address->family = TCS_FAMILY_IPV6;
+    int gap_size = gap_pos >= 0 ? 8 - group_count : 0;
+    for (int i = 0, group = 0; i < 8; ++i)
+    {
+        uint16_t value = (i >= gap_pos && i < gap_pos + gap_size) ? 0 : groups[group++];
+        out_address->data.ipv6.address.bytes[i * 2] = (uint8_t)(value >> 8);
+        out_address->data.ipv6.address.bytes[i * 2 + 1] = (uint8_t)(value & 0xFF);
     }
+    out_address->data.ipv6.port = (uint16_t)port;
+    out_address->data.ipv6.scope_id = (TcsInterfaceId)scope_id;
+    return true;
+}
 
+// Straight-line parsers for the canonical forms, dispatched on the first separator found. Only accepts strings
+// that address_parse_generic() would parse to the same address, everything else is left to it.
+static bool address_parse_fast(const char str[], struct TcsAddress* out_address)
+{
+    const char* c = str;
+    while (address_hex_lut[(unsigned char)*c] <= 0xF)
+        c++;
+    memset(out_address, 0, sizeof(struct TcsAddress));
+    if (*c == '.')
+        return address_parse_fast_ipv4(str, out_address);
+    if (*c == ':')
+        return address_parse_fast_mac(str, out_address) || address_parse_fast_ipv6(str, out_address);
+    if (*c == '[')
+        return address_parse_fast_ipv6(str, out_address);
+    return false;
+}
+
+// Slow but easy parser that handles every accepted form
+static TcsResult address_parse_generic(const char str[], struct TcsAddress* out_address)
+{
     memset(out_address, 0, sizeof(struct TcsAddress));
-    // Slow but easy parser
     int n_colons = 0;
     int n_dots = 0;
     int double_colons = 0;
@@ -7476,29 +14899,84 @@ TcsResult tcs_address_parse(const char str[], struct TcsAddress* out_address)
     return TCS_SUCCESS;
 }
 
-TcsResult tcs_address_to_str(const struct TcsAddress* address, char out_str[], size_t str_length, size_t* out_length)
+TcsResult tcs_address_parse(const char str[], struct TcsAddress* out_address)
 {
-    if (address == NULL)
-        return TCS_ERROR_INVALID_ARGUMENT;
-    if (out_str == NULL && str_length != 0)
+    if (out_address == NULL)
         return TCS_ERROR_INVALID_ARGUMENT;
-    if (out_str == NULL && out_length == NULL)
+    if (str == NULL)
         return TCS_ERROR_INVALID_ARGUMENT;
 
-    char str[70];
-    memset(str, 0, sizeof str);
+    if (str[0] == '\0')
+    {
+        *out_address = TCS_ADDRESS_NONE;
+        return TCS_SUCCESS;
+    }
+
+    if (address_parse_fast(str, out_address))
+        return TCS_SUCCESS;
+    return address_parse_generic(str, out_address);
+}
+
+#define TCS_ADDRESS_STR_SIZE 70 // Fits every supported family, as documented for tcs_address_to_str()
+
+static const char address_decimal_pairs[201] = "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+                                               "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+                                               "8081828384858687888990919293949596979899";
+
+// Writes @p value in decimal, two digits per table lookup, and returns the number of characters
+static size_t address_decimal_write(char* out, uint32_t value)
+{
+    char digits[10];
+    size_t position = sizeof(digits);
+    while (value >= 100)
+    {
+        uint32_t pair = value % 100 * 2;
+        value /= 100;
+        digits[--position] = address_decimal_pairs[pair + 1];
+        digits[--position] = address_decimal_pairs[pair];
+    }
+    if (value >= 10)
+    {
+        digits[--position] = address_decimal_pairs[value * 2 + 1];
+        digits[--position] = address_decimal_pairs[value * 2];
+    }
+    else
+    {
+        digits[--position] = (char)('0' + value);
+    }
+    memcpy(out, digits + position, sizeof(digits) - position);
+    return sizeof(digits) - position;
+}
+
+// Lower case hex without leading zeros, as "%x"
+static size_t address_hex_write(char* out, uint32_t group)
+{
+    static const char hex_digits[] = "0123456789abcdef";
+    size_t length = group >= 0x1000 ? 4 : group >= 0x100 ? 3 : group >= 0x10 ? 2 : 1;
+    for (size_t i = length; i > 0; --i, group >>= 4)
+        out[i - 1] = hex_digits[group & 0xF];
+    return length;
+}
+
+// Formats into @p out without a terminator and returns the length, or 0 for unsupported families.
+// The output is byte for byte what the former snprintf() based formatting produced.
+static size_t address_format(const struct TcsAddress* address, char out[TCS_ADDRESS_STR_SIZE])
+{
+    char* c = out;
     if (address->family.native == TCS_FAMILY_IPV4.native)
     {
         uint32_t d = address->data.ipv4.address;
-        uint16_t p = address->data.ipv4.port;
-        uint8_t b1 = (uint8_t)(d & 0xFF);
-        uint8_t b2 = (uint8_t)((d >> 8) & 0xFF);
-        uint8_t b3 = (uint8_t)((d >> 16) & 0xFF);
-        uint8_t b4 = (uint8_t)((d >> 24) & 0xFF);
-        if (p == 0)
-            snprintf(str, sizeof str, "%i.%i.%i.%i", b4, b3, b2, b1);
-        else
-            snprintf(str, sizeof str, "%i.%i.%i.%i:%i", b4, b3, b2, b1, p);
+        for (int shift = 24; shift >= 0; shift -= 8)
+        {
+            c += address_decimal_write(c, d >> shift & 0xFF);
+            *c++ = '.';
+        }
+        c--;
+        if (address->data.ipv4.port != 0)
+        {
+            *c++ = ':';
+            c += address_decimal_write(c, address->data.ipv4.port);
+        }
     }
     else if (address->family.native == TCS_FAMILY_IPV6.native)
     {
@@ -7507,89 +14985,135 @@ TcsResult tcs_address_to_str(const struct TcsAddress* address, char out_str[], s
             groups[i] = (uint16_t)((unsigned int)address->data.ipv6.address.bytes[i * 2] << 8 |
                                    address->data.ipv6.address.bytes[i * 2 + 1]);
 
-        // Find longest run of consecutive zero groups for :: compression (RFC 5952)
+        // Find longest run of consecutive zero groups for :: compression (RFC 5952), the first one on ties
         int best_start = -1;
-        int best_len = 0;
-        int cur_start = -1;
-        int cur_len = 0;
-        for (int i = 0; i < 8; i++)
+        int best_len = 1;
+        for (int i = 0; i < 8;)
         {
-            if (groups[i] == 0)
-            {
-                if (cur_start < 0)
-                    cur_start = i;
-                cur_len++;
-                if (cur_len > best_len)
-                {
-                    best_start = cur_start;
-                    best_len = cur_len;
-                }
-            }
-            else
+            int run = 0;
+            while (i + run < 8 && groups[i + run] == 0)
+                run++;
+            if (run > best_len)
             {
-                cur_start = -1;
-                cur_len = 0;
+                best_start = i;
+                best_len = run;
             }
+            i += run + 1;
         }
-        if (best_len < 2)
-            best_start = -1;
 
-        char addr_str[46];
-        int pos = 0;
+        uint16_t port = address->data.ipv6.port;
+        TcsInterfaceId scope_id = address->data.ipv6.scope_id;
+        if (port != 0)
+            *c++ = '[';
         for (int i = 0; i < 8; i++)
         {
             if (i == best_start)
             {
-                pos += snprintf(addr_str + pos, sizeof addr_str - (size_t)pos, "::");
+                *c++ = ':';
+                *c++ = ':';
                 i += best_len - 1;
                 continue;
             }
-            if (i > 0 && (best_start < 0 || i != best_start + best_len))
-                addr_str[pos++] = ':';
-            pos += snprintf(addr_str + pos, sizeof addr_str - (size_t)pos, "%x", (unsigned int)groups[i]);
-        }
-        addr_str[pos] = '\0';
-
-        uint16_t p = address->data.ipv6.port;
-        TcsInterfaceId sc = address->data.ipv6.scope_id;
-        if (p != 0 && sc != 0)
-            snprintf(str, sizeof str, "[%s%%%u]:%u", addr_str, (unsigned int)sc, (unsigned int)p);
-        else if (p != 0)
-            snprintf(str, sizeof str, "[%s]:%u", addr_str, (unsigned int)p);
-        else if (sc != 0)
-            snprintf(str, sizeof str, "%s%%%u", addr_str, (unsigned int)sc);
-        else
-            snprintf(str, sizeof str, "%s", addr_str);
+            if (i > 0 && i != best_start + best_len)
+                *c++ = ':';
+            c += address_hex_write(c, groups[i]);
+        }
+        if (scope_id != 0)
+        {
+            *c++ = '%';
+            c += address_decimal_write(c, (uint32_t)scope_id);
+        }
+        if (port != 0)
+        {
+            *c++ = ']';
+            *c++ = ':';
+            c += address_decimal_write(c, port);
+        }
     }
     else if (address->family.native == TCS_FAMILY_PACKET.native)
     {
-        snprintf(str,
-                 sizeof str,
-                 "%02X:%02X:%02X:%02X:%02X:%02X",
-                 address->data.packet.mac[0],
-                 address->data.packet.mac[1],
-                 address->data.packet.mac[2],
-                 address->data.packet.mac[3],
-                 address->data.packet.mac[4],
-                 address->data.packet.mac[5]);
+        static const char hex_digits[] = "0123456789ABCDEF";
+        for (int i = 0; i < 6; ++i)
+        {
+            *c++ = hex_digits[address->data.packet.mac[i] >> 4];
+            *c++ = hex_digits[address->data.packet.mac[i] & 0xF];
+            *c++ = ':';
+        }
+        c--;
     }
-    else
-    {
+    return (size_t)(c - out);
+}
+
+TcsResult tcs_address_to_str(const struct TcsAddress* address, char out_str[], size_t str_length, size_t* out_length)
+{
+    if (address == NULL)
+        return TCS_ERROR_INVALID_ARGUMENT;
+    if (out_str == NULL && str_length != 0)
+        return TCS_ERROR_INVALID_ARGUMENT;
+    if (out_str == NULL && out_length == NULL)
+        return TCS_ERROR_INVALID_ARGUMENT;
+
+    char str[TCS_ADDRESS_STR_SIZE];
+    size_t written = address_format(address, str);
+    if (written == 0)
         return TCS_ERROR_NOT_IMPLEMENTED;
-    }
 
-    size_t written = strlen(str);
     if (out_length != NULL)
         *out_length = written;
     if (out_str == NULL)
         return TCS_SUCCESS;
     if (str_length <= written)
         return TCS_ERROR_MEMORY;
-    memcpy(out_str, str, written + 1);
+    memcpy(out_str, str, written);
+    out_str[written] = '\0';
 
     return TCS_SUCCESS;
 }
 
+TcsResult tcs_address_to_str_many(const struct TcsAddress addresses[],
+                                  size_t addresses_length,
+                                  const char* separator,
+                                  char out_str[],
+                                  size_t str_length,
+                                  size_t* out_length)
+{
+    if (addresses == NULL && addresses_length != 0)
+        return TCS_ERROR_INVALID_ARGUMENT;
+    if (out_str == NULL && str_length != 0)
+        return TCS_ERROR_INVALID_ARGUMENT;
+    if (out_str == NULL && out_length == NULL)
+        return TCS_ERROR_INVALID_ARGUMENT;
+
+    size_t separator_length = separator != NULL ? strlen(separator) : 0;
+    size_t total = 0;
+    bool fits = out_str != NULL && str_length > 0;
+    for (size_t i = 0; i < addresses_length; ++i)
+    {
+        size_t offset = total + (i > 0 ? separator_length : 0);
+        // Format straight into the output while any address fits, only the tail goes through a copy
+        char str[TCS_ADDRESS_STR_SIZE];
+        char* target = fits && str_length > offset + TCS_ADDRESS_STR_SIZE ? out_str + offset : str;
+        size_t written = address_format(&addresses[i], target);
+        if (written == 0)
+            return TCS_ERROR_NOT_IMPLEMENTED;
+        fits = fits && str_length > offset + written;
+        if (fits && i > 0)
+            memcpy(out_str + total, separator, separator_length);
+        if (fits && target == str)
+            memcpy(out_str + offset, str, written);
+        total = offset + written;
+    }
+
+    if (out_length != NULL)
+        *out_length = total;
+    if (out_str == NULL)
+        return TCS_SUCCESS;
+    if (!fits)
+        return TCS_ERROR_MEMORY;
+    out_str[total] = '\0';
+    return TCS_SUCCESS;
+}
+
 bool tcs_address_is_equal(const struct TcsAddress* l, const struct TcsAddress* r)
 {
     if (l == r) // pointer equality also covers NULL == NULL
@@ -7613,6 +15137,47 @@ bool tcs_address_is_equal(const struct TcsAddress* l, const struct TcsAddress* r
     return false;
 }
 
+static inline uint64_t address_hash_mix(uint64_t hash, uint64_t word)
+{
+    hash = (hash ^ word) * 0x9E3779B97F4A7C15ULL;
+    return hash ^ (hash >> 29);
+}
+
+uint64_t tcs_address_hash(const struct TcsAddress* address, uint64_t seed)
+{
+    if (address == NULL)
+        return seed;
+
+    // One multiply per 64 bit word of the fields that tcs_address_is_equal() compares
+    uint64_t hash = address_hash_mix(seed, (uint64_t)(uint32_t)address->family.native);
+    if (address->family.native == TCS_FAMILY_IPV4.native)
+    {
+        hash = address_hash_mix(hash, (uint64_t)address->data.ipv4.address << 16 | address->data.ipv4.port);
+    }
+    else if (address->family.native == TCS_FAMILY_IPV6.native)
+    {
+        uint64_t words[2];
+        memcpy(words, address->data.ipv6.address.bytes, sizeof(words));
+        hash = address_hash_mix(hash, words[0]);
+        hash = address_hash_mix(hash, words[1] ^ address->data.ipv6.port);
+    }
+    else if (address->family.native == TCS_FAMILY_PACKET.native)
+    {
+        uint64_t mac = 0;
+        memcpy(&mac, address->data.packet.mac, sizeof(address->data.packet.mac));
+        hash = address_hash_mix(hash, mac << 16 | address->data.packet.protocol);
+        hash = address_hash_mix(hash, address->data.packet.interface_id);
+    }
+
+    // Final avalanche (MurmurHash3 fmix64) so the low bits used by power of two tables depend on every input bit
+    hash ^= hash >> 33;
+    hash *= 0xFF51AFD7ED558CCDULL;
+    hash ^= hash >> 33;
+    hash *= 0xC4CEB9FE1A85EC53ULL;
+    hash ^= hash >> 33;
+    return hash;
+}
+
 bool tcs_address_is_any(const struct TcsAddress* addr)
 {
     if (addr == NULL)
@@ -7703,5 +15268,83 @@ bool tcs_address_is_supported(const struct TcsAddress* addr)
     return false;
 }
 
+static inline bool address_map_is_equal(const struct TcsAddress* l, const struct TcsAddress* r)
+{
+    return tcs_address_is_equal(l, r);
+}
+
+TDS_HMAP_IMPL(struct TcsAddress, void*, address, tcs_address_hash, address_map_is_equal)
+
+struct TcsAddressMap
+{
+    struct TdsHMap_address map;
+};
+
+TcsResult tcs_address_map_create(struct TcsAddressMap** out_map, size_t capacity_hint)
+{
+    if (out_map == NULL)
+        return TCS_ERROR_INVALID_ARGUMENT;
+
+    *out_map = NULL;
+    struct TcsAddressMap* map = (struct TcsAddressMap*)tcs_lib_malloc(sizeof(struct TcsAddressMap));
+    if (map == NULL)
+        return TCS_ERROR_MEMORY;
+    // Per map seed so remote peers can not pick addresses that collide in every process
+    uint64_t seed = (uint64_t)tcs_time_monotonic_ms() ^ (uint64_t)(uintptr_t)map;
+    tds_hmap_address_create(&map->map, tcs_address_hash(NULL, seed) * 0x9E3779B97F4A7C15ULL);
+    if (tds_hmap_address_reserve(&map->map, capacity_hint) != 0)
+    {
+        tcs_lib_free(map);
+        return TCS_ERROR_MEMORY;
+    }
+    *out_map = map;
+    return TCS_SUCCESS;
+}
+
+TcsResult tcs_address_map_destroy(struct TcsAddressMap** map)
+{
+    if (map == NULL || *map == NULL)
+        return TCS_ERROR_INVALID_ARGUMENT;
+
+    tds_hmap_address_destroy(&(*map)->map);
+    tcs_lib_free(*map);
+    *map = NULL;
+    return TCS_SUCCESS;
+}
+
+TcsResult tcs_address_map_set(struct TcsAddressMap* map, const struct TcsAddress* address, void* value)
+{
+    if (map == NULL || address == NULL)
+        return TCS_ERROR_INVALID_ARGUMENT;
+
+    if (tds_hmap_address_set(&map->map, address, &value) != 0)
+        return TCS_ERROR_MEMORY;
+    return TCS_SUCCESS;
+}
+
+void* tcs_address_map_get(const struct TcsAddressMap* map, const struct TcsAddress* address)
+{
+    if (map == NULL || address == NULL)
+        return NULL;
+
+    void** value = tds_hmap_address_get(&map->map, address);
+    return value != NULL ? *value : NULL;
+}
+
+TcsResult tcs_address_map_remove(struct TcsAddressMap* map, const struct TcsAddress* address)
+{
+    if (map == NULL || address == NULL)
+        return TCS_ERROR_INVALID_ARGUMENT;
+
+    if (tds_hmap_address_remove(&map->map, address) != 0)
+        return TCS_ERROR_INVALID_ARGUMENT;
+    return TCS_SUCCESS;
+}
+
+size_t tcs_address_map_count(const struct TcsAddressMap* map)
+{
+    return map != NULL ? map->map.count : 0;
+}
+
 #endif
 #endif
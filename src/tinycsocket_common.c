@@ -25,13 +25,17 @@
 
 // This file should never call OS dependent code. Do not include OS files of OS specific ifdefs
 
+#ifndef TINYDATASTRUCTURES_H_
+#include "tinydatastructures.h"
+#endif
+
 #ifdef DO_WRAP
 #include "dbg_wrap.h"
 #endif
 
 #include <stdbool.h>
-#include <stdio.h>  //sprintf
-#include <stdlib.h> // malloc, free
+#include <stdio.h>  //sprintf, fopen for resolv.conf and hosts
+#include <stdlib.h> // malloc, realloc, free for the default allocator
 #include <string.h> // memset
 
 const char* const TCS_LICENSE_TXT =
@@ -55,10 +59,116 @@ const char* const TCS_LICENSE_TXT =
     "OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE "
     "SOFTWARE.";
 
+// ######## OS Primitives ########
+
+// Thin wrappers around OS facilities for the code in this file, defined in OS specific files. Not public API.
+
+size_t tcs_os_steering_cpu_count(void); // CPUs a SO_REUSEPORT group can steer between, 0 if not supported
+
+struct TcsOsMutex; // Non recursive lock between threads
+TcsResult tcs_os_mutex_create(struct TcsOsMutex** out_mutex);
+void tcs_os_mutex_destroy(struct TcsOsMutex** mutex);
+void tcs_os_mutex_lock(struct TcsOsMutex* mutex);
+void tcs_os_mutex_unlock(struct TcsOsMutex* mutex);
+
+// One process wide lock for library state, usable without any setup
+void tcs_os_global_lock(void);
+void tcs_os_global_unlock(void);
+
+// The system resolver, tcs_address_resolve() without parsing and caching
+TcsResult tcs_os_address_resolve_native(const char* hostname,
+                                        TcsFamily address_family,
+                                        struct TcsAddress out_addresses[],
+                                        size_t addresses_length,
+                                        size_t* out_length);
+
+struct TcsOsThread;
+TcsResult tcs_os_thread_create(struct TcsOsThread** out_thread, void (*function)(void*), void* arg);
+void tcs_os_thread_join(struct TcsOsThread** thread); // Waits for the thread to return and frees it
+
+struct TcsOsSemaphore; // Counting, starts at zero
+TcsResult tcs_os_semaphore_create(struct TcsOsSemaphore** out_semaphore);
+void tcs_os_semaphore_destroy(struct TcsOsSemaphore** semaphore);
+void tcs_os_semaphore_post(struct TcsOsSemaphore* semaphore);
+void tcs_os_semaphore_wait(struct TcsOsSemaphore* semaphore);
+
+struct TcsOsWakeup; // Can be waited on with TcsPoll, readable while set. Only set when cleared and vice versa.
+TcsResult tcs_os_wakeup_create(struct TcsOsWakeup** out_wakeup);
+void tcs_os_wakeup_destroy(struct TcsOsWakeup** wakeup);
+TcsSocket tcs_os_wakeup_socket(const struct TcsOsWakeup* wakeup);
+void tcs_os_wakeup_set(struct TcsOsWakeup* wakeup, bool is_set);
+
+// Waits for non-blocking connects without allocating. Sockets that are TCS_SOCKET_INVALID are skipped. Sets
+// TCS_SUCCESS, an error or TCS_IN_PROGRESS per socket, at most TCS_CFG_CONNECT_CANDIDATES_MAX sockets.
+TcsResult tcs_os_connect_wait(const TcsSocket sockets[], size_t sockets_length, TcsResult out_results[], int timeout_ms);
+
+// Fills with bytes from the OS entropy source, TCS_ERROR_NOT_SUPPORTED if there is none
+TcsResult tcs_os_random(uint8_t* out_bytes, size_t length);
+
 // ######## Library Management ########
 
 // tcs_lib_init() is defined in OS specific files
 // tcs_lib_cleanup() is defined in OS specific files
+// tcs_time_monotonic_ms() is defined in OS specific files
+
+static void* tcs_default_alloc(size_t size, void* context)
+{
+    (void)context;
+    return malloc(size);
+}
+
+static void* tcs_default_realloc(void* ptr, size_t size, void* context)
+{
+    (void)context;
+    return realloc(ptr, size);
+}
+
+static void tcs_default_free(void* ptr, void* context)
+{
+    (void)context;
+    free(ptr);
+}
+
+static TcsAllocFn tcs_alloc_fn = tcs_default_alloc;
+static TcsReallocFn tcs_realloc_fn = tcs_default_realloc;
+static TcsFreeFn tcs_free_fn = tcs_default_free;
+static void* tcs_alloc_context = NULL;
+
+TcsResult tcs_lib_set_allocator(TcsAllocFn alloc_fn, TcsReallocFn realloc_fn, TcsFreeFn free_fn, void* context)
+{
+    if (alloc_fn == NULL && realloc_fn == NULL && free_fn == NULL)
+    {
+        tcs_alloc_fn = tcs_default_alloc;
+        tcs_realloc_fn = tcs_default_realloc;
+        tcs_free_fn = tcs_default_free;
+        tcs_alloc_context = NULL;
+        return TCS_SUCCESS;
+    }
+    if (alloc_fn == NULL || realloc_fn == NULL || free_fn == NULL)
+        return TCS_ERROR_INVALID_ARGUMENT;
+
+    tcs_alloc_fn = alloc_fn;
+    tcs_realloc_fn = realloc_fn;
+    tcs_free_fn = free_fn;
+    tcs_alloc_context = context;
+    return TCS_SUCCESS;
+}
+
+void* tcs_lib_malloc(size_t size)
+{
+    return tcs_alloc_fn(size, tcs_alloc_context);
+}
+
+void* tcs_lib_realloc(void* ptr, size_t size)
+{
+    return tcs_realloc_fn(ptr, size, tcs_alloc_context);
+}
+
+void tcs_lib_free(void* ptr)
+{
+    if (ptr != NULL)
+        tcs_free_fn(ptr, tcs_alloc_context);
+}
 
 const char* tcs_strerror(TcsResult result)
 {
@@ -117,6 +227,7 @@ const char* tcs_strerror(TcsResult result)
 // ######## Socket Creation ########
 
 // tcs_socket() is defined in OS specific files
+// tcs_socket_with_flags() is defined in OS specific files
 
 TcsResult tcs_socket_tcp(TcsSocket* out_socket,
                          const struct TcsAddress* local_address,
@@ -135,7 +246,10 @@ TcsResult tcs_socket_tcp(TcsSocket* out_socket,
 
     TcsFamily family = local_address != NULL ? local_address->family : remote_address->family;
 
-    TcsResult res = tcs_socket(out_socket, family, TCS_SOCKET_STREAM, TCS_PROTOCOL_IP_TCP);
+    // Created non-blocking so tcs_connect_timeout() does not switch modes, blocking mode is set once when connected
+    bool is_timed = remote_address != NULL && timeout_ms != TCS_WAIT_INF;
+    uint32_t flags = TCS_SOCKET_FLAG_CLOEXEC | (is_timed ? TCS_SOCKET_FLAG_NONBLOCKING : TCS_FLAG_NONE);
+    TcsResult res = tcs_socket_with_flags(out_socket, family, TCS_SOCKET_STREAM, TCS_PROTOCOL_IP_TCP, flags);
     if (res != TCS_SUCCESS)
         return res;
 
@@ -157,77 +271,83 @@ TcsResult tcs_socket_tcp(TcsSocket* out_socket,
 
     if (remote_address != NULL)
     {
-        if (timeout_ms == TCS_WAIT_INF)
+        res = tcs_connect_timeout(*out_socket, remote_address, timeout_ms);
+        if (res == TCS_SUCCESS && is_timed)
+            res = tcs_opt_nonblocking_set(*out_socket, false);
+        if (res != TCS_SUCCESS)
         {
-            res = tcs_connect(*out_socket, remote_address);
-            if (res != TCS_SUCCESS)
-            {
-                tcs_close(out_socket);
-                return res;
-            }
+            tcs_close(out_socket);
+            return res;
+        }
+    }
+
+    return TCS_SUCCESS;
+}
+
+// Splits "host:port" and "[host]:port". More than one colon without brackets is an IPv6 address without port.
+static TcsResult host_port_split(const char* str, char* out_host, size_t host_size, uint16_t* out_port)
+{
+    const char* host_begin = str;
+    const char* host_end = NULL;
+    const char* port_str = NULL;
+    if (str[0] == '[')
+    {
+        host_begin = str + 1;
+        host_end = strchr(host_begin, ']');
+        if (host_end == NULL)
+            return TCS_ERROR_INVALID_ARGUMENT;
+        if (host_end[1] == ':')
+            port_str = host_end + 2;
+        else if (host_end[1] != '\0')
+            return TCS_ERROR_INVALID_ARGUMENT;
+    }
+    else
+    {
+        const char* colon = strchr(str, ':');
+        if (colon != NULL && strchr(colon + 1, ':') == NULL)
+        {
+            host_end = colon;
+            port_str = colon + 1;
         }
         else
         {
-            res = tcs_opt_nonblocking_set(*out_socket, true);
-            if (res != TCS_SUCCESS)
-            {
-                tcs_close(out_socket);
-                return res;
-            }
-            res = tcs_connect(*out_socket, remote_address);
-            if (res != TCS_IN_PROGRESS && res != TCS_SUCCESS)
-            {
-                tcs_close(out_socket);
-                return res;
-            }
-            if (res == TCS_IN_PROGRESS)
-            {
-                struct TcsPoll* poll = NULL;
-                res = tcs_poll_create(&poll);
-                if (res != TCS_SUCCESS)
-                {
-                    tcs_close(out_socket);
-                    return res;
-                }
-                res = tcs_poll_add(poll, *out_socket, NULL, TCS_POLL_WRITE);
-                if (res != TCS_SUCCESS)
-                {
-                    tcs_poll_destroy(&poll);
-                    tcs_close(out_socket);
-                    return res;
-                }
-                struct TcsPollEvent event = TCS_POLL_EVENT_EMPTY;
-                size_t out_events_length = 0;
-                res = tcs_poll_wait(poll, &event, 1, &out_events_length, timeout_ms);
-                tcs_poll_destroy(&poll);
-                if (res == TCS_ERROR_TIMED_OUT)
-                {
-                    tcs_close(out_socket);
-                    return TCS_ERROR_TIMED_OUT;
-                }
-                if (res != TCS_SUCCESS || out_events_length == 0)
-                {
-                    tcs_close(out_socket);
-                    return res != TCS_SUCCESS ? res : TCS_ERROR_UNKNOWN;
-                }
-                if (event.error != TCS_SUCCESS)
-                {
-                    tcs_close(out_socket);
-                    return TCS_ERROR_CONNECTION_REFUSED;
-                }
-            }
-            res = tcs_opt_nonblocking_set(*out_socket, false);
-            if (res != TCS_SUCCESS)
-            {
-                tcs_close(out_socket);
-                return res;
-            }
+            host_end = str + strlen(str);
+        }
+    }
+
+    *out_port = 0;
+    if (port_str != NULL)
+    {
+        uint32_t port = 0;
+        if (*port_str == '\0')
+            return TCS_ERROR_INVALID_ARGUMENT;
+        for (const char* c = port_str; *c != '\0'; ++c)
+        {
+            if (*c < '0' || *c > '9')
+                return TCS_ERROR_INVALID_ARGUMENT;
+            port = port * 10 + (uint32_t)(*c - '0');
+            if (port > 0xFFFF)
+                return TCS_ERROR_INVALID_ARGUMENT;
         }
+        *out_port = (uint16_t)port;
     }
 
+    size_t host_length = (size_t)(host_end - host_begin);
+    if (host_length == 0 || host_length >= host_size)
+        return TCS_ERROR_INVALID_ARGUMENT;
+    memcpy(out_host, host_begin, host_length);
+    out_host[host_length] = '\0';
     return TCS_SUCCESS;
 }
 
+static void address_port_set(struct TcsAddress* address, uint16_t port)
+{
+    if (address->family.native == TCS_FAMILY_IPV4.native)
+        address->data.ipv4.port = port;
+    else if (address->family.native == TCS_FAMILY_IPV6.native)
+        address->data.ipv6.port = port;
+}
+
 TcsResult tcs_socket_tcp_str(TcsSocket* out_socket,
                              const char* local_address,
                              const char* remote_address,
@@ -239,7 +359,6 @@ TcsResult tcs_socket_tcp_str(TcsSocket* out_socket,
         return TCS_ERROR_INVALID_ARGUMENT;
 
     struct TcsAddress local_addr = TCS_ADDRESS_NONE;
-    struct TcsAddress remote_addr = TCS_ADDRESS_NONE;
     TcsFamily family = TCS_FAMILY_ANY;
 
     if (local_address != NULL)
@@ -253,20 +372,189 @@ TcsResult tcs_socket_tcp_str(TcsSocket* out_socket,
         family = local_addr.family;
     }
 
-    if (remote_address != NULL)
+    if (remote_address == NULL)
+        return tcs_socket_tcp(out_socket, &local_addr, NULL, timeout_ms);
+
+    // Resolve the host without the port to get every candidate, also for host names
+    char host[256];
+    uint16_t port = 0;
+    TcsResult res = host_port_split(remote_address, host, sizeof(host), &port);
+    if (res != TCS_SUCCESS)
+        return res;
+
+    struct TcsAddress candidates[TCS_CFG_CONNECT_CANDIDATES_MAX];
+    size_t count = 0;
+    res = tcs_address_resolve(host, family, candidates, TCS_CFG_CONNECT_CANDIDATES_MAX, &count);
+    if (res != TCS_SUCCESS)
+        return res;
+    if (count == 0)
+        return TCS_ERROR_ADDRESS_LOOKUP_FAILED;
+    for (size_t i = 0; i < count; ++i)
+        address_port_set(&candidates[i], port);
+
+    return tcs_socket_tcp_any(out_socket, local_address != NULL ? &local_addr : NULL, candidates, count, timeout_ms);
+}
+
+// RFC 8305 section 4: alternate between the families, starting with the family of the first address
+static void interleave_families(struct TcsAddress addresses[], size_t count)
+{
+    struct TcsAddress first_family[TCS_CFG_CONNECT_CANDIDATES_MAX];
+    struct TcsAddress other_family[TCS_CFG_CONNECT_CANDIDATES_MAX];
+    size_t first_count = 0;
+    size_t other_count = 0;
+    for (size_t i = 0; i < count; ++i)
     {
-        size_t count = 0;
-        TcsResult res = tcs_address_resolve(remote_address, family, &remote_addr, 1, &count);
-        if (res != TCS_SUCCESS)
-            return res;
-        if (count == 0)
-            return TCS_ERROR_ADDRESS_LOOKUP_FAILED;
+        if (addresses[i].family.native == addresses[0].family.native)
+            first_family[first_count++] = addresses[i];
+        else
+            other_family[other_count++] = addresses[i];
+    }
+
+    size_t n = 0;
+    for (size_t i = 0; n < count; ++i)
+    {
+        if (i < first_count)
+            addresses[n++] = first_family[i];
+        if (i < other_count)
+            addresses[n++] = other_family[i];
+    }
+}
+
+static TcsResult connect_attempt_start(TcsSocket* out_socket,
+                                       const struct TcsAddress* local_address,
+                                       const struct TcsAddress* remote_address)
+{
+    TcsResult res = tcs_socket_with_flags(out_socket,
+                                          remote_address->family,
+                                          TCS_SOCKET_STREAM,
+                                          TCS_PROTOCOL_IP_TCP,
+                                          TCS_SOCKET_FLAG_NONBLOCKING | TCS_SOCKET_FLAG_CLOEXEC);
+    if (res != TCS_SUCCESS)
+        return res;
+    if (local_address != NULL)
+    {
+        res = tcs_opt_reuse_address_set(*out_socket, true);
+        if (res == TCS_SUCCESS)
+            res = tcs_bind(*out_socket, local_address);
+    }
+    if (res == TCS_SUCCESS)
+        res = tcs_connect(*out_socket, remote_address);
+    if (res != TCS_SUCCESS && res != TCS_IN_PROGRESS)
+        tcs_close(out_socket);
+    return res;
+}
+
+TcsResult tcs_socket_tcp_any(TcsSocket* out_socket,
+                             const struct TcsAddress* local_address,
+                             const struct TcsAddress remote_addresses[],
+                             size_t remote_addresses_length,
+                             int timeout_ms)
+{
+    if (out_socket == NULL || *out_socket != TCS_SOCKET_INVALID)
+        return TCS_ERROR_INVALID_ARGUMENT;
+    if (remote_addresses == NULL || remote_addresses_length == 0)
+        return TCS_ERROR_INVALID_ARGUMENT;
+    if (timeout_ms < 0 && timeout_ms != TCS_WAIT_INF)
+        return TCS_ERROR_INVALID_ARGUMENT;
+
+    struct TcsAddress candidates[TCS_CFG_CONNECT_CANDIDATES_MAX];
+    size_t count = 0;
+    for (size_t i = 0; i < remote_addresses_length && count < TCS_CFG_CONNECT_CANDIDATES_MAX; ++i)
+    {
+        if (local_address == NULL || local_address->family.native == remote_addresses[i].family.native)
+            candidates[count++] = remote_addresses[i];
+    }
+    if (count == 0)
+        return TCS_ERROR_INVALID_ARGUMENT;
+    if (count == 1)
+        return tcs_socket_tcp(out_socket, local_address, &candidates[0], timeout_ms); // Nothing to race
+    interleave_families(candidates, count);
+
+    TcsSocket attempts[TCS_CFG_CONNECT_CANDIDATES_MAX];
+    TcsResult results[TCS_CFG_CONNECT_CANDIDATES_MAX];
+    for (size_t i = 0; i < count; ++i)
+        attempts[i] = TCS_SOCKET_INVALID;
+
+    int64_t now = tcs_time_monotonic_ms();
+    const int64_t deadline = timeout_ms == TCS_WAIT_INF ? INT64_MAX : now + timeout_ms;
+    int64_t next_attempt_time = now;
+    size_t next = 0;
+    size_t pending = 0;
+    TcsSocket* winner = NULL;
+    TcsResult last_error = TCS_ERROR_CONNECTION_REFUSED;
+    TcsResult res = TCS_SUCCESS;
+    while (winner == NULL)
+    {
+        now = tcs_time_monotonic_ms();
+        if (next < count && (pending == 0 || now >= next_attempt_time))
+        {
+            TcsSocket* attempt = &attempts[next];
+            res = connect_attempt_start(attempt, local_address, &candidates[next]);
+            next++;
+            if (res == TCS_SUCCESS)
+            {
+                winner = attempt;
+            }
+            else if (res == TCS_IN_PROGRESS)
+            {
+                pending++;
+                next_attempt_time = now + TCS_CFG_CONNECT_ATTEMPT_DELAY_MS;
+            }
+            else
+            {
+                last_error = res;
+            }
+            continue;
+        }
+        if (pending == 0)
+            break; // Every candidate failed
+        if (now >= deadline)
+        {
+            last_error = TCS_ERROR_TIMED_OUT;
+            break;
+        }
+
+        int64_t wake_time = next < count && next_attempt_time < deadline ? next_attempt_time : deadline;
+        int wait_ms = wake_time == INT64_MAX ? TCS_WAIT_INF : (int)(wake_time - now);
+        res = tcs_os_connect_wait(attempts, next, results, wait_ms);
+        if (res != TCS_SUCCESS && res != TCS_ERROR_TIMED_OUT)
+        {
+            last_error = res;
+            break;
+        }
+        for (size_t i = 0; i < next && res == TCS_SUCCESS && winner == NULL; ++i)
+        {
+            if (attempts[i] == TCS_SOCKET_INVALID || results[i] == TCS_IN_PROGRESS)
+                continue;
+            if (results[i] == TCS_SUCCESS)
+            {
+                winner = &attempts[i];
+                continue;
+            }
+            // A failed attempt starts the next one at once instead of waiting for the delay
+            tcs_close(&attempts[i]);
+            pending--;
+            last_error = results[i];
+            next_attempt_time = now;
+        }
     }
 
-    return tcs_socket_tcp(out_socket,
-                          local_address != NULL ? &local_addr : NULL,
-                          remote_address != NULL ? &remote_addr : NULL,
-                          timeout_ms);
+    for (size_t i = 0; i < count; ++i)
+    {
+        if (&attempts[i] != winner && attempts[i] != TCS_SOCKET_INVALID)
+            tcs_close(&attempts[i]);
+    }
+    if (winner == NULL)
+        return last_error;
+
+    res = tcs_opt_nonblocking_set(*winner, false);
+    if (res != TCS_SUCCESS)
+    {
+        tcs_close(winner);
+        return res;
+    }
+    *out_socket = *winner;
+    return TCS_SUCCESS;
 }
 
 TcsResult tcs_socket_udp(TcsSocket* out_socket,
@@ -425,13 +713,13 @@ TcsResult tcs_socket_packet_str(TcsSocket* out_socket,
 
     if (count > 16)
     {
-        interfaces = (struct TcsInterface*)malloc(count * sizeof(struct TcsInterface));
+        interfaces = (struct TcsInterface*)tcs_lib_malloc(count * sizeof(struct TcsInterface));
         if (interfaces == NULL)
             return TCS_ERROR_MEMORY;
         res = tcs_interface_list(interfaces, count, &count);
         if (res != TCS_SUCCESS)
         {
-            free(interfaces);
+            tcs_lib_free(interfaces);
             return res;
         }
     }
@@ -445,22 +733,78 @@ TcsResult tcs_socket_packet_str(TcsSocket* out_socket,
             bind_address.data.packet.interface_id = interfaces[i].id;
             bind_address.data.packet.protocol = protocol;
             if (interfaces != stack_buf)
-                free(interfaces);
+                tcs_lib_free(interfaces);
             return tcs_socket_packet(out_socket, &bind_address, type);
         }
     }
 
     if (interfaces != stack_buf)
-        free(interfaces);
+        tcs_lib_free(interfaces);
     return TCS_ERROR_INVALID_ARGUMENT;
 }
 
 // tcs_close() is defined in OS specific files
 
+TcsResult tcs_socket_per_cpu(TcsSocket out_sockets[],
+                             size_t sockets_length,
+                             TcsSocketType type,
+                             const struct TcsAddress* local_address,
+                             size_t* out_sockets_count)
+{
+    if (out_sockets == NULL || sockets_length == 0 || local_address == NULL || out_sockets_count == NULL)
+        return TCS_ERROR_INVALID_ARGUMENT;
+    if (type.native != TCS_SOCKET_STREAM.native && type.native != TCS_SOCKET_DGRAM.native)
+        return TCS_ERROR_INVALID_ARGUMENT;
+    for (size_t i = 0; i < sockets_length; ++i)
+    {
+        if (out_sockets[i] != TCS_SOCKET_INVALID)
+            return TCS_ERROR_INVALID_ARGUMENT;
+    }
+    *out_sockets_count = 0;
+
+    size_t cpu_count = tcs_os_steering_cpu_count();
+    if (cpu_count == 0)
+        return TCS_ERROR_NOT_SUPPORTED;
+    size_t count = cpu_count < sockets_length ? cpu_count : sockets_length;
+
+    bool is_stream = type.native == TCS_SOCKET_STREAM.native;
+    TcsProtocol protocol = is_stream ? TCS_PROTOCOL_IP_TCP : TCS_PROTOCOL_IP_UDP;
+    struct TcsAddress bind_address = *local_address;
+    TcsResult sts = TCS_SUCCESS;
+    for (size_t i = 0; i < count && sts == TCS_SUCCESS; ++i)
+    {
+        // The group index is the join order, so each socket must be bound (and listening) before the next
+        sts = tcs_socket(&out_sockets[i], local_address->family, type, protocol);
+        if (sts == TCS_SUCCESS)
+            sts = tcs_opt_reuse_port_set(out_sockets[i], true);
+        if (sts == TCS_SUCCESS)
+            sts = tcs_bind(out_sockets[i], &bind_address);
+        if (sts == TCS_SUCCESS && i == 0)
+            sts = tcs_address_socket_local(out_sockets[i], &bind_address); // Resolve port 0 once
+        if (sts == TCS_SUCCESS && is_stream)
+            sts = tcs_listen(out_sockets[i], TCS_BACKLOG_MAX);
+    }
+    if (sts == TCS_SUCCESS)
+        sts = tcs_opt_reuse_port_steer_by_cpu(out_sockets[0], count);
+
+    if (sts != TCS_SUCCESS)
+    {
+        for (size_t i = 0; i < count; ++i)
+        {
+            if (out_sockets[i] != TCS_SOCKET_INVALID)
+                tcs_close(&out_sockets[i]);
+        }
+        return sts;
+    }
+    *out_sockets_count = count;
+    return TCS_SUCCESS;
+}
+
 // ######## Socket Operations ########
 
 // tcs_bind() is defined in OS specific files
 // tcs_connect() is defined in OS specific files
+// tcs_connect_timeout() is defined in OS specific files
 
 TcsResult tcs_connect_str(TcsSocket socket, const char* remote_address, uint16_t port)
 {
@@ -515,6 +859,7 @@ TcsResult tcs_connect_str(TcsSocket socket, const char* remote_address, uint16_t
 
 // tcs_listen() is defined in OS specific files
 // tcs_accept() is defined in OS specific files
+// tcs_accept_many() is defined in OS specific files
 // tcs_shutdown() is defined in OS specific files
 
 // ######## Data Transfer ########
@@ -724,43 +1069,2029 @@ TcsResult tcs_receive_netstring(TcsSocket socket, uint8_t* buffer, size_t buffer
 // tcs_poll_remove() is defined in OS specific files
 // tcs_poll_wait() is defined in OS specific files
 
-// ######## Socket Options ########
+// ######## Bulk Connect ########
 
-// tcs_opt_set() is defined in OS specific files
-// tcs_opt_get() is defined in OS specific files
+#define TCS_CONNECTOR_EVENTS_MAX 64
 
-TcsResult tcs_opt_broadcast_set(TcsSocket socket, bool do_allow_broadcast)
+struct TcsConnectorTarget
 {
-    if (socket == TCS_SOCKET_INVALID)
+    struct TcsAddress address;
+    TcsSocket socket;
+    TcsResult result; // TCS_IN_PROGRESS until the target has finished
+    int64_t deadline;
+    bool is_polled;
+    bool is_taken;
+};
+
+struct TcsConnector
+{
+    struct TcsPoll* poll;
+    struct TcsConnectorTarget* targets;
+    size_t targets_length;
+    struct TcsPollEvent events[TCS_CONNECTOR_EVENTS_MAX]; // Kept here to keep tcs_connector_run() stack frame small
+};
+
+TcsResult tcs_connector_create(struct TcsConnector** out_connector,
+                               const struct TcsAddress remote_addresses[],
+                               size_t remote_addresses_length)
+{
+    if (out_connector == NULL || *out_connector != NULL)
+        return TCS_ERROR_INVALID_ARGUMENT;
+    if (remote_addresses == NULL || remote_addresses_length == 0)
         return TCS_ERROR_INVALID_ARGUMENT;
 
-    int b = do_allow_broadcast ? 1 : 0;
-    return tcs_opt_set(socket, TCS_SOL_SOCKET, TCS_SO_BROADCAST, &b, sizeof(b));
+    struct TcsConnector* connector = (struct TcsConnector*)tcs_lib_malloc(sizeof(struct TcsConnector));
+    if (connector == NULL)
+        return TCS_ERROR_MEMORY;
+    connector->poll = NULL;
+    connector->targets_length = remote_addresses_length;
+    connector->targets =
+        (struct TcsConnectorTarget*)tcs_lib_malloc(remote_addresses_length * sizeof(struct TcsConnectorTarget));
+    if (connector->targets == NULL)
+    {
+        tcs_lib_free(connector);
+        return TCS_ERROR_MEMORY;
+    }
+    TcsResult res = tcs_poll_create(&connector->poll);
+    if (res != TCS_SUCCESS)
+    {
+        tcs_lib_free(connector->targets);
+        tcs_lib_free(connector);
+        return res;
+    }
+
+    for (size_t i = 0; i < remote_addresses_length; ++i)
+    {
+        connector->targets[i].address = remote_addresses[i];
+        connector->targets[i].socket = TCS_SOCKET_INVALID;
+        connector->targets[i].result = TCS_IN_PROGRESS;
+        connector->targets[i].deadline = INT64_MAX;
+        connector->targets[i].is_polled = false;
+        connector->targets[i].is_taken = false;
+    }
+    *out_connector = connector;
+    return TCS_SUCCESS;
 }
 
-TcsResult tcs_opt_type_get(TcsSocket socket, TcsSocketType* type)
+TcsResult tcs_connector_destroy(struct TcsConnector** connector)
 {
-    if (socket == TCS_SOCKET_INVALID || type == NULL)
+    if (connector == NULL || *connector == NULL)
         return TCS_ERROR_INVALID_ARGUMENT;
-    int t = 0;
-    size_t s = sizeof(t);
-    TcsResult sts = tcs_opt_get(socket, TCS_SOL_SOCKET, TCS_SO_TYPE, &t, &s);
-    type->native = t;
-    return sts;
+
+    for (size_t i = 0; i < (*connector)->targets_length; ++i)
+    {
+        if ((*connector)->targets[i].socket != TCS_SOCKET_INVALID)
+            tcs_close(&(*connector)->targets[i].socket);
+    }
+    tcs_poll_destroy(&(*connector)->poll);
+    tcs_lib_free((*connector)->targets);
+    tcs_lib_free(*connector);
+    *connector = NULL;
+    return TCS_SUCCESS;
 }
 
-TcsResult tcs_opt_broadcast_get(TcsSocket socket, bool* is_broadcast_allowed)
+static void connector_target_finish(struct TcsConnector* connector, struct TcsConnectorTarget* target, TcsResult result)
 {
-    if (socket == TCS_SOCKET_INVALID || is_broadcast_allowed == NULL)
-        return TCS_ERROR_INVALID_ARGUMENT;
-    int b = 0;
-    size_t s = sizeof(b);
-    TcsResult sts = tcs_opt_get(socket, TCS_SOL_SOCKET, TCS_SO_BROADCAST, &b, &s);
-    *is_broadcast_allowed = b;
-    return sts;
+    if (target->is_polled)
+        tcs_poll_remove(connector->poll, target->socket);
+    target->is_polled = false;
+    if (result == TCS_SUCCESS)
+        result = tcs_opt_nonblocking_set(target->socket, false);
+    if (result != TCS_SUCCESS && target->socket != TCS_SOCKET_INVALID)
+        tcs_close(&target->socket);
+    target->result = result;
 }
 
-TcsResult tcs_opt_keep_alive_set(TcsSocket socket, bool do_keep_alive)
+TcsResult tcs_connector_run(struct TcsConnector* connector,
+                            size_t max_in_flight,
+                            int connect_timeout_ms,
+                            int total_timeout_ms)
+{
+    if (connector == NULL)
+        return TCS_ERROR_INVALID_ARGUMENT;
+    if ((connect_timeout_ms < 0 && connect_timeout_ms != TCS_WAIT_INF) ||
+        (total_timeout_ms < 0 && total_timeout_ms != TCS_WAIT_INF))
+        return TCS_ERROR_INVALID_ARGUMENT;
+
+    const int64_t start = tcs_time_monotonic_ms();
+    const int64_t total_deadline = total_timeout_ms == TCS_WAIT_INF ? INT64_MAX : start + total_timeout_ms;
+    size_t next = 0;
+    size_t in_flight = 0;
+    for (size_t i = 0; i < connector->targets_length; ++i)
+        in_flight += connector->targets[i].is_polled ? 1 : 0;
+    TcsResult res = TCS_SUCCESS;
+    for (;;)
+    {
+        int64_t now = tcs_time_monotonic_ms();
+
+        // Start targets while there is room
+        for (; next < connector->targets_length && (max_in_flight == 0 || in_flight < max_in_flight) &&
+               now < total_deadline;
+             ++next)
+        {
+            struct TcsConnectorTarget* target = &connector->targets[next];
+            if (target->result != TCS_IN_PROGRESS || target->is_polled)
+                continue;
+            TcsResult start_res = tcs_socket_with_flags(&target->socket,
+                                                        target->address.family,
+                                                        TCS_SOCKET_STREAM,
+                                                        TCS_PROTOCOL_IP_TCP,
+                                                        TCS_SOCKET_FLAG_NONBLOCKING | TCS_SOCKET_FLAG_CLOEXEC);
+            if (start_res == TCS_SUCCESS)
+                start_res = tcs_connect(target->socket, &target->address);
+            if (start_res == TCS_IN_PROGRESS)
+            {
+                start_res = tcs_poll_add(connector->poll, target->socket, target, TCS_POLL_WRITE);
+                if (start_res == TCS_SUCCESS)
+                {
+                    target->is_polled = true;
+                    target->deadline = connect_timeout_ms == TCS_WAIT_INF ? INT64_MAX : now + connect_timeout_ms;
+                    in_flight++;
+                    continue;
+                }
+            }
+            // Failed, or connected at once which may happen on loopback
+            connector_target_finish(connector, target, start_res);
+        }
+
+        if (in_flight == 0 && next == connector->targets_length)
+            break;
+
+        // Expire targets and find the next wake up time
+        int64_t wake_time = total_deadline;
+        for (size_t i = 0; i < connector->targets_length; ++i)
+        {
+            struct TcsConnectorTarget* target = &connector->targets[i];
+            if (!target->is_polled)
+                continue;
+            if (now >= target->deadline || now >= total_deadline)
+            {
+                connector_target_finish(connector, target, TCS_ERROR_TIMED_OUT);
+                in_flight--;
+            }
+            else if (target->deadline < wake_time)
+            {
+                wake_time = target->deadline;
+            }
+        }
+        if (now >= total_deadline)
+        {
+            for (; next < connector->targets_length; ++next)
+            {
+                if (connector->targets[next].result == TCS_IN_PROGRESS)
+                    connector->targets[next].result = TCS_ERROR_TIMED_OUT;
+            }
+            res = TCS_ERROR_TIMED_OUT;
+            break;
+        }
+        if (in_flight == 0)
+            continue;
+
+        struct TcsPollEvent* events = connector->events;
+        size_t events_length = 0;
+        int wait_ms = wake_time == INT64_MAX ? TCS_WAIT_INF : (int)(wake_time - now);
+        TcsResult wait_res = tcs_poll_wait(connector->poll, events, TCS_CONNECTOR_EVENTS_MAX, &events_length, wait_ms);
+        if (wait_res != TCS_SUCCESS && wait_res != TCS_ERROR_TIMED_OUT)
+        {
+            res = wait_res;
+            break;
+        }
+        for (size_t i = 0; i < events_length; ++i)
+        {
+            struct TcsConnectorTarget* target = (struct TcsConnectorTarget*)events[i].user_data;
+            if (events[i].error != TCS_SUCCESS)
+                connector_target_finish(connector, target, events[i].error);
+            else if (events[i].can_write)
+                connector_target_finish(connector, target, TCS_SUCCESS);
+            else
+                continue;
+            in_flight--;
+        }
+    }
+    return res;
+}
+
+TcsResult tcs_connector_take(struct TcsConnector* connector, size_t index, TcsSocket* out_socket)
+{
+    if (connector == NULL || index >= connector->targets_length)
+        return TCS_ERROR_INVALID_ARGUMENT;
+    if (out_socket != NULL && *out_socket != TCS_SOCKET_INVALID)
+        return TCS_ERROR_INVALID_ARGUMENT;
+
+    struct TcsConnectorTarget* target = &connector->targets[index];
+    if (target->is_taken)
+        return TCS_ERROR_INVALID_ARGUMENT;
+    if (target->result == TCS_SUCCESS && out_socket != NULL)
+    {
+        *out_socket = target->socket;
+        target->socket = TCS_SOCKET_INVALID;
+        target->is_taken = true;
+    }
+    return target->result;
+}
+
+// ######## Connection Pool ########
+
+#define TCS_POOL_CLOSE_BATCH 16 // Sockets closed after the shard lock is dropped, the rest waits for the next call
+
+struct TcsPoolIdle
+{
+    TcsSocket socket;
+    int64_t idle_since_ms;
+};
+
+struct TcsPoolKey
+{
+    struct TcsAddress address;
+    size_t total;      // Idle and acquired connections, the key is removed when this reaches zero
+    size_t idle_count; // Oldest first
+    struct TcsPoolIdle* idle;
+};
+
+// Keys are allocated one by one so pointers to them stay valid while the map grows
+TDS_HMAP_IMPL(struct TcsAddress, struct TcsPoolKey*, pool_key, tcs_address_hash, tcs_address_is_equal)
+
+struct TcsPoolShard
+{
+    struct TcsOsMutex* lock;
+    struct TdsHMap_pool_key keys;
+    int64_t next_sweep_ms; // Keys nobody touches are only expired by a sweep of the whole shard
+};
+
+struct TcsPool
+{
+    size_t max_idle_per_key;
+    size_t max_total_per_key;
+    int idle_timeout_ms;
+    int connect_timeout_ms;
+    struct TcsPoolShard shards[TCS_CFG_POOL_SHARDS];
+};
+
+// Sockets removed from the pool under the shard lock, closed by pool_closing_flush() without it
+struct TcsPoolClosing
+{
+    TcsSocket sockets[TCS_POOL_CLOSE_BATCH];
+    size_t count;
+};
+
+static void pool_closing_flush(struct TcsPoolClosing* closing)
+{
+    for (size_t i = 0; i < closing->count; ++i)
+        tcs_close(&closing->sockets[i]);
+    closing->count = 0;
+}
+
+static size_t pool_shard_index(const struct TcsAddress* address)
+{
+    return (size_t)(tcs_address_hash(address, 0) % TCS_CFG_POOL_SHARDS);
+}
+
+// Moves idle connections that have passed the idle timeout to closing, they are stored oldest first
+static void pool_key_expire(const struct TcsPool* pool,
+                            struct TcsPoolKey* key,
+                            int64_t now_ms,
+                            struct TcsPoolClosing* closing)
+{
+    if (pool->idle_timeout_ms == TCS_WAIT_INF)
+        return;
+    size_t expired = 0;
+    while (expired < key->idle_count && closing->count < TCS_POOL_CLOSE_BATCH &&
+           now_ms - key->idle[expired].idle_since_ms >= pool->idle_timeout_ms)
+        closing->sockets[closing->count++] = key->idle[expired++].socket;
+    if (expired == 0)
+        return;
+    key->idle_count -= expired;
+    key->total -= expired;
+    memmove(key->idle, key->idle + expired, key->idle_count * sizeof(struct TcsPoolIdle));
+}
+
+// Frees a key without connections, the key pointer is invalid afterwards if it returns true
+static bool pool_key_remove_if_unused(struct TcsPoolShard* shard, struct TcsPoolKey* key)
+{
+    if (key->total > 0)
+        return false;
+    tds_hmap_pool_key_remove(&shard->keys, &key->address);
+    tcs_lib_free(key->idle);
+    tcs_lib_free(key);
+    return true;
+}
+
+// Expires every key of the shard at most once per idle timeout, so keys of addresses that are not used anymore are
+// also removed without making every acquire and release walk the whole shard
+static void pool_shard_sweep(const struct TcsPool* pool,
+                             struct TcsPoolShard* shard,
+                             int64_t now_ms,
+                             struct TcsPoolClosing* closing)
+{
+    if (pool->idle_timeout_ms == TCS_WAIT_INF || now_ms < shard->next_sweep_ms)
+        return;
+    size_t i = 0;
+    while (i < shard->keys.capacity && closing->count < TCS_POOL_CLOSE_BATCH)
+    {
+        if (shard->keys.distances[i] == 0)
+        {
+            ++i;
+            continue;
+        }
+        struct TcsPoolKey* key = shard->keys.values[i];
+        pool_key_expire(pool, key, now_ms, closing);
+        if (!pool_key_remove_if_unused(shard, key))
+            ++i; // Otherwise the removal shifted the next entry into i
+    }
+    if (closing->count < TCS_POOL_CLOSE_BATCH)
+        shard->next_sweep_ms = now_ms + pool->idle_timeout_ms; // A full batch continues the sweep on the next call
+}
+
+// An idle connection should have nothing to read, EOF, a pending error or stray data all make it unusable
+static bool pool_socket_is_alive(TcsSocket socket)
+{
+    uint8_t byte = 0;
+    size_t received = 0;
+    return tcs_receive(socket, &byte, 1, TCS_MSG_PEEK | TCS_MSG_DONTWAIT, &received) == TCS_ERROR_WOULD_BLOCK;
+}
+
+TcsResult tcs_pool_create(struct TcsPool** out_pool,
+                          size_t max_idle_per_key,
+                          size_t max_total_per_key,
+                          int idle_timeout_ms,
+                          int connect_timeout_ms)
+{
+    if (out_pool == NULL || *out_pool != NULL)
+        return TCS_ERROR_INVALID_ARGUMENT;
+    if (max_total_per_key == 0 || max_idle_per_key > max_total_per_key)
+        return TCS_ERROR_INVALID_ARGUMENT;
+    if ((idle_timeout_ms < 0 && idle_timeout_ms != TCS_WAIT_INF) ||
+        (connect_timeout_ms < 0 && connect_timeout_ms != TCS_WAIT_INF))
+        return TCS_ERROR_INVALID_ARGUMENT;
+
+    struct TcsPool* pool = (struct TcsPool*)tcs_lib_malloc(sizeof(struct TcsPool));
+    if (pool == NULL)
+        return TCS_ERROR_MEMORY;
+    memset(pool, 0, sizeof(struct TcsPool));
+    pool->max_idle_per_key = max_idle_per_key;
+    pool->max_total_per_key = max_total_per_key;
+    pool->idle_timeout_ms = idle_timeout_ms;
+    pool->connect_timeout_ms = connect_timeout_ms;
+
+    // Per pool seed so remote peers can not pick addresses that collide in every process
+    uint64_t seed = (uint64_t)tcs_time_monotonic_ms() ^ (uint64_t)(uintptr_t)pool;
+    for (size_t i = 0; i < TCS_CFG_POOL_SHARDS; ++i)
+    {
+        TcsResult res = tcs_os_mutex_create(&pool->shards[i].lock);
+        if (res != TCS_SUCCESS)
+        {
+            for (size_t j = 0; j < i; ++j)
+                tcs_os_mutex_destroy(&pool->shards[j].lock);
+            tcs_lib_free(pool);
+            return res;
+        }
+        tds_hmap_pool_key_create(&pool->shards[i].keys, tcs_address_hash(NULL, seed + i) * 0x9E3779B97F4A7C15ULL);
+    }
+
+    *out_pool = pool;
+    return TCS_SUCCESS;
+}
+
+TcsResult tcs_pool_destroy(struct TcsPool** pool)
+{
+    if (pool == NULL || *pool == NULL)
+        return TCS_ERROR_INVALID_ARGUMENT;
+
+    for (size_t i = 0; i < TCS_CFG_POOL_SHARDS; ++i)
+    {
+        struct TcsPoolShard* shard = &(*pool)->shards[i];
+        for (size_t k = 0; k < shard->keys.capacity; ++k)
+        {
+            if (shard->keys.distances[k] == 0)
+                continue;
+            struct TcsPoolKey* key = shard->keys.values[k];
+            for (size_t n = 0; n < key->idle_count; ++n)
+                tcs_close(&key->idle[n].socket);
+            tcs_lib_free(key->idle);
+            tcs_lib_free(key);
+        }
+        tds_hmap_pool_key_destroy(&shard->keys);
+        tcs_os_mutex_destroy(&shard->lock);
+    }
+    tcs_lib_free(*pool);
+    *pool = NULL;
+    return TCS_SUCCESS;
+}
+
+static struct TcsPoolKey* pool_key_get_or_add(const struct TcsPool* pool,
+                                              struct TcsPoolShard* shard,
+                                              const struct TcsAddress* address)
+{
+    struct TcsPoolKey** found = tds_hmap_pool_key_get(&shard->keys, address);
+    if (found != NULL)
+        return *found;
+
+    struct TcsPoolKey* key = (struct TcsPoolKey*)tcs_lib_malloc(sizeof(struct TcsPoolKey));
+    if (key == NULL)
+        return NULL;
+    key->address = *address;
+    key->total = 0;
+    key->idle_count = 0;
+    key->idle = NULL;
+    if (pool->max_idle_per_key > 0)
+    {
+        key->idle = (struct TcsPoolIdle*)tcs_lib_malloc(pool->max_idle_per_key * sizeof(struct TcsPoolIdle));
+        if (key->idle == NULL)
+        {
+            tcs_lib_free(key);
+            return NULL;
+        }
+    }
+    if (tds_hmap_pool_key_set(&shard->keys, address, &key) != 0)
+    {
+        tcs_lib_free(key->idle);
+        tcs_lib_free(key);
+        return NULL;
+    }
+    return key;
+}
+
+TcsResult tcs_pool_acquire(struct TcsPool* pool, const struct TcsAddress* remote_address, TcsSocket* out_socket)
+{
+    if (pool == NULL || remote_address == NULL || out_socket == NULL || *out_socket != TCS_SOCKET_INVALID)
+        return TCS_ERROR_INVALID_ARGUMENT;
+
+    struct TcsPoolShard* shard = &pool->shards[pool_shard_index(remote_address)];
+    struct TcsPoolClosing closing;
+    closing.count = 0;
+    tcs_os_mutex_lock(shard->lock);
+    int64_t now_ms = tcs_time_monotonic_ms();
+    pool_shard_sweep(pool, shard, now_ms, &closing);
+    struct TcsPoolKey* key = pool_key_get_or_add(pool, shard, remote_address);
+    if (key == NULL)
+    {
+        tcs_os_mutex_unlock(shard->lock);
+        pool_closing_flush(&closing);
+        return TCS_ERROR_MEMORY;
+    }
+    pool_key_expire(pool, key, now_ms, &closing);
+
+    // The newest idle connection is checked without the lock, it still counts in total so the key stays
+    while (key->idle_count > 0)
+    {
+        TcsSocket socket = key->idle[--key->idle_count].socket;
+        tcs_os_mutex_unlock(shard->lock);
+        pool_closing_flush(&closing);
+        if (pool_socket_is_alive(socket))
+        {
+            *out_socket = socket;
+            return TCS_SUCCESS;
+        }
+        tcs_close(&socket);
+        tcs_os_mutex_lock(shard->lock);
+        key->total--;
+    }
+    if (key->total >= pool->max_total_per_key)
+    {
+        tcs_os_mutex_unlock(shard->lock);
+        pool_closing_flush(&closing);
+        return TCS_ERROR_WOULD_BLOCK;
+    }
+    key->total++; // Reserve the slot while connecting without the lock, this also keeps the key
+    tcs_os_mutex_unlock(shard->lock);
+    pool_closing_flush(&closing);
+
+    TcsResult res = tcs_socket_tcp(out_socket, NULL, remote_address, pool->connect_timeout_ms);
+    if (res != TCS_SUCCESS)
+    {
+        tcs_os_mutex_lock(shard->lock);
+        key->total--;
+        pool_key_remove_if_unused(shard, key);
+        tcs_os_mutex_unlock(shard->lock);
+    }
+    return res;
+}
+
+TcsResult tcs_pool_release(struct TcsPool* pool,
+                           const struct TcsAddress* remote_address,
+                           TcsSocket* socket,
+                           bool is_reusable)
+{
+    if (pool == NULL || remote_address == NULL || socket == NULL || *socket == TCS_SOCKET_INVALID)
+        return TCS_ERROR_INVALID_ARGUMENT;
+
+    struct TcsPoolShard* shard = &pool->shards[pool_shard_index(remote_address)];
+    struct TcsPoolClosing closing;
+    closing.count = 0;
+    tcs_os_mutex_lock(shard->lock);
+    struct TcsPoolKey** found = tds_hmap_pool_key_get(&shard->keys, remote_address);
+    if (found == NULL)
+    {
+        tcs_os_mutex_unlock(shard->lock);
+        return TCS_ERROR_INVALID_ARGUMENT;
+    }
+    struct TcsPoolKey* key = *found;
+    int64_t now_ms = tcs_time_monotonic_ms();
+    pool_key_expire(pool, key, now_ms, &closing); // The released connection keeps total above zero
+    bool is_pooled = is_reusable && key->idle_count < pool->max_idle_per_key;
+    if (is_pooled)
+    {
+        key->idle[key->idle_count].socket = *socket;
+        key->idle[key->idle_count].idle_since_ms = now_ms;
+        key->idle_count++;
+        *socket = TCS_SOCKET_INVALID;
+    }
+    else
+    {
+        key->total--;
+        pool_key_remove_if_unused(shard, key);
+    }
+    pool_shard_sweep(pool, shard, now_ms, &closing); // Last, it may remove the key
+    tcs_os_mutex_unlock(shard->lock);
+    pool_closing_flush(&closing);
+    return is_pooled ? TCS_SUCCESS : tcs_close(socket);
+}
+
+// ######## Asynchronous Resolve ########
+
+enum TcsResolveState
+{
+    TCS_RESOLVE_FREE,
+    TCS_RESOLVE_PENDING,
+    TCS_RESOLVE_RUNNING,
+    TCS_RESOLVE_DONE,
+    TCS_RESOLVE_CANCELLED, // Freed by the worker when the lookup returns
+};
+
+struct TcsResolveRequest
+{
+    char* hostname;
+    TcsFamily family;
+    enum TcsResolveState state;
+    TcsResult result;
+    size_t address_count;
+    struct TcsAddress addresses[TCS_CFG_RESOLVER_ADDRESSES_MAX];
+    size_t next;       // Next request in the free, pending or done list
+    size_t generation; // Bumped when the slot is freed so handles of earlier lookups no longer match
+};
+
+#ifndef TDS_ULIST_resolve_request
+#define TDS_ULIST_resolve_request
+TDS_ULIST_IMPL(struct TcsResolveRequest, resolve_request)
+#endif
+
+struct TcsResolver
+{
+    struct TcsOsMutex* lock;
+    struct TcsOsSemaphore* has_pending; // Posted for every submit, and once per thread when stopping
+    struct TcsOsWakeup* wakeup;         // Set while the done list is not empty
+    bool is_stopping;
+    size_t thread_count;
+    struct TcsOsThread** threads;
+    struct TdsUList_resolve_request requests; // Requests are reused but never moved between slots
+    size_t free_head;
+    size_t pending_head;
+    size_t pending_tail;
+    size_t done_head;
+    size_t done_tail;
+};
+
+// End of the free, pending and done lists
+static const size_t RESOLVER_END = (size_t)-1;
+
+// A handle is the slot index in the low half and the slot generation in the high half
+#define RESOLVER_HANDLE_SHIFT (sizeof(size_t) * 4)
+static const size_t RESOLVER_HANDLE_MASK = ((size_t)1 << RESOLVER_HANDLE_SHIFT) - 1;
+
+static size_t resolver_handle(const struct TcsResolver* resolver, size_t index)
+{
+    return index | (resolver->requests.data[index].generation << RESOLVER_HANDLE_SHIFT);
+}
+
+// Returns the slot of a handle, or RESOLVER_END for handles of lookups that were already taken or cancelled
+static size_t resolver_handle_index(const struct TcsResolver* resolver, size_t handle)
+{
+    size_t index = handle & RESOLVER_HANDLE_MASK;
+    if (index >= resolver->requests.count)
+        return RESOLVER_END;
+    if (resolver->requests.data[index].generation != handle >> RESOLVER_HANDLE_SHIFT)
+        return RESOLVER_END;
+    return index;
+}
+
+static void resolver_request_free(struct TcsResolver* resolver, size_t index)
+{
+    struct TcsResolveRequest* request = &resolver->requests.data[index];
+    tcs_lib_free(request->hostname);
+    request->hostname = NULL;
+    request->state = TCS_RESOLVE_FREE;
+    request->generation = (request->generation + 1) & RESOLVER_HANDLE_MASK;
+    request->next = resolver->free_head;
+    resolver->free_head = index;
+}
+
+static void resolver_list_append(struct TcsResolver* resolver, size_t* head, size_t* tail, size_t index)
+{
+    resolver->requests.data[index].next = RESOLVER_END;
+    if (*tail != RESOLVER_END)
+        resolver->requests.data[*tail].next = index;
+    else
+        *head = index;
+    *tail = index;
+}
+
+static void resolver_list_unlink(struct TcsResolver* resolver, size_t* head, size_t* tail, size_t index)
+{
+    size_t prev = RESOLVER_END;
+    size_t iter = *head;
+    while (iter != index)
+    {
+        prev = iter;
+        iter = resolver->requests.data[iter].next;
+    }
+    size_t next = resolver->requests.data[index].next;
+    if (prev != RESOLVER_END)
+        resolver->requests.data[prev].next = next;
+    else
+        *head = next;
+    if (*tail == index)
+        *tail = prev;
+}
+
+// Keeps the wakeup readable exactly while there are lookups to take. The caller holds the lock.
+static void resolver_wakeup_update(struct TcsResolver* resolver, bool was_done_empty)
+{
+    bool is_done_empty = resolver->done_head == RESOLVER_END;
+    if (was_done_empty != is_done_empty)
+        tcs_os_wakeup_set(resolver->wakeup, !is_done_empty);
+}
+
+static void resolver_thread(void* arg)
+{
+    struct TcsResolver* resolver = (struct TcsResolver*)arg;
+    while (true)
+    {
+        tcs_os_semaphore_wait(resolver->has_pending);
+        tcs_os_mutex_lock(resolver->lock);
+        if (resolver->is_stopping)
+            break;
+        if (resolver->pending_head == RESOLVER_END) // Cancelled before any thread took it
+        {
+            tcs_os_mutex_unlock(resolver->lock);
+            continue;
+        }
+
+        size_t index = resolver->pending_head;
+        struct TcsResolveRequest* request = &resolver->requests.data[index];
+        resolver_list_unlink(resolver, &resolver->pending_head, &resolver->pending_tail, index);
+        request->state = TCS_RESOLVE_RUNNING;
+        const char* hostname = request->hostname; // Only freed by this thread while running
+        TcsFamily family = request->family;
+        tcs_os_mutex_unlock(resolver->lock);
+
+        struct TcsAddress addresses[TCS_CFG_RESOLVER_ADDRESSES_MAX];
+        size_t address_count = 0;
+        TcsResult res = tcs_address_resolve(
+            hostname, family, addresses, TCS_CFG_RESOLVER_ADDRESSES_MAX, &address_count);
+
+        tcs_os_mutex_lock(resolver->lock);
+        request = &resolver->requests.data[index]; // The list may have grown
+        if (request->state == TCS_RESOLVE_CANCELLED)
+        {
+            resolver_request_free(resolver, index);
+            tcs_os_mutex_unlock(resolver->lock);
+            continue;
+        }
+        request->state = TCS_RESOLVE_DONE;
+        request->result = res;
+        request->address_count = res == TCS_SUCCESS ? address_count : 0;
+        memcpy(request->addresses, addresses, request->address_count * sizeof(struct TcsAddress));
+        bool was_done_empty = resolver->done_head == RESOLVER_END;
+        resolver_list_append(resolver, &resolver->done_head, &resolver->done_tail, index);
+        resolver_wakeup_update(resolver, was_done_empty);
+        tcs_os_mutex_unlock(resolver->lock);
+    }
+    tcs_os_mutex_unlock(resolver->lock);
+}
+
+// Stops and joins the started threads and frees everything that was created
+static void resolver_free(struct TcsResolver* resolver)
+{
+    if (resolver->thread_count > 0)
+    {
+        tcs_os_mutex_lock(resolver->lock);
+        resolver->is_stopping = true;
+        tcs_os_mutex_unlock(resolver->lock);
+        for (size_t i = 0; i < resolver->thread_count; ++i)
+            tcs_os_semaphore_post(resolver->has_pending);
+        for (size_t i = 0; i < resolver->thread_count; ++i)
+            tcs_os_thread_join(&resolver->threads[i]);
+    }
+
+    for (size_t i = 0; i < resolver->requests.count; ++i)
+        tcs_lib_free(resolver->requests.data[i].hostname);
+    tds_ulist_resolve_request_destroy(&resolver->requests);
+    tcs_lib_free(resolver->threads);
+    if (resolver->wakeup != NULL)
+        tcs_os_wakeup_destroy(&resolver->wakeup);
+    if (resolver->has_pending != NULL)
+        tcs_os_semaphore_destroy(&resolver->has_pending);
+    if (resolver->lock != NULL)
+        tcs_os_mutex_destroy(&resolver->lock);
+    tcs_lib_free(resolver);
+}
+
+TcsResult tcs_resolver_create(struct TcsResolver** out_resolver, size_t thread_count)
+{
+    if (out_resolver == NULL || *out_resolver != NULL || thread_count == 0)
+        return TCS_ERROR_INVALID_ARGUMENT;
+
+    struct TcsResolver* resolver = (struct TcsResolver*)tcs_lib_malloc(sizeof(struct TcsResolver));
+    if (resolver == NULL)
+        return TCS_ERROR_MEMORY;
+    memset(resolver, 0, sizeof(struct TcsResolver));
+    resolver->free_head = RESOLVER_END;
+    resolver->pending_head = RESOLVER_END;
+    resolver->pending_tail = RESOLVER_END;
+    resolver->done_head = RESOLVER_END;
+    resolver->done_tail = RESOLVER_END;
+
+    TcsResult res = tcs_os_mutex_create(&resolver->lock);
+    if (res == TCS_SUCCESS)
+        res = tcs_os_semaphore_create(&resolver->has_pending);
+    if (res == TCS_SUCCESS)
+        res = tcs_os_wakeup_create(&resolver->wakeup);
+    if (res == TCS_SUCCESS)
+    {
+        resolver->threads = (struct TcsOsThread**)tcs_lib_malloc(thread_count * sizeof(struct TcsOsThread*));
+        if (resolver->threads == NULL || tds_ulist_resolve_request_create(&resolver->requests) != 0)
+            res = TCS_ERROR_MEMORY;
+    }
+    for (size_t i = 0; i < thread_count && res == TCS_SUCCESS; ++i)
+    {
+        res = tcs_os_thread_create(&resolver->threads[i], resolver_thread, resolver);
+        if (res == TCS_SUCCESS)
+            resolver->thread_count++;
+    }
+    if (res != TCS_SUCCESS)
+    {
+        resolver_free(resolver);
+        return res;
+    }
+
+    *out_resolver = resolver;
+    return TCS_SUCCESS;
+}
+
+TcsResult tcs_resolver_destroy(struct TcsResolver** resolver)
+{
+    if (resolver == NULL || *resolver == NULL)
+        return TCS_ERROR_INVALID_ARGUMENT;
+    resolver_free(*resolver);
+    *resolver = NULL;
+    return TCS_SUCCESS;
+}
+
+TcsResult tcs_resolver_socket(struct TcsResolver* resolver, TcsSocket* out_socket)
+{
+    if (resolver == NULL || out_socket == NULL)
+        return TCS_ERROR_INVALID_ARGUMENT;
+    *out_socket = tcs_os_wakeup_socket(resolver->wakeup);
+    return TCS_SUCCESS;
+}
+
+TcsResult tcs_resolver_submit(struct TcsResolver* resolver,
+                              const char* hostname,
+                              TcsFamily address_family,
+                              size_t* out_handle)
+{
+    if (resolver == NULL || hostname == NULL || out_handle == NULL)
+        return TCS_ERROR_INVALID_ARGUMENT;
+    if (address_family.native == -1) // sentinel for unsupported families (e.g. TCS_FAMILY_PACKET on Windows)
+        return TCS_ERROR_NOT_SUPPORTED;
+
+    size_t hostname_size = strlen(hostname) + 1;
+    char* hostname_copy = (char*)tcs_lib_malloc(hostname_size);
+    if (hostname_copy == NULL)
+        return TCS_ERROR_MEMORY;
+    memcpy(hostname_copy, hostname, hostname_size);
+
+    tcs_os_mutex_lock(resolver->lock);
+    size_t index = resolver->free_head;
+    if (index == RESOLVER_END)
+    {
+        struct TcsResolveRequest new_request;
+        memset(&new_request, 0, sizeof(new_request));
+        if (resolver->requests.count > RESOLVER_HANDLE_MASK ||
+            tds_ulist_resolve_request_add(&resolver->requests, &new_request, 1) != 0)
+        {
+            tcs_os_mutex_unlock(resolver->lock);
+            tcs_lib_free(hostname_copy);
+            return TCS_ERROR_MEMORY;
+        }
+        index = resolver->requests.count - 1;
+    }
+    else
+    {
+        resolver->free_head = resolver->requests.data[index].next;
+    }
+    struct TcsResolveRequest* request = &resolver->requests.data[index];
+    request->hostname = hostname_copy;
+    request->family = address_family;
+    request->state = TCS_RESOLVE_PENDING;
+    resolver_list_append(resolver, &resolver->pending_head, &resolver->pending_tail, index);
+    *out_handle = resolver_handle(resolver, index);
+    tcs_os_mutex_unlock(resolver->lock);
+    tcs_os_semaphore_post(resolver->has_pending);
+    return TCS_SUCCESS;
+}
+
+TcsResult tcs_resolver_take(struct TcsResolver* resolver,
+                            size_t* out_handle,
+                            TcsResult* out_result,
+                            struct TcsAddress out_addresses[],
+                            size_t addresses_length,
+                            size_t* out_length)
+{
+    if (resolver == NULL || out_handle == NULL || out_result == NULL)
+        return TCS_ERROR_INVALID_ARGUMENT;
+    if (out_length != NULL)
+        *out_length = 0;
+
+    tcs_os_mutex_lock(resolver->lock);
+    size_t index = resolver->done_head;
+    if (index == RESOLVER_END)
+    {
+        tcs_os_mutex_unlock(resolver->lock);
+        return TCS_AGAIN;
+    }
+    resolver_list_unlink(resolver, &resolver->done_head, &resolver->done_tail, index);
+    resolver_wakeup_update(resolver, false);
+
+    const struct TcsResolveRequest* request = &resolver->requests.data[index];
+    size_t address_count = request->address_count;
+    if (out_addresses != NULL)
+    {
+        if (address_count > addresses_length)
+            address_count = addresses_length;
+        memcpy(out_addresses, request->addresses, address_count * sizeof(struct TcsAddress));
+    }
+    if (out_length != NULL)
+        *out_length = address_count;
+    *out_handle = resolver_handle(resolver, index);
+    *out_result = request->result;
+    resolver_request_free(resolver, index);
+    tcs_os_mutex_unlock(resolver->lock);
+    return TCS_SUCCESS;
+}
+
+TcsResult tcs_resolver_cancel(struct TcsResolver* resolver, size_t handle)
+{
+    if (resolver == NULL)
+        return TCS_ERROR_INVALID_ARGUMENT;
+
+    tcs_os_mutex_lock(resolver->lock);
+    size_t index = resolver_handle_index(resolver, handle);
+    if (index == RESOLVER_END || resolver->requests.data[index].state == TCS_RESOLVE_FREE ||
+        resolver->requests.data[index].state == TCS_RESOLVE_CANCELLED)
+    {
+        tcs_os_mutex_unlock(resolver->lock);
+        return TCS_ERROR_INVALID_ARGUMENT;
+    }
+    struct TcsResolveRequest* request = &resolver->requests.data[index];
+    if (request->state == TCS_RESOLVE_PENDING)
+    {
+        resolver_list_unlink(resolver, &resolver->pending_head, &resolver->pending_tail, index);
+        resolver_request_free(resolver, index);
+    }
+    else if (request->state == TCS_RESOLVE_DONE)
+    {
+        resolver_list_unlink(resolver, &resolver->done_head, &resolver->done_tail, index);
+        resolver_wakeup_update(resolver, false);
+        resolver_request_free(resolver, index);
+    }
+    else
+    {
+        request->state = TCS_RESOLVE_CANCELLED;
+    }
+    tcs_os_mutex_unlock(resolver->lock);
+    return TCS_SUCCESS;
+}
+
+// ######## DNS Stub Resolver ########
+
+// RFC 1035 wire format
+#define TCS_DNS_HEADER_SIZE 12
+#define TCS_DNS_NAME_MAX 255  // Encoded name including the root label
+#define TCS_DNS_LABEL_MAX 63  // Longest label
+#define TCS_DNS_UDP_MAX 512   // Largest answer over UDP without EDNS
+#define TCS_DNS_TCP_MAX 65535 // TCP messages have a 16 bit length prefix
+#define TCS_DNS_FLAG_QR 0x8000
+#define TCS_DNS_FLAG_TC 0x0200
+#define TCS_DNS_FLAG_RD 0x0100
+#define TCS_DNS_RCODE_MASK 0x000F
+#define TCS_DNS_RCODE_NXDOMAIN 3
+#define TCS_DNS_TYPE_A 1
+#define TCS_DNS_TYPE_AAAA 28
+#define TCS_DNS_CLASS_IN 1
+
+enum TcsDnsQueryState
+{
+    TCS_DNS_QUERY_UNUSED,
+    TCS_DNS_QUERY_UDP,         // Waiting for a datagram, sent again on timeout
+    TCS_DNS_QUERY_TCP_SEND,    // Connecting or sending after a truncated answer
+    TCS_DNS_QUERY_TCP_RECEIVE, // Waiting for the length prefixed answer
+    TCS_DNS_QUERY_DONE,
+};
+
+// The query and then the answer, both with the length prefix
+struct TcsDnsTcpBuffer
+{
+    uint8_t bytes[2 + TCS_DNS_TCP_MAX];
+};
+
+#ifndef TDS_POOL_dns_tcp_buffer
+#define TDS_POOL_dns_tcp_buffer
+TDS_POOL_IMPL(struct TcsDnsTcpBuffer, dns_tcp_buffer)
+#endif
+
+struct TcsDnsQuery
+{
+    enum TcsDnsQueryState state;
+    uint16_t id;
+    uint16_t type;
+    size_t nameserver; // Index of the nameserver asked last
+    int sent_count;
+    int64_t deadline_ms;
+    TcsResult result;
+    size_t address_count;
+    struct TcsAddress addresses[TCS_CFG_DNS_ADDRESSES_MAX];
+    TcsSocket socket; // UDP or TCP, a new socket per attempt gets a new random source port
+    struct TcsDnsTcpBuffer* tcp_buffer;
+    size_t tcp_length;
+    size_t tcp_done;
+};
+
+enum TcsDnsLookupState
+{
+    TCS_DNS_LOOKUP_FREE,
+    TCS_DNS_LOOKUP_ACTIVE,
+    TCS_DNS_LOOKUP_DONE,
+};
+
+struct TcsDnsLookup
+{
+    enum TcsDnsLookupState state;
+    uint8_t name[TCS_DNS_NAME_MAX];
+    size_t name_length;
+    struct TcsDnsQuery queries[2]; // AAAA and A, addresses are returned in this order
+    size_t next;                   // Next lookup in the free or done list
+    size_t generation;             // Bumped when the slot is freed so handles of earlier lookups no longer match
+};
+
+struct TcsDnsHost
+{
+    char name[TCS_DNS_NAME_MAX + 1];
+    struct TcsAddress address;
+};
+
+#ifndef TDS_ULIST_dns_lookup
+#define TDS_ULIST_dns_lookup
+TDS_ULIST_IMPL(struct TcsDnsLookup, dns_lookup)
+#endif
+
+#ifndef TDS_ULIST_dns_host
+#define TDS_ULIST_dns_host
+TDS_ULIST_IMPL(struct TcsDnsHost, dns_host)
+#endif
+
+static uint64_t dns_socket_hash(const TcsSocket* socket, uint64_t seed)
+{
+    uint64_t x = (uint64_t)*socket ^ seed;
+    x *= 0x9E3779B97F4A7C15ULL;
+    return x ^ (x >> 29);
+}
+
+static bool dns_socket_is_equal(const TcsSocket* l, const TcsSocket* r)
+{
+    return *l == *r;
+}
+
+// Socket of a query to lookup index * 2 + query index
+TDS_HMAP_IMPL(TcsSocket, size_t, dns_socket, dns_socket_hash, dns_socket_is_equal)
+
+struct TcsDns
+{
+    struct TcsPoll* poll;
+    int attempt_timeout_ms;
+    int attempts;
+    size_t nameservers_length;
+    struct TcsAddress nameservers[TCS_CFG_DNS_NAMESERVERS_MAX];
+    struct TdsUList_dns_host hosts;
+    struct TdsUList_dns_lookup lookups; // Lookups are reused but never moved between slots
+    struct TdsHMap_dns_socket query_by_socket;
+    uint32_t random_state;
+    size_t in_flight;                          // Queries waiting for an answer
+    struct TdsPool_dns_tcp_buffer tcp_buffers; // Reused by later TCP queries instead of a 64 KiB malloc() each
+    int64_t next_deadline_ms;
+    size_t free_head;
+    size_t done_head;
+    size_t done_tail;
+};
+
+// End of the free and done lists
+static const size_t DNS_END = (size_t)-1;
+
+// A handle is the slot index in the low half and the slot generation in the high half, as for TcsResolver
+#define DNS_HANDLE_SHIFT (sizeof(size_t) * 4)
+static const size_t DNS_HANDLE_MASK = ((size_t)1 << DNS_HANDLE_SHIFT) - 1;
+
+static size_t dns_handle(const struct TcsDns* dns, size_t index)
+{
+    return index | (dns->lookups.data[index].generation << DNS_HANDLE_SHIFT);
+}
+
+// Returns the slot of a handle, or DNS_END for handles of lookups that were already taken or cancelled
+static size_t dns_handle_index(const struct TcsDns* dns, size_t handle)
+{
+    size_t index = handle & DNS_HANDLE_MASK;
+    if (index >= dns->lookups.count || dns->lookups.data[index].state == TCS_DNS_LOOKUP_FREE)
+        return DNS_END;
+    if (dns->lookups.data[index].generation != handle >> DNS_HANDLE_SHIFT)
+        return DNS_END;
+    return index;
+}
+
+// xorshift32 seeded from the OS entropy source. An off-path attacker has to guess the id and the source port.
+static uint16_t dns_id_random(struct TcsDns* dns)
+{
+    uint32_t x = dns->random_state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    dns->random_state = x;
+    return (uint16_t)(x >> 8);
+}
+
+static char dns_fold(char c)
+{
+    return (c >= 'A' && c <= 'Z') ? (char)(c - 'A' + 'a') : c;
+}
+
+static bool dns_hostname_is_equal(const char* l, const char* r)
+{
+    while (*l != '\0' && dns_fold(*l) == dns_fold(*r))
+    {
+        ++l;
+        ++r;
+    }
+    return dns_fold(*l) == dns_fold(*r);
+}
+
+static uint16_t dns_read_u16(const uint8_t* bytes)
+{
+    return (uint16_t)((bytes[0] << 8) | bytes[1]);
+}
+
+static void dns_write_u16(uint8_t* bytes, uint16_t value)
+{
+    bytes[0] = (uint8_t)(value >> 8);
+    bytes[1] = (uint8_t)(value & 0xFF);
+}
+
+// "example.com" to 7example3com0, a trailing dot is allowed
+static TcsResult dns_name_encode(const char* hostname, uint8_t out_name[TCS_DNS_NAME_MAX], size_t* out_length)
+{
+    size_t length = 0;
+    const char* label = hostname;
+    if (*label == '\0')
+        return TCS_ERROR_INVALID_ARGUMENT;
+    while (*label != '\0')
+    {
+        const char* end = label;
+        while (*end != '\0' && *end != '.')
+            ++end;
+        size_t label_length = (size_t)(end - label);
+        if (label_length == 0 || label_length > TCS_DNS_LABEL_MAX || length + label_length + 2 > TCS_DNS_NAME_MAX)
+            return TCS_ERROR_INVALID_ARGUMENT;
+        out_name[length++] = (uint8_t)label_length;
+        memcpy(out_name + length, label, label_length);
+        length += label_length;
+        label = *end == '.' ? end + 1 : end;
+    }
+    out_name[length++] = 0;
+    *out_length = length;
+    return TCS_SUCCESS;
+}
+
+// Skips a possibly compressed name, the target of a compression pointer is never needed
+static bool dns_name_skip(const uint8_t* message, size_t length, size_t* offset)
+{
+    size_t position = *offset;
+    while (position < length)
+    {
+        uint8_t label_length = message[position];
+        if (label_length == 0)
+        {
+            *offset = position + 1;
+            return true;
+        }
+        if ((label_length & 0xC0) == 0xC0)
+        {
+            if (position + 2 > length)
+                return false;
+            *offset = position + 2;
+            return true;
+        }
+        if ((label_length & 0xC0) != 0)
+            return false;
+        position += 1u + label_length;
+    }
+    return false;
+}
+
+static size_t dns_query_build(const struct TcsDnsLookup* lookup, const struct TcsDnsQuery* query, uint8_t* out_message)
+{
+    memset(out_message, 0, TCS_DNS_HEADER_SIZE);
+    dns_write_u16(out_message, query->id);
+    dns_write_u16(out_message + 2, TCS_DNS_FLAG_RD);
+    dns_write_u16(out_message + 4, 1); // QDCOUNT
+    memcpy(out_message + TCS_DNS_HEADER_SIZE, lookup->name, lookup->name_length);
+    size_t length = TCS_DNS_HEADER_SIZE + lookup->name_length;
+    dns_write_u16(out_message + length, query->type);
+    dns_write_u16(out_message + length + 2, TCS_DNS_CLASS_IN);
+    return length + 4;
+}
+
+// Fills the query with the addresses of an answer. Returns TCS_ERROR_ILL_FORMED_MESSAGE for messages that do not
+// answer this query, they are ignored. TCS_ERROR_TEMPORARY_FAILURE means that another nameserver may do better, or
+// with out_is_truncated that the answer did not fit.
+static TcsResult dns_answer_parse(const uint8_t* message,
+                                  size_t length,
+                                  const struct TcsDnsLookup* lookup,
+                                  struct TcsDnsQuery* query,
+                                  bool* out_is_truncated)
+{
+    *out_is_truncated = false;
+    if (length < TCS_DNS_HEADER_SIZE + lookup->name_length + 4)
+        return TCS_ERROR_ILL_FORMED_MESSAGE;
+    uint16_t flags = dns_read_u16(message + 2);
+    if (dns_read_u16(message) != query->id || (flags & TCS_DNS_FLAG_QR) == 0 || dns_read_u16(message + 4) != 1)
+        return TCS_ERROR_ILL_FORMED_MESSAGE;
+
+    // The question must be ours, names compare case insensitively
+    const uint8_t* question = message + TCS_DNS_HEADER_SIZE;
+    for (size_t i = 0; i < lookup->name_length; ++i)
+    {
+        if (dns_fold((char)question[i]) != dns_fold((char)lookup->name[i]))
+            return TCS_ERROR_ILL_FORMED_MESSAGE;
+    }
+    if (dns_read_u16(question + lookup->name_length) != query->type ||
+        dns_read_u16(question + lookup->name_length + 2) != TCS_DNS_CLASS_IN)
+        return TCS_ERROR_ILL_FORMED_MESSAGE;
+
+    if (flags & TCS_DNS_FLAG_TC)
+    {
+        *out_is_truncated = true;
+        return TCS_ERROR_TEMPORARY_FAILURE;
+    }
+    uint16_t rcode = (uint16_t)(flags & TCS_DNS_RCODE_MASK);
+    if (rcode == TCS_DNS_RCODE_NXDOMAIN)
+        return TCS_ERROR_ADDRESS_LOOKUP_FAILED;
+    if (rcode != 0)
+        return TCS_ERROR_TEMPORARY_FAILURE;
+
+    // Records of other types, e.g. the CNAME chain leading to the addresses, are skipped
+    uint16_t answer_count = dns_read_u16(message + 6);
+    size_t offset = TCS_DNS_HEADER_SIZE + lookup->name_length + 4;
+    query->address_count = 0;
+    for (uint16_t i = 0; i < answer_count; ++i)
+    {
+        if (!dns_name_skip(message, length, &offset) || offset + 10 > length)
+            return TCS_ERROR_ILL_FORMED_MESSAGE;
+        uint16_t type = dns_read_u16(message + offset);
+        uint16_t class_ = dns_read_u16(message + offset + 2);
+        uint16_t data_length = dns_read_u16(message + offset + 8);
+        offset += 10;
+        if (offset + data_length > length)
+            return TCS_ERROR_ILL_FORMED_MESSAGE;
+        if (class_ == TCS_DNS_CLASS_IN && type == query->type && query->address_count < TCS_CFG_DNS_ADDRESSES_MAX)
+        {
+            struct TcsAddress* address = &query->addresses[query->address_count];
+            *address = TCS_ADDRESS_NONE;
+            if (type == TCS_DNS_TYPE_A && data_length == 4)
+            {
+                address->family = TCS_FAMILY_IPV4;
+                address->data.ipv4.address = ((uint32_t)message[offset] << 24) |
+                                             ((uint32_t)message[offset + 1] << 16) |
+                                             ((uint32_t)message[offset + 2] << 8) | (uint32_t)message[offset + 3];
+                query->address_count++;
+            }
+            else if (type == TCS_DNS_TYPE_AAAA && data_length == 16)
+            {
+                address->family = TCS_FAMILY_IPV6;
+                memcpy(address->data.ipv6.address.bytes, message + offset, 16);
+                query->address_count++;
+            }
+        }
+        offset += data_length;
+    }
+    return query->address_count > 0 ? TCS_SUCCESS : TCS_ERROR_ADDRESS_LOOKUP_FAILED;
+}
+
+static void dns_deadline_set(struct TcsDns* dns, struct TcsDnsQuery* query, int64_t now_ms)
+{
+    query->deadline_ms = now_ms + dns->attempt_timeout_ms;
+    if (query->deadline_ms < dns->next_deadline_ms)
+        dns->next_deadline_ms = query->deadline_ms;
+}
+
+static void dns_query_socket_close(struct TcsDns* dns, struct TcsDnsQuery* query)
+{
+    if (query->socket == TCS_SOCKET_INVALID)
+        return;
+    tcs_poll_remove(dns->poll, query->socket);
+    tds_hmap_dns_socket_remove(&dns->query_by_socket, &query->socket);
+    tcs_close(&query->socket);
+}
+
+// Opens a new socket to the nameserver of the query, the OS picks a random source port for it
+static TcsResult dns_query_socket_open(struct TcsDns* dns, size_t index, struct TcsDnsQuery* query, bool is_tcp)
+{
+    const struct TcsAddress* nameserver = &dns->nameservers[query->nameserver];
+    size_t slot = index * 2 + (size_t)(query - dns->lookups.data[index].queries);
+    TcsResult res = TCS_SUCCESS;
+    if (is_tcp)
+    {
+        res = connect_attempt_start(&query->socket, NULL, nameserver);
+    }
+    else
+    {
+        res = tcs_socket_with_flags(&query->socket,
+                                    nameserver->family,
+                                    TCS_SOCKET_DGRAM,
+                                    TCS_PROTOCOL_IP_UDP,
+                                    TCS_SOCKET_FLAG_NONBLOCKING | TCS_SOCKET_FLAG_CLOEXEC);
+        if (res == TCS_SUCCESS)
+            res = tcs_connect(query->socket, nameserver);
+    }
+    if (res == TCS_IN_PROGRESS)
+        res = TCS_SUCCESS;
+    if (res == TCS_SUCCESS)
+        res = tcs_poll_add(dns->poll, query->socket, dns, is_tcp ? TCS_POLL_WRITE : TCS_POLL_READ);
+    if (res == TCS_SUCCESS && tds_hmap_dns_socket_set(&dns->query_by_socket, &query->socket, &slot) != 0)
+    {
+        tcs_poll_remove(dns->poll, query->socket);
+        res = TCS_ERROR_MEMORY;
+    }
+    if (res != TCS_SUCCESS && query->socket != TCS_SOCKET_INVALID)
+        tcs_close(&query->socket);
+    return res;
+}
+
+// Every attempt asks all nameservers in turn, from a new socket. Socket and send errors are left to the timeout.
+static void dns_query_send(struct TcsDns* dns, size_t index, struct TcsDnsQuery* query, int64_t now_ms)
+{
+    dns_query_socket_close(dns, query);
+    query->nameserver = (size_t)query->sent_count % dns->nameservers_length;
+    query->sent_count++;
+    query->id = dns_id_random(dns);
+    dns_deadline_set(dns, query, now_ms);
+    if (dns_query_socket_open(dns, index, query, false) != TCS_SUCCESS)
+        return;
+    uint8_t message[TCS_DNS_HEADER_SIZE + TCS_DNS_NAME_MAX + 4];
+    size_t length = dns_query_build(&dns->lookups.data[index], query, message);
+    tcs_send(query->socket, message, length, TCS_FLAG_NONE, NULL);
+}
+
+static bool dns_query_is_in_flight(const struct TcsDnsQuery* query)
+{
+    return query->state == TCS_DNS_QUERY_UDP || query->state == TCS_DNS_QUERY_TCP_SEND ||
+           query->state == TCS_DNS_QUERY_TCP_RECEIVE;
+}
+
+// Releases the socket and the TCP buffer of a query that was in flight
+static void dns_query_stop(struct TcsDns* dns, struct TcsDnsQuery* query)
+{
+    dns->in_flight--;
+    dns_query_socket_close(dns, query);
+    if (query->tcp_buffer != NULL)
+        tds_pool_dns_tcp_buffer_free(&dns->tcp_buffers, query->tcp_buffer);
+    query->tcp_buffer = NULL;
+}
+
+static void dns_lookup_done(struct TcsDns* dns, size_t index)
+{
+    struct TcsDnsLookup* lookup = &dns->lookups.data[index];
+    lookup->state = TCS_DNS_LOOKUP_DONE;
+    lookup->next = DNS_END;
+    if (dns->done_tail != DNS_END)
+        dns->lookups.data[dns->done_tail].next = index;
+    else
+        dns->done_head = index;
+    dns->done_tail = index;
+}
+
+static void dns_query_finish(struct TcsDns* dns, size_t index, struct TcsDnsQuery* query, TcsResult result)
+{
+    dns_query_stop(dns, query);
+    query->state = TCS_DNS_QUERY_DONE;
+    query->result = result;
+    if (result != TCS_SUCCESS)
+        query->address_count = 0;
+    const struct TcsDnsLookup* lookup = &dns->lookups.data[index];
+    if (!dns_query_is_in_flight(&lookup->queries[0]) && !dns_query_is_in_flight(&lookup->queries[1]))
+        dns_lookup_done(dns, index);
+}
+
+// Handles a parsed answer, possibly by retrying with the next nameserver or over TCP. A truncated answer over TCP
+// fails the query, there is nothing larger to fall back to.
+static void dns_answer_handle(
+    struct TcsDns* dns, size_t index, struct TcsDnsQuery* query, TcsResult result, bool is_truncated, int64_t now_ms)
+{
+    const struct TcsDnsLookup* lookup = &dns->lookups.data[index];
+    if (is_truncated && query->state == TCS_DNS_QUERY_UDP)
+    {
+        query->tcp_buffer = tds_pool_dns_tcp_buffer_alloc(&dns->tcp_buffers);
+        if (query->tcp_buffer == NULL)
+        {
+            dns_query_finish(dns, index, query, TCS_ERROR_MEMORY);
+            return;
+        }
+        query->tcp_length = 2 + dns_query_build(lookup, query, query->tcp_buffer->bytes + 2);
+        dns_write_u16(query->tcp_buffer->bytes, (uint16_t)(query->tcp_length - 2));
+        query->tcp_done = 0;
+        dns_query_socket_close(dns, query);
+        TcsResult res = dns_query_socket_open(dns, index, query, true);
+        if (res != TCS_SUCCESS)
+        {
+            dns_query_finish(dns, index, query, res);
+            return;
+        }
+        query->state = TCS_DNS_QUERY_TCP_SEND;
+        dns_deadline_set(dns, query, now_ms);
+        return;
+    }
+    if (result == TCS_ERROR_TEMPORARY_FAILURE && query->state == TCS_DNS_QUERY_UDP &&
+        query->sent_count < dns->attempts * (int)dns->nameservers_length)
+    {
+        dns_query_send(dns, index, query, now_ms);
+        return;
+    }
+    dns_query_finish(dns, index, query, result);
+}
+
+// Stops when the query leaves UDP or sends again from a new socket
+static void dns_udp_receive(struct TcsDns* dns, size_t index, struct TcsDnsQuery* query, int64_t now_ms)
+{
+    uint8_t message[TCS_DNS_UDP_MAX];
+    size_t received = 0;
+    TcsSocket socket = query->socket;
+    while (query->state == TCS_DNS_QUERY_UDP && query->socket == socket &&
+           tcs_receive(socket, message, sizeof(message), TCS_FLAG_NONE, &received) == TCS_SUCCESS)
+    {
+        bool is_truncated = false;
+        TcsResult res = dns_answer_parse(message, received, &dns->lookups.data[index], query, &is_truncated);
+        if (res != TCS_ERROR_ILL_FORMED_MESSAGE)
+            dns_answer_handle(dns, index, query, res, is_truncated, now_ms);
+    }
+}
+
+static void dns_tcp_progress(struct TcsDns* dns,
+                             size_t index,
+                             struct TcsDnsQuery* query,
+                             const struct TcsPollEvent* event,
+                             int64_t now_ms)
+{
+    if (event->error != TCS_SUCCESS)
+    {
+        dns_query_finish(dns, index, query, event->error);
+        return;
+    }
+    if (query->state == TCS_DNS_QUERY_TCP_SEND && event->can_write)
+    {
+        size_t sent = 0;
+        TcsResult res = tcs_send(query->socket,
+                                 query->tcp_buffer->bytes + query->tcp_done,
+                                 query->tcp_length - query->tcp_done,
+                                 0,
+                                 &sent);
+        if (res != TCS_SUCCESS && res != TCS_ERROR_WOULD_BLOCK)
+        {
+            dns_query_finish(dns, index, query, res);
+            return;
+        }
+        query->tcp_done += sent;
+        if (query->tcp_done == query->tcp_length)
+        {
+            query->state = TCS_DNS_QUERY_TCP_RECEIVE;
+            query->tcp_done = 0;
+            tcs_poll_modify(dns->poll, query->socket, TCS_POLL_READ);
+        }
+        return;
+    }
+    while (query->state == TCS_DNS_QUERY_TCP_RECEIVE && event->can_read)
+    {
+        size_t wanted = query->tcp_done < 2 ? 2 : 2 + (size_t)dns_read_u16(query->tcp_buffer->bytes);
+        size_t received = 0;
+        TcsResult res = tcs_receive(
+            query->socket, query->tcp_buffer->bytes + query->tcp_done, wanted - query->tcp_done, 0, &received);
+        if (res == TCS_ERROR_WOULD_BLOCK)
+            return;
+        if (res != TCS_SUCCESS || received == 0)
+        {
+            dns_query_finish(dns, index, query, res != TCS_SUCCESS ? res : TCS_ERROR_SOCKET_CLOSED);
+            return;
+        }
+        query->tcp_done += received;
+        if (query->tcp_done >= 2 && query->tcp_done == 2 + (size_t)dns_read_u16(query->tcp_buffer->bytes))
+        {
+            bool is_truncated = false;
+            res = dns_answer_parse(
+                query->tcp_buffer->bytes + 2, query->tcp_done - 2, &dns->lookups.data[index], query, &is_truncated);
+            dns_answer_handle(dns, index, query, res, is_truncated, now_ms);
+        }
+    }
+}
+
+// Sends again or gives up on queries past their deadline and finds the next deadline
+static void dns_timeouts(struct TcsDns* dns, int64_t now_ms)
+{
+    dns->next_deadline_ms = INT64_MAX;
+    for (size_t index = 0; index < dns->lookups.count; ++index)
+    {
+        for (size_t q = 0; q < 2; ++q)
+        {
+            struct TcsDnsQuery* query = &dns->lookups.data[index].queries[q];
+            if (!dns_query_is_in_flight(query))
+                continue;
+            if (now_ms >= query->deadline_ms)
+            {
+                if (query->state == TCS_DNS_QUERY_UDP &&
+                    query->sent_count < dns->attempts * (int)dns->nameservers_length)
+                {
+                    dns_query_send(dns, index, query, now_ms);
+                }
+                else
+                {
+                    dns_query_finish(dns, index, query, TCS_ERROR_TIMED_OUT);
+                    continue;
+                }
+            }
+            if (query->deadline_ms < dns->next_deadline_ms)
+                dns->next_deadline_ms = query->deadline_ms;
+        }
+    }
+}
+
+static void dns_lookup_free(struct TcsDns* dns, size_t index)
+{
+    struct TcsDnsLookup* lookup = &dns->lookups.data[index];
+    for (size_t q = 0; q < 2; ++q)
+    {
+        if (dns_query_is_in_flight(&lookup->queries[q]))
+            dns_query_stop(dns, &lookup->queries[q]);
+        lookup->queries[q].state = TCS_DNS_QUERY_UNUSED;
+    }
+    lookup->state = TCS_DNS_LOOKUP_FREE;
+    lookup->generation = (lookup->generation + 1) & DNS_HANDLE_MASK;
+    lookup->next = dns->free_head;
+    dns->free_head = index;
+}
+
+// Whitespace separated tokens, strtok() would not be thread safe
+static char* dns_token_next(char** cursor)
+{
+    char* token = *cursor;
+    while (*token == ' ' || *token == '\t' || *token == '\r' || *token == '\n')
+        ++token;
+    if (*token == '\0')
+        return NULL;
+    char* end = token;
+    while (*end != '\0' && *end != ' ' && *end != '\t' && *end != '\r' && *end != '\n')
+        ++end;
+    *cursor = *end != '\0' ? end + 1 : end;
+    *end = '\0';
+    return token;
+}
+
+static void dns_config_load(struct TcsDns* dns)
+{
+    char line[512];
+    FILE* file = fopen(TCS_CFG_DNS_RESOLV_CONF_PATH, "r");
+    while (file != NULL && fgets(line, sizeof(line), file) != NULL)
+    {
+        char address_str[128];
+        struct TcsAddress address = TCS_ADDRESS_NONE;
+        if (dns->nameservers_length < TCS_CFG_DNS_NAMESERVERS_MAX &&
+            sscanf(line, " nameserver %127s", address_str) == 1 &&
+            tcs_address_parse(address_str, &address) == TCS_SUCCESS)
+            dns->nameservers[dns->nameservers_length++] = address;
+    }
+    if (file != NULL)
+        fclose(file);
+    if (dns->nameservers_length == 0) // Same default as glibc
+        tcs_address_parse("127.0.0.1", &dns->nameservers[dns->nameservers_length++]);
+
+    file = fopen(TCS_CFG_DNS_HOSTS_PATH, "r");
+    while (file != NULL && fgets(line, sizeof(line), file) != NULL)
+    {
+        char* comment = strchr(line, '#');
+        if (comment != NULL)
+            *comment = '\0';
+        struct TcsDnsHost host;
+        host.address = TCS_ADDRESS_NONE;
+        char* cursor = line;
+        char* token = dns_token_next(&cursor);
+        if (token == NULL || tcs_address_parse(token, &host.address) != TCS_SUCCESS)
+            continue;
+        while ((token = dns_token_next(&cursor)) != NULL)
+        {
+            if (strlen(token) > TCS_DNS_NAME_MAX)
+                continue;
+            memcpy(host.name, token, strlen(token) + 1);
+            if (tds_ulist_dns_host_add(&dns->hosts, &host, 1) != 0)
+                break;
+        }
+    }
+    if (file != NULL)
+        fclose(file);
+}
+
+// Closes all sockets and frees everything, also for a partly created resolver
+static void dns_free(struct TcsDns* dns)
+{
+    for (size_t index = 0; index < dns->lookups.count; ++index)
+    {
+        if (dns->lookups.data[index].state == TCS_DNS_LOOKUP_ACTIVE)
+            dns_lookup_free(dns, index);
+    }
+    tds_ulist_dns_lookup_destroy(&dns->lookups);
+    tds_ulist_dns_host_destroy(&dns->hosts);
+    tds_pool_dns_tcp_buffer_destroy(&dns->tcp_buffers);
+    tds_hmap_dns_socket_destroy(&dns->query_by_socket);
+    tcs_lib_free(dns);
+}
+
+TcsResult tcs_dns_create(struct TcsDns** out_dns,
+                         struct TcsPoll* poll,
+                         const struct TcsAddress nameservers[],
+                         size_t nameservers_length,
+                         int attempt_timeout_ms,
+                         int attempts)
+{
+    if (out_dns == NULL || *out_dns != NULL || poll == NULL)
+        return TCS_ERROR_INVALID_ARGUMENT;
+    if ((nameservers == NULL) != (nameservers_length == 0) || nameservers_length > TCS_CFG_DNS_NAMESERVERS_MAX)
+        return TCS_ERROR_INVALID_ARGUMENT;
+    if (attempt_timeout_ms <= 0 || attempts <= 0)
+        return TCS_ERROR_INVALID_ARGUMENT;
+
+    struct TcsDns* dns = (struct TcsDns*)tcs_lib_malloc(sizeof(struct TcsDns));
+    if (dns == NULL)
+        return TCS_ERROR_MEMORY;
+    memset(dns, 0, sizeof(struct TcsDns));
+    dns->poll = poll;
+    dns->attempt_timeout_ms = attempt_timeout_ms;
+    dns->attempts = attempts;
+    dns->next_deadline_ms = INT64_MAX;
+    dns->free_head = DNS_END;
+    dns->done_head = DNS_END;
+    dns->done_tail = DNS_END;
+
+    // Query ids and the socket map seed, guessable ones only if the OS has no entropy source
+    uint8_t random[12];
+    if (tcs_os_random(random, sizeof(random)) != TCS_SUCCESS)
+    {
+        uint64_t fallback = (uint64_t)tcs_time_monotonic_ms() ^ (uint64_t)(uintptr_t)dns;
+        memcpy(random, &fallback, sizeof(fallback));
+        memcpy(random + 8, &fallback, 4);
+    }
+    uint64_t map_seed = 0;
+    memcpy(&dns->random_state, random, sizeof(dns->random_state));
+    memcpy(&map_seed, random + 4, sizeof(map_seed));
+    if (dns->random_state == 0)
+        dns->random_state = 0x9E3779B9u;
+    tds_hmap_dns_socket_create(&dns->query_by_socket, map_seed);
+
+    if (tds_ulist_dns_lookup_create(&dns->lookups) != 0 || tds_ulist_dns_host_create(&dns->hosts) != 0 ||
+        tds_pool_dns_tcp_buffer_create(&dns->tcp_buffers, 1, 0) != 0)
+    {
+        dns_free(dns);
+        return TCS_ERROR_MEMORY;
+    }
+
+    if (nameservers == NULL)
+    {
+        dns_config_load(dns);
+    }
+    else
+    {
+        memcpy(dns->nameservers, nameservers, nameservers_length * sizeof(struct TcsAddress));
+        dns->nameservers_length = nameservers_length;
+    }
+
+    for (size_t i = 0; i < dns->nameservers_length; ++i)
+    {
+        struct TcsAddress* nameserver = &dns->nameservers[i];
+        if (nameserver->family.native == TCS_FAMILY_IPV4.native && nameserver->data.ipv4.port == 0)
+            nameserver->data.ipv4.port = 53;
+        else if (nameserver->family.native == TCS_FAMILY_IPV6.native && nameserver->data.ipv6.port == 0)
+            nameserver->data.ipv6.port = 53;
+    }
+
+    *out_dns = dns;
+    return TCS_SUCCESS;
+}
+
+TcsResult tcs_dns_destroy(struct TcsDns** dns)
+{
+    if (dns == NULL || *dns == NULL)
+        return TCS_ERROR_INVALID_ARGUMENT;
+    dns_free(*dns);
+    *dns = NULL;
+    return TCS_SUCCESS;
+}
+
+TcsResult tcs_dns_submit(struct TcsDns* dns, const char* hostname, TcsFamily address_family, size_t* out_handle)
+{
+    if (dns == NULL || hostname == NULL || out_handle == NULL)
+        return TCS_ERROR_INVALID_ARGUMENT;
+    bool is_any = address_family.native == TCS_FAMILY_ANY.native;
+    if (!is_any && address_family.native != TCS_FAMILY_IPV4.native &&
+        address_family.native != TCS_FAMILY_IPV6.native)
+        return TCS_ERROR_NOT_SUPPORTED;
+
+    size_t index = dns->free_head;
+    if (index == DNS_END)
+    {
+        struct TcsDnsLookup new_lookup;
+        memset(&new_lookup, 0, sizeof(new_lookup));
+        if (dns->lookups.count >= UINT32_MAX / 2 || dns->lookups.count > DNS_HANDLE_MASK ||
+            tds_ulist_dns_lookup_add(&dns->lookups, &new_lookup, 1) != 0)
+            return TCS_ERROR_MEMORY;
+        index = dns->lookups.count - 1;
+    }
+    else
+    {
+        dns->free_head = dns->lookups.data[index].next;
+    }
+    struct TcsDnsLookup* lookup = &dns->lookups.data[index];
+    lookup->state = TCS_DNS_LOOKUP_ACTIVE;
+    for (size_t q = 0; q < 2; ++q)
+    {
+        lookup->queries[q].state = TCS_DNS_QUERY_UNUSED;
+        lookup->queries[q].address_count = 0;
+        lookup->queries[q].socket = TCS_SOCKET_INVALID;
+        lookup->queries[q].tcp_buffer = NULL;
+    }
+    *out_handle = dns_handle(dns, index);
+
+    // Numeric addresses and the hosts file are answered at once
+    struct TcsDnsQuery* local = &lookup->queries[0];
+    struct TcsAddress parsed = TCS_ADDRESS_NONE;
+    if (tcs_address_parse(hostname, &parsed) == TCS_SUCCESS &&
+        (is_any || parsed.family.native == address_family.native))
+        local->addresses[local->address_count++] = parsed;
+    for (size_t i = 0; i < dns->hosts.count && local->address_count < TCS_CFG_DNS_ADDRESSES_MAX; ++i)
+    {
+        const struct TcsDnsHost* host = &dns->hosts.data[i];
+        if ((is_any || host->address.family.native == address_family.native) &&
+            dns_hostname_is_equal(host->name, hostname))
+            local->addresses[local->address_count++] = host->address;
+    }
+    if (local->address_count > 0)
+    {
+        local->state = TCS_DNS_QUERY_DONE;
+        local->result = TCS_SUCCESS;
+        dns_lookup_done(dns, index);
+        return TCS_SUCCESS;
+    }
+
+    TcsResult res = dns_name_encode(hostname, lookup->name, &lookup->name_length);
+    if (res != TCS_SUCCESS)
+    {
+        dns_lookup_free(dns, index);
+        return res;
+    }
+    int64_t now_ms = tcs_time_monotonic_ms();
+    for (size_t q = 0; q < 2; ++q)
+    {
+        uint16_t type = q == 0 ? TCS_DNS_TYPE_AAAA : TCS_DNS_TYPE_A;
+        if (!is_any && (type == TCS_DNS_TYPE_AAAA) != (address_family.native == TCS_FAMILY_IPV6.native))
+            continue;
+        struct TcsDnsQuery* query = &lookup->queries[q];
+        dns->in_flight++;
+        query->type = type;
+        query->state = TCS_DNS_QUERY_UDP;
+        query->sent_count = 0;
+        dns_query_send(dns, index, query, now_ms);
+    }
+    return TCS_SUCCESS;
+}
+
+TcsResult tcs_dns_process(struct TcsDns* dns, const struct TcsPollEvent* event, int* out_timeout_ms)
+{
+    if (dns == NULL)
+        return TCS_ERROR_INVALID_ARGUMENT;
+
+    int64_t now_ms = tcs_time_monotonic_ms();
+    const size_t* slot = event != NULL ? tds_hmap_dns_socket_get(&dns->query_by_socket, &event->socket) : NULL;
+    if (slot != NULL)
+    {
+        size_t index = *slot / 2;
+        struct TcsDnsQuery* query = &dns->lookups.data[index].queries[*slot % 2];
+        if (query->state == TCS_DNS_QUERY_UDP)
+            dns_udp_receive(dns, index, query, now_ms);
+        else
+            dns_tcp_progress(dns, index, query, event, now_ms);
+    }
+    if (now_ms >= dns->next_deadline_ms)
+        dns_timeouts(dns, now_ms);
+
+    if (out_timeout_ms != NULL)
+    {
+        if (dns->done_head != DNS_END)
+            *out_timeout_ms = 0;
+        else if (dns->in_flight == 0)
+            *out_timeout_ms = TCS_WAIT_INF;
+        else if (dns->next_deadline_ms <= now_ms)
+            *out_timeout_ms = 0;
+        else
+            *out_timeout_ms = (int)(dns->next_deadline_ms - now_ms);
+    }
+    return TCS_SUCCESS;
+}
+
+TcsResult tcs_dns_take(struct TcsDns* dns,
+                       size_t* out_handle,
+                       TcsResult* out_result,
+                       struct TcsAddress out_addresses[],
+                       size_t addresses_length,
+                       size_t* out_length)
+{
+    if (dns == NULL || out_handle == NULL || out_result == NULL)
+        return TCS_ERROR_INVALID_ARGUMENT;
+    if (out_length != NULL)
+        *out_length = 0;
+
+    size_t index = dns->done_head;
+    if (index == DNS_END)
+        return TCS_AGAIN;
+    struct TcsDnsLookup* lookup = &dns->lookups.data[index];
+    dns->done_head = lookup->next;
+    if (dns->done_head == DNS_END)
+        dns->done_tail = DNS_END;
+
+    // Addresses of both families, otherwise the most telling error. No such name is the least telling.
+    TcsResult result = TCS_ERROR_ADDRESS_LOOKUP_FAILED;
+    size_t count = 0;
+    for (size_t q = 0; q < 2; ++q)
+    {
+        const struct TcsDnsQuery* query = &lookup->queries[q];
+        if (query->state != TCS_DNS_QUERY_DONE)
+            continue;
+        if (query->result == TCS_SUCCESS)
+            result = TCS_SUCCESS;
+        else if (result == TCS_ERROR_ADDRESS_LOOKUP_FAILED)
+            result = query->result;
+        for (size_t i = 0; i < query->address_count; ++i, ++count)
+        {
+            if (out_addresses != NULL && count < addresses_length)
+                out_addresses[count] = query->addresses[i];
+        }
+    }
+    if (out_addresses != NULL && count > addresses_length)
+        count = addresses_length;
+    if (out_length != NULL)
+        *out_length = count;
+    *out_handle = dns_handle(dns, index);
+    *out_result = result;
+    dns_lookup_free(dns, index);
+    return TCS_SUCCESS;
+}
+
+TcsResult tcs_dns_cancel(struct TcsDns* dns, size_t handle)
+{
+    if (dns == NULL)
+        return TCS_ERROR_INVALID_ARGUMENT;
+    size_t index = dns_handle_index(dns, handle);
+    if (index == DNS_END)
+        return TCS_ERROR_INVALID_ARGUMENT;
+
+    if (dns->lookups.data[index].state == TCS_DNS_LOOKUP_DONE)
+    {
+        size_t prev = DNS_END;
+        size_t iter = dns->done_head;
+        while (iter != index)
+        {
+            prev = iter;
+            iter = dns->lookups.data[iter].next;
+        }
+        if (prev != DNS_END)
+            dns->lookups.data[prev].next = dns->lookups.data[index].next;
+        else
+            dns->done_head = dns->lookups.data[index].next;
+        if (dns->done_tail == index)
+            dns->done_tail = prev;
+    }
+    dns_lookup_free(dns, index);
+    return TCS_SUCCESS;
+}
+
+// ######## Socket Filters ########
+
+// Classic BPF opcodes and Linux ancillary offsets, kernel ABI values from linux/filter.h
+#define TCS_BPF_LD_W_ABS 0x20  // BPF_LD | BPF_W | BPF_ABS
+#define TCS_BPF_LD_H_ABS 0x28  // BPF_LD | BPF_H | BPF_ABS
+#define TCS_BPF_LD_B_ABS 0x30  // BPF_LD | BPF_B | BPF_ABS
+#define TCS_BPF_LD_H_IND 0x48  // BPF_LD | BPF_H | BPF_IND
+#define TCS_BPF_LDX_B_MSH 0xb1 // BPF_LDX | BPF_B | BPF_MSH
+#define TCS_BPF_AND_K 0x54     // BPF_ALU | BPF_AND | BPF_K
+#define TCS_BPF_JA 0x05        // BPF_JMP | BPF_JA
+#define TCS_BPF_JEQ_K 0x15     // BPF_JMP | BPF_JEQ | BPF_K
+#define TCS_BPF_JSET_K 0x45    // BPF_JMP | BPF_JSET | BPF_K
+#define TCS_BPF_RET_K 0x06     // BPF_RET | BPF_K
+
+#define TCS_SKF_AD_PROTOCOL 0xFFFFF000U         // SKF_AD_OFF + SKF_AD_PROTOCOL
+#define TCS_SKF_AD_VLAN_TAG 0xFFFFF02CU         // SKF_AD_OFF + SKF_AD_VLAN_TAG
+#define TCS_SKF_AD_VLAN_TAG_PRESENT 0xFFFFF030U // SKF_AD_OFF + SKF_AD_VLAN_TAG_PRESENT
+#define TCS_SKF_NET_OFF 0xFFF00000U             // SKF_NET_OFF, network header independent of socket type
+#define TCS_SKF_LL_OFF 0xFFE00000U              // SKF_LL_OFF, link layer header independent of socket type
+
+// Jump target of a predicate meaning its own trailing reject
+#define TCS_BPF_REJECT 0xFF
+
+// Every predicate ends with its own "ret #0", the check before it jumps over it on a match.
+// This keeps predicates self contained so they can be appended in front of the final accept.
+static TcsResult filter_append(struct TcsFilter* filter, struct TcsFilterInstruction* block, size_t block_length)
+{
+    if (filter == NULL || filter->length == 0 || filter->length > TCS_CFG_FILTER_MAX_INSTRUCTIONS)
+        return TCS_ERROR_INVALID_ARGUMENT;
+    if (filter->length + block_length > TCS_CFG_FILTER_MAX_INSTRUCTIONS)
+        return TCS_ERROR_MEMORY;
+
+    for (size_t i = 0; i < block_length; ++i)
+    {
+        uint8_t to_reject = (uint8_t)(block_length - 1 - i - 1);
+        if (block[i].jt == TCS_BPF_REJECT)
+            block[i].jt = to_reject;
+        if (block[i].jf == TCS_BPF_REJECT)
+            block[i].jf = to_reject;
+    }
+
+    struct TcsFilterInstruction accept = filter->instructions[filter->length - 1];
+    memcpy(&filter->instructions[filter->length - 1], block, block_length * sizeof(struct TcsFilterInstruction));
+    filter->length += block_length;
+    filter->instructions[filter->length - 1] = accept;
+    return TCS_SUCCESS;
+}
+
+TcsResult tcs_filter_init(struct TcsFilter* filter)
+{
+    if (filter == NULL)
+        return TCS_ERROR_INVALID_ARGUMENT;
+
+    memset(filter, 0, sizeof(struct TcsFilter));
+    filter->instructions[0].code = TCS_BPF_RET_K;
+    filter->instructions[0].k = 0xFFFFFFFFU; // Accept the whole frame
+    filter->length = 1;
+    return TCS_SUCCESS;
+}
+
+TcsResult tcs_filter_ether_type(struct TcsFilter* filter, uint16_t ether_type)
+{
+    struct TcsFilterInstruction block[] = {
+        {TCS_BPF_LD_H_ABS, 0, 0, TCS_SKF_AD_PROTOCOL},
+        {TCS_BPF_JEQ_K, 1, 0, ether_type},
+        {TCS_BPF_RET_K, 0, 0, 0},
+    };
+    return filter_append(filter, block, sizeof(block) / sizeof(block[0]));
+}
+
+TcsResult tcs_filter_vlan_id(struct TcsFilter* filter, uint16_t vlan_id)
+{
+    if (vlan_id > 0x0FFF)
+        return TCS_ERROR_INVALID_ARGUMENT;
+
+    struct TcsFilterInstruction block[] = {
+        {TCS_BPF_LD_W_ABS, 0, 0, TCS_SKF_AD_VLAN_TAG_PRESENT},
+        {TCS_BPF_JEQ_K, TCS_BPF_REJECT, 0, 0},
+        {TCS_BPF_LD_W_ABS, 0, 0, TCS_SKF_AD_VLAN_TAG},
+        {TCS_BPF_AND_K, 0, 0, 0x0FFF},
+        {TCS_BPF_JEQ_K, 1, 0, vlan_id},
+        {TCS_BPF_RET_K, 0, 0, 0},
+    };
+    return filter_append(filter, block, sizeof(block) / sizeof(block[0]));
+}
+
+TcsResult tcs_filter_udp_destination_port(struct TcsFilter* filter, uint16_t port)
+{
+    struct TcsFilterInstruction block[] = {
+        {TCS_BPF_LD_H_ABS, 0, 0, TCS_SKF_AD_PROTOCOL},
+        {TCS_BPF_JEQ_K, 8, 0, 0x86DD},                       // IPv6 continues at the next header check
+        {TCS_BPF_JEQ_K, 0, TCS_BPF_REJECT, 0x0800},          // IPv4
+        {TCS_BPF_LD_B_ABS, 0, 0, TCS_SKF_NET_OFF + 9},       // Protocol
+        {TCS_BPF_JEQ_K, 0, TCS_BPF_REJECT, 17},              // UDP
+        {TCS_BPF_LD_H_ABS, 0, 0, TCS_SKF_NET_OFF + 6},       // Flags and fragment offset
+        {TCS_BPF_JSET_K, TCS_BPF_REJECT, 0, 0x1FFF},         // Only the first fragment has the UDP header
+        {TCS_BPF_LDX_B_MSH, 0, 0, TCS_SKF_NET_OFF},          // X = IPv4 header length
+        {TCS_BPF_LD_H_IND, 0, 0, TCS_SKF_NET_OFF + 2},       // Destination port after the IPv4 header
+        {TCS_BPF_JA, 0, 0, 3},                               // Go to the port compare
+        {TCS_BPF_LD_B_ABS, 0, 0, TCS_SKF_NET_OFF + 6},       // IPv6 next header
+        {TCS_BPF_JEQ_K, 0, TCS_BPF_REJECT, 17},              // UDP
+        {TCS_BPF_LD_H_ABS, 0, 0, TCS_SKF_NET_OFF + 40 + 2},  // Destination port after the IPv6 header
+        {TCS_BPF_JEQ_K, 1, 0, port},
+        {TCS_BPF_RET_K, 0, 0, 0},
+    };
+    return filter_append(filter, block, sizeof(block) / sizeof(block[0]));
+}
+
+TcsResult tcs_filter_multicast_group(struct TcsFilter* filter, const struct TcsAddress* multicast_address)
+{
+    if (!tcs_address_is_multicast(multicast_address))
+        return TCS_ERROR_INVALID_ARGUMENT;
+
+    if (multicast_address->family.native == TCS_FAMILY_IPV4.native)
+    {
+        struct TcsFilterInstruction block[] = {
+            {TCS_BPF_LD_H_ABS, 0, 0, TCS_SKF_AD_PROTOCOL},
+            {TCS_BPF_JEQ_K, 0, TCS_BPF_REJECT, 0x0800},
+            {TCS_BPF_LD_W_ABS, 0, 0, TCS_SKF_NET_OFF + 16}, // Destination address
+            {TCS_BPF_JEQ_K, 1, 0, multicast_address->data.ipv4.address},
+            {TCS_BPF_RET_K, 0, 0, 0},
+        };
+        return filter_append(filter, block, sizeof(block) / sizeof(block[0]));
+    }
+
+    if (multicast_address->family.native == TCS_FAMILY_IPV6.native)
+    {
+        uint32_t words[4];
+        const uint8_t* b = multicast_address->data.ipv6.address.bytes;
+        for (int i = 0; i < 4; ++i)
+            words[i] = (uint32_t)b[i * 4] << 24 | (uint32_t)b[i * 4 + 1] << 16 | (uint32_t)b[i * 4 + 2] << 8 |
+                       (uint32_t)b[i * 4 + 3];
+        struct TcsFilterInstruction block[] = {
+            {TCS_BPF_LD_H_ABS, 0, 0, TCS_SKF_AD_PROTOCOL},
+            {TCS_BPF_JEQ_K, 0, TCS_BPF_REJECT, 0x86DD},
+            {TCS_BPF_LD_W_ABS, 0, 0, TCS_SKF_NET_OFF + 24}, // Destination address
+            {TCS_BPF_JEQ_K, 0, TCS_BPF_REJECT, words[0]},
+            {TCS_BPF_LD_W_ABS, 0, 0, TCS_SKF_NET_OFF + 28},
+            {TCS_BPF_JEQ_K, 0, TCS_BPF_REJECT, words[1]},
+            {TCS_BPF_LD_W_ABS, 0, 0, TCS_SKF_NET_OFF + 32},
+            {TCS_BPF_JEQ_K, 0, TCS_BPF_REJECT, words[2]},
+            {TCS_BPF_LD_W_ABS, 0, 0, TCS_SKF_NET_OFF + 36},
+            {TCS_BPF_JEQ_K, 1, 0, words[3]},
+            {TCS_BPF_RET_K, 0, 0, 0},
+        };
+        return filter_append(filter, block, sizeof(block) / sizeof(block[0]));
+    }
+
+    const uint8_t* mac = multicast_address->data.packet.mac;
+    uint32_t mac_high = (uint32_t)mac[0] << 24 | (uint32_t)mac[1] << 16 | (uint32_t)mac[2] << 8 | mac[3];
+    uint32_t mac_low = (uint32_t)mac[4] << 8 | mac[5];
+    struct TcsFilterInstruction block[] = {
+        {TCS_BPF_LD_W_ABS, 0, 0, TCS_SKF_LL_OFF}, // Destination MAC
+        {TCS_BPF_JEQ_K, 0, TCS_BPF_REJECT, mac_high},
+        {TCS_BPF_LD_H_ABS, 0, 0, TCS_SKF_LL_OFF + 4},
+        {TCS_BPF_JEQ_K, 1, 0, mac_low},
+        {TCS_BPF_RET_K, 0, 0, 0},
+    };
+    return filter_append(filter, block, sizeof(block) / sizeof(block[0]));
+}
+
+// ######## Socket Options ########
+
+// tcs_opt_set() is defined in OS specific files
+// tcs_opt_get() is defined in OS specific files
+
+TcsResult tcs_opt_broadcast_set(TcsSocket socket, bool do_allow_broadcast)
+{
+    if (socket == TCS_SOCKET_INVALID)
+        return TCS_ERROR_INVALID_ARGUMENT;
+
+    int b = do_allow_broadcast ? 1 : 0;
+    return tcs_opt_set(socket, TCS_SOL_SOCKET, TCS_SO_BROADCAST, &b, sizeof(b));
+}
+
+TcsResult tcs_opt_type_get(TcsSocket socket, TcsSocketType* type)
+{
+    if (socket == TCS_SOCKET_INVALID || type == NULL)
+        return TCS_ERROR_INVALID_ARGUMENT;
+    int t = 0;
+    size_t s = sizeof(t);
+    TcsResult sts = tcs_opt_get(socket, TCS_SOL_SOCKET, TCS_SO_TYPE, &t, &s);
+    type->native = t;
+    return sts;
+}
+
+TcsResult tcs_opt_broadcast_get(TcsSocket socket, bool* is_broadcast_allowed)
+{
+    if (socket == TCS_SOCKET_INVALID || is_broadcast_allowed == NULL)
+        return TCS_ERROR_INVALID_ARGUMENT;
+    int b = 0;
+    size_t s = sizeof(b);
+    TcsResult sts = tcs_opt_get(socket, TCS_SOL_SOCKET, TCS_SO_BROADCAST, &b, &s);
+    *is_broadcast_allowed = b;
+    return sts;
+}
+
+TcsResult tcs_opt_keep_alive_set(TcsSocket socket, bool do_keep_alive)
 {
     if (socket == TCS_SOCKET_INVALID)
         return TCS_ERROR_INVALID_ARGUMENT;
@@ -876,75 +3207,655 @@ TcsResult tcs_opt_priority_set(TcsSocket socket, int priority)
     return tcs_opt_set(socket, TCS_SOL_SOCKET, TCS_SO_PRIORITY, &priority, sizeof(priority));
 }
 
-TcsResult tcs_opt_priority_get(TcsSocket socket, int* priority)
+TcsResult tcs_opt_priority_get(TcsSocket socket, int* priority)
+{
+    if (socket == TCS_SOCKET_INVALID || priority == NULL)
+        return TCS_ERROR_INVALID_ARGUMENT;
+
+    size_t s = sizeof(*priority);
+    return tcs_opt_get(socket, TCS_SOL_SOCKET, TCS_SO_PRIORITY, priority, &s);
+}
+
+// tcs_opt_nonblocking_set() is defined in OS specific files
+// tcs_opt_nonblocking_get() is defined in OS specific files
+
+// tcs_opt_membership_add() is defined in OS specific files
+
+TcsResult tcs_opt_membership_add_str(TcsSocket socket, const char* multicast_address)
+{
+    if (multicast_address == NULL)
+        return TCS_ERROR_INVALID_ARGUMENT;
+
+    struct TcsAddress addr = TCS_ADDRESS_NONE;
+    TcsResult res = tcs_address_parse(multicast_address, &addr);
+    if (res != TCS_SUCCESS)
+        return res;
+
+    return tcs_opt_membership_add(socket, &addr);
+}
+
+// tcs_opt_membership_add_to() is defined in OS specific files
+// tcs_opt_membership_drop() is defined in OS specific files
+
+TcsResult tcs_opt_membership_drop_str(TcsSocket socket, const char* multicast_address)
+{
+    if (multicast_address == NULL)
+        return TCS_ERROR_INVALID_ARGUMENT;
+
+    struct TcsAddress addr = TCS_ADDRESS_NONE;
+    TcsResult res = tcs_address_parse(multicast_address, &addr);
+    if (res != TCS_SUCCESS)
+        return res;
+
+    return tcs_opt_membership_drop(socket, &addr);
+}
+
+// tcs_opt_membership_drop_from() is defined in OS specific files
+
+// ######## Address and Interface Utilities ########
+
+// tcs_interface_list() is defined in OS specific files
+// tcs_address_list() is defined in OS specific files
+// tcs_address_socket_local() is defined in OS specific files
+// tcs_address_socket_remote() is defined in OS specific files
+// tcs_address_socket_family() is defined in OS specific files
+
+struct TcsAddressCacheEntry
+{
+    char hostname[TCS_CFG_ADDRESS_CACHE_HOSTNAME_SIZE];
+    int family; // Native family, TCS_FAMILY_ANY is cached apart from the specific families
+    uint32_t hash;
+    int64_t expires_ms;
+    TcsResult result; // TCS_SUCCESS or the cached lookup failure
+    size_t address_count;
+    struct TcsAddress addresses[TCS_CFG_ADDRESS_CACHE_ADDRESSES_MAX];
+    size_t chain_next; // Next entry in the same bucket, or the next free entry
+    size_t lru_prev;   // Towards the most recently used
+    size_t lru_next;   // Towards the least recently used
+};
+
+struct TcsAddressCache
+{
+    int positive_ttl_ms;
+    int negative_ttl_ms;
+    size_t capacity;
+    size_t bucket_mask;
+    size_t* buckets;
+    size_t free_head;
+    size_t lru_head; // Most recently used
+    size_t lru_tail; // Evicted first
+    struct TcsAddressCacheEntry* entries;
+};
+
+// End of a bucket chain, the free list and the LRU list
+static const size_t ADDRESS_CACHE_END = (size_t)-1;
+
+static struct TcsAddressCache* address_cache = NULL;
+
+static char address_cache_fold(char c)
+{
+    return (c >= 'A' && c <= 'Z') ? (char)(c - 'A' + 'a') : c;
+}
+
+// FNV-1a over the lower case hostname and the family, DNS names are case insensitive
+static uint32_t address_cache_hash(const char* hostname, int family)
+{
+    uint32_t hash = 2166136261u;
+    for (const char* c = hostname; *c != '\0'; ++c)
+        hash = (hash ^ (uint8_t)address_cache_fold(*c)) * 16777619u;
+    return (hash ^ (uint32_t)family) * 16777619u;
+}
+
+static bool address_cache_hostname_is_equal(const char* l, const char* r)
+{
+    while (*l != '\0' && address_cache_fold(*l) == address_cache_fold(*r))
+    {
+        ++l;
+        ++r;
+    }
+    return address_cache_fold(*l) == address_cache_fold(*r);
+}
+
+static void address_cache_clear(struct TcsAddressCache* cache)
+{
+    for (size_t i = 0; i <= cache->bucket_mask; ++i)
+        cache->buckets[i] = ADDRESS_CACHE_END;
+    for (size_t i = 0; i < cache->capacity; ++i)
+        cache->entries[i].chain_next = i + 1 < cache->capacity ? i + 1 : ADDRESS_CACHE_END;
+    cache->free_head = 0;
+    cache->lru_head = ADDRESS_CACHE_END;
+    cache->lru_tail = ADDRESS_CACHE_END;
+}
+
+static void address_cache_free(struct TcsAddressCache* cache)
+{
+    if (cache == NULL)
+        return;
+    tcs_lib_free(cache->buckets);
+    tcs_lib_free(cache->entries);
+    tcs_lib_free(cache);
+}
+
+static void address_cache_lru_unlink(struct TcsAddressCache* cache, size_t index)
+{
+    struct TcsAddressCacheEntry* entry = &cache->entries[index];
+    if (entry->lru_prev != ADDRESS_CACHE_END)
+        cache->entries[entry->lru_prev].lru_next = entry->lru_next;
+    else
+        cache->lru_head = entry->lru_next;
+    if (entry->lru_next != ADDRESS_CACHE_END)
+        cache->entries[entry->lru_next].lru_prev = entry->lru_prev;
+    else
+        cache->lru_tail = entry->lru_prev;
+}
+
+static void address_cache_lru_push(struct TcsAddressCache* cache, size_t index)
+{
+    struct TcsAddressCacheEntry* entry = &cache->entries[index];
+    entry->lru_prev = ADDRESS_CACHE_END;
+    entry->lru_next = cache->lru_head;
+    if (cache->lru_head != ADDRESS_CACHE_END)
+        cache->entries[cache->lru_head].lru_prev = index;
+    else
+        cache->lru_tail = index;
+    cache->lru_head = index;
+}
+
+static size_t address_cache_find(const struct TcsAddressCache* cache, const char* hostname, int family, uint32_t hash)
+{
+    size_t index = cache->buckets[hash & cache->bucket_mask];
+    while (index != ADDRESS_CACHE_END)
+    {
+        const struct TcsAddressCacheEntry* entry = &cache->entries[index];
+        if (entry->hash == hash && entry->family == family &&
+            address_cache_hostname_is_equal(entry->hostname, hostname))
+            return index;
+        index = entry->chain_next;
+    }
+    return ADDRESS_CACHE_END;
+}
+
+static void address_cache_remove(struct TcsAddressCache* cache, size_t index)
+{
+    struct TcsAddressCacheEntry* entry = &cache->entries[index];
+    size_t* link = &cache->buckets[entry->hash & cache->bucket_mask];
+    while (*link != index)
+        link = &cache->entries[*link].chain_next;
+    *link = entry->chain_next;
+    address_cache_lru_unlink(cache, index);
+    entry->chain_next = cache->free_head;
+    cache->free_head = index;
+}
+
+// Replaces an existing entry, evicts the least recently used entry when full. The caller holds the lock.
+static void address_cache_store(struct TcsAddressCache* cache,
+                                const char* hostname,
+                                int family,
+                                TcsResult result,
+                                const struct TcsAddress addresses[],
+                                size_t address_count,
+                                int ttl_ms)
+{
+    uint32_t hash = address_cache_hash(hostname, family);
+    size_t index = address_cache_find(cache, hostname, family, hash);
+    if (index != ADDRESS_CACHE_END)
+        address_cache_remove(cache, index);
+    if (cache->free_head == ADDRESS_CACHE_END)
+        address_cache_remove(cache, cache->lru_tail);
+
+    index = cache->free_head;
+    struct TcsAddressCacheEntry* entry = &cache->entries[index];
+    cache->free_head = entry->chain_next;
+
+    memcpy(entry->hostname, hostname, strlen(hostname) + 1);
+    entry->family = family;
+    entry->hash = hash;
+    entry->expires_ms = ttl_ms == TCS_WAIT_INF ? INT64_MAX : tcs_time_monotonic_ms() + ttl_ms;
+    entry->result = result;
+    entry->address_count = address_count;
+    if (address_count > 0)
+        memcpy(entry->addresses, addresses, address_count * sizeof(struct TcsAddress));
+    entry->chain_next = cache->buckets[hash & cache->bucket_mask];
+    cache->buckets[hash & cache->bucket_mask] = index;
+    address_cache_lru_push(cache, index);
+}
+
+// Fills the output the same way as tcs_address_resolve() fills it from getaddrinfo()
+static void address_cache_copy_out(const struct TcsAddress addresses[],
+                                   size_t address_count,
+                                   struct TcsAddress out_addresses[],
+                                   size_t addresses_length,
+                                   size_t* out_length)
+{
+    if (out_addresses != NULL)
+    {
+        if (address_count > addresses_length)
+            address_count = addresses_length;
+        if (address_count > 0)
+            memcpy(out_addresses, addresses, address_count * sizeof(struct TcsAddress));
+    }
+    if (out_length != NULL)
+        *out_length = address_count;
+}
+
+// Returns false on a miss, expired entries are removed. The caller holds the lock.
+static bool address_cache_lookup(struct TcsAddressCache* cache,
+                                 const char* hostname,
+                                 int family,
+                                 struct TcsAddress out_addresses[],
+                                 size_t addresses_length,
+                                 size_t* out_length,
+                                 TcsResult* out_result)
+{
+    size_t index = address_cache_find(cache, hostname, family, address_cache_hash(hostname, family));
+    if (index == ADDRESS_CACHE_END)
+        return false;
+    const struct TcsAddressCacheEntry* entry = &cache->entries[index];
+    if (entry->expires_ms != INT64_MAX && tcs_time_monotonic_ms() >= entry->expires_ms)
+    {
+        address_cache_remove(cache, index);
+        return false;
+    }
+    address_cache_lru_unlink(cache, index);
+    address_cache_lru_push(cache, index);
+    address_cache_copy_out(entry->addresses, entry->address_count, out_addresses, addresses_length, out_length);
+    *out_result = entry->result;
+    return true;
+}
+
+TcsResult tcs_address_resolve(const char* hostname,
+                              TcsFamily address_family,
+                              struct TcsAddress out_addresses[],
+                              size_t addresses_length,
+                              size_t* out_length)
+{
+    if (hostname == NULL)
+        return TCS_ERROR_INVALID_ARGUMENT;
+
+    if (out_addresses == NULL && out_length == NULL)
+        return TCS_ERROR_INVALID_ARGUMENT;
+
+    if (out_length != NULL)
+        *out_length = 0;
+
+    // Fast path: try numeric/MAC parse first to avoid DNS lookup
+    struct TcsAddress parsed = TCS_ADDRESS_NONE;
+    if (tcs_address_parse(hostname, &parsed) == TCS_SUCCESS && parsed.family.native != TCS_FAMILY_ANY.native)
+    {
+        if (address_family.native == TCS_FAMILY_ANY.native || parsed.family.native == address_family.native)
+        {
+            if (out_addresses != NULL && addresses_length > 0)
+                out_addresses[0] = parsed;
+            if (out_length != NULL)
+                *out_length = 1;
+            return TCS_SUCCESS;
+        }
+    }
+
+    if (address_family.native == -1) // sentinel for unsupported families (e.g. TCS_FAMILY_PACKET on Windows)
+        return TCS_ERROR_NOT_SUPPORTED;
+
+    if (strlen(hostname) >= TCS_CFG_ADDRESS_CACHE_HOSTNAME_SIZE)
+        return tcs_os_address_resolve_native(hostname, address_family, out_addresses, addresses_length, out_length);
+
+    tcs_os_global_lock();
+    bool is_cached = address_cache != NULL;
+    TcsResult res = TCS_SUCCESS;
+    if (is_cached && address_cache_lookup(address_cache,
+                                          hostname,
+                                          address_family.native,
+                                          out_addresses,
+                                          addresses_length,
+                                          out_length,
+                                          &res))
+    {
+        tcs_os_global_unlock();
+        return res;
+    }
+    tcs_os_global_unlock();
+    if (!is_cached)
+        return tcs_os_address_resolve_native(hostname, address_family, out_addresses, addresses_length, out_length);
+
+    // Resolve into a buffer of our own so the cache gets the full answer whatever the caller asked for
+    struct TcsAddress found[TCS_CFG_ADDRESS_CACHE_ADDRESSES_MAX];
+    size_t found_count = 0;
+    res = tcs_os_address_resolve_native(hostname,
+                                        address_family,
+                                        found,
+                                        TCS_CFG_ADDRESS_CACHE_ADDRESSES_MAX,
+                                        &found_count);
+
+    tcs_os_global_lock();
+    if (address_cache != NULL)
+    {
+        int ttl_ms = res == TCS_SUCCESS ? address_cache->positive_ttl_ms : address_cache->negative_ttl_ms;
+        bool is_cacheable = res == TCS_SUCCESS || res == TCS_ERROR_ADDRESS_LOOKUP_FAILED;
+        if (is_cacheable && ttl_ms != 0)
+            address_cache_store(address_cache, hostname, address_family.native, res, found, found_count, ttl_ms);
+    }
+    tcs_os_global_unlock();
+
+    if (res != TCS_SUCCESS)
+        return res;
+    address_cache_copy_out(found, found_count, out_addresses, addresses_length, out_length);
+    return TCS_SUCCESS;
+}
+
+TcsResult tcs_address_cache_enable(size_t max_entries, int positive_ttl_ms, int negative_ttl_ms)
 {
-    if (socket == TCS_SOCKET_INVALID || priority == NULL)
+    if (max_entries == 0)
+        return TCS_ERROR_INVALID_ARGUMENT;
+    if ((positive_ttl_ms < 0 && positive_ttl_ms != TCS_WAIT_INF) ||
+        (negative_ttl_ms < 0 && negative_ttl_ms != TCS_WAIT_INF))
         return TCS_ERROR_INVALID_ARGUMENT;
 
-    size_t s = sizeof(*priority);
-    return tcs_opt_get(socket, TCS_SOL_SOCKET, TCS_SO_PRIORITY, priority, &s);
+    size_t bucket_count = 1;
+    while (bucket_count < max_entries)
+        bucket_count *= 2;
+
+    struct TcsAddressCache* cache = (struct TcsAddressCache*)tcs_lib_malloc(sizeof(struct TcsAddressCache));
+    if (cache == NULL)
+        return TCS_ERROR_MEMORY;
+    cache->buckets = (size_t*)tcs_lib_malloc(bucket_count * sizeof(size_t));
+    cache->entries = (struct TcsAddressCacheEntry*)tcs_lib_malloc(max_entries * sizeof(struct TcsAddressCacheEntry));
+    if (cache->buckets == NULL || cache->entries == NULL)
+    {
+        address_cache_free(cache);
+        return TCS_ERROR_MEMORY;
+    }
+    cache->positive_ttl_ms = positive_ttl_ms;
+    cache->negative_ttl_ms = negative_ttl_ms;
+    cache->capacity = max_entries;
+    cache->bucket_mask = bucket_count - 1;
+    address_cache_clear(cache);
+
+    tcs_os_global_lock();
+    struct TcsAddressCache* old_cache = address_cache;
+    address_cache = cache;
+    tcs_os_global_unlock();
+
+    address_cache_free(old_cache);
+    return TCS_SUCCESS;
 }
 
-// tcs_opt_nonblocking_set() is defined in OS specific files
-// tcs_opt_nonblocking_get() is defined in OS specific files
+TcsResult tcs_address_cache_disable(void)
+{
+    tcs_os_global_lock();
+    struct TcsAddressCache* cache = address_cache;
+    address_cache = NULL;
+    tcs_os_global_unlock();
 
-// tcs_opt_membership_add() is defined in OS specific files
+    address_cache_free(cache);
+    return TCS_SUCCESS;
+}
 
-TcsResult tcs_opt_membership_add_str(TcsSocket socket, const char* multicast_address)
+TcsResult tcs_address_cache_prefill(const char* hostname,
+                                    TcsFamily address_family,
+                                    const struct TcsAddress addresses[],
+                                    size_t addresses_length,
+                                    int ttl_ms)
 {
-    if (multicast_address == NULL)
+    if (hostname == NULL || strlen(hostname) >= TCS_CFG_ADDRESS_CACHE_HOSTNAME_SIZE)
+        return TCS_ERROR_INVALID_ARGUMENT;
+    if ((addresses == NULL && addresses_length > 0) || addresses_length > TCS_CFG_ADDRESS_CACHE_ADDRESSES_MAX)
+        return TCS_ERROR_INVALID_ARGUMENT;
+    if (ttl_ms < 0 && ttl_ms != TCS_WAIT_INF)
         return TCS_ERROR_INVALID_ARGUMENT;
+    if (address_family.native == -1)
+        return TCS_ERROR_NOT_SUPPORTED;
 
-    struct TcsAddress addr = TCS_ADDRESS_NONE;
-    TcsResult res = tcs_address_parse(multicast_address, &addr);
-    if (res != TCS_SUCCESS)
-        return res;
+    tcs_os_global_lock();
+    if (address_cache == NULL)
+    {
+        tcs_os_global_unlock();
+        return TCS_ERROR_LIBRARY_NOT_INITIALIZED;
+    }
+    TcsResult result = addresses_length > 0 ? TCS_SUCCESS : TCS_ERROR_ADDRESS_LOOKUP_FAILED;
+    address_cache_store(address_cache, hostname, address_family.native, result, addresses, addresses_length, ttl_ms);
+    tcs_os_global_unlock();
+    return TCS_SUCCESS;
+}
 
-    return tcs_opt_membership_add(socket, &addr);
+TcsResult tcs_address_cache_flush(const char* hostname)
+{
+    tcs_os_global_lock();
+    if (address_cache != NULL && hostname == NULL)
+    {
+        address_cache_clear(address_cache);
+    }
+    else if (address_cache != NULL)
+    {
+        size_t index = address_cache->lru_head;
+        while (index != ADDRESS_CACHE_END)
+        {
+            size_t next = address_cache->entries[index].lru_next;
+            if (address_cache_hostname_is_equal(address_cache->entries[index].hostname, hostname))
+                address_cache_remove(address_cache, index);
+            index = next;
+        }
+    }
+    tcs_os_global_unlock();
+    return TCS_SUCCESS;
 }
 
-// tcs_opt_membership_add_to() is defined in OS specific files
-// tcs_opt_membership_drop() is defined in OS specific files
+// Value of a hex digit, or 0xFF for any other character
+static const uint8_t address_hex_lut[256] = {
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, // 0x00
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, // 0x10
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, // 0x20
+    0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, // 0x30
+    0xFF, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E, 0x0F, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, // 0x40
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, // 0x50
+    0xFF, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E, 0x0F, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, // 0x60
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, // 0x70
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, // 0x80
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, // 0x90
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, // 0xA0
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, // 0xB0
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, // 0xC0
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, // 0xD0
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, // 0xE0
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, // 0xF0
+};
+
+static inline uint32_t address_digit(char c)
+{
+    return (uint32_t)(unsigned char)c - '0';
+}
 
-TcsResult tcs_opt_membership_drop_str(TcsSocket socket, const char* multicast_address)
+// Parses 1 to max_digits decimal digits without a leading zero, the forms where sscanf("%i") would not read octal.
+// Returns the number of characters consumed or 0 if there is no such number.
+static size_t address_decimal_parse(const char* c, size_t max_digits, uint32_t* out_value)
 {
-    if (multicast_address == NULL)
-        return TCS_ERROR_INVALID_ARGUMENT;
+    if (address_digit(c[0]) > 9)
+        return 0;
+    uint32_t value = address_digit(c[0]);
+    size_t digits = 1;
+    while (digits < max_digits && address_digit(c[digits]) <= 9)
+        value = value * 10 + address_digit(c[digits++]);
+    if (address_digit(c[digits]) <= 9 || (c[0] == '0' && digits > 1))
+        return 0;
+    *out_value = value;
+    return digits;
+}
 
-    struct TcsAddress addr = TCS_ADDRESS_NONE;
-    TcsResult res = tcs_address_parse(multicast_address, &addr);
-    if (res != TCS_SUCCESS)
-        return res;
+// "a.b.c.d" and "a.b.c.d:port" in plain decimal
+static bool address_parse_fast_ipv4(const char* c, struct TcsAddress* out_address)
+{
+    uint32_t address = 0;
+    for (int i = 0; i < 4; ++i)
+    {
+        uint32_t octet = 0;
+        size_t length = address_decimal_parse(c, 3, &octet);
+        if (length == 0 || octet > 255)
+            return false;
+        address = address << 8 | octet;
+        c += length;
+        if (i < 3 && *c++ != '.')
+            return false;
+    }
+    uint32_t port = 0;
+    if (*c == ':')
+    {
+        size_t length = address_decimal_parse(c + 1, 5, &port);
+        if (length == 0 || port > UINT16_MAX)
+            return false;
+        c += 1 + length;
+    }
+    if (*c != '\0')
+        return false;
 
-    return tcs_opt_membership_drop(socket, &addr);
+    out_address->family = TCS_FAMILY_IPV4;
+    out_address->data.ipv4.address = address;
+    out_address->data.ipv4.port = (uint16_t)port;
+    return true;
 }
 
-// tcs_opt_membership_drop_from() is defined in OS specific files
-
-// ######## Address and Interface Utilities ########
+// "x:x:x:x:x:x" with one or two hex digits per byte
+static bool address_parse_fast_mac(const char* c, struct TcsAddress* out_address)
+{
+    uint8_t mac[6];
+    for (int i = 0; i < 6; ++i)
+    {
+        uint32_t high = address_hex_lut[(unsigned char)c[0]];
+        if (high > 0xF)
+            return false;
+        uint32_t low = address_hex_lut[(unsigned char)c[1]];
+        mac[i] = (uint8_t)(low > 0xF ? high : high << 4 | low);
+        c += low > 0xF ? 1 : 2;
+        if (*c++ != (i < 5 ? ':' : '\0'))
+            return false;
+    }
 
-// tcs_interface_list() is defined in OS specific files
-// tcs_address_resolve() is defined in OS specific files
-// tcs_address_list() is defined in OS specific files
-// tcs_address_socket_local() is defined in OS specific files
-// tcs_address_socket_remote() is defined in OS specific files
-// tcs_address_socket_family() is defined in OS specific files
+    out_address->family = TCS_FAMILY_PACKET;
+    memcpy(out_address->data.packet.mac, mac, sizeof(mac));
+    return true;
+}
 
-TcsResult tcs_address_parse(const char str[], struct TcsAddress* out_address)
+// Hex groups with at most one "::", an optional decimal scope and, within brackets, an optional port.
+// Embedded IPv4 and anything unusual is left to the DFA.
+static bool address_parse_fast_ipv6(const char* c, struct TcsAddress* out_address)
 {
-    if (out_address == NULL)
-        return TCS_ERROR_INVALID_ARGUMENT;
-    if (str == NULL)
-        return TCS_ERROR_INVALID_ARGUMENT;
+    bool is_bracketed = *c == '[';
+    if (is_bracketed)
+        c++;
+
+    uint16_t groups[8];
+    int group_count = 0;
+    int gap_pos = -1;
+    if (c[0] == ':')
+    {
+        if (c[1] != ':')
+            return false;
+        gap_pos = 0;
+        c += 2;
+    }
+    while (address_hex_lut[(unsigned char)*c] <= 0xF)
+    {
+        uint32_t value = 0;
+        int digits = 0;
+        uint32_t digit;
+        while ((digit = address_hex_lut[(unsigned char)*c]) <= 0xF)
+        {
+            if (++digits > 4)
+                return false;
+            value = value << 4 | digit;
+            c++;
+        }
+        if (group_count == 8)
+            return false;
+        groups[group_count++] = (uint16_t)value;
+        if (c[0] != ':')
+            break;
+        if (c[1] == ':')
+        {
+            if (gap_pos >= 0)
+                return false;
+            gap_pos = group_count;
+            c += 2;
+        }
+        else if (address_hex_lut[(unsigned char)c[1]] <= 0xF)
+        {
+            c++;
+        }
+        else
+        {
+            return false;
+        }
+    }
+    if (gap_pos >= 0 ? group_count > 7 : group_count != 8)
+        return false;
 
-    if (str[0] == '\0')
+    uint32_t scope_id = 0;
+    if (*c == '%')
     {
-        *out_address = TCS_ADDRESS_NONE;
-        return TCS_SUCCESS;
+        // The DFA takes no scope right after "::"
+        if (gap_pos == group_count)
+            return false;
+        uint32_t digit = address_digit(*++c);
+        if (digit > 9)
+            return false;
+        uint64_t value = 0;
+        for (int digits = 0; digit <= 9; digit = address_digit(*++c))
+        {
+            if (++digits > 10)
+                return false;
+            value = value * 10 + digit;
+        }
+        if (value > UINT32_MAX)
+            return false;
+        scope_id = (uint32_t)value;
+    }
+    uint32_t port = 0;
+    if (is_bracketed)
+    {
+        if (*c++ != ']')
+            return false;
+        if (*c == ':')
+        {
+            size_t length = address_decimal_parse(c + 1, 5, &port);
+            if (length == 0 || port > UINT16_MAX)
+                return false;
+            c += 1 + length;
+        }
+    }
+    if (*c != '\0')
+        return false;
+
+    out_address->family = TCS_FAMILY_IPV6;
+    int gap_size = gap_pos >= 0 ? 8 - group_count : 0;
+    for (int i = 0, group = 0; i < 8; ++i)
+    {
+        uint16_t value = (i >= gap_pos && i < gap_pos + gap_size) ? 0 : groups[group++];
+        out_address->data.ipv6.address.bytes[i * 2] = (uint8_t)(value >> 8);
+        out_address->data.ipv6.address.bytes[i * 2 + 1] = (uint8_t)(value & 0xFF);
     }
+    out_address->data.ipv6.port = (uint16_t)port;
+    out_address->data.ipv6.scope_id = (TcsInterfaceId)scope_id;
+    return true;
+}
+
+// Straight-line parsers for the canonical forms, dispatched on the first separator found. Only accepts strings
+// that address_parse_generic() would parse to the same address, everything else is left to it.
+static bool address_parse_fast(const char str[], struct TcsAddress* out_address)
+{
+    const char* c = str;
+    while (address_hex_lut[(unsigned char)*c] <= 0xF)
+        c++;
+    memset(out_address, 0, sizeof(struct TcsAddress));
+    if (*c == '.')
+        return address_parse_fast_ipv4(str, out_address);
+    if (*c == ':')
+        return address_parse_fast_mac(str, out_address) || address_parse_fast_ipv6(str, out_address);
+    if (*c == '[')
+        return address_parse_fast_ipv6(str, out_address);
+    return false;
+}
 
+// Slow but easy parser that handles every accepted form
+static TcsResult address_parse_generic(const char str[], struct TcsAddress* out_address)
+{
     memset(out_address, 0, sizeof(struct TcsAddress));
-    // Slow but easy parser
     int n_colons = 0;
     int n_dots = 0;
     int double_colons = 0;
@@ -1311,29 +4222,84 @@ TcsResult tcs_address_parse(const char str[], struct TcsAddress* out_address)
     return TCS_SUCCESS;
 }
 
-TcsResult tcs_address_to_str(const struct TcsAddress* address, char out_str[], size_t str_length, size_t* out_length)
+TcsResult tcs_address_parse(const char str[], struct TcsAddress* out_address)
 {
-    if (address == NULL)
-        return TCS_ERROR_INVALID_ARGUMENT;
-    if (out_str == NULL && str_length != 0)
+    if (out_address == NULL)
         return TCS_ERROR_INVALID_ARGUMENT;
-    if (out_str == NULL && out_length == NULL)
+    if (str == NULL)
         return TCS_ERROR_INVALID_ARGUMENT;
 
-    char str[70];
-    memset(str, 0, sizeof str);
+    if (str[0] == '\0')
+    {
+        *out_address = TCS_ADDRESS_NONE;
+        return TCS_SUCCESS;
+    }
+
+    if (address_parse_fast(str, out_address))
+        return TCS_SUCCESS;
+    return address_parse_generic(str, out_address);
+}
+
+#define TCS_ADDRESS_STR_SIZE 70 // Fits every supported family, as documented for tcs_address_to_str()
+
+static const char address_decimal_pairs[201] = "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+                                               "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+                                               "8081828384858687888990919293949596979899";
+
+// Writes @p value in decimal, two digits per table lookup, and returns the number of characters
+static size_t address_decimal_write(char* out, uint32_t value)
+{
+    char digits[10];
+    size_t position = sizeof(digits);
+    while (value >= 100)
+    {
+        uint32_t pair = value % 100 * 2;
+        value /= 100;
+        digits[--position] = address_decimal_pairs[pair + 1];
+        digits[--position] = address_decimal_pairs[pair];
+    }
+    if (value >= 10)
+    {
+        digits[--position] = address_decimal_pairs[value * 2 + 1];
+        digits[--position] = address_decimal_pairs[value * 2];
+    }
+    else
+    {
+        digits[--position] = (char)('0' + value);
+    }
+    memcpy(out, digits + position, sizeof(digits) - position);
+    return sizeof(digits) - position;
+}
+
+// Lower case hex without leading zeros, as "%x"
+static size_t address_hex_write(char* out, uint32_t group)
+{
+    static const char hex_digits[] = "0123456789abcdef";
+    size_t length = group >= 0x1000 ? 4 : group >= 0x100 ? 3 : group >= 0x10 ? 2 : 1;
+    for (size_t i = length; i > 0; --i, group >>= 4)
+        out[i - 1] = hex_digits[group & 0xF];
+    return length;
+}
+
+// Formats into @p out without a terminator and returns the length, or 0 for unsupported families.
+// The output is byte for byte what the former snprintf() based formatting produced.
+static size_t address_format(const struct TcsAddress* address, char out[TCS_ADDRESS_STR_SIZE])
+{
+    char* c = out;
     if (address->family.native == TCS_FAMILY_IPV4.native)
     {
         uint32_t d = address->data.ipv4.address;
-        uint16_t p = address->data.ipv4.port;
-        uint8_t b1 = (uint8_t)(d & 0xFF);
-        uint8_t b2 = (uint8_t)((d >> 8) & 0xFF);
-        uint8_t b3 = (uint8_t)((d >> 16) & 0xFF);
-        uint8_t b4 = (uint8_t)((d >> 24) & 0xFF);
-        if (p == 0)
-            snprintf(str, sizeof str, "%i.%i.%i.%i", b4, b3, b2, b1);
-        else
-            snprintf(str, sizeof str, "%i.%i.%i.%i:%i", b4, b3, b2, b1, p);
+        for (int shift = 24; shift >= 0; shift -= 8)
+        {
+            c += address_decimal_write(c, d >> shift & 0xFF);
+            *c++ = '.';
+        }
+        c--;
+        if (address->data.ipv4.port != 0)
+        {
+            *c++ = ':';
+            c += address_decimal_write(c, address->data.ipv4.port);
+        }
     }
     else if (address->family.native == TCS_FAMILY_IPV6.native)
     {
@@ -1342,86 +4308,132 @@ TcsResult tcs_address_to_str(const struct TcsAddress* address, char out_str[], s
             groups[i] = (uint16_t)((unsigned int)address->data.ipv6.address.bytes[i * 2] << 8 |
                                    address->data.ipv6.address.bytes[i * 2 + 1]);
 
-        // Find longest run of consecutive zero groups for :: compression (RFC 5952)
+        // Find longest run of consecutive zero groups for :: compression (RFC 5952), the first one on ties
         int best_start = -1;
-        int best_len = 0;
-        int cur_start = -1;
-        int cur_len = 0;
-        for (int i = 0; i < 8; i++)
+        int best_len = 1;
+        for (int i = 0; i < 8;)
         {
-            if (groups[i] == 0)
-            {
-                if (cur_start < 0)
-                    cur_start = i;
-                cur_len++;
-                if (cur_len > best_len)
-                {
-                    best_start = cur_start;
-                    best_len = cur_len;
-                }
-            }
-            else
+            int run = 0;
+            while (i + run < 8 && groups[i + run] == 0)
+                run++;
+            if (run > best_len)
             {
-                cur_start = -1;
-                cur_len = 0;
+                best_start = i;
+                best_len = run;
             }
+            i += run + 1;
         }
-        if (best_len < 2)
-            best_start = -1;
 
-        char addr_str[46];
-        int pos = 0;
+        uint16_t port = address->data.ipv6.port;
+        TcsInterfaceId scope_id = address->data.ipv6.scope_id;
+        if (port != 0)
+            *c++ = '[';
         for (int i = 0; i < 8; i++)
         {
             if (i == best_start)
             {
-                pos += snprintf(addr_str + pos, sizeof addr_str - (size_t)pos, "::");
+                *c++ = ':';
+                *c++ = ':';
                 i += best_len - 1;
                 continue;
             }
-            if (i > 0 && (best_start < 0 || i != best_start + best_len))
-                addr_str[pos++] = ':';
-            pos += snprintf(addr_str + pos, sizeof addr_str - (size_t)pos, "%x", (unsigned int)groups[i]);
-        }
-        addr_str[pos] = '\0';
-
-        uint16_t p = address->data.ipv6.port;
-        TcsInterfaceId sc = address->data.ipv6.scope_id;
-        if (p != 0 && sc != 0)
-            snprintf(str, sizeof str, "[%s%%%u]:%u", addr_str, (unsigned int)sc, (unsigned int)p);
-        else if (p != 0)
-            snprintf(str, sizeof str, "[%s]:%u", addr_str, (unsigned int)p);
-        else if (sc != 0)
-            snprintf(str, sizeof str, "%s%%%u", addr_str, (unsigned int)sc);
-        else
-            snprintf(str, sizeof str, "%s", addr_str);
+            if (i > 0 && i != best_start + best_len)
+                *c++ = ':';
+            c += address_hex_write(c, groups[i]);
+        }
+        if (scope_id != 0)
+        {
+            *c++ = '%';
+            c += address_decimal_write(c, (uint32_t)scope_id);
+        }
+        if (port != 0)
+        {
+            *c++ = ']';
+            *c++ = ':';
+            c += address_decimal_write(c, port);
+        }
     }
     else if (address->family.native == TCS_FAMILY_PACKET.native)
     {
-        snprintf(str,
-                 sizeof str,
-                 "%02X:%02X:%02X:%02X:%02X:%02X",
-                 address->data.packet.mac[0],
-                 address->data.packet.mac[1],
-                 address->data.packet.mac[2],
-                 address->data.packet.mac[3],
-                 address->data.packet.mac[4],
-                 address->data.packet.mac[5]);
+        static const char hex_digits[] = "0123456789ABCDEF";
+        for (int i = 0; i < 6; ++i)
+        {
+            *c++ = hex_digits[address->data.packet.mac[i] >> 4];
+            *c++ = hex_digits[address->data.packet.mac[i] & 0xF];
+            *c++ = ':';
+        }
+        c--;
     }
-    else
-    {
+    return (size_t)(c - out);
+}
+
+TcsResult tcs_address_to_str(const struct TcsAddress* address, char out_str[], size_t str_length, size_t* out_length)
+{
+    if (address == NULL)
+        return TCS_ERROR_INVALID_ARGUMENT;
+    if (out_str == NULL && str_length != 0)
+        return TCS_ERROR_INVALID_ARGUMENT;
+    if (out_str == NULL && out_length == NULL)
+        return TCS_ERROR_INVALID_ARGUMENT;
+
+    char str[TCS_ADDRESS_STR_SIZE];
+    size_t written = address_format(address, str);
+    if (written == 0)
         return TCS_ERROR_NOT_IMPLEMENTED;
-    }
 
-    size_t written = strlen(str);
     if (out_length != NULL)
         *out_length = written;
     if (out_str == NULL)
         return TCS_SUCCESS;
     if (str_length <= written)
         return TCS_ERROR_MEMORY;
-    memcpy(out_str, str, written + 1);
+    memcpy(out_str, str, written);
+    out_str[written] = '\0';
+
+    return TCS_SUCCESS;
+}
+
+TcsResult tcs_address_to_str_many(const struct TcsAddress addresses[],
+                                  size_t addresses_length,
+                                  const char* separator,
+                                  char out_str[],
+                                  size_t str_length,
+                                  size_t* out_length)
+{
+    if (addresses == NULL && addresses_length != 0)
+        return TCS_ERROR_INVALID_ARGUMENT;
+    if (out_str == NULL && str_length != 0)
+        return TCS_ERROR_INVALID_ARGUMENT;
+    if (out_str == NULL && out_length == NULL)
+        return TCS_ERROR_INVALID_ARGUMENT;
 
+    size_t separator_length = separator != NULL ? strlen(separator) : 0;
+    size_t total = 0;
+    bool fits = out_str != NULL && str_length > 0;
+    for (size_t i = 0; i < addresses_length; ++i)
+    {
+        size_t offset = total + (i > 0 ? separator_length : 0);
+        // Format straight into the output while any address fits, only the tail goes through a copy
+        char str[TCS_ADDRESS_STR_SIZE];
+        char* target = fits && str_length > offset + TCS_ADDRESS_STR_SIZE ? out_str + offset : str;
+        size_t written = address_format(&addresses[i], target);
+        if (written == 0)
+            return TCS_ERROR_NOT_IMPLEMENTED;
+        fits = fits && str_length > offset + written;
+        if (fits && i > 0)
+            memcpy(out_str + total, separator, separator_length);
+        if (fits && target == str)
+            memcpy(out_str + offset, str, written);
+        total = offset + written;
+    }
+
+    if (out_length != NULL)
+        *out_length = total;
+    if (out_str == NULL)
+        return TCS_SUCCESS;
+    if (!fits)
+        return TCS_ERROR_MEMORY;
+    out_str[total] = '\0';
     return TCS_SUCCESS;
 }
 
@@ -1448,6 +4460,47 @@ bool tcs_address_is_equal(const struct TcsAddress* l, const struct TcsAddress* r
     return false;
 }
 
+static inline uint64_t address_hash_mix(uint64_t hash, uint64_t word)
+{
+    hash = (hash ^ word) * 0x9E3779B97F4A7C15ULL;
+    return hash ^ (hash >> 29);
+}
+
+uint64_t tcs_address_hash(const struct TcsAddress* address, uint64_t seed)
+{
+    if (address == NULL)
+        return seed;
+
+    // One multiply per 64 bit word of the fields that tcs_address_is_equal() compares
+    uint64_t hash = address_hash_mix(seed, (uint64_t)(uint32_t)address->family.native);
+    if (address->family.native == TCS_FAMILY_IPV4.native)
+    {
+        hash = address_hash_mix(hash, (uint64_t)address->data.ipv4.address << 16 | address->data.ipv4.port);
+    }
+    else if (address->family.native == TCS_FAMILY_IPV6.native)
+    {
+        uint64_t words[2];
+        memcpy(words, address->data.ipv6.address.bytes, sizeof(words));
+        hash = address_hash_mix(hash, words[0]);
+        hash = address_hash_mix(hash, words[1] ^ address->data.ipv6.port);
+    }
+    else if (address->family.native == TCS_FAMILY_PACKET.native)
+    {
+        uint64_t mac = 0;
+        memcpy(&mac, address->data.packet.mac, sizeof(address->data.packet.mac));
+        hash = address_hash_mix(hash, mac << 16 | address->data.packet.protocol);
+        hash = address_hash_mix(hash, address->data.packet.interface_id);
+    }
+
+    // Final avalanche (MurmurHash3 fmix64) so the low bits used by power of two tables depend on every input bit
+    hash ^= hash >> 33;
+    hash *= 0xFF51AFD7ED558CCDULL;
+    hash ^= hash >> 33;
+    hash *= 0xC4CEB9FE1A85EC53ULL;
+    hash ^= hash >> 33;
+    return hash;
+}
+
 bool tcs_address_is_any(const struct TcsAddress* addr)
 {
     if (addr == NULL)
@@ -1537,3 +4590,81 @@ bool tcs_address_is_supported(const struct TcsAddress* addr)
         return addr->family.native != -1;
     return false;
 }
+
+static inline bool address_map_is_equal(const struct TcsAddress* l, const struct TcsAddress* r)
+{
+    return tcs_address_is_equal(l, r);
+}
+
+TDS_HMAP_IMPL(struct TcsAddress, void*, address, tcs_address_hash, address_map_is_equal)
+
+struct TcsAddressMap
+{
+    struct TdsHMap_address map;
+};
+
+TcsResult tcs_address_map_create(struct TcsAddressMap** out_map, size_t capacity_hint)
+{
+    if (out_map == NULL)
+        return TCS_ERROR_INVALID_ARGUMENT;
+
+    *out_map = NULL;
+    struct TcsAddressMap* map = (struct TcsAddressMap*)tcs_lib_malloc(sizeof(struct TcsAddressMap));
+    if (map == NULL)
+        return TCS_ERROR_MEMORY;
+    // Per map seed so remote peers can not pick addresses that collide in every process
+    uint64_t seed = (uint64_t)tcs_time_monotonic_ms() ^ (uint64_t)(uintptr_t)map;
+    tds_hmap_address_create(&map->map, tcs_address_hash(NULL, seed) * 0x9E3779B97F4A7C15ULL);
+    if (tds_hmap_address_reserve(&map->map, capacity_hint) != 0)
+    {
+        tcs_lib_free(map);
+        return TCS_ERROR_MEMORY;
+    }
+    *out_map = map;
+    return TCS_SUCCESS;
+}
+
+TcsResult tcs_address_map_destroy(struct TcsAddressMap** map)
+{
+    if (map == NULL || *map == NULL)
+        return TCS_ERROR_INVALID_ARGUMENT;
+
+    tds_hmap_address_destroy(&(*map)->map);
+    tcs_lib_free(*map);
+    *map = NULL;
+    return TCS_SUCCESS;
+}
+
+TcsResult tcs_address_map_set(struct TcsAddressMap* map, const struct TcsAddress* address, void* value)
+{
+    if (map == NULL || address == NULL)
+        return TCS_ERROR_INVALID_ARGUMENT;
+
+    if (tds_hmap_address_set(&map->map, address, &value) != 0)
+        return TCS_ERROR_MEMORY;
+    return TCS_SUCCESS;
+}
+
+void* tcs_address_map_get(const struct TcsAddressMap* map, const struct TcsAddress* address)
+{
+    if (map == NULL || address == NULL)
+        return NULL;
+
+    void** value = tds_hmap_address_get(&map->map, address);
+    return value != NULL ? *value : NULL;
+}
+
+TcsResult tcs_address_map_remove(struct TcsAddressMap* map, const struct TcsAddress* address)
+{
+    if (map == NULL || address == NULL)
+        return TCS_ERROR_INVALID_ARGUMENT;
+
+    if (tds_hmap_address_remove(&map->map, address) != 0)
+        return TCS_ERROR_INVALID_ARGUMENT;
+    return TCS_SUCCESS;
+}
+
+size_t tcs_address_map_count(const struct TcsAddressMap* map)
+{
+    return map != NULL ? map->map.count : 0;
+}
@@ -35,34 +35,47 @@ extern const char* const TCS_LICENSE_TXT;
 * Library Management:
 * - TcsResult tcs_lib_init(void);
 * - TcsResult tcs_lib_cleanup(void);
+* - int64_t tcs_time_monotonic_ms(void);
+* - TcsResult tcs_lib_set_allocator(TcsAllocFn alloc_fn, TcsReallocFn realloc_fn, TcsFreeFn free_fn, void* context);
+* - void* tcs_lib_malloc(size_t size);
+* - void* tcs_lib_realloc(void* ptr, size_t size);
+* - void tcs_lib_free(void* ptr);
 *
 * Socket Creation:
 * - TcsResult tcs_socket(TcsSocket* out_socket, TcsFamily family, TcsSocketType type, TcsProtocol protocol);
+* - TcsResult tcs_socket_with_flags(TcsSocket* out_socket, TcsFamily family, TcsSocketType type, TcsProtocol protocol, uint32_t flags);
 * - TcsResult tcs_socket_tcp(TcsSocket* out_socket, const struct TcsAddress* local_address, const struct TcsAddress* remote_address, int timeout_ms);
 * - TcsResult tcs_socket_tcp_str(TcsSocket* out_socket, const char* local_address, const char* remote_address, int timeout_ms);
+* - TcsResult tcs_socket_tcp_any(TcsSocket* out_socket, const struct TcsAddress* local_address, const struct TcsAddress remote_addresses[], size_t remote_addresses_length, int timeout_ms);
 * - TcsResult tcs_socket_udp(TcsSocket* out_socket, const struct TcsAddress* local_address, const struct TcsAddress* remote_address);
 * - TcsResult tcs_socket_udp_str(TcsSocket* out_socket, const char* local_address, const char* remote_address);
 * - TcsResult tcs_socket_packet(TcsSocket* out_socket, const struct TcsAddress* bind_address, TcsSocketType type);
 * - TcsResult tcs_socket_packet_str(TcsSocket* out_socket, const char* interface_name, uint16_t protocol, TcsSocketType type);
+* - TcsResult tcs_socket_per_cpu(TcsSocket out_sockets[], size_t sockets_length, TcsSocketType type, const struct TcsAddress* local_address, size_t* out_sockets_count);
 * - TcsResult tcs_close(TcsSocket* socket);
 *
 * Socket Operations:
 * - TcsResult tcs_bind(TcsSocket socket, const struct TcsAddress* local_address);
 * - TcsResult tcs_connect(TcsSocket socket, const struct TcsAddress* address);
 * - TcsResult tcs_connect_str(TcsSocket socket, const char* remote_address, uint16_t port);
+* - TcsResult tcs_connect_timeout(TcsSocket socket, const struct TcsAddress* address, int timeout_ms);
 * - TcsResult tcs_listen(TcsSocket socket, int backlog);
 * - TcsResult tcs_accept(TcsSocket listener, TcsSocket* out_socket, struct TcsAddress* out_address);
+* - TcsResult tcs_accept_many(TcsSocket listener, TcsSocket out_sockets[], struct TcsAddress out_addresses[], size_t sockets_length, size_t* out_accepted_count);
 * - TcsResult tcs_shutdown(TcsSocket socket, TcsShutdownDirection direction);
 *
 * Data Transfer:
 * - TcsResult tcs_send(TcsSocket socket, const uint8_t* buffer, size_t buffer_size, uint32_t flags, size_t* out_sent_size);
 * - TcsResult tcs_send_to(TcsSocket socket, const uint8_t* buffer, size_t buffer_size, uint32_t flags, const struct TcsAddress* destination_address, size_t* out_sent_size);
+* - TcsResult tcs_send_to_from(TcsSocket socket, const uint8_t* buffer, size_t buffer_size, uint32_t flags, const struct TcsAddress* destination_address, const struct TcsAddress* source_address, TcsInterfaceId interface_id, size_t* out_sent_size);
 * - TcsResult tcs_sendv(TcsSocket socket, const struct TcsIoVec* iov, size_t iov_length, uint32_t flags, size_t* out_sent_size);
 * - TcsResult tcs_send_netstring(TcsSocket socket, const uint8_t* buffer, size_t buffer_size);
 * - TcsResult tcs_receive(TcsSocket socket, uint8_t* buffer, size_t buffer_size, uint32_t flags, size_t* out_received_size);
 * - TcsResult tcs_receive_from(TcsSocket socket, uint8_t* buffer, size_t buffer_size, uint32_t flags, struct TcsAddress* out_source_address, size_t* out_received_size);
+* - TcsResult tcs_receive_from_to(TcsSocket socket, uint8_t* buffer, size_t buffer_size, uint32_t flags, struct TcsAddress* out_source_address, struct TcsAddress* out_destination_address, TcsInterfaceId* out_interface_id, size_t* out_received_size);
 * - TcsResult tcs_receive_line(TcsSocket socket, uint8_t* buffer, size_t buffer_size, uint8_t delimiter, size_t* out_received_size);
 * - TcsResult tcs_receive_netstring(TcsSocket socket, uint8_t* buffer, size_t buffer_size, size_t* out_received_size);
+* - TcsResult tcs_receive_tx_timestamps(TcsSocket socket, struct TcsTxTimestamp out_timestamps[], size_t timestamps_length, size_t* out_length);
 *
 * Socket Polling:
 * - TcsResult tcs_poll_create(struct TcsPoll** out_poll);
@@ -72,6 +85,51 @@ extern const char* const TCS_LICENSE_TXT;
 * - TcsResult tcs_poll_remove(struct TcsPoll* poll, TcsSocket socket);
 * - TcsResult tcs_poll_wait(struct TcsPoll* poll, struct TcsPollEvent* out_events, size_t events_length, size_t* out_events_length, int timeout_ms);
 *
+* Bulk Connect:
+* - TcsResult tcs_connector_create(struct TcsConnector** out_connector, const struct TcsAddress remote_addresses[], size_t remote_addresses_length);
+* - TcsResult tcs_connector_destroy(struct TcsConnector** connector);
+* - TcsResult tcs_connector_run(struct TcsConnector* connector, size_t max_in_flight, int connect_timeout_ms, int total_timeout_ms);
+* - TcsResult tcs_connector_take(struct TcsConnector* connector, size_t index, TcsSocket* out_socket);
+*
+* Connection Pool:
+* - TcsResult tcs_pool_create(struct TcsPool** out_pool, size_t max_idle_per_key, size_t max_total_per_key, int idle_timeout_ms, int connect_timeout_ms);
+* - TcsResult tcs_pool_destroy(struct TcsPool** pool);
+* - TcsResult tcs_pool_acquire(struct TcsPool* pool, const struct TcsAddress* remote_address, TcsSocket* out_socket);
+* - TcsResult tcs_pool_release(struct TcsPool* pool, const struct TcsAddress* remote_address, TcsSocket* socket, bool is_reusable);
+*
+* Asynchronous Resolve:
+* - TcsResult tcs_resolver_create(struct TcsResolver** out_resolver, size_t thread_count);
+* - TcsResult tcs_resolver_destroy(struct TcsResolver** resolver);
+* - TcsResult tcs_resolver_socket(struct TcsResolver* resolver, TcsSocket* out_socket);
+* - TcsResult tcs_resolver_submit(struct TcsResolver* resolver, const char* hostname, TcsFamily address_family, size_t* out_handle);
+* - TcsResult tcs_resolver_take(struct TcsResolver* resolver, size_t* out_handle, TcsResult* out_result, struct TcsAddress out_addresses[], size_t addresses_length, size_t* out_length);
+* - TcsResult tcs_resolver_cancel(struct TcsResolver* resolver, size_t handle);
+*
+* DNS Stub Resolver:
+* - TcsResult tcs_dns_create(struct TcsDns** out_dns, struct TcsPoll* poll, const struct TcsAddress nameservers[], size_t nameservers_length, int attempt_timeout_ms, int attempts);
+* - TcsResult tcs_dns_destroy(struct TcsDns** dns);
+* - TcsResult tcs_dns_submit(struct TcsDns* dns, const char* hostname, TcsFamily address_family, size_t* out_handle);
+* - TcsResult tcs_dns_process(struct TcsDns* dns, const struct TcsPollEvent* event, int* out_timeout_ms);
+* - TcsResult tcs_dns_take(struct TcsDns* dns, size_t* out_handle, TcsResult* out_result, struct TcsAddress out_addresses[], size_t addresses_length, size_t* out_length);
+* - TcsResult tcs_dns_cancel(struct TcsDns* dns, size_t handle);
+*
+* Packet Rings (Linux only):
+* - TcsResult tcs_packet_ring_rx_create(struct TcsPacketRing** out_ring, TcsSocket socket, size_t block_size, size_t block_count, size_t frame_size, int block_timeout_ms);
+* - TcsResult tcs_packet_ring_destroy(struct TcsPacketRing** ring);
+* - TcsResult tcs_packet_ring_rx_next(struct TcsPacketRing* ring, struct TcsPacketFrame* out_frame);
+* - TcsResult tcs_packet_ring_rx_release(struct TcsPacketRing* ring);
+* - TcsResult tcs_packet_ring_tx_create(struct TcsPacketRing** out_ring, TcsSocket socket, size_t block_size, size_t block_count, size_t frame_size);
+* - TcsResult tcs_packet_ring_tx_acquire(struct TcsPacketRing* ring, uint8_t** out_data, size_t* out_capacity);
+* - TcsResult tcs_packet_ring_tx_commit(struct TcsPacketRing* ring, size_t frame_size);
+* - TcsResult tcs_packet_ring_tx_flush(struct TcsPacketRing* ring, const struct TcsAddress* destination_address);
+*
+* Socket Filters:
+* - TcsResult tcs_filter_init(struct TcsFilter* filter);
+* - TcsResult tcs_filter_ether_type(struct TcsFilter* filter, uint16_t ether_type);
+* - TcsResult tcs_filter_vlan_id(struct TcsFilter* filter, uint16_t vlan_id);
+* - TcsResult tcs_filter_udp_destination_port(struct TcsFilter* filter, uint16_t port);
+* - TcsResult tcs_filter_multicast_group(struct TcsFilter* filter, const struct TcsAddress* multicast_address);
+*
 * Socket Options:
 * - TcsResult tcs_opt_set(TcsSocket socket, int32_t level, int32_t option_name, const void* option_value, size_t option_size);
 * - TcsResult tcs_opt_get(TcsSocket socket, int32_t level, int32_t option_name, void* out_option_value, size_t* option_size);
@@ -84,6 +142,7 @@ extern const char* const TCS_LICENSE_TXT;
 * - TcsResult tcs_opt_reuse_address_get(TcsSocket socket, bool* out_is_reuse_address_allowed);
 * - TcsResult tcs_opt_reuse_port_set(TcsSocket socket, bool do_allow_reuse_port);
 * - TcsResult tcs_opt_reuse_port_get(TcsSocket socket, bool* out_is_reuse_port_allowed);
+* - TcsResult tcs_opt_reuse_port_steer_by_cpu(TcsSocket socket, size_t group_size);
 * - TcsResult tcs_opt_send_buffer_size_set(TcsSocket socket, size_t send_buffer_size);
 * - TcsResult tcs_opt_send_buffer_size_get(TcsSocket socket, size_t* out_send_buffer_size);
 * - TcsResult tcs_opt_receive_buffer_size_set(TcsSocket socket, size_t receive_buffer_size);
@@ -94,12 +153,25 @@ extern const char* const TCS_LICENSE_TXT;
 * - TcsResult tcs_opt_linger_get(TcsSocket socket, bool* out_do_linger, int* out_timeout_seconds);
 * - TcsResult tcs_opt_ip_no_delay_set(TcsSocket socket, bool use_no_delay);
 * - TcsResult tcs_opt_ip_no_delay_get(TcsSocket socket, bool* out_is_no_delay_used);
+* - TcsResult tcs_opt_tcp_fast_open_set(TcsSocket socket, int queue_length);
+* - TcsResult tcs_opt_tcp_fast_open_get(TcsSocket socket, int* out_queue_length);
+* - TcsResult tcs_opt_tcp_fast_open_connect_set(TcsSocket socket, bool do_fast_open);
+* - TcsResult tcs_opt_tcp_fast_open_connect_get(TcsSocket socket, bool* out_is_fast_open);
 * - TcsResult tcs_opt_out_of_band_inline_set(TcsSocket socket, bool enable_oob);
 * - TcsResult tcs_opt_out_of_band_inline_get(TcsSocket socket, bool* out_is_oob_enabled);
 * - TcsResult tcs_opt_priority_set(TcsSocket socket, int priority);
 * - TcsResult tcs_opt_priority_get(TcsSocket socket, int* out_priority);
 * - TcsResult tcs_opt_nonblocking_set(TcsSocket socket, bool do_nonblocking);
 * - TcsResult tcs_opt_nonblocking_get(TcsSocket socket, bool* out_is_nonblocking);
+* - TcsResult tcs_opt_tx_timestamping_set(TcsSocket socket, bool do_timestamp);
+* - TcsResult tcs_opt_tx_timestamping_get(TcsSocket socket, bool* out_is_timestamping);
+* - TcsResult tcs_opt_packet_info_set(TcsSocket socket, bool do_receive_packet_info);
+* - TcsResult tcs_opt_packet_info_get(TcsSocket socket, bool* out_is_packet_info_received);
+* - TcsResult tcs_opt_packet_qdisc_bypass_set(TcsSocket socket, bool do_bypass);
+* - TcsResult tcs_opt_packet_qdisc_bypass_get(TcsSocket socket, bool* out_is_bypassed);
+* - TcsResult tcs_opt_packet_fanout_join(TcsSocket socket, uint16_t group_id, TcsPacketFanoutMode mode);
+* - TcsResult tcs_opt_filter_attach(TcsSocket socket, const struct TcsFilter* filter);
+* - TcsResult tcs_opt_filter_detach(TcsSocket socket);
 * - TcsResult tcs_opt_membership_add(TcsSocket socket, const struct TcsAddress* multicast_address);
 * - TcsResult tcs_opt_membership_add_str(TcsSocket socket, const char* multicast_address);
 * - TcsResult tcs_opt_membership_add_to(TcsSocket socket, const struct TcsAddress* local_address, const struct TcsAddress* multicast_address);
@@ -113,19 +185,31 @@ extern const char* const TCS_LICENSE_TXT;
 * Address and Interface Utilities:
 * - TcsResult tcs_interface_list(struct TcsInterface out_interfaces[], size_t interfaces_length, size_t* out_length);
 * - TcsResult tcs_address_resolve(const char* hostname, TcsFamily address_family, struct TcsAddress out_addresses[], size_t addresses_length, size_t* out_length);
+* - TcsResult tcs_address_cache_enable(size_t max_entries, int positive_ttl_ms, int negative_ttl_ms);
+* - TcsResult tcs_address_cache_disable(void);
+* - TcsResult tcs_address_cache_prefill(const char* hostname, TcsFamily address_family, const struct TcsAddress addresses[], size_t addresses_length, int ttl_ms);
+* - TcsResult tcs_address_cache_flush(const char* hostname);
 * - TcsResult tcs_address_list(TcsInterfaceId interface_id_filter, TcsFamily address_family_filter, struct TcsInterfaceAddress out_interface_addresses[], size_t interface_addresses_length, size_t* out_length);
 * - TcsResult tcs_address_socket_local(TcsSocket socket, struct TcsAddress* out_local_address);
 * - TcsResult tcs_address_socket_remote(TcsSocket socket, struct TcsAddress* out_remote_address);
 * - TcsResult tcs_address_socket_family(TcsSocket socket, TcsFamily* out_family);
 * - TcsResult tcs_address_parse(const char str[], struct TcsAddress* out_address);
 * - TcsResult tcs_address_to_str(const struct TcsAddress* address, char out_str[], size_t str_length, size_t* out_length);
+* - TcsResult tcs_address_to_str_many(const struct TcsAddress addresses[], size_t addresses_length, const char* separator, char out_str[], size_t str_length, size_t* out_length);
 * - bool tcs_address_is_equal(const struct TcsAddress* l, const struct TcsAddress* r);
+* - uint64_t tcs_address_hash(const struct TcsAddress* address, uint64_t seed);
 * - bool tcs_address_is_any(const struct TcsAddress* addr);
 * - bool tcs_address_is_link_local(const struct TcsAddress* addr);
 * - bool tcs_address_is_loopback(const struct TcsAddress* addr);
 * - bool tcs_address_is_multicast(const struct TcsAddress* addr);
 * - bool tcs_address_is_broadcast(const struct TcsAddress* addr);
 * - bool tcs_address_is_supported(const struct TcsAddress* addr);
+* - TcsResult tcs_address_map_create(struct TcsAddressMap** out_map, size_t capacity_hint);
+* - TcsResult tcs_address_map_destroy(struct TcsAddressMap** map);
+* - TcsResult tcs_address_map_set(struct TcsAddressMap* map, const struct TcsAddress* address, void* value);
+* - void* tcs_address_map_get(const struct TcsAddressMap* map, const struct TcsAddress* address);
+* - TcsResult tcs_address_map_remove(struct TcsAddressMap* map, const struct TcsAddress* address);
+* - size_t tcs_address_map_count(const struct TcsAddressMap* map);
 */
 
 // Recognize which system we are compiling against
@@ -189,6 +273,54 @@ typedef unsigned int TcsInterfaceId;
 #define TCS_CFG_INTERFACE_NAME_SIZE 64
 #endif
 
+#ifndef TCS_CFG_FILTER_MAX_INSTRUCTIONS
+#define TCS_CFG_FILTER_MAX_INSTRUCTIONS 64
+#endif
+
+#ifndef TCS_CFG_CONNECT_CANDIDATES_MAX
+#define TCS_CFG_CONNECT_CANDIDATES_MAX 8
+#endif
+
+#ifndef TCS_CFG_POOL_SHARDS
+#define TCS_CFG_POOL_SHARDS 16 // Number of independently locked parts of a TcsPool
+#endif
+
+#ifndef TCS_CFG_ADDRESS_CACHE_HOSTNAME_SIZE
+#define TCS_CFG_ADDRESS_CACHE_HOSTNAME_SIZE 256 // Longer hostnames are resolved but never cached
+#endif
+
+#ifndef TCS_CFG_ADDRESS_CACHE_ADDRESSES_MAX
+#define TCS_CFG_ADDRESS_CACHE_ADDRESSES_MAX 8 // Addresses kept per cached hostname
+#endif
+
+#ifndef TCS_CFG_RESOLVER_ADDRESSES_MAX
+#define TCS_CFG_RESOLVER_ADDRESSES_MAX 8 // Addresses kept per asynchronous lookup
+#endif
+
+#ifndef TCS_CFG_DNS_NAMESERVERS_MAX
+#define TCS_CFG_DNS_NAMESERVERS_MAX 3 // Same limit as resolv.conf
+#endif
+
+#ifndef TCS_CFG_DNS_ADDRESSES_MAX
+#define TCS_CFG_DNS_ADDRESSES_MAX 8 // Addresses kept per family of a DNS lookup
+#endif
+
+#ifndef TCS_CFG_DNS_RESOLV_CONF_PATH
+#define TCS_CFG_DNS_RESOLV_CONF_PATH "/etc/resolv.conf"
+#endif
+
+#ifndef TCS_CFG_DNS_HOSTS_PATH
+#define TCS_CFG_DNS_HOSTS_PATH "/etc/hosts"
+#endif
+
+#ifndef TCS_CFG_THREADS
+#define TCS_CFG_THREADS 0 // Set to 1 for tcs_resolver_create() on POSIX, then link with -pthread
+#endif
+
+#ifndef TCS_CFG_CONNECT_ATTEMPT_DELAY_MS
+#define TCS_CFG_CONNECT_ATTEMPT_DELAY_MS 250 // RFC 8305 recommended Connection Attempt Delay
+#endif
+
 // Declarations
 
 /** @internal */
@@ -238,6 +370,19 @@ typedef enum
     TCS_SHUTDOWN_BOTH,    /**< To shutdown both incoming and outgoing packets for socket */
 } TcsShutdownDirection;
 
+/**
+ * @brief How frames are distributed between the members of a packet fanout group.
+ *
+ * @see tcs_opt_packet_fanout_join()
+ */
+typedef enum
+{
+    TCS_PACKET_FANOUT_HASH,     /**< By flow hash, all frames of a flow go to the same member */
+    TCS_PACKET_FANOUT_LB,       /**< Round robin between the members */
+    TCS_PACKET_FANOUT_CPU,      /**< By the CPU that received the frame */
+    TCS_PACKET_FANOUT_ROLLOVER, /**< Fill one member, move to the next when its receive buffer is full */
+} TcsPacketFanoutMode;
+
 // Return codes
 typedef enum
 {
@@ -358,7 +503,62 @@ struct TcsIoVec
     size_t buffer_size;
 };
 
+/**
+ * @brief Transmit timestamp read from the socket error queue.
+ *
+ * @see tcs_receive_tx_timestamps()
+ */
+struct TcsTxTimestamp
+{
+    uint32_t id;          /**< Datagram counter for datagram sockets, byte counter for stream sockets. Starts at 0. */
+    int64_t timestamp_ns; /**< CLOCK_REALTIME when the packet left the network stack, in nanoseconds */
+};
+
+/**
+ * @brief A frame inside a memory mapped packet ring.
+ *
+ * @see tcs_packet_ring_rx_next()
+ */
+struct TcsPacketFrame
+{
+    uint8_t* data;        /**< Points into the ring. Valid until the block is released. */
+    size_t size;          /**< Number of bytes available at data */
+    size_t original_size; /**< Size of the frame on the wire, larger than size if the frame was truncated */
+    int64_t timestamp_ns; /**< CLOCK_REALTIME when the frame was received, in nanoseconds */
+};
+
+struct TcsPacketRing;
+
+/**
+ * @brief One classic BPF instruction. Same layout as struct sock_filter on Linux.
+ */
+struct TcsFilterInstruction
+{
+    uint16_t code; /**< Operation, BPF_* values from linux/filter.h */
+    uint8_t jt;    /**< Number of instructions to skip if the jump condition is true */
+    uint8_t jf;    /**< Number of instructions to skip if the jump condition is false */
+    uint32_t k;    /**< Operand */
+};
+
+/**
+ * @brief A classic BPF program that decides in the kernel which frames a socket receives.
+ *
+ * Build it with tcs_filter_init() and the tcs_filter_*() predicates, a frame is accepted if all predicates match.
+ * The instructions may also be written by hand.
+ *
+ * @see tcs_opt_filter_attach()
+ */
+struct TcsFilter
+{
+    struct TcsFilterInstruction instructions[TCS_CFG_FILTER_MAX_INSTRUCTIONS];
+    size_t length;
+};
 struct TcsPoll;
+struct TcsConnector;
+struct TcsPool;
+struct TcsResolver;
+struct TcsDns;
+struct TcsAddressMap;
 struct TcsPollEvent
 {
     TcsSocket socket;
@@ -366,6 +566,7 @@ struct TcsPollEvent
     bool can_read;
     bool can_write;
     TcsResult error;
+    bool can_read_error_queue; /**< Transmit timestamps are waiting, see tcs_receive_tx_timestamps() */
 };
 
 extern const TcsFamily TCS_FAMILY_ANY;    /**< Layer 4 agnostic (AF_UNSPEC) */
@@ -398,6 +599,10 @@ extern const TcsSocketType TCS_SOCKET_STREAM; /**< Use for streaming types like
 extern const TcsSocketType TCS_SOCKET_DGRAM;  /**< Use for datagrams types like UDP */
 extern const TcsSocketType TCS_SOCKET_RAW;    /**< Use for raw sockets, eg. layer 2 packet sockets */
 
+// Socket creation flags, see tcs_socket_with_flags()
+static const uint32_t TCS_SOCKET_FLAG_NONBLOCKING = 0x1; /**< Same as calling tcs_opt_nonblocking_set() afterwards */
+static const uint32_t TCS_SOCKET_FLAG_CLOEXEC = 0x2;     /**< Not inherited by child processes */
+
 static const TcsProtocol TCS_PROTOCOL_IP_TCP = 6;  /**< TCP, IANA-assigned (RFC 9293). Use with TCS_SOCKET_STREAM. */
 static const TcsProtocol TCS_PROTOCOL_IP_UDP = 17; /**< UDP, IANA-assigned (RFC 768). Use with TCS_SOCKET_DGRAM. */
 static const TcsProtocol TCS_PROTOCOL_ETH_ALL = 3; /**< Receive all protocols. Use with TCS_FAMILY_PACKET. */
@@ -410,6 +615,9 @@ extern const uint32_t TCS_MSG_WAITALL;
 // Send flags
 extern const uint32_t TCS_MSG_SENDALL;
 
+// Send and recv flags
+extern const uint32_t TCS_MSG_DONTWAIT; /**< Do not block in this call only, the socket keeps its blocking mode */
+
 // Backlog
 extern const int TCS_BACKLOG_MAX; /**< Max number of queued sockets when listening */
 
@@ -447,7 +655,7 @@ extern const int32_t TCS_PACKET_MEMBERSHIP_DROP;
 // Use for timeout to wait until infinity happens
 extern const int32_t TCS_WAIT_INF;
 
-static const struct TcsPollEvent TCS_POLL_EVENT_EMPTY = {0, 0, false, false, TCS_SUCCESS};
+static const struct TcsPollEvent TCS_POLL_EVENT_EMPTY = {0, 0, false, false, TCS_SUCCESS, false};
 
 // ######## Library Management ########
 
@@ -494,6 +702,68 @@ TcsResult tcs_lib_init(void);
  */
 TcsResult tcs_lib_cleanup(void);
 
+/**
+ * @brief Get a monotonic clock in milliseconds, suitable for timeouts and deadlines.
+ *
+ * The starting point is unspecified, only differences between two calls are meaningful.
+ *
+ * @return Milliseconds since an unspecified point in time.
+ */
+int64_t tcs_time_monotonic_ms(void);
+
+/** @brief Allocates size bytes, returns NULL on failure. See tcs_lib_set_allocator(). */
+typedef void* (*TcsAllocFn)(size_t size, void* context);
+/** @brief Works like realloc(), ptr may be NULL and size is never 0. See tcs_lib_set_allocator(). */
+typedef void* (*TcsReallocFn)(void* ptr, size_t size, void* context);
+/** @brief Frees memory from the other two functions, never called with NULL. See tcs_lib_set_allocator(). */
+typedef void (*TcsFreeFn)(void* ptr, void* context);
+
+/**
+ * @brief Route all memory the library allocates to your own allocator.
+ *
+ * Every allocation in the library goes through these functions, also the ones in its internal data structures.
+ * Use it to put the library memory in an arena or a NUMA local pool, or to count it in production.
+ * Pass NULL for all three functions to go back to malloc(), realloc() and free().
+ *
+ * The allocator is global and not protected against concurrent calls. Set it before using any other function in the
+ * library and do not change it while library objects exist, their memory is freed with the allocator that is set then.
+ *
+ * @code
+ * #include "tinycsocket.h"
+ *
+ * static size_t allocations = 0;
+ *
+ * static void* counting_alloc(size_t size, void* context) { (void)context; allocations++; return malloc(size); }
+ * static void* counting_realloc(void* ptr, size_t size, void* context) { (void)context; return realloc(ptr, size); }
+ * static void counting_free(void* ptr, void* context) { (void)context; free(ptr); }
+ *
+ * int main()
+ * {
+ *   tcs_lib_set_allocator(counting_alloc, counting_realloc, counting_free, NULL);
+ *   TcsResult tcs_init_res = tcs_lib_init();
+ *   // Do stuff with the library here
+ *   tcs_lib_cleanup();
+ * }
+ * @endcode
+ *
+ * @param alloc_fn is called instead of malloc().
+ * @param realloc_fn is called instead of realloc().
+ * @param free_fn is called instead of free().
+ * @param context is passed to all three functions.
+ * @return #TCS_SUCCESS if successful, otherwise the error code.
+ * @retval #TCS_ERROR_INVALID_ARGUMENT if some but not all of the functions are NULL.
+ */
+TcsResult tcs_lib_set_allocator(TcsAllocFn alloc_fn, TcsReallocFn realloc_fn, TcsFreeFn free_fn, void* context);
+
+/** @brief Allocate with the allocator from tcs_lib_set_allocator(), as the library does internally. */
+void* tcs_lib_malloc(size_t size);
+
+/** @brief Reallocate memory from tcs_lib_malloc() with the allocator from tcs_lib_set_allocator(). */
+void* tcs_lib_realloc(void* ptr, size_t size);
+
+/** @brief Free memory from tcs_lib_malloc() or tcs_lib_realloc(), NULL is ignored. */
+void tcs_lib_free(void* ptr);
+
 // ######## Socket Creation ########
 
 /**
@@ -552,6 +822,27 @@ TcsResult tcs_lib_cleanup(void);
  */
 TcsResult tcs_socket(TcsSocket* out_socket, TcsFamily family, TcsSocketType type, TcsProtocol protocol);
 
+/**
+ * @brief Create a new socket with creation flags applied atomically.
+ *
+ * Same as ::tcs_socket(), but the flags are applied by the socket call itself where the platform supports it
+ * (SOCK_NONBLOCK and SOCK_CLOEXEC on Linux and the BSDs), saving the extra calls to set them afterwards.
+ *
+ * @param[out] out_socket pointer to socket context to be created, which must have been initialized to #TCS_SOCKET_INVALID before use.
+ * @param[in] family See ::TcsFamily for supported values.
+ * @param[in] type specifies the type of the socket, supported values are: ::TCS_SOCKET_STREAM, ::TCS_SOCKET_DGRAM and ::TCS_SOCKET_RAW.
+ * @param[in] protocol specifies the protocol, for example #TCS_PROTOCOL_IP_TCP or #TCS_PROTOCOL_IP_UDP.
+ * @param[in] flags bitmask of #TCS_SOCKET_FLAG_NONBLOCKING and #TCS_SOCKET_FLAG_CLOEXEC, or #TCS_FLAG_NONE.
+ *
+ * @return #TCS_SUCCESS if successful, otherwise the error code.
+ * @see tcs_socket()
+ */
+TcsResult tcs_socket_with_flags(TcsSocket* out_socket,
+                                TcsFamily family,
+                                TcsSocketType type,
+                                TcsProtocol protocol,
+                                uint32_t flags);
+
 /**
 * @brief Create a TCP socket, optionally bind to a local address and/or connect to a remote address.
 *
@@ -560,6 +851,7 @@ TcsResult tcs_socket(TcsSocket* out_socket, TcsFamily family, TcsSocketType type
 * If @p remote_address is not NULL, the socket connects to it.
 * At least one of @p local_address or @p remote_address must be non-NULL.
 * If both are provided, they must have the same address family.
+* The socket is created with #TCS_SOCKET_FLAG_CLOEXEC and is returned in blocking mode.
 * On failure, *out_socket is always set back to #TCS_SOCKET_INVALID.
 *
 * @code
@@ -610,8 +902,9 @@ TcsResult tcs_socket_tcp(TcsSocket* out_socket,
 /**
 * @brief Create a TCP socket from string addresses, optionally bind and/or connect.
 *
-* Resolves the address strings with ::tcs_address_resolve() and delegates to ::tcs_socket_tcp().
-* Addresses must include a port, e.g. "127.0.0.1:8080" or "[::1]:8080".
+* Resolves the address strings with ::tcs_address_resolve(). All resolved remote addresses are raced with
+* ::tcs_socket_tcp_any() (Happy Eyeballs), so an unreachable address family does not stall the connect.
+* Addresses must include a port, e.g. "127.0.0.1:8080", "[::1]:8080" or "example.com:80".
 * At least one of @p local_address or @p remote_address must be non-NULL.
 * On failure, *out_socket is always set back to #TCS_SOCKET_INVALID.
 *
@@ -654,6 +947,40 @@ TcsResult tcs_socket_tcp_str(TcsSocket* out_socket,
                              const char* remote_address,
                              int timeout_ms);
 
+/**
+* @brief Create a TCP socket connected to the first reachable of several remote addresses (Happy Eyeballs, RFC 8305).
+*
+* The addresses are interleaved by family, keeping their order within each family, starting with the family of the
+* first address. A non-blocking connect is started to one address at a time. The next one is started when the
+* previous attempt fails or after #TCS_CFG_CONNECT_ATTEMPT_DELAY_MS without an answer, without cancelling the earlier
+* attempts. The first attempt to succeed is kept and the others are closed.
+*
+* @code
+* struct TcsAddress candidates[TCS_CFG_CONNECT_CANDIDATES_MAX];
+* size_t count = 0;
+* tcs_address_resolve("example.com", TCS_FAMILY_ANY, candidates, TCS_CFG_CONNECT_CANDIDATES_MAX, &count);
+* // Set the port of each candidate
+* TcsSocket socket = TCS_SOCKET_INVALID;
+* tcs_socket_tcp_any(&socket, NULL, candidates, count, 5000);
+* @endcode
+*
+* @param[out] out_socket pointer to socket context to be created, which must have been initialized to #TCS_SOCKET_INVALID before use.
+* @param[in] local_address address to bind to, or NULL to skip binding. Remote addresses of another family are skipped.
+* @param[in] remote_addresses addresses to try. At most #TCS_CFG_CONNECT_CANDIDATES_MAX are used.
+* @param[in] remote_addresses_length number of elements in @p remote_addresses.
+* @param[in] timeout_ms maximum time in milliseconds for all attempts together, or #TCS_WAIT_INF to wait until every attempt has failed.
+*
+* @return #TCS_SUCCESS if successful, otherwise the error of the last failed attempt.
+* @retval #TCS_ERROR_TIMED_OUT if no attempt succeeded within @p timeout_ms.
+*
+* @see tcs_socket_tcp_str()
+*/
+TcsResult tcs_socket_tcp_any(TcsSocket* out_socket,
+                             const struct TcsAddress* local_address,
+                             const struct TcsAddress remote_addresses[],
+                             size_t remote_addresses_length,
+                             int timeout_ms);
+
 /**
 * @brief Create a UDP socket, optionally bind to a local address and/or connect to a remote address.
 *
@@ -838,6 +1165,42 @@ TcsResult tcs_socket_packet_str(TcsSocket* out_socket,
                                 uint16_t protocol,
                                 TcsSocketType type);
 
+/**
+* @brief Create one socket per CPU sharing the same local address, with incoming traffic steered to the socket of the
+* CPU that received it.
+*
+* The sockets join a SO_REUSEPORT group in order and tcs_opt_reuse_port_steer_by_cpu() is attached, so socket i gets
+* the traffic handled by CPU i. Run the worker of socket i on CPU i to keep the receive path cache local.
+* Stream sockets are listening when returned. If @p local_address has port 0, all sockets share the port picked for
+* the first one.
+*
+* @code
+* TcsSocket sockets[64];
+* for (int i = 0; i < 64; ++i)
+*     sockets[i] = TCS_SOCKET_INVALID;
+* struct TcsAddress local = TCS_ADDRESS_NONE;
+* tcs_address_parse("0.0.0.0:5000", &local);
+* size_t count = 0;
+* tcs_socket_per_cpu(sockets, 64, TCS_SOCKET_DGRAM, &local, &count);
+* // Start count workers, worker i pinned to CPU i receives from sockets[i]
+* @endcode
+*
+* @note Only supported on Linux. Will return #TCS_ERROR_NOT_SUPPORTED on other platforms.
+*
+* @param[out] out_sockets array of sockets to create, all must be initialized to #TCS_SOCKET_INVALID.
+* @param[in] sockets_length number of elements in @p out_sockets. Fewer sockets than CPUs share CPUs round robin.
+* @param[in] type either #TCS_SOCKET_DGRAM for UDP or #TCS_SOCKET_STREAM for TCP listeners.
+* @param[in] local_address is the address all sockets are bound to.
+* @param[out] out_sockets_count number of created sockets, the smaller of the CPU count and @p sockets_length.
+* @return #TCS_SUCCESS if successful, otherwise the error code. No sockets are left open on failure.
+* @see tcs_opt_reuse_port_steer_by_cpu()
+*/
+TcsResult tcs_socket_per_cpu(TcsSocket out_sockets[],
+                             size_t sockets_length,
+                             TcsSocketType type,
+                             const struct TcsAddress* local_address,
+                             size_t* out_sockets_count);
+
 /**
 * @brief Closes the socket, stop communication and free all resources for the socket.
 *
@@ -1048,6 +1411,29 @@ TcsResult tcs_connect(TcsSocket socket, const struct TcsAddress* address);
  */
 TcsResult tcs_connect_str(TcsSocket socket, const char* remote_address, uint16_t port);
 
+/**
+ * @brief Connect a socket to a remote address, giving up after a timeout.
+ *
+ * Waits for the connection on the socket itself, without any heap allocation or poll context. A blocking socket is
+ * made non-blocking for the duration of the call and restored afterwards. A non-blocking socket, for example from
+ * tcs_socket_with_flags() with #TCS_SOCKET_FLAG_NONBLOCKING, is used as is and skips both mode switches.
+ *
+ * @note On Windows the non-blocking state cannot be queried, the socket is always left in blocking mode.
+ *
+ * @param[in] socket a TCP socket that is not yet connected.
+ * @param[in] address remote address to connect to.
+ * @param[in] timeout_ms maximum time to wait in milliseconds, or #TCS_WAIT_INF to behave as tcs_connect().
+ *
+ * @return #TCS_SUCCESS if the connection was established, otherwise the error code.
+ * @retval #TCS_ERROR_TIMED_OUT if the connection was not established within @p timeout_ms. The connection attempt is
+ * still in progress, close the socket before reusing it.
+ * @retval #TCS_ERROR_CONNECTION_REFUSED if the remote side refused the connection.
+ *
+ * @see tcs_connect()
+ * @see tcs_socket_tcp()
+ */
+TcsResult tcs_connect_timeout(TcsSocket socket, const struct TcsAddress* address, int timeout_ms);
+
 /**
  * @brief Let a socket start listening for incoming connections.
  *
@@ -1092,6 +1478,38 @@ TcsResult tcs_listen(TcsSocket socket, int backlog);
  */
 TcsResult tcs_accept(TcsSocket listener, TcsSocket* out_socket, struct TcsAddress* out_address);
 
+/**
+ * @brief Accept all pending connections of a listening socket, up to a maximum, in one call.
+ *
+ * The accepted sockets are non-blocking and close-on-exec from the start, on Linux with a single accept4() per
+ * connection. Use a non-blocking listener, for example together with a TcsPoll, otherwise the call blocks until
+ * @p sockets_length connections have been accepted.
+ *
+ * @code
+ * TcsSocket clients[64];
+ * size_t count = 0;
+ * tcs_accept_many(listen_socket, clients, NULL, 64, &count);
+ * for (size_t i = 0; i < count; ++i)
+ *     add_client(clients[i]);
+ * @endcode
+ *
+ * @param[in] listener is a listening socket, see ::tcs_listen().
+ * @param[out] out_sockets array that receives the accepted sockets. Its content is overwritten.
+ * @param[out] out_addresses optional array of at least @p sockets_length elements for the remote addresses, NULL to
+ * skip the address conversion.
+ * @param[in] sockets_length maximum number of connections to accept.
+ * @param[out] out_accepted_count number of sockets written to @p out_sockets, also when an error is returned.
+ *
+ * @return #TCS_SUCCESS if at least one connection was accepted, otherwise the error code.
+ * @retval #TCS_ERROR_WOULD_BLOCK if no connection was pending.
+ * @see tcs_accept()
+ */
+TcsResult tcs_accept_many(TcsSocket listener,
+                          TcsSocket out_sockets[],
+                          struct TcsAddress out_addresses[],
+                          size_t sockets_length,
+                          size_t* out_accepted_count);
+
 /**
 * @brief Turn off communication with a 3-way handshaking for the socket.
 * 
@@ -1137,6 +1555,36 @@ TcsResult tcs_send_to(TcsSocket socket,
                       const struct TcsAddress* destination_address,
                       size_t* out_sent_size);
 
+/**
+ * @brief Sends a datagram to an address from a chosen local address and/or interface.
+ *
+ * Useful for UDP servers bound to the wildcard address on hosts with several addresses. Reply from the
+ * destination address returned by tcs_receive_from_to() and the reply will leave from the address the request
+ * was sent to.
+ *
+ * @note Not supported on Windows. Will return #TCS_ERROR_NOT_SUPPORTED on that platform.
+ *
+ * @param[in] socket is your in-out socket context.
+ * @param[in] buffer is a pointer to your data you want to send.
+ * @param[in] buffer_size is number of bytes of the data you want to send.
+ * @param[in] flags is a bitmask of send flags. Use #TCS_FLAG_NONE for no flags.
+ * @param[in] destination_address is the address to send to.
+ * @param[in] source_address is the local address to send from, or NULL to let the routing table decide. The port is ignored.
+ * @param[in] interface_id is the interface to send on, or 0 to let the routing table decide.
+ * @param[out] out_sent_size is how many bytes that was successfully sent.
+ * @return #TCS_SUCCESS if successful, otherwise the error code.
+ * @retval #TCS_ERROR_INVALID_ARGUMENT if source_address and destination_address have different families.
+ * @see tcs_receive_from_to()
+ */
+TcsResult tcs_send_to_from(TcsSocket socket,
+                           const uint8_t* buffer,
+                           size_t buffer_size,
+                           uint32_t flags,
+                           const struct TcsAddress* destination_address,
+                           const struct TcsAddress* source_address,
+                           TcsInterfaceId interface_id,
+                           size_t* out_sent_size);
+
 /**
 * @brief Sends several data buffers on a socket as one message.
 *
@@ -1180,7 +1628,7 @@ TcsResult tcs_send_netstring(TcsSocket socket, const uint8_t* buffer, size_t buf
 * @param[in] socket is your in-out socket context.
 * @param[out] buffer is a pointer to your buffer where you want to store the incoming data to.
 * @param[in] buffer_size is the byte size of your buffer, for preventing overflows.
-* @param[in] flags is a bitmask of receive flags. Use #TCS_FLAG_NONE for no flags, or any combination of #TCS_MSG_PEEK, #TCS_MSG_OOB, and #TCS_MSG_WAITALL.
+* @param[in] flags is a bitmask of receive flags. Use #TCS_FLAG_NONE for no flags, or any combination of #TCS_MSG_PEEK, #TCS_MSG_OOB, #TCS_MSG_WAITALL and #TCS_MSG_DONTWAIT.
 * @param[out] out_received_size is how many bytes that was successfully written to your buffer.
 * @return #TCS_SUCCESS if successful, otherwise the error code.
 * @see tcs_send()
@@ -1193,7 +1641,7 @@ TcsResult tcs_receive(TcsSocket socket, uint8_t* buffer, size_t buffer_size, uin
 * @param[in] socket is your in-out socket context.
 * @param[out] buffer is a pointer to your buffer where you want to store the incoming data to.
 * @param[in] buffer_size is the byte size of your buffer, for preventing overflows.
-* @param[in] flags is a bitmask of receive flags. Use #TCS_FLAG_NONE for no flags, or any combination of #TCS_MSG_PEEK, #TCS_MSG_OOB, and #TCS_MSG_WAITALL.
+* @param[in] flags is a bitmask of receive flags. Use #TCS_FLAG_NONE for no flags, or any combination of #TCS_MSG_PEEK, #TCS_MSG_OOB, #TCS_MSG_WAITALL and #TCS_MSG_DONTWAIT.
 * @param[out] out_source_address is the address the data was received from.
 * @param[out] out_received_size is how many bytes that was successfully written to your buffer.
 * @return #TCS_SUCCESS if successful, otherwise the error code.
@@ -1206,6 +1654,43 @@ TcsResult tcs_receive_from(TcsSocket socket,
                            struct TcsAddress* out_source_address,
                            size_t* out_received_size);
 
+/**
+* @brief Receive a datagram together with its local destination address and ingress interface.
+*
+* Packet info must be enabled with tcs_opt_packet_info_set() first, otherwise @p out_destination_address is set to
+* #TCS_ADDRESS_NONE and @p out_interface_id to 0.
+*
+* @code
+* tcs_opt_packet_info_set(socket, true);
+* struct TcsAddress remote = TCS_ADDRESS_NONE;
+* struct TcsAddress local = TCS_ADDRESS_NONE;
+* TcsInterfaceId iface = 0;
+* tcs_receive_from_to(socket, buffer, sizeof(buffer), TCS_FLAG_NONE, &remote, &local, &iface, &received);
+* tcs_send_to_from(socket, buffer, received, TCS_FLAG_NONE, &remote, &local, iface, NULL); // Echo from same address
+* @endcode
+*
+* @note Not supported on Windows. Will return #TCS_ERROR_NOT_SUPPORTED on that platform.
+*
+* @param[in] socket is your in-out socket context.
+* @param[out] buffer is a pointer to your buffer where you want to store the incoming data to.
+* @param[in] buffer_size is the byte size of your buffer, for preventing overflows.
+* @param[in] flags is a bitmask of receive flags. Use #TCS_FLAG_NONE for no flags, or any combination of #TCS_MSG_PEEK, #TCS_MSG_OOB, #TCS_MSG_WAITALL and #TCS_MSG_DONTWAIT.
+* @param[out] out_source_address is the address the data was received from. May be NULL.
+* @param[out] out_destination_address is the local address the data was sent to. The port is not set. May be NULL.
+* @param[out] out_interface_id is the interface the data was received on. May be NULL.
+* @param[out] out_received_size is how many bytes that was successfully written to your buffer.
+* @return #TCS_SUCCESS if successful, otherwise the error code.
+* @see tcs_send_to_from()
+*/
+TcsResult tcs_receive_from_to(TcsSocket socket,
+                              uint8_t* buffer,
+                              size_t buffer_size,
+                              uint32_t flags,
+                              struct TcsAddress* out_source_address,
+                              struct TcsAddress* out_destination_address,
+                              TcsInterfaceId* out_interface_id,
+                              size_t* out_received_size);
+
 /**
 * @brief Read up to and including a delimiter.
 *
@@ -1247,6 +1732,37 @@ TcsResult tcs_receive_line(TcsSocket socket,
 */
 TcsResult tcs_receive_netstring(TcsSocket socket, uint8_t* buffer, size_t buffer_size, size_t* out_received_size);
 
+/**
+* @brief Drain transmit timestamps from the socket error queue.
+*
+* Timestamps must first be enabled with tcs_opt_tx_timestamping_set(). Every send after that queues one
+* timestamp when the packet leaves the network stack. A socket in a TcsPoll reports
+* TcsPollEvent::can_read_error_queue when timestamps are waiting. The call never blocks.
+*
+* @code
+* tcs_opt_tx_timestamping_set(socket, true);
+* tcs_send_to(socket, msg, sizeof(msg), TCS_FLAG_NONE, &destination, NULL); // Gets id 0
+* // ... poll until can_read_error_queue ...
+* struct TcsTxTimestamp timestamps[16];
+* size_t count = 0;
+* tcs_receive_tx_timestamps(socket, timestamps, 16, &count);
+* @endcode
+*
+* @note Only supported on Linux. Will return #TCS_ERROR_NOT_SUPPORTED on other platforms.
+*
+* @param[in] socket socket with transmit timestamping enabled.
+* @param[out] out_timestamps array to fill with timestamps, oldest first.
+* @param[in] timestamps_length number of elements in @p out_timestamps.
+* @param[out] out_length number of timestamps written to @p out_timestamps.
+* @return #TCS_SUCCESS if at least one timestamp was read, otherwise the error code.
+* @retval #TCS_ERROR_WOULD_BLOCK if no timestamps are queued.
+* @see tcs_opt_tx_timestamping_set()
+*/
+TcsResult tcs_receive_tx_timestamps(TcsSocket socket,
+                                    struct TcsTxTimestamp out_timestamps[],
+                                    size_t timestamps_length,
+                                    size_t* out_length);
+
 /**
 * @brief Create a context used for waiting on several sockets.
 *
@@ -1363,114 +1879,709 @@ TcsResult tcs_poll_wait(struct TcsPoll* poll,
                         int timeout_ms);
 
 /**
-* @brief Set parameters on a socket. It is recommended to use tcs_opt_*_set() instead.
+* @brief Create a connector that opens TCP connections to many remote addresses in parallel.
 *
-* @param[in] socket is your in-out socket context.
-* @param[in] level is the definition level.
-* @param[in] option_name is the option name.
-* @param[in] option_value is a pointer to the option value.
-* @param[in] option_size is the byte size of the data pointed by @p option_value.
-* @return #TCS_SUCCESS if successful, otherwise the error code.
-*/
-TcsResult tcs_opt_set(TcsSocket socket,
-                      int32_t level,
-                      int32_t option_name,
-                      const void* option_value,
-                      size_t option_size);
-
-/**
-* @brief Get parameters on a socket. It is recommended to use tcs_opt_*_get() instead.
+* All connects are driven by one poll context in tcs_connector_run(), pick up the connected sockets and the result of
+* each target with tcs_connector_take().
 *
 * @code
-* uint8_t c;
-* size_t a = sizeof(c);
-* tcs_opt_get(socket, TCS_SOL_IP, TCS_IP_MULTICAST_LOOP, &c, &a);
+* struct TcsConnector* connector = NULL;
+* tcs_connector_create(&connector, backends, backends_count);
+* tcs_connector_run(connector, 0, 1000, 5000);
+* for (size_t i = 0; i < backends_count; ++i)
+* {
+*     TcsSocket socket = TCS_SOCKET_INVALID;
+*     if (tcs_connector_take(connector, i, &socket) == TCS_SUCCESS)
+*         use_backend(i, socket);
+* }
+* tcs_connector_destroy(&connector);
 * @endcode
 *
-* @param[in] socket is your in-out socket context.
-* @param[in] level is the definition level.
-* @param[in] option_name is the option name.
-* @param[out] out_option_value is a pointer to receive the option value.
-* @param[in,out] option_size is a pointer the byte size of the data pointed by @p out_option_value.
+* @param[out] out_connector is your out connector pointer. Initiate a TcsConnector pointer to NULL and use the address of this pointer.
+* @param[in] remote_addresses addresses to connect to, the array is copied.
+* @param[in] remote_addresses_length number of elements in @p remote_addresses.
 * @return #TCS_SUCCESS if successful, otherwise the error code.
+* @see tcs_connector_destroy()
 */
-TcsResult tcs_opt_get(TcsSocket socket,
-                      int32_t level,
-                      int32_t option_name,
-                      void* out_option_value,
-                      size_t* option_size);
+TcsResult tcs_connector_create(struct TcsConnector** out_connector,
+                               const struct TcsAddress remote_addresses[],
+                               size_t remote_addresses_length);
 
 /**
-* @brief Query the socket type (e.g. ::TCS_SOCKET_STREAM or ::TCS_SOCKET_DGRAM).
+* @brief Free a connector and close every socket that has not been taken with tcs_connector_take().
 *
-* @param[in] socket socket to query.
-* @param[out] out_type pointer to receive the socket type.
+* @param[in,out] connector is a pointer to your connector pointer. It will be set to NULL.
 * @return #TCS_SUCCESS if successful, otherwise the error code.
 */
-TcsResult tcs_opt_type_get(TcsSocket socket, TcsSocketType* out_type);
+TcsResult tcs_connector_destroy(struct TcsConnector** connector);
 
 /**
-* @brief Enable the socket to be allowed to send to broadcast addresses.
+* @brief Connect to all targets of the connector in parallel and wait until each one has a result.
 *
-* By default, sockets are not permitted to send to broadcast addresses (e.g.
-* 255.255.255.255 or subnet broadcast addresses) as a safety measure to prevent
-* accidental broadcast storms. Enable this option on UDP sockets that need to
-* send broadcast traffic.
+* Targets are started in order, at most @p max_in_flight at a time. A target that is not connected
+* @p connect_timeout_ms after its start fails with #TCS_ERROR_TIMED_OUT. When @p total_timeout_ms has passed, all
+* unfinished targets, including the ones never started, fail with #TCS_ERROR_TIMED_OUT. Connected sockets are in
+* blocking mode. Targets that already have a result are not retried by later calls.
 *
-* Only valid for protocols that support broadcast, for example UDP. Default is false.
+* @param[in] connector created with tcs_connector_create().
+* @param[in] max_in_flight maximum number of simultaneous connects, 0 for no limit.
+* @param[in] connect_timeout_ms per target timeout in milliseconds, or #TCS_WAIT_INF.
+* @param[in] total_timeout_ms timeout for the whole call in milliseconds, or #TCS_WAIT_INF.
+* @return #TCS_SUCCESS when every target has a result, use tcs_connector_take() to see which ones connected.
+* @retval #TCS_ERROR_TIMED_OUT if @p total_timeout_ms cut some targets short.
+*/
+TcsResult tcs_connector_run(struct TcsConnector* connector,
+                            size_t max_in_flight,
+                            int connect_timeout_ms,
+                            int total_timeout_ms);
+
+/**
+* @brief Get the result of one target and take over its socket.
 *
-* @param[in] socket socket to enable/disable permission to send broadcast on.
-* @param[in] do_allow_broadcast set to true to allow, false to forbid.
-* @return #TCS_SUCCESS if successful, otherwise the error code.
+* @param[in] connector created with tcs_connector_create().
+* @param[in] index of the target, in the order given to tcs_connector_create().
+* @param[out] out_socket receives the connected socket on success and the caller becomes its owner. Must be
+* initialized to #TCS_SOCKET_INVALID. May be NULL to only query the result, the connector then keeps the socket.
+* @return #TCS_SUCCESS if the target is connected, otherwise the error of its connect.
+* @retval #TCS_IN_PROGRESS if tcs_connector_run() has not finished the target yet.
+* @retval #TCS_ERROR_INVALID_ARGUMENT if the index is out of range or the socket was already taken.
 */
-TcsResult tcs_opt_broadcast_set(TcsSocket socket, bool do_allow_broadcast);
+TcsResult tcs_connector_take(struct TcsConnector* connector, size_t index, TcsSocket* out_socket);
 
 /**
-* @brief Query whether broadcast is enabled on a socket.
+* @brief Create a thread safe pool of outbound TCP connections, keyed by remote address.
 *
-* See tcs_opt_broadcast_set() for details on the broadcast option.
+* Released connections are kept open and handed out again by tcs_pool_acquire() for the same remote address, saving
+* the handshake and the TIME_WAIT state of a closed connection. The pool is split in #TCS_CFG_POOL_SHARDS
+* independently locked parts to keep contention low.
 *
-* @param[in] socket socket to query.
-* @param[out] out_is_broadcast_allowed pointer to receive the current broadcast setting.
+* @code
+* struct TcsPool* pool = NULL;
+* tcs_pool_create(&pool, 4, 16, 30000, 1000);
+* TcsSocket socket = TCS_SOCKET_INVALID;
+* if (tcs_pool_acquire(pool, &backend, &socket) == TCS_SUCCESS)
+* {
+*     bool is_ok = do_request(socket);
+*     tcs_pool_release(pool, &backend, &socket, is_ok);
+* }
+* tcs_pool_destroy(&pool);
+* @endcode
+*
+* @param[out] out_pool is your out pool pointer. Initiate a TcsPool pointer to NULL and use the address of this pointer.
+* @param[in] max_idle_per_key maximum number of idle connections kept per remote address.
+* @param[in] max_total_per_key maximum number of connections per remote address, idle and acquired together.
+* @param[in] idle_timeout_ms idle connections older than this are closed, or #TCS_WAIT_INF to keep them.
+* @param[in] connect_timeout_ms timeout for new connections, see tcs_socket_tcp().
 * @return #TCS_SUCCESS if successful, otherwise the error code.
+* @see tcs_pool_destroy()
 */
-TcsResult tcs_opt_broadcast_get(TcsSocket socket, bool* out_is_broadcast_allowed);
+TcsResult tcs_pool_create(struct TcsPool** out_pool,
+                          size_t max_idle_per_key,
+                          size_t max_total_per_key,
+                          int idle_timeout_ms,
+                          int connect_timeout_ms);
 
 /**
-* @brief Enable or disable TCP keep-alive on a socket.
-*
-* Keep-alive operates at the transport layer (TCP). When enabled, the OS periodically
-* sends probe packets on an idle connection to detect if the remote peer is still
-* reachable. Without keep-alive, a connection where neither side sends data can remain
-* open indefinitely even if the remote host has crashed or the network path is broken.
-*
-* Keep-alive probes also prevent NAT routers and stateful firewalls from dropping
-* idle connection mappings due to inactivity timeouts.
+* @brief Close all idle connections and free the pool.
 *
-* This is particularly useful for long-lived connections that may be idle for extended
-* periods, such as database connections or control channels.
+* Connections that are acquired at this point are owned by the caller and must be closed with tcs_close().
 *
-* @param[in] socket socket to configure.
-* @param[in] do_keep_alive set to true to enable, false to disable.
+* @param[in,out] pool is a pointer to your pool pointer. It will be set to NULL.
 * @return #TCS_SUCCESS if successful, otherwise the error code.
 */
-TcsResult tcs_opt_keep_alive_set(TcsSocket socket, bool do_keep_alive);
+TcsResult tcs_pool_destroy(struct TcsPool** pool);
 
 /**
-* @brief Query whether keep-alive is enabled on a socket.
+* @brief Get a connection to a remote address, reusing an idle one when possible.
 *
-* See tcs_opt_keep_alive_set() for details on what keep-alive does.
+* The most recently released idle connection is checked with a non-blocking peek. Connections that were closed or
+* reset by the peer, or that have unread data, are closed and the next one is tried. A new connection is made with
+* tcs_socket_tcp() when no idle one is usable.
 *
-* @param[in] socket socket to query.
-* @param[out] out_is_keep_alive_enabled pointer to receive the current keep-alive setting.
+* @param[in] pool created with tcs_pool_create().
+* @param[in] remote_address the key of the connection.
+* @param[out] out_socket receives the connection. Must be initialized to #TCS_SOCKET_INVALID.
 * @return #TCS_SUCCESS if successful, otherwise the error code.
+* @retval #TCS_ERROR_WOULD_BLOCK if the maximum number of connections to @p remote_address are already acquired.
+* @see tcs_pool_release()
 */
-TcsResult tcs_opt_keep_alive_get(TcsSocket socket, bool* out_is_keep_alive_enabled);
+TcsResult tcs_pool_acquire(struct TcsPool* pool, const struct TcsAddress* remote_address, TcsSocket* out_socket);
 
 /**
-* @brief Allow or disallow address reuse on a socket.
+* @brief Give a connection from tcs_pool_acquire() back to the pool.
 *
-* **TCP:**
+* @param[in] pool created with tcs_pool_create().
+* @param[in] remote_address the same address as used for tcs_pool_acquire().
+* @param[in,out] socket the connection. It is kept idle or closed, and set to #TCS_SOCKET_INVALID.
+* @param[in] is_reusable false to close the connection, e.g. after a protocol error.
+* @return #TCS_SUCCESS if successful, otherwise the error code.
+*/
+TcsResult tcs_pool_release(struct TcsPool* pool,
+                           const struct TcsAddress* remote_address,
+                           TcsSocket* socket,
+                           bool is_reusable);
+
+/**
+* @brief Create a resolver that runs tcs_address_resolve() on a pool of worker threads.
+*
+* Lookups are submitted without blocking and completions are signaled through a socket that can be added to a
+* TcsPoll, so an event loop thread can resolve hostnames. Any number of lookups can be queued, @p thread_count of them
+* run at the same time.
+*
+* @code
+* struct TcsResolver* resolver = NULL;
+* tcs_resolver_create(&resolver, 4);
+* TcsSocket resolver_socket = TCS_SOCKET_INVALID;
+* tcs_resolver_socket(resolver, &resolver_socket);
+* tcs_poll_add(poll, resolver_socket, resolver, TCS_POLL_READ);
+*
+* size_t handle = 0;
+* tcs_resolver_submit(resolver, "example.com", TCS_FAMILY_ANY, &handle);
+*
+* // When resolver_socket is readable
+* TcsResult lookup_result = TCS_SUCCESS;
+* struct TcsAddress addresses[4];
+* size_t count = 0;
+* while (tcs_resolver_take(resolver, &handle, &lookup_result, addresses, 4, &count) == TCS_SUCCESS)
+*     on_resolved(handle, lookup_result, addresses, count);
+* @endcode
+*
+* @param[out] out_resolver is your out resolver pointer. Initiate a TcsResolver pointer to NULL and use the address of
+* this pointer.
+* @param[in] thread_count number of worker threads, the maximum number of concurrent lookups.
+* @return #TCS_SUCCESS if successful, otherwise the error code.
+* @retval #TCS_ERROR_NOT_SUPPORTED on POSIX unless the implementation is built with TCS_CFG_THREADS set to 1.
+* @see tcs_resolver_destroy()
+*/
+TcsResult tcs_resolver_create(struct TcsResolver** out_resolver, size_t thread_count);
+
+/**
+* @brief Stop the worker threads and free the resolver.
+*
+* Waits for lookups that are already running, the system resolver can not interrupt them. Queued lookups are dropped.
+*
+* @param[in,out] resolver is a pointer to your resolver pointer. It will be set to NULL.
+* @return #TCS_SUCCESS if successful, otherwise the error code.
+*/
+TcsResult tcs_resolver_destroy(struct TcsResolver** resolver);
+
+/**
+* @brief Get the socket that is readable while there are finished lookups to take with tcs_resolver_take().
+*
+* Add it to a TcsPoll with #TCS_POLL_READ. It is owned by the resolver, do not read, write or close it. On POSIX it
+* is the read end of a pipe.
+*
+* @param[in] resolver created with tcs_resolver_create().
+* @param[out] out_socket receives the socket.
+* @return #TCS_SUCCESS if successful, otherwise the error code.
+*/
+TcsResult tcs_resolver_socket(struct TcsResolver* resolver, TcsSocket* out_socket);
+
+/**
+* @brief Queue a lookup without blocking.
+*
+* @param[in] resolver created with tcs_resolver_create().
+* @param[in] hostname hostname or IP string to resolve, it is copied.
+* @param[in] address_family address family filter, or ::TCS_FAMILY_ANY for all.
+* @param[out] out_handle identifies the lookup until it is taken or cancelled. Later lookups get other handles, so a
+* stale handle is rejected instead of acting on another lookup.
+* @return #TCS_SUCCESS if successful, otherwise the error code.
+*/
+TcsResult tcs_resolver_submit(struct TcsResolver* resolver,
+                              const char* hostname,
+                              TcsFamily address_family,
+                              size_t* out_handle);
+
+/**
+* @brief Take the result of the oldest finished lookup.
+*
+* At most #TCS_CFG_RESOLVER_ADDRESSES_MAX addresses are kept per lookup.
+*
+* @param[in] resolver created with tcs_resolver_create().
+* @param[out] out_handle receives the handle given by tcs_resolver_submit().
+* @param[out] out_result receives the result of the lookup, as tcs_address_resolve() would have returned it.
+* @param[out] out_addresses array to receive resolved addresses, or NULL to only count.
+* @param[in] addresses_length number of elements in the @p out_addresses array.
+* @param[out] out_length pointer to receive the number of addresses found, or NULL.
+* @return #TCS_SUCCESS if a lookup was taken, otherwise the error code.
+* @retval #TCS_AGAIN if no lookup has finished.
+*/
+TcsResult tcs_resolver_take(struct TcsResolver* resolver,
+                            size_t* out_handle,
+                            TcsResult* out_result,
+                            struct TcsAddress out_addresses[],
+                            size_t addresses_length,
+                            size_t* out_length);
+
+/**
+* @brief Drop a lookup that is no longer needed. It will not be returned by tcs_resolver_take().
+*
+* A lookup that is already running still occupies its worker thread until the system resolver returns.
+*
+* @param[in] resolver created with tcs_resolver_create().
+* @param[in] handle given by tcs_resolver_submit().
+* @return #TCS_SUCCESS if successful, otherwise the error code.
+* @retval #TCS_ERROR_INVALID_ARGUMENT if the lookup was already taken or cancelled.
+*/
+TcsResult tcs_resolver_cancel(struct TcsResolver* resolver, size_t handle);
+
+/**
+* @brief Create a DNS stub resolver that speaks DNS over its own non-blocking sockets, driven by your TcsPoll.
+*
+* A and AAAA queries are sent in parallel over UDP to the nameservers. Queries without an answer are sent again to the
+* next nameserver after @p attempt_timeout_ms. Truncated answers are fetched again over TCP. Every attempt uses a new
+* socket with a random source port and a random query id. Thousands of lookups can be in flight from a single thread,
+* limited by the number of open sockets, no thread or blocking call is used.
+*
+* The resolver adds its sockets to @p poll with itself as user data. Pass every event with that user data to
+* tcs_dns_process() and call it when tcs_poll_wait() times out, using the timeout it returns.
+*
+* @code
+* struct TcsDns* dns = NULL;
+* tcs_dns_create(&dns, poll, NULL, 0, 5000, 2);
+* size_t handle = 0;
+* tcs_dns_submit(dns, "example.com", TCS_FAMILY_ANY, &handle);
+* int timeout_ms = 0;
+* tcs_dns_process(dns, NULL, &timeout_ms);
+* while (running)
+* {
+*     struct TcsPollEvent events[16];
+*     size_t count = 0;
+*     tcs_poll_wait(poll, events, 16, &count, timeout_ms);
+*     for (size_t i = 0; i < count; ++i)
+*     {
+*         if (events[i].user_data == dns)
+*             tcs_dns_process(dns, &events[i], &timeout_ms);
+*     }
+*     tcs_dns_process(dns, NULL, &timeout_ms);
+*     while (tcs_dns_take(dns, &handle, &lookup_result, addresses, 16, &address_count) == TCS_SUCCESS)
+*         on_resolved(handle, lookup_result, addresses, address_count);
+* }
+* @endcode
+*
+* @note Names are queried as given, search domains of resolv.conf are not applied. Use tcs_address_resolve() when the
+* full system resolver behavior is needed.
+*
+* @param[out] out_dns is your out resolver pointer. Initiate a TcsDns pointer to NULL and use the address of this
+* pointer.
+* @param[in] poll receives the sockets of the resolver. Must outlive the resolver.
+* @param[in] nameservers to ask, port 0 means 53. NULL to use the system configuration: the nameservers of
+* #TCS_CFG_DNS_RESOLV_CONF_PATH, or 127.0.0.1 if there are none, and the names in #TCS_CFG_DNS_HOSTS_PATH.
+* @param[in] nameservers_length number of nameservers, at most #TCS_CFG_DNS_NAMESERVERS_MAX. 0 if @p nameservers is
+* NULL.
+* @param[in] attempt_timeout_ms time to wait for an answer before asking again.
+* @param[in] attempts number of times every nameserver is asked before a lookup fails with #TCS_ERROR_TIMED_OUT.
+* @return #TCS_SUCCESS if successful, otherwise the error code.
+* @see tcs_dns_destroy()
+*/
+TcsResult tcs_dns_create(struct TcsDns** out_dns,
+                         struct TcsPoll* poll,
+                         const struct TcsAddress nameservers[],
+                         size_t nameservers_length,
+                         int attempt_timeout_ms,
+                         int attempts);
+
+/**
+* @brief Remove the sockets of the resolver from its TcsPoll, close them and free the resolver.
+*
+* @param[in,out] dns is a pointer to your resolver pointer. It will be set to NULL.
+* @return #TCS_SUCCESS if successful, otherwise the error code.
+*/
+TcsResult tcs_dns_destroy(struct TcsDns** dns);
+
+/**
+* @brief Start a lookup. The queries are sent before this function returns.
+*
+* Numeric addresses and names in the hosts file are answered at once, call tcs_dns_take() to get them.
+*
+* @param[in] dns created with tcs_dns_create().
+* @param[in] hostname name or IP string to resolve.
+* @param[in] address_family ::TCS_FAMILY_IPV4 for A, ::TCS_FAMILY_IPV6 for AAAA or ::TCS_FAMILY_ANY for both.
+* @param[out] out_handle identifies the lookup until it is taken or cancelled. Later lookups get other handles, so a
+* stale handle is rejected instead of acting on another lookup.
+* @return #TCS_SUCCESS if successful, otherwise the error code.
+*/
+TcsResult tcs_dns_submit(struct TcsDns* dns, const char* hostname, TcsFamily address_family, size_t* out_handle);
+
+/**
+* @brief Read answers, progress TCP fallbacks and send again queries that timed out. Never blocks.
+*
+* @param[in] dns created with tcs_dns_create().
+* @param[in] event from tcs_poll_wait() with the resolver as user data, or NULL to only check timeouts.
+* @param[out] out_timeout_ms receives the time until the next timeout, 0 if finished lookups are waiting for
+* tcs_dns_take(), or #TCS_WAIT_INF if no query is in flight. May be NULL.
+* @return #TCS_SUCCESS if successful, otherwise the error code.
+*/
+TcsResult tcs_dns_process(struct TcsDns* dns, const struct TcsPollEvent* event, int* out_timeout_ms);
+
+/**
+* @brief Take the result of the oldest finished lookup.
+*
+* AAAA addresses are returned before A addresses, at most #TCS_CFG_DNS_ADDRESSES_MAX of each.
+*
+* @param[in] dns created with tcs_dns_create().
+* @param[out] out_handle receives the handle given by tcs_dns_submit().
+* @param[out] out_result receives the result of the lookup. #TCS_SUCCESS if any family has addresses.
+* @param[out] out_addresses array to receive resolved addresses, or NULL to only count.
+* @param[in] addresses_length number of elements in the @p out_addresses array.
+* @param[out] out_length pointer to receive the number of addresses found, or NULL.
+* @return #TCS_SUCCESS if a lookup was taken, otherwise the error code.
+* @retval #TCS_AGAIN if no lookup has finished.
+*/
+TcsResult tcs_dns_take(struct TcsDns* dns,
+                       size_t* out_handle,
+                       TcsResult* out_result,
+                       struct TcsAddress out_addresses[],
+                       size_t addresses_length,
+                       size_t* out_length);
+
+/**
+* @brief Stop a lookup that is no longer needed. Late answers are ignored.
+*
+* @param[in] dns created with tcs_dns_create().
+* @param[in] handle given by tcs_dns_submit().
+* @return #TCS_SUCCESS if successful, otherwise the error code.
+* @retval #TCS_ERROR_INVALID_ARGUMENT if the lookup was already taken or cancelled.
+*/
+TcsResult tcs_dns_cancel(struct TcsDns* dns, size_t handle);
+
+/**
+* @brief Create a memory mapped receive ring (TPACKET_V3) on a packet socket.
+*
+* Frames are written by the kernel directly into memory shared with the application. No syscall or copy is needed
+* per frame. The ring is split into blocks, a block is handed to the application when it is full or when
+* @p block_timeout_ms has passed since the first frame was written to it. Iterate the frames of a block with
+* tcs_packet_ring_rx_next() and hand the block back with tcs_packet_ring_rx_release().
+*
+* Add the socket to a TcsPoll with #TCS_POLL_READ to wait for the next block.
+* Frames are no longer delivered to tcs_receive() while the ring exists.
+* A socket can only have one ring. The kernel fixes the ring version and the map offset per socket, so a transmit ring
+* from tcs_packet_ring_tx_create() needs a separate packet socket.
+*
+* @code
+* TcsSocket socket = TCS_SOCKET_INVALID;
+* tcs_socket_packet_str(&socket, "eth0", TCS_PROTOCOL_ETH_ALL, TCS_SOCKET_RAW);
+* struct TcsPacketRing* ring = NULL;
+* tcs_packet_ring_rx_create(&ring, socket, 1 << 20, 16, 2048, 10);
+* for (;;)
+* {
+*     struct TcsPacketFrame frame;
+*     TcsResult sts = tcs_packet_ring_rx_next(ring, &frame);
+*     if (sts == TCS_SUCCESS)
+*         handle_frame(frame.data, frame.size);
+*     else if (sts == TCS_AGAIN)
+*         tcs_packet_ring_rx_release(ring);
+*     else if (sts == TCS_ERROR_WOULD_BLOCK)
+*         wait_with_tcs_poll(socket);
+* }
+* tcs_packet_ring_destroy(&ring);
+* tcs_close(&socket);
+* @endcode
+*
+* @note Only supported on Linux. Will return #TCS_ERROR_NOT_SUPPORTED on other platforms.
+*
+* @param[out] out_ring is your out ring pointer. Initiate a TcsPacketRing pointer to NULL and use the address of this pointer.
+* @param[in] socket is a packet socket, see tcs_socket_packet(). The ring does not take ownership of the socket.
+* @param[in] block_size is the byte size of each block. Must be a multiple of the page size.
+* @param[in] block_count is the number of blocks in the ring.
+* @param[in] frame_size is the maximum byte size of a frame including the 48 byte ring header. Must be a multiple of 16.
+* @param[in] block_timeout_ms is the maximum time a partially filled block is held by the kernel. Use 0 for the kernel default.
+* @return #TCS_SUCCESS if successful, otherwise the error code.
+* @retval #TCS_ERROR_INVALID_ARGUMENT if the socket already has a receive or transmit ring.
+* @see tcs_packet_ring_destroy()
+*/
+TcsResult tcs_packet_ring_rx_create(struct TcsPacketRing** out_ring,
+                                    TcsSocket socket,
+                                    size_t block_size,
+                                    size_t block_count,
+                                    size_t frame_size,
+                                    int block_timeout_ms);
+
+/**
+* @brief Unmap and free a packet ring. The socket is left open.
+*
+* @param[in,out] ring is a pointer to your ring pointer. Will be set to NULL.
+* @return #TCS_SUCCESS if successful, otherwise the error code.
+*/
+TcsResult tcs_packet_ring_destroy(struct TcsPacketRing** ring);
+
+/**
+* @brief Get the next received frame in place.
+*
+* @param[in] ring is a receive ring created with tcs_packet_ring_rx_create().
+* @param[out] out_frame will point to the frame inside the ring.
+* @return #TCS_SUCCESS if a frame was returned, otherwise the error code.
+* @retval #TCS_AGAIN if all frames of the current block are consumed. Call tcs_packet_ring_rx_release() to continue.
+* @retval #TCS_ERROR_WOULD_BLOCK if no block is ready. Wait with TcsPoll.
+*/
+TcsResult tcs_packet_ring_rx_next(struct TcsPacketRing* ring, struct TcsPacketFrame* out_frame);
+
+/**
+* @brief Hand the current block back to the kernel and move to the next block.
+*
+* All frames returned from the current block become invalid.
+*
+* @param[in] ring is a receive ring created with tcs_packet_ring_rx_create().
+* @return #TCS_SUCCESS if successful, otherwise the error code.
+*/
+TcsResult tcs_packet_ring_rx_release(struct TcsPacketRing* ring);
+
+/**
+* @brief Create a memory mapped transmit ring (TPACKET_V2) on a packet socket.
+*
+* Frames are written by the application directly into memory shared with the kernel. Fill as many frames as needed
+* with tcs_packet_ring_tx_acquire() and tcs_packet_ring_tx_commit(), then transmit all of them with a single
+* tcs_packet_ring_tx_flush().
+*
+* Add the socket to a TcsPoll with #TCS_POLL_WRITE to wait for a free frame.
+* A socket can only have one ring. The kernel fixes the ring version and the map offset per socket, so a receive ring
+* from tcs_packet_ring_rx_create() needs a separate packet socket.
+*
+* @code
+* TcsSocket socket = TCS_SOCKET_INVALID;
+* tcs_socket_packet_str(&socket, "eth0", 0x22F0, TCS_SOCKET_RAW);
+* tcs_opt_packet_qdisc_bypass_set(socket, true); // Optional
+* struct TcsPacketRing* ring = NULL;
+* tcs_packet_ring_tx_create(&ring, socket, 1 << 16, 16, 2048);
+* uint8_t* data = NULL;
+* size_t capacity = 0;
+* while (has_frames() && tcs_packet_ring_tx_acquire(ring, &data, &capacity) == TCS_SUCCESS)
+*     tcs_packet_ring_tx_commit(ring, write_frame(data, capacity));
+* tcs_packet_ring_tx_flush(ring, NULL);
+* tcs_packet_ring_destroy(&ring);
+* tcs_close(&socket);
+* @endcode
+*
+* @note Only supported on Linux. Will return #TCS_ERROR_NOT_SUPPORTED on other platforms.
+*
+* @param[out] out_ring is your out ring pointer. Initiate a TcsPacketRing pointer to NULL and use the address of this pointer.
+* @param[in] socket is a packet socket, see tcs_socket_packet(). The ring does not take ownership of the socket.
+* @param[in] block_size is the byte size of each block. Must be a multiple of the page size.
+* @param[in] block_count is the number of blocks in the ring.
+* @param[in] frame_size is the byte size of each frame including the 32 byte ring header. Must be a multiple of 16.
+* @return #TCS_SUCCESS if successful, otherwise the error code.
+* @retval #TCS_ERROR_INVALID_ARGUMENT if the socket already has a receive or transmit ring.
+* @see tcs_packet_ring_destroy()
+*/
+TcsResult tcs_packet_ring_tx_create(struct TcsPacketRing** out_ring,
+                                    TcsSocket socket,
+                                    size_t block_size,
+                                    size_t block_count,
+                                    size_t frame_size);
+
+/**
+* @brief Get the next free frame of a transmit ring.
+*
+* The same frame is returned until it is committed with tcs_packet_ring_tx_commit().
+* For #TCS_SOCKET_RAW sockets the frame starts with the link layer header, for #TCS_SOCKET_DGRAM it is the payload.
+*
+* @param[in] ring is a transmit ring created with tcs_packet_ring_tx_create().
+* @param[out] out_data will point to the frame inside the ring.
+* @param[out] out_capacity is the maximum number of bytes that can be written to @p out_data.
+* @return #TCS_SUCCESS if a frame was returned, otherwise the error code.
+* @retval #TCS_ERROR_WOULD_BLOCK if all frames are queued for transmission. Flush or wait with TcsPoll.
+*/
+TcsResult tcs_packet_ring_tx_acquire(struct TcsPacketRing* ring, uint8_t** out_data, size_t* out_capacity);
+
+/**
+* @brief Queue the frame returned by tcs_packet_ring_tx_acquire() for transmission.
+*
+* Nothing is sent until tcs_packet_ring_tx_flush() is called.
+*
+* @param[in] ring is a transmit ring created with tcs_packet_ring_tx_create().
+* @param[in] frame_size is the number of bytes written to the frame.
+* @return #TCS_SUCCESS if successful, otherwise the error code.
+* @retval #TCS_ERROR_INVALID_ARGUMENT if no frame was acquired since the last commit.
+*/
+TcsResult tcs_packet_ring_tx_commit(struct TcsPacketRing* ring, size_t frame_size);
+
+/**
+* @brief Transmit all committed frames with one syscall.
+*
+* Blocks until the frames are handed to the device unless the socket is non-blocking.
+*
+* @param[in] ring is a transmit ring created with tcs_packet_ring_tx_create().
+* @param[in] destination_address is the link layer destination, required for #TCS_SOCKET_DGRAM sockets. Use NULL for
+*            #TCS_SOCKET_RAW sockets to send on the interface the socket is bound to.
+* @return #TCS_SUCCESS if successful, otherwise the error code.
+*/
+TcsResult tcs_packet_ring_tx_flush(struct TcsPacketRing* ring, const struct TcsAddress* destination_address);
+
+/**
+* @brief Initialize a filter that accepts everything.
+*
+* Add predicates with the tcs_filter_*() functions and attach it with tcs_opt_filter_attach().
+* The predicates only build instructions and work on every platform, attaching is only supported on Linux.
+*
+* @code
+* struct TcsFilter filter;
+* tcs_filter_init(&filter);
+* tcs_filter_ether_type(&filter, 0x0800);
+* tcs_filter_udp_destination_port(&filter, 5000);
+* tcs_opt_filter_attach(socket, &filter);
+* @endcode
+*
+* @param[out] filter is the filter to initialize.
+* @return #TCS_SUCCESS if successful, otherwise the error code.
+*/
+TcsResult tcs_filter_init(struct TcsFilter* filter);
+
+/**
+* @brief Only accept frames with this EtherType.
+*
+* Matches the protocol after any VLAN tag, e.g. 0x0800 for IPv4 or 0x22F0 for AVTP.
+*
+* @param[in,out] filter is an initialized filter.
+* @param[in] ether_type is the EtherType in host byte order.
+* @return #TCS_SUCCESS if successful, otherwise the error code.
+* @retval #TCS_ERROR_MEMORY if the filter has no room left, see TCS_CFG_FILTER_MAX_INSTRUCTIONS.
+*/
+TcsResult tcs_filter_ether_type(struct TcsFilter* filter, uint16_t ether_type);
+
+/**
+* @brief Only accept frames with a VLAN tag with this VLAN id.
+*
+* @param[in,out] filter is an initialized filter.
+* @param[in] vlan_id is the 12 bit VLAN id.
+* @return #TCS_SUCCESS if successful, otherwise the error code.
+* @retval #TCS_ERROR_MEMORY if the filter has no room left, see TCS_CFG_FILTER_MAX_INSTRUCTIONS.
+*/
+TcsResult tcs_filter_vlan_id(struct TcsFilter* filter, uint16_t vlan_id);
+
+/**
+* @brief Only accept UDP datagrams over IPv4 or IPv6 to this destination port.
+*
+* IPv4 fragments after the first one are dropped. IPv6 datagrams with extension headers are not matched.
+*
+* @param[in,out] filter is an initialized filter.
+* @param[in] port is the UDP destination port.
+* @return #TCS_SUCCESS if successful, otherwise the error code.
+* @retval #TCS_ERROR_MEMORY if the filter has no room left, see TCS_CFG_FILTER_MAX_INSTRUCTIONS.
+*/
+TcsResult tcs_filter_udp_destination_port(struct TcsFilter* filter, uint16_t port);
+
+/**
+* @brief Only accept frames sent to this multicast group.
+*
+* Compares the IPv4 or IPv6 destination address, or the destination MAC address for #TCS_FAMILY_PACKET.
+* Useful on sockets bound to a wildcard address that have joined several groups.
+*
+* @param[in,out] filter is an initialized filter.
+* @param[in] multicast_address is an IPv4, IPv6 or MAC multicast address. The port is ignored.
+* @return #TCS_SUCCESS if successful, otherwise the error code.
+* @retval #TCS_ERROR_MEMORY if the filter has no room left, see TCS_CFG_FILTER_MAX_INSTRUCTIONS.
+*/
+TcsResult tcs_filter_multicast_group(struct TcsFilter* filter, const struct TcsAddress* multicast_address);
+
+/**
+* @brief Set parameters on a socket. It is recommended to use tcs_opt_*_set() instead.
+*
+* @param[in] socket is your in-out socket context.
+* @param[in] level is the definition level.
+* @param[in] option_name is the option name.
+* @param[in] option_value is a pointer to the option value.
+* @param[in] option_size is the byte size of the data pointed by @p option_value.
+* @return #TCS_SUCCESS if successful, otherwise the error code.
+*/
+TcsResult tcs_opt_set(TcsSocket socket,
+                      int32_t level,
+                      int32_t option_name,
+                      const void* option_value,
+                      size_t option_size);
+
+/**
+* @brief Get parameters on a socket. It is recommended to use tcs_opt_*_get() instead.
+*
+* @code
+* uint8_t c;
+* size_t a = sizeof(c);
+* tcs_opt_get(socket, TCS_SOL_IP, TCS_IP_MULTICAST_LOOP, &c, &a);
+* @endcode
+*
+* @param[in] socket is your in-out socket context.
+* @param[in] level is the definition level.
+* @param[in] option_name is the option name.
+* @param[out] out_option_value is a pointer to receive the option value.
+* @param[in,out] option_size is a pointer the byte size of the data pointed by @p out_option_value.
+* @return #TCS_SUCCESS if successful, otherwise the error code.
+*/
+TcsResult tcs_opt_get(TcsSocket socket,
+                      int32_t level,
+                      int32_t option_name,
+                      void* out_option_value,
+                      size_t* option_size);
+
+/**
+* @brief Query the socket type (e.g. ::TCS_SOCKET_STREAM or ::TCS_SOCKET_DGRAM).
+*
+* @param[in] socket socket to query.
+* @param[out] out_type pointer to receive the socket type.
+* @return #TCS_SUCCESS if successful, otherwise the error code.
+*/
+TcsResult tcs_opt_type_get(TcsSocket socket, TcsSocketType* out_type);
+
+/**
+* @brief Enable the socket to be allowed to send to broadcast addresses.
+*
+* By default, sockets are not permitted to send to broadcast addresses (e.g.
+* 255.255.255.255 or subnet broadcast addresses) as a safety measure to prevent
+* accidental broadcast storms. Enable this option on UDP sockets that need to
+* send broadcast traffic.
+*
+* Only valid for protocols that support broadcast, for example UDP. Default is false.
+*
+* @param[in] socket socket to enable/disable permission to send broadcast on.
+* @param[in] do_allow_broadcast set to true to allow, false to forbid.
+* @return #TCS_SUCCESS if successful, otherwise the error code.
+*/
+TcsResult tcs_opt_broadcast_set(TcsSocket socket, bool do_allow_broadcast);
+
+/**
+* @brief Query whether broadcast is enabled on a socket.
+*
+* See tcs_opt_broadcast_set() for details on the broadcast option.
+*
+* @param[in] socket socket to query.
+* @param[out] out_is_broadcast_allowed pointer to receive the current broadcast setting.
+* @return #TCS_SUCCESS if successful, otherwise the error code.
+*/
+TcsResult tcs_opt_broadcast_get(TcsSocket socket, bool* out_is_broadcast_allowed);
+
+/**
+* @brief Enable or disable TCP keep-alive on a socket.
+*
+* Keep-alive operates at the transport layer (TCP). When enabled, the OS periodically
+* sends probe packets on an idle connection to detect if the remote peer is still
+* reachable. Without keep-alive, a connection where neither side sends data can remain
+* open indefinitely even if the remote host has crashed or the network path is broken.
+*
+* Keep-alive probes also prevent NAT routers and stateful firewalls from dropping
+* idle connection mappings due to inactivity timeouts.
+*
+* This is particularly useful for long-lived connections that may be idle for extended
+* periods, such as database connections or control channels.
+*
+* @param[in] socket socket to configure.
+* @param[in] do_keep_alive set to true to enable, false to disable.
+* @return #TCS_SUCCESS if successful, otherwise the error code.
+*/
+TcsResult tcs_opt_keep_alive_set(TcsSocket socket, bool do_keep_alive);
+
+/**
+* @brief Query whether keep-alive is enabled on a socket.
+*
+* See tcs_opt_keep_alive_set() for details on what keep-alive does.
+*
+* @param[in] socket socket to query.
+* @param[out] out_is_keep_alive_enabled pointer to receive the current keep-alive setting.
+* @return #TCS_SUCCESS if successful, otherwise the error code.
+*/
+TcsResult tcs_opt_keep_alive_get(TcsSocket socket, bool* out_is_keep_alive_enabled);
+
+/**
+* @brief Allow or disallow address reuse on a socket.
+*
+* **TCP:**
 * Allows binding to a port that is in the TIME_WAIT state. When a TCP connection
 * is closed, the port remains reserved for up to 2 minutes (2x Maximum Segment
 * Lifetime) to ensure delayed packets from the old connection are not misinterpreted
@@ -1542,6 +2653,21 @@ TcsResult tcs_opt_reuse_port_set(TcsSocket socket, bool do_allow_reuse_port);
 */
 TcsResult tcs_opt_reuse_port_get(TcsSocket socket, bool* out_is_reuse_port_allowed);
 
+/**
+* @brief Pick the socket of a SO_REUSEPORT group by the CPU that received the packet instead of by flow hash.
+*
+* Attaches a SO_ATTACH_REUSEPORT_CBPF program selecting socket number (CPU % @p group_size), where sockets are
+* numbered in the order they joined the group (bind for UDP, listen for TCP). The program applies to the whole group,
+* attach it to any member once all members have joined. See tcs_socket_per_cpu() for a helper creating the group.
+*
+* @note Only supported on Linux 4.5+. Will return #TCS_ERROR_NOT_SUPPORTED on other platforms.
+*
+* @param[in] socket is a bound member of the group.
+* @param[in] group_size is the number of sockets in the group.
+* @return #TCS_SUCCESS if successful, otherwise the error code.
+*/
+TcsResult tcs_opt_reuse_port_steer_by_cpu(TcsSocket socket, size_t group_size);
+
 /**
 * @brief Set the send buffer size of a socket.
 *
@@ -1634,6 +2760,63 @@ TcsResult tcs_opt_ip_no_delay_set(TcsSocket socket, bool use_no_delay);
 */
 TcsResult tcs_opt_ip_no_delay_get(TcsSocket socket, bool* out_is_no_delay_used);
 
+/**
+* @brief Accept TCP Fast Open (TFO) connections on a listener, data in the SYN is delivered without waiting for the
+* handshake to complete.
+*
+* Call before tcs_listen(). Falls back silently to normal handshakes where TFO is unavailable, in that case
+* tcs_opt_tcp_fast_open_get() reports 0. On Linux the server side must also be enabled in net.ipv4.tcp_fastopen.
+*
+* @param[in] socket TCP socket that will listen.
+* @param[in] queue_length maximum number of pending TFO requests, 0 to disable.
+* @return #TCS_SUCCESS if successful or if TFO is unavailable, otherwise the error code.
+* @see tcs_opt_tcp_fast_open_connect_set()
+*/
+TcsResult tcs_opt_tcp_fast_open_set(TcsSocket socket, int queue_length);
+
+/**
+* @brief Query the TCP Fast Open queue length of a listener.
+*
+* @param[in] socket socket to query.
+* @param[out] out_queue_length pointer to receive the queue length, 0 if TFO is disabled or unavailable.
+* @return #TCS_SUCCESS if successful, otherwise the error code.
+*/
+TcsResult tcs_opt_tcp_fast_open_get(TcsSocket socket, int* out_queue_length);
+
+/**
+* @brief Send the first data with the SYN using TCP Fast Open (TFO) on a client socket.
+*
+* Call before tcs_connect(). tcs_connect() then returns immediately and the handshake starts with the first
+* tcs_send(), carrying its data in the SYN when the server has handed out a TFO cookie earlier. The first connection
+* to a server uses a normal handshake to get the cookie. Falls back silently to normal handshakes where TFO is
+* unavailable, in that case tcs_opt_tcp_fast_open_connect_get() reports false.
+*
+* @code
+* TcsSocket socket = TCS_SOCKET_INVALID;
+* tcs_socket(&socket, TCS_FAMILY_IPV4, TCS_SOCKET_STREAM, TCS_PROTOCOL_IP_TCP);
+* tcs_opt_tcp_fast_open_connect_set(socket, true);
+* tcs_connect(socket, &server_address);
+* tcs_send(socket, request, request_size, TCS_FLAG_NONE, NULL); // Goes out with the SYN
+* @endcode
+*
+* @note Uses TCP_FASTOPEN_CONNECT, Linux 4.11+.
+*
+* @param[in] socket TCP socket that is not yet connected.
+* @param[in] do_fast_open set to true to enable, false to disable.
+* @return #TCS_SUCCESS if successful or if TFO is unavailable, otherwise the error code.
+* @see tcs_opt_tcp_fast_open_set()
+*/
+TcsResult tcs_opt_tcp_fast_open_connect_set(TcsSocket socket, bool do_fast_open);
+
+/**
+* @brief Query if a client socket uses TCP Fast Open.
+*
+* @param[in] socket socket to query.
+* @param[out] out_is_fast_open pointer to receive the current setting, false if TFO is unavailable.
+* @return #TCS_SUCCESS if successful, otherwise the error code.
+*/
+TcsResult tcs_opt_tcp_fast_open_connect_get(TcsSocket socket, bool* out_is_fast_open);
+
 /**
 * @brief Enable or disable inline reception of out-of-band data.
 *
@@ -1797,6 +2980,136 @@ TcsResult tcs_opt_nonblocking_set(TcsSocket socket, bool do_nonblocking);
 */
 TcsResult tcs_opt_nonblocking_get(TcsSocket socket, bool* out_is_nonblocking);
 
+/**
+* @brief Enable or disable software transmit timestamps.
+*
+* Each packet sent after enabling gets a software timestamp queued on the socket error queue.
+* Read them with tcs_receive_tx_timestamps(). The id of each timestamp is a counter that restarts
+* at 0 every time timestamping is enabled.
+*
+* @note Only supported on Linux. Will return #TCS_ERROR_NOT_SUPPORTED on other platforms.
+*
+* @param[in] socket socket to configure.
+* @param[in] do_timestamp set to true to enable transmit timestamps, false to disable.
+* @return #TCS_SUCCESS if successful, otherwise the error code.
+* @see tcs_receive_tx_timestamps()
+*/
+TcsResult tcs_opt_tx_timestamping_set(TcsSocket socket, bool do_timestamp);
+
+/**
+* @brief Query if software transmit timestamps are enabled.
+*
+* @note Only supported on Linux. Will return #TCS_ERROR_NOT_SUPPORTED on other platforms.
+*
+* @param[in] socket socket to query.
+* @param[out] out_is_timestamping pointer to receive the current setting.
+* @return #TCS_SUCCESS if successful, otherwise the error code.
+*/
+TcsResult tcs_opt_tx_timestamping_get(TcsSocket socket, bool* out_is_timestamping);
+
+/**
+* @brief Enable or disable reception of destination address and interface for each datagram.
+*
+* Sets IP_PKTINFO on IPv4 sockets and IPV6_RECVPKTINFO on IPv6 sockets.
+*
+* @note Not supported on Windows. Will return #TCS_ERROR_NOT_SUPPORTED on that platform.
+*
+* @param[in] socket socket to configure.
+* @param[in] do_receive_packet_info set to true to enable, false to disable.
+* @return #TCS_SUCCESS if successful, otherwise the error code.
+* @see tcs_receive_from_to()
+*/
+TcsResult tcs_opt_packet_info_set(TcsSocket socket, bool do_receive_packet_info);
+
+/**
+* @brief Query if destination address and interface are received for each datagram.
+*
+* @note Not supported on Windows. Will return #TCS_ERROR_NOT_SUPPORTED on that platform.
+*
+* @param[in] socket socket to query.
+* @param[out] out_is_packet_info_received pointer to receive the current setting.
+* @return #TCS_SUCCESS if successful, otherwise the error code.
+*/
+TcsResult tcs_opt_packet_info_get(TcsSocket socket, bool* out_is_packet_info_received);
+
+/**
+* @brief Send frames from a packet socket directly to the device, skipping the traffic control (qdisc) layer.
+*
+* Gives the highest frame rate but frames are dropped instead of queued if the device queue is full, and they are
+* not seen by other packet sockets on the interface.
+*
+* @note Only supported on Linux. Will return #TCS_ERROR_NOT_SUPPORTED on other platforms.
+*
+* @param[in] socket packet socket to configure, see tcs_socket_packet().
+* @param[in] do_bypass set to true to bypass the qdisc layer, false to use it.
+* @return #TCS_SUCCESS if successful, otherwise the error code.
+* @see tcs_packet_ring_tx_create()
+*/
+TcsResult tcs_opt_packet_qdisc_bypass_set(TcsSocket socket, bool do_bypass);
+
+/**
+* @brief Query if a packet socket bypasses the qdisc layer.
+*
+* @note Only supported on Linux. Will return #TCS_ERROR_NOT_SUPPORTED on other platforms.
+*
+* @param[in] socket packet socket to query.
+* @param[out] out_is_bypassed pointer to receive the current setting.
+* @return #TCS_SUCCESS if successful, otherwise the error code.
+*/
+TcsResult tcs_opt_packet_qdisc_bypass_get(TcsSocket socket, bool* out_is_bypassed);
+
+/**
+* @brief Join a packet socket to a fanout group to share the capture of an interface between sockets.
+*
+* Every frame is delivered to exactly one member of the group, picked by @p mode. Give each worker thread its own
+* packet socket bound to the same interface and protocol, and join them all to the same group. All members must use
+* the same mode. The group is per network namespace, use an id that is not used by other applications.
+* A socket stays in the group until it is closed.
+*
+* @code
+* TcsSocket workers[4];
+* for (int i = 0; i < 4; ++i)
+* {
+*     workers[i] = TCS_SOCKET_INVALID;
+*     tcs_socket_packet_str(&workers[i], "eth0", TCS_PROTOCOL_ETH_ALL, TCS_SOCKET_RAW);
+*     tcs_opt_packet_fanout_join(workers[i], 42, TCS_PACKET_FANOUT_HASH);
+* }
+* @endcode
+*
+* @note Only supported on Linux. Will return #TCS_ERROR_NOT_SUPPORTED on other platforms.
+*
+* @param[in] socket is a bound packet socket, see tcs_socket_packet().
+* @param[in] group_id identifies the group. The group is created by the first member.
+* @param[in] mode is how frames are distributed, see ::TcsPacketFanoutMode.
+* @return #TCS_SUCCESS if successful, otherwise the error code.
+*/
+TcsResult tcs_opt_packet_fanout_join(TcsSocket socket, uint16_t group_id, TcsPacketFanoutMode mode);
+
+/**
+* @brief Attach a classic BPF filter to a socket. Frames rejected by the filter are dropped in the kernel.
+*
+* Works on packet sockets as well as UDP and TCP sockets. Replaces any filter already attached.
+* Frames queued before the filter was attached are still received.
+*
+* @note Only supported on Linux. Will return #TCS_ERROR_NOT_SUPPORTED on other platforms.
+*
+* @param[in] socket socket to filter.
+* @param[in] filter is the program to attach, see tcs_filter_init(). It is copied by the kernel.
+* @return #TCS_SUCCESS if successful, otherwise the error code.
+* @see tcs_opt_filter_detach()
+*/
+TcsResult tcs_opt_filter_attach(TcsSocket socket, const struct TcsFilter* filter);
+
+/**
+* @brief Remove the filter attached with tcs_opt_filter_attach().
+*
+* @note Only supported on Linux. Will return #TCS_ERROR_NOT_SUPPORTED on other platforms.
+*
+* @param[in] socket socket to remove the filter from.
+* @return #TCS_SUCCESS if successful, otherwise the error code.
+*/
+TcsResult tcs_opt_filter_detach(TcsSocket socket);
+
 /**
 * @brief List available network interfaces.
 *
@@ -1810,6 +3123,9 @@ TcsResult tcs_interface_list(struct TcsInterface out_interfaces[], size_t interf
 /**
 * @brief Resolve a hostname to one or more addresses.
 *
+* Numeric addresses are parsed without a lookup. Other hostnames are served from the address cache when it is enabled
+* with tcs_address_cache_enable(), at most #TCS_CFG_ADDRESS_CACHE_ADDRESSES_MAX addresses are returned then.
+*
 * @param[in] hostname hostname or IP string to resolve.
 * @param[in] address_family address family filter, or ::TCS_FAMILY_ANY for all.
 * @param[out] out_addresses array to receive resolved addresses, or NULL to only count.
@@ -1824,6 +3140,63 @@ TcsResult tcs_address_resolve(const char* hostname,
                               size_t addresses_length,
                               size_t* out_length);
 
+/**
+* @brief Enable an in-process cache for tcs_address_resolve() and all functions using it.
+*
+* Lookups are keyed by hostname, compared case insensitively, and address family. Successful lookups are kept for
+* @p positive_ttl_ms and failed lookups (#TCS_ERROR_ADDRESS_LOOKUP_FAILED) for @p negative_ttl_ms, other errors are
+* never cached. The system resolver does not report DNS TTLs, so the same TTL is used for all hostnames. When the cache
+* is full the least recently used entry is evicted. The cache is thread safe, calling this again replaces the cache
+* with an empty one.
+*
+* @code
+* tcs_address_cache_enable(256, 60000, 5000);
+* tcs_socket_tcp_str(&socket, NULL, "example.com:80", 1000); // Resolved with getaddrinfo()
+* tcs_socket_tcp_str(&other, NULL, "example.com:80", 1000);  // Resolved from the cache
+* tcs_address_cache_disable();
+* @endcode
+*
+* @param[in] max_entries maximum number of cached hostname and family pairs.
+* @param[in] positive_ttl_ms lifetime of successful lookups, 0 to not cache them or #TCS_WAIT_INF to never expire.
+* @param[in] negative_ttl_ms lifetime of failed lookups, 0 to not cache them or #TCS_WAIT_INF to never expire.
+* @return #TCS_SUCCESS if successful, otherwise the error code.
+* @see tcs_address_cache_disable()
+*/
+TcsResult tcs_address_cache_enable(size_t max_entries, int positive_ttl_ms, int negative_ttl_ms);
+
+/**
+* @brief Disable the address cache and free its memory. Lookups go to the system resolver again.
+*
+* @return #TCS_SUCCESS if successful, otherwise the error code.
+*/
+TcsResult tcs_address_cache_disable(void);
+
+/**
+* @brief Insert or replace a cache entry, e.g. to warm up the cache at startup or to pin a hostname to addresses.
+*
+* @param[in] hostname the name given to tcs_address_resolve().
+* @param[in] address_family the family given to tcs_address_resolve(), ::TCS_FAMILY_ANY is a separate entry.
+* @param[in] addresses the result of the lookup.
+* @param[in] addresses_length number of addresses, at most #TCS_CFG_ADDRESS_CACHE_ADDRESSES_MAX. 0 caches a failed
+* lookup.
+* @param[in] ttl_ms lifetime of the entry, or #TCS_WAIT_INF to keep it until it is evicted or flushed.
+* @return #TCS_SUCCESS if successful, otherwise the error code.
+* @retval #TCS_ERROR_LIBRARY_NOT_INITIALIZED if the cache is not enabled.
+*/
+TcsResult tcs_address_cache_prefill(const char* hostname,
+                                    TcsFamily address_family,
+                                    const struct TcsAddress addresses[],
+                                    size_t addresses_length,
+                                    int ttl_ms);
+
+/**
+* @brief Remove cache entries, e.g. after a network change.
+*
+* @param[in] hostname remove the entries of all families for this hostname, or NULL to remove all entries.
+* @return #TCS_SUCCESS if successful, otherwise the error code.
+*/
+TcsResult tcs_address_cache_flush(const char* hostname);
+
 /**
 * @brief List addresses associated with network interfaces.
 *
@@ -1907,9 +3280,48 @@ TcsResult tcs_address_parse(const char str[], struct TcsAddress* out_address);
  */
 TcsResult tcs_address_to_str(const struct TcsAddress* address, char out_str[], size_t str_length, size_t* out_length);
 
+/**
+ * @brief Convert an array of addresses to one string, joined by a separator.
+ *
+ * Each address is formatted exactly as by tcs_address_to_str(). Useful for log lines listing several peers.
+ * Pass @c out_str=NULL and @c str_length=0 with @c out_length set to query the required size.
+ *
+ * @code
+ * char str[256];
+ * tcs_address_to_str_many(candidates, candidates_count, ", ", str, sizeof str, NULL);
+ * @endcode
+ *
+ * @param[in] addresses the addresses to convert.
+ * @param[in] addresses_length number of elements in @p addresses.
+ * @param[in] separator null-terminated string put between two addresses, NULL for none.
+ * @param[out] out_str buffer to receive the null-terminated string.
+ * @param[in] str_length capacity of @c out_str in bytes.
+ * @param[out] out_length receives the length of the whole string excluding the null terminator. May be NULL.
+ * @return #TCS_SUCCESS if successful, #TCS_ERROR_MEMORY if @c out_str is too small, otherwise the error code.
+ * @see tcs_address_to_str()
+ */
+TcsResult tcs_address_to_str_many(const struct TcsAddress addresses[],
+                                  size_t addresses_length,
+                                  const char* separator,
+                                  char out_str[],
+                                  size_t str_length,
+                                  size_t* out_length);
+
 /** @brief Check if two addresses are equal. Returns false for NULL, mismatched, unknown, or unsupported address families. */
 bool tcs_address_is_equal(const struct TcsAddress* l, const struct TcsAddress* r);
 
+/**
+ * @brief Hash an address for use in hash tables.
+ *
+ * Only the fields compared by tcs_address_is_equal() are hashed, so equal addresses always have equal hashes. Like
+ * tcs_address_is_equal(), the IPv6 scope id is not part of the hash.
+ *
+ * @param[in] address the address to hash. NULL hashes to a value derived from @p seed only.
+ * @param[in] seed varies the hash function. Use a random seed per table when peers choose the addresses.
+ * @return a 64 bit hash where all bits depend on the address, so masking off the low bits is fine.
+ */
+uint64_t tcs_address_hash(const struct TcsAddress* address, uint64_t seed);
+
 /** @brief Check if the address is a wildcard (any) address. Returns false for NULL, unknown, or unsupported address families. */
 bool tcs_address_is_any(const struct TcsAddress* addr);
 
@@ -1928,6 +3340,68 @@ bool tcs_address_is_broadcast(const struct TcsAddress* addr);
 /** @brief Check if the address family is known and supported by this platform. Returns false for NULL or unknown families. */
 bool tcs_address_is_supported(const struct TcsAddress* addr);
 
+/**
+ * @brief Create a hash map from addresses to user pointers, for example per peer state of a UDP server.
+ *
+ * Lookups take constant time on average. Keys are compared with tcs_address_is_equal() and hashed with
+ * tcs_address_hash() using a random seed per map. The map is not thread safe.
+ *
+ * @code
+ * struct Peer* peer = (struct Peer*)tcs_address_map_get(peers, &source);
+ * if (peer == NULL)
+ * {
+ *     peer = peer_create();
+ *     tcs_address_map_set(peers, &source, peer);
+ * }
+ * @endcode
+ *
+ * @param[out] out_map receives the new map, free it with tcs_address_map_destroy().
+ * @param[in] capacity_hint number of entries to make room for up front, 0 to grow on demand.
+ * @return #TCS_SUCCESS if successful, otherwise the error code.
+ */
+TcsResult tcs_address_map_create(struct TcsAddressMap** out_map, size_t capacity_hint);
+
+/**
+ * @brief Free a map created with tcs_address_map_create(). The values are not touched.
+ *
+ * @param[in,out] map pointer to the map, set to NULL afterwards.
+ * @return #TCS_SUCCESS if successful, otherwise the error code.
+ */
+TcsResult tcs_address_map_destroy(struct TcsAddressMap** map);
+
+/**
+ * @brief Insert an address or replace the value of an address already in the map.
+ *
+ * @param[in] map created with tcs_address_map_create().
+ * @param[in] address the key, copied into the map.
+ * @param[in] value the pointer to store.
+ * @return #TCS_SUCCESS if successful, otherwise the error code.
+ * @retval #TCS_ERROR_MEMORY if the map could not grow.
+ */
+TcsResult tcs_address_map_set(struct TcsAddressMap* map, const struct TcsAddress* address, void* value);
+
+/**
+ * @brief Look up the value of an address.
+ *
+ * @param[in] map created with tcs_address_map_create().
+ * @param[in] address the key to look up.
+ * @return the stored value, or NULL if the address is not in the map.
+ */
+void* tcs_address_map_get(const struct TcsAddressMap* map, const struct TcsAddress* address);
+
+/**
+ * @brief Remove an address from the map.
+ *
+ * @param[in] map created with tcs_address_map_create().
+ * @param[in] address the key to remove.
+ * @return #TCS_SUCCESS if successful, otherwise the error code.
+ * @retval #TCS_ERROR_INVALID_ARGUMENT if the address is not in the map.
+ */
+TcsResult tcs_address_map_remove(struct TcsAddressMap* map, const struct TcsAddress* address);
+
+/** @brief Number of addresses in the map, 0 for NULL. */
+size_t tcs_address_map_count(const struct TcsAddressMap* map);
+
 #ifdef __cplusplus
 }
 #endif
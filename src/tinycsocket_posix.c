@@ -34,6 +34,15 @@
 #include "dbg_wrap.h"
 #endif
 
+// Without TCS_CFG_THREADS locks are spinlocks on atomics so plain use does not need -pthread
+#ifndef TCS_HAS_PTHREAD
+#if TCS_CFG_THREADS || !defined(TDS_HAS_ATOMICS)
+#define TCS_HAS_PTHREAD 1
+#else
+#define TCS_HAS_PTHREAD 0
+#endif
+#endif
+
 #ifndef TCS_HAS_AF_PACKET
 #if defined(__linux__)
 #define TCS_HAS_AF_PACKET 1
@@ -42,6 +51,22 @@
 #endif
 #endif
 
+#ifndef TCS_HAS_TX_TIMESTAMPING
+#if defined(__linux__)
+#define TCS_HAS_TX_TIMESTAMPING 1
+#else
+#define TCS_HAS_TX_TIMESTAMPING 0
+#endif
+#endif
+
+#ifndef TCS_HAS_SOCKET_FILTER
+#if defined(__linux__)
+#define TCS_HAS_SOCKET_FILTER 1
+#else
+#define TCS_HAS_SOCKET_FILTER 0
+#endif
+#endif
+
 #ifndef TCS_HAS_GETIFADDRS
 #if defined(__ANDROID__)
 #if __ANDROID_API__ >= 24
@@ -65,9 +90,9 @@
 #include <netinet/in.h>  // IPPROTO_XXP
 #include <netinet/tcp.h> // TCP_NODELAY
 #include <poll.h>        // poll()
-#include <stdlib.h>      // malloc()/free()
+#include <sched.h>       // sched_yield()
 #include <string.h>      // strcpy, memset
-#include <sys/ioctl.h>   // Flags for ifaddrs
+#include <sys/ioctl.h>   // Flags for ifaddrs, FIONBIO
 #ifdef __sun
 #include <sys/sockio.h> // SIOCGIFCONF on Solaris/illumos
 #endif
@@ -80,14 +105,53 @@
 #if TCS_HAS_GETIFADDRS
 #include <ifaddrs.h> // getifaddr()
 #endif
+#if TCS_HAS_PTHREAD
+#include <pthread.h> // pthread_mutex_t, pthread_create
+#endif
 #if TCS_HAS_AF_PACKET
 #include <linux/if_arp.h>    // sll_hatype (ethernet and not can or firewire etc.)
 #include <linux/if_packet.h> // struct sockaddr_ll
+#include <sys/mman.h>         // mmap() for packet rings
+#endif
+#if TCS_HAS_SOCKET_FILTER
+#include <linux/filter.h> // struct sock_fprog
+#endif
+
+#ifndef TCS_HAS_REUSEPORT_CBPF
+#if TCS_HAS_SOCKET_FILTER && defined(SO_ATTACH_REUSEPORT_CBPF)
+#define TCS_HAS_REUSEPORT_CBPF 1
+#else
+#define TCS_HAS_REUSEPORT_CBPF 0
+#endif
+#endif
+
+#ifndef TCS_HAS_ACCEPT4
+#if defined(__linux__) && defined(SOCK_NONBLOCK) && defined(SOCK_CLOEXEC)
+#define TCS_HAS_ACCEPT4 1
+#else
+#define TCS_HAS_ACCEPT4 0
+#endif
+#endif
+#if TCS_HAS_ACCEPT4 && defined(__GLIBC__) && !defined(__USE_GNU)
+// glibc only declares accept4() with _GNU_SOURCE
+extern int accept4(int sockfd, struct sockaddr* addr, socklen_t* addrlen, int flags);
+#endif
+#if TCS_HAS_TX_TIMESTAMPING
+#include <linux/errqueue.h>   // struct sock_extended_err, struct scm_timestamping
+#include <linux/net_tstamp.h> // SOF_TIMESTAMPING_*
+#endif
+
+#ifndef TCS_HAS_PKTINFO
+#if defined(IP_PKTINFO) && defined(IPV6_RECVPKTINFO) && defined(IPV6_PKTINFO)
+#define TCS_HAS_PKTINFO 1
+#else
+#define TCS_HAS_PKTINFO 0
+#endif
 #endif
 
 #ifndef TDS_MAP_pollfd_pvoid
 #define TDS_MAP_pollfd_pvoid
-TDS_MAP_IMPL(struct pollfd, void*, poll)
+TDS_MAP_IMPL_WITH_POLICY(struct pollfd, void*, poll, &TDS_GROWTH_POLICY_NEVER_SHRINK)
 #endif
 
 struct TcsPoll
@@ -101,6 +165,27 @@ struct TcsPoll
     } backend;
 };
 
+#if TCS_HAS_AF_PACKET
+struct TcsPacketRing
+{
+    TcsSocket socket;
+    int ring_option; // PACKET_RX_RING or PACKET_TX_RING
+    uint8_t* map;
+    size_t map_size;
+    size_t block_size;
+    size_t block_count;
+    size_t current_block;
+    uint8_t* next_frame; // NULL until the current block is handed to us
+    uint32_t frames_left;
+    // Transmit rings are addressed per frame
+    size_t frame_size;
+    size_t frames_per_block;
+    size_t frame_count;
+    size_t current_frame;
+    bool is_frame_acquired;
+};
+#endif
+
 const TcsSocket TCS_SOCKET_INVALID = -1;
 const int32_t TCS_WAIT_INF = -1;
 
@@ -138,6 +223,9 @@ const uint32_t TCS_MSG_WAITALL = MSG_WAITALL;
 // Send flags
 const uint32_t TCS_MSG_SENDALL = 0x80000000;
 
+// Send and recv flags
+const uint32_t TCS_MSG_DONTWAIT = MSG_DONTWAIT;
+
 // Backlog
 const int TCS_BACKLOG_MAX = SOMAXCONN;
 
@@ -351,6 +439,386 @@ static TcsResult native2sockaddr(const struct sockaddr* in_addr, struct TcsAddre
     return TCS_SUCCESS;
 }
 
+#if TCS_HAS_PKTINFO
+// Same layout as RFC 3542 struct in6_pktinfo, which glibc hides behind _GNU_SOURCE
+struct tcs_in6_pktinfo
+{
+    struct in6_addr ipi6_addr;
+    unsigned int ipi6_ifindex;
+};
+
+// Large enough and aligned for one IP_PKTINFO or IPV6_PKTINFO control message
+union tcs_pktinfo_control
+{
+    char buffer[CMSG_SPACE(sizeof(struct tcs_in6_pktinfo)) > CMSG_SPACE(sizeof(struct in_pktinfo))
+                    ? CMSG_SPACE(sizeof(struct tcs_in6_pktinfo))
+                    : CMSG_SPACE(sizeof(struct in_pktinfo))];
+    struct cmsghdr align;
+};
+#endif
+
+// ######## OS Primitives ########
+
+// Used by tinycsocket_common.c, see the declarations there
+
+size_t tcs_os_steering_cpu_count(void)
+{
+#if TCS_HAS_REUSEPORT_CBPF
+    // Configured, not online, CPUs since SO_INCOMING_CPU ids may be sparse
+    long cpu_count = sysconf(_SC_NPROCESSORS_CONF);
+    return cpu_count > 0 ? (size_t)cpu_count : 0;
+#else
+    return 0;
+#endif
+}
+
+#ifdef TDS_HAS_ATOMICS
+// Only for short critical sections, a waiter gives up its time slice instead of sleeping
+static void os_spin_lock(TdsAtomicSize* lock)
+{
+    size_t expected = 0;
+    while (!tds_atomic_compare_exchange(lock, &expected, 1))
+    {
+        sched_yield();
+        expected = 0;
+    }
+}
+
+static void os_spin_unlock(TdsAtomicSize* lock)
+{
+    tds_atomic_store_release(lock, 0);
+}
+#endif
+
+#if TCS_HAS_PTHREAD
+struct TcsOsMutex
+{
+    pthread_mutex_t mutex;
+};
+
+TcsResult tcs_os_mutex_create(struct TcsOsMutex** out_mutex)
+{
+    struct TcsOsMutex* mutex = (struct TcsOsMutex*)tcs_lib_malloc(sizeof(struct TcsOsMutex));
+    if (mutex == NULL)
+        return TCS_ERROR_MEMORY;
+    int sts = pthread_mutex_init(&mutex->mutex, NULL);
+    if (sts != 0)
+    {
+        tcs_lib_free(mutex);
+        return errno2retcode(sts);
+    }
+    *out_mutex = mutex;
+    return TCS_SUCCESS;
+}
+
+void tcs_os_mutex_destroy(struct TcsOsMutex** mutex)
+{
+    pthread_mutex_destroy(&(*mutex)->mutex);
+    tcs_lib_free(*mutex);
+    *mutex = NULL;
+}
+
+void tcs_os_mutex_lock(struct TcsOsMutex* mutex)
+{
+    pthread_mutex_lock(&mutex->mutex);
+}
+
+void tcs_os_mutex_unlock(struct TcsOsMutex* mutex)
+{
+    pthread_mutex_unlock(&mutex->mutex);
+}
+#else
+struct TcsOsMutex
+{
+    TdsAtomicSize is_locked;
+};
+
+TcsResult tcs_os_mutex_create(struct TcsOsMutex** out_mutex)
+{
+    struct TcsOsMutex* mutex = (struct TcsOsMutex*)tcs_lib_malloc(sizeof(struct TcsOsMutex));
+    if (mutex == NULL)
+        return TCS_ERROR_MEMORY;
+    tds_atomic_store_relaxed(&mutex->is_locked, 0);
+    *out_mutex = mutex;
+    return TCS_SUCCESS;
+}
+
+void tcs_os_mutex_destroy(struct TcsOsMutex** mutex)
+{
+    tcs_lib_free(*mutex);
+    *mutex = NULL;
+}
+
+void tcs_os_mutex_lock(struct TcsOsMutex* mutex)
+{
+    os_spin_lock(&mutex->is_locked);
+}
+
+void tcs_os_mutex_unlock(struct TcsOsMutex* mutex)
+{
+    os_spin_unlock(&mutex->is_locked);
+}
+#endif
+
+#ifdef TDS_HAS_ATOMICS
+static TdsAtomicSize os_global_lock = 0; // Held for a few lookups in the address cache, a spinlock is enough
+
+void tcs_os_global_lock(void)
+{
+    os_spin_lock(&os_global_lock);
+}
+
+void tcs_os_global_unlock(void)
+{
+    os_spin_unlock(&os_global_lock);
+}
+#else
+static pthread_mutex_t os_global_lock = PTHREAD_MUTEX_INITIALIZER;
+
+void tcs_os_global_lock(void)
+{
+    pthread_mutex_lock(&os_global_lock);
+}
+
+void tcs_os_global_unlock(void)
+{
+    pthread_mutex_unlock(&os_global_lock);
+}
+#endif
+
+#if TCS_CFG_THREADS
+struct TcsOsThread
+{
+    pthread_t thread;
+    void (*function)(void*);
+    void* arg;
+};
+
+static void* os_thread_main(void* arg)
+{
+    struct TcsOsThread* thread = (struct TcsOsThread*)arg;
+    thread->function(thread->arg);
+    return NULL;
+}
+
+TcsResult tcs_os_thread_create(struct TcsOsThread** out_thread, void (*function)(void*), void* arg)
+{
+    struct TcsOsThread* thread = (struct TcsOsThread*)tcs_lib_malloc(sizeof(struct TcsOsThread));
+    if (thread == NULL)
+        return TCS_ERROR_MEMORY;
+    thread->function = function;
+    thread->arg = arg;
+    int sts = pthread_create(&thread->thread, NULL, os_thread_main, thread);
+    if (sts != 0)
+    {
+        tcs_lib_free(thread);
+        return errno2retcode(sts);
+    }
+    *out_thread = thread;
+    return TCS_SUCCESS;
+}
+
+void tcs_os_thread_join(struct TcsOsThread** thread)
+{
+    pthread_join((*thread)->thread, NULL);
+    tcs_lib_free(*thread);
+    *thread = NULL;
+}
+
+// Not sem_t, unnamed POSIX semaphores are missing on MacOS
+struct TcsOsSemaphore
+{
+    pthread_mutex_t lock;
+    pthread_cond_t is_posted;
+    size_t count;
+};
+
+TcsResult tcs_os_semaphore_create(struct TcsOsSemaphore** out_semaphore)
+{
+    struct TcsOsSemaphore* semaphore = (struct TcsOsSemaphore*)tcs_lib_malloc(sizeof(struct TcsOsSemaphore));
+    if (semaphore == NULL)
+        return TCS_ERROR_MEMORY;
+    semaphore->count = 0;
+    int sts = pthread_mutex_init(&semaphore->lock, NULL);
+    if (sts != 0)
+    {
+        tcs_lib_free(semaphore);
+        return errno2retcode(sts);
+    }
+    sts = pthread_cond_init(&semaphore->is_posted, NULL);
+    if (sts != 0)
+    {
+        pthread_mutex_destroy(&semaphore->lock);
+        tcs_lib_free(semaphore);
+        return errno2retcode(sts);
+    }
+    *out_semaphore = semaphore;
+    return TCS_SUCCESS;
+}
+
+void tcs_os_semaphore_destroy(struct TcsOsSemaphore** semaphore)
+{
+    pthread_cond_destroy(&(*semaphore)->is_posted);
+    pthread_mutex_destroy(&(*semaphore)->lock);
+    tcs_lib_free(*semaphore);
+    *semaphore = NULL;
+}
+
+void tcs_os_semaphore_post(struct TcsOsSemaphore* semaphore)
+{
+    pthread_mutex_lock(&semaphore->lock);
+    semaphore->count++;
+    pthread_cond_signal(&semaphore->is_posted);
+    pthread_mutex_unlock(&semaphore->lock);
+}
+
+void tcs_os_semaphore_wait(struct TcsOsSemaphore* semaphore)
+{
+    pthread_mutex_lock(&semaphore->lock);
+    while (semaphore->count == 0)
+        pthread_cond_wait(&semaphore->is_posted, &semaphore->lock);
+    semaphore->count--;
+    pthread_mutex_unlock(&semaphore->lock);
+}
+#else
+struct TcsOsThread;
+struct TcsOsSemaphore;
+
+TcsResult tcs_os_thread_create(struct TcsOsThread** out_thread, void (*function)(void*), void* arg)
+{
+    (void)out_thread;
+    (void)function;
+    (void)arg;
+    return TCS_ERROR_NOT_SUPPORTED; // Build with TCS_CFG_THREADS and link with -pthread
+}
+
+void tcs_os_thread_join(struct TcsOsThread** thread)
+{
+    (void)thread;
+}
+
+TcsResult tcs_os_semaphore_create(struct TcsOsSemaphore** out_semaphore)
+{
+    (void)out_semaphore;
+    return TCS_ERROR_NOT_SUPPORTED;
+}
+
+void tcs_os_semaphore_destroy(struct TcsOsSemaphore** semaphore)
+{
+    (void)semaphore;
+}
+
+void tcs_os_semaphore_post(struct TcsOsSemaphore* semaphore)
+{
+    (void)semaphore;
+}
+
+void tcs_os_semaphore_wait(struct TcsOsSemaphore* semaphore)
+{
+    (void)semaphore;
+}
+#endif
+
+struct TcsOsWakeup
+{
+    int pipe[2]; // One byte is in the pipe while set
+};
+
+TcsResult tcs_os_wakeup_create(struct TcsOsWakeup** out_wakeup)
+{
+    struct TcsOsWakeup* wakeup = (struct TcsOsWakeup*)tcs_lib_malloc(sizeof(struct TcsOsWakeup));
+    if (wakeup == NULL)
+        return TCS_ERROR_MEMORY;
+    if (pipe(wakeup->pipe) != 0)
+    {
+        int error_code = errno;
+        tcs_lib_free(wakeup);
+        return errno2retcode(error_code);
+    }
+    for (int i = 0; i < 2; ++i)
+    {
+        fcntl(wakeup->pipe[i], F_SETFL, fcntl(wakeup->pipe[i], F_GETFL, 0) | O_NONBLOCK);
+        fcntl(wakeup->pipe[i], F_SETFD, FD_CLOEXEC);
+    }
+    *out_wakeup = wakeup;
+    return TCS_SUCCESS;
+}
+
+void tcs_os_wakeup_destroy(struct TcsOsWakeup** wakeup)
+{
+    close((*wakeup)->pipe[0]);
+    close((*wakeup)->pipe[1]);
+    tcs_lib_free(*wakeup);
+    *wakeup = NULL;
+}
+
+TcsSocket tcs_os_wakeup_socket(const struct TcsOsWakeup* wakeup)
+{
+    return wakeup->pipe[0];
+}
+
+void tcs_os_wakeup_set(struct TcsOsWakeup* wakeup, bool is_set)
+{
+    uint8_t byte = 1;
+    ssize_t sts = is_set ? write(wakeup->pipe[1], &byte, 1) : read(wakeup->pipe[0], &byte, 1);
+    (void)sts;
+}
+
+TcsResult tcs_os_connect_wait(const TcsSocket sockets[], size_t sockets_length, TcsResult out_results[], int timeout_ms)
+{
+    if (sockets_length > TCS_CFG_CONNECT_CANDIDATES_MAX)
+        return TCS_ERROR_INVALID_ARGUMENT;
+
+    struct pollfd poll_fds[TCS_CFG_CONNECT_CANDIDATES_MAX];
+    for (size_t i = 0; i < sockets_length; ++i)
+    {
+        poll_fds[i].fd = sockets[i]; // poll() ignores TCS_SOCKET_INVALID since it is negative
+        poll_fds[i].events = POLLOUT;
+        poll_fds[i].revents = 0;
+        out_results[i] = TCS_IN_PROGRESS;
+    }
+    int ready = poll(poll_fds, (nfds_t)sockets_length, timeout_ms);
+    if (ready == 0 || (ready < 0 && errno == EINTR))
+        return TCS_ERROR_TIMED_OUT;
+    if (ready < 0)
+        return errno2retcode(errno);
+
+    for (size_t i = 0; i < sockets_length; ++i)
+    {
+        if (poll_fds[i].revents == 0)
+            continue;
+        int error = 0;
+        socklen_t error_size = sizeof(error);
+        if (getsockopt(sockets[i], SOL_SOCKET, SO_ERROR, &error, &error_size) != 0)
+            error = errno;
+        out_results[i] = error == 0 ? TCS_SUCCESS : errno2retcode(error);
+    }
+    return TCS_SUCCESS;
+}
+
+// /dev/urandom and not getrandom(), which needs glibc 2.25 and is missing on older BSDs and MacOS
+TcsResult tcs_os_random(uint8_t* out_bytes, size_t length)
+{
+    int flags = O_RDONLY;
+#ifdef O_CLOEXEC
+    flags |= O_CLOEXEC;
+#endif
+    int fd = open("/dev/urandom", flags);
+    if (fd == -1)
+        return TCS_ERROR_NOT_SUPPORTED;
+    size_t done = 0;
+    while (done < length)
+    {
+        ssize_t sts = read(fd, out_bytes + done, length - done);
+        if (sts <= 0 && !(sts == -1 && errno == EINTR))
+            break;
+        if (sts > 0)
+            done += (size_t)sts;
+    }
+    close(fd);
+    return done == length ? TCS_SUCCESS : TCS_ERROR_NOT_SUPPORTED;
+}
+
 // ######## Library Management ########
 
 TcsResult tcs_lib_init(void)
@@ -367,12 +835,30 @@ TcsResult tcs_lib_cleanup(void)
     return TCS_SUCCESS;
 }
 
+int64_t tcs_time_monotonic_ms(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
 // ######## Socket Creation ########
 
 TcsResult tcs_socket(TcsSocket* out_socket, TcsFamily family, TcsSocketType type, TcsProtocol protocol)
+{
+    return tcs_socket_with_flags(out_socket, family, type, protocol, TCS_FLAG_NONE);
+}
+
+TcsResult tcs_socket_with_flags(TcsSocket* out_socket,
+                                TcsFamily family,
+                                TcsSocketType type,
+                                TcsProtocol protocol,
+                                uint32_t flags)
 {
     if (out_socket == NULL || *out_socket != TCS_SOCKET_INVALID)
         return TCS_ERROR_INVALID_ARGUMENT;
+    if ((flags & ~(TCS_SOCKET_FLAG_NONBLOCKING | TCS_SOCKET_FLAG_CLOEXEC)) != 0)
+        return TCS_ERROR_INVALID_ARGUMENT;
     if (family.native == -1) // sentinel for unsupported families (e.g. TCS_FAMILY_PACKET on non-Linux)
         return TCS_ERROR_NOT_SUPPORTED;
 #if TCS_HAS_AF_PACKET
@@ -380,12 +866,32 @@ TcsResult tcs_socket(TcsSocket* out_socket, TcsFamily family, TcsSocketType type
 #else
     int native_protocol = (int)protocol;
 #endif
-    *out_socket = socket(family.native, type.native, native_protocol);
+    int native_type = type.native;
+#if defined(SOCK_NONBLOCK) && defined(SOCK_CLOEXEC)
+    if (flags & TCS_SOCKET_FLAG_NONBLOCKING)
+        native_type |= SOCK_NONBLOCK;
+    if (flags & TCS_SOCKET_FLAG_CLOEXEC)
+        native_type |= SOCK_CLOEXEC;
+#endif
+    *out_socket = socket(family.native, native_type, native_protocol);
 
-    if (*out_socket != -1) // Same as TCS_NULLSOCKET
-        return TCS_SUCCESS;
-    else
+    if (*out_socket == -1) // Same as TCS_NULLSOCKET
         return errno2retcode(errno);
+
+#if !defined(SOCK_NONBLOCK) || !defined(SOCK_CLOEXEC)
+    // No creation flags (e.g. macOS), set them afterwards
+    TcsResult res = TCS_SUCCESS;
+    if (flags & TCS_SOCKET_FLAG_NONBLOCKING)
+        res = tcs_opt_nonblocking_set(*out_socket, true);
+    if (res == TCS_SUCCESS && (flags & TCS_SOCKET_FLAG_CLOEXEC) && fcntl(*out_socket, F_SETFD, FD_CLOEXEC) == -1)
+        res = errno2retcode(errno);
+    if (res != TCS_SUCCESS)
+    {
+        tcs_close(out_socket);
+        return res;
+    }
+#endif
+    return TCS_SUCCESS;
 }
 
 // tcs_socket_tcp() is defined in tinycsocket_common.c
@@ -395,6 +901,8 @@ TcsResult tcs_socket(TcsSocket* out_socket, TcsFamily family, TcsSocketType type
 // tcs_socket_packet() is defined in tinycsocket_common.c
 // tcs_socket_packet_str() is defined in tinycsocket_common.c
 
+// tcs_socket_per_cpu() is defined in tinycsocket_common.c
+
 TcsResult tcs_close(TcsSocket* socket)
 {
     if (socket == NULL || *socket == TCS_SOCKET_INVALID)
@@ -455,31 +963,95 @@ TcsResult tcs_connect(TcsSocket socket, const struct TcsAddress* address)
 
 // tcs_connect_str() is defined in tinycsocket_common.c
 
-TcsResult tcs_listen(TcsSocket socket, int backlog)
+static TcsResult connect_wait(TcsSocket socket, int timeout_ms)
 {
-    if (socket == TCS_SOCKET_INVALID)
-        return TCS_ERROR_INVALID_ARGUMENT;
+    struct pollfd poll_fd;
+    poll_fd.fd = socket;
+    poll_fd.events = POLLOUT;
+    poll_fd.revents = 0;
 
-    if (backlog < 1 || backlog > TCS_BACKLOG_MAX)
-        backlog = TCS_BACKLOG_MAX;
+    const int64_t deadline = tcs_time_monotonic_ms() + timeout_ms;
+    int remaining_ms = timeout_ms;
+    for (;;)
+    {
+        int ready = poll(&poll_fd, 1, remaining_ms);
+        if (ready > 0)
+            break;
+        if (ready == 0)
+            return TCS_ERROR_TIMED_OUT;
+        if (errno != EINTR)
+            return errno2retcode(errno);
+        int64_t left_ms = deadline - tcs_time_monotonic_ms();
+        remaining_ms = left_ms > 0 ? (int)left_ms : 0;
+    }
 
-    if (listen(socket, backlog) == 0)
-        return TCS_SUCCESS;
-    else
+    int error = 0;
+    socklen_t error_size = sizeof(error);
+    if (getsockopt(socket, SOL_SOCKET, SO_ERROR, &error, &error_size) != 0)
         return errno2retcode(errno);
+    return error == 0 ? TCS_SUCCESS : errno2retcode(error);
 }
 
-TcsResult tcs_accept(TcsSocket listener, TcsSocket* out_socket, struct TcsAddress* out_address)
+TcsResult tcs_connect_timeout(TcsSocket socket, const struct TcsAddress* address, int timeout_ms)
 {
-    if (listener == TCS_SOCKET_INVALID || out_socket == NULL || *out_socket != TCS_SOCKET_INVALID)
+    if (socket == TCS_SOCKET_INVALID || address == NULL)
         return TCS_ERROR_INVALID_ARGUMENT;
-
-    if (out_address != NULL)
-        *out_address = TCS_ADDRESS_NONE;
+    if (timeout_ms < 0 && timeout_ms != TCS_WAIT_INF)
+        return TCS_ERROR_INVALID_ARGUMENT;
+    if (timeout_ms == TCS_WAIT_INF)
+        return tcs_connect(socket, address);
 
     struct sockaddr_storage native_sockaddr;
     memset(&native_sockaddr, 0, sizeof native_sockaddr);
-    socklen_t sockaddr_size = sizeof native_sockaddr;
+    socklen_t sockaddr_size = 0;
+    TcsResult res = sockaddr2native(address, &native_sockaddr, &sockaddr_size);
+    if (res != TCS_SUCCESS)
+        return res;
+
+    int flags = fcntl(socket, F_GETFL, 0);
+    if (flags == -1)
+        return errno2retcode(errno);
+    const bool was_blocking = (flags & O_NONBLOCK) == 0;
+    if (was_blocking && fcntl(socket, F_SETFL, flags | O_NONBLOCK) == -1)
+        return errno2retcode(errno);
+
+    if (connect(socket, (const struct sockaddr*)&native_sockaddr, sockaddr_size) == 0)
+        res = TCS_SUCCESS;
+    else if (errno == EINPROGRESS)
+        res = connect_wait(socket, timeout_ms);
+    else
+        res = errno2retcode(errno);
+
+    if (was_blocking && fcntl(socket, F_SETFL, flags) == -1 && res == TCS_SUCCESS)
+        res = errno2retcode(errno);
+    return res;
+}
+
+TcsResult tcs_listen(TcsSocket socket, int backlog)
+{
+    if (socket == TCS_SOCKET_INVALID)
+        return TCS_ERROR_INVALID_ARGUMENT;
+
+    if (backlog < 1 || backlog > TCS_BACKLOG_MAX)
+        backlog = TCS_BACKLOG_MAX;
+
+    if (listen(socket, backlog) == 0)
+        return TCS_SUCCESS;
+    else
+        return errno2retcode(errno);
+}
+
+TcsResult tcs_accept(TcsSocket listener, TcsSocket* out_socket, struct TcsAddress* out_address)
+{
+    if (listener == TCS_SOCKET_INVALID || out_socket == NULL || *out_socket != TCS_SOCKET_INVALID)
+        return TCS_ERROR_INVALID_ARGUMENT;
+
+    if (out_address != NULL)
+        *out_address = TCS_ADDRESS_NONE;
+
+    struct sockaddr_storage native_sockaddr;
+    memset(&native_sockaddr, 0, sizeof native_sockaddr);
+    socklen_t sockaddr_size = sizeof native_sockaddr;
 
     *out_socket = accept(listener, (struct sockaddr*)&native_sockaddr, &sockaddr_size);
     if (*out_socket != -1)
@@ -499,6 +1071,58 @@ TcsResult tcs_accept(TcsSocket listener, TcsSocket* out_socket, struct TcsAddres
     }
 }
 
+TcsResult tcs_accept_many(TcsSocket listener,
+                          TcsSocket out_sockets[],
+                          struct TcsAddress out_addresses[],
+                          size_t sockets_length,
+                          size_t* out_accepted_count)
+{
+    if (out_accepted_count != NULL)
+        *out_accepted_count = 0;
+    if (listener == TCS_SOCKET_INVALID || out_sockets == NULL || sockets_length == 0 || out_accepted_count == NULL)
+        return TCS_ERROR_INVALID_ARGUMENT;
+
+    TcsResult res = TCS_SUCCESS;
+    size_t count = 0;
+    while (count < sockets_length)
+    {
+        struct sockaddr_storage native_sockaddr;
+        socklen_t sockaddr_size = sizeof native_sockaddr;
+        struct sockaddr* native_address = out_addresses != NULL ? (struct sockaddr*)&native_sockaddr : NULL;
+        socklen_t* native_address_size = out_addresses != NULL ? &sockaddr_size : NULL;
+#if TCS_HAS_ACCEPT4
+        int socket = accept4(listener, native_address, native_address_size, SOCK_NONBLOCK | SOCK_CLOEXEC);
+#else
+        int socket = accept(listener, native_address, native_address_size);
+        if (socket != -1 && (fcntl(socket, F_SETFL, fcntl(socket, F_GETFL, 0) | O_NONBLOCK) == -1 ||
+                             fcntl(socket, F_SETFD, FD_CLOEXEC) == -1))
+        {
+            int error = errno;
+            close(socket);
+            socket = -1;
+            errno = error;
+        }
+#endif
+        if (socket == -1)
+        {
+            if (errno == EINTR)
+                continue;
+            res = errno2retcode(errno);
+            break;
+        }
+        out_sockets[count] = socket;
+        if (out_addresses != NULL)
+        {
+            out_addresses[count] = TCS_ADDRESS_NONE;
+            native2sockaddr((struct sockaddr*)&native_sockaddr, &out_addresses[count]);
+        }
+        count++;
+    }
+
+    *out_accepted_count = count;
+    return count > 0 ? TCS_SUCCESS : res;
+}
+
 TcsResult tcs_shutdown(TcsSocket socket, TcsShutdownDirection direction)
 {
     const int LUT[] = {SHUT_RD, SHUT_WR, SHUT_RDWR};
@@ -612,6 +1236,102 @@ TcsResult tcs_send_to(TcsSocket socket,
     }
 }
 
+TcsResult tcs_send_to_from(TcsSocket socket,
+                           const uint8_t* buffer,
+                           size_t buffer_size,
+                           uint32_t flags,
+                           const struct TcsAddress* destination_address,
+                           const struct TcsAddress* source_address,
+                           TcsInterfaceId interface_id,
+                           size_t* sent_size)
+{
+    if (sent_size != NULL)
+        *sent_size = 0;
+    if (socket == TCS_SOCKET_INVALID)
+        return TCS_ERROR_INVALID_ARGUMENT;
+    if (buffer == NULL && buffer_size > 0)
+        return TCS_ERROR_INVALID_ARGUMENT;
+    if (destination_address == NULL)
+        return TCS_ERROR_INVALID_ARGUMENT;
+    if (source_address != NULL && source_address->family.native != destination_address->family.native)
+        return TCS_ERROR_INVALID_ARGUMENT;
+
+    if (flags & TCS_MSG_SENDALL)
+        return TCS_ERROR_NOT_IMPLEMENTED;
+
+    if (source_address == NULL && interface_id == 0)
+        return tcs_send_to(socket, buffer, buffer_size, flags, destination_address, sent_size);
+
+#if TCS_HAS_PKTINFO
+    struct sockaddr_storage native_sockaddr;
+    socklen_t sockaddr_size = 0;
+    TcsResult convert_addr_status = sockaddr2native(destination_address, &native_sockaddr, &sockaddr_size);
+    if (convert_addr_status != TCS_SUCCESS)
+        return convert_addr_status;
+
+    union tcs_pktinfo_control control;
+    memset(&control, 0, sizeof(control));
+
+    // We know that sendmsg() does not modify the data, so we can safely cast away the const here.
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wcast-qual"
+    struct iovec iov;
+    iov.iov_base = (void*)buffer;
+    iov.iov_len = buffer_size;
+#pragma GCC diagnostic pop
+
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_name = &native_sockaddr;
+    msg.msg_namelen = sockaddr_size;
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control.buffer;
+
+    if (destination_address->family.native == TCS_FAMILY_IPV4.native)
+    {
+        struct in_pktinfo info;
+        memset(&info, 0, sizeof(info));
+        info.ipi_ifindex = (int)interface_id;
+        if (source_address != NULL)
+            info.ipi_spec_dst.s_addr = htonl(source_address->data.ipv4.address);
+        msg.msg_controllen = CMSG_SPACE(sizeof(info));
+        struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+        cmsg->cmsg_level = IPPROTO_IP;
+        cmsg->cmsg_type = IP_PKTINFO;
+        cmsg->cmsg_len = CMSG_LEN(sizeof(info));
+        memcpy(CMSG_DATA(cmsg), &info, sizeof(info));
+    }
+    else if (destination_address->family.native == TCS_FAMILY_IPV6.native)
+    {
+        struct tcs_in6_pktinfo info;
+        memset(&info, 0, sizeof(info));
+        info.ipi6_ifindex = interface_id;
+        if (source_address != NULL)
+            memcpy(&info.ipi6_addr, source_address->data.ipv6.address.bytes, 16);
+        msg.msg_controllen = CMSG_SPACE(sizeof(info));
+        struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+        cmsg->cmsg_level = IPPROTO_IPV6;
+        cmsg->cmsg_type = IPV6_PKTINFO;
+        cmsg->cmsg_len = CMSG_LEN(sizeof(info));
+        memcpy(CMSG_DATA(cmsg), &info, sizeof(info));
+    }
+    else
+    {
+        return TCS_ERROR_NOT_SUPPORTED;
+    }
+
+    ssize_t ret = sendmsg(socket, &msg, TCS_DEFAULT_SEND_FLAGS | (int)flags);
+    if (ret < 0)
+        return errno2retcode(errno);
+    if (sent_size != NULL)
+        *sent_size = (size_t)ret;
+    return TCS_SUCCESS;
+#else
+    return TCS_ERROR_NOT_SUPPORTED;
+#endif
+}
+
 TcsResult tcs_sendv(TcsSocket socket, const struct TcsIoVec* iov, size_t iov_length, uint32_t flags, size_t* sent_size)
 {
     if (socket == TCS_SOCKET_INVALID || iov == NULL || iov_length == 0)
@@ -629,7 +1349,7 @@ TcsResult tcs_sendv(TcsSocket socket, const struct TcsIoVec* iov, size_t iov_len
 
     if (iov_length > TCS_CFG_SENDV_STACK_MAX)
     {
-        heap_iovec = (struct iovec*)malloc(sizeof(struct iovec) * iov_length);
+        heap_iovec = (struct iovec*)tcs_lib_malloc(sizeof(struct iovec) * iov_length);
         if (heap_iovec == NULL)
             return TCS_ERROR_MEMORY;
         my_iovec = heap_iovec;
@@ -639,7 +1359,7 @@ TcsResult tcs_sendv(TcsSocket socket, const struct TcsIoVec* iov, size_t iov_len
     {
         if (iov[i].buffer == NULL && iov[i].buffer_size > 0)
         {
-            free(heap_iovec);
+            tcs_lib_free(heap_iovec);
             return TCS_ERROR_INVALID_ARGUMENT;
         }
         // We know that sendmsg() does not modify the data, so we can safely cast away the const here.
@@ -668,7 +1388,7 @@ TcsResult tcs_sendv(TcsSocket socket, const struct TcsIoVec* iov, size_t iov_len
     ssize_t ret = 0;
     ret = sendmsg(socket, &msg, TCS_DEFAULT_SEND_FLAGS | (int)flags);
 
-    free(heap_iovec);
+    tcs_lib_free(heap_iovec);
 
     if (ret >= 0)
     {
@@ -721,7 +1441,7 @@ TcsResult tcs_receive(TcsSocket socket, uint8_t* buffer, size_t buffer_size, uin
         // already returns EAGAIN immediately, which the epilog converts to
         // TCS_ERROR_WOULD_BLOCK.
         int fcntl_flags = fcntl(socket, F_GETFL, 0);
-        bool is_nonblock = (fcntl_flags != -1 && (fcntl_flags & O_NONBLOCK));
+        bool is_nonblock = (fcntl_flags != -1 && (fcntl_flags & O_NONBLOCK)) || (flags & TCS_MSG_DONTWAIT);
 
         // SO_RCVTIMEO == 0 means block forever; otherwise compute monotonic deadline.
         int timeout = 0;
@@ -883,6 +1603,8 @@ TcsResult tcs_receive(TcsSocket socket, uint8_t* buffer, size_t buffer_size, uin
 #if (EAGAIN == EWOULDBLOCK)
         if (errno == EAGAIN)
         {
+            if (flags & TCS_MSG_DONTWAIT)
+                return TCS_ERROR_WOULD_BLOCK;
             int fcntl_flags = fcntl(socket, F_GETFL, 0);
             if (fcntl_flags == -1)
                 return errno2retcode(errno);
@@ -943,9 +1665,183 @@ TcsResult tcs_receive_from(TcsSocket socket,
     }
 }
 
+TcsResult tcs_receive_from_to(TcsSocket socket,
+                              uint8_t* buffer,
+                              size_t buffer_size,
+                              uint32_t flags,
+                              struct TcsAddress* source_address,
+                              struct TcsAddress* destination_address,
+                              TcsInterfaceId* interface_id,
+                              size_t* received_size)
+{
+    if (received_size != NULL)
+        *received_size = 0;
+    if (destination_address != NULL)
+        *destination_address = TCS_ADDRESS_NONE;
+    if (interface_id != NULL)
+        *interface_id = 0;
+    if (socket == TCS_SOCKET_INVALID)
+        return TCS_ERROR_INVALID_ARGUMENT;
+    if (buffer == NULL && buffer_size > 0)
+        return TCS_ERROR_INVALID_ARGUMENT;
+
+#if TCS_HAS_PKTINFO
+    struct sockaddr_storage native_sockaddr;
+    memset(&native_sockaddr, 0, sizeof native_sockaddr);
+
+    union tcs_pktinfo_control control;
+    struct iovec iov;
+    iov.iov_base = buffer;
+    iov.iov_len = buffer_size;
+
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_name = &native_sockaddr;
+    msg.msg_namelen = sizeof(native_sockaddr);
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control.buffer;
+    msg.msg_controllen = sizeof(control.buffer);
+
+    ssize_t recvmsg_status = recvmsg(socket, &msg, TCS_DEFAULT_RECV_FLAGS | (int)flags);
+    if (recvmsg_status < 0)
+        return errno2retcode(errno);
+
+    if (received_size != NULL)
+        *received_size = (size_t)recvmsg_status;
+
+    for (struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg); cmsg != NULL; cmsg = CMSG_NXTHDR(&msg, cmsg))
+    {
+        if (cmsg->cmsg_level == IPPROTO_IP && cmsg->cmsg_type == IP_PKTINFO)
+        {
+            struct in_pktinfo info;
+            memcpy(&info, CMSG_DATA(cmsg), sizeof(info));
+            if (destination_address != NULL)
+            {
+                destination_address->family = TCS_FAMILY_IPV4;
+                destination_address->data.ipv4.address = ntohl(info.ipi_addr.s_addr);
+            }
+            if (interface_id != NULL)
+                *interface_id = (TcsInterfaceId)info.ipi_ifindex;
+        }
+        else if (cmsg->cmsg_level == IPPROTO_IPV6 && cmsg->cmsg_type == IPV6_PKTINFO)
+        {
+            struct tcs_in6_pktinfo info;
+            memcpy(&info, CMSG_DATA(cmsg), sizeof(info));
+            if (destination_address != NULL)
+            {
+                destination_address->family = TCS_FAMILY_IPV6;
+                memcpy(destination_address->data.ipv6.address.bytes, &info.ipi6_addr, 16);
+                destination_address->data.ipv6.scope_id = info.ipi6_ifindex;
+            }
+            if (interface_id != NULL)
+                *interface_id = info.ipi6_ifindex;
+        }
+    }
+
+    if (recvmsg_status == 0)
+    {
+        TcsSocketType sock_type = {0};
+        if (tcs_opt_type_get(socket, &sock_type) == TCS_SUCCESS && sock_type.native == TCS_SOCKET_STREAM.native)
+            return TCS_SHUTDOWN;
+        return TCS_SUCCESS;
+    }
+    if (source_address != NULL)
+        return native2sockaddr((struct sockaddr*)&native_sockaddr, source_address);
+    return TCS_SUCCESS;
+#else
+    (void)flags;
+    (void)source_address;
+    return TCS_ERROR_NOT_SUPPORTED;
+#endif
+}
+
 // tcs_receive_line() is defined in tinycsocket_common.c
 // tcs_receive_netstring() is defined in tinycsocket_common.c
 
+TcsResult tcs_receive_tx_timestamps(TcsSocket socket,
+                                    struct TcsTxTimestamp out_timestamps[],
+                                    size_t timestamps_length,
+                                    size_t* out_length)
+{
+    if (out_length != NULL)
+        *out_length = 0;
+    if (socket == TCS_SOCKET_INVALID || out_timestamps == NULL || timestamps_length == 0 || out_length == NULL)
+        return TCS_ERROR_INVALID_ARGUMENT;
+
+#if TCS_HAS_TX_TIMESTAMPING
+    size_t filled = 0;
+    while (filled < timestamps_length)
+    {
+        union
+        {
+            char buffer[CMSG_SPACE(sizeof(struct scm_timestamping)) +
+                        CMSG_SPACE(sizeof(struct sock_extended_err) + sizeof(struct sockaddr_in6))];
+            struct cmsghdr align;
+        } control;
+        uint8_t payload[1]; // Only the control messages are of interest, the looped payload is truncated
+        struct iovec iov;
+        iov.iov_base = payload;
+        iov.iov_len = sizeof(payload);
+
+        struct msghdr msg;
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_iov = &iov;
+        msg.msg_iovlen = 1;
+        msg.msg_control = control.buffer;
+        msg.msg_controllen = sizeof(control.buffer);
+
+        ssize_t recv_status = recvmsg(socket, &msg, MSG_ERRQUEUE | MSG_DONTWAIT);
+        if (recv_status < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            if (filled > 0)
+                break;
+            return errno2retcode(errno);
+        }
+
+        bool has_timestamp = false;
+        bool has_id = false;
+        struct TcsTxTimestamp entry = {0, 0};
+        for (struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg); cmsg != NULL; cmsg = CMSG_NXTHDR(&msg, cmsg))
+        {
+            bool is_extended_error = (cmsg->cmsg_level == IPPROTO_IP && cmsg->cmsg_type == IP_RECVERR) ||
+                                     (cmsg->cmsg_level == IPPROTO_IPV6 && cmsg->cmsg_type == IPV6_RECVERR);
+#if TCS_HAS_AF_PACKET
+            is_extended_error |= cmsg->cmsg_level == SOL_PACKET && cmsg->cmsg_type == PACKET_TX_TIMESTAMP;
+#endif
+            if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_TIMESTAMPING)
+            {
+                struct scm_timestamping timestamps;
+                memcpy(&timestamps, CMSG_DATA(cmsg), sizeof(timestamps));
+                // Index 0 holds the software timestamp, 1 is deprecated and 2 is the hardware timestamp
+                entry.timestamp_ns = (int64_t)timestamps.ts[0].tv_sec * 1000000000LL + timestamps.ts[0].tv_nsec;
+                has_timestamp = true;
+            }
+            else if (is_extended_error)
+            {
+                struct sock_extended_err error;
+                memcpy(&error, CMSG_DATA(cmsg), sizeof(error));
+                if (error.ee_errno == ENOMSG && error.ee_origin == SO_EE_ORIGIN_TIMESTAMPING)
+                {
+                    entry.id = error.ee_data;
+                    has_id = true;
+                }
+            }
+        }
+
+        // Other error queue entries, e.g. ICMP errors when IP_RECVERR is enabled, are consumed and skipped
+        if (has_timestamp && has_id)
+            out_timestamps[filled++] = entry;
+    }
+    *out_length = filled;
+    return TCS_SUCCESS;
+#else
+    return TCS_ERROR_NOT_SUPPORTED;
+#endif
+}
+
 // ######## Socket Polling ########
 
 TcsResult tcs_poll_create(struct TcsPoll** out_poll)
@@ -953,14 +1849,14 @@ TcsResult tcs_poll_create(struct TcsPoll** out_poll)
     if (out_poll == NULL || *out_poll != NULL)
         return TCS_ERROR_INVALID_ARGUMENT;
 
-    *out_poll = (struct TcsPoll*)malloc(sizeof(struct TcsPoll));
+    *out_poll = (struct TcsPoll*)tcs_lib_malloc(sizeof(struct TcsPoll));
     if (*out_poll == NULL)
         return TCS_ERROR_MEMORY;
     memset(*out_poll, 0, sizeof(struct TcsPoll));
 
     if (tds_map_poll_create(&(*out_poll)->backend.poll.map) != 0)
     {
-        free(*out_poll);
+        tcs_lib_free(*out_poll);
         *out_poll = NULL;
         return TCS_ERROR_MEMORY;
     }
@@ -978,7 +1874,7 @@ TcsResult tcs_poll_destroy(struct TcsPoll** ctx)
         return TCS_ERROR_MEMORY;
     }
 
-    free(*ctx);
+    tcs_lib_free(*ctx);
     *ctx = NULL;
 
     return TCS_SUCCESS;
@@ -1036,89 +1932,456 @@ TcsResult tcs_poll_modify(struct TcsPoll* ctx, TcsSocket socket, uint32_t flags)
 
 TcsResult tcs_poll_remove(struct TcsPoll* ctx, TcsSocket socket)
 {
-    if (ctx == NULL)
-        return TCS_ERROR_INVALID_ARGUMENT;
-    if (socket == TCS_SOCKET_INVALID)
+    if (ctx == NULL)
+        return TCS_ERROR_INVALID_ARGUMENT;
+    if (socket == TCS_SOCKET_INVALID)
+        return TCS_ERROR_INVALID_ARGUMENT;
+    struct TdsMap_poll const* map = &ctx->backend.poll.map;
+
+    bool found = false;
+    for (size_t i = 0; i < map->count; ++i)
+    {
+        if (socket == map->keys[i].fd)
+        {
+            if (tds_map_poll_remove(&ctx->backend.poll.map, i) != 0)
+                return TCS_ERROR_MEMORY;
+            found = true;
+            break;
+        }
+    }
+    if (!found)
+        return TCS_ERROR_INVALID_ARGUMENT;
+
+    return TCS_SUCCESS;
+}
+
+TcsResult tcs_poll_wait(struct TcsPoll* poll_ctx,
+                        struct TcsPollEvent* out_events,
+                        size_t events_length,
+                        size_t* out_events_length,
+                        int timeout_ms)
+{
+    if (poll_ctx == NULL || out_events == NULL || out_events_length == NULL)
+        return TCS_ERROR_INVALID_ARGUMENT;
+    if (timeout_ms < 0 && timeout_ms != TCS_WAIT_INF)
+        return TCS_ERROR_INVALID_ARGUMENT;
+
+    struct TdsMap_poll* map = &poll_ctx->backend.poll.map;
+
+    int poll_ret = poll(map->keys, map->count, timeout_ms);
+    *out_events_length = 0;
+    if (poll_ret < 0)
+    {
+        return errno2retcode(errno);
+    }
+    if ((size_t)poll_ret > map->count)
+    {
+        return TCS_ERROR_UNKNOWN; // Corruption
+    }
+
+    int fill_max = poll_ret > (int)events_length ? (int)events_length : poll_ret; // min(ret, events_length)
+    int filled = 0;
+    for (size_t i = 0; filled < fill_max; ++i)
+    {
+        if (i >= map->count)
+            return TCS_ERROR_UNKNOWN;
+
+        if (map->keys[i].revents != 0)
+        {
+            out_events[filled].socket = map->keys[i].fd;
+            out_events[filled].user_data = map->values[i];
+            out_events[filled].can_read = map->keys[i].revents & POLLIN;
+            out_events[filled].can_write = map->keys[i].revents & POLLOUT;
+            out_events[filled].can_read_error_queue = false;
+            if (map->keys[i].revents & (POLLERR | POLLHUP))
+            {
+                int so_error = 0;
+                socklen_t so_error_size = sizeof(so_error);
+                TcsResult fallback = (map->keys[i].revents & POLLERR) ? TCS_ERROR_UNKNOWN : TCS_ERROR_SOCKET_CLOSED;
+#if TCS_HAS_TX_TIMESTAMPING
+                // POLLERR without a pending socket error means that the error queue has entries, e.g. timestamps
+                if (map->keys[i].revents & POLLERR)
+                    fallback = (map->keys[i].revents & POLLHUP) ? TCS_ERROR_SOCKET_CLOSED : TCS_SUCCESS;
+#endif
+                if (getsockopt(map->keys[i].fd, SOL_SOCKET, SO_ERROR, &so_error, &so_error_size) != 0)
+                    out_events[filled].error = errno2retcode(errno);
+                else
+                    out_events[filled].error = so_error != 0 ? errno2retcode(so_error) : fallback;
+#if TCS_HAS_TX_TIMESTAMPING
+                out_events[filled].can_read_error_queue = so_error == 0 && (map->keys[i].revents & POLLERR);
+#endif
+            }
+            else
+            {
+                out_events[filled].error = TCS_SUCCESS;
+            }
+            map->keys[i].revents = 0;
+            ++filled;
+        }
+    }
+    *out_events_length = (size_t)filled;
+
+    if (poll_ret == 0)
+        return TCS_ERROR_TIMED_OUT;
+    return TCS_SUCCESS;
+}
+
+// ######## Connection Pool ########
+
+// tcs_pool_create() is defined in tinycsocket_common.c
+// tcs_pool_destroy() is defined in tinycsocket_common.c
+// tcs_pool_acquire() is defined in tinycsocket_common.c
+// tcs_pool_release() is defined in tinycsocket_common.c
+
+// ######## Asynchronous Resolve ########
+
+// tcs_resolver_create() is defined in tinycsocket_common.c
+// tcs_resolver_destroy() is defined in tinycsocket_common.c
+// tcs_resolver_socket() is defined in tinycsocket_common.c
+// tcs_resolver_submit() is defined in tinycsocket_common.c
+// tcs_resolver_take() is defined in tinycsocket_common.c
+// tcs_resolver_cancel() is defined in tinycsocket_common.c
+
+// ######## Packet Rings ########
+
+#if TCS_HAS_AF_PACKET
+static void packet_ring_unset(TcsSocket socket, int ring_option)
+{
+    struct tpacket_req3 req;
+    memset(&req, 0, sizeof(req));
+    setsockopt(socket, SOL_PACKET, ring_option, &req, sizeof(req));
+}
+#endif
+
+TcsResult tcs_packet_ring_rx_create(struct TcsPacketRing** out_ring,
+                                    TcsSocket socket,
+                                    size_t block_size,
+                                    size_t block_count,
+                                    size_t frame_size,
+                                    int block_timeout_ms)
+{
+    if (out_ring == NULL || *out_ring != NULL || socket == TCS_SOCKET_INVALID)
+        return TCS_ERROR_INVALID_ARGUMENT;
+    if (block_timeout_ms < 0)
+        return TCS_ERROR_INVALID_ARGUMENT;
+
+#if TCS_HAS_AF_PACKET
+    long page_size = sysconf(_SC_PAGESIZE);
+    if (page_size <= 0)
+        return TCS_ERROR_SYSTEM;
+    if (block_size == 0 || block_size % (size_t)page_size != 0 || block_size > UINT_MAX)
+        return TCS_ERROR_INVALID_ARGUMENT;
+    // TPACKET_ALIGN() in the kernel header mixes int and size_t
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wsign-conversion"
+    const size_t min_frame_size = TPACKET3_HDRLEN;
+#pragma GCC diagnostic pop
+    if (frame_size < min_frame_size || frame_size % TPACKET_ALIGNMENT != 0 || frame_size > block_size)
+        return TCS_ERROR_INVALID_ARGUMENT;
+    if (block_count == 0 || block_count > UINT_MAX / (block_size / frame_size) || block_count > SIZE_MAX / block_size)
+        return TCS_ERROR_INVALID_ARGUMENT;
+
+    int version = TPACKET_V3;
+    if (setsockopt(socket, SOL_PACKET, PACKET_VERSION, &version, sizeof(version)) != 0)
+        return errno == EBUSY ? TCS_ERROR_INVALID_ARGUMENT : errno2retcode(errno); // EBUSY: the socket has a ring
+
+    struct tpacket_req3 req;
+    memset(&req, 0, sizeof(req));
+    req.tp_block_size = (unsigned int)block_size;
+    req.tp_block_nr = (unsigned int)block_count;
+    req.tp_frame_size = (unsigned int)frame_size;
+    req.tp_frame_nr = (unsigned int)(block_size / frame_size * block_count);
+    req.tp_retire_blk_tov = (unsigned int)block_timeout_ms;
+    if (setsockopt(socket, SOL_PACKET, PACKET_RX_RING, &req, sizeof(req)) != 0)
+        return errno2retcode(errno);
+
+    size_t map_size = block_size * block_count;
+    void* map = mmap(NULL, map_size, PROT_READ | PROT_WRITE, MAP_SHARED, socket, 0);
+    if (map == MAP_FAILED)
+    {
+        TcsResult sts = errno2retcode(errno);
+        packet_ring_unset(socket, PACKET_RX_RING);
+        return sts;
+    }
+
+    struct TcsPacketRing* ring = (struct TcsPacketRing*)tcs_lib_malloc(sizeof(struct TcsPacketRing));
+    if (ring == NULL)
+    {
+        munmap(map, map_size);
+        packet_ring_unset(socket, PACKET_RX_RING);
+        return TCS_ERROR_MEMORY;
+    }
+    memset(ring, 0, sizeof(struct TcsPacketRing));
+    ring->socket = socket;
+    ring->ring_option = PACKET_RX_RING;
+    ring->map = (uint8_t*)map;
+    ring->map_size = map_size;
+    ring->block_size = block_size;
+    ring->block_count = block_count;
+
+    *out_ring = ring;
+    return TCS_SUCCESS;
+#else
+    (void)block_size;
+    (void)block_count;
+    (void)frame_size;
+    return TCS_ERROR_NOT_SUPPORTED;
+#endif
+}
+
+TcsResult tcs_packet_ring_destroy(struct TcsPacketRing** ring)
+{
+    if (ring == NULL || *ring == NULL)
+        return TCS_ERROR_INVALID_ARGUMENT;
+
+#if TCS_HAS_AF_PACKET
+    munmap((*ring)->map, (*ring)->map_size);
+    packet_ring_unset((*ring)->socket, (*ring)->ring_option);
+    tcs_lib_free(*ring);
+    *ring = NULL;
+    return TCS_SUCCESS;
+#else
+    return TCS_ERROR_NOT_SUPPORTED;
+#endif
+}
+
+TcsResult tcs_packet_ring_rx_next(struct TcsPacketRing* ring, struct TcsPacketFrame* out_frame)
+{
+    if (ring == NULL || out_frame == NULL)
+        return TCS_ERROR_INVALID_ARGUMENT;
+
+#if TCS_HAS_AF_PACKET
+    if (ring->ring_option != PACKET_RX_RING)
+        return TCS_ERROR_INVALID_ARGUMENT;
+
+    if (ring->next_frame == NULL)
+    {
+        struct tpacket_block_desc* block =
+            (struct tpacket_block_desc*)(void*)(ring->map + ring->current_block * ring->block_size);
+        // Acquire pairs with the kernel publishing the block, the frames must not be read before the status
+        if ((__atomic_load_n(&block->hdr.bh1.block_status, __ATOMIC_ACQUIRE) & TP_STATUS_USER) == 0)
+            return TCS_ERROR_WOULD_BLOCK;
+        ring->frames_left = block->hdr.bh1.num_pkts;
+        ring->next_frame = (uint8_t*)block + block->hdr.bh1.offset_to_first_pkt;
+    }
+
+    if (ring->frames_left == 0)
+        return TCS_AGAIN;
+
+    struct tpacket3_hdr const* header = (struct tpacket3_hdr const*)(void*)ring->next_frame;
+    out_frame->data = ring->next_frame + header->tp_mac;
+    out_frame->size = header->tp_snaplen;
+    out_frame->original_size = header->tp_len;
+    out_frame->timestamp_ns = (int64_t)header->tp_sec * 1000000000LL + header->tp_nsec;
+
+    ring->next_frame += header->tp_next_offset;
+    ring->frames_left--;
+    return TCS_SUCCESS;
+#else
+    return TCS_ERROR_NOT_SUPPORTED;
+#endif
+}
+
+TcsResult tcs_packet_ring_rx_release(struct TcsPacketRing* ring)
+{
+    if (ring == NULL)
+        return TCS_ERROR_INVALID_ARGUMENT;
+
+#if TCS_HAS_AF_PACKET
+    if (ring->ring_option != PACKET_RX_RING)
+        return TCS_ERROR_INVALID_ARGUMENT;
+    if (ring->next_frame == NULL)
+        return TCS_SUCCESS; // No block is held
+
+    struct tpacket_block_desc* block =
+        (struct tpacket_block_desc*)(void*)(ring->map + ring->current_block * ring->block_size);
+    __atomic_store_n(&block->hdr.bh1.block_status, TP_STATUS_KERNEL, __ATOMIC_RELEASE);
+
+    ring->current_block = (ring->current_block + 1) % ring->block_count;
+    ring->next_frame = NULL;
+    ring->frames_left = 0;
+    return TCS_SUCCESS;
+#else
+    return TCS_ERROR_NOT_SUPPORTED;
+#endif
+}
+
+#if TCS_HAS_AF_PACKET
+static struct tpacket2_hdr* packet_ring_tx_frame(struct TcsPacketRing* ring, size_t frame)
+{
+    size_t block = frame / ring->frames_per_block;
+    size_t offset = (frame % ring->frames_per_block) * ring->frame_size;
+    return (struct tpacket2_hdr*)(void*)(ring->map + block * ring->block_size + offset);
+}
+
+// Without PACKET_TX_HAS_OFF the kernel reads the frame right after the aligned header
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wsign-conversion"
+static const size_t PACKET_RING_TX_DATA_OFFSET = TPACKET_ALIGN(sizeof(struct tpacket2_hdr));
+#pragma GCC diagnostic pop
+#endif
+
+TcsResult tcs_packet_ring_tx_create(struct TcsPacketRing** out_ring,
+                                    TcsSocket socket,
+                                    size_t block_size,
+                                    size_t block_count,
+                                    size_t frame_size)
+{
+    if (out_ring == NULL || *out_ring != NULL || socket == TCS_SOCKET_INVALID)
+        return TCS_ERROR_INVALID_ARGUMENT;
+
+#if TCS_HAS_AF_PACKET
+    long page_size = sysconf(_SC_PAGESIZE);
+    if (page_size <= 0)
+        return TCS_ERROR_SYSTEM;
+    if (block_size == 0 || block_size % (size_t)page_size != 0 || block_size > UINT_MAX)
+        return TCS_ERROR_INVALID_ARGUMENT;
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wsign-conversion"
+    const size_t min_frame_size = TPACKET2_HDRLEN;
+#pragma GCC diagnostic pop
+    if (frame_size < min_frame_size || frame_size % TPACKET_ALIGNMENT != 0 || frame_size > block_size)
+        return TCS_ERROR_INVALID_ARGUMENT;
+    if (block_count == 0 || block_count > UINT_MAX / (block_size / frame_size) || block_count > SIZE_MAX / block_size)
+        return TCS_ERROR_INVALID_ARGUMENT;
+
+    int version = TPACKET_V2;
+    if (setsockopt(socket, SOL_PACKET, PACKET_VERSION, &version, sizeof(version)) != 0)
+        return errno == EBUSY ? TCS_ERROR_INVALID_ARGUMENT : errno2retcode(errno); // EBUSY: the socket has a ring
+
+    struct tpacket_req req;
+    memset(&req, 0, sizeof(req));
+    req.tp_block_size = (unsigned int)block_size;
+    req.tp_block_nr = (unsigned int)block_count;
+    req.tp_frame_size = (unsigned int)frame_size;
+    req.tp_frame_nr = (unsigned int)(block_size / frame_size * block_count);
+    if (setsockopt(socket, SOL_PACKET, PACKET_TX_RING, &req, sizeof(req)) != 0)
+        return errno2retcode(errno);
+
+    size_t map_size = block_size * block_count;
+    void* map = mmap(NULL, map_size, PROT_READ | PROT_WRITE, MAP_SHARED, socket, 0);
+    if (map == MAP_FAILED)
+    {
+        TcsResult sts = errno2retcode(errno);
+        packet_ring_unset(socket, PACKET_TX_RING);
+        return sts;
+    }
+
+    struct TcsPacketRing* ring = (struct TcsPacketRing*)tcs_lib_malloc(sizeof(struct TcsPacketRing));
+    if (ring == NULL)
+    {
+        munmap(map, map_size);
+        packet_ring_unset(socket, PACKET_TX_RING);
+        return TCS_ERROR_MEMORY;
+    }
+    memset(ring, 0, sizeof(struct TcsPacketRing));
+    ring->socket = socket;
+    ring->ring_option = PACKET_TX_RING;
+    ring->map = (uint8_t*)map;
+    ring->map_size = map_size;
+    ring->block_size = block_size;
+    ring->block_count = block_count;
+    ring->frame_size = frame_size;
+    ring->frames_per_block = block_size / frame_size;
+    ring->frame_count = ring->frames_per_block * block_count;
+
+    *out_ring = ring;
+    return TCS_SUCCESS;
+#else
+    (void)block_size;
+    (void)block_count;
+    (void)frame_size;
+    return TCS_ERROR_NOT_SUPPORTED;
+#endif
+}
+
+TcsResult tcs_packet_ring_tx_acquire(struct TcsPacketRing* ring, uint8_t** out_data, size_t* out_capacity)
+{
+    if (ring == NULL || out_data == NULL || out_capacity == NULL)
+        return TCS_ERROR_INVALID_ARGUMENT;
+
+#if TCS_HAS_AF_PACKET
+    if (ring->ring_option != PACKET_TX_RING)
+        return TCS_ERROR_INVALID_ARGUMENT;
+
+    struct tpacket2_hdr* header = packet_ring_tx_frame(ring, ring->current_frame);
+    // Acquire pairs with the kernel releasing the frame after transmission
+    uint32_t status = __atomic_load_n(&header->tp_status, __ATOMIC_ACQUIRE);
+    // A frame the kernel rejected is handed back as free, tcs_packet_ring_tx_flush() has reported the error
+    if (status != TP_STATUS_AVAILABLE && status != TP_STATUS_WRONG_FORMAT)
+        return TCS_ERROR_WOULD_BLOCK;
+
+    *out_data = (uint8_t*)header + PACKET_RING_TX_DATA_OFFSET;
+    *out_capacity = ring->frame_size - PACKET_RING_TX_DATA_OFFSET;
+    ring->is_frame_acquired = true;
+    return TCS_SUCCESS;
+#else
+    return TCS_ERROR_NOT_SUPPORTED;
+#endif
+}
+
+TcsResult tcs_packet_ring_tx_commit(struct TcsPacketRing* ring, size_t frame_size)
+{
+    if (ring == NULL)
         return TCS_ERROR_INVALID_ARGUMENT;
-    struct TdsMap_poll const* map = &ctx->backend.poll.map;
 
-    bool found = false;
-    for (size_t i = 0; i < map->count; ++i)
-    {
-        if (socket == map->keys[i].fd)
-        {
-            if (tds_map_poll_remove(&ctx->backend.poll.map, i) != 0)
-                return TCS_ERROR_MEMORY;
-            found = true;
-            break;
-        }
-    }
-    if (!found)
+#if TCS_HAS_AF_PACKET
+    if (ring->ring_option != PACKET_TX_RING)
+        return TCS_ERROR_INVALID_ARGUMENT;
+    if (frame_size == 0 || frame_size > ring->frame_size - PACKET_RING_TX_DATA_OFFSET)
         return TCS_ERROR_INVALID_ARGUMENT;
+    if (!ring->is_frame_acquired)
+        return TCS_ERROR_INVALID_ARGUMENT;
+
+    struct tpacket2_hdr* header = packet_ring_tx_frame(ring, ring->current_frame);
 
+    header->tp_len = (uint32_t)frame_size;
+    header->tp_snaplen = (uint32_t)frame_size;
+    // Release makes the frame content visible before the kernel sees the request
+    __atomic_store_n(&header->tp_status, TP_STATUS_SEND_REQUEST, __ATOMIC_RELEASE);
+
+    ring->is_frame_acquired = false;
+    ring->current_frame = (ring->current_frame + 1) % ring->frame_count;
     return TCS_SUCCESS;
+#else
+    (void)frame_size;
+    return TCS_ERROR_NOT_SUPPORTED;
+#endif
 }
 
-TcsResult tcs_poll_wait(struct TcsPoll* poll_ctx,
-                        struct TcsPollEvent* out_events,
-                        size_t events_length,
-                        size_t* out_events_length,
-                        int timeout_ms)
+TcsResult tcs_packet_ring_tx_flush(struct TcsPacketRing* ring, const struct TcsAddress* destination_address)
 {
-    if (poll_ctx == NULL || out_events == NULL || out_events_length == NULL)
-        return TCS_ERROR_INVALID_ARGUMENT;
-    if (timeout_ms < 0 && timeout_ms != TCS_WAIT_INF)
+    if (ring == NULL)
         return TCS_ERROR_INVALID_ARGUMENT;
 
-    struct TdsMap_poll* map = &poll_ctx->backend.poll.map;
-
-    int poll_ret = poll(map->keys, map->count, timeout_ms);
-    *out_events_length = 0;
-    if (poll_ret < 0)
-    {
-        return errno2retcode(errno);
-    }
-    if ((size_t)poll_ret > map->count)
-    {
-        return TCS_ERROR_UNKNOWN; // Corruption
-    }
+#if TCS_HAS_AF_PACKET
+    if (ring->ring_option != PACKET_TX_RING)
+        return TCS_ERROR_INVALID_ARGUMENT;
 
-    int fill_max = poll_ret > (int)events_length ? (int)events_length : poll_ret; // min(ret, events_length)
-    int filled = 0;
-    for (size_t i = 0; filled < fill_max; ++i)
+    struct sockaddr_storage native_address;
+    memset(&native_address, 0, sizeof native_address);
+    socklen_t native_address_size = 0;
+    if (destination_address != NULL)
     {
-        if (i >= map->count)
-            return TCS_ERROR_UNKNOWN;
-
-        if (map->keys[i].revents != 0)
-        {
-            out_events[filled].socket = map->keys[i].fd;
-            out_events[filled].user_data = map->values[i];
-            out_events[filled].can_read = map->keys[i].revents & POLLIN;
-            out_events[filled].can_write = map->keys[i].revents & POLLOUT;
-            if (map->keys[i].revents & (POLLERR | POLLHUP))
-            {
-                int so_error = 0;
-                socklen_t so_error_size = sizeof(so_error);
-                TcsResult fallback = (map->keys[i].revents & POLLERR) ? TCS_ERROR_UNKNOWN : TCS_ERROR_SOCKET_CLOSED;
-                if (getsockopt(map->keys[i].fd, SOL_SOCKET, SO_ERROR, &so_error, &so_error_size) != 0)
-                    out_events[filled].error = errno2retcode(errno);
-                else
-                    out_events[filled].error = so_error != 0 ? errno2retcode(so_error) : fallback;
-            }
-            else
-            {
-                out_events[filled].error = TCS_SUCCESS;
-            }
-            map->keys[i].revents = 0;
-            ++filled;
-        }
+        TcsResult sts = sockaddr2native(destination_address, &native_address, &native_address_size);
+        if (sts != TCS_SUCCESS)
+            return sts;
     }
-    *out_events_length = (size_t)filled;
 
-    if (poll_ret == 0)
-        return TCS_ERROR_TIMED_OUT;
+    // All frames with TP_STATUS_SEND_REQUEST are sent by this single call
+    ssize_t sent = sendto(ring->socket,
+                          NULL,
+                          0,
+                          0,
+                          destination_address != NULL ? (const struct sockaddr*)&native_address : NULL,
+                          native_address_size);
+    if (sent < 0)
+        return errno2retcode(errno);
     return TCS_SUCCESS;
+#else
+    (void)destination_address;
+    return TCS_ERROR_NOT_SUPPORTED;
+#endif
 }
 
 // ######## Socket Options ########
@@ -1149,7 +2412,7 @@ TcsResult tcs_opt_get(TcsSocket socket, int32_t level, int32_t option_name, void
         *option_size = (size_t)optlen;
         // Linux sets the buffer size to the doubled because of internal use and returns the full doubled size including internal part
 #ifdef __linux__
-        if (option_name == TCS_SO_RCVBUF || option_name == TCS_SO_SNDBUF)
+        if (level == TCS_SOL_SOCKET && (option_name == TCS_SO_RCVBUF || option_name == TCS_SO_SNDBUF))
         {
             *(unsigned int*)out_option_value /= 2;
         }
@@ -1273,6 +2536,78 @@ TcsResult tcs_opt_linger_get(TcsSocket socket, bool* do_linger, int* timeout_sec
 
 // tcs_opt_ip_no_delay_set() is defined in tinycsocket_common.c
 // tcs_opt_ip_no_delay_get() is defined in tinycsocket_common.c
+
+TcsResult tcs_opt_tcp_fast_open_set(TcsSocket socket, int queue_length)
+{
+    if (socket == TCS_SOCKET_INVALID || queue_length < 0)
+        return TCS_ERROR_INVALID_ARGUMENT;
+
+#if defined(TCP_FASTOPEN)
+    TcsResult sts = tcs_opt_set(socket, IPPROTO_TCP, TCP_FASTOPEN, &queue_length, sizeof(queue_length));
+    // Kernel without TFO, the listener keeps working with normal handshakes
+    if (sts == TCS_ERROR_NOT_SUPPORTED)
+        return TCS_SUCCESS;
+    return sts;
+#else
+    return TCS_SUCCESS;
+#endif
+}
+
+TcsResult tcs_opt_tcp_fast_open_get(TcsSocket socket, int* queue_length)
+{
+    if (socket == TCS_SOCKET_INVALID || queue_length == NULL)
+        return TCS_ERROR_INVALID_ARGUMENT;
+
+    *queue_length = 0;
+#if defined(TCP_FASTOPEN)
+    int length = 0;
+    size_t length_size = sizeof(length);
+    TcsResult sts = tcs_opt_get(socket, IPPROTO_TCP, TCP_FASTOPEN, &length, &length_size);
+    if (sts == TCS_ERROR_NOT_SUPPORTED)
+        return TCS_SUCCESS;
+    if (sts != TCS_SUCCESS)
+        return sts;
+    *queue_length = length;
+#endif
+    return TCS_SUCCESS;
+}
+
+TcsResult tcs_opt_tcp_fast_open_connect_set(TcsSocket socket, bool do_fast_open)
+{
+    if (socket == TCS_SOCKET_INVALID)
+        return TCS_ERROR_INVALID_ARGUMENT;
+
+#if defined(TCP_FASTOPEN_CONNECT)
+    int enable = do_fast_open ? 1 : 0;
+    TcsResult sts = tcs_opt_set(socket, IPPROTO_TCP, TCP_FASTOPEN_CONNECT, &enable, sizeof(enable));
+    // Kernel older than 4.11, tcs_connect() does a normal handshake
+    if (sts == TCS_ERROR_NOT_SUPPORTED)
+        return TCS_SUCCESS;
+    return sts;
+#else
+    (void)do_fast_open;
+    return TCS_SUCCESS;
+#endif
+}
+
+TcsResult tcs_opt_tcp_fast_open_connect_get(TcsSocket socket, bool* is_fast_open)
+{
+    if (socket == TCS_SOCKET_INVALID || is_fast_open == NULL)
+        return TCS_ERROR_INVALID_ARGUMENT;
+
+    *is_fast_open = false;
+#if defined(TCP_FASTOPEN_CONNECT)
+    int enabled = 0;
+    size_t enabled_size = sizeof(enabled);
+    TcsResult sts = tcs_opt_get(socket, IPPROTO_TCP, TCP_FASTOPEN_CONNECT, &enabled, &enabled_size);
+    if (sts == TCS_ERROR_NOT_SUPPORTED)
+        return TCS_SUCCESS;
+    if (sts != TCS_SUCCESS)
+        return sts;
+    *is_fast_open = enabled != 0;
+#endif
+    return TCS_SUCCESS;
+}
 // tcs_opt_out_of_band_inline_set() is defined in tinycsocket_common.c
 // tcs_opt_out_of_band_inline_get() is defined in tinycsocket_common.c
 // tcs_opt_priority_set() is defined in tinycsocket_common.c
@@ -1283,6 +2618,12 @@ TcsResult tcs_opt_nonblocking_set(TcsSocket socket, bool do_non_blocking)
     if (socket == TCS_SOCKET_INVALID)
         return TCS_ERROR_INVALID_ARGUMENT;
 
+#ifdef FIONBIO
+    // One syscall instead of a F_GETFL and F_SETFL pair
+    int mode = do_non_blocking ? 1 : 0;
+    if (ioctl(socket, FIONBIO, &mode) == -1)
+        return errno2retcode(errno);
+#else
     int flags = fcntl(socket, F_GETFL, 0);
     if (flags == -1)
         return errno2retcode(errno);
@@ -1294,6 +2635,7 @@ TcsResult tcs_opt_nonblocking_set(TcsSocket socket, bool do_non_blocking)
 
     if (fcntl(socket, F_SETFL, flags) == -1)
         return errno2retcode(errno);
+#endif
 
     return TCS_SUCCESS;
 }
@@ -1311,6 +2653,220 @@ TcsResult tcs_opt_nonblocking_get(TcsSocket socket, bool* is_non_blocking)
     return TCS_SUCCESS;
 }
 
+TcsResult tcs_opt_tx_timestamping_set(TcsSocket socket, bool do_timestamp)
+{
+    if (socket == TCS_SOCKET_INVALID)
+        return TCS_ERROR_INVALID_ARGUMENT;
+
+#if TCS_HAS_TX_TIMESTAMPING
+    // OPT_TSONLY skips looping the payload back to the error queue, only the timestamp is of interest
+    int flags = 0;
+    if (do_timestamp)
+        flags = SOF_TIMESTAMPING_TX_SOFTWARE | SOF_TIMESTAMPING_SOFTWARE | SOF_TIMESTAMPING_OPT_ID |
+                SOF_TIMESTAMPING_OPT_TSONLY;
+    if (setsockopt(socket, SOL_SOCKET, SO_TIMESTAMPING, &flags, sizeof(flags)) != 0)
+        return errno2retcode(errno);
+    return TCS_SUCCESS;
+#else
+    (void)do_timestamp;
+    return TCS_ERROR_NOT_SUPPORTED;
+#endif
+}
+
+TcsResult tcs_opt_tx_timestamping_get(TcsSocket socket, bool* is_timestamping)
+{
+    if (socket == TCS_SOCKET_INVALID || is_timestamping == NULL)
+        return TCS_ERROR_INVALID_ARGUMENT;
+
+#if TCS_HAS_TX_TIMESTAMPING
+    int flags = 0;
+    socklen_t flags_size = sizeof(flags);
+    if (getsockopt(socket, SOL_SOCKET, SO_TIMESTAMPING, &flags, &flags_size) != 0)
+        return errno2retcode(errno);
+    *is_timestamping = (flags & SOF_TIMESTAMPING_TX_SOFTWARE) != 0;
+    return TCS_SUCCESS;
+#else
+    return TCS_ERROR_NOT_SUPPORTED;
+#endif
+}
+
+TcsResult tcs_opt_packet_info_set(TcsSocket socket, bool do_receive_packet_info)
+{
+    if (socket == TCS_SOCKET_INVALID)
+        return TCS_ERROR_INVALID_ARGUMENT;
+
+#if TCS_HAS_PKTINFO
+    TcsFamily family = TCS_FAMILY_ANY;
+    TcsResult sts = tcs_address_socket_family(socket, &family);
+    if (sts != TCS_SUCCESS)
+        return sts;
+
+    int enable = do_receive_packet_info ? 1 : 0;
+    if (family.native == TCS_FAMILY_IPV4.native)
+        return tcs_opt_set(socket, IPPROTO_IP, IP_PKTINFO, &enable, sizeof(enable));
+    if (family.native == TCS_FAMILY_IPV6.native)
+        return tcs_opt_set(socket, IPPROTO_IPV6, IPV6_RECVPKTINFO, &enable, sizeof(enable));
+    return TCS_ERROR_NOT_SUPPORTED;
+#else
+    (void)do_receive_packet_info;
+    return TCS_ERROR_NOT_SUPPORTED;
+#endif
+}
+
+TcsResult tcs_opt_packet_info_get(TcsSocket socket, bool* is_packet_info_received)
+{
+    if (socket == TCS_SOCKET_INVALID || is_packet_info_received == NULL)
+        return TCS_ERROR_INVALID_ARGUMENT;
+
+#if TCS_HAS_PKTINFO
+    TcsFamily family = TCS_FAMILY_ANY;
+    TcsResult sts = tcs_address_socket_family(socket, &family);
+    if (sts != TCS_SUCCESS)
+        return sts;
+
+    int enabled = 0;
+    size_t enabled_size = sizeof(enabled);
+    if (family.native == TCS_FAMILY_IPV4.native)
+        sts = tcs_opt_get(socket, IPPROTO_IP, IP_PKTINFO, &enabled, &enabled_size);
+    else if (family.native == TCS_FAMILY_IPV6.native)
+        sts = tcs_opt_get(socket, IPPROTO_IPV6, IPV6_RECVPKTINFO, &enabled, &enabled_size);
+    else
+        return TCS_ERROR_NOT_SUPPORTED;
+    if (sts != TCS_SUCCESS)
+        return sts;
+    *is_packet_info_received = enabled != 0;
+    return TCS_SUCCESS;
+#else
+    return TCS_ERROR_NOT_SUPPORTED;
+#endif
+}
+
+TcsResult tcs_opt_packet_qdisc_bypass_set(TcsSocket socket, bool do_bypass)
+{
+    if (socket == TCS_SOCKET_INVALID)
+        return TCS_ERROR_INVALID_ARGUMENT;
+
+#if TCS_HAS_AF_PACKET && defined(PACKET_QDISC_BYPASS)
+    int bypass = do_bypass ? 1 : 0;
+    return tcs_opt_set(socket, SOL_PACKET, PACKET_QDISC_BYPASS, &bypass, sizeof(bypass));
+#else
+    (void)do_bypass;
+    return TCS_ERROR_NOT_SUPPORTED;
+#endif
+}
+
+TcsResult tcs_opt_packet_qdisc_bypass_get(TcsSocket socket, bool* is_bypassed)
+{
+    if (socket == TCS_SOCKET_INVALID || is_bypassed == NULL)
+        return TCS_ERROR_INVALID_ARGUMENT;
+
+#if TCS_HAS_AF_PACKET && defined(PACKET_QDISC_BYPASS)
+    int bypass = 0;
+    size_t bypass_size = sizeof(bypass);
+    TcsResult sts = tcs_opt_get(socket, SOL_PACKET, PACKET_QDISC_BYPASS, &bypass, &bypass_size);
+    if (sts != TCS_SUCCESS)
+        return sts;
+    *is_bypassed = bypass != 0;
+    return TCS_SUCCESS;
+#else
+    return TCS_ERROR_NOT_SUPPORTED;
+#endif
+}
+
+TcsResult tcs_opt_packet_fanout_join(TcsSocket socket, uint16_t group_id, TcsPacketFanoutMode mode)
+{
+    if (socket == TCS_SOCKET_INVALID)
+        return TCS_ERROR_INVALID_ARGUMENT;
+
+#if TCS_HAS_AF_PACKET && defined(PACKET_FANOUT)
+    uint32_t type = 0;
+    switch (mode)
+    {
+        case TCS_PACKET_FANOUT_HASH:
+            // Reassemble IP fragments first so they hash like the rest of the flow
+            type = PACKET_FANOUT_HASH | PACKET_FANOUT_FLAG_DEFRAG;
+            break;
+        case TCS_PACKET_FANOUT_LB:
+            type = PACKET_FANOUT_LB;
+            break;
+        case TCS_PACKET_FANOUT_CPU:
+            type = PACKET_FANOUT_CPU;
+            break;
+        case TCS_PACKET_FANOUT_ROLLOVER:
+            type = PACKET_FANOUT_ROLLOVER;
+            break;
+        default:
+            return TCS_ERROR_INVALID_ARGUMENT;
+    }
+    uint32_t fanout = (uint32_t)group_id | (type << 16);
+    return tcs_opt_set(socket, SOL_PACKET, PACKET_FANOUT, &fanout, sizeof(fanout));
+#else
+    (void)group_id;
+    (void)mode;
+    return TCS_ERROR_NOT_SUPPORTED;
+#endif
+}
+
+TcsResult tcs_opt_reuse_port_steer_by_cpu(TcsSocket socket, size_t group_size)
+{
+    if (socket == TCS_SOCKET_INVALID || group_size == 0 || group_size > UINT32_MAX)
+        return TCS_ERROR_INVALID_ARGUMENT;
+
+#if TCS_HAS_REUSEPORT_CBPF
+    // The returned value is the index of the socket in the group
+    struct sock_filter instructions[] = {
+        BPF_STMT(BPF_LD | BPF_W | BPF_ABS, (uint32_t)(SKF_AD_OFF + SKF_AD_CPU)),
+        BPF_STMT(BPF_ALU | BPF_MOD | BPF_K, (uint32_t)group_size),
+        BPF_STMT(BPF_RET | BPF_A, 0),
+    };
+    struct sock_fprog program;
+    memset(&program, 0, sizeof(program));
+    program.len = (unsigned short)(sizeof(instructions) / sizeof(instructions[0]));
+    program.filter = instructions;
+    return tcs_opt_set(socket, SOL_SOCKET, SO_ATTACH_REUSEPORT_CBPF, &program, sizeof(program));
+#else
+    return TCS_ERROR_NOT_SUPPORTED;
+#endif
+}
+
+#if TCS_HAS_SOCKET_FILTER
+tcs_static_assert(filter_instruction_layout, sizeof(struct TcsFilterInstruction) == sizeof(struct sock_filter));
+#endif
+
+TcsResult tcs_opt_filter_attach(TcsSocket socket, const struct TcsFilter* filter)
+{
+    if (socket == TCS_SOCKET_INVALID || filter == NULL)
+        return TCS_ERROR_INVALID_ARGUMENT;
+    if (filter->length == 0 || filter->length > TCS_CFG_FILTER_MAX_INSTRUCTIONS)
+        return TCS_ERROR_INVALID_ARGUMENT;
+
+#if TCS_HAS_SOCKET_FILTER
+    struct sock_filter instructions[TCS_CFG_FILTER_MAX_INSTRUCTIONS];
+    memcpy(instructions, filter->instructions, filter->length * sizeof(struct sock_filter));
+
+    struct sock_fprog program;
+    memset(&program, 0, sizeof(program));
+    program.len = (unsigned short)filter->length;
+    program.filter = instructions;
+    return tcs_opt_set(socket, SOL_SOCKET, SO_ATTACH_FILTER, &program, sizeof(program));
+#else
+    return TCS_ERROR_NOT_SUPPORTED;
+#endif
+}
+
+TcsResult tcs_opt_filter_detach(TcsSocket socket)
+{
+    if (socket == TCS_SOCKET_INVALID)
+        return TCS_ERROR_INVALID_ARGUMENT;
+
+#if TCS_HAS_SOCKET_FILTER
+    int unused = 0;
+    return tcs_opt_set(socket, SOL_SOCKET, SO_DETACH_FILTER, &unused, sizeof(unused));
+#else
+    return TCS_ERROR_NOT_SUPPORTED;
+#endif
+}
+
 TcsResult tcs_opt_membership_add(TcsSocket socket, const struct TcsAddress* multicast_address)
 {
     if (socket == TCS_SOCKET_INVALID)
@@ -1624,7 +3180,7 @@ TcsResult tcs_interface_list(struct TcsInterface* out_interfaces,
         if (ioctl(fd, SIOCGIFCONF, &ifc) != 0)
         {
             if (buf != stack_buf)
-                free(buf);
+                tcs_lib_free(buf);
             close(fd);
             return errno2retcode(errno);
         }
@@ -1636,8 +3192,8 @@ TcsResult tcs_interface_list(struct TcsInterface* out_interfaces,
             break;
         buf_len *= 2;
         if (buf != stack_buf)
-            free(buf);
-        buf = (char*)malloc((size_t)buf_len);
+            tcs_lib_free(buf);
+        buf = (char*)tcs_lib_malloc((size_t)buf_len);
         if (buf == NULL)
         {
             close(fd);
@@ -1667,44 +3223,19 @@ TcsResult tcs_interface_list(struct TcsInterface* out_interfaces,
         *interfaces_populated = count;
 
     if (buf != stack_buf)
-        free(buf);
+        tcs_lib_free(buf);
     close(fd);
     return TCS_SUCCESS;
 }
 #endif
 
-TcsResult tcs_address_resolve(const char* hostname,
-                              TcsFamily address_family,
-                              struct TcsAddress out_addresses[],
-                              size_t addresses_length,
-                              size_t* out_length)
+// Used by tinycsocket_common.c, see the declarations there
+TcsResult tcs_os_address_resolve_native(const char* hostname,
+                                       TcsFamily address_family,
+                                       struct TcsAddress out_addresses[],
+                                       size_t addresses_length,
+                                       size_t* out_length)
 {
-    if (hostname == NULL)
-        return TCS_ERROR_INVALID_ARGUMENT;
-
-    if (out_addresses == NULL && out_length == NULL)
-        return TCS_ERROR_INVALID_ARGUMENT;
-
-    if (out_length != NULL)
-        *out_length = 0;
-
-    // Fast path: try numeric/MAC parse first to avoid DNS lookup
-    struct TcsAddress parsed = TCS_ADDRESS_NONE;
-    if (tcs_address_parse(hostname, &parsed) == TCS_SUCCESS && parsed.family.native != TCS_FAMILY_ANY.native)
-    {
-        if (address_family.native == TCS_FAMILY_ANY.native || parsed.family.native == address_family.native)
-        {
-            if (out_addresses != NULL && addresses_length > 0)
-                out_addresses[0] = parsed;
-            if (out_length != NULL)
-                *out_length = 1;
-            return TCS_SUCCESS;
-        }
-    }
-
-    if (address_family.native == -1) // sentinel for unsupported families (e.g. TCS_FAMILY_PACKET on non-Linux)
-        return TCS_ERROR_NOT_SUPPORTED;
-
     struct addrinfo native_hints;
     memset(&native_hints, 0, sizeof native_hints);
     native_hints.ai_family = address_family.native;
@@ -1766,6 +3297,12 @@ TcsResult tcs_address_resolve(const char* hostname,
     return TCS_SUCCESS;
 }
 
+// tcs_address_resolve() is defined in tinycsocket_common.c
+// tcs_address_cache_enable() is defined in tinycsocket_common.c
+// tcs_address_cache_disable() is defined in tinycsocket_common.c
+// tcs_address_cache_prefill() is defined in tinycsocket_common.c
+// tcs_address_cache_flush() is defined in tinycsocket_common.c
+
 #if TCS_HAS_GETIFADDRS
 TcsResult tcs_address_list(unsigned int interface_id_filter,
                            TcsFamily address_family_filter,
@@ -1887,7 +3424,7 @@ TcsResult tcs_address_list(unsigned int interface_id_filter,
         if (ioctl(fd, SIOCGIFCONF, &ifc) != 0)
         {
             if (buf != stack_buf)
-                free(buf);
+                tcs_lib_free(buf);
             close(fd);
             return errno2retcode(errno);
         }
@@ -1898,8 +3435,8 @@ TcsResult tcs_address_list(unsigned int interface_id_filter,
             break;
         buf_len *= 2;
         if (buf != stack_buf)
-            free(buf);
-        buf = (char*)malloc((size_t)buf_len);
+            tcs_lib_free(buf);
+        buf = (char*)tcs_lib_malloc((size_t)buf_len);
         if (buf == NULL)
         {
             close(fd);
@@ -1981,7 +3518,7 @@ TcsResult tcs_address_list(unsigned int interface_id_filter,
     }
 
     if (buf != stack_buf)
-        free(buf);
+        tcs_lib_free(buf);
     close(fd);
     return TCS_SUCCESS;
 }
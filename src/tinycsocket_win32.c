@@ -44,7 +44,6 @@
 #include <ws2tcpip.h> // getaddrinfo
 
 #include <stdio.h>  // fprintf (debug diagnostics)
-#include <stdlib.h> // Malloc for GetAdaptersAddresses
 #include <string.h> // memset
 
 // SOCKADDR_STORAGE was introduced in Windows XP (0x0501).
@@ -68,7 +67,7 @@ typedef struct
 
 #ifndef ULIST_SOC
 #define ULIST_SOC
-TDS_ULIST_IMPL(SOCKET, soc)
+TDS_ULIST_IMPL_WITH_POLICY(SOCKET, soc, &TDS_GROWTH_POLICY_NEVER_SHRINK)
 #endif
 
 #ifndef ULIST_PVOID
@@ -78,7 +77,7 @@ TDS_ULIST_IMPL(void*, pvoid)
 
 #ifndef TDS_MAP_socket_pvoid
 #define TDS_MAP_socket_pvoid
-TDS_MAP_IMPL(SOCKET, void*, socket_user)
+TDS_MAP_IMPL_WITH_POLICY(SOCKET, void*, socket_user, &TDS_GROWTH_POLICY_NEVER_SHRINK)
 #endif
 
 // Needs to be compatible with fd_set, hopefully this works. Only used when FD_SETSIZE is to small.
@@ -127,6 +126,9 @@ const uint32_t TCS_MSG_WAITALL = 0x8; // Binary compatible when it does not exis
 // Send flags
 const uint32_t TCS_MSG_SENDALL = 0x80000000;
 
+// Send and recv flags
+const uint32_t TCS_MSG_DONTWAIT = 0x40000000; // Emulated, Winsock has no MSG_DONTWAIT
+
 // Backlog
 const int TCS_BACKLOG_MAX = SOMAXCONN;
 
@@ -157,6 +159,10 @@ const int32_t TCS_IP_MULTICAST_LOOP = IP_MULTICAST_LOOP;
 
 // ######## Internal Helpers ########
 
+#ifndef WSA_FLAG_NO_HANDLE_INHERIT
+#define WSA_FLAG_NO_HANDLE_INHERIT 0x80 // Windows 7 SP1 and later, missing in older SDKs
+#endif
+
 static TcsResult wsaerror2retcode(int wsa_error)
 {
     switch (wsa_error)
@@ -290,6 +296,268 @@ static TcsResult native2sockaddr(const PSOCKADDR in_addr, struct TcsAddress* out
     return TCS_SUCCESS;
 }
 
+// ######## OS Primitives ########
+
+// Used by tinycsocket_common.c, see the declarations there
+
+size_t tcs_os_steering_cpu_count(void)
+{
+    return 0; // No SO_REUSEPORT groups
+}
+
+// CRITICAL_SECTION and not SRWLOCK, which needs Windows Vista
+struct TcsOsMutex
+{
+    CRITICAL_SECTION section;
+};
+
+TcsResult tcs_os_mutex_create(struct TcsOsMutex** out_mutex)
+{
+    struct TcsOsMutex* mutex = (struct TcsOsMutex*)tcs_lib_malloc(sizeof(struct TcsOsMutex));
+    if (mutex == NULL)
+        return TCS_ERROR_MEMORY;
+    InitializeCriticalSection(&mutex->section);
+    *out_mutex = mutex;
+    return TCS_SUCCESS;
+}
+
+void tcs_os_mutex_destroy(struct TcsOsMutex** mutex)
+{
+    DeleteCriticalSection(&(*mutex)->section);
+    tcs_lib_free(*mutex);
+    *mutex = NULL;
+}
+
+void tcs_os_mutex_lock(struct TcsOsMutex* mutex)
+{
+    EnterCriticalSection(&mutex->section);
+}
+
+void tcs_os_mutex_unlock(struct TcsOsMutex* mutex)
+{
+    LeaveCriticalSection(&mutex->section);
+}
+
+// A CRITICAL_SECTION has no static initializer, the first caller initializes it. It is never deleted.
+static CRITICAL_SECTION os_global_section;
+static volatile LONG os_global_state = 0; // 0 not initialized, 1 initializing, 2 ready
+
+void tcs_os_global_lock(void)
+{
+    if (InterlockedCompareExchange(&os_global_state, 1, 0) == 0)
+    {
+        InitializeCriticalSection(&os_global_section);
+        InterlockedExchange(&os_global_state, 2);
+    }
+    while (InterlockedCompareExchange(&os_global_state, 2, 2) != 2)
+        Sleep(0);
+    EnterCriticalSection(&os_global_section);
+}
+
+void tcs_os_global_unlock(void)
+{
+    LeaveCriticalSection(&os_global_section);
+}
+
+struct TcsOsThread
+{
+    HANDLE handle;
+    void (*function)(void*);
+    void* arg;
+};
+
+static DWORD WINAPI os_thread_main(LPVOID arg)
+{
+    struct TcsOsThread* thread = (struct TcsOsThread*)arg;
+    thread->function(thread->arg);
+    return 0;
+}
+
+TcsResult tcs_os_thread_create(struct TcsOsThread** out_thread, void (*function)(void*), void* arg)
+{
+    struct TcsOsThread* thread = (struct TcsOsThread*)tcs_lib_malloc(sizeof(struct TcsOsThread));
+    if (thread == NULL)
+        return TCS_ERROR_MEMORY;
+    thread->function = function;
+    thread->arg = arg;
+    thread->handle = CreateThread(NULL, 0, os_thread_main, thread, 0, NULL);
+    if (thread->handle == NULL)
+    {
+        tcs_lib_free(thread);
+        return TCS_ERROR_SYSTEM;
+    }
+    *out_thread = thread;
+    return TCS_SUCCESS;
+}
+
+void tcs_os_thread_join(struct TcsOsThread** thread)
+{
+    WaitForSingleObject((*thread)->handle, INFINITE);
+    CloseHandle((*thread)->handle);
+    tcs_lib_free(*thread);
+    *thread = NULL;
+}
+
+// A semaphore object and not CONDITION_VARIABLE, which needs Windows Vista
+struct TcsOsSemaphore
+{
+    HANDLE handle;
+};
+
+TcsResult tcs_os_semaphore_create(struct TcsOsSemaphore** out_semaphore)
+{
+    struct TcsOsSemaphore* semaphore = (struct TcsOsSemaphore*)tcs_lib_malloc(sizeof(struct TcsOsSemaphore));
+    if (semaphore == NULL)
+        return TCS_ERROR_MEMORY;
+    semaphore->handle = CreateSemaphoreW(NULL, 0, MAXLONG, NULL);
+    if (semaphore->handle == NULL)
+    {
+        tcs_lib_free(semaphore);
+        return TCS_ERROR_SYSTEM;
+    }
+    *out_semaphore = semaphore;
+    return TCS_SUCCESS;
+}
+
+void tcs_os_semaphore_destroy(struct TcsOsSemaphore** semaphore)
+{
+    CloseHandle((*semaphore)->handle);
+    tcs_lib_free(*semaphore);
+    *semaphore = NULL;
+}
+
+void tcs_os_semaphore_post(struct TcsOsSemaphore* semaphore)
+{
+    ReleaseSemaphore(semaphore->handle, 1, NULL);
+}
+
+void tcs_os_semaphore_wait(struct TcsOsSemaphore* semaphore)
+{
+    WaitForSingleObject(semaphore->handle, INFINITE);
+}
+
+// Windows can only select() on sockets, a pipe would not work with TcsPoll. This is a UDP socket connected to
+// itself instead, one datagram is queued while set.
+struct TcsOsWakeup
+{
+    TcsSocket socket;
+};
+
+TcsResult tcs_os_wakeup_create(struct TcsOsWakeup** out_wakeup)
+{
+    struct TcsAddress loopback = TCS_ADDRESS_NONE;
+    TcsResult res = tcs_address_parse("127.0.0.1:0", &loopback);
+    if (res != TCS_SUCCESS)
+        return res;
+    struct TcsOsWakeup* wakeup = (struct TcsOsWakeup*)tcs_lib_malloc(sizeof(struct TcsOsWakeup));
+    if (wakeup == NULL)
+        return TCS_ERROR_MEMORY;
+    wakeup->socket = TCS_SOCKET_INVALID;
+    res = tcs_socket_with_flags(&wakeup->socket,
+                                TCS_FAMILY_IPV4,
+                                TCS_SOCKET_DGRAM,
+                                TCS_PROTOCOL_IP_UDP,
+                                TCS_SOCKET_FLAG_NONBLOCKING | TCS_SOCKET_FLAG_CLOEXEC);
+    if (res == TCS_SUCCESS)
+        res = tcs_bind(wakeup->socket, &loopback);
+    if (res == TCS_SUCCESS)
+        res = tcs_address_socket_local(wakeup->socket, &loopback);
+    if (res == TCS_SUCCESS)
+        res = tcs_connect(wakeup->socket, &loopback);
+    if (res != TCS_SUCCESS)
+    {
+        if (wakeup->socket != TCS_SOCKET_INVALID)
+            tcs_close(&wakeup->socket);
+        tcs_lib_free(wakeup);
+        return res;
+    }
+    *out_wakeup = wakeup;
+    return TCS_SUCCESS;
+}
+
+void tcs_os_wakeup_destroy(struct TcsOsWakeup** wakeup)
+{
+    tcs_close(&(*wakeup)->socket);
+    tcs_lib_free(*wakeup);
+    *wakeup = NULL;
+}
+
+TcsSocket tcs_os_wakeup_socket(const struct TcsOsWakeup* wakeup)
+{
+    return wakeup->socket;
+}
+
+void tcs_os_wakeup_set(struct TcsOsWakeup* wakeup, bool is_set)
+{
+    char byte = 1;
+    if (is_set)
+        send(wakeup->socket, &byte, 1, 0);
+    else
+        recv(wakeup->socket, &byte, 1, 0);
+}
+
+TcsResult tcs_os_connect_wait(const TcsSocket sockets[], size_t sockets_length, TcsResult out_results[], int timeout_ms)
+{
+    if (sockets_length > TCS_CFG_CONNECT_CANDIDATES_MAX || sockets_length > FD_SETSIZE)
+        return TCS_ERROR_INVALID_ARGUMENT;
+
+    // A failed connect is reported in the except set on Windows
+    fd_set write_set;
+    fd_set except_set;
+    FD_ZERO(&write_set);
+    FD_ZERO(&except_set);
+    for (size_t i = 0; i < sockets_length; ++i)
+    {
+        out_results[i] = TCS_IN_PROGRESS;
+        if (sockets[i] == TCS_SOCKET_INVALID)
+            continue;
+        FD_SET(sockets[i], &write_set);
+        FD_SET(sockets[i], &except_set);
+    }
+    if (write_set.fd_count == 0)
+    {
+        Sleep(timeout_ms == TCS_WAIT_INF ? INFINITE : (DWORD)timeout_ms); // select() fails on empty sets
+        return TCS_ERROR_TIMED_OUT;
+    }
+    struct timeval timeout;
+    timeout.tv_sec = timeout_ms / 1000;
+    timeout.tv_usec = (timeout_ms % 1000) * 1000;
+    int ready = select(0, NULL, &write_set, &except_set, timeout_ms == TCS_WAIT_INF ? NULL : &timeout);
+    if (ready == SOCKET_ERROR)
+        return wsaerror2retcode(WSAGetLastError());
+    if (ready == 0)
+        return TCS_ERROR_TIMED_OUT;
+
+    for (size_t i = 0; i < sockets_length; ++i)
+    {
+        if (sockets[i] == TCS_SOCKET_INVALID ||
+            (!FD_ISSET(sockets[i], &write_set) && !FD_ISSET(sockets[i], &except_set)))
+            continue;
+        int error = 0;
+        int error_size = sizeof(error);
+        if (getsockopt(sockets[i], SOL_SOCKET, SO_ERROR, (char*)&error, &error_size) == SOCKET_ERROR)
+            error = WSAGetLastError();
+        out_results[i] = error == 0 ? TCS_SUCCESS : wsaerror2retcode(error);
+    }
+    return TCS_SUCCESS;
+}
+
+// RtlGenRandom() is exported as SystemFunction036 since Windows XP, looked up so advapi32 is not needed at link time
+typedef BOOLEAN(WINAPI* TcsRtlGenRandom)(PVOID buffer, ULONG length);
+
+TcsResult tcs_os_random(uint8_t* out_bytes, size_t length)
+{
+    if (length > MAXULONG)
+        return TCS_ERROR_INVALID_ARGUMENT;
+    HMODULE advapi = LoadLibraryA("advapi32.dll");
+    if (advapi == NULL)
+        return TCS_ERROR_NOT_SUPPORTED;
+    TcsRtlGenRandom gen_random = (TcsRtlGenRandom)(void*)GetProcAddress(advapi, "SystemFunction036");
+    bool is_filled = gen_random != NULL && gen_random(out_bytes, (ULONG)length);
+    FreeLibrary(advapi);
+    return is_filled ? TCS_SUCCESS : TCS_ERROR_NOT_SUPPORTED;
+}
+
 TcsResult tcs_lib_init(void)
 {
     WSADATA wsa_data;
@@ -304,25 +572,69 @@ TcsResult tcs_lib_cleanup(void)
     return TCS_SUCCESS;
 }
 
+int64_t tcs_time_monotonic_ms(void)
+{
+    LARGE_INTEGER frequency;
+    LARGE_INTEGER counter;
+    QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&counter);
+    // Split to not overflow when multiplying large counters
+    int64_t whole_seconds = counter.QuadPart / frequency.QuadPart;
+    int64_t remainder = counter.QuadPart % frequency.QuadPart;
+    return whole_seconds * 1000 + remainder * 1000 / frequency.QuadPart;
+}
+
 TcsResult tcs_socket(TcsSocket* out_socket, TcsFamily family, TcsSocketType type, TcsProtocol protocol)
+{
+    return tcs_socket_with_flags(out_socket, family, type, protocol, TCS_FLAG_NONE);
+}
+
+TcsResult tcs_socket_with_flags(TcsSocket* out_socket,
+                                TcsFamily family,
+                                TcsSocketType type,
+                                TcsProtocol protocol,
+                                uint32_t flags)
 {
     if (out_socket == NULL || *out_socket != TCS_SOCKET_INVALID)
         return TCS_ERROR_INVALID_ARGUMENT;
+    if ((flags & ~(TCS_SOCKET_FLAG_NONBLOCKING | TCS_SOCKET_FLAG_CLOEXEC)) != 0)
+        return TCS_ERROR_INVALID_ARGUMENT;
     if (family.native == -1) // sentinel for unsupported families (e.g. TCS_FAMILY_PACKET on Windows)
         return TCS_ERROR_NOT_SUPPORTED;
 
-    TcsSocket new_socket = socket(family.native, type.native, (int)protocol);
-
-    if (new_socket != INVALID_SOCKET)
+    // Same as socket(), which creates overlapped sockets
+    DWORD wsa_flags = WSA_FLAG_OVERLAPPED;
+    if (flags & TCS_SOCKET_FLAG_CLOEXEC)
+        wsa_flags |= WSA_FLAG_NO_HANDLE_INHERIT;
+    TcsSocket new_socket = WSASocketW(family.native, type.native, (int)protocol, NULL, 0, wsa_flags);
+    if (new_socket == INVALID_SOCKET && (wsa_flags & WSA_FLAG_NO_HANDLE_INHERIT) && WSAGetLastError() == WSAEINVAL)
     {
-        *out_socket = new_socket;
-        return TCS_SUCCESS;
+        // The flag is unknown before Windows 7 SP1, clear the inherit flag after creation instead
+        new_socket = WSASocketW(family.native, type.native, (int)protocol, NULL, 0, WSA_FLAG_OVERLAPPED);
+        if (new_socket != INVALID_SOCKET && !SetHandleInformation((HANDLE)new_socket, HANDLE_FLAG_INHERIT, 0))
+        {
+            closesocket(new_socket);
+            return TCS_ERROR_SYSTEM;
+        }
     }
-    else
+
+    if (new_socket == INVALID_SOCKET)
     {
         int error_code = WSAGetLastError();
         return wsaerror2retcode(error_code);
     }
+    if (flags & TCS_SOCKET_FLAG_NONBLOCKING)
+    {
+        u_long non_blocking = 1;
+        if (ioctlsocket(new_socket, FIONBIO, &non_blocking) == SOCKET_ERROR)
+        {
+            int error_code = WSAGetLastError();
+            closesocket(new_socket);
+            return wsaerror2retcode(error_code);
+        }
+    }
+    *out_socket = new_socket;
+    return TCS_SUCCESS;
 }
 
 // tcs_socket_tcp() is defined in tinycsocket_common.c
@@ -332,6 +644,8 @@ TcsResult tcs_socket(TcsSocket* out_socket, TcsFamily family, TcsSocketType type
 // tcs_socket_packet() is defined in tinycsocket_common.c
 // tcs_socket_packet_str() is defined in tinycsocket_common.c
 
+// tcs_socket_per_cpu() is defined in tinycsocket_common.c
+
 TcsResult tcs_close(TcsSocket* socket)
 {
     if (socket == NULL || *socket == TCS_SOCKET_INVALID)
@@ -397,6 +711,58 @@ TcsResult tcs_connect(TcsSocket socket, const struct TcsAddress* address)
 
 // tcs_connect_str() is defined in tinycsocket_common.c
 
+TcsResult tcs_connect_timeout(TcsSocket socket, const struct TcsAddress* address, int timeout_ms)
+{
+    if (socket == TCS_SOCKET_INVALID || address == NULL)
+        return TCS_ERROR_INVALID_ARGUMENT;
+    if (timeout_ms < 0 && timeout_ms != TCS_WAIT_INF)
+        return TCS_ERROR_INVALID_ARGUMENT;
+    if (timeout_ms == TCS_WAIT_INF)
+        return tcs_connect(socket, address);
+
+    u_long non_blocking = 1;
+    if (ioctlsocket(socket, FIONBIO, &non_blocking) == SOCKET_ERROR)
+        return wsaerror2retcode(WSAGetLastError());
+
+    TcsResult res = tcs_connect(socket, address);
+    if (res == TCS_IN_PROGRESS)
+    {
+        // A failed connect is reported in the except set on Windows
+        fd_set write_set;
+        fd_set except_set;
+        FD_ZERO(&write_set);
+        FD_ZERO(&except_set);
+        FD_SET(socket, &write_set);
+        FD_SET(socket, &except_set);
+        struct timeval timeout;
+        timeout.tv_sec = timeout_ms / 1000;
+        timeout.tv_usec = (timeout_ms % 1000) * 1000;
+        int ready = select(0, NULL, &write_set, &except_set, &timeout);
+        if (ready == SOCKET_ERROR)
+        {
+            res = wsaerror2retcode(WSAGetLastError());
+        }
+        else if (ready == 0)
+        {
+            res = TCS_ERROR_TIMED_OUT;
+        }
+        else
+        {
+            int error = 0;
+            int error_size = sizeof(error);
+            if (getsockopt(socket, SOL_SOCKET, SO_ERROR, (char*)&error, &error_size) == SOCKET_ERROR)
+                res = wsaerror2retcode(WSAGetLastError());
+            else
+                res = error == 0 ? TCS_SUCCESS : wsaerror2retcode(error);
+        }
+    }
+
+    non_blocking = 0;
+    if (ioctlsocket(socket, FIONBIO, &non_blocking) == SOCKET_ERROR && res == TCS_SUCCESS)
+        res = wsaerror2retcode(WSAGetLastError());
+    return res;
+}
+
 TcsResult tcs_listen(TcsSocket socket, int backlog)
 {
     if (socket == TCS_SOCKET_INVALID)
@@ -433,6 +799,53 @@ TcsResult tcs_accept(TcsSocket listener, TcsSocket* out_socket, struct TcsAddres
     }
 }
 
+TcsResult tcs_accept_many(TcsSocket listener,
+                          TcsSocket out_sockets[],
+                          struct TcsAddress out_addresses[],
+                          size_t sockets_length,
+                          size_t* out_accepted_count)
+{
+    if (out_accepted_count != NULL)
+        *out_accepted_count = 0;
+    if (listener == TCS_SOCKET_INVALID || out_sockets == NULL || sockets_length == 0 || out_accepted_count == NULL)
+        return TCS_ERROR_INVALID_ARGUMENT;
+
+    TcsResult res = TCS_SUCCESS;
+    size_t count = 0;
+    while (count < sockets_length)
+    {
+        SOCKADDR_STORAGE native_sockaddr;
+        int addr_len = sizeof(native_sockaddr);
+        PSOCKADDR native_address = out_addresses != NULL ? (PSOCKADDR)&native_sockaddr : NULL;
+        int* native_address_size = out_addresses != NULL ? &addr_len : NULL;
+        SOCKET socket = accept(listener, native_address, native_address_size);
+        if (socket == INVALID_SOCKET)
+        {
+            res = wsaerror2retcode(WSAGetLastError());
+            break;
+        }
+        // Windows has no accept4(), set the flags afterwards
+        u_long non_blocking = 1;
+        if (ioctlsocket(socket, FIONBIO, &non_blocking) == SOCKET_ERROR ||
+            !SetHandleInformation((HANDLE)socket, HANDLE_FLAG_INHERIT, 0))
+        {
+            res = wsaerror2retcode(WSAGetLastError());
+            closesocket(socket);
+            break;
+        }
+        out_sockets[count] = socket;
+        if (out_addresses != NULL)
+        {
+            out_addresses[count] = TCS_ADDRESS_NONE;
+            native2sockaddr((PSOCKADDR)&native_sockaddr, &out_addresses[count]);
+        }
+        count++;
+    }
+
+    *out_accepted_count = count;
+    return count > 0 ? TCS_SUCCESS : res;
+}
+
 TcsResult tcs_shutdown(TcsSocket socket, TcsShutdownDirection direction)
 {
     const int LUT[] = {SD_RECEIVE, SD_SEND, SD_BOTH};
@@ -449,6 +862,23 @@ TcsResult tcs_shutdown(TcsSocket socket, TcsShutdownDirection direction)
 
 // ######## Data Transfer ########
 
+// Winsock has no MSG_DONTWAIT, check readiness without waiting instead and strip the flag
+static TcsResult dontwait_check(TcsSocket socket, uint32_t* flags, bool is_send)
+{
+    if ((*flags & TCS_MSG_DONTWAIT) == 0)
+        return TCS_SUCCESS;
+    *flags &= ~TCS_MSG_DONTWAIT;
+
+    fd_set set;
+    FD_ZERO(&set);
+    FD_SET(socket, &set);
+    struct timeval no_wait = {0, 0};
+    int ready = select(0, is_send ? NULL : &set, is_send ? &set : NULL, NULL, &no_wait);
+    if (ready == SOCKET_ERROR)
+        return wsaerror2retcode(WSAGetLastError());
+    return ready == 0 ? TCS_ERROR_WOULD_BLOCK : TCS_SUCCESS;
+}
+
 TcsResult tcs_send(TcsSocket socket, const uint8_t* buffer, size_t buffer_size, uint32_t flags, size_t* sent_size)
 {
     if (socket == TCS_SOCKET_INVALID)
@@ -460,6 +890,10 @@ TcsResult tcs_send(TcsSocket socket, const uint8_t* buffer, size_t buffer_size,
     if (buffer == NULL || buffer_size == 0)
         return TCS_ERROR_INVALID_ARGUMENT;
 
+    TcsResult dontwait_sts = dontwait_check(socket, &flags, true);
+    if (dontwait_sts != TCS_SUCCESS)
+        return dontwait_sts;
+
     // Send all
     if (flags & TCS_MSG_SENDALL)
     {
@@ -516,6 +950,10 @@ TcsResult tcs_send_to(TcsSocket socket,
     if (flags & TCS_MSG_SENDALL)
         return TCS_ERROR_NOT_IMPLEMENTED;
 
+    TcsResult dontwait_sts = dontwait_check(socket, &flags, true);
+    if (dontwait_sts != TCS_SUCCESS)
+        return dontwait_sts;
+
     SOCKADDR_STORAGE native_sockaddr;
     memset(&native_sockaddr, 0, sizeof native_sockaddr);
     int addrlen = 0;
@@ -541,6 +979,23 @@ TcsResult tcs_send_to(TcsSocket socket,
     }
 }
 
+TcsResult tcs_send_to_from(TcsSocket socket,
+                           const uint8_t* buffer,
+                           size_t buffer_size,
+                           uint32_t flags,
+                           const struct TcsAddress* destination_address,
+                           const struct TcsAddress* source_address,
+                           TcsInterfaceId interface_id,
+                           size_t* sent_size)
+{
+    if (source_address == NULL && interface_id == 0)
+        return tcs_send_to(socket, buffer, buffer_size, flags, destination_address, sent_size);
+
+    if (sent_size != NULL)
+        *sent_size = 0;
+    return TCS_ERROR_NOT_SUPPORTED;
+}
+
 TcsResult tcs_sendv(TcsSocket socket, const struct TcsIoVec* iov, size_t iov_length, uint32_t flags, size_t* sent_size)
 {
     if (socket == TCS_SOCKET_INVALID || iov == NULL || iov_length == 0)
@@ -549,13 +1004,17 @@ TcsResult tcs_sendv(TcsSocket socket, const struct TcsIoVec* iov, size_t iov_len
     if (flags & TCS_MSG_SENDALL)
         return TCS_ERROR_NOT_IMPLEMENTED;
 
+    TcsResult dontwait_sts = dontwait_check(socket, &flags, true);
+    if (dontwait_sts != TCS_SUCCESS)
+        return dontwait_sts;
+
     WSABUF stack_buffers[TCS_CFG_SENDV_STACK_MAX];
     WSABUF* native_buffers = stack_buffers;
     WSABUF* heap_buffers = NULL;
 
     if (iov_length > TCS_CFG_SENDV_STACK_MAX)
     {
-        heap_buffers = (WSABUF*)malloc(sizeof(WSABUF) * iov_length);
+        heap_buffers = (WSABUF*)tcs_lib_malloc(sizeof(WSABUF) * iov_length);
         if (heap_buffers == NULL)
             return TCS_ERROR_MEMORY;
         native_buffers = heap_buffers;
@@ -565,7 +1024,7 @@ TcsResult tcs_sendv(TcsSocket socket, const struct TcsIoVec* iov, size_t iov_len
     {
         if (iov[i].buffer == NULL && iov[i].buffer_size > 0)
         {
-            free(heap_buffers);
+            tcs_lib_free(heap_buffers);
             return TCS_ERROR_INVALID_ARGUMENT;
         }
         // WSABUF.buf is non-const by Windows API design, but WSASend does not modify the data.
@@ -583,7 +1042,7 @@ TcsResult tcs_sendv(TcsSocket socket, const struct TcsIoVec* iov, size_t iov_len
     DWORD sent = 0;
     int wsasend_status = WSASend(socket, native_buffers, (DWORD)iov_length, &sent, (DWORD)flags, NULL, NULL);
 
-    free(heap_buffers);
+    tcs_lib_free(heap_buffers);
 
     if (wsasend_status != SOCKET_ERROR)
     {
@@ -606,6 +1065,14 @@ TcsResult tcs_receive(TcsSocket socket, uint8_t* buffer, size_t buffer_size, uin
     if (buffer == NULL && buffer_size > 0)
         return TCS_ERROR_INVALID_ARGUMENT;
 
+    TcsResult dontwait_sts = dontwait_check(socket, &flags, false);
+    if (dontwait_sts != TCS_SUCCESS)
+    {
+        if (received_size != NULL)
+            *received_size = 0;
+        return dontwait_sts;
+    }
+
 #if WINVER <= 0x501
     if (flags & TCS_MSG_WAITALL)
     {
@@ -671,6 +1138,10 @@ TcsResult tcs_receive_from(TcsSocket socket,
     if (received_size != NULL)
         *received_size = 0;
 
+    TcsResult dontwait_sts = dontwait_check(socket, &flags, false);
+    if (dontwait_sts != TCS_SUCCESS)
+        return dontwait_sts;
+
     SOCKADDR_STORAGE native_sockaddr;
     memset(&native_sockaddr, 0, sizeof native_sockaddr);
     int addrlen = sizeof(native_sockaddr);
@@ -709,9 +1180,44 @@ TcsResult tcs_receive_from(TcsSocket socket,
     }
 }
 
+TcsResult tcs_receive_from_to(TcsSocket socket,
+                              uint8_t* buffer,
+                              size_t buffer_size,
+                              uint32_t flags,
+                              struct TcsAddress* source_address,
+                              struct TcsAddress* destination_address,
+                              TcsInterfaceId* interface_id,
+                              size_t* received_size)
+{
+    (void)socket;
+    (void)buffer;
+    (void)buffer_size;
+    (void)flags;
+    (void)source_address;
+    (void)destination_address;
+    (void)interface_id;
+    if (received_size != NULL)
+        *received_size = 0;
+    // Requires WSARecvMsg() which has to be loaded at runtime through WSAIoctl()
+    return TCS_ERROR_NOT_SUPPORTED;
+}
+
 // tcs_receive_line() is defined in tinycsocket_common.c
 // tcs_receive_netstring() is defined in tinycsocket_common.c
 
+TcsResult tcs_receive_tx_timestamps(TcsSocket socket,
+                                    struct TcsTxTimestamp out_timestamps[],
+                                    size_t timestamps_length,
+                                    size_t* out_length)
+{
+    (void)socket;
+    (void)out_timestamps;
+    (void)timestamps_length;
+    if (out_length != NULL)
+        *out_length = 0;
+    return TCS_ERROR_NOT_SUPPORTED;
+}
+
 // ######## Socket Polling ########
 
 TcsResult tcs_poll_create(struct TcsPoll** out_poll)
@@ -719,7 +1225,7 @@ TcsResult tcs_poll_create(struct TcsPoll** out_poll)
     if (out_poll == NULL || *out_poll != NULL)
         return TCS_ERROR_INVALID_ARGUMENT;
 
-    *out_poll = (struct TcsPoll*)malloc(sizeof(struct TcsPoll));
+    *out_poll = (struct TcsPoll*)tcs_lib_malloc(sizeof(struct TcsPoll));
     if (*out_poll == NULL)
         return TCS_ERROR_MEMORY;
     memset(*out_poll, 0, sizeof(struct TcsPoll));
@@ -746,7 +1252,7 @@ TcsResult tcs_poll_destroy(struct TcsPoll** poll)
     tds_ulist_soc_destroy(&(*poll)->error_sockets);
     tds_map_socket_user_destroy(&(*poll)->user_data);
 
-    free(*poll);
+    tcs_lib_free(*poll);
     *poll = NULL;
 
     return TCS_SUCCESS;
@@ -929,7 +1435,7 @@ TcsResult tcs_poll_wait(struct TcsPoll* poll,
     }
     else
     {
-        rfds_heap = (struct tcs_fd_set*)malloc(data_offset + sizeof(SOCKET) * poll->read_sockets.count);
+        rfds_heap = (struct tcs_fd_set*)tcs_lib_malloc(data_offset + sizeof(SOCKET) * poll->read_sockets.count);
         if (rfds_heap == NULL)
             return TCS_ERROR_MEMORY;
         rfds_cpy = rfds_heap;
@@ -942,10 +1448,10 @@ TcsResult tcs_poll_wait(struct TcsPoll* poll,
     }
     else
     {
-        wfds_heap = (struct tcs_fd_set*)malloc(data_offset + sizeof(SOCKET) * poll->write_sockets.count);
+        wfds_heap = (struct tcs_fd_set*)tcs_lib_malloc(data_offset + sizeof(SOCKET) * poll->write_sockets.count);
         if (wfds_heap == NULL)
         {
-            free(rfds_heap);
+            tcs_lib_free(rfds_heap);
             return TCS_ERROR_MEMORY;
         }
         wfds_cpy = wfds_heap;
@@ -958,11 +1464,11 @@ TcsResult tcs_poll_wait(struct TcsPoll* poll,
     }
     else
     {
-        efds_heap = (struct tcs_fd_set*)malloc(data_offset + sizeof(SOCKET) * poll->error_sockets.count);
+        efds_heap = (struct tcs_fd_set*)tcs_lib_malloc(data_offset + sizeof(SOCKET) * poll->error_sockets.count);
         if (efds_heap == NULL)
         {
-            free(rfds_heap);
-            free(wfds_heap);
+            tcs_lib_free(rfds_heap);
+            tcs_lib_free(wfds_heap);
             return TCS_ERROR_MEMORY;
         }
         efds_cpy = efds_heap;
@@ -1077,11 +1583,11 @@ TcsResult tcs_poll_wait(struct TcsPoll* poll,
 
     // Clean up
     if (rfds_heap != NULL)
-        free(rfds_heap);
+        tcs_lib_free(rfds_heap);
     if (wfds_heap != NULL)
-        free(wfds_heap);
+        tcs_lib_free(wfds_heap);
     if (efds_heap != NULL)
-        free(efds_heap);
+        tcs_lib_free(efds_heap);
 
     if (no == 0)
     {
@@ -1096,6 +1602,95 @@ TcsResult tcs_poll_wait(struct TcsPoll* poll,
     return TCS_SUCCESS;
 }
 
+// ######## Connection Pool ########
+
+// tcs_pool_create() is defined in tinycsocket_common.c
+// tcs_pool_destroy() is defined in tinycsocket_common.c
+// tcs_pool_acquire() is defined in tinycsocket_common.c
+// tcs_pool_release() is defined in tinycsocket_common.c
+
+// ######## Asynchronous Resolve ########
+
+// tcs_resolver_create() is defined in tinycsocket_common.c
+// tcs_resolver_destroy() is defined in tinycsocket_common.c
+// tcs_resolver_socket() is defined in tinycsocket_common.c
+// tcs_resolver_submit() is defined in tinycsocket_common.c
+// tcs_resolver_take() is defined in tinycsocket_common.c
+// tcs_resolver_cancel() is defined in tinycsocket_common.c
+
+// ######## Packet Rings ########
+
+TcsResult tcs_packet_ring_rx_create(struct TcsPacketRing** out_ring,
+                                    TcsSocket socket,
+                                    size_t block_size,
+                                    size_t block_count,
+                                    size_t frame_size,
+                                    int block_timeout_ms)
+{
+    (void)out_ring;
+    (void)socket;
+    (void)block_size;
+    (void)block_count;
+    (void)frame_size;
+    (void)block_timeout_ms;
+    return TCS_ERROR_NOT_SUPPORTED;
+}
+
+TcsResult tcs_packet_ring_destroy(struct TcsPacketRing** ring)
+{
+    (void)ring;
+    return TCS_ERROR_NOT_SUPPORTED;
+}
+
+TcsResult tcs_packet_ring_rx_next(struct TcsPacketRing* ring, struct TcsPacketFrame* out_frame)
+{
+    (void)ring;
+    (void)out_frame;
+    return TCS_ERROR_NOT_SUPPORTED;
+}
+
+TcsResult tcs_packet_ring_rx_release(struct TcsPacketRing* ring)
+{
+    (void)ring;
+    return TCS_ERROR_NOT_SUPPORTED;
+}
+
+TcsResult tcs_packet_ring_tx_create(struct TcsPacketRing** out_ring,
+                                    TcsSocket socket,
+                                    size_t block_size,
+                                    size_t block_count,
+                                    size_t frame_size)
+{
+    (void)out_ring;
+    (void)socket;
+    (void)block_size;
+    (void)block_count;
+    (void)frame_size;
+    return TCS_ERROR_NOT_SUPPORTED;
+}
+
+TcsResult tcs_packet_ring_tx_acquire(struct TcsPacketRing* ring, uint8_t** out_data, size_t* out_capacity)
+{
+    (void)ring;
+    (void)out_data;
+    (void)out_capacity;
+    return TCS_ERROR_NOT_SUPPORTED;
+}
+
+TcsResult tcs_packet_ring_tx_commit(struct TcsPacketRing* ring, size_t frame_size)
+{
+    (void)ring;
+    (void)frame_size;
+    return TCS_ERROR_NOT_SUPPORTED;
+}
+
+TcsResult tcs_packet_ring_tx_flush(struct TcsPacketRing* ring, const struct TcsAddress* destination_address)
+{
+    (void)ring;
+    (void)destination_address;
+    return TCS_ERROR_NOT_SUPPORTED;
+}
+
 // ######## Socket Options ########
 
 TcsResult tcs_opt_set(TcsSocket socket,
@@ -1236,6 +1831,39 @@ TcsResult tcs_opt_linger_get(TcsSocket socket, bool* do_linger, int* timeout_sec
 
 // tcs_opt_ip_no_delay_set() is defined in tinycsocket_common.c
 // tcs_opt_ip_no_delay_get() is defined in tinycsocket_common.c
+
+// TCP Fast Open on Windows needs ConnectEx(), fall back to normal handshakes
+
+TcsResult tcs_opt_tcp_fast_open_set(TcsSocket socket, int queue_length)
+{
+    if (socket == TCS_SOCKET_INVALID || queue_length < 0)
+        return TCS_ERROR_INVALID_ARGUMENT;
+    return TCS_SUCCESS;
+}
+
+TcsResult tcs_opt_tcp_fast_open_get(TcsSocket socket, int* queue_length)
+{
+    if (socket == TCS_SOCKET_INVALID || queue_length == NULL)
+        return TCS_ERROR_INVALID_ARGUMENT;
+    *queue_length = 0;
+    return TCS_SUCCESS;
+}
+
+TcsResult tcs_opt_tcp_fast_open_connect_set(TcsSocket socket, bool do_fast_open)
+{
+    (void)do_fast_open;
+    if (socket == TCS_SOCKET_INVALID)
+        return TCS_ERROR_INVALID_ARGUMENT;
+    return TCS_SUCCESS;
+}
+
+TcsResult tcs_opt_tcp_fast_open_connect_get(TcsSocket socket, bool* is_fast_open)
+{
+    if (socket == TCS_SOCKET_INVALID || is_fast_open == NULL)
+        return TCS_ERROR_INVALID_ARGUMENT;
+    *is_fast_open = false;
+    return TCS_SUCCESS;
+}
 // tcs_opt_out_of_band_inline_set() is defined in tinycsocket_common.c
 // tcs_opt_out_of_band_inline_get() is defined in tinycsocket_common.c
 // tcs_opt_priority_set() is defined in tinycsocket_common.c
@@ -1259,6 +1887,76 @@ TcsResult tcs_opt_nonblocking_get(TcsSocket socket, bool* is_non_blocking)
     return TCS_ERROR_NOT_SUPPORTED;
 }
 
+TcsResult tcs_opt_tx_timestamping_set(TcsSocket socket, bool do_timestamp)
+{
+    (void)socket;
+    (void)do_timestamp;
+    return TCS_ERROR_NOT_SUPPORTED;
+}
+
+TcsResult tcs_opt_tx_timestamping_get(TcsSocket socket, bool* is_timestamping)
+{
+    (void)socket;
+    (void)is_timestamping;
+    return TCS_ERROR_NOT_SUPPORTED;
+}
+
+TcsResult tcs_opt_packet_info_set(TcsSocket socket, bool do_receive_packet_info)
+{
+    (void)socket;
+    (void)do_receive_packet_info;
+    return TCS_ERROR_NOT_SUPPORTED;
+}
+
+TcsResult tcs_opt_packet_info_get(TcsSocket socket, bool* is_packet_info_received)
+{
+    (void)socket;
+    (void)is_packet_info_received;
+    return TCS_ERROR_NOT_SUPPORTED;
+}
+
+TcsResult tcs_opt_packet_qdisc_bypass_set(TcsSocket socket, bool do_bypass)
+{
+    (void)socket;
+    (void)do_bypass;
+    return TCS_ERROR_NOT_SUPPORTED;
+}
+
+TcsResult tcs_opt_packet_qdisc_bypass_get(TcsSocket socket, bool* is_bypassed)
+{
+    (void)socket;
+    (void)is_bypassed;
+    return TCS_ERROR_NOT_SUPPORTED;
+}
+
+TcsResult tcs_opt_packet_fanout_join(TcsSocket socket, uint16_t group_id, TcsPacketFanoutMode mode)
+{
+    (void)socket;
+    (void)group_id;
+    (void)mode;
+    return TCS_ERROR_NOT_SUPPORTED;
+}
+
+TcsResult tcs_opt_reuse_port_steer_by_cpu(TcsSocket socket, size_t group_size)
+{
+    (void)socket;
+    (void)group_size;
+    return TCS_ERROR_NOT_SUPPORTED;
+}
+
+TcsResult tcs_opt_filter_attach(TcsSocket socket, const struct TcsFilter* filter)
+{
+    (void)socket;
+    (void)filter;
+    return TCS_ERROR_NOT_SUPPORTED;
+}
+
+TcsResult tcs_opt_filter_detach(TcsSocket socket)
+{
+    (void)socket;
+    return TCS_ERROR_NOT_SUPPORTED;
+}
+
 // tcs_opt_membership_add_str() is defined in tinycsocket_common.c
 
 TcsResult tcs_opt_membership_add(TcsSocket socket, const struct TcsAddress* multicast_address)
@@ -1505,7 +2203,7 @@ TcsResult tcs_interface_list(struct TcsInterface out_interfaces[], size_t interf
     ULONG adapter_sts = ERROR_NO_DATA;
     for (int i = 0; i < MAX_TRIES; ++i)
     {
-        adapters = (PIP_ADAPTER_ADDRESSES)malloc(buffer_size);
+        adapters = (PIP_ADAPTER_ADDRESSES)tcs_lib_malloc(buffer_size);
         if (adapters == NULL)
             return TCS_ERROR_MEMORY;
         adapter_sts = GetAdaptersAddresses(AF_UNSPEC,
@@ -1515,7 +2213,7 @@ TcsResult tcs_interface_list(struct TcsInterface out_interfaces[], size_t interf
                                            &buffer_size);
         if (adapter_sts == ERROR_BUFFER_OVERFLOW)
         {
-            free(adapters);
+            tcs_lib_free(adapters);
             adapters = NULL;
         }
         else
@@ -1526,7 +2224,7 @@ TcsResult tcs_interface_list(struct TcsInterface out_interfaces[], size_t interf
     if (adapter_sts == ERROR_NO_DATA)
     {
         if (adapters != NULL)
-            free(adapters);
+            tcs_lib_free(adapters);
         return TCS_SUCCESS;
     }
     if (adapter_sts != NO_ERROR)
@@ -1534,7 +2232,7 @@ TcsResult tcs_interface_list(struct TcsInterface out_interfaces[], size_t interf
         // Debug: log the actual Windows error code for diagnostics
         fprintf(stderr, "GetAdaptersAddresses failed with error: %lu (0x%lX)\n", adapter_sts, adapter_sts);
         if (adapters != NULL)
-            free(adapters);
+            tcs_lib_free(adapters);
         return TCS_ERROR_UNKNOWN;
     }
 
@@ -1546,7 +2244,7 @@ TcsResult tcs_interface_list(struct TcsInterface out_interfaces[], size_t interf
             TcsResult up_sts = adapter_is_up(iter, &is_up);
             if (up_sts != TCS_SUCCESS)
             {
-                free(adapters);
+                tcs_lib_free(adapters);
                 return TCS_ERROR_SYSTEM;
             }
             if (!is_up)
@@ -1559,7 +2257,7 @@ TcsResult tcs_interface_list(struct TcsInterface out_interfaces[], size_t interf
                     adapter_get_friendly_name(iter, out_interfaces[i].name, TCS_CFG_INTERFACE_NAME_SIZE - 1);
                 if (name_sts != TCS_SUCCESS)
                 {
-                    free(adapters);
+                    tcs_lib_free(adapters);
                     return TCS_ERROR_SYSTEM;
                 }
                 out_interfaces[i].id = iter->IfIndex;
@@ -1570,42 +2268,17 @@ TcsResult tcs_interface_list(struct TcsInterface out_interfaces[], size_t interf
         }
     }
 
-    free(adapters);
+    tcs_lib_free(adapters);
     return TCS_SUCCESS;
 }
 
-TcsResult tcs_address_resolve(const char* hostname,
-                              TcsFamily address_family,
-                              struct TcsAddress out_addresses[],
-                              size_t addresses_length,
-                              size_t* out_length)
+// Used by tinycsocket_common.c, see the declarations there
+TcsResult tcs_os_address_resolve_native(const char* hostname,
+                                       TcsFamily address_family,
+                                       struct TcsAddress out_addresses[],
+                                       size_t addresses_length,
+                                       size_t* out_length)
 {
-    if (hostname == NULL)
-        return TCS_ERROR_INVALID_ARGUMENT;
-
-    if (out_addresses == NULL && out_length == NULL)
-        return TCS_ERROR_INVALID_ARGUMENT;
-
-    if (out_length != NULL)
-        *out_length = 0;
-
-    // Fast path: try numeric/MAC parse first to avoid DNS lookup
-    struct TcsAddress parsed = TCS_ADDRESS_NONE;
-    if (tcs_address_parse(hostname, &parsed) == TCS_SUCCESS && parsed.family.native != TCS_FAMILY_ANY.native)
-    {
-        if (address_family.native == TCS_FAMILY_ANY.native || parsed.family.native == address_family.native)
-        {
-            if (out_addresses != NULL && addresses_length > 0)
-                out_addresses[0] = parsed;
-            if (out_length != NULL)
-                *out_length = 1;
-            return TCS_SUCCESS;
-        }
-    }
-
-    if (address_family.native == -1) // sentinel for unsupported families (e.g. TCS_FAMILY_PACKET on Windows)
-        return TCS_ERROR_NOT_SUPPORTED;
-
     ADDRINFOA native_hints;
     memset(&native_hints, 0, sizeof native_hints);
     native_hints.ai_family = address_family.native;
@@ -1647,6 +2320,12 @@ TcsResult tcs_address_resolve(const char* hostname,
     return TCS_SUCCESS;
 }
 
+// tcs_address_resolve() is defined in tinycsocket_common.c
+// tcs_address_cache_enable() is defined in tinycsocket_common.c
+// tcs_address_cache_disable() is defined in tinycsocket_common.c
+// tcs_address_cache_prefill() is defined in tinycsocket_common.c
+// tcs_address_cache_flush() is defined in tinycsocket_common.c
+
 TcsResult tcs_address_list(unsigned int interface_id_filter,
                            TcsFamily address_family_filter,
                            struct TcsInterfaceAddress out_interface_addresses[],
@@ -1668,7 +2347,7 @@ TcsResult tcs_address_list(unsigned int interface_id_filter,
     ULONG adapter_sts = ERROR_NO_DATA;
     for (int i = 0; i < MAX_TRIES; ++i)
     {
-        adapters = (PIP_ADAPTER_ADDRESSES)malloc(buffer_size);
+        adapters = (PIP_ADAPTER_ADDRESSES)tcs_lib_malloc(buffer_size);
         if (adapters == NULL)
             return TCS_ERROR_MEMORY;
         adapter_sts = GetAdaptersAddresses(AF_UNSPEC,
@@ -1678,7 +2357,7 @@ TcsResult tcs_address_list(unsigned int interface_id_filter,
                                            &buffer_size);
         if (adapter_sts == ERROR_BUFFER_OVERFLOW)
         {
-            free(adapters);
+            tcs_lib_free(adapters);
             adapters = NULL;
         }
         else
@@ -1689,13 +2368,13 @@ TcsResult tcs_address_list(unsigned int interface_id_filter,
     if (adapter_sts == ERROR_NO_DATA)
     {
         if (adapters != NULL)
-            free(adapters);
+            tcs_lib_free(adapters);
         return TCS_SUCCESS;
     }
     if (adapter_sts != NO_ERROR)
     {
         if (adapters != NULL)
-            free(adapters);
+            tcs_lib_free(adapters);
         return TCS_ERROR_UNKNOWN;
     }
 
@@ -1706,7 +2385,7 @@ TcsResult tcs_address_list(unsigned int interface_id_filter,
         TcsResult up_sts = adapter_is_up(iter, &is_up);
         if (up_sts != TCS_SUCCESS)
         {
-            free(adapters);
+            tcs_lib_free(adapters);
             return TCS_ERROR_SYSTEM;
         }
         if (!is_up)
@@ -1741,7 +2420,7 @@ TcsResult tcs_address_list(unsigned int interface_id_filter,
                     iter, out_interface_addresses[populated].iface.name, TCS_CFG_INTERFACE_NAME_SIZE - 1);
                 if (name_sts != TCS_SUCCESS)
                 {
-                    free(adapters);
+                    tcs_lib_free(adapters);
                     return TCS_ERROR_SYSTEM;
                 }
                 out_interface_addresses[populated].iface.id = iter->IfIndex;
@@ -1758,7 +2437,7 @@ TcsResult tcs_address_list(unsigned int interface_id_filter,
         }
     }
 
-    free(adapters);
+    tcs_lib_free(adapters);
     return TCS_SUCCESS;
 }
 
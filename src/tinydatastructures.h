@@ -1,46 +1,88 @@
 #ifndef TINYDATASTRUCTURES_H_
 #define TINYDATASTRUCTURES_H_
 
+#include <stddef.h>
+#include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
 
+// All memory comes from TDS_MALLOC, TDS_REALLOC and TDS_FREE, define them before including this file to use another
+// allocator. Inside tinycsocket they go through the tcs_lib_set_allocator() hooks.
+#ifndef TDS_MALLOC
+#ifdef TINYCSOCKET_INTERNAL_H_
+#define TDS_MALLOC(size) tcs_lib_malloc(size)
+#define TDS_REALLOC(ptr, size) tcs_lib_realloc(ptr, size)
+#define TDS_FREE(ptr) tcs_lib_free(ptr)
+#else
+#define TDS_MALLOC(size) malloc(size)
+#define TDS_REALLOC(ptr, size) realloc(ptr, size)
+#define TDS_FREE(ptr) free(ptr)
+#endif
+#endif
+
 #ifdef _MSC_VER
 #define TDS_UNUSED
 #else
 #define TDS_UNUSED __attribute__((unused))
 #endif
 
-static inline int tds_ulist_create(void** data, size_t* count, size_t* capacity, size_t element_size);
+// Growth and shrink behavior of a TdsUList or TdsMap, chosen per instantiation with the *_IMPL_WITH_POLICY macros.
+// Capacities step from minimum_capacity by growth_percent, 200 doubles. A list shrinks to fit when the count drops
+// below capacity / shrink_divisor, but never by a single step, and TDS_SHRINK_NEVER keeps the capacity until destroy.
+struct TdsGrowthPolicy
+{
+    size_t minimum_capacity; // Capacity after create
+    size_t growth_percent;   // Next capacity in percent of the current one, grows by at least one element
+    int is_zero_filled;      // Newly reserved elements are zeroed
+    size_t shrink_divisor;   // Or TDS_SHRINK_NEVER
+};
+
+#define TDS_SHRINK_NEVER 0
+
+static const struct TdsGrowthPolicy TDS_GROWTH_POLICY_DEFAULT = {8, 200, 1, 2};
+
+// For sets that go up and down in size, like poll sets, no realloc() or memset() once they have reached their peak
+static const struct TdsGrowthPolicy TDS_GROWTH_POLICY_NEVER_SHRINK = {8, 200, 0, TDS_SHRINK_NEVER};
+
+static inline int tds_ulist_create(
+    void** data, size_t* count, size_t* capacity, size_t element_size, const struct TdsGrowthPolicy* policy);
 static inline int tds_ulist_destroy(void** data, size_t* count, size_t* capacity);
-static inline int tds_ulist_reserve(void** data, size_t* capacity, size_t element_size, size_t requested_capacity);
+static inline int tds_ulist_reserve(void** data,
+                                    size_t* capacity,
+                                    size_t element_size,
+                                    size_t requested_capacity,
+                                    const struct TdsGrowthPolicy* policy);
 static inline int tds_ulist_add(void** data,
                                 size_t* count,
                                 size_t* capacity,
                                 size_t element_size,
                                 void* add_data,
-                                size_t add_count);
+                                size_t add_count,
+                                const struct TdsGrowthPolicy* policy);
 static inline int tds_ulist_remove(void** data,
                                    size_t* count,
                                    size_t* capacity,
                                    size_t element_size,
                                    size_t remove_from,
-                                   size_t remove_count);
+                                   size_t remove_count,
+                                   const struct TdsGrowthPolicy* policy);
 
-static inline int tds_ulist_create(void** data, size_t* count, size_t* capacity, size_t element_size)
+static inline int tds_ulist_create(
+    void** data, size_t* count, size_t* capacity, size_t element_size, const struct TdsGrowthPolicy* policy)
 {
     *data = NULL;
     *count = 0;
     *capacity = 0;
     if (element_size == 0)
         return -1;
-    return tds_ulist_reserve(data, capacity, element_size, 1);
+    return tds_ulist_reserve(data, capacity, element_size, 1, policy);
 }
 
 static inline int tds_ulist_destroy(void** data, size_t* count, size_t* capacity)
 {
     if (*data != NULL)
     {
-        free(*data);
+        TDS_FREE(*data);
         *data = NULL;
     }
     *count = 0;
@@ -48,27 +90,44 @@ static inline int tds_ulist_destroy(void** data, size_t* count, size_t* capacity
     return 0;
 }
 
-// TODO: move to reserve
-static inline size_t tds_ulist_best_capacity_fit(size_t old_capacity, size_t new_capacity)
+static inline size_t tds_ulist_next_capacity(const struct TdsGrowthPolicy* policy, size_t capacity)
 {
-    const size_t MINIMUM_CAPACITY = 8;
+    size_t next = capacity * policy->growth_percent / 100;
+    return next > capacity ? next : capacity + 1;
+}
 
-    size_t c = MINIMUM_CAPACITY;
+// TODO: move to reserve
+static inline size_t tds_ulist_policy_capacity_fit(const struct TdsGrowthPolicy* policy,
+                                                   size_t old_capacity,
+                                                   size_t new_capacity)
+{
+    size_t c = policy->minimum_capacity > 0 ? policy->minimum_capacity : 1;
     while (c < new_capacity)
-        c *= 2;
+        c = tds_ulist_next_capacity(policy, c);
 
     // Hysteresis
-    if (c * 2 == old_capacity)
+    if (tds_ulist_next_capacity(policy, c) == old_capacity)
         return old_capacity;
 
     return c;
 }
 
-static inline int tds_ulist_reserve(void** data, size_t* capacity, size_t element_size, size_t requested_capacity)
+static inline size_t tds_ulist_best_capacity_fit(size_t old_capacity, size_t new_capacity)
 {
-    size_t new_capacity = tds_ulist_best_capacity_fit(*capacity, requested_capacity);
+    return tds_ulist_policy_capacity_fit(&TDS_GROWTH_POLICY_DEFAULT, old_capacity, new_capacity);
+}
+
+static inline int tds_ulist_reserve(void** data,
+                                    size_t* capacity,
+                                    size_t element_size,
+                                    size_t requested_capacity,
+                                    const struct TdsGrowthPolicy* policy)
+{
+    size_t new_capacity = tds_ulist_policy_capacity_fit(policy, *capacity, requested_capacity);
     if (new_capacity == *capacity)
         return 0;
+    if (new_capacity < *capacity && policy->shrink_divisor == TDS_SHRINK_NEVER)
+        return 0;
 
 // UB protection for C23 and implemention defined protection before C23 (Should never happen)
 #ifndef NDEBUG
@@ -76,11 +135,11 @@ static inline int tds_ulist_reserve(void** data, size_t* capacity, size_t elemen
         return -1;
 #endif
 
-    void* new_data = realloc(*data, new_capacity * element_size);
+    void* new_data = TDS_REALLOC(*data, new_capacity * element_size);
     if (new_data == NULL)
         return -1;
 
-    if (new_capacity > *capacity)
+    if (policy->is_zero_filled && new_capacity > *capacity)
     {
         memset((char*)new_data + *capacity * element_size, 0, (new_capacity - *capacity) * element_size);
     }
@@ -94,11 +153,12 @@ static inline int tds_ulist_add(void** data,
                                 size_t* capacity,
                                 size_t element_size,
                                 void* add_data,
-                                size_t add_count)
+                                size_t add_count,
+                                const struct TdsGrowthPolicy* policy)
 {
     if (*count + add_count > *capacity)
     {
-        int reserve_sts = tds_ulist_reserve(data, capacity, element_size, *count + add_count);
+        int reserve_sts = tds_ulist_reserve(data, capacity, element_size, *count + add_count, policy);
         if (reserve_sts != 0)
             return reserve_sts;
     }
@@ -113,7 +173,8 @@ static inline int tds_ulist_remove(void** data,
                                    size_t* capacity,
                                    size_t element_size,
                                    size_t remove_from,
-                                   size_t remove_count)
+                                   size_t remove_count,
+                                   const struct TdsGrowthPolicy* policy)
 {
     if (remove_from >= *count || remove_count == 0 || remove_from + remove_count > *count)
         return -1;
@@ -123,9 +184,9 @@ static inline int tds_ulist_remove(void** data,
     memmove(dst, src, element_size * remove_count);
     *count -= remove_count;
 
-    if (*count < *capacity / 2)
+    if (policy->shrink_divisor != TDS_SHRINK_NEVER && *count < *capacity / policy->shrink_divisor)
     {
-        int reserve_sts = tds_ulist_reserve(data, capacity, element_size, *count);
+        int reserve_sts = tds_ulist_reserve(data, capacity, element_size, *count, policy);
         if (reserve_sts != 0)
             return reserve_sts;
     }
@@ -133,7 +194,7 @@ static inline int tds_ulist_remove(void** data,
     return 0;
 }
 
-#define TDS_ULIST_IMPL(TYPE, NAME)                                                                                     \
+#define TDS_ULIST_IMPL_WITH_POLICY(TYPE, NAME, POLICY)                                                                 \
     struct TdsUList_##NAME                                                                                             \
     {                                                                                                                  \
         TYPE* data;                                                                                                    \
@@ -143,7 +204,7 @@ static inline int tds_ulist_remove(void** data,
                                                                                                                        \
     TDS_UNUSED static inline int tds_ulist_##NAME##_create(struct TdsUList_##NAME* ulist)                              \
     {                                                                                                                  \
-        return tds_ulist_create((void**)&ulist->data, &ulist->count, &ulist->capacity, sizeof(TYPE));                  \
+        return tds_ulist_create((void**)&ulist->data, &ulist->count, &ulist->capacity, sizeof(TYPE), (POLICY));        \
     }                                                                                                                  \
     TDS_UNUSED static inline int tds_ulist_##NAME##_destroy(struct TdsUList_##NAME* ulist)                             \
     {                                                                                                                  \
@@ -153,19 +214,22 @@ static inline int tds_ulist_remove(void** data,
     }                                                                                                                  \
     TDS_UNUSED static inline int tds_ulist_##NAME##_add(struct TdsUList_##NAME* ulist, TYPE* data, size_t count)       \
     {                                                                                                                  \
-        return tds_ulist_add((void**)&ulist->data, &ulist->count, &ulist->capacity, sizeof(TYPE), (void*)data, count); \
+        return tds_ulist_add(                                                                                          \
+            (void**)&ulist->data, &ulist->count, &ulist->capacity, sizeof(TYPE), (void*)data, count, (POLICY));        \
     }                                                                                                                  \
     TDS_UNUSED static inline int tds_ulist_##NAME##_remove(                                                            \
         struct TdsUList_##NAME* ulist, size_t remove_from, size_t remove_count)                                        \
     {                                                                                                                  \
         return tds_ulist_remove(                                                                                       \
-            (void**)&ulist->data, &ulist->count, &ulist->capacity, sizeof(TYPE), remove_from, remove_count);           \
+            (void**)&ulist->data, &ulist->count, &ulist->capacity, sizeof(TYPE), remove_from, remove_count, (POLICY)); \
     }                                                                                                                  \
     TDS_UNUSED static inline int tds_ulist_##NAME##_reserve(struct TdsUList_##NAME* ulist, size_t new_capacity)        \
     {                                                                                                                  \
-        return tds_ulist_reserve((void**)&ulist->data, &ulist->capacity, sizeof(TYPE), new_capacity);                  \
+        return tds_ulist_reserve((void**)&ulist->data, &ulist->capacity, sizeof(TYPE), new_capacity, (POLICY));        \
     }
 
+#define TDS_ULIST_IMPL(TYPE, NAME) TDS_ULIST_IMPL_WITH_POLICY(TYPE, NAME, &TDS_GROWTH_POLICY_DEFAULT)
+
 // Tiny Data Structures Map Implementation
 
 static inline int tds_map_create(void** keys,
@@ -173,7 +237,8 @@ static inline int tds_map_create(void** keys,
                                  size_t* count,
                                  size_t* capacity,
                                  size_t key_element_size,
-                                 size_t value_element_size)
+                                 size_t value_element_size,
+                                 const struct TdsGrowthPolicy* policy)
 {
     size_t key_capacity = 0;
     size_t key_count = 0;
@@ -181,8 +246,8 @@ static inline int tds_map_create(void** keys,
     size_t value_capacity = 0;
     size_t value_count = 0;
 
-    int key_sts = tds_ulist_create(keys, &key_count, &key_capacity, key_element_size);
-    int value_sts = tds_ulist_create(values, &value_count, &value_capacity, value_element_size);
+    int key_sts = tds_ulist_create(keys, &key_count, &key_capacity, key_element_size, policy);
+    int value_sts = tds_ulist_create(values, &value_count, &value_capacity, value_element_size, policy);
 
     if (key_sts != 0 || value_sts != 0)
     {
@@ -231,14 +296,15 @@ static inline int tds_map_add(void** keys,
                               size_t key_element_size,
                               size_t value_element_size,
                               void* key_add,
-                              void* value_add)
+                              void* value_add,
+                              const struct TdsGrowthPolicy* policy)
 {
     size_t value_count = *count;
     size_t key_count = *count;
     size_t key_capacity = *capacity;
     size_t value_capacity = *capacity;
-    int key_sts = tds_ulist_add(keys, &key_count, &key_capacity, key_element_size, key_add, 1);
-    int value_sts = tds_ulist_add(values, &value_count, &value_capacity, value_element_size, value_add, 1);
+    int key_sts = tds_ulist_add(keys, &key_count, &key_capacity, key_element_size, key_add, 1, policy);
+    int value_sts = tds_ulist_add(values, &value_count, &value_capacity, value_element_size, value_add, 1, policy);
     if (key_sts != 0 || value_sts != 0)
     {
         // TODO: fix invariant memory state. Restore memory capacity should work most of the time.
@@ -260,7 +326,8 @@ static inline int tds_map_remove(void** keys,
                                  size_t* capacity,
                                  size_t key_element_size,
                                  size_t value_element_size,
-                                 size_t index)
+                                 size_t index,
+                                 const struct TdsGrowthPolicy* policy)
 {
     size_t value_count = *count;
     size_t key_count = *count;
@@ -269,8 +336,8 @@ static inline int tds_map_remove(void** keys,
     if (index >= *count)
         return -1;
 
-    int key_sts = tds_ulist_remove(keys, &key_count, &key_capacity, key_element_size, index, 1);
-    int value_sts = tds_ulist_remove(values, &value_count, &value_capacity, value_element_size, index, 1);
+    int key_sts = tds_ulist_remove(keys, &key_count, &key_capacity, key_element_size, index, 1, policy);
+    int value_sts = tds_ulist_remove(values, &value_count, &value_capacity, value_element_size, index, 1, policy);
     if (key_sts != 0 || value_sts != 0)
     {
         // -2 indicates we are in a very bad situation and the data structure may be corrupted.
@@ -284,65 +351,820 @@ static inline int tds_map_remove(void** keys,
     return 0;
 }
 
+#define TDS_MAP_IMPL_WITH_POLICY(KEY_TYPE, VALUE_TYPE, NAME, POLICY)                                               \
+                                                                                                                   \
+    struct TdsMap_##NAME                                                                                           \
+    {                                                                                                              \
+        KEY_TYPE* keys;                                                                                            \
+        VALUE_TYPE* values;                                                                                        \
+        size_t count;                                                                                              \
+        size_t capacity;                                                                                           \
+    };                                                                                                             \
+                                                                                                                   \
+    TDS_UNUSED static inline int tds_map_##NAME##_create(struct TdsMap_##NAME* map)                                \
+    {                                                                                                              \
+        memset(map, 0, sizeof(struct TdsMap_##NAME));                                                              \
+        return tds_map_create((void**)&map->keys,                                                                  \
+                              (void**)&map->values,                                                                \
+                              &map->count,                                                                         \
+                              &map->capacity,                                                                      \
+                              sizeof(KEY_TYPE),                                                                    \
+                              sizeof(VALUE_TYPE),                                                                  \
+                              (POLICY));                                                                           \
+    }                                                                                                              \
+    TDS_UNUSED static inline int tds_map_##NAME##_destroy(struct TdsMap_##NAME* map)                               \
+    {                                                                                                              \
+        int sts = tds_map_destroy((void**)&map->keys, (void**)&map->values, &map->count, &map->capacity);          \
+        if (sts != 0)                                                                                              \
+            return sts;                                                                                            \
+        memset(map, 0, sizeof(struct TdsMap_##NAME));                                                              \
+        return 0;                                                                                                  \
+    }                                                                                                              \
+    TDS_UNUSED static inline int tds_map_##NAME##_add(struct TdsMap_##NAME* map, KEY_TYPE key, VALUE_TYPE value)   \
+    {                                                                                                              \
+        return tds_map_add((void**)&map->keys,                                                                     \
+                           (void**)&map->values,                                                                   \
+                           &map->count,                                                                            \
+                           &map->capacity,                                                                         \
+                           sizeof(KEY_TYPE),                                                                       \
+                           sizeof(VALUE_TYPE),                                                                     \
+                           &key,                                                                                   \
+                           &value,                                                                                 \
+                           (POLICY));                                                                              \
+    }                                                                                                              \
+    TDS_UNUSED static inline int tds_map_##NAME##_addp(struct TdsMap_##NAME* map, KEY_TYPE* key, VALUE_TYPE* value)\
+    {                                                                                                              \
+        return tds_map_add((void**)&map->keys,                                                                     \
+                           (void**)&map->values,                                                                   \
+                           &map->count,                                                                            \
+                           &map->capacity,                                                                         \
+                           sizeof(KEY_TYPE),                                                                       \
+                           sizeof(VALUE_TYPE),                                                                     \
+                           key,                                                                                    \
+                           value,                                                                                  \
+                           (POLICY));                                                                              \
+    }                                                                                                              \
+    TDS_UNUSED static inline int tds_map_##NAME##_remove(struct TdsMap_##NAME* map, size_t index)                  \
+    {                                                                                                              \
+        return tds_map_remove((void**)&map->keys,                                                                  \
+                              (void**)&map->values,                                                                \
+                              &map->count,                                                                         \
+                              &map->capacity,                                                                      \
+                              sizeof(KEY_TYPE),                                                                    \
+                              sizeof(VALUE_TYPE),                                                                  \
+                              index,                                                                               \
+                              (POLICY));                                                                           \
+    }
+
 #define TDS_MAP_IMPL(KEY_TYPE, VALUE_TYPE, NAME)                                                                    \
-                                                                                                                    \
-    struct TdsMap_##NAME                                                                                            \
-    {                                                                                                               \
-        KEY_TYPE* keys;                                                                                             \
-        VALUE_TYPE* values;                                                                                         \
-        size_t count;                                                                                               \
-        size_t capacity;                                                                                            \
-    };                                                                                                              \
-                                                                                                                    \
-    TDS_UNUSED static inline int tds_map_##NAME##_create(struct TdsMap_##NAME* map)                                 \
-    {                                                                                                               \
-        memset(map, 0, sizeof(struct TdsMap_##NAME));                                                               \
-        return tds_map_create((void**)&map->keys,                                                                   \
-                              (void**)&map->values,                                                                 \
-                              &map->count,                                                                          \
-                              &map->capacity,                                                                       \
-                              sizeof(KEY_TYPE),                                                                     \
-                              sizeof(VALUE_TYPE));                                                                  \
-    }                                                                                                               \
-    TDS_UNUSED static inline int tds_map_##NAME##_destroy(struct TdsMap_##NAME* map)                                \
-    {                                                                                                               \
-        int sts = tds_map_destroy((void**)&map->keys, (void**)&map->values, &map->count, &map->capacity);           \
-        if (sts != 0)                                                                                               \
-            return sts;                                                                                             \
-        memset(map, 0, sizeof(struct TdsMap_##NAME));                                                               \
-        return 0;                                                                                                   \
-    }                                                                                                               \
-    TDS_UNUSED static inline int tds_map_##NAME##_add(struct TdsMap_##NAME* map, KEY_TYPE key, VALUE_TYPE value)    \
-    {                                                                                                               \
-        return tds_map_add((void**)&map->keys,                                                                      \
-                           (void**)&map->values,                                                                    \
-                           &map->count,                                                                             \
-                           &map->capacity,                                                                          \
-                           sizeof(KEY_TYPE),                                                                        \
-                           sizeof(VALUE_TYPE),                                                                      \
-                           &key,                                                                                    \
-                           &value);                                                                                 \
-    }                                                                                                               \
-    TDS_UNUSED static inline int tds_map_##NAME##_addp(struct TdsMap_##NAME* map, KEY_TYPE* key, VALUE_TYPE* value) \
-    {                                                                                                               \
-        return tds_map_add((void**)&map->keys,                                                                      \
-                           (void**)&map->values,                                                                    \
-                           &map->count,                                                                             \
-                           &map->capacity,                                                                          \
-                           sizeof(KEY_TYPE),                                                                        \
-                           sizeof(VALUE_TYPE),                                                                      \
-                           key,                                                                                     \
-                           value);                                                                                  \
-    }                                                                                                               \
-    TDS_UNUSED static inline int tds_map_##NAME##_remove(struct TdsMap_##NAME* map, size_t index)                   \
-    {                                                                                                               \
-        return tds_map_remove((void**)&map->keys,                                                                   \
-                              (void**)&map->values,                                                                 \
-                              &map->count,                                                                          \
-                              &map->capacity,                                                                       \
-                              sizeof(KEY_TYPE),                                                                     \
-                              sizeof(VALUE_TYPE),                                                                   \
-                              index);                                                                               \
+    TDS_MAP_IMPL_WITH_POLICY(KEY_TYPE, VALUE_TYPE, NAME, &TDS_GROWTH_POLICY_DEFAULT)
+
+// Tiny Data Structures Hash Map Implementation
+// Robin Hood open addressing over power of two capacities. HASH(const KEY_TYPE*, uint64_t seed) returns the hash as
+// uint64_t and EQ(const KEY_TYPE*, const KEY_TYPE*) is true for equal keys. Probing reads one metadata byte per slot,
+// the distance from the home slot, and only calls EQ for slots with the same home. Removal shifts entries back so no
+// tombstones are left and lookups of missing keys stay short.
+
+static inline size_t tds_hmap_capacity_fit(size_t count)
+{
+    const size_t MINIMUM_CAPACITY = 8;
+
+    // At most three quarters full
+    size_t c = MINIMUM_CAPACITY;
+    while (c - c / 4 < count)
+        c *= 2;
+    return c;
+}
+
+#define TDS_HMAP_IMPL(KEY_TYPE, VALUE_TYPE, NAME, HASH, EQ)                                                            \
+    typedef KEY_TYPE TdsHMapKey_##NAME;                                                                                \
+    typedef VALUE_TYPE TdsHMapValue_##NAME;                                                                            \
+    struct TdsHMap_##NAME                                                                                              \
+    {                                                                                                                  \
+        TdsHMapKey_##NAME* keys;                                                                                       \
+        TdsHMapValue_##NAME* values;                                                                                   \
+        uint8_t* distances; /* Probe distance + 1 per slot, 0 for empty */                                             \
+        size_t count;                                                                                                  \
+        size_t capacity;                                                                                               \
+        uint64_t seed;                                                                                                 \
+    };                                                                                                                 \
+                                                                                                                       \
+    TDS_UNUSED static inline int tds_hmap_##NAME##_create(struct TdsHMap_##NAME* map, uint64_t seed)                   \
+    {                                                                                                                  \
+        memset(map, 0, sizeof(struct TdsHMap_##NAME));                                                                 \
+        map->seed = seed;                                                                                              \
+        return 0;                                                                                                      \
+    }                                                                                                                  \
+    TDS_UNUSED static inline int tds_hmap_##NAME##_destroy(struct TdsHMap_##NAME* map)                                 \
+    {                                                                                                                  \
+        TDS_FREE(map->keys);                                                                                           \
+        TDS_FREE(map->values);                                                                                         \
+        TDS_FREE(map->distances);                                                                                      \
+        memset(map, 0, sizeof(struct TdsHMap_##NAME));                                                                 \
+        return 0;                                                                                                      \
+    }                                                                                                                  \
+    TDS_UNUSED static inline size_t tds_hmap_##NAME##_find(                                                            \
+        const struct TdsHMap_##NAME* map, const TdsHMapKey_##NAME* key)                                                \
+    {                                                                                                                  \
+        if (map->count == 0)                                                                                           \
+            return map->capacity;                                                                                      \
+        size_t mask = map->capacity - 1;                                                                               \
+        size_t i = (size_t)HASH(key, map->seed) & mask;                                                                \
+        /* A slot closer to its home than we are to ours ends the search, our key would have taken it */               \
+        for (uint8_t distance = 1; map->distances[i] >= distance; ++distance, i = (i + 1) & mask)                      \
+        {                                                                                                              \
+            if (map->distances[i] == distance && EQ(&map->keys[i], key))                                               \
+                return i;                                                                                              \
+        }                                                                                                              \
+        return map->capacity;                                                                                          \
+    }                                                                                                                  \
+    /* Places a key known to be missing starting at its hash, or with is_dry_run only checks that it can be placed. */ \
+    /* Returns 1 without touching the map if a probe distance would not fit the metadata byte. */                      \
+    TDS_UNUSED static inline int tds_hmap_##NAME##_place(struct TdsHMap_##NAME* map,                                   \
+                                                         uint64_t hash,                                                \
+                                                         TdsHMapKey_##NAME key,                                        \
+                                                         TdsHMapValue_##NAME value,                                    \
+                                                         int is_dry_run)                                               \
+    {                                                                                                                  \
+        if (!is_dry_run && tds_hmap_##NAME##_place(map, hash, key, value, 1) != 0)                                     \
+            return 1;                                                                                                  \
+        size_t mask = map->capacity - 1;                                                                               \
+        size_t i = (size_t)hash & mask;                                                                                \
+        for (uint8_t distance = 1; distance < UINT8_MAX; ++distance, i = (i + 1) & mask)                               \
+        {                                                                                                              \
+            if (map->distances[i] == 0)                                                                                \
+            {                                                                                                          \
+                if (!is_dry_run)                                                                                       \
+                {                                                                                                      \
+                    map->keys[i] = key;                                                                                \
+                    map->values[i] = value;                                                                            \
+                    map->distances[i] = distance;                                                                      \
+                }                                                                                                      \
+                return 0;                                                                                              \
+            }                                                                                                          \
+            if (map->distances[i] < distance)                                                                          \
+            {                                                                                                          \
+                /* Robin Hood: take the slot from the entry closer to its home and continue placing that one */        \
+                uint8_t displaced_distance = map->distances[i];                                                        \
+                if (!is_dry_run)                                                                                       \
+                {                                                                                                      \
+                    TdsHMapKey_##NAME displaced_key = map->keys[i];                                                    \
+                    TdsHMapValue_##NAME displaced_value = map->values[i];                                              \
+                    map->keys[i] = key;                                                                                \
+                    map->values[i] = value;                                                                            \
+                    map->distances[i] = distance;                                                                      \
+                    key = displaced_key;                                                                               \
+                    value = displaced_value;                                                                           \
+                }                                                                                                      \
+                distance = displaced_distance;                                                                         \
+            }                                                                                                          \
+        }                                                                                                              \
+        return 1;                                                                                                      \
+    }                                                                                                                  \
+    TDS_UNUSED static inline int tds_hmap_##NAME##_rehash(struct TdsHMap_##NAME* map, size_t new_capacity)             \
+    {                                                                                                                  \
+        struct TdsHMap_##NAME grown = *map;                                                                            \
+        grown.keys = (TdsHMapKey_##NAME*)TDS_MALLOC(new_capacity * sizeof(TdsHMapKey_##NAME));                         \
+        grown.values = (TdsHMapValue_##NAME*)TDS_MALLOC(new_capacity * sizeof(TdsHMapValue_##NAME));                   \
+        grown.distances = (uint8_t*)TDS_MALLOC(new_capacity);                                                          \
+        grown.capacity = new_capacity;                                                                                 \
+        int sts = grown.keys == NULL || grown.values == NULL || grown.distances == NULL ? -1 : 0;                      \
+        if (sts == 0)                                                                                                  \
+            memset(grown.distances, 0, new_capacity);                                                                  \
+        for (size_t i = 0; sts == 0 && i < map->capacity; ++i)                                                         \
+        {                                                                                                              \
+            if (map->distances[i] != 0)                                                                                \
+                sts = tds_hmap_##NAME##_place(                                                                         \
+                    &grown, HASH(&map->keys[i], map->seed), map->keys[i], map->values[i], 0);                          \
+        }                                                                                                              \
+        if (sts != 0)                                                                                                  \
+        {                                                                                                              \
+            TDS_FREE(grown.keys);                                                                                      \
+            TDS_FREE(grown.values);                                                                                    \
+            TDS_FREE(grown.distances);                                                                                 \
+            /* Probe sequences too long for the metadata byte, a sparser table spreads them out unless HASH is bad */  \
+            if (sts == 1 && new_capacity / 64 <= map->count)                                                           \
+                return tds_hmap_##NAME##_rehash(map, new_capacity * 2);                                                \
+            return -1;                                                                                                 \
+        }                                                                                                              \
+        TDS_FREE(map->keys);                                                                                           \
+        TDS_FREE(map->values);                                                                                         \
+        TDS_FREE(map->distances);                                                                                      \
+        *map = grown;                                                                                                  \
+        return 0;                                                                                                      \
+    }                                                                                                                  \
+    TDS_UNUSED static inline int tds_hmap_##NAME##_reserve(struct TdsHMap_##NAME* map, size_t count)                   \
+    {                                                                                                                  \
+        size_t new_capacity = tds_hmap_capacity_fit(count);                                                            \
+        if (new_capacity <= map->capacity)                                                                             \
+            return 0;                                                                                                  \
+        return tds_hmap_##NAME##_rehash(map, new_capacity);                                                            \
+    }                                                                                                                  \
+    TDS_UNUSED static inline TdsHMapValue_##NAME* tds_hmap_##NAME##_get(                                               \
+        const struct TdsHMap_##NAME* map, const TdsHMapKey_##NAME* key)                                                \
+    {                                                                                                                  \
+        size_t i = tds_hmap_##NAME##_find(map, key);                                                                   \
+        return i < map->capacity ? &map->values[i] : NULL;                                                             \
+    }                                                                                                                  \
+    TDS_UNUSED static inline int tds_hmap_##NAME##_set(                                                                \
+        struct TdsHMap_##NAME* map, const TdsHMapKey_##NAME* key, const TdsHMapValue_##NAME* value)                    \
+    {                                                                                                                  \
+        size_t i = tds_hmap_##NAME##_find(map, key);                                                                   \
+        if (i < map->capacity)                                                                                         \
+        {                                                                                                              \
+            map->values[i] = *value;                                                                                   \
+            return 0;                                                                                                  \
+        }                                                                                                              \
+        if (tds_hmap_##NAME##_reserve(map, map->count + 1) != 0)                                                       \
+            return -1;                                                                                                 \
+        uint64_t hash = HASH(key, map->seed);                                                                          \
+        while (tds_hmap_##NAME##_place(map, hash, *key, *value, 0) != 0)                                               \
+        {                                                                                                              \
+            if (map->capacity / 64 > map->count || tds_hmap_##NAME##_rehash(map, map->capacity * 2) != 0)              \
+                return -1;                                                                                             \
+        }                                                                                                              \
+        map->count++;                                                                                                  \
+        return 0;                                                                                                      \
+    }                                                                                                                  \
+    TDS_UNUSED static inline int tds_hmap_##NAME##_remove(struct TdsHMap_##NAME* map, const TdsHMapKey_##NAME* key)    \
+    {                                                                                                                  \
+        size_t i = tds_hmap_##NAME##_find(map, key);                                                                   \
+        if (i == map->capacity)                                                                                        \
+            return -1;                                                                                                 \
+        size_t mask = map->capacity - 1;                                                                               \
+        /* Backward shift instead of a tombstone, every following entry away from home moves one step closer */        \
+        for (size_t next = (i + 1) & mask; map->distances[next] > 1; i = next, next = (next + 1) & mask)               \
+        {                                                                                                              \
+            map->keys[i] = map->keys[next];                                                                            \
+            map->values[i] = map->values[next];                                                                        \
+            map->distances[i] = (uint8_t)(map->distances[next] - 1);                                                   \
+        }                                                                                                              \
+        map->distances[i] = 0;                                                                                         \
+        map->count--;                                                                                                  \
+        return 0;                                                                                                      \
     }
 
+
+// Tiny Data Structures Atomics
+// Just enough atomics on a size_t for the rings below. C11 <stdatomic.h> when compiled as C11, the __atomic builtins
+// on GCC and Clang (C++ and C99 included) and volatile plus barriers on MSVC. TDS_HAS_ATOMICS is left undefined on
+// other compilers and the rings are not available there.
+
+#if !defined(__cplusplus) && defined(__STDC_VERSION__) && __STDC_VERSION__ >= 201112L && !defined(__STDC_NO_ATOMICS__)
+#include <stdatomic.h>
+#define TDS_HAS_ATOMICS
+typedef _Atomic size_t TdsAtomicSize;
+
+static inline size_t tds_atomic_load_relaxed(TdsAtomicSize* atomic)
+{
+    return atomic_load_explicit(atomic, memory_order_relaxed);
+}
+
+static inline size_t tds_atomic_load_acquire(TdsAtomicSize* atomic)
+{
+    return atomic_load_explicit(atomic, memory_order_acquire);
+}
+
+static inline void tds_atomic_store_relaxed(TdsAtomicSize* atomic, size_t value)
+{
+    atomic_store_explicit(atomic, value, memory_order_relaxed);
+}
+
+static inline void tds_atomic_store_release(TdsAtomicSize* atomic, size_t value)
+{
+    atomic_store_explicit(atomic, value, memory_order_release);
+}
+
+// On failure expected is updated with the current value
+static inline int tds_atomic_compare_exchange(TdsAtomicSize* atomic, size_t* expected, size_t desired)
+{
+    return atomic_compare_exchange_weak_explicit(atomic, expected, desired, memory_order_acq_rel, memory_order_relaxed);
+}
+#elif defined(__GNUC__)
+#define TDS_HAS_ATOMICS
+typedef size_t TdsAtomicSize;
+
+static inline size_t tds_atomic_load_relaxed(TdsAtomicSize* atomic)
+{
+    return __atomic_load_n(atomic, __ATOMIC_RELAXED);
+}
+
+static inline size_t tds_atomic_load_acquire(TdsAtomicSize* atomic)
+{
+    return __atomic_load_n(atomic, __ATOMIC_ACQUIRE);
+}
+
+static inline void tds_atomic_store_relaxed(TdsAtomicSize* atomic, size_t value)
+{
+    __atomic_store_n(atomic, value, __ATOMIC_RELAXED);
+}
+
+static inline void tds_atomic_store_release(TdsAtomicSize* atomic, size_t value)
+{
+    __atomic_store_n(atomic, value, __ATOMIC_RELEASE);
+}
+
+// On failure expected is updated with the current value
+static inline int tds_atomic_compare_exchange(TdsAtomicSize* atomic, size_t* expected, size_t desired)
+{
+    return __atomic_compare_exchange_n(atomic, expected, desired, 1, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED);
+}
+#elif defined(_MSC_VER)
+#include <intrin.h>
+#define TDS_HAS_ATOMICS
+typedef volatile size_t TdsAtomicSize;
+
+// x86 and x64 only reorder stores after loads, ARM needs a real barrier for acquire and release
+static inline void tds_atomic_barrier(void)
+{
+#if defined(_M_ARM64)
+    __dmb(_ARM64_BARRIER_ISH);
+#elif defined(_M_ARM)
+    __dmb(_ARM_BARRIER_ISH);
+#else
+    _ReadWriteBarrier();
+#endif
+}
+
+static inline size_t tds_atomic_load_relaxed(TdsAtomicSize* atomic)
+{
+    return *atomic;
+}
+
+static inline size_t tds_atomic_load_acquire(TdsAtomicSize* atomic)
+{
+    size_t value = *atomic;
+    tds_atomic_barrier();
+    return value;
+}
+
+static inline void tds_atomic_store_relaxed(TdsAtomicSize* atomic, size_t value)
+{
+    *atomic = value;
+}
+
+static inline void tds_atomic_store_release(TdsAtomicSize* atomic, size_t value)
+{
+    tds_atomic_barrier();
+    *atomic = value;
+}
+
+// On failure expected is updated with the current value
+static inline int tds_atomic_compare_exchange(TdsAtomicSize* atomic, size_t* expected, size_t desired)
+{
+#if defined(_WIN64)
+    size_t previous =
+        (size_t)_InterlockedCompareExchange64((volatile __int64*)atomic, (__int64)desired, (__int64)*expected);
+#else
+    size_t previous = (size_t)_InterlockedCompareExchange((volatile long*)atomic, (long)desired, (long)*expected);
+#endif
+    if (previous == *expected)
+        return 1;
+    *expected = previous;
+    return 0;
+}
+#endif
+
+#ifndef TDS_CACHE_LINE_SIZE
+#define TDS_CACHE_LINE_SIZE 64
+#endif
+
+static inline size_t tds_ring_capacity_fit(size_t capacity)
+{
+    size_t c = 1;
+    while (c < capacity)
+        c *= 2;
+    return c;
+}
+
+#ifdef TDS_HAS_ATOMICS
+
+// Tiny Data Structures Single Producer Single Consumer Ring Implementation
+// Bounded lock-free queue for exactly one pushing and one popping thread. The capacity is rounded up to a power of two
+// and the free running head and tail are kept on their own cache lines. Each side caches the last seen index of the
+// other side and only reloads it when the ring looks full or empty. push_many and pop_many move as many items as
+// there is room for and return how many that was.
+
+#define TDS_SPSC_RING_IMPL(TYPE, NAME)                                                                                 \
+    struct TdsSpscRing_##NAME                                                                                          \
+    {                                                                                                                  \
+        TYPE* data;                                                                                                    \
+        size_t capacity;                                                                                               \
+        char shared_padding[TDS_CACHE_LINE_SIZE];                                                                      \
+        TdsAtomicSize head; /* Written by the consumer */                                                              \
+        size_t cached_tail;                                                                                            \
+        char head_padding[TDS_CACHE_LINE_SIZE];                                                                        \
+        TdsAtomicSize tail; /* Written by the producer */                                                              \
+        size_t cached_head;                                                                                            \
+        char tail_padding[TDS_CACHE_LINE_SIZE];                                                                        \
+    };                                                                                                                 \
+                                                                                                                       \
+    TDS_UNUSED static inline int tds_spsc_ring_##NAME##_create(struct TdsSpscRing_##NAME* ring, size_t capacity)       \
+    {                                                                                                                  \
+        memset(ring, 0, sizeof(struct TdsSpscRing_##NAME));                                                            \
+        if (capacity == 0)                                                                                             \
+            return -1;                                                                                                 \
+        ring->capacity = tds_ring_capacity_fit(capacity);                                                              \
+        ring->data = (TYPE*)TDS_MALLOC(ring->capacity * sizeof(TYPE));                                                 \
+        if (ring->data == NULL)                                                                                        \
+            return -1;                                                                                                 \
+        tds_atomic_store_relaxed(&ring->head, 0);                                                                      \
+        tds_atomic_store_relaxed(&ring->tail, 0);                                                                      \
+        return 0;                                                                                                      \
+    }                                                                                                                  \
+    TDS_UNUSED static inline int tds_spsc_ring_##NAME##_destroy(struct TdsSpscRing_##NAME* ring)                       \
+    {                                                                                                                  \
+        TDS_FREE(ring->data);                                                                                          \
+        memset(ring, 0, sizeof(struct TdsSpscRing_##NAME));                                                            \
+        return 0;                                                                                                      \
+    }                                                                                                                  \
+    TDS_UNUSED static inline size_t tds_spsc_ring_##NAME##_push_many(                                                  \
+        struct TdsSpscRing_##NAME* ring, const TYPE* items, size_t count)                                              \
+    {                                                                                                                  \
+        size_t tail = tds_atomic_load_relaxed(&ring->tail);                                                            \
+        if (ring->capacity - (tail - ring->cached_head) < count)                                                       \
+            ring->cached_head = tds_atomic_load_acquire(&ring->head);                                                  \
+        size_t free_count = ring->capacity - (tail - ring->cached_head);                                               \
+        if (count > free_count)                                                                                        \
+            count = free_count;                                                                                        \
+        size_t mask = ring->capacity - 1;                                                                              \
+        for (size_t i = 0; i < count; ++i)                                                                             \
+            ring->data[(tail + i) & mask] = items[i];                                                                  \
+        tds_atomic_store_release(&ring->tail, tail + count);                                                           \
+        return count;                                                                                                  \
+    }                                                                                                                  \
+    TDS_UNUSED static inline size_t tds_spsc_ring_##NAME##_pop_many(                                                   \
+        struct TdsSpscRing_##NAME* ring, TYPE* items, size_t max_count)                                                \
+    {                                                                                                                  \
+        size_t head = tds_atomic_load_relaxed(&ring->head);                                                            \
+        if (ring->cached_tail - head < max_count)                                                                      \
+            ring->cached_tail = tds_atomic_load_acquire(&ring->tail);                                                  \
+        size_t count = ring->cached_tail - head;                                                                       \
+        if (count > max_count)                                                                                         \
+            count = max_count;                                                                                         \
+        size_t mask = ring->capacity - 1;                                                                              \
+        for (size_t i = 0; i < count; ++i)                                                                             \
+            items[i] = ring->data[(head + i) & mask];                                                                  \
+        tds_atomic_store_release(&ring->head, head + count);                                                           \
+        return count;                                                                                                  \
+    }                                                                                                                  \
+    TDS_UNUSED static inline int tds_spsc_ring_##NAME##_push(struct TdsSpscRing_##NAME* ring, const TYPE* item)        \
+    {                                                                                                                  \
+        return tds_spsc_ring_##NAME##_push_many(ring, item, 1) == 1 ? 0 : -1;                                          \
+    }                                                                                                                  \
+    TDS_UNUSED static inline int tds_spsc_ring_##NAME##_pop(struct TdsSpscRing_##NAME* ring, TYPE* item)               \
+    {                                                                                                                  \
+        return tds_spsc_ring_##NAME##_pop_many(ring, item, 1) == 1 ? 0 : -1;                                           \
+    }                                                                                                                  \
+    /* Exact from either side when the other is idle, otherwise a snapshot */                                          \
+    TDS_UNUSED static inline size_t tds_spsc_ring_##NAME##_count(struct TdsSpscRing_##NAME* ring)                      \
+    {                                                                                                                  \
+        size_t head = tds_atomic_load_acquire(&ring->head);                                                            \
+        return tds_atomic_load_acquire(&ring->tail) - head;                                                            \
+    }
+
+// Tiny Data Structures Multiple Producer Single Consumer Ring Implementation
+// Bounded lock-free queue for any number of pushing threads and one popping thread. Every slot carries a sequence
+// number telling which lap it is ready for, producers claim a run of free slots with one compare exchange on the tail
+// and publish each slot by bumping its sequence, so a slow producer only holds back the consumer at its own slots.
+// The capacity is rounded up to a power of two and the tail and head are kept on their own cache lines.
+
+#define TDS_MPSC_RING_IMPL(TYPE, NAME)                                                                                 \
+    struct TdsMpscRingSlot_##NAME                                                                                      \
+    {                                                                                                                  \
+        TdsAtomicSize sequence;                                                                                        \
+        TYPE item;                                                                                                     \
+    };                                                                                                                 \
+                                                                                                                       \
+    struct TdsMpscRing_##NAME                                                                                          \
+    {                                                                                                                  \
+        struct TdsMpscRingSlot_##NAME* slots;                                                                          \
+        size_t capacity;                                                                                               \
+        char shared_padding[TDS_CACHE_LINE_SIZE];                                                                      \
+        TdsAtomicSize head; /* Written by the consumer */                                                              \
+        char head_padding[TDS_CACHE_LINE_SIZE];                                                                        \
+        TdsAtomicSize tail; /* Claimed by the producers */                                                             \
+        char tail_padding[TDS_CACHE_LINE_SIZE];                                                                        \
+    };                                                                                                                 \
+                                                                                                                       \
+    TDS_UNUSED static inline int tds_mpsc_ring_##NAME##_create(struct TdsMpscRing_##NAME* ring, size_t capacity)       \
+    {                                                                                                                  \
+        memset(ring, 0, sizeof(struct TdsMpscRing_##NAME));                                                            \
+        if (capacity == 0)                                                                                             \
+            return -1;                                                                                                 \
+        ring->capacity = tds_ring_capacity_fit(capacity);                                                              \
+        ring->slots =                                                                                                  \
+            (struct TdsMpscRingSlot_##NAME*)TDS_MALLOC(ring->capacity * sizeof(struct TdsMpscRingSlot_##NAME));        \
+        if (ring->slots == NULL)                                                                                       \
+            return -1;                                                                                                 \
+        for (size_t i = 0; i < ring->capacity; ++i)                                                                    \
+            tds_atomic_store_relaxed(&ring->slots[i].sequence, i);                                                     \
+        tds_atomic_store_relaxed(&ring->head, 0);                                                                      \
+        tds_atomic_store_relaxed(&ring->tail, 0);                                                                      \
+        return 0;                                                                                                      \
+    }                                                                                                                  \
+    TDS_UNUSED static inline int tds_mpsc_ring_##NAME##_destroy(struct TdsMpscRing_##NAME* ring)                       \
+    {                                                                                                                  \
+        TDS_FREE(ring->slots);                                                                                         \
+        memset(ring, 0, sizeof(struct TdsMpscRing_##NAME));                                                            \
+        return 0;                                                                                                      \
+    }                                                                                                                  \
+    TDS_UNUSED static inline size_t tds_mpsc_ring_##NAME##_push_many(                                                  \
+        struct TdsMpscRing_##NAME* ring, const TYPE* items, size_t count)                                              \
+    {                                                                                                                  \
+        size_t mask = ring->capacity - 1;                                                                              \
+        size_t tail = tds_atomic_load_relaxed(&ring->tail);                                                            \
+        size_t claimed = 0;                                                                                            \
+        for (;;)                                                                                                       \
+        {                                                                                                              \
+            /* The consumer frees slots in order, so the free slots after the tail are a prefix */                     \
+            claimed = 0;                                                                                               \
+            while (claimed < count && claimed < ring->capacity)                                                        \
+            {                                                                                                          \
+                size_t sequence = tds_atomic_load_acquire(&ring->slots[(tail + claimed) & mask].sequence);             \
+                if (sequence != tail + claimed)                                                                        \
+                    break;                                                                                             \
+                claimed++;                                                                                             \
+            }                                                                                                          \
+            if (claimed == 0)                                                                                          \
+            {                                                                                                          \
+                /* Either full, or another producer moved the tail since we loaded it */                               \
+                size_t sequence = tds_atomic_load_acquire(&ring->slots[tail & mask].sequence);                         \
+                size_t current_tail = tds_atomic_load_relaxed(&ring->tail);                                            \
+                if ((ptrdiff_t)(sequence - tail) < 0 && current_tail == tail)                                          \
+                    return 0;                                                                                          \
+                tail = current_tail;                                                                                   \
+                continue;                                                                                              \
+            }                                                                                                          \
+            if (tds_atomic_compare_exchange(&ring->tail, &tail, tail + claimed))                                       \
+                break;                                                                                                 \
+        }                                                                                                              \
+        for (size_t i = 0; i < claimed; ++i)                                                                           \
+        {                                                                                                              \
+            struct TdsMpscRingSlot_##NAME* slot = &ring->slots[(tail + i) & mask];                                     \
+            slot->item = items[i];                                                                                     \
+            tds_atomic_store_release(&slot->sequence, tail + i + 1);                                                   \
+        }                                                                                                              \
+        return claimed;                                                                                                \
+    }                                                                                                                  \
+    TDS_UNUSED static inline size_t tds_mpsc_ring_##NAME##_pop_many(                                                   \
+        struct TdsMpscRing_##NAME* ring, TYPE* items, size_t max_count)                                                \
+    {                                                                                                                  \
+        size_t mask = ring->capacity - 1;                                                                              \
+        size_t head = tds_atomic_load_relaxed(&ring->head);                                                            \
+        size_t count = 0;                                                                                              \
+        while (count < max_count)                                                                                      \
+        {                                                                                                              \
+            struct TdsMpscRingSlot_##NAME* slot = &ring->slots[(head + count) & mask];                                 \
+            if (tds_atomic_load_acquire(&slot->sequence) != head + count + 1)                                          \
+                break;                                                                                                 \
+            items[count] = slot->item;                                                                                 \
+            /* Ready for the producers one lap later */                                                                \
+            tds_atomic_store_release(&slot->sequence, head + count + ring->capacity);                                  \
+            count++;                                                                                                   \
+        }                                                                                                              \
+        tds_atomic_store_release(&ring->head, head + count);                                                           \
+        return count;                                                                                                  \
+    }                                                                                                                  \
+    TDS_UNUSED static inline int tds_mpsc_ring_##NAME##_push(struct TdsMpscRing_##NAME* ring, const TYPE* item)        \
+    {                                                                                                                  \
+        return tds_mpsc_ring_##NAME##_push_many(ring, item, 1) == 1 ? 0 : -1;                                          \
+    }                                                                                                                  \
+    TDS_UNUSED static inline int tds_mpsc_ring_##NAME##_pop(struct TdsMpscRing_##NAME* ring, TYPE* item)               \
+    {                                                                                                                  \
+        return tds_mpsc_ring_##NAME##_pop_many(ring, item, 1) == 1 ? 0 : -1;                                           \
+    }                                                                                                                  \
+    /* Counts claimed slots, including ones a producer is still writing */                                             \
+    TDS_UNUSED static inline size_t tds_mpsc_ring_##NAME##_count(struct TdsMpscRing_##NAME* ring)                      \
+    {                                                                                                                  \
+        size_t head = tds_atomic_load_acquire(&ring->head);                                                            \
+        return tds_atomic_load_acquire(&ring->tail) - head;                                                            \
+    }
+
+#endif
+
+// Tiny Data Structures Pool Implementation
+// Fixed size object allocator for objects allocated and freed at high rates. Objects are carved from chunks of
+// chunk_capacity objects and freed ones go on an intrusive free list, so alloc and free are O(1) and only a new chunk
+// calls malloc, the first one on the first alloc. With max_capacity 0 the pool grows without bound, otherwise alloc
+// returns NULL at max_capacity objects. Objects are not zeroed and stay at the same address until freed, the chunks are
+// released by destroy. For a pool shared between threads every thread puts a TdsPoolCache_NAME, declared
+// TDS_THREAD_LOCAL, in front of it. The cache moves TDS_POOL_CACHE_BATCH objects at a time to and from the pool under a
+// spin lock. The plain alloc and free take no lock, do not mix them with the cached ones on a shared pool.
+
+#ifndef TDS_POOL_CACHE_BATCH
+#define TDS_POOL_CACHE_BATCH 32
+#endif
+
+#ifndef TDS_THREAD_LOCAL
+#if defined(__cplusplus)
+#define TDS_THREAD_LOCAL thread_local
+#elif defined(__STDC_VERSION__) && __STDC_VERSION__ >= 201112L
+#define TDS_THREAD_LOCAL _Thread_local
+#elif defined(_MSC_VER)
+#define TDS_THREAD_LOCAL __declspec(thread)
+#else
+#define TDS_THREAD_LOCAL __thread
+#endif
+#endif
+
+#ifdef TDS_HAS_ATOMICS
+typedef TdsAtomicSize TdsPoolLock;
+
+#ifndef TDS_THREAD_YIELD
+#if defined(_WIN32)
+// windows.h is not included here for SwitchToThread(), so only tell the core that we are spinning
+#if defined(_M_ARM) || defined(_M_ARM64)
+#define TDS_THREAD_YIELD() __yield()
+#elif defined(_MSC_VER)
+#define TDS_THREAD_YIELD() _mm_pause()
+#else
+#define TDS_THREAD_YIELD() __builtin_ia32_pause()
+#endif
+#else
+#include <sched.h>
+#define TDS_THREAD_YIELD() sched_yield()
+#endif
+#endif
+
+static inline void tds_pool_lock(TdsPoolLock* lock)
+{
+    size_t unlocked = 0;
+    while (!tds_atomic_compare_exchange(lock, &unlocked, 1))
+    {
+        unlocked = 0;
+        TDS_THREAD_YIELD();
+    }
+}
+
+static inline void tds_pool_unlock(TdsPoolLock* lock)
+{
+    tds_atomic_store_release(lock, 0);
+}
+
+#define TDS_POOL_CACHE_IMPL(TYPE, NAME)                                                                                \
+    struct TdsPoolCache_##NAME                                                                                         \
+    {                                                                                                                  \
+        union TdsPoolSlot_##NAME* free_list;                                                                           \
+        size_t count;                                                                                                  \
+    };                                                                                                                 \
+                                                                                                                       \
+    /* Gives the cached objects back to the pool, call before the thread exits and before the pool is destroyed */     \
+    TDS_UNUSED static inline void tds_pool_##NAME##_cache_flush(                                                       \
+        struct TdsPool_##NAME* pool, struct TdsPoolCache_##NAME* cache)                                                \
+    {                                                                                                                  \
+        if (cache->count == 0)                                                                                         \
+            return;                                                                                                    \
+        union TdsPoolSlot_##NAME* last = cache->free_list;                                                             \
+        while (last->next != NULL)                                                                                     \
+            last = last->next;                                                                                         \
+        tds_pool_lock(&pool->lock);                                                                                    \
+        last->next = pool->free_list;                                                                                  \
+        pool->free_list = cache->free_list;                                                                            \
+        pool->count -= cache->count;                                                                                   \
+        tds_pool_unlock(&pool->lock);                                                                                  \
+        cache->free_list = NULL;                                                                                       \
+        cache->count = 0;                                                                                              \
+    }                                                                                                                  \
+    TDS_UNUSED static inline TYPE* tds_pool_##NAME##_cache_alloc(                                                      \
+        struct TdsPool_##NAME* pool, struct TdsPoolCache_##NAME* cache)                                                \
+    {                                                                                                                  \
+        if (cache->free_list == NULL)                                                                                  \
+        {                                                                                                              \
+            tds_pool_lock(&pool->lock);                                                                                \
+            for (size_t i = 0; i < TDS_POOL_CACHE_BATCH; ++i)                                                          \
+            {                                                                                                          \
+                union TdsPoolSlot_##NAME* slot = (union TdsPoolSlot_##NAME*)tds_pool_##NAME##_alloc(pool);             \
+                if (slot == NULL)                                                                                      \
+                    break;                                                                                             \
+                slot->next = cache->free_list;                                                                         \
+                cache->free_list = slot;                                                                               \
+                cache->count++;                                                                                        \
+            }                                                                                                          \
+            tds_pool_unlock(&pool->lock);                                                                              \
+            if (cache->free_list == NULL)                                                                              \
+                return NULL;                                                                                           \
+        }                                                                                                              \
+        union TdsPoolSlot_##NAME* slot = cache->free_list;                                                             \
+        cache->free_list = slot->next;                                                                                 \
+        cache->count--;                                                                                                \
+        return &slot->object;                                                                                          \
+    }                                                                                                                  \
+    TDS_UNUSED static inline void tds_pool_##NAME##_cache_free(                                                        \
+        struct TdsPool_##NAME* pool, struct TdsPoolCache_##NAME* cache, TYPE* object)                                  \
+    {                                                                                                                  \
+        union TdsPoolSlot_##NAME* slot = (union TdsPoolSlot_##NAME*)object;                                            \
+        slot->next = cache->free_list;                                                                                 \
+        cache->free_list = slot;                                                                                       \
+        cache->count++;                                                                                                \
+        /* Keep one batch for the next allocations and give the other back */                                          \
+        if (cache->count < 2 * TDS_POOL_CACHE_BATCH)                                                                   \
+            return;                                                                                                    \
+        union TdsPoolSlot_##NAME* first = cache->free_list;                                                            \
+        union TdsPoolSlot_##NAME* last = first;                                                                        \
+        for (size_t i = 1; i < TDS_POOL_CACHE_BATCH; ++i)                                                              \
+            last = last->next;                                                                                         \
+        cache->free_list = last->next;                                                                                 \
+        cache->count -= TDS_POOL_CACHE_BATCH;                                                                          \
+        tds_pool_lock(&pool->lock);                                                                                    \
+        last->next = pool->free_list;                                                                                  \
+        pool->free_list = first;                                                                                       \
+        pool->count -= TDS_POOL_CACHE_BATCH;                                                                           \
+        tds_pool_unlock(&pool->lock);                                                                                  \
+    }
+#else
+typedef size_t TdsPoolLock;
+#define TDS_POOL_CACHE_IMPL(TYPE, NAME)
+#endif
+
+#define TDS_POOL_IMPL(TYPE, NAME)                                                                                      \
+    union TdsPoolSlot_##NAME                                                                                           \
+    {                                                                                                                  \
+        union TdsPoolSlot_##NAME* next;                                                                                \
+        TYPE object;                                                                                                   \
+    };                                                                                                                 \
+                                                                                                                       \
+    /* A pointer sized header, the compiler pads it to the alignment of the slots instead of a whole slot */           \
+    struct TdsPoolChunk_##NAME                                                                                         \
+    {                                                                                                                  \
+        struct TdsPoolChunk_##NAME* previous;                                                                          \
+        union TdsPoolSlot_##NAME slots[1];                                                                             \
+    };                                                                                                                 \
+                                                                                                                       \
+    struct TdsPool_##NAME                                                                                              \
+    {                                                                                                                  \
+        union TdsPoolSlot_##NAME* free_list;                                                                           \
+        struct TdsPoolChunk_##NAME* chunks; /* Newest first */                                                         \
+        union TdsPoolSlot_##NAME* fresh;  /* Never used slots in the newest chunk, handed out before growing */        \
+        union TdsPoolSlot_##NAME* fresh_end;                                                                           \
+        size_t chunk_capacity;                                                                                         \
+        size_t max_capacity;                                                                                           \
+        size_t capacity;                                                                                               \
+        size_t count; /* Objects handed out, including the ones in caches */                                           \
+        TdsPoolLock lock;                                                                                              \
+    };                                                                                                                 \
+                                                                                                                       \
+    TDS_UNUSED static inline int tds_pool_##NAME##_grow(struct TdsPool_##NAME* pool)                                   \
+    {                                                                                                                  \
+        size_t chunk_capacity = pool->chunk_capacity;                                                                  \
+        if (pool->max_capacity != 0 && pool->max_capacity - pool->capacity < chunk_capacity)                           \
+            chunk_capacity = pool->max_capacity - pool->capacity;                                                      \
+        if (chunk_capacity == 0)                                                                                       \
+            return -1;                                                                                                 \
+        struct TdsPoolChunk_##NAME* chunk = (struct TdsPoolChunk_##NAME*)TDS_MALLOC(                                   \
+            offsetof(struct TdsPoolChunk_##NAME, slots) + chunk_capacity * sizeof(union TdsPoolSlot_##NAME));          \
+        if (chunk == NULL)                                                                                             \
+            return -1;                                                                                                 \
+        chunk->previous = pool->chunks;                                                                                \
+        pool->chunks = chunk;                                                                                          \
+        pool->fresh = chunk->slots;                                                                                    \
+        pool->fresh_end = chunk->slots + chunk_capacity;                                                               \
+        pool->capacity += chunk_capacity;                                                                              \
+        return 0;                                                                                                      \
+    }                                                                                                                  \
+    TDS_UNUSED static inline int tds_pool_##NAME##_create(                                                             \
+        struct TdsPool_##NAME* pool, size_t chunk_capacity, size_t max_capacity)                                       \
+    {                                                                                                                  \
+        memset(pool, 0, sizeof(struct TdsPool_##NAME));                                                                \
+        if (chunk_capacity == 0)                                                                                       \
+            return -1;                                                                                                 \
+        pool->chunk_capacity = chunk_capacity;                                                                         \
+        pool->max_capacity = max_capacity;                                                                             \
+        return 0;                                                                                                      \
+    }                                                                                                                  \
+    TDS_UNUSED static inline int tds_pool_##NAME##_destroy(struct TdsPool_##NAME* pool)                                \
+    {                                                                                                                  \
+        while (pool->chunks != NULL)                                                                                   \
+        {                                                                                                              \
+            struct TdsPoolChunk_##NAME* previous = pool->chunks->previous;                                             \
+            TDS_FREE(pool->chunks);                                                                                    \
+            pool->chunks = previous;                                                                                   \
+        }                                                                                                              \
+        memset(pool, 0, sizeof(struct TdsPool_##NAME));                                                                \
+        return 0;                                                                                                      \
+    }                                                                                                                  \
+    TDS_UNUSED static inline TYPE* tds_pool_##NAME##_alloc(struct TdsPool_##NAME* pool)                                \
+    {                                                                                                                  \
+        union TdsPoolSlot_##NAME* slot = pool->free_list;                                                              \
+        if (slot != NULL)                                                                                              \
+            pool->free_list = slot->next;                                                                              \
+        else if (pool->fresh != pool->fresh_end || tds_pool_##NAME##_grow(pool) == 0)                                  \
+            slot = pool->fresh++;                                                                                      \
+        else                                                                                                           \
+            return NULL;                                                                                               \
+        pool->count++;                                                                                                 \
+        return &slot->object;                                                                                          \
+    }                                                                                                                  \
+    TDS_UNUSED static inline int tds_pool_##NAME##_free(struct TdsPool_##NAME* pool, TYPE* object)                     \
+    {                                                                                                                  \
+        if (object == NULL)                                                                                            \
+            return -1;                                                                                                 \
+        union TdsPoolSlot_##NAME* slot = (union TdsPoolSlot_##NAME*)object;                                            \
+        slot->next = pool->free_list;                                                                                  \
+        pool->free_list = slot;                                                                                        \
+        pool->count--;                                                                                                 \
+        return 0;                                                                                                      \
+    }                                                                                                                  \
+    TDS_POOL_CACHE_IMPL(TYPE, NAME)
+
 #endif